@@ -32,7 +32,7 @@ class _HomeScreenState extends State<HomeScreen> {
   void initState() {
     super.initState();
     _audioService = AudioService();
-    _webSocketService = WebSocketStreamService();
+    _webSocketService = WebSocketStreamService(audioService: _audioService);
     _webSocketService.onConnectionStateChanged = (connected) {
       if (mounted) {
         if (!connected && _isStreaming) {
@@ -73,8 +73,17 @@ class _HomeScreenState extends State<HomeScreen> {
         _isSystemAudioCapturing = false;
       });
     } else {
+      // Captures feed the live-assist stream, so keep native buffering short.
+      // The backend transcribes one mono channel per speaker, and only
+      // needs to hear how long the pauses were.
       final success = await _audioService.startSystemAudioCapture(
         deviceId: _selectedSystemAudioDeviceId,
+        profile: CaptureProfile.realtime,
+        sampleRate: LocalAudioRecorder.liveSampleRate,
+        channels: ChannelMapping.downmix,
+        silencePolicy: SilencePolicy.markers,
+        encoding: LocalAudioRecorder.liveEncoding,
+        frameMs: LocalAudioRecorder.liveFrameMs,
       );
       if (success) {
         setState(() {
@@ -100,8 +109,17 @@ class _HomeScreenState extends State<HomeScreen> {
         _isMicrophoneCapturing = false;
       });
     } else {
+      // Captures feed the live-assist stream, so keep native buffering short.
+      // The backend transcribes one mono channel per speaker, and only
+      // needs to hear how long the pauses were.
       final success = await _audioService.startMicrophoneCapture(
         deviceId: _selectedMicrophoneDeviceId,
+        profile: CaptureProfile.realtime,
+        sampleRate: LocalAudioRecorder.liveSampleRate,
+        channels: ChannelMapping.downmix,
+        silencePolicy: SilencePolicy.markers,
+        encoding: LocalAudioRecorder.liveEncoding,
+        frameMs: LocalAudioRecorder.liveFrameMs,
       );
       if (success) {
         setState(() {
@@ -0,0 +1,93 @@
+import 'dart:typed_data';
+
+import 'audio_service.dart';
+
+/// What the payload of an [AudioFrame] holds.
+class AudioFrameFormat {
+  final String codec; // 'pcm', 'opus' or 'mp3'
+  final int sampleRate;
+  final int channels;
+  final String sampleType; // 'int16', 'int24', 'int32' or 'float32'
+
+  const AudioFrameFormat({
+    this.codec = 'pcm',
+    required this.sampleRate,
+    required this.channels,
+    this.sampleType = 'int16',
+  });
+
+  factory AudioFrameFormat.fromStreamInfo(CaptureStreamInfo info) {
+    return AudioFrameFormat(
+      codec: info.codec,
+      sampleRate: info.sampleRate,
+      channels: info.channels,
+      sampleType: info.sampleType,
+    );
+  }
+
+  int get bytesPerFrame =>
+      channels * (sampleType == 'int16' ? 2 : sampleType == 'int24' ? 3 : 4);
+}
+
+/// Binary audio frames for the streaming server, one per WebSocket binary
+/// message. The layout is defined in the core library's frame_protocol.h;
+/// tools/frame_decoder.py decodes it on the server side.
+class AudioFrame {
+  static const int version = 1;
+  static const int headerBytes = 40;
+  // Without the trailing stream position, for frames that have none.
+  static const int headerBytesWithoutPosition = 32;
+
+  // Stream ids on the wire.
+  static const int systemStream = 0; // customer
+  static const int microphoneStream = 1; // agent
+  static const int alignedStream = 2; // stereo, customer left, agent right
+
+  static const Map<String, int> _codecs = {'pcm': 0, 'opus': 1, 'mp3': 2};
+  static const Map<String, int> _sampleTypes = {
+    'int16': 0,
+    'int24': 1,
+    'int32': 2,
+    'float32': 3,
+  };
+
+  /// 'system' / 'microphone' to its stream id.
+  static int streamFor(String type) =>
+      type == 'microphone' ? microphoneStream : systemStream;
+
+  /// Header plus [payload] in one buffer. Silence markers pass an empty
+  /// [payload] with [AudioData.silenceMarkerFlag] set in [flags]. Without
+  /// a [position] the shorter header is sent, so the server knows it has
+  /// none.
+  static Uint8List encode({
+    required int stream,
+    required AudioFrameFormat format,
+    required int frames,
+    required int sequence,
+    required int captureTimeNs,
+    int? position,
+    int flags = 0,
+    List<int> payload = const [],
+  }) {
+    final size = position != null ? headerBytes : headerBytesWithoutPosition;
+    final frame = Uint8List(size + payload.length);
+    final header = ByteData.sublistView(frame, 0, size);
+    header.setUint8(0, version);
+    header.setUint8(1, size);
+    header.setUint8(2, stream);
+    header.setUint8(3, _codecs[format.codec] ?? 0);
+    header.setUint16(4, flags & 0xFFFF, Endian.little);
+    header.setUint8(6, format.channels);
+    header.setUint8(7, _sampleTypes[format.sampleType] ?? 0);
+    header.setInt64(8, captureTimeNs, Endian.little);
+    header.setUint32(16, format.sampleRate, Endian.little);
+    header.setUint32(20, frames, Endian.little);
+    header.setUint32(24, sequence & 0xFFFFFFFF, Endian.little);
+    header.setUint32(28, payload.length, Endian.little);
+    if (position != null) {
+      header.setUint64(32, position, Endian.little);
+    }
+    frame.setRange(size, frame.length, payload);
+    return frame;
+  }
+}
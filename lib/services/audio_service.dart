@@ -1,4 +1,6 @@
 import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
 import 'package:flutter/services.dart';
 
 class AudioDevice {
@@ -21,15 +23,269 @@ class AudioDevice {
   }
 }
 
+/// Native capture buffer profiles: lower latency against resilience to
+/// stalls. Names match the native `profile` start argument.
+enum CaptureProfile { realtime, balanced, bulk }
+
+/// Native resampler filter quality: CPU cost against stopband rejection.
+/// Names match the native `resamplerQuality` start argument.
+enum ResamplerQuality { low, medium, high }
+
+/// What native capture does with packets its voice activity detector finds
+/// no speech in. Names match the native `silencePolicy` start argument;
+/// leaving it unset turns detection off.
+enum SilencePolicy {
+  forward, // deliver everything, tagged [AudioData.noSpeechFlag]
+  drop, // deliver speech only
+  markers, // replace silence runs with sample-less [AudioData.isSilenceMarker] packets
+}
+
+/// Opus signal tuning. Names match the native `opusApplication` argument.
+enum OpusApplication { voip, audio }
+
+/// Native codec applied after capture. Codecs the runner was built without
+/// (or that cannot take the stream's rate) fall back to PCM; check
+/// [CaptureStreamInfo.codec] and [CaptureStreamInfo.mimeType] for what runs.
+class AudioEncoding {
+  final String codec; // 'pcm', 'opus' or 'mp3'
+  final int bitrate; // bits/s
+  final int frameMs; // one codec frame
+  final OpusApplication application;
+
+  const AudioEncoding._(this.codec,
+      {this.bitrate = 24000,
+      this.frameMs = 20,
+      this.application = OpusApplication.voip});
+
+  /// Raw PCM packets as captured.
+  static const AudioEncoding pcm = AudioEncoding._('pcm');
+
+  /// One Opus packet per [frameMs] (10, 20, 40 or 60). Needs a 8, 12, 16,
+  /// 24 or 48 kHz stream.
+  const AudioEncoding.opus(
+      {int bitrate = 24000,
+      int frameMs = 20,
+      OpusApplication application = OpusApplication.voip})
+      : this._('opus',
+            bitrate: bitrate, frameMs: frameMs, application: application);
+
+  /// MP3 at the nearest standard bitrate. Only used for [RecordingOptions];
+  /// live streams stay PCM or Opus.
+  const AudioEncoding.mp3({int bitrate = 128000})
+      : this._('mp3', bitrate: bitrate);
+
+  Map<String, dynamic> toArgs() => {
+        'codec': codec,
+        if (codec != 'pcm') ...{
+          'bitrate': bitrate,
+          'codecFrameMs': frameMs,
+          'opusApplication': application.name,
+        },
+      };
+}
+
+/// A file written natively while the stream is captured, so no export step
+/// is needed after stop. [encoding] picks the container: WAV for PCM, Ogg
+/// for Opus, raw MP3 otherwise. The file is readable while it grows and is
+/// finalized on stop; [wavCopyPath] adds a lossless copy alongside.
+class RecordingOptions {
+  final String path;
+  final AudioEncoding encoding;
+  final String? wavCopyPath;
+
+  const RecordingOptions(this.path,
+      {this.encoding = const AudioEncoding.opus(bitrate: 32000),
+      this.wavCopyPath});
+
+  Map<String, dynamic> toArgs() => {
+        'recordPath': path,
+        'recordCodec': encoding.codec,
+        'recordBitrate': encoding.bitrate,
+        if (wavCopyPath != null) 'recordWavPath': wavCopyPath,
+      };
+}
+
+/// Native channel mapping applied before anything else sees the audio.
+/// Speech backends only need mono per speaker, so [downmix] halves the
+/// bytes of a stereo device for every later stage.
+class ChannelMapping {
+  final String mode; // 'passthrough', 'downmix', 'select' or 'matrix'
+  final int channel;
+  final int outputChannels;
+  final List<double> matrix;
+
+  const ChannelMapping._(this.mode,
+      {this.channel = 0, this.outputChannels = 0, this.matrix = const []});
+
+  /// Keep the device layout.
+  static const ChannelMapping passthrough = ChannelMapping._('passthrough');
+
+  /// Average all device channels to mono.
+  static const ChannelMapping downmix = ChannelMapping._('downmix');
+
+  /// Keep only device channel [channel] (0-based) as mono.
+  const ChannelMapping.select(int channel) : this._('select', channel: channel);
+
+  /// [outputChannels] rows of one gain per device channel, row-major.
+  /// Must match the device's channel count or the layout is left alone.
+  const ChannelMapping.matrix(int outputChannels, List<double> gains)
+      : this._('matrix', outputChannels: outputChannels, matrix: gains);
+
+  Map<String, dynamic> toArgs() => {
+        'channelMode': mode,
+        'channel': channel,
+        'outputChannels': outputChannels,
+        if (mode == 'matrix') 'channelMatrix': Float64List.fromList(matrix),
+      };
+}
+
+/// What a native capture stream negotiated for its profile.
+class CaptureStreamInfo {
+  final String profile;
+  // Delivered PCM format, after native conversion.
+  final int sampleRate;
+  final int channels;
+  final String sampleType; // 'int16', 'float32', ...
+  final String mimeType; // of the delivered packets, PCM or encoded
+  final String codec; // negotiated AudioEncoding codec
+  final int bitrate;
+  final int codecFrameMs;
+  final String channelMode; // applied ChannelMapping mode
+  // Format negotiated with the device.
+  final int deviceSampleRate;
+  final int deviceChannels;
+  final String deviceSampleType;
+  final bool eventDriven;
+  final int devicePeriodMs;
+  final int bufferDurationMs;
+  final int deliveryFrames; // max frames per delivered packet
+  final int frameFrames; // fixed PCM frame size with frameMs; 0 if unset
+  final int queueSlots;
+  final int queueDurationMs; // consumer stall absorbed before overruns
+  final int expectedLatencyMs; // worst-case capture-to-queue latency
+  final String? recordingMimeType; // set while RecordingOptions is active
+
+  CaptureStreamInfo({
+    required this.profile,
+    required this.sampleRate,
+    required this.channels,
+    required this.sampleType,
+    required this.mimeType,
+    this.codec = 'pcm',
+    this.bitrate = 0,
+    this.codecFrameMs = 0,
+    required this.channelMode,
+    required this.deviceSampleRate,
+    required this.deviceChannels,
+    required this.deviceSampleType,
+    required this.eventDriven,
+    required this.devicePeriodMs,
+    required this.bufferDurationMs,
+    required this.deliveryFrames,
+    this.frameFrames = 0,
+    required this.queueSlots,
+    required this.queueDurationMs,
+    required this.expectedLatencyMs,
+    this.recordingMimeType,
+  });
+
+  factory CaptureStreamInfo.fromMap(Map<dynamic, dynamic> map) {
+    return CaptureStreamInfo(
+      profile: map['profile'] as String,
+      sampleRate: map['sampleRate'] as int,
+      channels: map['channels'] as int,
+      sampleType: map['sampleType'] as String,
+      mimeType: map['mimeType'] as String,
+      codec: map['codec'] as String? ?? 'pcm',
+      bitrate: map['bitrate'] as int? ?? 0,
+      codecFrameMs: map['codecFrameMs'] as int? ?? 0,
+      channelMode: map['channelMode'] as String? ?? 'passthrough',
+      deviceSampleRate: map['deviceSampleRate'] as int,
+      deviceChannels: map['deviceChannels'] as int,
+      deviceSampleType: map['deviceSampleType'] as String,
+      eventDriven: map['eventDriven'] as bool,
+      devicePeriodMs: map['devicePeriodMs'] as int,
+      bufferDurationMs: map['bufferDurationMs'] as int,
+      deliveryFrames: map['deliveryFrames'] as int,
+      frameFrames: map['frameFrames'] as int? ?? 0,
+      queueSlots: map['queueSlots'] as int,
+      queueDurationMs: map['queueDurationMs'] as int,
+      expectedLatencyMs: map['expectedLatencyMs'] as int,
+      recordingMimeType: map['recordingMimeType'] as String?,
+    );
+  }
+}
+
 class AudioService {
   static const MethodChannel _channel = MethodChannel('com.samurai.audio_capture');
+  // Raw PCM packets when capture is started with binary delivery.
+  static const EventChannel _pcmChannel = EventChannel('com.samurai.audio_capture/pcm');
+  // Progress and results of convertToMp3 and convertBatch jobs.
+  static const EventChannel _jobsChannel = EventChannel('com.samurai.audio_capture/jobs');
+  // Connection state and counters of the native WebSocket sink.
+  static const EventChannel _streamChannel = EventChannel('com.samurai.audio_capture/stream');
   
   final StreamController<AudioData> _audioDataController = StreamController<AudioData>.broadcast();
+  final StreamController<TranscodeJobEvent> _jobEventController =
+      StreamController<TranscodeJobEvent>.broadcast();
+  StreamSubscription<dynamic>? _pcmSubscription;
+  StreamSubscription<dynamic>? _jobsSubscription;
+  final StreamController<NativeStreamEvent> _streamEventController =
+      StreamController<NativeStreamEvent>.broadcast();
+  StreamSubscription<dynamic>? _streamSubscription;
+  // Ids for runners that convert synchronously and report no job id.
+  int _localJobId = 0;
+  final Map<String, CaptureStreamInfo> _streamInfo = {};
+
+  /// Whether captures are started with binary delivery. Only the Windows
+  /// and Linux runners serve the PCM event channel; the macOS runner keeps
+  /// sending base64 through `onAudioData`, which is still understood.
+  final bool binaryDelivery = Platform.isWindows || Platform.isLinux;
+
+  /// Whether the runner can stream to a WebSocket server itself
+  /// ([startNativeStreaming]), keeping audio off the platform channel.
+  final bool nativeStreaming = Platform.isWindows || Platform.isLinux;
   
   Stream<AudioData> get audioDataStream => _audioDataController.stream;
 
+  /// Progress and results of [convertToMp3] and [convertBatch] jobs.
+  Stream<TranscodeJobEvent> get jobEvents => _jobEventController.stream;
+
+  /// State changes and periodic counters of the native WebSocket sink.
+  Stream<NativeStreamEvent> get streamEvents => _streamEventController.stream;
+
+  /// Settings negotiated by the last successful start of [type] ('system'
+  /// or 'microphone'); null if unknown or the runner does not report them.
+  CaptureStreamInfo? streamInfo(String type) => _streamInfo[type];
+
   AudioService() {
     _channel.setMethodCallHandler(_handleMethodCall);
+    if (binaryDelivery) {
+      _pcmSubscription = _pcmChannel.receiveBroadcastStream().listen(
+        _handlePcmEvent,
+        onError: (error) {
+          print('PCM event channel error: $error');
+        },
+      );
+    }
+    if (Platform.isWindows || Platform.isLinux) {
+      _jobsSubscription = _jobsChannel.receiveBroadcastStream().listen(
+        (event) => _jobEventController.add(
+            TranscodeJobEvent.fromMap(event as Map<dynamic, dynamic>)),
+        onError: (error) {
+          print('Jobs event channel error: $error');
+        },
+      );
+    }
+    if (nativeStreaming) {
+      _streamSubscription = _streamChannel.receiveBroadcastStream().listen(
+        (event) => _streamEventController.add(
+            NativeStreamEvent.fromMap(event as Map<dynamic, dynamic>)),
+        onError: (error) {
+          print('Stream event channel error: $error');
+        },
+      );
+    }
   }
 
   Future<void> _handleMethodCall(MethodCall call) async {
@@ -37,13 +293,29 @@ class AudioService {
       final Map<dynamic, dynamic> data = call.arguments as Map<dynamic, dynamic>;
       final audioData = AudioData(
         type: data['type'] as String,
-        data: data['data'] as String, // base64 string
-        size: data['size'] as int,
+        bytes: base64Decode(data['data'] as String),
+        flags: data['flags'] as int? ?? 0,
+        frames: data['frames'] as int?,
+        position: data['position'] as int?,
+        captureTimeNs: data['captureTimeNs'] as int?,
       );
       _audioDataController.add(audioData);
     }
   }
 
+  void _handlePcmEvent(dynamic event) {
+    final Map<dynamic, dynamic> data = event as Map<dynamic, dynamic>;
+    _audioDataController.add(AudioData(
+      type: data['type'] as String,
+      bytes: data['data'] as Uint8List,
+      sequence: data['seq'] as int,
+      flags: data['flags'] as int,
+      frames: data['frames'] as int?,
+      position: data['position'] as int?,
+      captureTimeNs: data['captureTimeNs'] as int?,
+    ));
+  }
+
   Future<List<AudioDevice>> getInputDevices() async {
     try {
       final List<dynamic> devices = await _channel.invokeMethod('getInputDevices');
@@ -64,18 +336,86 @@ class AudioService {
     }
   }
 
-  Future<bool> startSystemAudioCapture({String? deviceId}) async {
+  Future<bool> startSystemAudioCapture({
+    String? deviceId,
+    CaptureProfile profile = CaptureProfile.balanced,
+    int? sampleRate,
+    ResamplerQuality? resamplerQuality,
+    ChannelMapping channels = ChannelMapping.passthrough,
+    SilencePolicy? silencePolicy,
+    AudioEncoding encoding = AudioEncoding.pcm,
+    RecordingOptions? recording,
+    int? frameMs,
+    bool compensateDrift = false,
+    bool native = false,
+    bool mirror = false,
+  }) async {
     try {
-      final bool result = await _channel.invokeMethod('startSystemAudioCapture', {
+      final dynamic result = await _channel.invokeMethod('startSystemAudioCapture', {
         'deviceId': deviceId,
+        'delivery': _delivery(native),
+        if (native && mirror) 'mirror': true,
+        'profile': profile.name,
+        if (sampleRate != null) 'sampleRate': sampleRate,
+        if (resamplerQuality != null) 'resamplerQuality': resamplerQuality.name,
+        ...channels.toArgs(),
+        if (silencePolicy != null) 'silencePolicy': silencePolicy.name,
+        ...encoding.toArgs(),
+        if (recording != null) ...recording.toArgs(),
+        if (frameMs != null) 'frameMs': frameMs,
+        if (compensateDrift) 'compensateDrift': true,
       });
-      return result;
+      return _recordStart('system', result);
     } catch (e) {
       print('Error starting system audio capture: $e');
       return false;
     }
   }
 
+  /// Native delivery hands packets to the sink started by
+  /// [startNativeStreaming]; they only reach [audioDataStream] as well when
+  /// the capture is started with `mirror: true`, which shares the one
+  /// native capture instead of opening a second one.
+  String _delivery(bool native) {
+    if (native && nativeStreaming) return 'native';
+    return binaryDelivery ? 'binary' : 'base64';
+  }
+
+  /// Moves the running [type] capture ('system' or 'microphone') between
+  /// Dart and native delivery, as [native] and [mirror] do for a start;
+  /// its other settings stay as started. Returns false if it is not
+  /// running or the runner cannot switch it (macOS).
+  Future<bool> setDelivery(String type,
+      {bool native = false, bool mirror = false}) async {
+    try {
+      final bool result = await _channel.invokeMethod('setDelivery', {
+        'type': type,
+        'delivery': _delivery(native),
+        if (native && mirror) 'mirror': true,
+      });
+      return result;
+    } catch (e) {
+      print('Error setting $type delivery: $e');
+      return false;
+    }
+  }
+
+  /// Windows and Linux answer a start with the negotiated stream settings;
+  /// macOS answers `true`.
+  bool _recordStart(String type, dynamic result) {
+    if (result is Map) {
+      final info = CaptureStreamInfo.fromMap(result);
+      _streamInfo[type] = info;
+      print('$type capture: ${info.profile} profile, '
+          '~${info.expectedLatencyMs} ms latency, '
+          '${info.queueDurationMs} ms queue, ${info.mimeType} '
+          '(device ${info.deviceSampleType} ${info.deviceSampleRate} Hz)');
+      return true;
+    }
+    _streamInfo.remove(type);
+    return result == true;
+  }
+
   Future<bool> stopSystemAudioCapture() async {
     try {
       final bool result = await _channel.invokeMethod('stopSystemAudioCapture');
@@ -86,12 +426,36 @@ class AudioService {
     }
   }
 
-  Future<bool> startMicrophoneCapture({String? deviceId}) async {
+  Future<bool> startMicrophoneCapture({
+    String? deviceId,
+    CaptureProfile profile = CaptureProfile.balanced,
+    int? sampleRate,
+    ResamplerQuality? resamplerQuality,
+    ChannelMapping channels = ChannelMapping.passthrough,
+    SilencePolicy? silencePolicy,
+    AudioEncoding encoding = AudioEncoding.pcm,
+    RecordingOptions? recording,
+    int? frameMs,
+    bool compensateDrift = false,
+    bool native = false,
+    bool mirror = false,
+  }) async {
     try {
-      final bool result = await _channel.invokeMethod('startMicrophoneCapture', {
+      final dynamic result = await _channel.invokeMethod('startMicrophoneCapture', {
         'deviceId': deviceId,
+        'delivery': _delivery(native),
+        if (native && mirror) 'mirror': true,
+        'profile': profile.name,
+        if (sampleRate != null) 'sampleRate': sampleRate,
+        if (resamplerQuality != null) 'resamplerQuality': resamplerQuality.name,
+        ...channels.toArgs(),
+        if (silencePolicy != null) 'silencePolicy': silencePolicy.name,
+        ...encoding.toArgs(),
+        if (recording != null) ...recording.toArgs(),
+        if (frameMs != null) 'frameMs': frameMs,
+        if (compensateDrift) 'compensateDrift': true,
       });
-      return result;
+      return _recordStart('microphone', result);
     } catch (e) {
       print('Error starting microphone capture: $e');
       return false;
@@ -108,20 +472,502 @@ class AudioService {
     }
   }
 
+  /// Starts streaming captures begun with `native: true` to [url] from a
+  /// native thread. The runner connects, reconnects with backoff and
+  /// reports through [streamEvents]; returns false for a bad URL (only
+  /// ws:// is supported). [authToken] goes out as a bearer header, so
+  /// without TLS it is only accepted for a loopback host such as a local
+  /// TLS-terminating proxy; elsewhere the call fails. With [alignStreams],
+  /// PCM from both speakers is sent as one stereo stream
+  /// ([AudioFrame.alignedStream]): customer left, agent right, lined up by
+  /// capture time. Encoded captures are
+  /// still sent per speaker. [cancelEcho] (with [alignStreams]) removes
+  /// the customer's voice that the agent's microphone picks up from the
+  /// loudspeaker; it converges best with `compensateDrift` on both
+  /// captures.
+  ///
+  /// While the server is slow or unreachable, audio waits natively up to
+  /// [maxQueuedBytes] and [maxQueuedMs] (null keeps the runner's
+  /// defaults); beyond that [queuePolicy] decides what goes:
+  /// `drop_oldest`, `drop_newest`, `block` (stalls the other sinks too) or
+  /// `coalesce_silence` (silence first). See [getSinkStats].
+  ///
+  /// With [spillDirectory], audio goes to a disk log there instead while
+  /// the server is unreachable or the queue is full, up to [spillMaxBytes]
+  /// of disk, made durable every [spillSyncMs]. Once the link is back it
+  /// is replayed in order at up to [replaySpeed] times real time (0: no
+  /// limit), sequence numbers and timestamps intact, with new audio
+  /// behind it. What is left at a stop is replayed by the next start on
+  /// the same directory.
+  Future<bool> startNativeStreaming(
+    String url, {
+    String? authToken,
+    bool alignStreams = false,
+    bool cancelEcho = false,
+    String queuePolicy = 'drop_oldest',
+    int? maxQueuedBytes,
+    int? maxQueuedMs,
+    String? spillDirectory,
+    int? spillMaxBytes,
+    int? spillSyncMs,
+    int replaySpeed = 4,
+  }) async {
+    try {
+      final bool result = await _channel.invokeMethod('startNativeStreaming', {
+        'url': url,
+        if (authToken != null) 'authToken': authToken,
+        'alignStreams': alignStreams,
+        'cancelEcho': cancelEcho,
+        'queuePolicy': queuePolicy,
+        if (maxQueuedBytes != null) 'maxQueuedBytes': maxQueuedBytes,
+        if (maxQueuedMs != null) 'maxQueuedMs': maxQueuedMs,
+        if (spillDirectory != null) 'spillDirectory': spillDirectory,
+        if (spillMaxBytes != null) 'spillMaxBytes': spillMaxBytes,
+        if (spillSyncMs != null) 'spillSyncMs': spillSyncMs,
+        'replaySpeed': replaySpeed,
+      });
+      return result;
+    } catch (e) {
+      print('Error starting native streaming: $e');
+      return false;
+    }
+  }
+
+  /// Sends what is queued, closes the connection and stops the sink.
+  Future<bool> stopNativeStreaming() async {
+    try {
+      final bool result = await _channel.invokeMethod('stopNativeStreaming');
+      return result;
+    } catch (e) {
+      print('Error stopping native streaming: $e');
+      return false;
+    }
+  }
+
+  /// The native queues in front of each packet consumer, keyed `dart`
+  /// and, while streaming, `websocket`.
+  Future<Map<String, SinkQueueStats>?> getSinkStats() async {
+    try {
+      final Map<dynamic, dynamic> sinks =
+          await _channel.invokeMethod('getSinkStats');
+      return sinks.map((name, stats) => MapEntry(
+          name as String, SinkQueueStats.fromMap(stats as Map<dynamic, dynamic>)));
+    } catch (e) {
+      print('Error getting sink stats: $e');
+      return null;
+    }
+  }
+
+  Future<CaptureStats?> getCaptureStats(String type) async {
+    try {
+      final Map<dynamic, dynamic> stats = await _channel.invokeMethod('getCaptureStats', {
+        'type': type,
+      });
+      return CaptureStats.fromMap(stats);
+    } catch (e) {
+      print('Error getting capture stats: $e');
+      return null;
+    }
+  }
+
+  /// Starts converting [wavPath] to a 192 kbps MP3 at [mp3Path] without
+  /// blocking the platform thread. Returns the job id to match against
+  /// [jobEvents], or null if the job could not be submitted.
+  Future<int?> convertToMp3(String wavPath, String mp3Path) async {
+    try {
+      final dynamic result = await _channel.invokeMethod('convertToMp3', {
+        'wavPath': wavPath,
+        'mp3Path': mp3Path,
+      });
+      if (result is int) {
+        return result;
+      }
+      // The macOS runner converts before replying; report it as a job.
+      final id = --_localJobId;
+      _jobEventController.add(TranscodeJobEvent(
+        id: id,
+        state: result == true ? 'succeeded' : 'failed',
+        progress: result == true ? 1.0 : 0.0,
+        error: result == true ? null : 'Conversion failed',
+      ));
+      return id;
+    } catch (e) {
+      print('Error converting to MP3: $e');
+      return null;
+    }
+  }
+
+  /// Converts every WAV in [files] (input path to output path) as one batch
+  /// spread over all cores; MP3 at 192 kbps unless [encoding] says
+  /// otherwise. Per-file and aggregate progress arrive on [jobEvents].
+  /// Windows and Linux only; returns null elsewhere or on bad arguments.
+  Future<TranscodeBatch?> convertBatch(Map<String, String> files,
+      {AudioEncoding encoding = const AudioEncoding.mp3(bitrate: 192000)}) async {
+    if (!(Platform.isWindows || Platform.isLinux) || files.isEmpty) {
+      return null;
+    }
+    try {
+      final Map<dynamic, dynamic> result =
+          await _channel.invokeMethod('convertBatch', {
+        'inputs': files.keys.toList(),
+        'outputs': files.values.toList(),
+        'codec': encoding.codec,
+        'bitrate': encoding.bitrate,
+      });
+      return TranscodeBatch(
+        id: result['batch'] as int,
+        jobIds: (result['jobs'] as List<dynamic>).cast<int>(),
+      );
+    } catch (e) {
+      print('Error converting batch: $e');
+      return null;
+    }
+  }
+
+  /// Cancels a queued or running [convertToMp3] job. Returns false if it
+  /// already finished.
+  Future<bool> cancelJob(int id) async {
+    if (id < 0) {
+      return false;
+    }
+    try {
+      final bool result = await _channel.invokeMethod('cancelJob', {'id': id});
+      return result;
+    } catch (e) {
+      print('Error cancelling job: $e');
+      return false;
+    }
+  }
+
+  /// Cancels every unfinished job of a [convertBatch] batch.
+  Future<bool> cancelBatch(int batch) async {
+    try {
+      final bool result =
+          await _channel.invokeMethod('cancelBatch', {'batch': batch});
+      return result;
+    } catch (e) {
+      print('Error cancelling batch: $e');
+      return false;
+    }
+  }
+
   void dispose() {
+    _pcmSubscription?.cancel();
+    _jobsSubscription?.cancel();
+    _streamSubscription?.cancel();
     _audioDataController.close();
+    _jobEventController.close();
+    _streamEventController.close();
+  }
+}
+
+/// Native capture counters for one stream since its last start.
+class CaptureStats {
+  final int packetsCaptured;
+  final int packetsDelivered;
+  final int overruns; // device packets dropped because the ring was full
+  final int droppedFrames;
+  final int maxCaptureNs; // worst capture-thread time for one packet
+  final int totalCaptureNs;
+  final int wakeups; // capture thread wakeups
+  final int idleWakeups; // wakeups that found no data
+  final int maxLatencyNs; // worst device-to-ring latency
+  final int totalLatencyNs;
+  final int latencySamples; // packets that carried a device timestamp
+  final int silentPackets; // device packets classified as not speech
+  final int suppressedFrames; // dropped or folded into silence markers
+  final int frameTimeouts; // short frames sent when frameMs stalled
+  final double driftPpm; // device clock against the host clock
+  final double driftMs; // how far the device clock drifted since start
+  final int driftCorrectedFrames; // inserted (+) / removed by compensateDrift
+  final int encodedPackets; // codec frames delivered
+  final int encoderFailures; // codec frames lost to encoder errors
+  final int recordedFrames; // frames written to the RecordingOptions file
+  final int recordingBytes; // bytes on disk, WAV copy included
+  final bool recordingFailed; // a write failed; the file is truncated
+
+  CaptureStats({
+    required this.packetsCaptured,
+    required this.packetsDelivered,
+    required this.overruns,
+    required this.droppedFrames,
+    required this.maxCaptureNs,
+    required this.totalCaptureNs,
+    required this.wakeups,
+    required this.idleWakeups,
+    required this.maxLatencyNs,
+    required this.totalLatencyNs,
+    required this.latencySamples,
+    this.silentPackets = 0,
+    this.suppressedFrames = 0,
+    this.frameTimeouts = 0,
+    this.driftPpm = 0,
+    this.driftMs = 0,
+    this.driftCorrectedFrames = 0,
+    this.encodedPackets = 0,
+    this.encoderFailures = 0,
+    this.recordedFrames = 0,
+    this.recordingBytes = 0,
+    this.recordingFailed = false,
+  });
+
+  factory CaptureStats.fromMap(Map<dynamic, dynamic> map) {
+    return CaptureStats(
+      packetsCaptured: map['packetsCaptured'] as int,
+      packetsDelivered: map['packetsDelivered'] as int,
+      overruns: map['overruns'] as int,
+      droppedFrames: map['droppedFrames'] as int,
+      maxCaptureNs: map['maxCaptureNs'] as int,
+      totalCaptureNs: map['totalCaptureNs'] as int,
+      wakeups: map['wakeups'] as int,
+      idleWakeups: map['idleWakeups'] as int,
+      maxLatencyNs: map['maxLatencyNs'] as int,
+      totalLatencyNs: map['totalLatencyNs'] as int,
+      latencySamples: map['latencySamples'] as int,
+      silentPackets: map['silentPackets'] as int? ?? 0,
+      suppressedFrames: map['suppressedFrames'] as int? ?? 0,
+      frameTimeouts: map['frameTimeouts'] as int? ?? 0,
+      driftPpm: (map['driftPpm'] as num?)?.toDouble() ?? 0,
+      driftMs: (map['driftMs'] as num?)?.toDouble() ?? 0,
+      driftCorrectedFrames: map['driftCorrectedFrames'] as int? ?? 0,
+      encodedPackets: map['encodedPackets'] as int? ?? 0,
+      encoderFailures: map['encoderFailures'] as int? ?? 0,
+      recordedFrames: map['recordedFrames'] as int? ?? 0,
+      recordingBytes: map['recordingBytes'] as int? ?? 0,
+      recordingFailed: map['recordingFailed'] as bool? ?? false,
+    );
   }
 }
 
 class AudioData {
+  // Native packet flags.
+  static const int deviceSilentFlag = 1 << 0;
+  static const int discontinuityFlag = 1 << 1;
+  static const int noSpeechFlag = 1 << 2;
+  static const int silenceMarkerFlag = 1 << 3;
+
   final String type; // 'system' or 'microphone'
-  final String data; // base64 encoded audio data
-  final int size; // size in bytes
+  final Uint8List bytes; // PCM or one codec frame; empty for silence markers
+  final int? sequence; // per-stream packet number (binary delivery only)
+  final int flags; // native packet flags, see the constants above
+  final int? frames; // frames the packet covers, if the runner reports it
+  // Where the first frame sits on the stream's timeline, from the device
+  // position and clock (Windows and Linux runners only). Positions count
+  // every frame since the start, lost ones included; times share the
+  // native monotonic clock across both streams.
+  final int? position;
+  final int? captureTimeNs;
 
   AudioData({
     required this.type,
-    required this.data,
-    required this.size,
+    required this.bytes,
+    this.sequence,
+    this.flags = 0,
+    this.frames,
+    this.position,
+    this.captureTimeNs,
+  });
+
+  int get size => bytes.length; // size in bytes
+
+  /// Stands in for [frames] frames of silence and carries no samples.
+  bool get isSilenceMarker => flags & silenceMarkerFlag != 0;
+
+  /// Whether the native detector (or the device) found no speech.
+  bool get isSpeech => flags & (noSpeechFlag | deviceSilentFlag) == 0;
+}
+
+/// One update from the native WebSocket sink.
+class NativeStreamEvent {
+  final String state; // connecting, connected, reconnecting, stopped
+  final String? error; // why the last attempt failed or the link dropped
+  final int messagesSent;
+  final int bytesSent; // on the socket, framing included
+  final int messagesDropped; // evicted while the server was unreachable
+  final int messagesReceived;
+  final int reconnects;
+  final int messagesBlocked; // waited for room with the queue full
+  final int queuedBytes;
+  final int queuedMs;
+  final int highWaterBytes;
+  final int highWaterMs;
+  // Spilling: messages written to disk and sent from it, those lost to
+  // the disk bound or a failed write, and what waits on disk.
+  final int messagesSpilled;
+  final int messagesReplayed;
+  final int spillDropped;
+  final int spillQueuedBytes;
+  final int spillQueuedMs;
+  final int spillDiskBytes;
+  final int maxSendNs; // slowest single message write
+  // Aligned mode: frames zero-filled for a late or missing speaker, and
+  // frames that arrived after their slot had been sent.
+  final int alignedFilledFrames;
+  final int alignedLateFrames;
+  // Echo cancellation: agent frames cancelled, frames passed through over
+  // the CPU budget or uncancellable, CPU spent, and the echo reduction.
+  final int echoProcessedFrames;
+  final int echoBypassedFrames;
+  final int echoCpuNs;
+  final double echoErleDb;
+
+  NativeStreamEvent({
+    required this.state,
+    this.error,
+    this.messagesSent = 0,
+    this.bytesSent = 0,
+    this.messagesDropped = 0,
+    this.messagesReceived = 0,
+    this.reconnects = 0,
+    this.messagesBlocked = 0,
+    this.queuedBytes = 0,
+    this.queuedMs = 0,
+    this.highWaterBytes = 0,
+    this.highWaterMs = 0,
+    this.messagesSpilled = 0,
+    this.messagesReplayed = 0,
+    this.spillDropped = 0,
+    this.spillQueuedBytes = 0,
+    this.spillQueuedMs = 0,
+    this.spillDiskBytes = 0,
+    this.maxSendNs = 0,
+    this.alignedFilledFrames = 0,
+    this.alignedLateFrames = 0,
+    this.echoProcessedFrames = 0,
+    this.echoBypassedFrames = 0,
+    this.echoCpuNs = 0,
+    this.echoErleDb = 0,
+  });
+
+  bool get isConnected => state == 'connected';
+
+  factory NativeStreamEvent.fromMap(Map<dynamic, dynamic> map) {
+    return NativeStreamEvent(
+      state: map['state'] as String,
+      error: map['error'] as String?,
+      messagesSent: map['messagesSent'] as int? ?? 0,
+      bytesSent: map['bytesSent'] as int? ?? 0,
+      messagesDropped: map['messagesDropped'] as int? ?? 0,
+      messagesReceived: map['messagesReceived'] as int? ?? 0,
+      reconnects: map['reconnects'] as int? ?? 0,
+      messagesBlocked: map['messagesBlocked'] as int? ?? 0,
+      queuedBytes: map['queuedBytes'] as int? ?? 0,
+      queuedMs: map['queuedMs'] as int? ?? 0,
+      highWaterBytes: map['highWaterBytes'] as int? ?? 0,
+      highWaterMs: map['highWaterMs'] as int? ?? 0,
+      messagesSpilled: map['messagesSpilled'] as int? ?? 0,
+      messagesReplayed: map['messagesReplayed'] as int? ?? 0,
+      spillDropped: map['spillDropped'] as int? ?? 0,
+      spillQueuedBytes: map['spillQueuedBytes'] as int? ?? 0,
+      spillQueuedMs: map['spillQueuedMs'] as int? ?? 0,
+      spillDiskBytes: map['spillDiskBytes'] as int? ?? 0,
+      maxSendNs: map['maxSendNs'] as int? ?? 0,
+      alignedFilledFrames: map['alignedFilledFrames'] as int? ?? 0,
+      alignedLateFrames: map['alignedLateFrames'] as int? ?? 0,
+      echoProcessedFrames: map['echoProcessedFrames'] as int? ?? 0,
+      echoBypassedFrames: map['echoBypassedFrames'] as int? ?? 0,
+      echoCpuNs: map['echoCpuNs'] as int? ?? 0,
+      echoErleDb: (map['echoErleDb'] as num?)?.toDouble() ?? 0,
+    );
+  }
+}
+
+/// One native sink queue, from [AudioService.getSinkStats].
+class SinkQueueStats {
+  final String policy; // drop_oldest, drop_newest, block, coalesce_silence
+  final int deliveredPackets;
+  final int droppedPackets;
+  final int coalescedPackets; // silence given up for a marker
+  final int blockedPackets; // the capture waited for room
+  final int copiedPackets;
+  final int queuedPackets;
+  final int queuedBytes;
+  final int queuedMs;
+  // Highest since the sink was attached.
+  final int highWaterPackets;
+  final int highWaterBytes;
+  final int highWaterMs;
+
+  SinkQueueStats({
+    required this.policy,
+    this.deliveredPackets = 0,
+    this.droppedPackets = 0,
+    this.coalescedPackets = 0,
+    this.blockedPackets = 0,
+    this.copiedPackets = 0,
+    this.queuedPackets = 0,
+    this.queuedBytes = 0,
+    this.queuedMs = 0,
+    this.highWaterPackets = 0,
+    this.highWaterBytes = 0,
+    this.highWaterMs = 0,
   });
+
+  factory SinkQueueStats.fromMap(Map<dynamic, dynamic> map) {
+    return SinkQueueStats(
+      policy: map['policy'] as String,
+      deliveredPackets: map['deliveredPackets'] as int? ?? 0,
+      droppedPackets: map['droppedPackets'] as int? ?? 0,
+      coalescedPackets: map['coalescedPackets'] as int? ?? 0,
+      blockedPackets: map['blockedPackets'] as int? ?? 0,
+      copiedPackets: map['copiedPackets'] as int? ?? 0,
+      queuedPackets: map['queuedPackets'] as int? ?? 0,
+      queuedBytes: map['queuedBytes'] as int? ?? 0,
+      queuedMs: map['queuedMs'] as int? ?? 0,
+      highWaterPackets: map['highWaterPackets'] as int? ?? 0,
+      highWaterBytes: map['highWaterBytes'] as int? ?? 0,
+      highWaterMs: map['highWaterMs'] as int? ?? 0,
+    );
+  }
+}
+
+/// A submitted [AudioService.convertBatch]; [jobIds] follow the order of
+/// the files passed in.
+class TranscodeBatch {
+  final int id;
+  final List<int> jobIds;
+
+  TranscodeBatch({required this.id, required this.jobIds});
 }
 
+/// One update from a [AudioService.convertToMp3] or
+/// [AudioService.convertBatch] job.
+class TranscodeJobEvent {
+  final int id;
+  final String state; // queued, running, succeeded, failed, cancelled
+  final double progress; // 0..1
+  final String? error;
+  // Batch jobs only. Progress is weighted by file size and counts finished
+  // files as done whatever their outcome.
+  final int? batch;
+  final double batchProgress;
+  final int batchPending; // unfinished files in the batch
+
+  TranscodeJobEvent({
+    required this.id,
+    required this.state,
+    this.progress = 0.0,
+    this.error,
+    this.batch,
+    this.batchProgress = 0.0,
+    this.batchPending = 0,
+  });
+
+  bool get isDone =>
+      state == 'succeeded' || state == 'failed' || state == 'cancelled';
+
+  /// The last event of its batch.
+  bool get isBatchDone => batch != null && isDone && batchPending == 0;
+
+  factory TranscodeJobEvent.fromMap(Map<dynamic, dynamic> map) {
+    return TranscodeJobEvent(
+      id: map['id'] as int,
+      state: map['state'] as String,
+      progress: (map['progress'] as num?)?.toDouble() ?? 0.0,
+      error: map['error'] as String?,
+      batch: map['batch'] as int?,
+      batchProgress: (map['batchProgress'] as num?)?.toDouble() ?? 0.0,
+      batchPending: map['batchPending'] as int? ?? 0,
+    );
+  }
+}
@@ -1,4 +1,5 @@
 import 'dart:async';
+import 'dart:convert';
 import 'package:flutter/foundation.dart';
 import 'audio_service.dart';
 
@@ -15,7 +16,11 @@ class ConsoleLogger {
     _isLogging = true;
     _subscription = audioService.audioDataStream.listen((audioData) {
       final prefix = audioData.type == 'system' ? '[SYSTEM]' : '[MIC]';
-      debugPrint('$prefix ${audioData.data}');
+      if (audioData.isSilenceMarker) {
+        debugPrint('$prefix silence (${audioData.frames} frames)');
+        return;
+      }
+      debugPrint('$prefix ${base64Encode(audioData.bytes)}');
     });
   }
 
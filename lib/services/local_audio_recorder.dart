@@ -1,8 +1,8 @@
 import 'dart:async';
-import 'dart:convert';
 import 'dart:io';
 import 'package:flutter/services.dart';
 import 'package:desktop_audio_capture/audio_capture.dart';
+import 'audio_frame.dart';
 import 'audio_service.dart';
 import 'websocket_stream_service.dart';
 
@@ -23,7 +23,16 @@ class LocalAudioRecorder {
   static const int sampleRate = 44100;
   static const int channels = 2;
   static const int sampleWidth = 2; // 16-bit = 2 bytes
-  static const String mimeType = 'audio/pcm;rate=44100;channels=2;bitdepth=16';
+  static const AudioFrameFormat captureFormat =
+      AudioFrameFormat(sampleRate: sampleRate, channels: channels);
+
+  // Native live-stream settings: wideband Opus speech, about 24 kbit/s per
+  // speaker instead of 1.4 Mbit/s of stereo PCM. Runners without Opus
+  // fall back to PCM and report it in the stream's mime type.
+  static const int liveSampleRate = 16000;
+  static const AudioEncoding liveEncoding = AudioEncoding.opus();
+  // The PCM fallback is re-blocked into frames of the Opus frame length.
+  static const int liveFrameMs = 20;
 
   LocalAudioRecorder(this.audioService, {this.webSocketService});
 
@@ -52,49 +61,75 @@ class LocalAudioRecorder {
       return await _startMicrophoneCapture();
     }
 
+    // The runner streams to the server itself; nothing to relay here.
+    final native = webSocketService!.isNative;
+
     // Fallback to platform channel for other platforms or if desktop_audio_capture fails
-    if (_subscription == null) {
+    if (!native && _subscription == null) {
       _subscription = audioService.audioDataStream.listen((audioData) {
         if (!_isStreaming) return;
         
-        // Decode base64 and stream (including empty chunks)
         try {
-          final audioBytes = base64Decode(audioData.data);
-          
-          // Debug: Log if empty but still send it
-          if (audioBytes.isEmpty) {
-            print('Info: Received empty audio data for ${audioData.type} - sending anyway');
-          } else {
-            // Check if all zeros
-            final hasNonZero = audioBytes.any((byte) => byte != 0);
-            if (!hasNonZero) {
-              print('Info: Audio data is all zeros for ${audioData.type} - sending anyway');
-            }
-          }
-          
-          // Stream audio based on type (including empty chunks)
-          if (audioData.type == 'system') {
-            _streamAudioChunk('customer', audioBytes);
-          } else if (audioData.type == 'microphone') {
-            _streamAudioChunk('agent', audioBytes);
+          final stream = AudioFrame.streamFor(audioData.type);
+          final info = audioService.streamInfo(audioData.type);
+          // Native runners report the format they actually deliver.
+          final format = info != null
+              ? AudioFrameFormat.fromStreamInfo(info)
+              : captureFormat;
+          // Native capture already replaced silence with markers, so there
+          // is nothing left to scan here.
+          if (audioData.isSilenceMarker) {
+            _streamSilence(stream, format, audioData.frames ?? 0,
+                position: audioData.position,
+                captureTimeNs: audioData.captureTimeNs);
+            return;
           }
+          _streamAudioFrame(stream, audioData.bytes, format,
+              frames: audioData.frames,
+              flags: audioData.flags,
+              position: audioData.position,
+              captureTimeNs: audioData.captureTimeNs);
         } catch (e) {
-          print('Error decoding audio data: $e');
+          print('Error handling audio data: $e');
         }
       });
     }
 
-    // Start platform channel capture
+    // A running capture keeps its settings and only changes where its
+    // packets go.
+    if (await audioService.setDelivery(type, native: native)) {
+      return true;
+    }
+
+    // Start platform channel capture. Live streaming wants the shortest
+    // native buffers, the backend only needs mono speech per speaker, and
+    // pauses travel as silence markers instead of zeroed audio.
     if (type == 'system') {
-      await audioService.startSystemAudioCapture();
+      await audioService.startSystemAudioCapture(
+          profile: CaptureProfile.realtime,
+          sampleRate: liveSampleRate,
+          channels: ChannelMapping.downmix,
+          silencePolicy: SilencePolicy.markers,
+          encoding: liveEncoding,
+          frameMs: liveFrameMs,
+          native: native);
     } else if (type == 'microphone') {
-      await audioService.startMicrophoneCapture();
+      await audioService.startMicrophoneCapture(
+          profile: CaptureProfile.realtime,
+          sampleRate: liveSampleRate,
+          channels: ChannelMapping.downmix,
+          silencePolicy: SilencePolicy.markers,
+          encoding: liveEncoding,
+          frameMs: liveFrameMs,
+          native: native);
     }
 
     return true;
   }
 
-  void _streamAudioChunk(String source, List<int> audioBytes) {
+  void _streamAudioFrame(int stream, List<int> audioBytes,
+      AudioFrameFormat format,
+      {int? frames, int flags = 0, int? position, int? captureTimeNs}) {
     // Double-check streaming flag before sending
     if (!_isStreaming) {
       return;
@@ -104,18 +139,32 @@ class LocalAudioRecorder {
       return;
     }
     
-    // Stream audio chunk in background
-    webSocketService!.sendAudioChunk(
-      source: source,
-      audioBytes: audioBytes,
-      mimeType: mimeType,
-    ).then((success) {
-      if (!success) {
-        print('Failed to stream audio chunk for $source');
-      }
-    }).catchError((error) {
-      print('Error streaming audio chunk: $error');
-    });
+    // Encoded packets report their frame count; PCM is sized by its bytes.
+    final sent = webSocketService!.sendAudioFrame(
+      stream: stream,
+      audio: audioBytes,
+      format: format,
+      frames: frames ?? audioBytes.length ~/ format.bytesPerFrame,
+      flags: flags,
+      position: position,
+      captureTimeNs: captureTimeNs,
+    );
+    if (!sent) {
+      print('Failed to stream audio frame for stream $stream');
+    }
+  }
+
+  void _streamSilence(int stream, AudioFrameFormat format, int frames,
+      {int? position, int? captureTimeNs}) {
+    if (!_isStreaming || frames <= 0) {
+      return;
+    }
+    webSocketService?.sendSilenceMarker(
+        stream: stream,
+        format: format,
+        frames: frames,
+        position: position,
+        captureTimeNs: captureTimeNs);
   }
 
   Future<bool> _startSystemAudioCapture() async {
@@ -140,18 +189,7 @@ class LocalAudioRecorder {
         (audioData) {
           if (!_isStreaming) return;
           
-          // Stream audio as "customer" (speaker/system audio) - including empty chunks
-          if (audioData.isEmpty) {
-            print('Info: Received empty system audio data chunk - sending anyway');
-          } else {
-            // Check if all zeros
-            final hasNonZero = audioData.any((byte) => byte != 0);
-            if (!hasNonZero) {
-              print('Info: System audio data is all zeros - sending anyway');
-            }
-          }
-          
-          _streamAudioChunk('customer', audioData);
+          _streamAudioFrame(AudioFrame.systemStream, audioData, captureFormat);
         },
         onError: (error) {
           print('System audio stream error: $error');
@@ -193,18 +231,7 @@ class LocalAudioRecorder {
         (audioData) {
           if (!_isStreaming) return;
           
-          // Stream audio as "agent" (microphone audio) - including empty chunks
-          if (audioData.isEmpty) {
-            print('Info: Received empty microphone audio data chunk - sending anyway');
-          } else {
-            // Check if all zeros
-            final hasNonZero = audioData.any((byte) => byte != 0);
-            if (!hasNonZero) {
-              print('Info: Microphone audio data is all zeros - sending anyway');
-            }
-          }
-          
-          _streamAudioChunk('agent', audioData);
+          _streamAudioFrame(AudioFrame.microphoneStream, audioData, captureFormat);
         },
         onError: (error) {
           print('Microphone audio stream error: $error');
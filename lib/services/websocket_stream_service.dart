@@ -1,29 +1,56 @@
 import 'dart:async';
-import 'dart:convert';
 import 'dart:io';
+import 'package:path_provider/path_provider.dart';
 import 'package:web_socket_channel/io.dart';
-
-// MTU size: 1KB max per chunk
-const int maxChunkSize = 1024; // 1 KB
+import 'audio_frame.dart';
+import 'audio_service.dart';
 
 class WebSocketStreamService {
+  /// When set and the runner supports it, ws:// connections live in native
+  /// code: captures started with `native: true` stream straight from the
+  /// capture threads and the socket methods below go unused.
+  final AudioService? audioService;
+
   IOWebSocketChannel? _channel;
   WebSocket? _socket;
   bool _isConnected = false;
+  bool _native = false;
   StreamSubscription? _subscription;
   Function(bool)? onConnectionStateChanged;
-  
+  StreamSubscription<NativeStreamEvent>? _nativeSubscription;
+  NativeStreamEvent? _lastNativeEvent;
+  // Per-stream frame counters and the clock frames are stamped from.
+  final List<int> _sequence = [0, 0];
+  final Stopwatch _clock = Stopwatch()..start();
+
+  WebSocketStreamService({this.audioService});
+
   bool get isConnected => _isConnected;
-  
+
+  /// Whether the connection is held by the native sink.
+  bool get isNative => _native;
+
+  /// Whether [url] would be served by the native sink. Its client has no
+  /// TLS, so wss:// and anything else but ws:// uses the Dart client.
+  bool canConnectNatively(String url) =>
+      (audioService?.nativeStreaming ?? false) &&
+      Uri.tryParse(url)?.scheme == 'ws';
+
+  /// Latest native sink counters; null in Dart mode.
+  NativeStreamEvent? get nativeStats => _lastNativeEvent;
+
   Future<bool> connect(String url) async {
+    // Disconnect existing connection if any
+    if (_channel != null || _nativeSubscription != null) {
+      disconnect();
+    }
+    if (canConnectNatively(url)) {
+      _native = true;
+      return _connectNative(url);
+    }
     try {
       print('Connecting to WebSocket: $url');
       
-      // Disconnect existing connection if any
-      if (_channel != null) {
-        disconnect();
-      }
-      
       final uri = Uri.parse(url);
       
       // Use WebSocket.connect which actually waits for connection
@@ -37,6 +64,7 @@ class WebSocketStreamService {
         
         // Wrap the socket in an IOWebSocketChannel
         _channel = IOWebSocketChannel(_socket!);
+        _sequence.fillRange(0, _sequence.length, 0);
         _isConnected = true;
         print('WebSocket connected successfully');
         onConnectionStateChanged?.call(true);
@@ -80,7 +108,57 @@ class WebSocketStreamService {
     }
   }
   
+  /// Starts the native sink and waits for its first connection. Later drops
+  /// are retried natively, with audio spilled to disk meanwhile and
+  /// replayed after, so only a stop reports disconnected.
+  Future<bool> _connectNative(String url) async {
+    final spillDirectory = await _spillDirectory();
+    final connected = Completer<bool>();
+    _nativeSubscription = audioService!.streamEvents.listen((event) {
+      _lastNativeEvent = event;
+      if (event.isConnected && !_isConnected) {
+        _isConnected = true;
+        onConnectionStateChanged?.call(true);
+      }
+      if (!connected.isCompleted && event.state != 'connecting') {
+        if (event.error != null) {
+          print('Native WebSocket: ${event.state}: ${event.error}');
+        }
+        connected.complete(event.isConnected);
+      }
+    });
+    if (!await audioService!.startNativeStreaming(url,
+        spillDirectory: spillDirectory)) {
+      disconnect();
+      return false;
+    }
+    final ok = await connected.future.timeout(const Duration(seconds: 5),
+        onTimeout: () => false);
+    if (!ok) {
+      disconnect();
+    }
+    return ok;
+  }
+
+  /// Where the native sink spills audio it cannot send; null without an
+  /// application support directory, which leaves spilling off.
+  Future<String?> _spillDirectory() async {
+    try {
+      final support = await getApplicationSupportDirectory();
+      return '${support.path}${Platform.pathSeparator}spill';
+    } catch (e) {
+      print('No spill directory: $e');
+      return null;
+    }
+  }
+
   void disconnect() {
+    if (_nativeSubscription != null) {
+      _nativeSubscription!.cancel();
+      _nativeSubscription = null;
+      audioService!.stopNativeStreaming();
+    }
+
     _subscription?.cancel();
     _subscription = null;
     
@@ -103,87 +181,70 @@ class WebSocketStreamService {
     }
     
     _isConnected = false;
+    _native = false;
     onConnectionStateChanged?.call(false);
     print('WebSocket disconnected');
   }
   
-  Future<bool> sendAudioChunk({
-    required String source,
-    required List<int> audioBytes,
-    required String mimeType,
-  }) async {
+  /// Sends [audio] as one binary frame (see [AudioFrame]) covering
+  /// [frames] frames of [format]: one message per packet, no pacing.
+  /// [position] and [captureTimeNs] are the native timestamps
+  /// ([AudioData.position]); without them the frame is stamped on arrival.
+  bool sendAudioFrame({
+    required int stream,
+    required List<int> audio,
+    required AudioFrameFormat format,
+    required int frames,
+    int flags = 0,
+    int? position,
+    int? captureTimeNs,
+  }) {
+    return _sendFrame(
+        stream, format, frames, flags, audio, position, captureTimeNs);
+  }
+
+  /// Tells the backend [stream] was silent for [frames] frames of [format]
+  /// instead of sending that much zeroed audio.
+  bool sendSilenceMarker({
+    required int stream,
+    required AudioFrameFormat format,
+    required int frames,
+    int flags = 0,
+    int? position,
+    int? captureTimeNs,
+  }) {
+    return _sendFrame(stream, format, frames,
+        flags | AudioData.silenceMarkerFlag, const [], position, captureTimeNs);
+  }
+
+  bool _sendFrame(int stream, AudioFrameFormat format, int frames, int flags,
+      List<int> payload, int? position, int? captureTimeNs) {
     if (!_isConnected || _channel == null) {
       // Silently fail if not connected (don't spam logs)
       return false;
     }
-    
     try {
-      // Handle empty chunks - send them anyway
-      if (audioBytes.isEmpty) {
-        final base64Audio = base64Encode(audioBytes);
-        final payload = {
-          'source': source,
-          'audio': base64Audio,
-          'mime': mimeType,
-        };
-        final jsonString = jsonEncode(payload);
-        final jsonBytes = utf8.encode(jsonString);
-        
-        print('📤 WebSocket: Sending empty ${source} audio chunk (${jsonBytes.length} bytes JSON payload)');
-        _channel!.sink.add(jsonString);
-        return true;
-      }
-      
-      // Split audio into 1KB chunks (MTU)
-      int offset = 0;
-      int chunkCount = 0;
-      final totalBytes = audioBytes.length;
-      
-      while (offset < audioBytes.length) {
-        final chunkSize = (offset + maxChunkSize < audioBytes.length) 
-            ? maxChunkSize 
-            : audioBytes.length - offset;
-        
-        final chunk = audioBytes.sublist(offset, offset + chunkSize);
-        
-        // Convert audio bytes to base64
-        final base64Audio = base64Encode(chunk);
-        
-        // Create JSON payload
-        final payload = {
-          'source': source,
-          'audio': base64Audio,
-          'mime': mimeType,
-        };
-        
-        final jsonString = jsonEncode(payload);
-        final jsonBytes = utf8.encode(jsonString);
-        
-        // Log the message being sent
-        chunkCount++;
-        print('📤 WebSocket: Sending ${source} audio chunk #$chunkCount (${chunkSize} bytes audio, ${jsonBytes.length} bytes JSON payload)');
-        
-        _channel!.sink.add(jsonString);
-        
-        offset += chunkSize;
-        
-        // Small delay to avoid overwhelming the connection
-        if (offset < audioBytes.length) {
-          await Future.delayed(const Duration(milliseconds: 10));
-        }
-      }
-      
-      if (chunkCount > 1) {
-        print('📤 WebSocket: Sent $chunkCount chunks for ${source} audio (total: ${totalBytes} bytes)');
-      }
-      
+      // Without a native timestamp, stamped on arrival here and backdated
+      // by the packet's duration.
+      final durationNs = frames * 1000000000 ~/ format.sampleRate;
+      _channel!.sink.add(AudioFrame.encode(
+        stream: stream,
+        format: format,
+        frames: frames,
+        sequence: _sequence[stream]++,
+        captureTimeNs:
+            captureTimeNs ?? _clock.elapsedMicroseconds * 1000 - durationNs,
+        position: position,
+        flags: flags,
+        payload: payload,
+      ));
       return true;
     } catch (e) {
-      print('❌ Error sending audio chunk: $e');
+      print('❌ Error sending audio frame: $e');
       return false;
     }
   }
-  
+
   void dispose() {
     disconnect();
   }
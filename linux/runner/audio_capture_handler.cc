@@ -0,0 +1,568 @@
+#include "audio_capture_handler.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/base64.h"
+#include "samurai_audio_core/channel_protocol.h"
+#include "samurai_audio_core/synthetic_capture_backend.h"
+
+namespace {
+
+// Summed TranscodeMemoryEstimate() of the export jobs running at once.
+constexpr size_t kTranscodeMemoryBudget = 256u << 20;
+
+// How many packets may wait in the main loop for Dart. Beyond that the
+// Dart sink's thread waits, and the backlog builds up in its fan-out
+// queue, which is bounded, instead of in the main loop, which is not.
+constexpr int kMaxDartPacketsInFlight = 32;
+
+// The Dart sink's fan-out queue gives up silence before speech.
+constexpr samurai::BackpressurePolicy kDartQueuePolicy =
+    samurai::BackpressurePolicy::kCoalesceSilence;
+
+}  // namespace
+
+// Counts packets posted for Dart and not sent yet. Shared with the posted
+// events, which may run after the handler is gone.
+struct DartBacklog {
+  std::mutex mutex;
+  std::condition_variable cv;
+  int in_flight = 0;
+  bool closed = false;
+
+  // Waits for room. Returns false once closed.
+  bool Enter() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock,
+            [this]() { return closed || in_flight < kMaxDartPacketsInFlight; });
+    if (closed) {
+      return false;
+    }
+    ++in_flight;
+    return true;
+  }
+
+  void Leave() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --in_flight;
+    }
+    cv.notify_one();
+  }
+
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+    }
+    cv.notify_all();
+  }
+};
+
+namespace {
+
+struct AudioEvent {
+  FlMethodChannel* channel;
+  std::shared_ptr<DartBacklog> backlog;
+  samurai::StreamKind stream;
+  std::string base64;
+  size_t size;
+  uint32_t frames;
+  uint32_t flags;
+  uint64_t position;
+  int64_t capture_time_ns;
+};
+
+gboolean SendAudioEvent(gpointer user_data) {
+  AudioEvent* event = static_cast<AudioEvent*>(user_data);
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "type",
+                           fl_value_new_string(samurai::StreamKindName(event->stream)));
+  fl_value_set_string_take(args, "data",
+                           fl_value_new_string(event->base64.c_str()));
+  fl_value_set_string_take(args, "size",
+                           fl_value_new_int(static_cast<int64_t>(event->size)));
+  fl_value_set_string_take(args, "frames", fl_value_new_int(event->frames));
+  fl_value_set_string_take(args, "flags", fl_value_new_int(event->flags));
+  fl_value_set_string_take(
+      args, "position", fl_value_new_int(static_cast<int64_t>(event->position)));
+  fl_value_set_string_take(args, "captureTimeNs",
+                           fl_value_new_int(event->capture_time_ns));
+  fl_method_channel_invoke_method(event->channel, "onAudioData", args, nullptr,
+                                  nullptr, nullptr);
+
+  event->backlog->Leave();
+  g_object_unref(event->channel);
+  delete event;
+  return G_SOURCE_REMOVE;
+}
+
+struct ChannelEvent {
+  FlEventChannel* channel;
+  FlValue* value;
+  std::shared_ptr<DartBacklog> backlog;  // For PCM packets only.
+};
+
+gboolean SendChannelEvent(gpointer user_data) {
+  ChannelEvent* event = static_cast<ChannelEvent*>(user_data);
+  fl_event_channel_send(event->channel, event->value, nullptr, nullptr);
+  if (event->backlog) {
+    event->backlog->Leave();
+  }
+  fl_value_unref(event->value);
+  g_object_unref(event->channel);
+  delete event;
+  return G_SOURCE_REMOVE;
+}
+
+// Dart's arguments without the embedder's types; see channel_protocol.h.
+samurai::ChannelValue ToChannelValue(FlValue* value) {
+  if (value == nullptr) {
+    return samurai::ChannelValue();
+  }
+  switch (fl_value_get_type(value)) {
+    case FL_VALUE_TYPE_BOOL:
+      return samurai::ChannelValue::Bool(fl_value_get_bool(value));
+    case FL_VALUE_TYPE_INT:
+      return samurai::ChannelValue::Int(fl_value_get_int(value));
+    case FL_VALUE_TYPE_FLOAT:
+      return samurai::ChannelValue::Double(fl_value_get_float(value));
+    case FL_VALUE_TYPE_STRING:
+      return samurai::ChannelValue::String(fl_value_get_string(value));
+    case FL_VALUE_TYPE_FLOAT_LIST: {
+      const double* values = fl_value_get_float_list(value);
+      return samurai::ChannelValue::DoubleList(std::vector<double>(
+          values, values + fl_value_get_length(value)));
+    }
+    case FL_VALUE_TYPE_FLOAT32_LIST: {
+      const float* values = fl_value_get_float32_list(value);
+      return samurai::ChannelValue::DoubleList(std::vector<double>(
+          values, values + fl_value_get_length(value)));
+    }
+    case FL_VALUE_TYPE_LIST: {
+      samurai::ChannelValue list = samurai::ChannelValue::EmptyList();
+      for (size_t i = 0; i < fl_value_get_length(value); ++i) {
+        list.Append(ToChannelValue(fl_value_get_list_value(value, i)));
+      }
+      return list;
+    }
+    case FL_VALUE_TYPE_MAP: {
+      samurai::ChannelValue map = samurai::ChannelValue::EmptyMap();
+      for (size_t i = 0; i < fl_value_get_length(value); ++i) {
+        FlValue* key = fl_value_get_map_key(value, i);
+        if (fl_value_get_type(key) == FL_VALUE_TYPE_STRING) {
+          map.Set(fl_value_get_string(key),
+                  ToChannelValue(fl_value_get_map_value(value, i)));
+        }
+      }
+      return map;
+    }
+    default:
+      return samurai::ChannelValue();
+  }
+}
+
+// Returns a new reference.
+FlValue* ToFlValue(const samurai::ChannelValue& value) {
+  switch (value.type()) {
+    case samurai::ChannelValue::Type::kNull:
+      break;
+    case samurai::ChannelValue::Type::kBool:
+      return fl_value_new_bool(value.bool_value());
+    case samurai::ChannelValue::Type::kInt:
+      return fl_value_new_int(value.int_value());
+    case samurai::ChannelValue::Type::kDouble:
+      return fl_value_new_float(value.double_value());
+    case samurai::ChannelValue::Type::kString:
+      return fl_value_new_string(value.string_value().c_str());
+    case samurai::ChannelValue::Type::kDoubleList:
+      return fl_value_new_float_list(value.double_list().data(),
+                                     value.double_list().size());
+    case samurai::ChannelValue::Type::kList: {
+      FlValue* list = fl_value_new_list();
+      for (const samurai::ChannelValue& item : value.list()) {
+        fl_value_append_take(list, ToFlValue(item));
+      }
+      return list;
+    }
+    case samurai::ChannelValue::Type::kMap: {
+      FlValue* map = fl_value_new_map();
+      for (const auto& entry : value.map()) {
+        fl_value_set_string_take(map, entry.first.c_str(),
+                                 ToFlValue(entry.second));
+      }
+      return map;
+    }
+  }
+  return fl_value_new_null();
+}
+
+FlMethodResponse* SuccessResponse(const samurai::ChannelValue& value) {
+  g_autoptr(FlValue) result = ToFlValue(value);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* ErrorResponse(const samurai::ChannelResult& error) {
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      error.code.c_str(), error.message.c_str(), nullptr));
+}
+
+}  // namespace
+
+AudioCaptureHandler::AudioCaptureHandler(FlBinaryMessenger* messenger) {
+  // Synthesize exactly the format the Dart side assumes.
+  samurai::SyntheticCaptureBackend::Options options;
+  options.format = samurai::DefaultOutputFormat();
+  options.packet_frames = 441;
+  capture_engine_ = std::make_unique<samurai::CaptureEngine>(
+      std::make_unique<samurai::SyntheticCaptureBackend>(options));
+  capture_engine_->Initialize();
+  dart_backlog_ = std::make_shared<DartBacklog>();
+  fan_out_ = std::make_unique<samurai::PacketFanOut>();
+  samurai::FanOutSinkConfig dart_queue;
+  dart_queue.policy = kDartQueuePolicy;
+  dart_sink_id_ = fan_out_->Attach(
+      dart_queue,
+      [this](const samurai::AudioPacket& packet) { OnAudioData(packet); });
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  method_channel_ = fl_method_channel_new(messenger, "com.samurai.audio_capture",
+                                          FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(method_channel_, MethodCallCallback,
+                                            this, nullptr);
+
+  pcm_channel_ = fl_event_channel_new(messenger, "com.samurai.audio_capture/pcm",
+                                      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(pcm_channel_, PcmListenCallback,
+                                       PcmCancelCallback, this, nullptr);
+
+  jobs_channel_ = fl_event_channel_new(
+      messenger, "com.samurai.audio_capture/jobs", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(jobs_channel_, JobsListenCallback,
+                                       JobsCancelCallback, this, nullptr);
+  stream_channel_ = fl_event_channel_new(
+      messenger, "com.samurai.audio_capture/stream", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(stream_channel_, StreamListenCallback,
+                                       StreamCancelCallback, this, nullptr);
+  // No ffmpeg fallback here: without LAME, jobs fail with an error event.
+  // One worker per core for batch exports, capped in memory.
+  transcode_jobs_ = std::make_unique<samurai::TranscodeJobQueue>(
+      0, [this](const samurai::JobEvent& event) { OnJobEvent(event); });
+  transcode_jobs_->SetMemoryBudget(kTranscodeMemoryBudget);
+}
+
+AudioCaptureHandler::~AudioCaptureHandler() {
+  transcode_jobs_.reset();
+  capture_engine_->StopAll();
+  StopNativeStreaming();
+  dart_backlog_->Close();
+  fan_out_.reset();
+  fl_method_channel_set_method_call_handler(method_channel_, nullptr, nullptr,
+                                            nullptr);
+  g_object_unref(method_channel_);
+  fl_event_channel_set_stream_handlers(pcm_channel_, nullptr, nullptr, nullptr,
+                                       nullptr);
+  g_object_unref(pcm_channel_);
+  fl_event_channel_set_stream_handlers(jobs_channel_, nullptr, nullptr, nullptr,
+                                       nullptr);
+  g_object_unref(jobs_channel_);
+  fl_event_channel_set_stream_handlers(stream_channel_, nullptr, nullptr,
+                                       nullptr, nullptr);
+  g_object_unref(stream_channel_);
+}
+
+FlMethodErrorResponse* AudioCaptureHandler::PcmListenCallback(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  static_cast<AudioCaptureHandler*>(user_data)->pcm_listening_ = true;
+  return nullptr;
+}
+
+FlMethodErrorResponse* AudioCaptureHandler::PcmCancelCallback(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  static_cast<AudioCaptureHandler*>(user_data)->pcm_listening_ = false;
+  return nullptr;
+}
+
+FlMethodErrorResponse* AudioCaptureHandler::JobsListenCallback(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  static_cast<AudioCaptureHandler*>(user_data)->jobs_listening_ = true;
+  return nullptr;
+}
+
+FlMethodErrorResponse* AudioCaptureHandler::JobsCancelCallback(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  static_cast<AudioCaptureHandler*>(user_data)->jobs_listening_ = false;
+  return nullptr;
+}
+
+FlMethodErrorResponse* AudioCaptureHandler::StreamListenCallback(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  static_cast<AudioCaptureHandler*>(user_data)->stream_listening_ = true;
+  return nullptr;
+}
+
+FlMethodErrorResponse* AudioCaptureHandler::StreamCancelCallback(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  static_cast<AudioCaptureHandler*>(user_data)->stream_listening_ = false;
+  return nullptr;
+}
+
+void AudioCaptureHandler::MethodCallCallback(FlMethodChannel* channel,
+                                             FlMethodCall* method_call,
+                                             gpointer user_data) {
+  static_cast<AudioCaptureHandler*>(user_data)->HandleMethodCall(method_call);
+}
+
+void AudioCaptureHandler::HandleMethodCall(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  const samurai::ChannelValue args =
+      ToChannelValue(fl_method_call_get_args(method_call));
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "getInputDevices") == 0) {
+    response = SuccessResponse(
+        samurai::DeviceListValue(capture_engine_->GetInputDevices()));
+  } else if (strcmp(method, "getOutputDevices") == 0) {
+    response = SuccessResponse(
+        samurai::DeviceListValue(capture_engine_->GetOutputDevices()));
+  } else if (strcmp(method, "startSystemAudioCapture") == 0) {
+    response = StartCapture(samurai::StreamKind::kSystem, args);
+  } else if (strcmp(method, "startMicrophoneCapture") == 0) {
+    response = StartCapture(samurai::StreamKind::kMicrophone, args);
+  } else if (strcmp(method, "stopSystemAudioCapture") == 0 ||
+             strcmp(method, "stopMicrophoneCapture") == 0) {
+    capture_engine_->Stop(strcmp(method, "stopSystemAudioCapture") == 0
+                              ? samurai::StreamKind::kSystem
+                              : samurai::StreamKind::kMicrophone);
+    response = SuccessResponse(samurai::ChannelValue::Bool(true));
+  } else if (strcmp(method, "setDelivery") == 0) {
+    // Moves a running capture between Dart and native streaming.
+    samurai::StreamKind kind = samurai::ParseStreamType(args);
+    if (!capture_engine_->IsCapturing(kind)) {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "NOT_CAPTURING", "Capture is not running", nullptr));
+    } else {
+      SetDelivery(kind, samurai::ParseCaptureDelivery(args));
+      response = SuccessResponse(samurai::ChannelValue::Bool(true));
+    }
+  } else if (strcmp(method, "getCaptureStats") == 0) {
+    response = SuccessResponse(samurai::CaptureStatsValue(
+        capture_engine_->GetStats(samurai::ParseStreamType(args))));
+  } else if (strcmp(method, "convertToMp3") == 0) {
+    samurai::TranscodeRequest request;
+    samurai::ChannelResult parsed =
+        samurai::ParseConvertRequest(args, &request);
+    if (!parsed.ok()) {
+      response = ErrorResponse(parsed);
+    } else {
+      // Returns at once; the job reports through the jobs EventChannel.
+      response = SuccessResponse(samurai::ChannelValue::Int(
+          static_cast<int64_t>(transcode_jobs_->Submit(request))));
+    }
+  } else if (strcmp(method, "convertBatch") == 0) {
+    response = ConvertBatch(args);
+  } else if (strcmp(method, "cancelJob") == 0) {
+    int64_t id = args.GetInt("id", 0);
+    response = SuccessResponse(samurai::ChannelValue::Bool(
+        id > 0 && transcode_jobs_->Cancel(static_cast<uint64_t>(id))));
+  } else if (strcmp(method, "cancelBatch") == 0) {
+    int64_t batch = args.GetInt("batch", 0);
+    response = SuccessResponse(samurai::ChannelValue::Bool(
+        batch > 0 &&
+        transcode_jobs_->CancelBatch(static_cast<uint64_t>(batch))));
+  } else if (strcmp(method, "startNativeStreaming") == 0) {
+    response = StartNativeStreaming(args);
+  } else if (strcmp(method, "stopNativeStreaming") == 0) {
+    StopNativeStreaming();
+    response = SuccessResponse(samurai::ChannelValue::Bool(true));
+  } else if (strcmp(method, "getSinkStats") == 0) {
+    samurai::ChannelValue sinks = samurai::ChannelValue::EmptyMap();
+    samurai::FanOutSinkStats stats;
+    if (fan_out_->GetStats(dart_sink_id_, &stats)) {
+      sinks.Set("dart", samurai::SinkQueueValue(kDartQueuePolicy, stats));
+    }
+    if (websocket_sink_id_ != 0 &&
+        fan_out_->GetStats(websocket_sink_id_, &stats)) {
+      sinks.Set("websocket",
+                samurai::SinkQueueValue(websocket_policy_, stats));
+    }
+    response = SuccessResponse(sinks);
+  } else {
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  fl_method_call_respond(method_call, response, nullptr);
+}
+
+FlMethodResponse* AudioCaptureHandler::StartCapture(
+    samurai::StreamKind kind, const samurai::ChannelValue& args) {
+  samurai::CaptureRequest request;
+  samurai::ChannelResult parsed = samurai::ParseCaptureRequest(args, &request);
+  if (!parsed.ok()) {
+    return ErrorResponse(parsed);
+  }
+  // A running stream keeps its settings and delivery; see setDelivery.
+  if (capture_engine_->IsCapturing(kind)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ALREADY_CAPTURING", "Capture is already running", nullptr));
+  }
+  // Set before the first packet can reach OnAudioData().
+  SetDelivery(kind, request.delivery);
+  bool success = capture_engine_->Start(
+      kind, request.device_id, request.settings,
+      [this](const samurai::AudioPacket& packet) {
+        fan_out_->Deliver(packet);
+      });
+  samurai::StreamInfo info;
+  if (!success || !capture_engine_->GetStreamInfo(kind, &info)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "FAILED", "Failed to start audio capture", nullptr));
+  }
+  return SuccessResponse(samurai::StreamInfoValue(request.profile, info));
+}
+
+void AudioCaptureHandler::SetDelivery(
+    samurai::StreamKind kind, const samurai::CaptureDelivery& delivery) {
+  binary_delivery_[static_cast<int>(kind)] = delivery.binary;
+  native_delivery_[static_cast<int>(kind)] = delivery.native;
+}
+
+FlMethodResponse* AudioCaptureHandler::ConvertBatch(
+    const samurai::ChannelValue& args) {
+  std::vector<samurai::TranscodeRequest> requests;
+  samurai::ChannelResult parsed =
+      samurai::ParseConvertBatchRequest(args, &requests);
+  if (!parsed.ok()) {
+    return ErrorResponse(parsed);
+  }
+  std::vector<uint64_t> ids;
+  uint64_t batch = transcode_jobs_->SubmitBatch(requests, &ids);
+  return SuccessResponse(samurai::BatchValue(batch, ids));
+}
+
+FlMethodResponse* AudioCaptureHandler::StartNativeStreaming(
+    const samurai::ChannelValue& args) {
+  samurai::NativeStreamingRequest request;
+  samurai::ChannelResult parsed =
+      samurai::ParseNativeStreamingRequest(args, &request);
+  if (!parsed.ok()) {
+    return ErrorResponse(parsed);
+  }
+  const samurai::WebSocketSinkConfig& config = request.sink;
+  const samurai::BackpressurePolicy policy = request.policy;
+
+  // One connection at a time; a new call replaces the old sink.
+  StopNativeStreaming();
+  auto sink = std::make_unique<samurai::WebSocketSink>(
+      config, [this](const samurai::WebSocketSinkEvent& event) {
+        OnStreamEvent(event);
+      });
+  sink->Start();
+  samurai::WebSocketSink* raw = sink.get();
+  websocket_ = std::move(sink);
+  websocket_policy_ = policy;
+  samurai::FanOutSinkConfig queue;
+  queue.max_bytes = config.max_queued_bytes;
+  queue.max_duration_ms = config.max_queued_ms;
+  queue.policy = policy;
+  websocket_sink_id_ = fan_out_->Attach(
+      queue, [this, raw](const samurai::AudioPacket& packet) {
+        if (native_delivery_[static_cast<int>(packet.stream)]) {
+          raw->Deliver(packet);
+        }
+      });
+  return SuccessResponse(samurai::ChannelValue::Bool(true));
+}
+
+void AudioCaptureHandler::StopNativeStreaming() {
+  // Capture keeps running for the other sinks. Stopping the sink first
+  // releases a fan-out thread waiting on its full queue; what the detach
+  // then hands over is dropped.
+  if (websocket_) {
+    websocket_->Stop();
+  }
+  if (websocket_sink_id_ != 0) {
+    fan_out_->Detach(websocket_sink_id_);
+    websocket_sink_id_ = 0;
+  }
+  websocket_.reset();
+}
+
+void AudioCaptureHandler::OnAudioData(const samurai::AudioPacket& packet) {
+  if (native_delivery_[static_cast<int>(packet.stream)] &&
+      !binary_delivery_[static_cast<int>(packet.stream)]) {
+    return;
+  }
+  if (binary_delivery_[static_cast<int>(packet.stream)] && !pcm_listening_) {
+    return;
+  }
+  // Waiting here, on the Dart sink's thread, leaves the backlog to its
+  // fan-out queue and policy.
+  if (!dart_backlog_->Enter()) {
+    return;
+  }
+  if (binary_delivery_[static_cast<int>(packet.stream)]) {
+    FlValue* value = fl_value_new_map();
+    fl_value_set_string_take(value, "type",
+                             fl_value_new_string(samurai::StreamKindName(packet.stream)));
+    fl_value_set_string_take(value, "seq",
+                             fl_value_new_int(static_cast<int64_t>(packet.sequence)));
+    fl_value_set_string_take(value, "flags", fl_value_new_int(packet.flags));
+    // Silence markers carry a frame count and no samples.
+    fl_value_set_string_take(value, "frames", fl_value_new_int(packet.frames));
+    // Sample-accurate stream position and capture time of the first frame.
+    fl_value_set_string_take(
+        value, "position",
+        fl_value_new_int(static_cast<int64_t>(packet.position)));
+    fl_value_set_string_take(value, "captureTimeNs",
+                             fl_value_new_int(packet.capture_time_ns));
+    fl_value_set_string_take(value, "data",
+                             fl_value_new_uint8_list(packet.data, packet.size));
+
+    ChannelEvent* event = new ChannelEvent();
+    event->channel = FL_EVENT_CHANNEL(g_object_ref(pcm_channel_));
+    event->value = value;
+    event->backlog = dart_backlog_;
+    g_idle_add(SendChannelEvent, event);
+    return;
+  }
+
+  AudioEvent* event = new AudioEvent();
+  event->channel = FL_METHOD_CHANNEL(g_object_ref(method_channel_));
+  event->backlog = dart_backlog_;
+  event->stream = packet.stream;
+  event->base64 = samurai::Base64Encode(packet.data, packet.size);
+  event->size = packet.size;
+  event->frames = packet.frames;
+  event->flags = packet.flags;
+  event->position = packet.position;
+  event->capture_time_ns = packet.capture_time_ns;
+  g_idle_add(SendAudioEvent, event);
+}
+
+void AudioCaptureHandler::OnJobEvent(const samurai::JobEvent& event) {
+  if (!jobs_listening_) {
+    return;
+  }
+  ChannelEvent* pending = new ChannelEvent();
+  pending->channel = FL_EVENT_CHANNEL(g_object_ref(jobs_channel_));
+  pending->value = ToFlValue(samurai::JobEventValue(event));
+  g_idle_add(SendChannelEvent, pending);
+}
+
+void AudioCaptureHandler::OnStreamEvent(
+    const samurai::WebSocketSinkEvent& event) {
+  if (!stream_listening_) {
+    return;
+  }
+  ChannelEvent* pending = new ChannelEvent();
+  pending->channel = FL_EVENT_CHANNEL(g_object_ref(stream_channel_));
+  pending->value = ToFlValue(samurai::StreamEventValue(event));
+  g_idle_add(SendChannelEvent, pending);
+}
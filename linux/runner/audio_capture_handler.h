@@ -0,0 +1,98 @@
+#ifndef FLUTTER_AUDIO_CAPTURE_HANDLER_H_
+#define FLUTTER_AUDIO_CAPTURE_HANDLER_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/channel_protocol.h"
+#include "samurai_audio_core/packet_fan_out.h"
+#include "samurai_audio_core/transcode_jobs.h"
+#include "samurai_audio_core/websocket_sink.h"
+
+// Serves the com.samurai.audio_capture method channel on Linux. There is no
+// native capture backend yet, so the synthetic backend stands in for the
+// devices; the channel contract matches the Windows runner.
+struct DartBacklog;
+
+class AudioCaptureHandler {
+ public:
+  explicit AudioCaptureHandler(FlBinaryMessenger* messenger);
+  ~AudioCaptureHandler();
+
+  AudioCaptureHandler(const AudioCaptureHandler&) = delete;
+  AudioCaptureHandler& operator=(const AudioCaptureHandler&) = delete;
+
+ private:
+  static void MethodCallCallback(FlMethodChannel* channel,
+                                 FlMethodCall* method_call,
+                                 gpointer user_data);
+  static FlMethodErrorResponse* PcmListenCallback(FlEventChannel* channel,
+                                                  FlValue* args,
+                                                  gpointer user_data);
+  static FlMethodErrorResponse* PcmCancelCallback(FlEventChannel* channel,
+                                                  FlValue* args,
+                                                  gpointer user_data);
+  static FlMethodErrorResponse* JobsListenCallback(FlEventChannel* channel,
+                                                   FlValue* args,
+                                                   gpointer user_data);
+  static FlMethodErrorResponse* JobsCancelCallback(FlEventChannel* channel,
+                                                   FlValue* args,
+                                                   gpointer user_data);
+  static FlMethodErrorResponse* StreamListenCallback(FlEventChannel* channel,
+                                                     FlValue* args,
+                                                     gpointer user_data);
+  static FlMethodErrorResponse* StreamCancelCallback(FlEventChannel* channel,
+                                                     FlValue* args,
+                                                     gpointer user_data);
+
+  void HandleMethodCall(FlMethodCall* method_call);
+  FlMethodResponse* StartCapture(samurai::StreamKind kind,
+                                 const samurai::ChannelValue& args);
+  // Sets how packets of |kind| reach Dart.
+  void SetDelivery(samurai::StreamKind kind,
+                   const samurai::CaptureDelivery& delivery);
+  FlMethodResponse* ConvertBatch(const samurai::ChannelValue& args);
+  FlMethodResponse* StartNativeStreaming(const samurai::ChannelValue& args);
+  void StopNativeStreaming();
+
+  // Called on the fan-out thread of the Dart sink; hops to the main loop
+  // before touching the channel.
+  void OnAudioData(const samurai::AudioPacket& packet);
+  // Called on job workers; same hop as OnAudioData.
+  void OnJobEvent(const samurai::JobEvent& event);
+  // Called on the sink's network thread; same hop as OnAudioData.
+  void OnStreamEvent(const samurai::WebSocketSinkEvent& event);
+
+  FlMethodChannel* method_channel_;
+  // Binary PCM delivery ("delivery": "binary").
+  FlEventChannel* pcm_channel_;
+  std::atomic<bool> pcm_listening_{false};
+  std::atomic<bool> binary_delivery_[samurai::kStreamKindCount] = {};
+  // WAV -> MP3 export progress and results.
+  FlEventChannel* jobs_channel_;
+  std::atomic<bool> jobs_listening_{false};
+  // Native WebSocket streaming ("delivery": "native"): packets go from the
+  // fan-out straight to the sink; state and counters go out here. With
+  // "mirror" they reach Dart as binary packets as well.
+  FlEventChannel* stream_channel_;
+  std::atomic<bool> stream_listening_{false};
+  std::atomic<bool> native_delivery_[samurai::kStreamKindCount] = {};
+  std::unique_ptr<samurai::WebSocketSink> websocket_;
+  uint64_t websocket_sink_id_ = 0;
+  samurai::BackpressurePolicy websocket_policy_ =
+      samurai::BackpressurePolicy::kDropOldest;
+  // Every captured packet goes to the Dart sink and, while streaming, the
+  // WebSocket sink, each through its own queue.
+  std::unique_ptr<samurai::PacketFanOut> fan_out_;
+  uint64_t dart_sink_id_ = 0;
+  // Bounds what the Dart sink has posted to the main loop.
+  std::shared_ptr<DartBacklog> dart_backlog_;
+  std::unique_ptr<samurai::CaptureEngine> capture_engine_;
+  std::unique_ptr<samurai::TranscodeJobQueue> transcode_jobs_;
+};
+
+#endif  // FLUTTER_AUDIO_CAPTURE_HANDLER_H_
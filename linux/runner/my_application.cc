@@ -5,11 +5,13 @@
 #include <gdk/gdkx.h>
 #endif
 
+#include "audio_capture_handler.h"
 #include "flutter/generated_plugin_registrant.h"
 
 struct _MyApplication {
   GtkApplication parent_instance;
   char** dart_entrypoint_arguments;
+  AudioCaptureHandler* audio_capture_handler;
 };
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
@@ -75,6 +77,11 @@ static void my_application_activate(GApplication* application) {
 
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
 
+  // Initialize audio capture handler
+  FlEngine* engine = fl_view_get_engine(view);
+  self->audio_capture_handler =
+      new AudioCaptureHandler(fl_engine_get_binary_messenger(engine));
+
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
 
@@ -121,6 +128,8 @@ static void my_application_shutdown(GApplication* application) {
 static void my_application_dispose(GObject* object) {
   MyApplication* self = MY_APPLICATION(object);
   g_clear_pointer(&self->dart_entrypoint_arguments, g_strfreev);
+  delete self->audio_capture_handler;
+  self->audio_capture_handler = nullptr;
   G_OBJECT_CLASS(my_application_parent_class)->dispose(object);
 }
 
@@ -0,0 +1,62 @@
+// Base64 throughput of each encoder implementation on capture-sized packets
+// (44.1 kHz stereo int16).
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/base64.h"
+
+using namespace samurai;
+
+namespace {
+
+double MeasureGbPerSecond(Base64Impl impl, const std::vector<uint8_t>& input) {
+  std::string out(Base64EncodedSize(input.size()), '\0');
+  const auto budget = std::chrono::milliseconds(300);
+
+  uint64_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto now = start;
+  while (now - start < budget) {
+    for (int i = 0; i < 64; ++i) {
+      Base64EncodeWith(impl, input.data(), input.size(), &out[0]);
+    }
+    bytes += 64 * input.size();
+    now = std::chrono::steady_clock::now();
+  }
+  // Keep the result observable.
+  volatile char sink = out[out.size() / 2];
+  (void)sink;
+  return bytes / std::chrono::duration<double>(now - start).count() / 1e9;
+}
+
+}  // namespace
+
+int main() {
+  const uint32_t kBlockAlign = 4;
+  const uint32_t kPacketFrames[] = {441, 882, 4410};
+  const Base64Impl kImpls[] = {Base64Impl::kScalar, Base64Impl::kSsse3,
+                               Base64Impl::kAvx2, Base64Impl::kNeon};
+
+  std::printf("best implementation: %s\n", Base64ImplName(Base64BestImpl()));
+  std::printf("%-8s %10s %10s\n", "impl", "frames", "GB/s");
+
+  std::mt19937 rng(42);
+  for (uint32_t frames : kPacketFrames) {
+    std::vector<uint8_t> input(frames * kBlockAlign);
+    for (auto& byte : input) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    for (Base64Impl impl : kImpls) {
+      if (!Base64ImplSupported(impl)) {
+        continue;
+      }
+      std::printf("%-8s %10u %10.2f\n", Base64ImplName(impl), frames,
+                  MeasureGbPerSecond(impl, input));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+// CPU cost of resampling one second of stereo audio, per quality tier and
+// kernel, fed in 10 ms packets as the capture thread does. "ms/s" is
+// milliseconds of CPU per stream-second; the reciprocal is how many
+// streams one core could keep up with.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "samurai_audio_core/resampler.h"
+
+using namespace samurai;
+
+namespace {
+
+double MeasureMsPerStreamSecond(uint32_t input_rate, uint32_t output_rate,
+                                ResamplerQuality quality, ResamplerImpl impl) {
+  const uint16_t kChannels = 2;
+  Resampler resampler(input_rate, output_rate, kChannels, quality, impl);
+  const size_t packet = input_rate / 100;
+  std::vector<float> input(packet * kChannels);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<float>(std::sin(i * 0.01));
+  }
+  std::vector<float> out(resampler.MaxOutputFrames(packet) * kChannels);
+  const auto budget = std::chrono::milliseconds(300);
+
+  uint64_t frames = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto now = start;
+  while (now - start < budget) {
+    for (int i = 0; i < 20; ++i) {
+      resampler.Process(input.data(), packet, out.data());
+    }
+    frames += 20 * packet;
+    now = std::chrono::steady_clock::now();
+  }
+  volatile float sink = out[0];
+  (void)sink;
+  const double seconds = std::chrono::duration<double>(now - start).count();
+  return seconds * 1000.0 / (static_cast<double>(frames) / input_rate);
+}
+
+}  // namespace
+
+int main() {
+  const uint32_t kRates[][2] = {
+      {48000, 16000}, {44100, 16000}, {48000, 44100}, {96000, 48000}};
+  const ResamplerQuality kQualities[] = {ResamplerQuality::kLow,
+                                         ResamplerQuality::kMedium,
+                                         ResamplerQuality::kHigh};
+  const ResamplerImpl kImpls[] = {ResamplerImpl::kScalar, ResamplerImpl::kSse2,
+                                  ResamplerImpl::kAvx2, ResamplerImpl::kNeon};
+
+  std::printf("best implementation: %s\n",
+              ResamplerImplName(ResamplerBestImpl()));
+  std::printf("%-13s %-7s %5s %-7s %8s %10s\n", "rates", "quality", "taps",
+              "impl", "ms/s", "streams");
+  for (const auto& rates : kRates) {
+    for (ResamplerQuality quality : kQualities) {
+      const uint32_t taps =
+          Resampler(rates[0], rates[1], 2, quality).taps();
+      for (ResamplerImpl impl : kImpls) {
+        if (!ResamplerImplSupported(impl)) {
+          continue;
+        }
+        const double ms =
+            MeasureMsPerStreamSecond(rates[0], rates[1], quality, impl);
+        char label[32];
+        std::snprintf(label, sizeof(label), "%u>%u", rates[0], rates[1]);
+        std::printf("%-13s %-7s %5u %-7s %8.3f %10.0f\n", label,
+                    ResamplerQualityName(quality), taps,
+                    ResamplerImplName(impl), ms, 1000.0 / ms);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Batch transcode throughput against worker count, on synthetic 44.1 kHz
+// float stereo WAVs. Uses the best encoder built in (MP3, then Opus, then
+// 16-bit WAV). "x rt" is audio seconds encoded per wall-clock second;
+// "speedup" is against one worker and should track the worker count up to
+// the number of physical cores.
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/audio_file_writer.h"
+#include "samurai_audio_core/transcode_jobs.h"
+
+using namespace samurai;
+
+namespace {
+
+bool WriteSyntheticWav(const std::string& path, double seconds,
+                       uint32_t seed) {
+  AudioFormat format;
+  format.sample_rate = 44100;
+  format.channels = 2;
+  format.sample_type = SampleType::kFloat32;
+  EncoderConfig pcm;
+  pcm.codec = CodecId::kPcm;
+  AudioFileWriter writer;
+  if (!writer.Open(path, pcm, format)) {
+    return false;
+  }
+  // A chord plus a little noise, so encoders cannot coast on silence.
+  std::vector<float> block(4410 * 2);
+  const double rate = format.sample_rate;
+  uint32_t noise = seed;
+  const size_t total = static_cast<size_t>(seconds * rate);
+  for (size_t done = 0; done < total; done += 4410) {
+    for (size_t i = 0; i < 4410; ++i) {
+      const double t = (done + i) / rate;
+      noise = noise * 1664525u + 1013904223u;
+      const float n = static_cast<float>(noise >> 8) / (1 << 24) - 0.5f;
+      block[i * 2] = static_cast<float>(
+          0.3 * std::sin(2 * 3.14159265358979 * 220.0 * t) + 0.02 * n);
+      block[i * 2 + 1] = static_cast<float>(
+          0.3 * std::sin(2 * 3.14159265358979 * 330.0 * t) - 0.02 * n);
+    }
+    writer.Write(reinterpret_cast<const uint8_t*>(block.data()), 4410);
+  }
+  return writer.Close();
+}
+
+// Runs |requests| as one batch and returns the wall-clock seconds taken, or
+// a negative value if any job failed.
+double RunBatch(size_t workers, const std::vector<TranscodeRequest>& requests) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  bool failed = false;
+  TranscodeJobQueue queue(workers, [&](const JobEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    failed |= event.state == JobState::kFailed;
+    if (event.batch != 0 && event.batch_pending == 0) {
+      done = true;
+      cv.notify_all();
+    }
+  });
+  const auto start = std::chrono::steady_clock::now();
+  queue.SubmitBatch(requests, nullptr);
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&]() { return done; });
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return failed ? -1.0 : seconds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const double file_seconds = argc > 1 ? std::atof(argv[1]) : 20.0;
+  const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  const size_t files = argc > 2 ? static_cast<size_t>(std::atoi(argv[2]))
+                                : std::max<size_t>(8, cores * 2);
+
+  EncoderConfig encoder;
+  encoder.codec = CodecId::kPcm;
+  for (CodecId codec : {CodecId::kMp3, CodecId::kOpus}) {
+    if (AudioCodecAvailable(codec)) {
+      encoder.codec = codec;
+      break;
+    }
+  }
+  encoder.bitrate = encoder.codec == CodecId::kMp3 ? 192000 : 64000;
+  encoder.application = OpusApplication::kAudio;
+
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "samurai_transcode_benchmark";
+  std::filesystem::create_directories(dir);
+  std::vector<TranscodeRequest> requests;
+  for (size_t i = 0; i < files; ++i) {
+    TranscodeRequest request;
+    request.input_path = (dir / ("in" + std::to_string(i) + ".wav")).string();
+    request.output_path = (dir / ("out" + std::to_string(i) + "." +
+                                  AudioFileExtension(encoder.codec)))
+                              .string();
+    request.encoder = encoder;
+    if (!WriteSyntheticWav(request.input_path, file_seconds,
+                           static_cast<uint32_t>(i + 1))) {
+      std::fprintf(stderr, "cannot write %s\n", request.input_path.c_str());
+      return 1;
+    }
+    requests.push_back(request);
+  }
+
+  std::printf("codec: %s, %zu files x %.0f s, %zu cores\n",
+              CodecName(encoder.codec), files, file_seconds, cores);
+  std::printf("%7s %9s %9s %8s %10s\n", "workers", "seconds", "x rt",
+              "speedup", "efficiency");
+  double baseline = 0.0;
+  for (size_t workers = 1; workers <= cores; workers *= 2) {
+    const double seconds = RunBatch(workers, requests);
+    if (seconds < 0) {
+      std::fprintf(stderr, "a transcode failed\n");
+      break;
+    }
+    if (workers == 1) {
+      baseline = seconds;
+    }
+    const double speedup = baseline / seconds;
+    std::printf("%7zu %9.3f %9.1f %8.2f %9.0f%%\n", workers, seconds,
+                files * file_seconds / seconds, speedup,
+                100.0 * speedup / workers);
+    if (workers < cores && workers * 2 > cores) {
+      workers = cores / 2;  // Always finish on the full core count.
+    }
+  }
+  std::filesystem::remove_all(dir);
+  return 0;
+}
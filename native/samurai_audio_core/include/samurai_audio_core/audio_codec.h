@@ -0,0 +1,141 @@
+#ifndef SAMURAI_AUDIO_CORE_AUDIO_CODEC_H_
+#define SAMURAI_AUDIO_CORE_AUDIO_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+enum class CodecId {
+  kPcm,   // Raw interleaved PCM in the delivered format.
+  kOpus,  // RFC 6716, one Opus packet per codec frame. Needs libopus.
+  kMp3,   // MPEG-1/2 Layer III, CBR. Needs LAME; used for file export.
+};
+
+// "pcm" / "opus" / "mp3", as used on the platform channel.
+const char* CodecName(CodecId codec);
+
+// Parses a codec name. Returns false (leaving |codec| alone) for unknown
+// names.
+bool ParseCodecId(const std::string& name, CodecId* codec);
+
+// Whether this build can create encoders for |codec|.
+bool AudioCodecAvailable(CodecId codec);
+
+// Mime type of |codec| packets encoded from |format|, as
+// AudioEncoder::MimeType() reports it.
+std::string CodecMimeType(CodecId codec, const AudioFormat& format);
+
+// Opus signal tuning (OPUS_APPLICATION_*).
+enum class OpusApplication {
+  kVoip,   // Speech intelligibility; the default for live calls.
+  kAudio,  // Music and mixed content.
+};
+
+// "voip" / "audio".
+const char* OpusApplicationName(OpusApplication application);
+bool ParseOpusApplication(const std::string& name,
+                          OpusApplication* application);
+
+struct EncoderConfig {
+  CodecId codec = CodecId::kPcm;
+  // Target bitrate in bits/s for codecs that have one. Opus clamps to
+  // 6000..510000; MP3 picks the nearest standard rate.
+  uint32_t bitrate = 24000;
+  // Duration of one codec frame. Opus accepts 10, 20, 40 and 60 ms; MP3
+  // frames are always 1152 samples.
+  uint32_t frame_ms = 20;
+  OpusApplication application = OpusApplication::kVoip;
+};
+
+// Encodes fixed-size frames of interleaved PCM. Implementations are not
+// thread-safe; one encoder serves one stream.
+class AudioEncoder {
+ public:
+  virtual ~AudioEncoder() = default;
+
+  // What the encoder actually runs with, after clamping.
+  virtual const EncoderConfig& config() const = 0;
+  virtual const AudioFormat& input_format() const = 0;
+
+  // e.g. "audio/opus;rate=16000;channels=1".
+  virtual std::string MimeType() const = 0;
+
+  // Input frames consumed by each Encode() call.
+  virtual uint32_t frame_size() const = 0;
+  // Upper bound on the bytes one Encode() call writes.
+  virtual size_t max_packet_bytes() const = 0;
+
+  // Returned by Encode() when the codec rejected the frame.
+  static constexpr size_t kEncodeFailed = static_cast<size_t>(-1);
+
+  // Encodes exactly frame_size() frames into |out|. Returns the packet
+  // size, 0 while the codec is still filling its lookahead (MP3), or
+  // kEncodeFailed.
+  virtual size_t Encode(const uint8_t* pcm, uint8_t* out) = 0;
+
+  // Writes whatever the codec still holds back (MP3's bit reservoir) once
+  // the input has ended. Returns the size, at most max_packet_bytes().
+  virtual size_t Finish(uint8_t* out) { return 0; }
+};
+
+// Creates an encoder for |format| (kInt16 or kFloat32), or returns nullptr
+// if the codec is not built in or cannot take the format, e.g. Opus at
+// rates other than 8, 12, 16, 24 or 48 kHz and MP3 at rates LAME has no
+// table for (8 to 48 kHz are fine).
+std::unique_ptr<AudioEncoder> CreateAudioEncoder(const EncoderConfig& config,
+                                                 const AudioFormat& format);
+
+// Re-frames PCM packets of any size into the encoder's frame size and
+// encodes each complete frame. Runs synchronously on the caller's thread
+// and allocates nothing after construction.
+class EncoderStage {
+ public:
+  // (data, size, frames, flags) for each output packet. |frames| is the
+  // number of PCM frames the packet covers.
+  using Output =
+      std::function<void(const uint8_t*, size_t, uint32_t, uint32_t)>;
+
+  explicit EncoderStage(std::unique_ptr<AudioEncoder> encoder);
+
+  // Appends |frames| frames. |flags| (PacketFlags) are ORed into the
+  // packet that holds the first of them. A silence marker
+  // (kPacketSilenceMarker, no data) first completes the buffered frame with
+  // zeros, then passes through covering whatever silence the padding did
+  // not use.
+  void Push(const uint8_t* pcm, uint32_t frames, uint32_t flags,
+            const Output& output);
+
+  // Emits the buffered partial frame, zero-padded, then whatever the
+  // encoder still holds back. Call when the stream ends.
+  void Flush(const Output& output);
+
+  const AudioEncoder& encoder() const { return *encoder_; }
+  // Encode() calls that failed; their frames are lost. Frames the codec
+  // holds back are counted in the next packet it produces.
+  uint64_t failures() const { return failures_; }
+
+ private:
+  // Pads the open frame with zeros and encodes it; returns the padding.
+  uint32_t EmitPadded(const Output& output);
+  void EmitFrame(const Output& output);
+
+  std::unique_ptr<AudioEncoder> encoder_;
+  uint32_t block_align_;
+  std::vector<uint8_t> frame_;   // One codec frame of PCM.
+  std::vector<uint8_t> packet_;  // max_packet_bytes().
+  uint32_t buffered_ = 0;        // Frames in |frame_|.
+  uint32_t held_ = 0;            // Encoded frames with no packet yet.
+  uint32_t flags_ = 0;           // Carried to the next packet.
+  uint64_t failures_ = 0;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_AUDIO_CODEC_H_
@@ -0,0 +1,90 @@
+#ifndef SAMURAI_AUDIO_CORE_AUDIO_FILE_WRITER_H_
+#define SAMURAI_AUDIO_CORE_AUDIO_FILE_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/audio_codec.h"
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+namespace internal {
+class OggMuxer;
+}  // namespace internal
+
+// The container each codec is written in: kPcm as WAV, kMp3 as a plain
+// MPEG audio stream and kOpus as Ogg Opus (RFC 7845).
+const char* AudioFileExtension(CodecId codec);
+
+// Streams PCM into an audio file as it arrives, encoding on the caller's
+// thread. Nothing is buffered beyond one codec frame and one Ogg page, and
+// Close() only flushes those and patches fixed-size headers, so finishing
+// a long recording costs the same as a short one. A file cut off by a
+// crash still plays up to its last complete frame or page.
+class AudioFileWriter {
+ public:
+  AudioFileWriter();
+  ~AudioFileWriter();
+
+  AudioFileWriter(const AudioFileWriter&) = delete;
+  AudioFileWriter& operator=(const AudioFileWriter&) = delete;
+
+  // Creates |path| (UTF-8) for |format|. kPcm takes any format; other
+  // codecs need CreateAudioEncoder() to accept it. Returns false if the
+  // codec is unavailable or the file cannot be created.
+  bool Open(const std::string& path, const EncoderConfig& config,
+            const AudioFormat& format);
+
+  // As above with a ready encoder, whose config().codec picks the
+  // container.
+  bool Open(const std::string& path, std::unique_ptr<AudioEncoder> encoder);
+
+  // Appends |frames| frames in format(), or that many frames of silence
+  // when |pcm| is null. Returns false once any write has failed.
+  bool Write(const uint8_t* pcm, uint32_t frames);
+
+  // Flushes, finalizes headers and closes. Returns false if anything
+  // failed since Open(). Safe to call when not open.
+  bool Close();
+
+  bool is_open() const { return open_; }
+  CodecId codec() const { return codec_; }
+  const AudioFormat& format() const { return format_; }
+  // e.g. "audio/wav", "audio/mpeg", "audio/ogg;codecs=opus".
+  std::string MimeType() const;
+
+  uint64_t frames() const { return frames_; }  // Input frames written.
+  uint64_t bytes() const { return bytes_; }    // File size so far.
+  bool failed() const { return failed_; }
+
+ private:
+  bool OpenFile(const std::string& path);
+  void WriteBytes(const uint8_t* data, size_t size);
+  // Writes the header, or patches in the final sizes when |finalize|.
+  void WriteWavHeader(bool finalize);
+  void WriteOpusHeaders();
+  int64_t OpusGranule(uint64_t frames) const;
+
+  bool open_ = false;
+  bool failed_ = false;
+  CodecId codec_ = CodecId::kPcm;
+  AudioFormat format_;
+  std::ofstream file_;
+  std::vector<char> file_buffer_;
+  std::unique_ptr<EncoderStage> stage_;
+  EncoderStage::Output on_packet_;
+  std::unique_ptr<internal::OggMuxer> ogg_;
+  std::vector<uint8_t> zeros_;  // For silence.
+  uint64_t frames_ = 0;
+  uint64_t encoded_frames_ = 0;  // Covered by packets so far.
+  uint64_t bytes_ = 0;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_AUDIO_FILE_WRITER_H_
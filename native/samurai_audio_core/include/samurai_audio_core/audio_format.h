@@ -0,0 +1,75 @@
+#ifndef SAMURAI_AUDIO_CORE_AUDIO_FORMAT_H_
+#define SAMURAI_AUDIO_CORE_AUDIO_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace samurai {
+
+// Sample encodings the capture pipeline understands.
+enum class SampleType {
+  kInt16,
+  kInt24,
+  kInt32,
+  kFloat32,
+};
+
+// Interleaved PCM format description, independent of WAVEFORMATEX.
+struct AudioFormat {
+  uint32_t sample_rate = 44100;
+  uint16_t channels = 2;
+  SampleType sample_type = SampleType::kInt16;
+
+  uint16_t BytesPerSample() const;
+  uint16_t BitsPerSample() const { return BytesPerSample() * 8; }
+  // Bytes per interleaved frame (WAVEFORMATEX::nBlockAlign).
+  uint32_t BlockAlign() const { return BytesPerSample() * channels; }
+  uint32_t BytesPerSecond() const { return BlockAlign() * sample_rate; }
+
+  bool IsValid() const;
+
+  bool operator==(const AudioFormat& other) const {
+    return sample_rate == other.sample_rate && channels == other.channels &&
+           sample_type == other.sample_type;
+  }
+  bool operator!=(const AudioFormat& other) const { return !(*this == other); }
+};
+
+// The 44.1 kHz / stereo / 16-bit format the Dart side expects by default.
+AudioFormat DefaultOutputFormat();
+
+// Number of whole frames covering |milliseconds| of audio.
+uint32_t FramesForDuration(const AudioFormat& format, uint32_t milliseconds);
+
+// Duration of |frames| frames in microseconds.
+uint64_t DurationForFrames(const AudioFormat& format, uint64_t frames);
+
+// Duration of |frames| frames in nanoseconds, rounded down.
+int64_t NanosForFrames(const AudioFormat& format, uint64_t frames);
+
+// Where a run of frames sits on its stream's timeline.
+struct MediaTimestamp {
+  // Frames of the stream's format before this one since capture started.
+  // Frames the device lost, the ring dropped or silence suppression
+  // removed still count, so positions keep pace with the device clock and
+  // two streams can be lined up sample for sample.
+  uint64_t position = 0;
+  // Host time (CaptureClock epoch: QPC on Windows, CLOCK_MONOTONIC on
+  // Linux) at which the first frame was captured.
+  int64_t time_ns = 0;
+};
+
+// |timestamp| moved |frames| frames of |format| later.
+MediaTimestamp AdvanceTimestamp(const AudioFormat& format,
+                                const MediaTimestamp& timestamp,
+                                uint64_t frames);
+
+// e.g. "audio/pcm;rate=44100;channels=2;bitdepth=16".
+std::string PcmMimeType(const AudioFormat& format);
+
+const char* SampleTypeName(SampleType type);
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_AUDIO_FORMAT_H_
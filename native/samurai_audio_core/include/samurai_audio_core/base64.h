@@ -0,0 +1,48 @@
+#ifndef SAMURAI_AUDIO_CORE_BASE64_H_
+#define SAMURAI_AUDIO_CORE_BASE64_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace samurai {
+
+// Encoder implementations. Base64Encode picks the fastest one the CPU
+// supports; all of them produce identical output.
+enum class Base64Impl {
+  kScalar,
+  kSsse3,
+  kAvx2,
+  kNeon,
+};
+
+const char* Base64ImplName(Base64Impl impl);
+bool Base64ImplSupported(Base64Impl impl);
+Base64Impl Base64BestImpl();
+
+// Length of the padded base64 encoding of |size| bytes.
+inline size_t Base64EncodedSize(size_t size) { return ((size + 2) / 3) * 4; }
+
+// Standard (RFC 4648, padded) base64 encoding of |data| into |out|,
+// replacing its contents.
+void Base64Encode(const uint8_t* data, size_t size, std::string* out);
+
+std::string Base64Encode(const uint8_t* data, size_t size);
+
+// Encodes into |out|, which must hold Base64EncodedSize(size) chars.
+// Returns false if |impl| is not supported on this CPU.
+bool Base64EncodeWith(Base64Impl impl, const uint8_t* data, size_t size,
+                      char* out);
+
+// Strict decoder: rejects characters outside the alphabet, missing padding
+// and data after padding.
+bool Base64Decode(const char* text, size_t size, std::vector<uint8_t>* out);
+
+inline bool Base64Decode(const std::string& text, std::vector<uint8_t>* out) {
+  return Base64Decode(text.data(), text.size(), out);
+}
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_BASE64_H_
@@ -0,0 +1,144 @@
+#ifndef SAMURAI_AUDIO_CORE_CAPTURE_BACKEND_H_
+#define SAMURAI_AUDIO_CORE_CAPTURE_BACKEND_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+struct AudioDevice {
+  std::string id;
+  std::string name;
+  bool isInput;
+};
+
+// The two capture streams the app runs side by side.
+enum class StreamKind {
+  kSystem,      // Loopback of the render endpoint (customer).
+  kMicrophone,  // Capture endpoint (agent).
+  // Both of the above time-aligned into one stereo stream by
+  // StreamAligner: customer left, agent right. Never captured itself.
+  kAligned,
+};
+
+// Kinds that are captured, i.e. all but kAligned.
+constexpr int kStreamKindCount = 2;
+
+// True for kinds below kStreamKindCount, which index per-stream arrays.
+constexpr bool IsCapturedStream(StreamKind kind) {
+  return static_cast<int>(kind) >= 0 &&
+         static_cast<int>(kind) < kStreamKindCount;
+}
+
+// "system" / "microphone" / "aligned", as used on the platform channel.
+const char* StreamKindName(StreamKind kind);
+
+// Packet flags reported by the device, plus the ones the capture engine
+// adds on the way to consumers.
+enum PacketFlags : uint32_t {
+  kPacketSilent = 1u << 0,         // AUDCLNT_BUFFERFLAGS_SILENT
+  kPacketDiscontinuity = 1u << 1,  // AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY
+  // The voice activity detector found no speech in the packet.
+  kPacketNoSpeech = 1u << 2,
+  // Stands in for |frames| frames of silence; the packet has no samples.
+  kPacketSilenceMarker = 1u << 3,
+};
+
+// How the capture thread learns that the device has data.
+enum class SchedulingMode {
+  // Block on the device's buffer-ready event (AUDCLNT_STREAMFLAGS_
+  // EVENTCALLBACK). Wakes once per device period with minimal latency.
+  kEventDriven,
+  // Sleep one device period between polls. Fewer wakeups when the period
+  // is longer than the engine's, at the cost of up to a period of latency.
+  kTimer,
+};
+
+// What the engine asks of a device stream.
+struct StreamConfig {
+  // Requested format; a hint for capture endpoints, ignored for loopback.
+  AudioFormat format;
+  SchedulingMode scheduling = SchedulingMode::kEventDriven;
+  // Device period / poll interval. 0 uses the device default.
+  uint32_t device_period_ms = 10;
+  // Device-side buffer (WASAPI hnsBufferDuration). Longer buffers survive
+  // longer capture-thread stalls without losing data.
+  uint32_t buffer_duration_ms = 1000;
+  // Ask the OS to schedule the capture thread as pro audio (MMCSS).
+  bool high_priority = false;
+};
+
+// A packet borrowed from the device. |data| stays valid until the matching
+// CaptureStream::ReleasePacket call.
+struct CapturedPacket {
+  const uint8_t* data = nullptr;
+  uint32_t frames = 0;
+  uint32_t flags = 0;
+  // Host time (CaptureClock epoch) at which the first frame was captured,
+  // or 0 if the device did not report one.
+  int64_t capture_time_ns = 0;
+  // Device frames captured before the first frame since Start(), as
+  // IAudioCaptureClient::GetBuffer's u64DevicePosition. A jump past the
+  // end of the previous packet means the device lost frames.
+  uint64_t device_position = 0;
+};
+
+// An opened device stream. The contract mirrors IAudioCaptureClient so the
+// WASAPI backend is a thin adapter; all calls happen on the capture thread.
+class CaptureStream {
+ public:
+  virtual ~CaptureStream() = default;
+
+  // Format of the packets returned by GetPacket.
+  virtual const AudioFormat& format() const = 0;
+
+  virtual bool Start() = 0;
+  virtual void Stop() = 0;
+
+  // Frames in the next queued packet, 0 when nothing is queued.
+  virtual bool GetNextPacketSize(uint32_t* frames) = 0;
+
+  // Borrows the next packet. Must be followed by ReleasePacket.
+  virtual bool GetPacket(CapturedPacket* packet) = 0;
+  virtual void ReleasePacket(uint32_t frames) = 0;
+
+  // True if WaitForData blocks on a device event. Otherwise the engine
+  // sleeps one device period between polls.
+  virtual bool event_driven() const { return false; }
+
+  // Blocks until the device signals data or |timeout_ns| elapses. Returns
+  // false on timeout. Only called when event_driven().
+  virtual bool WaitForData(int64_t timeout_ns) { return false; }
+
+  // Device period and buffer the stream actually runs with.
+  virtual uint32_t device_period_ms() const { return 10; }
+  virtual uint32_t buffer_duration_ms() const { return 0; }
+};
+
+// Platform audio API: device enumeration and stream creation.
+class CaptureBackend {
+ public:
+  virtual ~CaptureBackend() = default;
+
+  virtual bool Initialize() = 0;
+
+  virtual std::vector<AudioDevice> GetInputDevices() = 0;
+  virtual std::vector<AudioDevice> GetOutputDevices() = 0;
+
+  // Opens |device_id| (empty for the default endpoint) for |kind|. System
+  // streams are loopback captures of a render endpoint. The stream reports
+  // the format it actually negotiated; backends that cannot honour
+  // kEventDriven fall back to timer scheduling. Called on the capture
+  // thread. Returns nullptr on failure.
+  virtual std::unique_ptr<CaptureStream> OpenStream(
+      StreamKind kind, const std::string& device_id,
+      const StreamConfig& config) = 0;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CAPTURE_BACKEND_H_
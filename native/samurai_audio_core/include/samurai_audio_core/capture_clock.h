@@ -0,0 +1,60 @@
+#ifndef SAMURAI_AUDIO_CORE_CAPTURE_CLOCK_H_
+#define SAMURAI_AUDIO_CORE_CAPTURE_CLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace samurai {
+
+// Time source and sleep primitive for capture scheduling. The engine and
+// the synthetic backend do all of their waiting through this interface, so
+// a simulated clock can drive them deterministically.
+class CaptureClock {
+ public:
+  virtual ~CaptureClock() = default;
+
+  // Monotonic nanoseconds. The real clock shares its epoch with the QPC /
+  // CLOCK_MONOTONIC timestamps devices report.
+  virtual int64_t NowNanos() = 0;
+
+  virtual void SleepFor(int64_t nanos) = 0;
+
+  void SleepUntil(int64_t deadline_nanos) {
+    int64_t now = NowNanos();
+    if (deadline_nanos > now) {
+      SleepFor(deadline_nanos - now);
+    }
+  }
+};
+
+// std::chrono::steady_clock (QPC on Windows, CLOCK_MONOTONIC on Linux).
+class SteadyCaptureClock : public CaptureClock {
+ public:
+  int64_t NowNanos() override;
+  void SleepFor(int64_t nanos) override;
+
+  // Process-wide instance used when no clock is injected.
+  static SteadyCaptureClock* Get();
+};
+
+// Virtual time that only moves when someone sleeps. Sleeping returns
+// immediately after advancing the clock, so hours of capture scheduling run
+// in milliseconds and every wakeup happens at an exact, repeatable time.
+class SimulatedCaptureClock : public CaptureClock {
+ public:
+  explicit SimulatedCaptureClock(int64_t start_nanos = 0) : now_(start_nanos) {}
+
+  int64_t NowNanos() override { return now_.load(); }
+  void SleepFor(int64_t nanos) override;
+
+  // Total number of SleepFor calls, i.e. thread wakeups.
+  uint64_t sleeps() const { return sleeps_.load(); }
+
+ private:
+  std::atomic<int64_t> now_;
+  std::atomic<uint64_t> sleeps_{0};
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CAPTURE_CLOCK_H_
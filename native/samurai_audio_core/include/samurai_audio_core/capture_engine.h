@@ -0,0 +1,305 @@
+#ifndef SAMURAI_AUDIO_CORE_CAPTURE_ENGINE_H_
+#define SAMURAI_AUDIO_CORE_CAPTURE_ENGINE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/audio_codec.h"
+#include "samurai_audio_core/audio_format.h"
+#include "samurai_audio_core/capture_backend.h"
+#include "samurai_audio_core/capture_clock.h"
+#include "samurai_audio_core/channel_mixer.h"
+#include "samurai_audio_core/frame_pool.h"
+#include "samurai_audio_core/recording_sink.h"
+#include "samurai_audio_core/resampler.h"
+#include "samurai_audio_core/voice_activity.h"
+
+namespace samurai {
+
+// A packet handed to consumers. |data| is only valid during the callback,
+// unless the consumer keeps a copy of |buffer|.
+struct AudioPacket {
+  StreamKind stream = StreamKind::kSystem;
+  // kPcm: interleaved samples in |format|. Otherwise one encoded frame
+  // covering |frames| frames of |format|.
+  CodecId codec = CodecId::kPcm;
+  const uint8_t* data = nullptr;
+  size_t size = 0;  // Bytes; 0 for kPacketSilenceMarker.
+  // The pooled buffer holding |data|, when there is one. Copying the
+  // FrameRef keeps the bytes alive and unchanged without copying them or
+  // allocating; the capture engine sets it for every packet with samples
+  // unless consumers hold on to more than StreamInfo::queue_slots of them.
+  const FrameRef* buffer = nullptr;
+  uint32_t frames = 0;
+  uint32_t flags = 0;  // PacketFlags.
+  // Per-stream delivery counter, starting at 0 on every Start(). Gaps never
+  // occur; overruns are reported through CaptureStats instead.
+  uint64_t sequence = 0;
+  // Where the first frame sits on the stream timeline (MediaTimestamp).
+  // Both come from the device's own position and QPC / CLOCK_MONOTONIC
+  // stamp, so they stay sample-accurate through conversion, re-framing
+  // and encoding. Only when a device reports no time is it estimated from
+  // the clock as the packet is read.
+  uint64_t position = 0;
+  int64_t capture_time_ns = 0;
+  AudioFormat format;
+};
+
+using AudioPacketCallback = std::function<void(const AudioPacket&)>;
+
+// Counters for one stream since its last Start().
+struct CaptureStats {
+  uint64_t packets_captured = 0;
+  uint64_t packets_delivered = 0;  // Ring slots handed to the callback.
+  uint64_t overruns = 0;           // Device packets dropped on a full ring.
+  uint64_t dropped_frames = 0;    // In device frames.
+  // How long the capture thread held each device packet, from GetPacket
+  // to ReleasePacket. Conversion and VAD run after the release and are
+  // not included.
+  uint64_t max_capture_ns = 0;
+  uint64_t total_capture_ns = 0;
+  // Capture thread wakeups, and how many of them found no data.
+  uint64_t wakeups = 0;
+  uint64_t idle_wakeups = 0;
+  // Time from a packet's last frame being captured to it entering the ring,
+  // over packets whose device reported a capture time.
+  uint64_t max_latency_ns = 0;
+  uint64_t total_latency_ns = 0;
+  uint64_t latency_samples = 0;
+  // Device packets the VAD classified as not speech, and how many of
+  // their delivered-format frames were dropped or folded into markers.
+  uint64_t silent_packets = 0;
+  uint64_t suppressed_frames = 0;
+  // Short frames the re-framer delivered because the device stalled past
+  // CaptureSettings::frame_flush_ms.
+  uint64_t frame_timeouts = 0;
+  // Device clock against the host clock, from the positions and times the
+  // device stamps on its packets: the fitted rate error, and how far the
+  // device timeline has drifted since Start(). 0 until the device has
+  // reported times for a couple of seconds.
+  double drift_ppm = 0.0;
+  double drift_ms = 0.0;
+  // With CaptureSettings::compensate_drift: delivered frames inserted
+  // (positive) or removed to keep the stream on the host clock.
+  int64_t drift_corrected_frames = 0;
+  // Codec frames handed to the callback, and frames the codec rejected.
+  uint64_t encoded_packets = 0;
+  uint64_t encoder_failures = 0;
+  // CaptureSettings::recording: frames and bytes on disk so far, and
+  // whether a write failed. Final once Stop() returns.
+  uint64_t recorded_frames = 0;
+  uint64_t recording_bytes = 0;
+  bool recording_failed = false;
+};
+
+// Everything that can be tuned per stream on Start().
+struct CaptureSettings {
+  // stream.format's sample type and rate are also what gets delivered:
+  // device packets are converted (to kInt16 or kFloat32) and resampled on
+  // the capture thread. The delivered channel layout comes from
+  // |channel_map| instead of stream.format.channels.
+  StreamConfig stream;
+  ChannelMap channel_map;
+  // TPDF dither when narrowing to int16.
+  bool dither = true;
+  ResamplerQuality resampler_quality = ResamplerQuality::kMedium;
+  // Delivery queue: |ring_slots| slots of up to |slot_duration_ms| each.
+  // Packets reach the callback at most one slot at a time.
+  uint32_t ring_slots = 64;
+  uint32_t slot_duration_ms = 20;
+  // Voice activity detection on the delivered format. Off by default:
+  // every packet is delivered untagged.
+  bool vad = false;
+  VadConfig vad_config;
+  SilencePolicy silence_policy = SilencePolicy::kForward;
+  // Longest silence one kMarkers marker stands for, so consumers hear
+  // about long pauses while they last.
+  uint32_t silence_marker_ms = 1000;
+  // Re-blocks delivered PCM into frames of exactly |frame_ms| (Reframer);
+  // a partial frame is delivered short after |frame_flush_ms|. 0 delivers
+  // ring slots as the device filled them. Encoded streams are always
+  // framed by the codec instead.
+  uint32_t frame_ms = 0;
+  uint32_t frame_flush_ms = 100;
+  // Trims the resampling ratio so delivered positions advance at exactly
+  // the delivered rate of host time, whatever the device crystal does.
+  // Streams from different devices then stay on one timeline.
+  bool compensate_drift = false;
+  // Codec applied on the delivery thread. Falls back to kPcm when the
+  // codec is not built in or cannot take the delivered format.
+  EncoderConfig encoder;
+  // Records the delivered stream to disk on the delivery thread, finished
+  // when Stop() returns. Unlike |encoder| there is no fallback: Start()
+  // fails if the file cannot be created with the requested codec.
+  RecordingConfig recording;
+};
+
+// What a running stream actually negotiated.
+struct StreamInfo {
+  AudioFormat device_format;  // As negotiated with the device.
+  AudioFormat format;         // As delivered to the callback.
+  // kPassthrough when the requested map did not fit the device.
+  ChannelMode channel_mode = ChannelMode::kPassthrough;
+  SchedulingMode scheduling = SchedulingMode::kEventDriven;
+  uint32_t device_period_ms = 0;
+  uint32_t buffer_duration_ms = 0;
+  uint32_t delivery_frames = 0;  // Frames per ring slot.
+  // Frames per delivered PCM packet when CaptureSettings::frame_ms
+  // re-blocks them; 0 otherwise.
+  uint32_t frame_frames = 0;
+  uint32_t queue_slots = 0;
+  // Worst-case time from a frame being captured to it reaching the
+  // delivery queue: one device period, plus one more when polling, plus
+  // the resampler lookahead, plus one codec frame when encoding.
+  uint32_t expected_latency_ms = 0;
+  // How long the queue absorbs a stalled consumer before overrunning.
+  uint32_t queue_duration_ms = 0;
+  // Codec actually running, and the matching mime type.
+  EncoderConfig encoder;
+  std::string mime_type;
+  // Of the recording file; empty when not recording.
+  std::string recording_mime_type;
+};
+
+// Runs one capture thread per StreamKind on top of a CaptureBackend. The
+// capture thread holds a device packet only long enough to copy it out,
+// then releases it before converting the copy (format, rate, channels,
+// drift trim) and queueing it in a PcmFrameRing; a separate delivery
+// thread per stream drains the ring and invokes the callback, so a slow
+// consumer costs overruns instead of stalling the device. With
+// CaptureSettings::vad the capture thread also classifies each converted
+// packet and applies the stream's SilencePolicy before queueing it.
+//
+// The capture thread sleeps on the device's buffer-ready event when the
+// stream supports it, and otherwise polls once per device period. Either
+// way all waiting goes through Options::clock.
+class CaptureEngine {
+ public:
+  struct Options {
+    // Used by the Start overload without settings.
+    CaptureSettings settings;
+    // Time source for timer scheduling and latency stats; defaults to the
+    // steady clock.
+    CaptureClock* clock = nullptr;
+    // Creates the encoders for CaptureSettings::encoder; defaults to
+    // CreateAudioEncoder.
+    std::function<std::unique_ptr<AudioEncoder>(const EncoderConfig&,
+                                                const AudioFormat&)>
+        encoder_factory;
+
+    Options();
+  };
+
+  explicit CaptureEngine(std::unique_ptr<CaptureBackend> backend);
+  CaptureEngine(std::unique_ptr<CaptureBackend> backend, const Options& options);
+  ~CaptureEngine();
+
+  CaptureEngine(const CaptureEngine&) = delete;
+  CaptureEngine& operator=(const CaptureEngine&) = delete;
+
+  bool Initialize();
+
+  std::vector<AudioDevice> GetInputDevices();
+  std::vector<AudioDevice> GetOutputDevices();
+
+  // Starts capturing |kind| from |device_id| (empty for the default device).
+  // Blocks until the device is open. Returns false if the stream is already
+  // running or the device could not be opened.
+  //
+  // Kinds that are not captured (kAligned) are refused everywhere: Start()
+  // and GetStreamInfo() return false, IsCapturing() false, GetStats() zeros
+  // and Stop() does nothing.
+  bool Start(StreamKind kind, const std::string& device_id,
+             AudioPacketCallback callback);
+  bool Start(StreamKind kind, const std::string& device_id,
+             const CaptureSettings& settings, AudioPacketCallback callback);
+  void Stop(StreamKind kind);
+  void StopAll();
+
+  bool IsCapturing(StreamKind kind) const;
+
+  CaptureStats GetStats(StreamKind kind) const;
+
+  // Negotiated parameters of the last successful Start() of |kind|. Returns
+  // false if the stream was never started.
+  bool GetStreamInfo(StreamKind kind, StreamInfo* info) const;
+
+  CaptureBackend* backend() const { return backend_.get(); }
+
+ private:
+  struct StreamState {
+    std::thread thread;
+    std::atomic<bool> capturing{false};
+
+    // Wakes the delivery thread. The producer takes the mutex only when the
+    // consumer has announced it is about to sleep, so an idle stream costs
+    // no timer wakeups and a busy one no locking.
+    std::mutex delivery_mutex;
+    std::condition_variable delivery_cv;
+    std::atomic<bool> consumer_waiting{false};
+
+    std::atomic<uint64_t> packets_captured{0};
+    std::atomic<uint64_t> packets_delivered{0};
+    std::atomic<uint64_t> overruns{0};
+    std::atomic<uint64_t> dropped_frames{0};
+    std::atomic<uint64_t> max_capture_ns{0};
+    std::atomic<uint64_t> total_capture_ns{0};
+    std::atomic<uint64_t> wakeups{0};
+    std::atomic<uint64_t> idle_wakeups{0};
+    std::atomic<uint64_t> max_latency_ns{0};
+    std::atomic<uint64_t> total_latency_ns{0};
+    std::atomic<uint64_t> latency_samples{0};
+    std::atomic<uint64_t> silent_packets{0};
+    std::atomic<uint64_t> suppressed_frames{0};
+    std::atomic<uint64_t> frame_timeouts{0};
+    std::atomic<double> drift_ppm{0.0};
+    std::atomic<double> drift_ms{0.0};
+    std::atomic<int64_t> drift_corrected_frames{0};
+    std::atomic<uint64_t> encoded_packets{0};
+    std::atomic<uint64_t> encoder_failures{0};
+    std::atomic<uint64_t> recorded_frames{0};
+    std::atomic<uint64_t> recording_bytes{0};
+    std::atomic<bool> recording_failed{false};
+
+    // Written by the capture thread before Start() returns; read under the
+    // engine mutex.
+    bool has_info = false;
+    StreamInfo info;
+
+    void ResetStats();
+  };
+
+  void CaptureThread(StreamKind kind, std::string device_id,
+                     CaptureSettings settings, AudioPacketCallback callback,
+                     StreamState* state, std::promise<bool>* opened);
+
+  // |kind| must be IsCapturedStream(); the public entry points check.
+  StreamState& state(StreamKind kind) {
+    return streams_[static_cast<int>(kind)];
+  }
+  const StreamState& state(StreamKind kind) const {
+    return streams_[static_cast<int>(kind)];
+  }
+
+  std::unique_ptr<CaptureBackend> backend_;
+  Options options_;
+  CaptureClock* clock_;
+  // Serialises Start() and Stop(); never taken by the getters, so a
+  // callback may use them while Stop() joins its thread.
+  std::mutex control_mutex_;
+  mutable std::mutex mutex_;
+  StreamState streams_[kStreamKindCount];
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CAPTURE_ENGINE_H_
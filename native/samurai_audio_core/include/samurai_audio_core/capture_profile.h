@@ -0,0 +1,37 @@
+#ifndef SAMURAI_AUDIO_CORE_CAPTURE_PROFILE_H_
+#define SAMURAI_AUDIO_CORE_CAPTURE_PROFILE_H_
+
+#include <string>
+
+#include "samurai_audio_core/capture_engine.h"
+
+namespace samurai {
+
+// Named latency / robustness trade-offs for a capture stream.
+enum class CaptureProfile {
+  // Live assist: 10 ms event-driven period, short device buffer and queue,
+  // MMCSS priority. Consumer stalls beyond ~160 ms drop audio.
+  kRealtime,
+  // Default: event-driven at the engine period with a few hundred ms of
+  // slack on the device and a ~1 s delivery queue.
+  kBalanced,
+  // Batch recording: polls every 100 ms into a 1 s device buffer and a
+  // ~25 s delivery queue. Few wakeups, survives long consumer stalls, and
+  // resamples at the highest quality.
+  kBulk,
+};
+
+// "realtime" / "balanced" / "bulk", as used on the platform channel.
+const char* CaptureProfileName(CaptureProfile profile);
+
+// Parses a profile name. Returns false (leaving |profile| alone) for
+// unknown names.
+bool ParseCaptureProfile(const std::string& name, CaptureProfile* profile);
+
+// Engine settings for |profile| with |format| as the requested format.
+CaptureSettings CaptureSettingsForProfile(CaptureProfile profile,
+                                          const AudioFormat& format);
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CAPTURE_PROFILE_H_
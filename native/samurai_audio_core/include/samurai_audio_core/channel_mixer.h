@@ -0,0 +1,87 @@
+#ifndef SAMURAI_AUDIO_CORE_CHANNEL_MIXER_H_
+#define SAMURAI_AUDIO_CORE_CHANNEL_MIXER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace samurai {
+
+enum class ChannelMode {
+  kPassthrough,  // Keep the device layout.
+  kDownmix,      // Average all channels to mono.
+  kSelect,       // Keep one channel as mono.
+  kMatrix,       // Arbitrary N -> M gains.
+};
+
+// "passthrough" / "downmix" / "select" / "matrix", as used on the platform
+// channel.
+const char* ChannelModeName(ChannelMode mode);
+
+// Parses a mode name. Returns false (leaving |mode| alone) for unknown
+// names.
+bool ParseChannelMode(const std::string& name, ChannelMode* mode);
+
+// Requested channel layout for a stream.
+struct ChannelMap {
+  ChannelMode mode = ChannelMode::kPassthrough;
+  // kSelect: the input channel to keep.
+  uint16_t channel = 0;
+  // kMatrix: |output_channels| rows of one gain per input channel,
+  // row-major, so out[m] = sum_n matrix[m * inputs + n] * in[n].
+  uint16_t output_channels = 0;
+  std::vector<float> matrix;
+
+  static ChannelMap Downmix();
+  static ChannelMap Select(uint16_t channel);
+  static ChannelMap Matrix(uint16_t output_channels, std::vector<float> gains);
+};
+
+// Stereo -> mono kernels; every implementation matches scalar to within
+// float rounding.
+enum class ChannelMixImpl {
+  kScalar,
+  kSse2,
+  kAvx2,
+  kNeon,
+};
+
+const char* ChannelMixImplName(ChannelMixImpl impl);
+bool ChannelMixImplSupported(ChannelMixImpl impl);
+ChannelMixImpl ChannelMixBestImpl();
+
+// Applies a ChannelMap to interleaved float frames. Two-input, one-output
+// maps (downmix or any 2 -> 1 matrix of a stereo device) run on the SIMD
+// kernels; channel selection is a strided copy and other matrices run a
+// scalar loop.
+class ChannelMixer {
+ public:
+  ChannelMixer(uint16_t input_channels, const ChannelMap& map);
+  ChannelMixer(uint16_t input_channels, const ChannelMap& map,
+               ChannelMixImpl impl);
+
+  // False if |map| does not fit |input_channels| (a selected channel out of
+  // range, a matrix of the wrong size) or |impl| is unavailable.
+  bool IsValid() const { return valid_; }
+
+  uint16_t input_channels() const { return input_channels_; }
+  uint16_t output_channels() const { return output_channels_; }
+
+  // Mixes |frames| frames from |in| to |out|, which holds
+  // frames * output_channels() floats and must not overlap |in|.
+  void Process(const float* in, size_t frames, float* out) const;
+
+ private:
+  uint16_t input_channels_;
+  uint16_t output_channels_ = 0;
+  ChannelMixImpl impl_;
+  bool valid_ = false;
+  // Input channel copied by a select map; -1 otherwise.
+  int select_ = -1;
+  std::vector<float> gains_;  // output_channels_ x input_channels_.
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CHANNEL_MIXER_H_
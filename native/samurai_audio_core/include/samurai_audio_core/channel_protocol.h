@@ -0,0 +1,100 @@
+#ifndef SAMURAI_AUDIO_CORE_CHANNEL_PROTOCOL_H_
+#define SAMURAI_AUDIO_CORE_CHANNEL_PROTOCOL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/capture_backend.h"
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/capture_profile.h"
+#include "samurai_audio_core/channel_value.h"
+#include "samurai_audio_core/packet_fan_out.h"
+#include "samurai_audio_core/transcode_jobs.h"
+#include "samurai_audio_core/websocket_sink.h"
+
+// The "com.samurai.audio_capture" protocol the Windows and Linux runners
+// share: the arguments of Dart's calls parsed and validated into core
+// settings, and the maps that go back. The runners convert ChannelValue to
+// and from their embedder's values and send from the platform thread.
+
+namespace samurai {
+
+// The outcome of parsing a call: ok, or the code and message of the
+// PlatformException Dart sees.
+struct ChannelResult {
+  std::string code;  // Empty on success.
+  std::string message;
+
+  bool ok() const { return code.empty(); }
+  static ChannelResult Ok() { return ChannelResult(); }
+  static ChannelResult Error(std::string code, std::string message);
+  // "INVALID_ARGUMENT".
+  static ChannelResult Invalid(std::string message);
+};
+
+// How a capture's packets leave the runner: the "delivery" and "mirror"
+// arguments of a start or of setDelivery.
+struct CaptureDelivery {
+  bool binary = false;  // Raw bytes on the pcm EventChannel.
+  bool native = false;  // To the native WebSocket sink.
+};
+
+// startSystemAudioCapture / startMicrophoneCapture.
+struct CaptureRequest {
+  std::string device_id;
+  CaptureProfile profile = CaptureProfile::kBalanced;
+  CaptureSettings settings;
+  CaptureDelivery delivery;
+};
+
+// startNativeStreaming.
+struct NativeStreamingRequest {
+  WebSocketSinkConfig sink;
+  // For the sink's fan-out queue, which has the sink's bounds.
+  BackpressurePolicy policy = BackpressurePolicy::kDropOldest;
+};
+
+// Base64 strings through onAudioData unless "binary" or "native"; a
+// native capture may still feed Dart with "mirror", e.g. to record it.
+CaptureDelivery ParseCaptureDelivery(const ChannelValue& args);
+
+// The "type" argument: "microphone", or the system stream by default.
+StreamKind ParseStreamType(const ChannelValue& args);
+
+// Starts from the profile's settings at the requested rate and applies the
+// optional resampler, channel map, silence policy, codec, recording, frame
+// and drift arguments. Whether they fit the device is checked on start.
+ChannelResult ParseCaptureRequest(const ChannelValue& args,
+                                  CaptureRequest* request);
+
+// Refuses URLs the native client cannot serve, and a bearer token bound
+// for anything but a loopback host, as ws:// has no TLS.
+ChannelResult ParseNativeStreamingRequest(const ChannelValue& args,
+                                          NativeStreamingRequest* request);
+
+// convertToMp3: wavPath to mp3Path at 192 kbit/s. "INVALID_ARGS" when
+// either is missing.
+ChannelResult ParseConvertRequest(const ChannelValue& args,
+                                  TranscodeRequest* request);
+// convertBatch: equal-length inputs / outputs, one codec and bitrate;
+// "INVALID_ARGS" otherwise.
+ChannelResult ParseConvertBatchRequest(const ChannelValue& args,
+                                       std::vector<TranscodeRequest>* requests);
+
+ChannelValue DeviceListValue(const std::vector<AudioDevice>& devices);
+// The negotiated settings a start answers with.
+ChannelValue StreamInfoValue(CaptureProfile profile, const StreamInfo& info);
+ChannelValue CaptureStatsValue(const CaptureStats& stats);
+// One entry of getSinkStats.
+ChannelValue SinkQueueValue(BackpressurePolicy policy,
+                            const FanOutSinkStats& stats);
+// The convertBatch reply.
+ChannelValue BatchValue(uint64_t batch, const std::vector<uint64_t>& jobs);
+// Events of the jobs and stream EventChannels.
+ChannelValue JobEventValue(const JobEvent& event);
+ChannelValue StreamEventValue(const WebSocketSinkEvent& event);
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CHANNEL_PROTOCOL_H_
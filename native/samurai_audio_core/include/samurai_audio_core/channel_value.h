@@ -0,0 +1,73 @@
+#ifndef SAMURAI_AUDIO_CORE_CHANNEL_VALUE_H_
+#define SAMURAI_AUDIO_CORE_CHANNEL_VALUE_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samurai {
+
+// A value of Flutter's standard method codec, as far as the runners' method
+// and event channels use it, without the embedder's types. Each runner
+// converts its flutter::EncodableValue or FlValue to and from it; the
+// protocol itself lives in channel_protocol.h. Maps have string keys and
+// keep their insertion order.
+class ChannelValue {
+ public:
+  enum class Type { kNull, kBool, kInt, kDouble, kString, kDoubleList,
+                    kList, kMap };
+  using List = std::vector<ChannelValue>;
+  using Map = std::vector<std::pair<std::string, ChannelValue>>;
+
+  ChannelValue() = default;  // Null.
+
+  static ChannelValue Bool(bool value);
+  static ChannelValue Int(int64_t value);
+  static ChannelValue Double(double value);
+  static ChannelValue String(std::string value);
+  // Float32List and Float64List alike.
+  static ChannelValue DoubleList(std::vector<double> values);
+  static ChannelValue EmptyList();
+  static ChannelValue EmptyMap();
+
+  Type type() const { return type_; }
+  bool is_null() const { return type_ == Type::kNull; }
+
+  // Each only meaningful for its type.
+  bool bool_value() const { return bool_; }
+  int64_t int_value() const { return int_; }
+  double double_value() const { return double_; }
+  const std::string& string_value() const { return string_; }
+  const std::vector<double>& double_list() const { return double_list_; }
+  const List& list() const { return list_; }
+  const Map& map() const { return map_; }
+
+  // Appends to a list; a null value becomes one.
+  void Append(ChannelValue value);
+  // Adds or replaces the map entry |key|; a null value becomes a map.
+  void Set(const std::string& key, ChannelValue value);
+
+  // The map entry |key|; null if missing or this is not a map.
+  const ChannelValue* Find(const char* key) const;
+  // The map entry |key|, or |fallback| when it is missing or of another
+  // type (e.g. a null deviceId).
+  std::string GetString(const char* key,
+                        const std::string& fallback = std::string()) const;
+  int64_t GetInt(const char* key, int64_t fallback) const;
+  bool GetBool(const char* key, bool fallback) const;
+
+ private:
+  Type type_ = Type::kNull;
+  bool bool_ = false;
+  int64_t int_ = 0;
+  double double_ = 0.0;
+  std::string string_;
+  std::vector<double> double_list_;
+  List list_;
+  Map map_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CHANNEL_VALUE_H_
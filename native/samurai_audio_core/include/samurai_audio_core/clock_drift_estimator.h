@@ -0,0 +1,74 @@
+#ifndef SAMURAI_AUDIO_CORE_CLOCK_DRIFT_ESTIMATOR_H_
+#define SAMURAI_AUDIO_CORE_CLOCK_DRIFT_ESTIMATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace samurai {
+
+struct DriftEstimatorConfig {
+  // The rate is fitted over observations from the last |window_ms|, taken
+  // at most every |interval_ms|.
+  uint32_t window_ms = 10000;
+  uint32_t interval_ms = 100;
+  // Observations must span this long before the fit is trusted.
+  uint32_t min_span_ms = 2000;
+};
+
+// Measures how fast a device clock runs against the host clock. Render and
+// capture endpoints each run off their own crystal, so a device's frame
+// position and the host time stamped on its packets (QPC /
+// CLOCK_MONOTONIC) drift apart by tens of ppm. A least-squares line
+// through recent (time, position) pairs gives the device's true rate
+// without following per-packet timestamp jitter. Not thread-safe;
+// allocates nothing after construction.
+class ClockDriftEstimator {
+ public:
+  ClockDriftEstimator(uint32_t nominal_rate,
+                      const DriftEstimatorConfig& config);
+
+  // Adds the device |position| (frames, gaps included) captured at host
+  // |time_ns|. Either moving backwards, e.g. after a device reset, restarts
+  // the estimate.
+  void Update(uint64_t position, int64_t time_ns);
+
+  void Reset();
+
+  // Whether ratio() comes from a long enough fit.
+  bool locked() const { return locked_; }
+
+  // Device frames per host second over the nominal rate; 1 until locked.
+  double ratio() const { return ratio_; }
+  double ppm() const { return (ratio_ - 1.0) * 1e6; }
+
+  // How far the device timeline has run ahead of host time (negative:
+  // fallen behind) between the first and the latest observation.
+  double drift_ns() const;
+
+ private:
+  struct Point {
+    double seconds;  // Host time since the first observation.
+    double frames;   // Device position since the first observation.
+  };
+
+  void Fit();
+
+  double nominal_rate_;
+  DriftEstimatorConfig config_;
+  std::vector<Point> points_;  // Circular, oldest at |head_|.
+  size_t head_ = 0;
+  size_t count_ = 0;
+
+  bool started_ = false;
+  uint64_t first_position_ = 0;
+  int64_t first_time_ns_ = 0;
+  uint64_t last_position_ = 0;
+  int64_t last_time_ns_ = 0;
+  bool locked_ = false;
+  double ratio_ = 1.0;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CLOCK_DRIFT_ESTIMATOR_H_
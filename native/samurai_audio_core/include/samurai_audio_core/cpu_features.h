@@ -0,0 +1,39 @@
+#ifndef SAMURAI_AUDIO_CORE_CPU_FEATURES_H_
+#define SAMURAI_AUDIO_CORE_CPU_FEATURES_H_
+
+// Runtime CPU feature detection for the SIMD kernels. Kernels are compiled
+// for their instruction set with SAMURAI_TARGET (no global -m flags), and
+// callers pick one at runtime from GetCpuFeatures().
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define SAMURAI_ARCH_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SAMURAI_ARCH_ARM64 1
+#endif
+
+#if defined(SAMURAI_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SAMURAI_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SAMURAI_TARGET(isa)
+#endif
+
+namespace samurai {
+
+struct CpuFeatures {
+  bool sse2 = false;
+  bool ssse3 = false;
+  bool sse41 = false;
+  bool avx2 = false;  // Also requires OS support for YMM state.
+  bool fma = false;
+  bool neon = false;
+};
+
+// Detected once and cached.
+const CpuFeatures& GetCpuFeatures();
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_CPU_FEATURES_H_
@@ -0,0 +1,124 @@
+#ifndef SAMURAI_AUDIO_CORE_ECHO_CANCELLER_H_
+#define SAMURAI_AUDIO_CORE_ECHO_CANCELLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "samurai_audio_core/fft.h"
+
+namespace samurai {
+
+struct EchoCancellerConfig {
+  // Longest loudspeaker-to-microphone path modelled, delay and reverb
+  // included.
+  uint32_t tail_ms = 128;
+  // NLMS step in (0, 1]; smaller converges slower but misadjusts less.
+  float step = 0.5f;
+  // CPU the canceller may use, as a percentage of the audio's duration,
+  // over each second of audio. Past it, the rest of that second passes
+  // through unprocessed. 0 for no limit.
+  uint32_t cpu_budget_percent = 10;
+};
+
+struct EchoCancellerStats {
+  uint64_t processed_frames = 0;
+  uint64_t bypassed_frames = 0;  // Passed through over the CPU budget.
+  uint64_t cpu_ns = 0;
+  // Echo return loss enhancement, smoothed over the last second or so of
+  // far-end activity: how much quieter the output is than the microphone.
+  double erle_db = 0.0;
+};
+
+// Removes the far-end echo from a near-end signal with a partitioned-block
+// frequency-domain adaptive filter (overlap-save MDF / PBFDAF). The echo
+// path is split into partitions of block_frames(); each block costs one
+// forward FFT of the far end, one complex multiply-accumulate per
+// partition and an NLMS update normalised per frequency bin. A background
+// filter adapts continuously and is copied to the foreground filter that
+// produces the output only while it cancels better, so near-end speech
+// during far-end speech (double talk) cannot knock the output off.
+//
+// The far end must be time-aligned with the near end, i.e. the echo must
+// arrive in |near| after it was played in |far| and within the tail. Not
+// thread-safe; allocates nothing after construction.
+class EchoCanceller {
+ public:
+  // |block_frames| is a power of two from 16 to 1024; Process() takes whole
+  // blocks, so the canceller adds no latency.
+  EchoCanceller(uint32_t sample_rate, uint32_t block_frames,
+                const EchoCancellerConfig& config);
+  EchoCanceller(uint32_t sample_rate, uint32_t block_frames,
+                const EchoCancellerConfig& config, FftImpl impl);
+
+  bool IsValid() const { return valid_; }
+
+  uint32_t block_frames() const { return block_; }
+  uint32_t partitions() const { return partitions_; }
+
+  // Writes |near| without the echo of |far| to |out|, which may be |near|.
+  // Returns false, leaving |out| alone, unless |frames| is a multiple of
+  // block_frames().
+  bool Process(const float* far, const float* near, size_t frames,
+               float* out);
+
+  // Forgets the echo path and all history.
+  void Reset();
+
+  const EchoCancellerStats& stats() const { return stats_; }
+
+ private:
+  // Planar complex spectra, |bins_| padded to a multiple of 8.
+  struct Spectra {
+    std::vector<float> re;
+    std::vector<float> im;
+  };
+
+  void ProcessBlock(const float* far, const float* near, float* out);
+  // Sets |y| to the echo estimate of |filter| for the current block.
+  void Estimate(const Spectra& filter, float* y);
+  void ClearHistory();
+
+  uint32_t sample_rate_;
+  uint32_t block_;
+  uint32_t partitions_ = 0;
+  EchoCancellerConfig config_;
+  bool valid_ = false;
+  RealFft fft_;
+  size_t bins_ = 0;
+  size_t padded_bins_ = 0;
+
+  // Far-end spectra of the last |partitions_| blocks, newest at |head_|.
+  Spectra far_;
+  size_t head_ = 0;
+  std::vector<float> far_power_;  // Smoothed |X|^2 per bin.
+  Spectra foreground_;  // |partitions_| filters back to back.
+  Spectra background_;
+  uint32_t constrain_next_ = 0;
+
+  // Scratch.
+  std::vector<float> far_window_;  // Previous and current far block.
+  std::vector<float> time_;
+  Spectra sum_;
+  Spectra error_;
+  std::vector<float> echo_;
+  std::vector<float> background_error_;
+
+  // Smoothed block energies deciding foreground copies and the ERLE.
+  double near_energy_ = 0.0;
+  double foreground_energy_ = 0.0;
+  double background_energy_ = 0.0;
+  double erle_near_ = 0.0;
+  double erle_out_ = 0.0;
+
+  // CPU budget over the current second of audio.
+  uint64_t budget_frames_ = 0;
+  uint64_t budget_ns_ = 0;
+  bool over_budget_ = false;
+
+  EchoCancellerStats stats_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_ECHO_CANCELLER_H_
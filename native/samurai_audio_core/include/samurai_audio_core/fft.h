@@ -0,0 +1,70 @@
+#ifndef SAMURAI_AUDIO_CORE_FFT_H_
+#define SAMURAI_AUDIO_CORE_FFT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace samurai {
+
+// Butterfly and spectrum kernels; all agree to within float rounding.
+enum class FftImpl {
+  kScalar,
+  kSse2,
+  kAvx2,  // AVX2 + FMA.
+  kNeon,
+};
+
+const char* FftImplName(FftImpl impl);
+bool FftImplSupported(FftImpl impl);
+FftImpl FftBestImpl();
+
+// FFT of real signals whose size is a power of two, with the spectrum in
+// split format: separate real and imaginary arrays of bins() values, DC
+// first and Nyquist last. Runs as a half-size complex radix-2 FFT plus a
+// split step, with per-stage twiddle tables so wide stages vectorize.
+// Forward is unscaled; Inverse divides by size(), so Inverse(Forward(x))
+// returns x. Not thread-safe (scratch is per instance); allocates nothing
+// after construction.
+class RealFft {
+ public:
+  explicit RealFft(size_t size);
+  RealFft(size_t size, FftImpl impl);
+
+  // False unless size is a power of two from 4 to 65536 and |impl| runs
+  // here.
+  bool IsValid() const { return valid_; }
+
+  size_t size() const { return size_; }
+  size_t bins() const { return size_ / 2 + 1; }
+  FftImpl impl() const { return impl_; }
+
+  // |in| holds size() samples; |re| and |im| receive bins() values.
+  void Forward(const float* in, float* re, float* im);
+
+  // |re| and |im| hold bins() values; |out| receives size() samples. The
+  // imaginary parts of DC and Nyquist are ignored.
+  void Inverse(const float* re, const float* im, float* out);
+
+ private:
+  // In-place complex FFT of |half_| points, input in bit-reversed order.
+  void Transform();
+
+  size_t size_;
+  size_t half_;  // Complex points.
+  FftImpl impl_;
+  bool valid_ = false;
+  std::vector<uint32_t> bit_reverse_;
+  // Stage with h butterflies per group uses entries [h - 1, 2h - 1).
+  std::vector<float> stage_re_;
+  std::vector<float> stage_im_;
+  // exp(-2 pi i k / size) for the split step, k in [0, half_].
+  std::vector<float> split_re_;
+  std::vector<float> split_im_;
+  std::vector<float> work_re_;
+  std::vector<float> work_im_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_FFT_H_
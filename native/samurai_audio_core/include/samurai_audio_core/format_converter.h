@@ -0,0 +1,86 @@
+#ifndef SAMURAI_AUDIO_CORE_FORMAT_CONVERTER_H_
+#define SAMURAI_AUDIO_CORE_FORMAT_CONVERTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "samurai_audio_core/audio_format.h"
+#include "samurai_audio_core/channel_mixer.h"
+#include "samurai_audio_core/resampler.h"
+#include "samurai_audio_core/sample_convert.h"
+
+namespace samurai {
+
+// Brings device packets to the requested format on the capture thread:
+// channel layout through ChannelMixer, sample rate through Resampler and
+// sample type through SampleConverter. When the layout or rate changes,
+// samples go device type -> float -> mix -> resample -> requested type, so
+// the resampler only filters the channels that are kept and int16 output
+// is dithered once, at the end.
+class FormatConverter {
+ public:
+  // Parts of the request that cannot be produced (an unsupported sample
+  // type, a zero or unsupported rate, a channel map that does not fit the
+  // device) fall back to the |input| value. |requested|.channels is
+  // ignored; the channel count follows from |channels|.
+  FormatConverter(const AudioFormat& input, const AudioFormat& requested,
+                  const ChannelMap& channels, bool dither,
+                  ResamplerQuality quality);
+
+  const AudioFormat& input_format() const { return input_; }
+  const AudioFormat& output_format() const { return output_; }
+
+  // The channel mode actually applied.
+  ChannelMode channel_mode() const { return channel_mode_; }
+
+  // True when input packets are already in the output format.
+  bool passthrough() const { return passthrough_; }
+
+  // Input frames the resamplers hold back as lookahead; 0 without one.
+  uint32_t delay_frames() const;
+
+  // Appends an AdaptiveResampler at the output rate, whose ratio
+  // SetRateAdjustment() trims so the output can follow a clock other than
+  // the device's. Moves conversion onto the float path. Returns false if
+  // the stage cannot be built.
+  bool EnableRateAdjustment(ResamplerQuality quality);
+  void SetRateAdjustment(double ratio);
+  // The trim stage; null unless enabled.
+  const AdaptiveResampler* rate_adjuster() const { return adjuster_.get(); }
+
+  // Upper bound on output frames for one Convert() of |input_frames|.
+  size_t MaxOutputFrames(size_t input_frames) const;
+
+  // Converts |frames| input frames, or that many frames of silence when
+  // |in| is null, into |out| (MaxOutputFrames(frames) frames of room).
+  // Returns the number of output frames, which differs from |frames| when
+  // resampling and may be 0 while the resampler fills its lookahead.
+  size_t Convert(const uint8_t* in, size_t frames, uint8_t* out);
+
+ private:
+  AudioFormat input_;
+  AudioFormat output_;
+  ChannelMode channel_mode_ = ChannelMode::kPassthrough;
+  bool passthrough_ = true;
+
+  // Same-layout, same-rate path.
+  std::unique_ptr<SampleConverter> direct_;
+
+  // Float path; staging grows to the largest packet.
+  std::unique_ptr<SampleConverter> to_float_;
+  std::unique_ptr<ChannelMixer> mixer_;
+  std::unique_ptr<Resampler> resampler_;
+  std::unique_ptr<AdaptiveResampler> adjuster_;
+  std::unique_ptr<SampleConverter> from_float_;
+  bool dither_;
+  std::vector<float> float_in_;
+  std::vector<float> mixed_;
+  std::vector<float> float_out_;
+  std::vector<float> adjusted_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_FORMAT_CONVERTER_H_
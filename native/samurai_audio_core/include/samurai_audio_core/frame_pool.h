@@ -0,0 +1,100 @@
+#ifndef SAMURAI_AUDIO_CORE_FRAME_POOL_H_
+#define SAMURAI_AUDIO_CORE_FRAME_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace samurai {
+
+namespace internal {
+struct FramePoolCore;
+}  // namespace internal
+
+// Shared handle to one audio buffer, from a FramePool or the heap. Copies
+// share the buffer through an atomic count and the last one to go hands
+// it back to its pool, on whichever thread that happens; copying, moving
+// and releasing never allocate. A buffer is written while one handle holds
+// it and treated as immutable once shared.
+class FrameRef {
+ public:
+  FrameRef() = default;
+  FrameRef(const FrameRef& other);
+  FrameRef(FrameRef&& other) noexcept;
+  FrameRef& operator=(const FrameRef& other);
+  FrameRef& operator=(FrameRef&& other) noexcept;
+  ~FrameRef() { Reset(); }
+
+  // A buffer of |capacity| bytes from the heap, freed with its last
+  // handle. For the odd size no pool covers; allocates.
+  static FrameRef Allocate(size_t capacity);
+
+  explicit operator bool() const { return buffer_ != nullptr; }
+
+  uint8_t* data() const { return buffer_ ? buffer_->data : nullptr; }
+  size_t capacity() const { return buffer_ ? buffer_->capacity : 0; }
+  // Bytes in use; 0 when handed out.
+  size_t size() const { return buffer_ ? buffer_->size : 0; }
+  // Up to capacity(). Only while unique().
+  void set_size(size_t size) {
+    if (buffer_) {
+      buffer_->size = size <= buffer_->capacity ? size : buffer_->capacity;
+    }
+  }
+  bool unique() const {
+    return buffer_ && buffer_->refs.load(std::memory_order_acquire) == 1;
+  }
+
+  void Reset();
+
+ private:
+  friend class FramePool;
+  friend struct internal::FramePoolCore;
+
+  struct Buffer {
+    std::atomic<uint32_t> refs{0};
+    std::atomic<uint32_t> next_free{0};  // Free-list link, by index.
+    uint32_t index = 0;
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;
+    internal::FramePoolCore* pool = nullptr;  // Null for Allocate().
+  };
+
+  explicit FrameRef(Buffer* buffer) : buffer_(buffer) {}
+
+  Buffer* buffer_ = nullptr;
+};
+
+// Fixed set of equal-sized, 64-byte aligned buffers, all allocated by the
+// constructor. Acquire() and release are lock-free, so any thread,
+// including a capture thread holding a device buffer, may take or drop
+// frames; an empty pool fails the Acquire() instead of allocating. Frames
+// may outlive the pool: its storage goes with the last of them.
+class FramePool {
+ public:
+  FramePool(size_t buffer_count, size_t buffer_bytes);
+  ~FramePool();
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  // A unique, empty frame, or a null one when all are in use.
+  FrameRef Acquire();
+
+  size_t capacity() const { return capacity_; }
+  size_t buffer_bytes() const { return buffer_bytes_; }
+  // Frames not in use right now.
+  size_t available() const;
+  // Acquire() calls that found the pool empty.
+  uint64_t exhausted() const;
+
+ private:
+  size_t capacity_;
+  size_t buffer_bytes_;
+  internal::FramePoolCore* core_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_FRAME_POOL_H_
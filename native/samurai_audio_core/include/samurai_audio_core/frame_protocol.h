@@ -0,0 +1,77 @@
+#ifndef SAMURAI_AUDIO_CORE_FRAME_PROTOCOL_H_
+#define SAMURAI_AUDIO_CORE_FRAME_PROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "samurai_audio_core/audio_codec.h"
+#include "samurai_audio_core/audio_format.h"
+#include "samurai_audio_core/capture_engine.h"
+
+namespace samurai {
+
+// Binary audio frames as streamed to the server, one per WebSocket binary
+// message. A fixed little-endian header is followed by the packet bytes:
+//
+//   offset  size  field
+//        0     1  version (kFrameProtocolVersion)
+//        1     1  header size in bytes (40; at least 32 in version 1)
+//        2     1  stream: 0 system (customer), 1 microphone (agent),
+//                 2 aligned (stereo: customer left, agent right)
+//        3     1  codec: 0 pcm, 1 opus, 2 mp3
+//        4     2  flags (PacketFlags)
+//        6     1  channels
+//        7     1  sample type: 0 int16, 1 int24, 2 int32, 3 float32
+//        8     8  capture time, ns, signed (capture clock epoch)
+//       16     4  sample rate
+//       20     4  frames covered by the payload
+//       24     4  sequence (per stream, wraps)
+//       28     4  payload size in bytes
+//       32     8  stream position in frames (absent from 32-byte headers)
+//
+// Silence markers (kPacketSilenceMarker) have no payload; |frames| is the
+// duration. Additions within a version only append header fields and grow
+// the header size, which decoders skip past; anything else bumps the
+// version. tools/frame_decoder.py is the reference decoder for servers.
+constexpr uint8_t kFrameProtocolVersion = 1;
+constexpr size_t kFrameHeaderBytes = 40;
+// The shortest version 1 header, as sent before positions were added.
+constexpr size_t kFrameHeaderMinBytes = 32;
+
+struct FrameHeader {
+  uint8_t version = kFrameProtocolVersion;
+  StreamKind stream = StreamKind::kSystem;
+  CodecId codec = CodecId::kPcm;
+  uint16_t flags = 0;
+  // For kPcm the payload's sample layout; for codecs what was encoded.
+  AudioFormat format;
+  int64_t capture_time_ns = 0;
+  uint32_t frames = 0;
+  uint32_t sequence = 0;
+  uint32_t payload_bytes = 0;
+  // AudioPacket::position. Decodes as 0 from a header too short to hold
+  // it; |has_position| tells the two apart.
+  uint64_t position = 0;
+  bool has_position = true;
+};
+
+// The header describing |packet|.
+FrameHeader FrameHeaderForPacket(const AudioPacket& packet);
+
+// Writes kFrameHeaderBytes to |out|.
+void EncodeFrameHeader(const FrameHeader& header, uint8_t* out);
+
+// Replaces |frame| with the header and payload of |packet|.
+void EncodeFrame(const AudioPacket& packet, std::string* frame);
+
+// Parses the frame at the start of |data|. Returns the bytes it occupies
+// (header plus payload), so concatenated frames can be walked, or 0 if
+// |data| does not hold a complete frame of a known version with valid
+// fields. |payload| points into |data|.
+size_t DecodeFrame(const uint8_t* data, size_t size, FrameHeader* header,
+                   const uint8_t** payload);
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_FRAME_PROTOCOL_H_
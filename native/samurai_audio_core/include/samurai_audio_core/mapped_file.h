@@ -0,0 +1,62 @@
+#ifndef SAMURAI_AUDIO_CORE_MAPPED_FILE_H_
+#define SAMURAI_AUDIO_CORE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace samurai {
+
+// Memory map of a whole file (mmap / MapViewOfFile), read-only or
+// read-write. Pages are faulted in on access, so a large recording costs
+// address space, not resident memory.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps |path| (UTF-8). Returns false if it cannot be opened or mapped.
+  // Empty files open successfully with a null data().
+  bool Open(const std::string& path);
+  // Maps |path| read-write, creating it, or growing it with zeros, to at
+  // least |size| bytes. The space is allocated up front, so a full disk
+  // fails here rather than faulting on a later write. Writes reach the
+  // file through the page cache; Sync() makes them durable.
+  bool OpenWritable(const std::string& path, size_t size);
+  void Close();
+
+  bool is_open() const { return open_; }
+  const uint8_t* data() const { return data_; }
+  // Null unless opened with OpenWritable().
+  uint8_t* mutable_data() const {
+    return writable_ ? const_cast<uint8_t*>(data_) : nullptr;
+  }
+  size_t size() const { return size_; }
+
+  // Writes [offset, offset + length) of a writable map to disk and waits
+  // for it. Returns false on failure or for read-only maps.
+  bool Sync(size_t offset, size_t length) const;
+
+  // Hints that [offset, offset + length) is no longer needed, so streaming
+  // readers do not keep the whole file resident.
+  void Release(size_t offset, size_t length) const;
+
+ private:
+  bool open_ = false;
+  bool writable_ = false;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(_WIN32)
+  void* file_ = nullptr;     // HANDLE
+  void* mapping_ = nullptr;  // HANDLE
+#else
+  int fd_ = -1;
+#endif
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_MAPPED_FILE_H_
@@ -0,0 +1,132 @@
+#ifndef SAMURAI_AUDIO_CORE_PACKET_FAN_OUT_H_
+#define SAMURAI_AUDIO_CORE_PACKET_FAN_OUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "samurai_audio_core/capture_engine.h"
+
+namespace samurai {
+
+// What a fan-out sink does with a packet that finds its queue full.
+enum class BackpressurePolicy {
+  kDropOldest,  // Evict the oldest queued packets; the sink lags least.
+  kDropNewest,  // Refuse the new packet; what is queued stays intact.
+  kBlock,       // Make the delivering thread wait for room. Every other
+                // sink waits with it, and in the end the capture ring
+                // overruns: for sinks that must see every packet.
+  // Give up silence first: queued PCM packets tagged kPacketNoSpeech or
+  // kPacketSilent become kPacketSilenceMarker packets, and adjacent
+  // markers merge, so the timeline survives while the samples go. Only
+  // when that is not enough are the oldest packets evicted.
+  kCoalesceSilence,
+};
+
+// "drop_oldest" / "drop_newest" / "block" / "coalesce_silence", as used on
+// the platform channel.
+const char* BackpressurePolicyName(BackpressurePolicy policy);
+
+// Parses a policy name. Returns false (leaving |policy| alone) for unknown
+// names.
+bool ParseBackpressurePolicy(const std::string& name,
+                             BackpressurePolicy* policy);
+
+// A sink's queue is full when any bound would be exceeded; 0 lifts the
+// byte or duration bound. A packet is always let into an empty queue.
+struct FanOutSinkConfig {
+  // Packets waiting for the sink's callback.
+  size_t max_packets = 64;
+  // Engine frames the sink may hold per stream, queued or in its callback.
+  // The engine lends a stream StreamInfo::queue_slots frames beyond its
+  // ring, and sinks share them, so with every sink within the smallest
+  // queue_slots in use (16 on the realtime profile) a stalled sink cannot
+  // starve capture for the others: the queue counts as full and the
+  // policy applies. Copied packets and silence markers hold none. 0 lifts
+  // the bound.
+  size_t max_held_frames = 16;
+  // Sample bytes and audio duration waiting. Silence markers count
+  // towards neither.
+  size_t max_bytes = 1 << 20;
+  uint32_t max_duration_ms = 2000;
+  BackpressurePolicy policy = BackpressurePolicy::kDropOldest;
+};
+
+// Counters for one attached sink.
+struct FanOutSinkStats {
+  uint64_t delivered_packets = 0;  // Handed to the callback.
+  uint64_t dropped_packets = 0;    // Evicted or refused on a full queue.
+  // kCoalesceSilence: packets whose samples were given up, by becoming a
+  // marker or merging into one.
+  uint64_t coalesced_packets = 0;
+  // kBlock: packets the delivering thread had to wait for room for.
+  uint64_t blocked_packets = 0;
+  // Packets that came without an AudioPacket::buffer and were copied.
+  uint64_t copied_packets = 0;
+  // Waiting right now, and the high-water marks since Attach().
+  size_t queued_packets = 0;
+  size_t queued_bytes = 0;
+  uint32_t queued_ms = 0;
+  size_t high_water_packets = 0;
+  size_t high_water_bytes = 0;
+  uint32_t high_water_ms = 0;
+};
+
+// Hands every delivered packet to any number of sinks without copying it:
+// each sink's queue holds a FrameRef to the packet's buffer, so recording,
+// streaming and metering share one capture. Every sink has its own bounded
+// queue, BackpressurePolicy and thread running its callback, so a slow
+// sink only costs its own drops (unless it blocks), and a stalled one
+// holds no more than its bounds. Sinks may be attached and detached while
+// packets flow.
+//
+// Deliver() is meant to be the CaptureEngine callback, for any number of
+// streams. Queues are allocated by Attach(); delivering allocates nothing
+// unless a packet comes without a buffer.
+class PacketFanOut {
+ public:
+  // Attach() fails beyond this many sinks.
+  static constexpr size_t kMaxSinks = 8;
+
+  PacketFanOut();
+  // Detaches every sink.
+  ~PacketFanOut();
+
+  PacketFanOut(const PacketFanOut&) = delete;
+  PacketFanOut& operator=(const PacketFanOut&) = delete;
+
+  // Starts delivering packets from the next Deliver() on to |callback|, on
+  // a thread of the sink's own. The packet's |buffer| is always set, and
+  // empty only for silence markers; it may be kept. Returns the sink's id,
+  // or 0 when kMaxSinks are attached.
+  uint64_t Attach(const FanOutSinkConfig& config,
+                  AudioPacketCallback callback);
+
+  // Hands the sink what is already queued, then joins its thread. Never
+  // call it from the sink's own callback. Returns false for unknown ids.
+  bool Detach(uint64_t id);
+
+  // Queues |packet| for every attached sink. Called on capture delivery
+  // threads.
+  void Deliver(const AudioPacket& packet);
+
+  // Returns false for unknown ids.
+  bool GetStats(uint64_t id, FanOutSinkStats* stats) const;
+
+  size_t sink_count() const;
+
+ private:
+  struct Sink;
+
+  mutable std::mutex mutex_;
+  // Copied out under |mutex_| by Deliver(), so queueing runs unlocked and
+  // a Detach() can wake a producer blocked on the sink it removes.
+  std::shared_ptr<Sink> sinks_[kMaxSinks];
+  uint64_t next_id_ = 1;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_PACKET_FAN_OUT_H_
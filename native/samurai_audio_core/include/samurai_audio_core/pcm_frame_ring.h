@@ -0,0 +1,94 @@
+#ifndef SAMURAI_AUDIO_CORE_PCM_FRAME_RING_H_
+#define SAMURAI_AUDIO_CORE_PCM_FRAME_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "samurai_audio_core/audio_format.h"
+#include "samurai_audio_core/frame_pool.h"
+
+namespace samurai {
+
+// One fixed-capacity slot of interleaved PCM.
+struct PcmFrame {
+  // Holds |data|; null for markers. Copy it to keep the samples past
+  // Pop() without copying them.
+  FrameRef buffer;
+  uint8_t* data = nullptr;
+  size_t size = 0;  // Bytes used, <= PcmFrameRing::slot_bytes().
+  uint32_t frames = 0;
+  uint32_t flags = 0;
+  MediaTimestamp timestamp;  // Of the first frame.
+};
+
+// Wait-free single-producer/single-consumer ring of fixed-size PCM slots.
+// All storage is allocated up front; Write() is a bounded memcpy and never
+// blocks, so it is safe to call while a device buffer is held. When the
+// consumer falls behind, writes fail and are counted as overruns.
+//
+// Slots are filled in FramePool buffers, one pool per ring with twice as
+// many buffers as slots: consumers may keep as many slots' samples again
+// past Pop() before writes run out of buffers and overrun too.
+class PcmFrameRing {
+ public:
+  // |slot_count| is rounded up to a power of two.
+  PcmFrameRing(size_t slot_count, size_t slot_bytes);
+
+  PcmFrameRing(const PcmFrameRing&) = delete;
+  PcmFrameRing& operator=(const PcmFrameRing&) = delete;
+
+  // Producer. Copies |frames| frames of |format|, splitting across slots
+  // if needed; each slot is stamped with where its first frame falls after
+  // |timestamp|. All-or-nothing: returns false without writing anything
+  // when there is not enough room.
+  bool Write(const uint8_t* data, uint32_t frames, const AudioFormat& format,
+             uint32_t flags, const MediaTimestamp& timestamp);
+
+  // Producer. Queues a slot with no samples (size 0) that stands for
+  // |frames| frames, e.g. a run of suppressed silence. Returns false when
+  // the ring is full, without touching the overrun counters; the caller
+  // decides what a lost marker costs.
+  bool WriteMarker(uint32_t frames, uint32_t flags,
+                   const MediaTimestamp& timestamp);
+
+  // Consumer. Returns the oldest slot, or nullptr when empty. The slot stays
+  // valid until Pop().
+  const PcmFrame* Peek() const;
+  void Pop();
+
+  bool Empty() const;
+  size_t Size() const;
+
+  size_t capacity() const { return slots_.size(); }
+  size_t slot_bytes() const { return slot_bytes_; }
+  const FramePool& pool() const { return pool_; }
+
+  // Producer-side counters, readable from any thread.
+  uint64_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+  uint64_t dropped_frames() const {
+    return dropped_frames_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Keeps head and tail on separate cache lines.
+  struct alignas(64) Index {
+    std::atomic<size_t> value{0};
+  };
+
+  const size_t slot_bytes_;
+  const size_t mask_;
+  FramePool pool_;
+  std::vector<PcmFrame> slots_;
+
+  Index head_;  // Next slot to read; written by the consumer.
+  Index tail_;  // Next slot to write; written by the producer.
+
+  std::atomic<uint64_t> overruns_{0};
+  std::atomic<uint64_t> dropped_frames_{0};
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_PCM_FRAME_RING_H_
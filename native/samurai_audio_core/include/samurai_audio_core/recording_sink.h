@@ -0,0 +1,54 @@
+#ifndef SAMURAI_AUDIO_CORE_RECORDING_SINK_H_
+#define SAMURAI_AUDIO_CORE_RECORDING_SINK_H_
+
+#include <cstdint>
+#include <string>
+
+#include "samurai_audio_core/audio_codec.h"
+#include "samurai_audio_core/audio_file_writer.h"
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+struct RecordingConfig {
+  std::string path;  // UTF-8. Empty: not recording.
+  // kMp3 or kOpus for a compressed file; kPcm writes WAV.
+  EncoderConfig encoder;
+  // Optional lossless WAV copy written alongside; empty for none.
+  std::string wav_path;
+};
+
+// Records one capture stream while it runs, so the file is complete the
+// moment capture stops instead of after a transcode of the whole WAV.
+// Fed with delivered-format packets on the engine's delivery thread.
+class RecordingSink {
+ public:
+  // Creates the file(s) for |format|. Returns false, leaving nothing
+  // open, if the codec cannot take |format| or a file cannot be created.
+  bool Open(const RecordingConfig& config, const AudioFormat& format);
+
+  // Appends one delivered packet (PacketFlags in |flags|). Silence markers
+  // are written as digital silence, so the file keeps the stream's
+  // timeline.
+  void Write(const uint8_t* pcm, uint32_t frames, uint32_t flags);
+
+  // Finalizes and closes both files in constant time. Returns false if
+  // any write failed.
+  bool Close();
+
+  bool is_open() const { return file_.is_open(); }
+  // Of the main file.
+  std::string MimeType() const { return file_.MimeType(); }
+  uint64_t frames() const { return file_.frames(); }
+  // Both files together.
+  uint64_t bytes() const { return file_.bytes() + wav_.bytes(); }
+  bool failed() const { return file_.failed() || wav_.failed(); }
+
+ private:
+  AudioFileWriter file_;
+  AudioFileWriter wav_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_RECORDING_SINK_H_
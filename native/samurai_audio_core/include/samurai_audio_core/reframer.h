@@ -0,0 +1,71 @@
+#ifndef SAMURAI_AUDIO_CORE_REFRAMER_H_
+#define SAMURAI_AUDIO_CORE_REFRAMER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+// Re-blocks PCM packets of whatever size the device produces into frames of
+// exactly |frame_ms|, e.g. 10, 20, 40 or 60 ms. Each frame is emitted from
+// one contiguous, 64-byte aligned buffer. A partial frame waits at most
+// |flush_timeout_ms| (measured from its first sample's arrival) for the
+// rest and is then emitted short, so a stalled device costs bounded
+// latency instead of a held frame. Silence markers complete the open frame
+// with zeros and pass through for the remainder, keeping the frame grid.
+// Not thread-safe; allocates nothing after construction.
+class Reframer {
+ public:
+  // (data, size, frames, flags), as EncoderStage::Output. Markers have no
+  // data.
+  using Output =
+      std::function<void(const uint8_t*, size_t, uint32_t, uint32_t)>;
+
+  static constexpr int64_t kNoDeadline = std::numeric_limits<int64_t>::max();
+
+  // |flush_timeout_ms| of 0 holds partial frames until Flush().
+  Reframer(const AudioFormat& format, uint32_t frame_ms,
+           uint32_t flush_timeout_ms);
+
+  uint32_t frame_frames() const { return frame_frames_; }
+
+  // Appends |frames| frames that arrived at |now_ns| and emits every frame
+  // they complete. |flags| (PacketFlags) are ORed into the frame holding
+  // the first of them.
+  void Push(const uint8_t* pcm, uint32_t frames, uint32_t flags,
+            int64_t now_ns, const Output& output);
+
+  // Emits the partial frame if its flush timeout has passed by |now_ns|.
+  void Poll(int64_t now_ns, const Output& output);
+
+  // When Poll() next has something to emit; kNoDeadline if nothing.
+  int64_t deadline_ns() const;
+
+  // Emits the partial frame, if any. Call when the stream ends.
+  void Flush(const Output& output);
+
+  // Short frames emitted because the flush timeout passed.
+  uint64_t timeouts() const { return timeouts_; }
+
+ private:
+  void Emit(const Output& output);
+
+  uint32_t block_align_;
+  uint32_t frame_frames_;
+  int64_t timeout_ns_;
+  std::unique_ptr<uint8_t[]> storage_;
+  uint8_t* frame_;            // |storage_| rounded up to 64 bytes.
+  uint32_t buffered_ = 0;     // Frames in |frame_|.
+  uint32_t flags_ = 0;        // Of the open frame.
+  int64_t first_ns_ = 0;      // Arrival of the open frame's first frame.
+  uint64_t timeouts_ = 0;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_REFRAMER_H_
@@ -0,0 +1,164 @@
+#ifndef SAMURAI_AUDIO_CORE_RESAMPLER_H_
+#define SAMURAI_AUDIO_CORE_RESAMPLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace samurai {
+
+// Filter length / stopband trade-offs. Tap counts are per output phase at
+// unity ratio and grow with the decimation factor, so the transition band
+// stays proportional to the output rate.
+enum class ResamplerQuality {
+  kLow,     // 16 taps, ~60 dB stopband. Speech to ASR.
+  kMedium,  // 32 taps, ~80 dB stopband.
+  kHigh,    // 64 taps, ~100 dB stopband. Music / archival.
+};
+
+// "low" / "medium" / "high", as used on the platform channel.
+const char* ResamplerQualityName(ResamplerQuality quality);
+
+// Parses a quality name. Returns false (leaving |quality| alone) for
+// unknown names.
+bool ParseResamplerQuality(const std::string& name, ResamplerQuality* quality);
+
+// Dot-product kernels; all agree to within float rounding.
+enum class ResamplerImpl {
+  kScalar,
+  kSse2,
+  kAvx2,  // AVX2 + FMA.
+  kNeon,
+};
+
+const char* ResamplerImplName(ResamplerImpl impl);
+bool ResamplerImplSupported(ResamplerImpl impl);
+ResamplerImpl ResamplerBestImpl();
+
+// Streaming rational-ratio polyphase resampler for interleaved float
+// frames. The rate ratio is reduced to L/M; a Kaiser-windowed sinc
+// prototype is split into L phases and each output frame is one dot
+// product over the input history. History carries across Process() calls,
+// so packet boundaries are inaudible.
+//
+// Output frame k is centred on input time k * M / L, so the stream has no
+// group delay, but each output needs taps() / 2 frames of lookahead: the
+// first call returns correspondingly fewer frames.
+class Resampler {
+ public:
+  Resampler(uint32_t input_rate, uint32_t output_rate, uint16_t channels,
+            ResamplerQuality quality);
+  Resampler(uint32_t input_rate, uint32_t output_rate, uint16_t channels,
+            ResamplerQuality quality, ResamplerImpl impl);
+
+  // False for zero rates/channels, unsupported |impl|, or ratios whose
+  // reduced form needs an unreasonably large coefficient table.
+  bool IsValid() const { return valid_; }
+
+  uint32_t input_rate() const { return input_rate_; }
+  uint32_t output_rate() const { return output_rate_; }
+  uint16_t channels() const { return channels_; }
+  // Filter length in input frames and number of polyphase branches.
+  uint32_t taps() const { return taps_; }
+  uint32_t phases() const { return up_; }
+
+  // Upper bound on the frames one Process() call produces from
+  // |input_frames| input frames.
+  size_t MaxOutputFrames(size_t input_frames) const;
+
+  // Consumes |frames| interleaved input frames and writes the output frames
+  // now available to |out| (MaxOutputFrames(frames) capacity). Returns the
+  // number of frames written.
+  size_t Process(const float* in, size_t frames, float* out);
+
+  // Drops history and phase, as if freshly constructed.
+  void Reset();
+
+ private:
+  uint32_t input_rate_;
+  uint32_t output_rate_;
+  uint16_t channels_;
+  ResamplerImpl impl_;
+  bool valid_ = false;
+
+  uint32_t up_ = 1;    // L
+  uint32_t down_ = 1;  // M
+  uint32_t taps_ = 0;  // Multiple of 8 for the vector kernels.
+  std::vector<float> coefficients_;  // up_ rows of taps_ in history order.
+
+  // Planar input history per channel: frames [0, buffered_) are valid and
+  // the next output starts at frame 0 with phase phase_.
+  std::vector<std::vector<float>> history_;
+  size_t buffered_ = 0;
+  uint32_t phase_ = 0;
+};
+
+// Streaming resampler for ratios within a percent of 1 that may change
+// between calls: the fine trim that locks a drifting device clock to the
+// host clock. The windowed sinc is tabulated at kPhases fractional offsets
+// and interpolated linearly between them, so the read position can step by
+// any amount. Like Resampler, output frame k is centred on the input
+// position it was read at, with taps() / 2 frames of lookahead.
+class AdaptiveResampler {
+ public:
+  static constexpr uint32_t kPhases = 128;
+  // SetRatio() clamps to 1 +- this.
+  static constexpr double kMaxAdjustment = 0.01;
+
+  AdaptiveResampler(uint16_t channels, ResamplerQuality quality);
+  AdaptiveResampler(uint16_t channels, ResamplerQuality quality,
+                    ResamplerImpl impl);
+
+  // False for zero channels or an unsupported |impl|.
+  bool IsValid() const { return valid_; }
+
+  uint16_t channels() const { return channels_; }
+  uint32_t taps() const { return taps_; }
+
+  // Input frames consumed per output frame from the next Process() on;
+  // above 1 shortens the stream. Starts at 1.
+  void SetRatio(double ratio);
+  double ratio() const { return ratio_; }
+
+  // Input frame, counted from Reset() and fractional, that the next output
+  // frame is centred on.
+  double next_input_position() const {
+    return static_cast<double>(dropped_ + position_) + fraction_;
+  }
+
+  // Upper bound on the frames one Process() call produces from
+  // |input_frames| input frames, at any ratio.
+  size_t MaxOutputFrames(size_t input_frames) const;
+
+  // As Resampler::Process().
+  size_t Process(const float* in, size_t frames, float* out);
+
+  // Drops history and position; keeps the ratio.
+  void Reset();
+
+ private:
+  uint16_t channels_;
+  ResamplerImpl impl_;
+  bool valid_ = false;
+  double ratio_ = 1.0;
+
+  uint32_t taps_ = 0;
+  // kPhases + 1 rows of taps_: row p delays by p / kPhases of a frame.
+  std::vector<float> coefficients_;
+  std::vector<float> row_;  // Interpolated between two rows.
+
+  // Planar history as in Resampler. The next output starts at history
+  // frame |position_|, with |fraction_| selecting the phase; kept apart so
+  // the phases do not depend on where packets split.
+  std::vector<std::vector<float>> history_;
+  size_t buffered_ = 0;
+  size_t position_ = 0;
+  double fraction_ = 0.0;
+  // History frames discarded since Reset().
+  uint64_t dropped_ = 0;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_RESAMPLER_H_
@@ -0,0 +1,69 @@
+#ifndef SAMURAI_AUDIO_CORE_SAMPLE_CONVERT_H_
+#define SAMURAI_AUDIO_CORE_SAMPLE_CONVERT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+// Kernel implementations for the int16 conversions. SampleConverter picks
+// the fastest one the CPU supports; all of them produce identical output,
+// dither included.
+enum class ConvertImpl {
+  kScalar,
+  kSsse3,
+  kAvx2,
+  kNeon,
+};
+
+const char* ConvertImplName(ConvertImpl impl);
+bool ConvertImplSupported(ConvertImpl impl);
+ConvertImpl ConvertBestImpl();
+
+// TPDF dither source: eight xorshift32 generators, one per position in a
+// block of eight samples, so vector kernels of any width draw the same
+// sequence as the scalar code.
+struct DitherState {
+  static constexpr int kLanes = 8;
+  uint32_t lanes[kLanes];
+
+  explicit DitherState(uint32_t seed = 0x2545F491u);
+};
+
+// Converts interleaved samples between sample types. Narrowing to int16
+// scales, optionally adds +-1 LSB triangular dither, rounds to nearest and
+// saturates (NaN becomes 0). Supported outputs are kInt16 and kFloat32;
+// any input type is accepted.
+class SampleConverter {
+ public:
+  SampleConverter(SampleType input, SampleType output, bool dither);
+  SampleConverter(SampleType input, SampleType output, bool dither,
+                  ConvertImpl impl);
+
+  // False if the output type is unsupported or |impl| is not available.
+  bool IsValid() const { return valid_; }
+
+  SampleType input() const { return input_; }
+  SampleType output() const { return output_; }
+
+  // Output bytes for |samples| input samples.
+  size_t OutputSize(size_t samples) const;
+
+  // Converts |samples| samples (frames * channels) from |in| to |out|,
+  // which must hold OutputSize(samples) bytes and must not overlap |in|.
+  void Convert(const uint8_t* in, size_t samples, uint8_t* out);
+
+ private:
+  SampleType input_;
+  SampleType output_;
+  bool dither_;
+  ConvertImpl impl_;
+  bool valid_;
+  DitherState dither_state_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SAMPLE_CONVERT_H_
@@ -0,0 +1,127 @@
+#ifndef SAMURAI_AUDIO_CORE_SPILL_LOG_H_
+#define SAMURAI_AUDIO_CORE_SPILL_LOG_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+namespace samurai {
+
+struct SpillLogConfig {
+  std::string directory;  // UTF-8; created if missing.
+  // Segment files are allocated at this size up front, so a full disk
+  // fails an append instead of faulting a write. A record must fit in one.
+  size_t segment_bytes = 4 << 20;
+  // Disk the log may take, rounded down to whole segments (at least two).
+  // Beyond it the oldest segment is deleted, unread records and all.
+  size_t max_bytes = 256 << 20;
+  // Appends are made durable in batches: once this many bytes are unsynced
+  // (0: after every append), or, checked on append, once the oldest
+  // unsynced one is this old (0: no time trigger). A crash loses at most
+  // the unsynced batch.
+  size_t sync_bytes = 256 << 10;
+  uint32_t sync_interval_ms = 1000;
+};
+
+struct SpillLogStats {
+  uint64_t appended_records = 0;
+  uint64_t consumed_records = 0;
+  // Unread when the disk bound evicted their segment.
+  uint64_t dropped_records = 0;
+  // Found on disk by Open().
+  uint64_t recovered_records = 0;
+  uint64_t syncs = 0;
+  // Unread right now: records, their payload bytes and audio.
+  uint64_t pending_records = 0;
+  uint64_t pending_bytes = 0;
+  uint64_t pending_ns = 0;
+  uint64_t disk_bytes = 0;  // Segment files, allocated size.
+};
+
+// One record from SpillLog::Peek(). |data| points into the log's mapping.
+struct SpillRecord {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  uint64_t ns = 0;     // As given to Append().
+  uint64_t index = 0;  // For Pop().
+};
+
+// An append-only log of opaque records, each tagged with the audio it
+// holds, for the network sink to spill encoded frames to while the server
+// is unreachable or slow and replay them later in order. Records go into
+// preallocated segment files mapped read-write, so appending is a copy;
+// segments are deleted once read. Whatever is unread when the log is
+// closed stays on disk, and the next Open() of the directory recovers it
+// up to the first torn or corrupt record. Reading progress within a
+// segment is not persisted, so after a crash records already read from
+// the oldest segment are read again.
+//
+// Not thread-safe.
+class SpillLog {
+ public:
+  explicit SpillLog(SpillLogConfig config);
+  // Close()s.
+  ~SpillLog();
+
+  SpillLog(const SpillLog&) = delete;
+  SpillLog& operator=(const SpillLog&) = delete;
+
+  // Creates the directory and recovers the segments in it. Returns false
+  // if the directory cannot be created or listed.
+  bool Open();
+  // Syncs and unmaps; the segments stay on disk.
+  void Close();
+  bool is_open() const { return open_; }
+
+  // Appends a record of |size| bytes holding |ns| of audio. Returns false
+  // when it cannot be written: empty, too big for a segment, or no new
+  // segment could be allocated.
+  bool Append(const uint8_t* data, size_t size, uint64_t ns);
+
+  // The oldest unread record; false when there is none. |record| stays
+  // valid until the next Append(), Pop() or Close().
+  bool Peek(SpillRecord* record);
+  // Consumes the record Peek() returned as |index|, unless the disk bound
+  // has dropped it since.
+  void Pop(uint64_t index);
+  bool empty() const { return stats_.pending_records == 0; }
+
+  // Syncs what is unsynced now, whatever the batching.
+  void Sync();
+
+  SpillLogStats stats() const;
+
+ private:
+  struct Segment;
+
+  std::string SegmentPath(uint64_t number) const;
+  // Scans a recovered segment. Returns null if it holds no records.
+  std::unique_ptr<Segment> Recover(uint64_t number);
+  // Syncs the tail, evicts past the bound and adds a writable segment.
+  bool AddSegment();
+  // Deletes the oldest segment, counting its unread records as dropped.
+  void EvictOldest();
+  void RemoveOldest();
+  // Deletes segments read to the end; the tail too once nothing is unread,
+  // so a restart does not read it again.
+  void RemoveRead();
+  void MaybeSync();
+
+  const SpillLogConfig config_;
+  const size_t max_segments_;
+  bool open_ = false;
+  // Oldest first; appends go to the last one if it is writable.
+  std::deque<std::unique_ptr<Segment>> segments_;
+  uint64_t next_number_ = 0;
+  uint64_t next_index_ = 0;  // Of the oldest unread record.
+  size_t unsynced_bytes_ = 0;
+  std::chrono::steady_clock::time_point unsynced_since_;
+  SpillLogStats stats_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SPILL_LOG_H_
@@ -0,0 +1,100 @@
+#ifndef SAMURAI_AUDIO_CORE_STREAM_ALIGNER_H_
+#define SAMURAI_AUDIO_CORE_STREAM_ALIGNER_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "samurai_audio_core/audio_format.h"
+#include "samurai_audio_core/capture_engine.h"
+
+namespace samurai {
+
+struct StreamAlignerConfig {
+  // Duration of each aligned packet.
+  uint32_t frame_ms = 20;
+  // How far one stream may run ahead before the other is taken to be
+  // late and its missing frames are filled with silence. Bounds both the
+  // added latency and the buffer.
+  uint32_t max_wait_ms = 200;
+};
+
+struct StreamAlignerStats {
+  uint64_t packets = 0;  // Aligned packets emitted.
+  // Per StreamKind::kSystem / kMicrophone: frames filled with silence
+  // because the stream had nothing for them in time, and frames that
+  // arrived after their packet had gone out and were dropped.
+  uint64_t filled_frames[kStreamKindCount] = {};
+  uint64_t late_frames[kStreamKindCount] = {};
+  // Input packets that could not be aligned (see Push()).
+  uint64_t rejected_packets = 0;
+};
+
+// Merges the system (customer) and microphone (agent) streams into one
+// stereo kAligned stream, customer on the left and agent on the right.
+//
+// Each stream is placed on a shared output timeline by its capture time:
+// its first packet fixes its offset from the other stream, so different
+// device start times cancel out, and from then on its sample-accurate
+// positions place every frame. An output packet goes out once both streams
+// have covered it, or once either stream is |max_wait_ms| past it; frames
+// a stream has not supplied by then, and silence markers and position
+// gaps, become zeros. Output is PCM in the inputs' sample type, stamped on
+// the output timeline with the first packet's host clock.
+//
+// Not thread-safe; callers feeding it from both delivery threads
+// serialize Push().
+class StreamAligner {
+ public:
+  using Output = std::function<void(const AudioPacket&)>;
+
+  explicit StreamAligner(const StreamAlignerConfig& config);
+
+  // Adds a system or microphone packet and emits every aligned packet it
+  // completes. Returns false, leaving the timeline alone, for packets it
+  // cannot align: encoded, not mono, or not in the format of the first
+  // packet it accepted.
+  bool Push(const AudioPacket& packet, const Output& output);
+
+  // Emits what is buffered, filling gaps. Call when both streams end.
+  void Flush(const Output& output);
+
+  const StreamAlignerStats& stats() const { return stats_; }
+
+ private:
+  struct Input {
+    bool started = false;
+    // Output frame index of stream position 0.
+    int64_t offset = 0;
+    // Output frame indices of the first frame supplied and just past the
+    // last.
+    int64_t begin = 0;
+    int64_t end = 0;
+  };
+
+  // ORs |flags| into the buffered packet holding output frame |frame|.
+  void MarkFrame(int64_t frame, uint32_t flags);
+  // Emits the oldest |frames| buffered frames as one packet.
+  void Emit(uint32_t frames, const Output& output);
+
+  StreamAlignerConfig config_;
+  bool configured_ = false;
+  AudioFormat input_format_;   // Mono.
+  AudioFormat output_format_;  // Stereo.
+  uint32_t frame_frames_ = 0;
+  uint32_t capacity_frames_ = 0;
+  int64_t origin_ns_ = 0;  // Host time of output frame 0.
+  Input inputs_[kStreamKindCount];
+  // Interleaved output frames [base_, base_ + capacity_frames_), zeros
+  // wherever no stream wrote.
+  std::vector<uint8_t> buffer_;
+  int64_t base_ = 0;
+  // PacketFlags of each buffered packet, oldest first.
+  std::vector<uint32_t> packet_flags_;
+  uint64_t sequence_ = 0;
+  StreamAlignerStats stats_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_STREAM_ALIGNER_H_
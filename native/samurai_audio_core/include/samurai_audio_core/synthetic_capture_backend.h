@@ -0,0 +1,64 @@
+#ifndef SAMURAI_AUDIO_CORE_SYNTHETIC_CAPTURE_BACKEND_H_
+#define SAMURAI_AUDIO_CORE_SYNTHETIC_CAPTURE_BACKEND_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/capture_backend.h"
+#include "samurai_audio_core/capture_clock.h"
+
+namespace samurai {
+
+// Device-free backend that synthesizes a sine tone per stream. Used on
+// Linux and in tests/benchmarks where no real endpoint exists. In real-time
+// mode a packet becomes ready every |packet_frames| frames of clock time;
+// event-driven streams sleep until exactly that moment.
+class SyntheticCaptureBackend : public CaptureBackend {
+ public:
+  struct Options {
+    // Format every stream reports; defaults to 48 kHz float stereo, which is
+    // what a typical Windows loopback endpoint hands us.
+    AudioFormat format;
+    // Frames per device packet (10 ms at 48 kHz).
+    uint32_t packet_frames = 480;
+    // When true packets become available at the format's real-time rate;
+    // otherwise a packet is always ready, for throughput measurements.
+    bool realtime = true;
+    // Tone frequencies for the system and microphone streams.
+    double system_frequency = 440.0;
+    double microphone_frequency = 660.0;
+    // How far each stream's device clock runs from |clock|, in parts per
+    // million; positive runs fast. Capture times follow, as with two real
+    // endpoints on separate crystals.
+    double system_clock_ppm = 0.0;
+    double microphone_clock_ppm = 0.0;
+    // Every Nth packet is flagged silent (and zeroed); 0 disables.
+    uint32_t silent_every = 0;
+    // Drives real-time pacing and event waits. Defaults to the steady
+    // clock; pass a SimulatedCaptureClock for deterministic scheduling.
+    CaptureClock* clock = nullptr;
+
+    Options();
+  };
+
+  SyntheticCaptureBackend();
+  explicit SyntheticCaptureBackend(const Options& options);
+  ~SyntheticCaptureBackend() override;
+
+  bool Initialize() override;
+  std::vector<AudioDevice> GetInputDevices() override;
+  std::vector<AudioDevice> GetOutputDevices() override;
+  std::unique_ptr<CaptureStream> OpenStream(
+      StreamKind kind, const std::string& device_id,
+      const StreamConfig& config) override;
+
+  const Options& options() const { return options_; }
+
+ private:
+  Options options_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SYNTHETIC_CAPTURE_BACKEND_H_
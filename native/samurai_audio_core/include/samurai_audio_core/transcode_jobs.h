@@ -0,0 +1,164 @@
+#ifndef SAMURAI_AUDIO_CORE_TRANSCODE_JOBS_H_
+#define SAMURAI_AUDIO_CORE_TRANSCODE_JOBS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/audio_codec.h"
+#include "samurai_audio_core/work_stealing_pool.h"
+
+namespace samurai {
+
+struct TranscodeRequest {
+  std::string input_path;   // A WAV file, UTF-8.
+  std::string output_path;  // Replaced only when the job succeeds.
+  EncoderConfig encoder;
+};
+
+enum class JobState {
+  kQueued,
+  kRunning,
+  kSucceeded,
+  kFailed,
+  kCancelled,
+};
+
+// "queued" / "running" / "succeeded" / "failed" / "cancelled".
+const char* JobStateName(JobState state);
+
+struct JobEvent {
+  uint64_t id = 0;
+  JobState state = JobState::kQueued;
+  double progress = 0.0;  // 0..1; 1 once succeeded.
+  std::string error;      // kFailed only.
+
+  // Set for jobs from SubmitBatch(). Progress is weighted by input size and
+  // counts finished jobs as done whatever their outcome; the batch is over
+  // once a terminal event reports batch_pending == 0.
+  uint64_t batch = 0;
+  double batch_progress = 0.0;
+  size_t batch_pending = 0;
+};
+
+using JobEventCallback = std::function<void(const JobEvent&)>;
+
+// Reports the fraction done; repeating a value only polls. Returning false
+// asks the job to stop.
+using TranscodeProgress = std::function<bool(double)>;
+
+// Encodes a WAV file to |request|.output_path in-process. The input is
+// memory-mapped and converted in blocks (to int16, at most two channels,
+// resampled to 48 kHz when the codec has no table for the file's rate),
+// and the output is written to "<output>.part" and renamed into place, so
+// a failed or cancelled job never leaves a truncated file behind. Writes
+// every CodecId in the container AudioFileWriter uses; kPcm gives a 16-bit
+// WAV. Returns false with |error| set on failure or when |progress| asks
+// to stop.
+bool TranscodeWavFile(const TranscodeRequest& request,
+                      const TranscodeProgress& progress, std::string* error);
+
+// Upper bound on the memory TranscodeWavFile() holds for |request|: the
+// resident window of the mapped input, the conversion buffers, the file
+// buffer and the encoder state. Probes the WAV header; an unreadable input
+// costs only the fixed part (the job fails at once anyway).
+size_t TranscodeMemoryEstimate(const TranscodeRequest& request);
+
+// Runs transcode jobs on a work-stealing pool so the platform thread never
+// waits on an encode and a batch of recordings keeps every core busy. Every
+// job reports kQueued, then kRunning with progress, then exactly one
+// terminal state. Jobs start in submission order; with a memory budget set,
+// a job waits in kQueued until the estimates of the running jobs leave
+// room for it.
+class TranscodeJobQueue {
+ public:
+  using Runner = std::function<bool(const TranscodeRequest&,
+                                    const TranscodeProgress&, std::string*)>;
+
+  // |callback| runs on worker threads, and on the caller's thread for
+  // kQueued and for jobs cancelled before they start. Calls are serialized.
+  // It must not call back into the queue. |workers| == 0 uses one per core. |runner| does
+  // the work; tests and platforms without a built-in encoder substitute
+  // their own.
+  TranscodeJobQueue(size_t workers, JobEventCallback callback,
+                    Runner runner = TranscodeWavFile);
+  // Cancels everything outstanding and waits for running jobs to stop.
+  ~TranscodeJobQueue();
+
+  TranscodeJobQueue(const TranscodeJobQueue&) = delete;
+  TranscodeJobQueue& operator=(const TranscodeJobQueue&) = delete;
+
+  // Queues |request| and returns its id (never 0).
+  uint64_t Submit(const TranscodeRequest& request);
+
+  // Queues |requests| as one batch and returns the batch id (never 0), or
+  // 0 for an empty list. Job ids go to |ids| (optional), in order.
+  uint64_t SubmitBatch(const std::vector<TranscodeRequest>& requests,
+                       std::vector<uint64_t>* ids);
+
+  // Cancels a queued or running job. Returns false if |id| is unknown or
+  // already finished. A running job stops at its next progress report.
+  bool Cancel(uint64_t id);
+
+  // Cancels every unfinished job of |batch|. Returns false if none was.
+  bool CancelBatch(uint64_t batch);
+
+  // Caps the summed TranscodeMemoryEstimate() of running jobs; 0 (the
+  // default) is unlimited. A job over the cap on its own still runs, alone.
+  void SetMemoryBudget(size_t bytes);
+
+  // Jobs submitted but not yet finished.
+  size_t outstanding() const;
+
+  size_t workers() const { return pool_->threads(); }
+
+ private:
+  struct Job;
+  struct Batch {
+    double total_weight = 0.0;
+    double done_weight = 0.0;
+    size_t pending = 0;
+  };
+
+  std::shared_ptr<Job> NewJob(const TranscodeRequest& request,
+                              uint64_t batch);
+  // Hands waiting jobs to the pool while the budget allows. Needs mutex_.
+  void AdmitLocked();
+  // Pool task for an admitted job.
+  void Execute(const std::shared_ptr<Job>& job);
+  // Runs |job| and returns its terminal event.
+  JobEvent Run(Job* job);
+  // Takes a finished |job| out of the books and returns its memory. Needs
+  // mutex_.
+  void RetireLocked(Job* job);
+  // Adds the batch fields to |event| and delivers it. Must not be called
+  // with mutex_ held.
+  void Emit(Job* job, JobEvent event);
+
+  JobEventCallback callback_;
+  Runner runner_;
+
+  // Orders deliveries, so a batch's last event really comes last.
+  std::mutex emit_mutex_;
+  std::map<uint64_t, Batch> batches_;  // Unfinished.
+
+  mutable std::mutex mutex_;
+  std::deque<std::shared_ptr<Job>> waiting_;  // Not yet admitted.
+  std::map<uint64_t, std::shared_ptr<Job>> jobs_;  // Unfinished.
+  size_t memory_budget_ = 0;
+  size_t memory_in_use_ = 0;
+  uint64_t next_id_ = 1;
+  uint64_t next_batch_ = 1;
+  bool stopping_ = false;
+  std::unique_ptr<WorkStealingPool> pool_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_TRANSCODE_JOBS_H_
@@ -0,0 +1,119 @@
+#ifndef SAMURAI_AUDIO_CORE_VOICE_ACTIVITY_H_
+#define SAMURAI_AUDIO_CORE_VOICE_ACTIVITY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+enum class VoiceActivity {
+  kSpeech,
+  kSilence,       // Detected by the VAD.
+  kDeviceSilent,  // The device flagged the packet silent (kPacketSilent).
+};
+
+const char* VoiceActivityName(VoiceActivity activity);
+
+// What the capture engine does with packets the VAD classifies as not
+// speech.
+enum class SilencePolicy {
+  kForward,  // Deliver everything, tagged with kPacketNoSpeech.
+  kDrop,     // Deliver speech only.
+  kMarkers,  // Replace each silence run with kPacketSilenceMarker packets
+             // that carry a frame count and no samples.
+};
+
+// "forward" / "drop" / "markers", as used on the platform channel.
+const char* SilencePolicyName(SilencePolicy policy);
+
+// Parses a policy name. Returns false (leaving |policy| alone) for unknown
+// names.
+bool ParseSilencePolicy(const std::string& name, SilencePolicy* policy);
+
+struct VadConfig {
+  // Analysis window. Speech decisions are made once per window.
+  uint32_t window_ms = 10;
+  // Windows quieter than this (dBFS RMS) are never speech.
+  float threshold_db = -50.0f;
+  // Speech must also stand this far above the tracked noise floor.
+  float margin_db = 10.0f;
+  // Loud windows crossing zero more often than this (per sample and
+  // channel) are broadband noise rather than voiced speech.
+  float max_zero_crossing_rate = 0.35f;
+  // How long output stays "speech" after the last speech window, so word
+  // gaps and unvoiced endings are not clipped.
+  uint32_t hangover_ms = 300;
+  // How fast the noise floor may rise during non-speech, in dB/s. It
+  // drops immediately to any quieter window.
+  float floor_rise_db_per_second = 5.0f;
+};
+
+// Window energy and zero-crossing kernels; all implementations agree to
+// within float rounding.
+enum class VadImpl {
+  kScalar,
+  kSse2,
+  kAvx2,
+  kNeon,
+};
+
+const char* VadImplName(VadImpl impl);
+bool VadImplSupported(VadImpl impl);
+VadImpl VadBestImpl();
+
+// Energy + zero-crossing-rate voice activity detector with an adaptive
+// noise floor and hangover, for interleaved int16 or float packets.
+// Windows carry across packet boundaries.
+class VoiceActivityDetector {
+ public:
+  VoiceActivityDetector(const AudioFormat& format, const VadConfig& config);
+  VoiceActivityDetector(const AudioFormat& format, const VadConfig& config,
+                        VadImpl impl);
+
+  // False for sample types other than kInt16/kFloat32 or an unavailable
+  // |impl|.
+  bool IsValid() const { return valid_; }
+
+  // Classifies one packet of |frames| frames. |flags| are the packet's
+  // PacketFlags; kPacketSilent packets are not analysed. A packet is
+  // speech if any window completed in it was, or the hangover is running.
+  VoiceActivity Process(const uint8_t* data, uint32_t frames, uint32_t flags);
+
+  // Measurements of the last completed window.
+  float last_energy_db() const { return last_energy_db_; }
+  float last_zero_crossing_rate() const { return last_zcr_; }
+  float noise_floor_db() const { return noise_floor_db_; }
+
+  void Reset();
+
+ private:
+  // Folds samples into the open window, closing it when full.
+  bool AnalyzeWindows(const uint8_t* data, uint32_t frames);
+  bool CloseWindow();
+
+  AudioFormat format_;
+  VadConfig config_;
+  VadImpl impl_;
+  bool valid_ = false;
+  uint32_t window_frames_ = 0;
+  uint32_t hangover_frames_ = 0;
+  float floor_rise_per_window_ = 0.0f;
+
+  // Open window.
+  double energy_ = 0.0;
+  uint64_t crossings_ = 0;
+  uint64_t crossing_pairs_ = 0;
+  uint32_t frames_in_window_ = 0;
+
+  uint32_t hangover_left_ = 0;
+  float noise_floor_db_ = -120.0f;
+  float last_energy_db_ = -120.0f;
+  float last_zcr_ = 0.0f;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_VOICE_ACTIVITY_H_
@@ -0,0 +1,41 @@
+#ifndef SAMURAI_AUDIO_CORE_WAV_READER_H_
+#define SAMURAI_AUDIO_CORE_WAV_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "samurai_audio_core/audio_format.h"
+#include "samurai_audio_core/mapped_file.h"
+
+namespace samurai {
+
+// Memory-mapped RIFF/WAVE reader for PCM and IEEE float files, including
+// WAVE_FORMAT_EXTENSIBLE. Samples are read in place from the mapping.
+class WavReader {
+ public:
+  // Maps and parses |path|. Returns false for unreadable files, other
+  // codecs and malformed headers. A data chunk that runs past the end of
+  // the file (a recording that was never finalized) is truncated to the
+  // whole frames present.
+  bool Open(const std::string& path);
+
+  const AudioFormat& format() const { return format_; }
+  uint64_t frames() const { return frames_; }
+
+  // Interleaved frames [0, frames()).
+  const uint8_t* samples() const { return samples_; }
+
+  // Tells the mapping frames before |frame| will not be read again.
+  void ReleaseBefore(uint64_t frame) const;
+
+ private:
+  MappedFile file_;
+  AudioFormat format_;
+  const uint8_t* samples_ = nullptr;
+  uint64_t frames_ = 0;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_WAV_READER_H_
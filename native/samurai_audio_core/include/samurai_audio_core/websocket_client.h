@@ -0,0 +1,105 @@
+#ifndef SAMURAI_AUDIO_CORE_WEBSOCKET_CLIENT_H_
+#define SAMURAI_AUDIO_CORE_WEBSOCKET_CLIENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace samurai {
+
+// A parsed "ws://host[:port][/path]" URL. TLS (wss://) is not supported.
+struct WebSocketUrl {
+  std::string host;
+  uint16_t port = 80;
+  std::string path = "/";  // Includes any query string.
+};
+
+// Returns false for other schemes, an empty host or a bad port.
+bool ParseWebSocketUrl(const std::string& url, WebSocketUrl* parsed);
+
+// True for localhost, 127.0.0.0/8 and ::1: hosts that traffic on a plain
+// ws:// connection never leaves the machine to reach.
+bool IsLoopbackHost(const std::string& host);
+
+// The Sec-WebSocket-Accept value a server must answer |key| with:
+// base64(SHA-1(key + the RFC 6455 GUID)).
+std::string WebSocketAcceptKey(const std::string& key);
+
+enum class WebSocketOpcode : uint8_t {
+  kContinuation = 0x0,
+  kText = 0x1,
+  kBinary = 0x2,
+  kClose = 0x8,
+  kPing = 0x9,
+  kPong = 0xA,
+};
+
+// Blocking RFC 6455 client over plain TCP. Sends are unfragmented, masked
+// frames built in one buffer and written with one call; Read() reassembles
+// fragmented messages and answers pings and closes itself. Not thread-safe:
+// one thread owns the client, interleaving sends with Read(0) to service
+// control frames.
+class WebSocketClient {
+ public:
+  enum class ReadResult {
+    kMessage,  // |opcode| is kText or kBinary.
+    kTimeout,
+    kClosed,   // By the peer or on error; the client is closed.
+  };
+
+  WebSocketClient();
+  ~WebSocketClient();
+
+  WebSocketClient(const WebSocketClient&) = delete;
+  WebSocketClient& operator=(const WebSocketClient&) = delete;
+
+  // Connects and completes the opening handshake within |timeout_ms|.
+  // |headers| are extra request header lines without the CRLF, e.g.
+  // "Authorization: Bearer <token>". Returns false with |error| set.
+  bool Connect(const std::string& url, const std::vector<std::string>& headers,
+               int timeout_ms, std::string* error);
+
+  bool SendText(const std::string& text);
+  bool SendBinary(const uint8_t* data, size_t size);
+  bool SendPing();
+
+  // Waits up to |timeout_ms| (0 polls) for the next data message.
+  ReadResult Read(int timeout_ms, WebSocketOpcode* opcode,
+                  std::vector<uint8_t>* payload);
+
+  // Sends a close frame with |code| if still open, then drops the
+  // connection without waiting for the reply.
+  void Close(uint16_t code = 1000);
+
+  bool is_open() const { return socket_ != kNoSocket; }
+
+  // Bytes written to the socket, frame headers included.
+  uint64_t bytes_sent() const { return bytes_sent_; }
+
+ private:
+  static constexpr intptr_t kNoSocket = -1;
+
+  bool SendFrame(WebSocketOpcode opcode, const uint8_t* data, size_t size);
+  bool WriteAll(const uint8_t* data, size_t size);
+  // Reads until |size| unconsumed bytes are buffered, waiting at most
+  // |timeout_ms| for each read. Returns false on timeout or error, with
+  // |timed_out| telling which; nothing buffered is lost either way.
+  bool Fill(size_t size, int timeout_ms, bool* timed_out);
+  void Consume(size_t size);
+  void Drop();
+
+  intptr_t socket_ = kNoSocket;
+  uint32_t mask_state_;  // xorshift state for frame masks.
+  uint64_t bytes_sent_ = 0;
+
+  std::vector<uint8_t> frame_;   // Outgoing frame scratch.
+  std::vector<uint8_t> input_;   // Received, not yet consumed.
+  size_t input_offset_ = 0;
+  std::vector<uint8_t> message_;  // Fragments so far.
+  WebSocketOpcode message_opcode_ = WebSocketOpcode::kBinary;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_WEBSOCKET_CLIENT_H_
@@ -0,0 +1,272 @@
+#ifndef SAMURAI_AUDIO_CORE_WEBSOCKET_SINK_H_
+#define SAMURAI_AUDIO_CORE_WEBSOCKET_SINK_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/echo_canceller.h"
+#include "samurai_audio_core/frame_pool.h"
+#include "samurai_audio_core/spill_log.h"
+#include "samurai_audio_core/stream_aligner.h"
+#include "samurai_audio_core/websocket_client.h"
+
+namespace samurai {
+
+struct WebSocketSinkConfig {
+  std::string url;         // ws://host[:port]/path
+  // Sent as "Authorization: Bearer <token>". Without TLS it would cross
+  // the network in the clear, so a sink with a token only starts for a
+  // loopback host, e.g. a local proxy that terminates TLS.
+  std::string auth_token;
+  // Messages waiting for the socket, e.g. across a reconnect, bounded by
+  // bytes and by the audio they hold (0: no duration bound). Beyond either
+  // the oldest are dropped, so a dead server costs bounded memory.
+  // Messages are encoded into a pool sized from this and the first
+  // message, so a steady stream allocates nothing.
+  size_t max_queued_bytes = 1 << 20;
+  uint32_t max_queued_ms = 10000;
+  // Make Deliver() wait for room instead of dropping, until Stop(). Meant
+  // for a sink fed by a PacketFanOut, whose queue then fills and applies
+  // its BackpressurePolicy.
+  bool block_when_full = false;
+  // With spill.directory set, messages go to a SpillLog instead, from the
+  // moment the link drops or the queue is full until the log has been
+  // replayed: an outage costs disk, up to spill.max_bytes, not audio.
+  // What is left in the log at Stop() is replayed by the next sink
+  // started on the directory.
+  SpillLogConfig spill;
+  // Replay pace as a multiple of real time, by the audio the messages
+  // hold; new audio waits behind the backlog, which is caught up at
+  // replay_speed - 1 times real time. 0: as fast as the socket takes it.
+  float replay_speed = 4.0f;
+  int connect_timeout_ms = 5000;
+  // Reconnect backoff, doubling from min to max.
+  uint32_t reconnect_min_ms = 250;
+  uint32_t reconnect_max_ms = 5000;
+  // How often a connected sink reports its counters.
+  uint32_t stats_interval_ms = 1000;
+  // Send the system and microphone streams as one time-aligned stereo
+  // stream (StreamAligner) instead of two. Packets it cannot align, such
+  // as encoded ones, still go out on their own.
+  bool align_streams = false;
+  StreamAlignerConfig aligner;
+  // With align_streams, remove the customer's voice, picked up by the
+  // agent's microphone from the loudspeaker, from the agent channel,
+  // using the time-aligned customer channel as the reference. Runs on the
+  // delivering thread within echo.cpu_budget_percent. Needs PCM int16 or
+  // float aligned packets whose frame count has a power-of-two factor of
+  // at least 16 (20 ms at 16 or 48 kHz does; at 44.1 kHz nothing does);
+  // other packets pass through.
+  bool cancel_echo = false;
+  EchoCancellerConfig echo;
+};
+
+enum class WebSocketSinkState {
+  kConnecting,    // First attempt.
+  kConnected,
+  kReconnecting,  // Waiting out the backoff after a failure or drop.
+  kStopped,
+};
+
+// "connecting" / "connected" / "reconnecting" / "stopped".
+const char* WebSocketSinkStateName(WebSocketSinkState state);
+
+struct WebSocketSinkStats {
+  uint64_t messages_sent = 0;
+  uint64_t bytes_sent = 0;        // On the socket, framing included.
+  uint64_t messages_dropped = 0;  // Evicted from a full queue.
+  // With block_when_full, messages Deliver() waited for room for.
+  uint64_t messages_blocked = 0;
+  uint64_t messages_received = 0;
+  uint64_t reconnects = 0;        // Connections after the first.
+  // Waiting right now, and the most ever waiting.
+  uint64_t queued_bytes = 0;
+  uint32_t queued_ms = 0;
+  uint64_t high_water_bytes = 0;
+  uint32_t high_water_ms = 0;
+  // With spilling, messages written to the log and sent from it, those
+  // lost to its disk bound or a failed write, and what waits in it.
+  uint64_t messages_spilled = 0;
+  uint64_t messages_replayed = 0;
+  uint64_t spill_dropped = 0;
+  uint64_t spill_queued_bytes = 0;
+  uint32_t spill_queued_ms = 0;
+  uint64_t spill_disk_bytes = 0;
+  uint64_t max_send_ns = 0;       // Slowest single message write.
+  // With align_streams, frames of either stream filled with silence or
+  // dropped as too late to align (StreamAlignerStats, both streams).
+  uint64_t aligned_filled_frames = 0;
+  uint64_t aligned_late_frames = 0;
+  // With cancel_echo, agent-channel frames cancelled and passed through
+  // (over the CPU budget or not cancellable), the canceller's CPU time and
+  // its current echo return loss enhancement.
+  uint64_t echo_processed_frames = 0;
+  uint64_t echo_bypassed_frames = 0;
+  uint64_t echo_cpu_ns = 0;
+  double echo_erle_db = 0.0;
+};
+
+struct WebSocketSinkEvent {
+  WebSocketSinkState state = WebSocketSinkState::kConnecting;
+  std::string error;  // Why the last attempt failed or the link dropped.
+  WebSocketSinkStats stats;
+};
+
+using WebSocketSinkCallback = std::function<void(const WebSocketSinkEvent&)>;
+
+// Streams delivered capture packets to a WebSocket server on a native
+// thread. Deliver() encodes a packet as one binary frame (frame_protocol.h)
+// and queues it; the network thread connects, reconnects with backoff,
+// writes each frame as one binary message and services pings. Nothing on
+// the audio path waits on the network.
+class WebSocketSink {
+ public:
+  // |callback| runs on the network thread on every state change and every
+  // stats_interval_ms while connected.
+  WebSocketSink(WebSocketSinkConfig config, WebSocketSinkCallback callback);
+  // Stop()s.
+  ~WebSocketSink();
+
+  WebSocketSink(const WebSocketSink&) = delete;
+  WebSocketSink& operator=(const WebSocketSink&) = delete;
+
+  // Opens the spill log if configured and starts the network thread.
+  // Returns false for a malformed URL, or for an auth_token with a host
+  // that is not loopback (IsLoopbackHost). A log that cannot be opened leaves
+  // the sink without one and is reported with the first event.
+  bool Start();
+
+  // Sends what is already queued if connected, closes the connection and
+  // joins the network thread. With a spill log, what is left queued, such
+  // as messages a drop sent back, is appended to it ahead of the messages
+  // it already holds, and the log is closed with everything unreplayed
+  // kept for the next sink on the directory. With align_streams the
+  // aligner is flushed first, so deliveries must have stopped.
+  void Stop();
+
+  // Encodes and queues |packet|, through the aligner with align_streams.
+  // Called on capture delivery threads.
+  void Deliver(const AudioPacket& packet);
+
+  WebSocketSinkStats stats() const;
+
+ private:
+  // Aligner output: cancels the echo if configured, then Enqueue()s.
+  void EnqueueAligned(const AudioPacket& packet);
+  void Enqueue(const AudioPacket& packet);
+  // Queues an encoded frame holding |ns| of audio, evicting the oldest
+  // past the bounds or, with block_when_full, waiting for room. Spills it
+  // instead while the link is down, the queue is full or the log is
+  // being replayed.
+  void QueueMessage(FrameRef message, uint64_t ns);
+  // Under |spill_mutex_| and |mutex_|.
+  void UpdateSpillStats();
+  // Moves what is left queued into the log, ahead of its records, once
+  // the network thread has exited. Under |spill_mutex_|.
+  void SpillQueue();
+  // Whether a message fits the bounds as they stand. Under |mutex_|.
+  bool QueueFits(size_t bytes, uint64_t ns) const;
+  // Evicts the oldest messages past the bounds. Under |mutex_|.
+  void TrimQueue();
+  // Under |mutex_|.
+  void UpdateQueueStats();
+  // A unique frame of at least |size| bytes: pooled, or from the heap for
+  // sizes beyond the pool or when every pooled frame is queued.
+  FrameRef NewMessage(size_t size);
+  void UpdateAlignerStats();
+  void Run();
+  // Sends queued messages and services the socket until the link drops or
+  // Stop() is called. Returns false with |error| set on a drop.
+  bool Pump(std::string* error);
+  // Sends spilled messages while the pace allows, |replayed_ns| of audio
+  // having been sent since |start|; lowers |wait| to when the next one is
+  // due. Returns false with |error| set on a drop.
+  bool Replay(std::chrono::steady_clock::time_point* start,
+              uint64_t* replayed_ns, std::chrono::nanoseconds* wait,
+              std::string* error);
+  void Emit(WebSocketSinkState state, const std::string& error);
+  // Waits up to |ms| for Stop(). Returns true if stopping.
+  bool WaitForStop(uint32_t ms);
+
+  WebSocketSinkConfig config_;
+  WebSocketSinkCallback callback_;
+  WebSocketClient client_;  // Network thread only.
+
+  // Taken before |spill_mutex_| and |mutex_| when held together.
+  std::mutex aligner_mutex_;
+  StreamAligner aligner_;
+  // Created for the first cancellable aligned packet; its format and
+  // block size then stay fixed.
+  std::unique_ptr<EchoCanceller> echo_canceller_;
+  bool echo_checked_ = false;
+  uint64_t echo_passed_frames_ = 0;
+  std::vector<float> echo_far_;
+  std::vector<float> echo_near_;
+
+  // Taken before |mutex_| when both are held.
+  std::mutex spill_mutex_;
+  // Set by Start() if configured and the log opened, reset by Stop().
+  std::unique_ptr<SpillLog> spill_;
+  // Messages go to |spill_| until the network thread finds it empty. The
+  // queue then holds nothing newer than the log, so it is sent first.
+  bool spilling_ = false;
+  std::vector<uint8_t> replay_message_;  // Network thread, then Stop().
+  std::string spill_error_;              // For the first event.
+  uint64_t spill_failures_ = 0;          // Failed appends. Under |mutex_|.
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  // Wakes a Deliver() waiting for room with block_when_full.
+  std::condition_variable room_cv_;
+  // Encoded frames, oldest first, with the audio each holds. Circular and
+  // grown by doubling; a steady stream never grows it.
+  class MessageQueue {
+   public:
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+    size_t bytes() const { return bytes_; }
+    uint64_t ns() const { return ns_; }
+    FrameRef& front() { return messages_[head_].frame; }
+    uint64_t front_ns() const { return messages_[head_].ns; }
+    void push_back(FrameRef message, uint64_t ns);
+    void pop_front();
+    void swap(MessageQueue& other);
+
+   private:
+    struct Message {
+      FrameRef frame;
+      uint64_t ns = 0;
+    };
+
+    void Grow();
+
+    std::vector<Message> messages_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t bytes_ = 0;
+    uint64_t ns_ = 0;
+  };
+
+  MessageQueue queue_;
+  std::unique_ptr<FramePool> message_pool_;  // Created by NewMessage().
+  WebSocketSinkStats stats_;
+  // Set first thing by Stop(), so no Deliver() keeps waiting for room.
+  bool releasing_ = false;
+  // From a failed attempt or drop until the next connection.
+  bool link_down_ = false;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_WEBSOCKET_SINK_H_
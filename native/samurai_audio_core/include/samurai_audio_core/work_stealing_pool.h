@@ -0,0 +1,69 @@
+#ifndef SAMURAI_AUDIO_CORE_WORK_STEALING_POOL_H_
+#define SAMURAI_AUDIO_CORE_WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace samurai {
+
+// Fixed-size thread pool with one task deque per worker. A worker runs its
+// own tasks oldest first and, when it runs dry, steals the oldest task of
+// another worker, so a few long tasks never leave the other cores idle
+// behind them. Tasks submitted from outside the pool are dealt round-robin;
+// tasks submitted from a worker stay on that worker's deque. Tasks start
+// in submission order when there is a single worker.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  // |threads| == 0 sizes the pool to the core count.
+  explicit WorkStealingPool(size_t threads);
+  // Runs every task already submitted, then joins the workers.
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  // Queues |task|. Must not be called once destruction has begun, except
+  // from a task.
+  void Submit(Task task);
+
+  size_t threads() const { return threads_.size(); }
+
+  // Tasks run by a worker other than the one they were queued on.
+  uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+ private:
+  struct TaskDeque {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(size_t index);
+  // Takes a task from worker |index|'s own deque, else steals one.
+  bool Take(size_t index, Task* task);
+
+  std::vector<std::unique_ptr<TaskDeque>> deques_;
+  std::atomic<size_t> next_deque_{0};
+  std::atomic<uint64_t> steals_{0};
+
+  // Tasks queued and not yet claimed by a worker.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t unclaimed_ = 0;
+  bool stopping_ = false;
+
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_WORK_STEALING_POOL_H_
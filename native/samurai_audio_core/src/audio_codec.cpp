@@ -0,0 +1,220 @@
+#include "samurai_audio_core/audio_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "audio_codec_internal.h"
+#include "samurai_audio_core/capture_backend.h"
+
+namespace samurai {
+
+namespace {
+
+// Fixed-size frames of the input PCM, unchanged. Lets consumers that want
+// uniform packets share the encoder path.
+class PcmEncoder : public AudioEncoder {
+ public:
+  PcmEncoder(const EncoderConfig& config, const AudioFormat& format)
+      : config_(config),
+        format_(format),
+        frame_size_(std::max<uint32_t>(
+            1, FramesForDuration(format, config.frame_ms))) {}
+
+  const EncoderConfig& config() const override { return config_; }
+  const AudioFormat& input_format() const override { return format_; }
+  std::string MimeType() const override {
+    return CodecMimeType(CodecId::kPcm, format_);
+  }
+  uint32_t frame_size() const override { return frame_size_; }
+  size_t max_packet_bytes() const override {
+    return static_cast<size_t>(frame_size_) * format_.BlockAlign();
+  }
+
+  size_t Encode(const uint8_t* pcm, uint8_t* out) override {
+    const size_t bytes = max_packet_bytes();
+    std::memcpy(out, pcm, bytes);
+    return bytes;
+  }
+
+ private:
+  EncoderConfig config_;
+  AudioFormat format_;
+  uint32_t frame_size_;
+};
+
+}  // namespace
+
+const char* CodecName(CodecId codec) {
+  switch (codec) {
+    case CodecId::kPcm:
+      return "pcm";
+    case CodecId::kOpus:
+      return "opus";
+    case CodecId::kMp3:
+      return "mp3";
+  }
+  return "unknown";
+}
+
+bool ParseCodecId(const std::string& name, CodecId* codec) {
+  for (CodecId candidate : {CodecId::kPcm, CodecId::kOpus, CodecId::kMp3}) {
+    if (name == CodecName(candidate)) {
+      *codec = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string CodecMimeType(CodecId codec, const AudioFormat& format) {
+  switch (codec) {
+    case CodecId::kPcm:
+      break;
+    case CodecId::kOpus:
+      return "audio/opus;rate=" + std::to_string(format.sample_rate) +
+             ";channels=" + std::to_string(format.channels);
+    case CodecId::kMp3:
+      return "audio/mpeg";
+  }
+  return PcmMimeType(format);
+}
+
+bool AudioCodecAvailable(CodecId codec) {
+  switch (codec) {
+    case CodecId::kPcm:
+      return true;
+    case CodecId::kOpus:
+#if defined(SAMURAI_HAVE_OPUS)
+      return true;
+#else
+      return false;
+#endif
+    case CodecId::kMp3:
+#if defined(SAMURAI_HAVE_LAME)
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+const char* OpusApplicationName(OpusApplication application) {
+  switch (application) {
+    case OpusApplication::kVoip:
+      return "voip";
+    case OpusApplication::kAudio:
+      return "audio";
+  }
+  return "unknown";
+}
+
+bool ParseOpusApplication(const std::string& name,
+                          OpusApplication* application) {
+  for (OpusApplication candidate :
+       {OpusApplication::kVoip, OpusApplication::kAudio}) {
+    if (name == OpusApplicationName(candidate)) {
+      *application = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<AudioEncoder> CreateAudioEncoder(const EncoderConfig& config,
+                                                 const AudioFormat& format) {
+  if (!format.IsValid() || (format.sample_type != SampleType::kInt16 &&
+                            format.sample_type != SampleType::kFloat32)) {
+    return nullptr;
+  }
+  switch (config.codec) {
+    case CodecId::kPcm:
+      return std::unique_ptr<AudioEncoder>(new PcmEncoder(config, format));
+    case CodecId::kOpus:
+#if defined(SAMURAI_HAVE_OPUS)
+      return internal::CreateOpusEncoder(config, format);
+#else
+      break;
+#endif
+    case CodecId::kMp3:
+#if defined(SAMURAI_HAVE_LAME)
+      return internal::CreateLameEncoder(config, format);
+#else
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+EncoderStage::EncoderStage(std::unique_ptr<AudioEncoder> encoder)
+    : encoder_(std::move(encoder)),
+      block_align_(encoder_->input_format().BlockAlign()),
+      frame_(static_cast<size_t>(encoder_->frame_size()) * block_align_),
+      packet_(encoder_->max_packet_bytes()) {}
+
+void EncoderStage::Push(const uint8_t* pcm, uint32_t frames, uint32_t flags,
+                        const Output& output) {
+  if (flags & kPacketSilenceMarker) {
+    const uint32_t padding = buffered_ > 0 ? EmitPadded(output) : 0;
+    if (frames > padding) {
+      output(nullptr, 0, frames - padding, flags);
+    }
+    return;
+  }
+
+  flags_ |= flags;
+
+  const uint32_t frame_size = encoder_->frame_size();
+  while (frames > 0) {
+    const uint32_t chunk = std::min(frames, frame_size - buffered_);
+    const size_t bytes = static_cast<size_t>(chunk) * block_align_;
+    std::memcpy(frame_.data() + static_cast<size_t>(buffered_) * block_align_,
+                pcm, bytes);
+    buffered_ += chunk;
+    pcm += bytes;
+    frames -= chunk;
+    if (buffered_ == frame_size) {
+      EmitFrame(output);
+    }
+  }
+}
+
+void EncoderStage::Flush(const Output& output) {
+  if (buffered_ > 0) {
+    EmitPadded(output);
+  }
+  const size_t size = encoder_->Finish(packet_.data());
+  if (size > 0) {
+    output(packet_.data(), size, held_, flags_);
+  }
+  held_ = 0;
+  flags_ = 0;
+}
+
+uint32_t EncoderStage::EmitPadded(const Output& output) {
+  const uint32_t padding = encoder_->frame_size() - buffered_;
+  std::memset(frame_.data() + static_cast<size_t>(buffered_) * block_align_,
+              0, static_cast<size_t>(padding) * block_align_);
+  buffered_ = encoder_->frame_size();
+  EmitFrame(output);
+  return padding;
+}
+
+void EncoderStage::EmitFrame(const Output& output) {
+  const size_t size = encoder_->Encode(frame_.data(), packet_.data());
+  if (size == AudioEncoder::kEncodeFailed) {
+    ++failures_;
+  } else if (size == 0) {
+    held_ += buffered_;
+    buffered_ = 0;
+    return;
+  } else {
+    output(packet_.data(), size, held_ + buffered_, flags_);
+  }
+  held_ = 0;
+  buffered_ = 0;
+  flags_ = 0;
+}
+
+}  // namespace samurai
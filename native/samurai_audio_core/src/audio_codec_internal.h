@@ -0,0 +1,22 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_AUDIO_CODEC_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_AUDIO_CODEC_INTERNAL_H_
+
+#include <memory>
+
+#include "samurai_audio_core/audio_codec.h"
+
+namespace samurai {
+namespace internal {
+
+// Defined in opus_encoder.cpp, which is only built with SAMURAI_HAVE_OPUS.
+std::unique_ptr<AudioEncoder> CreateOpusEncoder(const EncoderConfig& config,
+                                                const AudioFormat& format);
+
+// Defined in lame_encoder.cpp, which is only built with SAMURAI_HAVE_LAME.
+std::unique_ptr<AudioEncoder> CreateLameEncoder(const EncoderConfig& config,
+                                                const AudioFormat& format);
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_AUDIO_CODEC_INTERNAL_H_
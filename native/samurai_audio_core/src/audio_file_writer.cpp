@@ -0,0 +1,275 @@
+#include "samurai_audio_core/audio_file_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <utility>
+
+#include "ogg_muxer_internal.h"
+
+namespace samurai {
+
+namespace {
+
+// Enough for ~0.4 s of 48 kHz stereo int16 per write() call.
+constexpr size_t kFileBufferBytes = 64 * 1024;
+
+constexpr uint16_t kWaveFormatPcm = 0x0001;
+constexpr uint16_t kWaveFormatIeeeFloat = 0x0003;
+constexpr size_t kWavHeaderBytes = 44;
+
+// Opus always counts granules at 48 kHz. 312 is libopus's encoder
+// lookahead (2.5 ms + 4 ms delay compensation) at every supported rate.
+constexpr uint32_t kOpusGranuleRate = 48000;
+constexpr uint16_t kOpusPreSkip = 312;
+constexpr char kOpusVendor[] = "samurai_audio_core";
+
+void PutU16(uint8_t* p, uint16_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void PutU32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<uint8_t>(v >> (8 * i));
+  }
+}
+
+}  // namespace
+
+const char* AudioFileExtension(CodecId codec) {
+  switch (codec) {
+    case CodecId::kPcm:
+      return "wav";
+    case CodecId::kOpus:
+      return "opus";
+    case CodecId::kMp3:
+      return "mp3";
+  }
+  return "bin";
+}
+
+AudioFileWriter::AudioFileWriter()
+    : on_packet_([this](const uint8_t* data, size_t size, uint32_t frames,
+                        uint32_t) {
+        encoded_frames_ += frames;
+        if (ogg_) {
+          ogg_->AddPacket(data, size, OpusGranule(encoded_frames_));
+        } else {
+          WriteBytes(data, size);
+        }
+      }) {}
+
+AudioFileWriter::~AudioFileWriter() { Close(); }
+
+bool AudioFileWriter::Open(const std::string& path,
+                           const EncoderConfig& config,
+                           const AudioFormat& format) {
+  if (config.codec == CodecId::kPcm) {
+    Close();
+    if (!format.IsValid() || !OpenFile(path)) {
+      return false;
+    }
+    codec_ = CodecId::kPcm;
+    format_ = format;
+    WriteWavHeader(false);
+    return !failed_;
+  }
+  std::unique_ptr<AudioEncoder> encoder = CreateAudioEncoder(config, format);
+  return encoder && Open(path, std::move(encoder));
+}
+
+bool AudioFileWriter::Open(const std::string& path,
+                           std::unique_ptr<AudioEncoder> encoder) {
+  if (encoder && encoder->config().codec == CodecId::kPcm) {
+    return Open(path, encoder->config(), encoder->input_format());
+  }
+  Close();
+  if (!encoder || !OpenFile(path)) {
+    return false;
+  }
+  codec_ = encoder->config().codec;
+  format_ = encoder->input_format();
+  stage_.reset(new EncoderStage(std::move(encoder)));
+  if (codec_ == CodecId::kOpus) {
+    // Any serial works for a single-stream file; vary it per file so
+    // concatenated recordings stay distinct streams.
+    const uint32_t serial = static_cast<uint32_t>(
+        std::hash<std::string>()(path) ^ reinterpret_cast<uintptr_t>(this));
+    ogg_.reset(new internal::OggMuxer(
+        serial, [this](const uint8_t* page, size_t size) {
+          WriteBytes(page, size);
+        }));
+    WriteOpusHeaders();
+  }
+  return !failed_;
+}
+
+bool AudioFileWriter::OpenFile(const std::string& path) {
+  file_buffer_.resize(kFileBufferBytes);
+  file_.rdbuf()->pubsetbuf(file_buffer_.data(),
+                           static_cast<std::streamsize>(file_buffer_.size()));
+  file_.open(std::filesystem::u8path(path),
+             std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!file_) {
+    file_.clear();
+    return false;
+  }
+  open_ = true;
+  failed_ = false;
+  frames_ = 0;
+  encoded_frames_ = 0;
+  bytes_ = 0;
+  return true;
+}
+
+bool AudioFileWriter::Write(const uint8_t* pcm, uint32_t frames) {
+  if (!open_ || failed_) {
+    return false;
+  }
+  const uint32_t block_align = format_.BlockAlign();
+  if (!pcm) {
+    // Silence in bounded chunks; the buffer is sized once.
+    const uint32_t chunk = std::max<uint32_t>(
+        1, FramesForDuration(format_, 100));
+    zeros_.resize(static_cast<size_t>(chunk) * block_align);
+    while (frames > 0) {
+      const uint32_t n = std::min(frames, chunk);
+      if (!Write(zeros_.data(), n)) {
+        return false;
+      }
+      frames -= n;
+    }
+    return true;
+  }
+  frames_ += frames;
+  if (stage_) {
+    stage_->Push(pcm, frames, 0, on_packet_);
+  } else {
+    WriteBytes(pcm, static_cast<size_t>(frames) * block_align);
+  }
+  return !failed_;
+}
+
+bool AudioFileWriter::Close() {
+  if (!open_) {
+    return false;
+  }
+  if (stage_) {
+    stage_->Flush(on_packet_);
+    if (stage_->failures() > 0) {
+      failed_ = true;
+    }
+  }
+  if (ogg_) {
+    // The last page's granule trims the padding of the final frame.
+    ogg_->Finish(OpusGranule(frames_));
+  }
+  if (codec_ == CodecId::kPcm) {
+    WriteWavHeader(true);
+  }
+  file_.close();
+  if (!file_) {
+    failed_ = true;
+  }
+  file_.clear();
+  stage_.reset();
+  ogg_.reset();
+  open_ = false;
+  return !failed_;
+}
+
+std::string AudioFileWriter::MimeType() const {
+  switch (codec_) {
+    case CodecId::kPcm:
+      return "audio/wav";
+    case CodecId::kOpus:
+      return "audio/ogg;codecs=opus";
+    case CodecId::kMp3:
+      return "audio/mpeg";
+  }
+  return "application/octet-stream";
+}
+
+void AudioFileWriter::WriteBytes(const uint8_t* data, size_t size) {
+  file_.write(reinterpret_cast<const char*>(data),
+              static_cast<std::streamsize>(size));
+  if (!file_) {
+    failed_ = true;
+  }
+  bytes_ += size;
+}
+
+void AudioFileWriter::WriteWavHeader(bool finalize) {
+  // Sizes stay 0 while recording, and at the "unknown" 0xFFFFFFFF past
+  // 4 GiB; WavReader and most players then read to the end of the file.
+  uint32_t riff_bytes = 0;
+  uint32_t data_bytes = 0;
+  if (finalize) {
+    const uint64_t data = bytes_ - kWavHeaderBytes;
+    const bool fits = data <= 0xFFFFFFFFu - kWavHeaderBytes;
+    data_bytes = fits ? static_cast<uint32_t>(data) : 0xFFFFFFFFu;
+    riff_bytes = fits ? static_cast<uint32_t>(data + kWavHeaderBytes - 8)
+                      : 0xFFFFFFFFu;
+  }
+  uint8_t header[kWavHeaderBytes];
+  std::memcpy(header, "RIFF", 4);
+  PutU32(header + 4, riff_bytes);
+  std::memcpy(header + 8, "WAVEfmt ", 8);
+  PutU32(header + 16, 16);
+  PutU16(header + 20, format_.sample_type == SampleType::kFloat32
+                          ? kWaveFormatIeeeFloat
+                          : kWaveFormatPcm);
+  PutU16(header + 22, format_.channels);
+  PutU32(header + 24, format_.sample_rate);
+  PutU32(header + 28, format_.BytesPerSecond());
+  PutU16(header + 32, static_cast<uint16_t>(format_.BlockAlign()));
+  PutU16(header + 34, format_.BitsPerSample());
+  std::memcpy(header + 36, "data", 4);
+  PutU32(header + 40, data_bytes);
+
+  if (!finalize) {
+    WriteBytes(header, sizeof(header));
+    return;
+  }
+  // Finalizing: two fixed-offset patches, whatever the length.
+  const std::streampos end = file_.tellp();
+  file_.seekp(0);
+  file_.write(reinterpret_cast<const char*>(header), sizeof(header));
+  file_.seekp(end);
+  if (!file_) {
+    failed_ = true;
+  }
+}
+
+void AudioFileWriter::WriteOpusHeaders() {
+  // RFC 7845 5.1: identification header, alone on the first page.
+  uint8_t head[19];
+  std::memcpy(head, "OpusHead", 8);
+  head[8] = 1;  // Version.
+  head[9] = static_cast<uint8_t>(format_.channels);
+  PutU16(head + 10, kOpusPreSkip);
+  PutU32(head + 12, format_.sample_rate);
+  PutU16(head + 16, 0);  // Output gain.
+  head[18] = 0;          // Mapping family 0: mono or stereo.
+  ogg_->AddPacket(head, sizeof(head), 0);
+  ogg_->Flush();
+
+  // 5.2: comment header with the vendor string and no tags.
+  const uint32_t vendor = sizeof(kOpusVendor) - 1;
+  std::vector<uint8_t> tags(8 + 4 + vendor + 4);
+  std::memcpy(tags.data(), "OpusTags", 8);
+  PutU32(tags.data() + 8, vendor);
+  std::memcpy(tags.data() + 12, kOpusVendor, vendor);
+  PutU32(tags.data() + 12 + vendor, 0);
+  ogg_->AddPacket(tags.data(), tags.size(), 0);
+  ogg_->Flush();
+}
+
+int64_t AudioFileWriter::OpusGranule(uint64_t frames) const {
+  return kOpusPreSkip + static_cast<int64_t>(frames * kOpusGranuleRate /
+                                             format_.sample_rate);
+}
+
+}  // namespace samurai
@@ -0,0 +1,85 @@
+#include "samurai_audio_core/audio_format.h"
+
+namespace samurai {
+
+uint16_t AudioFormat::BytesPerSample() const {
+  switch (sample_type) {
+    case SampleType::kInt16:
+      return 2;
+    case SampleType::kInt24:
+      return 3;
+    case SampleType::kInt32:
+    case SampleType::kFloat32:
+      return 4;
+  }
+  return 0;
+}
+
+bool AudioFormat::IsValid() const {
+  return sample_rate > 0 && channels > 0 && BytesPerSample() > 0;
+}
+
+AudioFormat DefaultOutputFormat() {
+  AudioFormat format;
+  format.sample_rate = 44100;
+  format.channels = 2;
+  format.sample_type = SampleType::kInt16;
+  return format;
+}
+
+uint32_t FramesForDuration(const AudioFormat& format, uint32_t milliseconds) {
+  return static_cast<uint32_t>(
+      static_cast<uint64_t>(format.sample_rate) * milliseconds / 1000);
+}
+
+uint64_t DurationForFrames(const AudioFormat& format, uint64_t frames) {
+  if (format.sample_rate == 0) {
+    return 0;
+  }
+  return frames * 1000000 / format.sample_rate;
+}
+
+int64_t NanosForFrames(const AudioFormat& format, uint64_t frames) {
+  if (format.sample_rate == 0) {
+    return 0;
+  }
+  // Split so that hours of frames do not overflow the multiplication.
+  const uint64_t rate = format.sample_rate;
+  return static_cast<int64_t>(frames / rate * 1000000000 +
+                              frames % rate * 1000000000 / rate);
+}
+
+MediaTimestamp AdvanceTimestamp(const AudioFormat& format,
+                                const MediaTimestamp& timestamp,
+                                uint64_t frames) {
+  MediaTimestamp advanced;
+  advanced.position = timestamp.position + frames;
+  advanced.time_ns = timestamp.time_ns + NanosForFrames(format, frames);
+  return advanced;
+}
+
+std::string PcmMimeType(const AudioFormat& format) {
+  std::string mime = "audio/pcm;rate=" + std::to_string(format.sample_rate) +
+                     ";channels=" + std::to_string(format.channels) +
+                     ";bitdepth=" + std::to_string(format.BitsPerSample());
+  if (format.sample_type == SampleType::kFloat32) {
+    mime += ";encoding=float";
+  }
+  return mime;
+}
+
+const char* SampleTypeName(SampleType type) {
+  switch (type) {
+    case SampleType::kInt16:
+      return "int16";
+    case SampleType::kInt24:
+      return "int24";
+    case SampleType::kInt32:
+      return "int32";
+    case SampleType::kFloat32:
+      return "float32";
+  }
+  return "unknown";
+}
+
+}  // namespace samurai
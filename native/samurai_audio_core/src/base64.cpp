@@ -0,0 +1,171 @@
+#include "samurai_audio_core/base64.h"
+
+#include "base64_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+namespace samurai {
+
+namespace {
+
+const char kBase64Chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void EncodeScalar(const uint8_t* data, size_t size, char* dst) {
+  for (size_t i = 0; i < size; i += 3) {
+    uint32_t octet_a = data[i];
+    uint32_t octet_b = i + 1 < size ? data[i + 1] : 0;
+    uint32_t octet_c = i + 2 < size ? data[i + 2] : 0;
+
+    uint32_t triple = (octet_a << 16) | (octet_b << 8) | octet_c;
+
+    *dst++ = kBase64Chars[(triple >> 18) & 0x3F];
+    *dst++ = kBase64Chars[(triple >> 12) & 0x3F];
+    *dst++ = (i + 1 < size) ? kBase64Chars[(triple >> 6) & 0x3F] : '=';
+    *dst++ = (i + 2 < size) ? kBase64Chars[triple & 0x3F] : '=';
+  }
+}
+
+using KernelFn = size_t (*)(const uint8_t*, size_t, char*);
+
+KernelFn KernelFor(Base64Impl impl) {
+  switch (impl) {
+    case Base64Impl::kSsse3:
+      return internal::Base64EncodeSsse3;
+    case Base64Impl::kAvx2:
+      return internal::Base64EncodeAvx2;
+    case Base64Impl::kNeon:
+      return internal::Base64EncodeNeon;
+    case Base64Impl::kScalar:
+      break;
+  }
+  return nullptr;
+}
+
+void EncodeWithKernel(KernelFn kernel, const uint8_t* data, size_t size,
+                      char* out) {
+  size_t consumed = kernel ? kernel(data, size, out) : 0;
+  EncodeScalar(data + consumed, size - consumed, out + consumed / 3 * 4);
+}
+
+// 0xFF marks characters outside the alphabet.
+struct DecodeTable {
+  uint8_t values[256];
+  DecodeTable() {
+    for (int i = 0; i < 256; ++i) {
+      values[i] = 0xFF;
+    }
+    for (int i = 0; i < 64; ++i) {
+      values[static_cast<uint8_t>(kBase64Chars[i])] = static_cast<uint8_t>(i);
+    }
+  }
+};
+
+}  // namespace
+
+const char* Base64ImplName(Base64Impl impl) {
+  switch (impl) {
+    case Base64Impl::kScalar:
+      return "scalar";
+    case Base64Impl::kSsse3:
+      return "ssse3";
+    case Base64Impl::kAvx2:
+      return "avx2";
+    case Base64Impl::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool Base64ImplSupported(Base64Impl impl) {
+  const CpuFeatures& cpu = GetCpuFeatures();
+  switch (impl) {
+    case Base64Impl::kScalar:
+      return true;
+#if defined(SAMURAI_ARCH_X86)
+    case Base64Impl::kSsse3:
+      return cpu.ssse3;
+    case Base64Impl::kAvx2:
+      return cpu.avx2;
+#endif
+#if defined(SAMURAI_ARCH_ARM64)
+    case Base64Impl::kNeon:
+      return cpu.neon;
+#endif
+    default:
+      break;
+  }
+  return false;
+}
+
+Base64Impl Base64BestImpl() {
+  static const Base64Impl best = []() {
+    for (Base64Impl impl :
+         {Base64Impl::kAvx2, Base64Impl::kNeon, Base64Impl::kSsse3}) {
+      if (Base64ImplSupported(impl)) {
+        return impl;
+      }
+    }
+    return Base64Impl::kScalar;
+  }();
+  return best;
+}
+
+bool Base64EncodeWith(Base64Impl impl, const uint8_t* data, size_t size,
+                      char* out) {
+  if (!Base64ImplSupported(impl)) {
+    return false;
+  }
+  EncodeWithKernel(KernelFor(impl), data, size, out);
+  return true;
+}
+
+void Base64Encode(const uint8_t* data, size_t size, std::string* out) {
+  static const KernelFn kernel = KernelFor(Base64BestImpl());
+  out->resize(Base64EncodedSize(size));
+  if (size > 0) {
+    EncodeWithKernel(kernel, data, size, &(*out)[0]);
+  }
+}
+
+std::string Base64Encode(const uint8_t* data, size_t size) {
+  std::string out;
+  Base64Encode(data, size, &out);
+  return out;
+}
+
+bool Base64Decode(const char* text, size_t size, std::vector<uint8_t>* out) {
+  static const DecodeTable table;
+  out->clear();
+  if (size % 4 != 0) {
+    return false;
+  }
+  out->reserve(size / 4 * 3);
+
+  for (size_t i = 0; i < size; i += 4) {
+    const bool last = i + 4 == size;
+    size_t padding = 0;
+    if (last) {
+      padding = (text[i + 3] == '=') + (text[i + 2] == '=' && text[i + 3] == '=');
+    }
+
+    uint32_t triple = 0;
+    for (size_t j = 0; j < 4 - padding; ++j) {
+      uint8_t value = table.values[static_cast<uint8_t>(text[i + j])];
+      if (value == 0xFF) {
+        return false;
+      }
+      triple |= static_cast<uint32_t>(value) << (18 - 6 * j);
+    }
+
+    out->push_back(static_cast<uint8_t>(triple >> 16));
+    if (padding < 2) {
+      out->push_back(static_cast<uint8_t>(triple >> 8));
+    }
+    if (padding < 1) {
+      out->push_back(static_cast<uint8_t>(triple));
+    }
+  }
+  return true;
+}
+
+}  // namespace samurai
@@ -0,0 +1,20 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_BASE64_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_BASE64_INTERNAL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace samurai {
+namespace internal {
+
+// SIMD kernels encode whole blocks of input and return the number of input
+// bytes consumed (always a multiple of 3); the caller finishes the tail with
+// the scalar encoder. Each writes (consumed / 3) * 4 chars.
+size_t Base64EncodeSsse3(const uint8_t* data, size_t size, char* out);
+size_t Base64EncodeAvx2(const uint8_t* data, size_t size, char* out);
+size_t Base64EncodeNeon(const uint8_t* data, size_t size, char* out);
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_BASE64_INTERNAL_H_
@@ -0,0 +1,56 @@
+#include "base64_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_ARM64)
+
+size_t Base64EncodeNeon(const uint8_t* data, size_t size, char* out) {
+  static const uint8_t kAlphabet[64] = {
+      'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+      'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+      'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+      'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+      '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+  uint8x16x4_t table;
+  table.val[0] = vld1q_u8(kAlphabet);
+  table.val[1] = vld1q_u8(kAlphabet + 16);
+  table.val[2] = vld1q_u8(kAlphabet + 32);
+  table.val[3] = vld1q_u8(kAlphabet + 48);
+  const uint8x16_t mask6 = vdupq_n_u8(0x3F);
+
+  // vld3 de-interleaves 16 byte triples; vst4 re-interleaves the indices.
+  size_t i = 0;
+  for (; i + 48 <= size; i += 48) {
+    uint8x16x3_t in = vld3q_u8(data + i);
+    uint8x16x4_t indices;
+    indices.val[0] = vshrq_n_u8(in.val[0], 2);
+    indices.val[1] = vandq_u8(
+        vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask6);
+    indices.val[2] = vandq_u8(
+        vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask6);
+    indices.val[3] = vandq_u8(in.val[2], mask6);
+
+    uint8x16x4_t encoded;
+    for (int j = 0; j < 4; ++j) {
+      encoded.val[j] = vqtbl4q_u8(table, indices.val[j]);
+    }
+    vst4q_u8(reinterpret_cast<uint8_t*>(out), encoded);
+    out += 64;
+  }
+  return i;
+}
+
+#else  // !SAMURAI_ARCH_ARM64
+
+size_t Base64EncodeNeon(const uint8_t*, size_t, char*) { return 0; }
+
+#endif  // SAMURAI_ARCH_ARM64
+
+}  // namespace internal
+}  // namespace samurai
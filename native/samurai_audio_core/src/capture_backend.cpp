@@ -0,0 +1,17 @@
+#include "samurai_audio_core/capture_backend.h"
+
+namespace samurai {
+
+const char* StreamKindName(StreamKind kind) {
+  switch (kind) {
+    case StreamKind::kSystem:
+      return "system";
+    case StreamKind::kMicrophone:
+      return "microphone";
+    case StreamKind::kAligned:
+      return "aligned";
+  }
+  return "system";
+}
+
+}  // namespace samurai
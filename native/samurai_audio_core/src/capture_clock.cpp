@@ -0,0 +1,34 @@
+#include "samurai_audio_core/capture_clock.h"
+
+#include <chrono>
+#include <thread>
+
+namespace samurai {
+
+int64_t SteadyCaptureClock::NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void SteadyCaptureClock::SleepFor(int64_t nanos) {
+  if (nanos > 0) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(nanos));
+  }
+}
+
+SteadyCaptureClock* SteadyCaptureClock::Get() {
+  static SteadyCaptureClock clock;
+  return &clock;
+}
+
+void SimulatedCaptureClock::SleepFor(int64_t nanos) {
+  ++sleeps_;
+  if (nanos > 0) {
+    now_.fetch_add(nanos);
+  }
+  // Let other threads observe the new time before the sleeper races ahead.
+  std::this_thread::yield();
+}
+
+}  // namespace samurai
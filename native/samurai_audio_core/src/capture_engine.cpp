@@ -0,0 +1,782 @@
+#include "samurai_audio_core/capture_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "samurai_audio_core/clock_drift_estimator.h"
+#include "samurai_audio_core/format_converter.h"
+#include "samurai_audio_core/pcm_frame_ring.h"
+#include "samurai_audio_core/reframer.h"
+
+namespace samurai {
+
+namespace {
+
+constexpr int64_t kNanosPerMilli = 1000000;
+
+// Drift compensation removes a timeline error over about this long, and
+// never trims the rate by more than kMaxDriftCorrection beyond the
+// measured drift.
+constexpr double kDriftSettleSeconds = 2.0;
+constexpr double kMaxDriftCorrection = 0.001;
+
+void UpdateMax(std::atomic<uint64_t>* max, uint64_t value) {
+  if (value > max->load(std::memory_order_relaxed)) {
+    max->store(value, std::memory_order_relaxed);
+  }
+}
+
+uint64_t ElapsedNanos(std::chrono::steady_clock::time_point start) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+// Recovers timestamps for what the delivery stages emit. The encoder and
+// the re-framer keep frame order and count, silence markers included, so
+// the n-th frame out of them is the n-th frame pushed in.
+class DeliveryTimeline {
+ public:
+  explicit DeliveryTimeline(const AudioFormat& format)
+      : format_(format), entries_(8) {}
+
+  // |frames| frames starting at |timestamp| enter the stages.
+  void Push(const MediaTimestamp& timestamp, uint32_t frames) {
+    if (count_ == entries_.size()) {
+      // Unwrap into a vector twice the size; steady state never gets here.
+      std::vector<Entry> grown(entries_.size() * 2);
+      for (size_t i = 0; i < count_; ++i) {
+        grown[i] = entries_[(head_ + i) % entries_.size()];
+      }
+      entries_.swap(grown);
+      head_ = 0;
+    }
+    entries_[(head_ + count_) % entries_.size()] = Entry{timestamp, frames};
+    ++count_;
+  }
+
+  // Timestamp of the next |frames| frames out of the stages, which are
+  // then consumed. Frames past the input (codec padding) extrapolate.
+  MediaTimestamp Take(uint32_t frames) {
+    const MediaTimestamp result =
+        count_ > 0 ? AdvanceTimestamp(format_, entries_[head_].timestamp,
+                                      consumed_)
+                   : next_;
+    uint64_t remaining = frames;
+    while (remaining > 0 && count_ > 0) {
+      const Entry& entry = entries_[head_];
+      const uint64_t left = entry.frames - consumed_;
+      if (remaining < left) {
+        consumed_ += remaining;
+        return result;
+      }
+      remaining -= left;
+      next_ = AdvanceTimestamp(format_, entry.timestamp, entry.frames);
+      head_ = (head_ + 1) % entries_.size();
+      --count_;
+      consumed_ = 0;
+    }
+    next_ = AdvanceTimestamp(format_, next_, remaining);
+    return result;
+  }
+
+ private:
+  struct Entry {
+    MediaTimestamp timestamp;
+    uint32_t frames;
+  };
+
+  AudioFormat format_;
+  std::vector<Entry> entries_;  // Circular, from |head_|.
+  size_t head_ = 0;
+  size_t count_ = 0;
+  uint64_t consumed_ = 0;  // Frames of the head entry already taken.
+  MediaTimestamp next_;    // Just past the last entry taken.
+};
+
+}  // namespace
+
+void CaptureEngine::StreamState::ResetStats() {
+  packets_captured = 0;
+  packets_delivered = 0;
+  overruns = 0;
+  dropped_frames = 0;
+  max_capture_ns = 0;
+  total_capture_ns = 0;
+  wakeups = 0;
+  idle_wakeups = 0;
+  max_latency_ns = 0;
+  total_latency_ns = 0;
+  latency_samples = 0;
+  silent_packets = 0;
+  suppressed_frames = 0;
+  frame_timeouts = 0;
+  drift_ppm = 0.0;
+  drift_ms = 0.0;
+  drift_corrected_frames = 0;
+  encoded_packets = 0;
+  encoder_failures = 0;
+  recorded_frames = 0;
+  recording_bytes = 0;
+  recording_failed = false;
+}
+
+CaptureEngine::Options::Options() {
+  settings.stream.format = DefaultOutputFormat();
+}
+
+CaptureEngine::CaptureEngine(std::unique_ptr<CaptureBackend> backend)
+    : CaptureEngine(std::move(backend), Options()) {}
+
+CaptureEngine::CaptureEngine(std::unique_ptr<CaptureBackend> backend,
+                             const Options& options)
+    : backend_(std::move(backend)),
+      options_(options),
+      clock_(options.clock ? options.clock : SteadyCaptureClock::Get()) {}
+
+CaptureEngine::~CaptureEngine() { StopAll(); }
+
+bool CaptureEngine::Initialize() { return backend_ && backend_->Initialize(); }
+
+std::vector<AudioDevice> CaptureEngine::GetInputDevices() {
+  return backend_->GetInputDevices();
+}
+
+std::vector<AudioDevice> CaptureEngine::GetOutputDevices() {
+  return backend_->GetOutputDevices();
+}
+
+bool CaptureEngine::Start(StreamKind kind, const std::string& device_id,
+                          AudioPacketCallback callback) {
+  return Start(kind, device_id, options_.settings, std::move(callback));
+}
+
+bool CaptureEngine::Start(StreamKind kind, const std::string& device_id,
+                          const CaptureSettings& settings,
+                          AudioPacketCallback callback) {
+  if (!IsCapturedStream(kind)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> control(control_mutex_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  StreamState& stream = state(kind);
+
+  if (stream.capturing.load()) {
+    return false;  // Already capturing
+  }
+
+  // The thread of a start whose device failed to open has exited but was
+  // never joined.
+  if (stream.thread.joinable()) {
+    stream.thread.join();
+  }
+
+  stream.ResetStats();
+  stream.capturing = true;
+  std::promise<bool> opened;
+  std::future<bool> opened_future = opened.get_future();
+  stream.thread =
+      std::thread(&CaptureEngine::CaptureThread, this, kind, device_id,
+                  settings, std::move(callback), &stream, &opened);
+  return opened_future.get();
+}
+
+void CaptureEngine::Stop(StreamKind kind) {
+  if (!IsCapturedStream(kind)) {
+    return;
+  }
+  std::lock_guard<std::mutex> control(control_mutex_);
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StreamState& stream = state(kind);
+    stream.capturing = false;
+    thread = std::move(stream.thread);
+  }
+  // Joined without |mutex_|: the callback may query the engine until the
+  // delivery thread has drained.
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void CaptureEngine::StopAll() {
+  Stop(StreamKind::kSystem);
+  Stop(StreamKind::kMicrophone);
+}
+
+bool CaptureEngine::IsCapturing(StreamKind kind) const {
+  return IsCapturedStream(kind) && state(kind).capturing.load();
+}
+
+CaptureStats CaptureEngine::GetStats(StreamKind kind) const {
+  CaptureStats stats;
+  if (!IsCapturedStream(kind)) {
+    return stats;
+  }
+  const StreamState& stream = state(kind);
+  stats.packets_captured = stream.packets_captured.load();
+  stats.packets_delivered = stream.packets_delivered.load();
+  stats.overruns = stream.overruns.load();
+  stats.dropped_frames = stream.dropped_frames.load();
+  stats.max_capture_ns = stream.max_capture_ns.load();
+  stats.total_capture_ns = stream.total_capture_ns.load();
+  stats.wakeups = stream.wakeups.load();
+  stats.idle_wakeups = stream.idle_wakeups.load();
+  stats.max_latency_ns = stream.max_latency_ns.load();
+  stats.total_latency_ns = stream.total_latency_ns.load();
+  stats.latency_samples = stream.latency_samples.load();
+  stats.silent_packets = stream.silent_packets.load();
+  stats.suppressed_frames = stream.suppressed_frames.load();
+  stats.frame_timeouts = stream.frame_timeouts.load();
+  stats.drift_ppm = stream.drift_ppm.load();
+  stats.drift_ms = stream.drift_ms.load();
+  stats.drift_corrected_frames = stream.drift_corrected_frames.load();
+  stats.encoded_packets = stream.encoded_packets.load();
+  stats.encoder_failures = stream.encoder_failures.load();
+  stats.recorded_frames = stream.recorded_frames.load();
+  stats.recording_bytes = stream.recording_bytes.load();
+  stats.recording_failed = stream.recording_failed.load();
+  return stats;
+}
+
+bool CaptureEngine::GetStreamInfo(StreamKind kind, StreamInfo* info) const {
+  if (!IsCapturedStream(kind)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  const StreamState& stream = state(kind);
+  if (!stream.has_info) {
+    return false;
+  }
+  *info = stream.info;
+  return true;
+}
+
+void CaptureEngine::CaptureThread(StreamKind kind, std::string device_id,
+                                  CaptureSettings settings,
+                                  AudioPacketCallback callback,
+                                  StreamState* state,
+                                  std::promise<bool>* opened) {
+  std::unique_ptr<CaptureStream> stream =
+      backend_->OpenStream(kind, device_id, settings.stream);
+  if (!stream || !stream->Start()) {
+    state->capturing = false;
+    opened->set_value(false);
+    return;
+  }
+
+  // Convert at the source: dropping channels, narrowing the usual float mix
+  // format to int16 and resampling to the requested rate here shrink every
+  // later copy. Whatever cannot be converted keeps the device's value.
+  const AudioFormat device_format = stream->format();
+  FormatConverter converter(device_format, settings.stream.format,
+                            settings.channel_map, settings.dither,
+                            settings.resampler_quality);
+  const AudioFormat format = converter.output_format();
+  const bool compensate_drift =
+      settings.compensate_drift &&
+      converter.EnableRateAdjustment(settings.resampler_quality);
+  ClockDriftEstimator drift(device_format.sample_rate,
+                            DriftEstimatorConfig());
+  // Device packets that need processing are copied out here so they can
+  // be released first; converted or zeroed packets are staged in
+  // |staging|. Both grow to the largest device packet and are reused.
+  std::vector<uint8_t> raw;
+  std::vector<uint8_t> staging;
+
+  const uint32_t block_align = format.BlockAlign();
+  const uint32_t slot_frames = std::max<uint32_t>(
+      1, FramesForDuration(format, settings.slot_duration_ms));
+  PcmFrameRing ring(settings.ring_slots,
+                    static_cast<size_t>(slot_frames) * block_align);
+
+  // Runs on converted packets, so it sees exactly what is delivered. Left
+  // off for formats it cannot analyse.
+  std::unique_ptr<VoiceActivityDetector> vad;
+  if (settings.vad) {
+    vad.reset(new VoiceActivityDetector(format, settings.vad_config));
+    if (!vad->IsValid()) {
+      vad.reset();
+    }
+  }
+  const SilencePolicy silence_policy = settings.silence_policy;
+
+  // Encoding runs on the delivery thread: a slow codec costs overruns,
+  // never device glitches.
+  std::unique_ptr<EncoderStage> encoder;
+  if (settings.encoder.codec != CodecId::kPcm) {
+    std::unique_ptr<AudioEncoder> created =
+        options_.encoder_factory
+            ? options_.encoder_factory(settings.encoder, format)
+            : CreateAudioEncoder(settings.encoder, format);
+    if (created) {
+      encoder.reset(new EncoderStage(std::move(created)));
+    }
+  }
+  // PCM re-blocking also runs on the delivery thread; codecs frame their
+  // own input.
+  std::unique_ptr<Reframer> reframer;
+  if (!encoder && settings.frame_ms > 0) {
+    reframer.reset(
+        new Reframer(format, settings.frame_ms, settings.frame_flush_ms));
+  }
+  // Recording shares the delivery thread with the encoder, so disk writes
+  // never delay the device. A recording that was asked for but cannot be
+  // created fails the start instead of being silently lost.
+  std::unique_ptr<RecordingSink> recorder;
+  if (!settings.recording.path.empty()) {
+    recorder.reset(new RecordingSink());
+    if (!recorder->Open(settings.recording, format)) {
+      stream->Stop();
+      state->capturing = false;
+      opened->set_value(false);
+      return;
+    }
+  }
+  const uint32_t max_marker_frames = std::max<uint32_t>(
+      1, FramesForDuration(format, settings.silence_marker_ms));
+
+  const bool event_driven = stream->event_driven();
+  const uint32_t period_ms = std::max<uint32_t>(1, stream->device_period_ms());
+  const int64_t period_ns = static_cast<int64_t>(period_ms) * kNanosPerMilli;
+
+  StreamInfo& info = state->info;
+  info.device_format = device_format;
+  info.format = format;
+  info.channel_mode = converter.channel_mode();
+  info.scheduling =
+      event_driven ? SchedulingMode::kEventDriven : SchedulingMode::kTimer;
+  info.device_period_ms = period_ms;
+  info.buffer_duration_ms = stream->buffer_duration_ms();
+  info.delivery_frames = slot_frames;
+  info.queue_slots = static_cast<uint32_t>(ring.capacity());
+  info.expected_latency_ms =
+      (event_driven ? period_ms : 2 * period_ms) +
+      static_cast<uint32_t>(
+          (DurationForFrames(device_format, converter.delay_frames()) + 500) /
+          1000);
+  info.queue_duration_ms = static_cast<uint32_t>(
+      DurationForFrames(format, static_cast<uint64_t>(slot_frames) *
+                                    ring.capacity()) /
+      1000);
+  if (encoder) {
+    info.encoder = encoder->encoder().config();
+    info.mime_type = encoder->encoder().MimeType();
+    info.expected_latency_ms += info.encoder.frame_ms;
+  } else {
+    info.encoder = EncoderConfig();
+    info.mime_type = PcmMimeType(format);
+  }
+  info.frame_frames = reframer ? reframer->frame_frames() : 0;
+  info.recording_mime_type = recorder ? recorder->MimeType() : std::string();
+  state->has_info = true;
+  // |opened| dies with Start(); it must not be touched after this.
+  opened->set_value(true);
+
+  // What the encoder and re-framer emit is copied into these, so every
+  // delivered packet can be kept without a copy; ring slots already are.
+  // As with the ring, consumers may keep a queue's worth. An encoded frame
+  // never outgrows the PCM slot it came from.
+  const size_t staged_bytes = std::max<size_t>(
+      ring.slot_bytes(),
+      reframer ? static_cast<size_t>(reframer->frame_frames()) * block_align
+               : 0);
+  FramePool delivery_pool(encoder || reframer ? 2 * ring.capacity() : 0,
+                          staged_bytes);
+
+  std::atomic<bool> delivering{true};
+  std::thread delivery_thread([&]() {
+    DeliveryTimeline timeline(format);
+    AudioPacket packet;
+    packet.stream = kind;
+    packet.codec = info.encoder.codec;
+    packet.format = format;
+    auto deliver = [&](const uint8_t* data, size_t size, uint32_t frames,
+                       uint32_t flags, const FrameRef* buffer) {
+      if (callback) {
+        packet.data = data;
+        packet.size = size;
+        packet.buffer = buffer;
+        packet.frames = frames;
+        packet.flags = flags;
+        const MediaTimestamp timestamp = timeline.Take(frames);
+        packet.position = timestamp.position;
+        packet.capture_time_ns = timestamp.time_ns;
+        callback(packet);
+        ++packet.sequence;
+      }
+    };
+    auto deliver_staged = [&](const uint8_t* data, size_t size,
+                              uint32_t frames, uint32_t flags) {
+      FrameRef staged;
+      if (callback && size > 0 && size <= delivery_pool.buffer_bytes()) {
+        staged = delivery_pool.Acquire();
+      }
+      if (staged) {
+        std::memcpy(staged.data(), data, size);
+        staged.set_size(size);
+        data = staged.data();
+      }
+      deliver(data, size, frames, flags, staged ? &staged : nullptr);
+    };
+    const EncoderStage::Output emit = [&](const uint8_t* data, size_t size,
+                                          uint32_t frames, uint32_t flags) {
+      state->encoded_packets.fetch_add(1, std::memory_order_relaxed);
+      deliver_staged(data, size, frames, flags);
+    };
+    const Reframer::Output reframed = deliver_staged;
+    // Partial-frame deadlines are wall time whatever clock drives capture:
+    // they bound real latency.
+    SteadyCaptureClock* steady = SteadyCaptureClock::Get();
+
+    std::unique_lock<std::mutex> lock(state->delivery_mutex);
+    while (true) {
+      // Announce the sleep before re-checking the ring; paired with the
+      // fence in the producer, one side always sees the other's store.
+      state->consumer_waiting.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const auto ready = [&]() {
+        return !ring.Empty() || !delivering.load();
+      };
+      const int64_t deadline =
+          reframer ? reframer->deadline_ns() : Reframer::kNoDeadline;
+      if (deadline == Reframer::kNoDeadline) {
+        state->delivery_cv.wait(lock, ready);
+      } else {
+        state->delivery_cv.wait_until(
+            lock,
+            std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(deadline)),
+            ready);
+      }
+      state->consumer_waiting.store(false, std::memory_order_relaxed);
+      bool draining = !delivering.load();
+
+      lock.unlock();
+      while (const PcmFrame* frame = ring.Peek()) {
+        if (callback) {
+          timeline.Push(frame->timestamp, frame->frames);
+        }
+        if (recorder) {
+          recorder->Write(frame->data, frame->frames, frame->flags);
+          state->recorded_frames.store(recorder->frames(),
+                                       std::memory_order_relaxed);
+          state->recording_bytes.store(recorder->bytes(),
+                                       std::memory_order_relaxed);
+        }
+        if (encoder) {
+          encoder->Push(frame->data, frame->frames, frame->flags, emit);
+          state->encoder_failures.store(encoder->failures(),
+                                        std::memory_order_relaxed);
+        } else if (reframer) {
+          reframer->Push(frame->data, frame->frames, frame->flags,
+                         steady->NowNanos(), reframed);
+        } else {
+          deliver(frame->data, frame->size, frame->frames, frame->flags,
+                  frame->buffer ? &frame->buffer : nullptr);
+        }
+        ring.Pop();
+        state->packets_delivered.fetch_add(1, std::memory_order_relaxed);
+      }
+      if (reframer) {
+        reframer->Poll(steady->NowNanos(), reframed);
+        state->frame_timeouts.store(reframer->timeouts(),
+                                    std::memory_order_relaxed);
+      }
+      lock.lock();
+
+      if (draining) {
+        if (encoder) {
+          encoder->Flush(emit);
+        }
+        if (reframer) {
+          reframer->Flush(reframed);
+        }
+        if (recorder) {
+          state->recording_failed.store(!recorder->Close());
+          state->recorded_frames.store(recorder->frames());
+          state->recording_bytes.store(recorder->bytes());
+        }
+        break;
+      }
+    }
+  });
+
+  // Wakes the delivery thread if, and only if, it is asleep.
+  auto wake_consumer = [state]() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (state->consumer_waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(state->delivery_mutex);
+      state->delivery_cv.notify_one();
+    }
+  };
+
+  // How long a device packet was held, from GetPacket to ReleasePacket.
+  auto record_held = [state](std::chrono::steady_clock::time_point start) {
+    const uint64_t held_ns = ElapsedNanos(start);
+    state->total_capture_ns.fetch_add(held_ns, std::memory_order_relaxed);
+    UpdateMax(&state->max_capture_ns, held_ns);
+  };
+
+  uint32_t packet_frames = 0;
+  CapturedPacket captured;
+  // Flags of device packets that produced no output (the resampler was
+  // still filling), carried to the next slot written.
+  uint32_t pending_flags = 0;
+  // Silence not yet reported under SilencePolicy::kMarkers, in delivered
+  // and device frames. A marker that does not fit is an overrun like any
+  // other packet.
+  uint32_t marker_frames = 0;
+  uint32_t marker_device_frames = 0;
+  uint32_t marker_flags = 0;
+  MediaTimestamp marker_timestamp;
+  auto flush_marker = [&]() {
+    if (marker_frames == 0) {
+      return;
+    }
+    if (ring.WriteMarker(marker_frames,
+                         marker_flags | kPacketNoSpeech | kPacketSilenceMarker,
+                         marker_timestamp)) {
+      wake_consumer();
+    } else {
+      state->overruns.fetch_add(1, std::memory_order_relaxed);
+      state->dropped_frames.fetch_add(marker_device_frames,
+                                      std::memory_order_relaxed);
+    }
+    marker_frames = 0;
+    marker_device_frames = 0;
+    marker_flags = 0;
+  };
+
+  // The stream timeline. Positions count converted frames plus, scaled to
+  // |format|, whatever the device position says was lost in between.
+  bool positioned = false;
+  uint64_t next_device_position = 0;
+  uint64_t input_frames = 0;   // Into the converter.
+  uint64_t output_frames = 0;  // Out of it.
+  uint64_t lost_frames = 0;
+  // Compensated positions against host time, from when the drift estimate
+  // first locked.
+  bool drift_anchored = false;
+  double drift_anchor_frames = 0.0;
+  int64_t drift_anchor_ns = 0;
+
+  while (state->capturing.load()) {
+    // Event waits time out after two periods so Stop() is never stuck
+    // behind a device that stopped signalling.
+    if (event_driven) {
+      stream->WaitForData(2 * period_ns);
+    }
+    state->wakeups.fetch_add(1, std::memory_order_relaxed);
+
+    bool ok = stream->GetNextPacketSize(&packet_frames);
+    if (ok && packet_frames == 0) {
+      state->idle_wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    while (ok && packet_frames > 0 && state->capturing.load()) {
+      ok = stream->GetPacket(&captured);
+      if (!ok) {
+        break;
+      }
+      auto packet_start = std::chrono::steady_clock::now();
+
+      // Hold the device buffer only for a copy. Packets that need
+      // conversion or analysis are copied out and released before any of
+      // it runs; the rest are copied straight into the ring below.
+      const bool silent = (captured.flags & kPacketSilent) != 0;
+      const bool convert =
+          captured.frames > 0 && (!converter.passthrough() || silent);
+      const uint8_t* device_data = captured.data;
+      bool held = true;
+      if (captured.frames > 0 && (convert || vad)) {
+        if (!silent) {
+          const size_t bytes =
+              static_cast<size_t>(captured.frames) * device_format.BlockAlign();
+          if (raw.size() < bytes) {
+            raw.resize(bytes);
+          }
+          std::memcpy(raw.data(), captured.data, bytes);
+          device_data = raw.data();
+        }
+        stream->ReleasePacket(captured.frames);
+        held = false;
+        record_held(packet_start);
+      }
+
+      if (captured.capture_time_ns > 0) {
+        int64_t ready_ns =
+            captured.capture_time_ns +
+            static_cast<int64_t>(
+                DurationForFrames(device_format, captured.frames)) *
+                1000;
+        uint64_t latency_ns =
+            static_cast<uint64_t>(std::max<int64_t>(0, clock_->NowNanos() -
+                                                           ready_ns));
+        state->latency_samples.fetch_add(1, std::memory_order_relaxed);
+        state->total_latency_ns.fetch_add(latency_ns,
+                                          std::memory_order_relaxed);
+        UpdateMax(&state->max_latency_ns, latency_ns);
+      }
+
+      // Stamp the packet on the device's clock where it reports one.
+      int64_t packet_time_ns = captured.capture_time_ns;
+      if (packet_time_ns <= 0) {
+        packet_time_ns = clock_->NowNanos() -
+                         NanosForFrames(device_format, captured.frames);
+      }
+      if (positioned && captured.device_position > next_device_position) {
+        lost_frames += (captured.device_position - next_device_position) *
+                       format.sample_rate / device_format.sample_rate;
+        pending_flags |= kPacketDiscontinuity;
+      }
+      positioned = true;
+      next_device_position = captured.device_position + captured.frames;
+
+      // The resampler has no group delay: output frame k is centred on
+      // converter input frame k * in / out, wherever packets split.
+      MediaTimestamp timestamp;
+      timestamp.position = output_frames + lost_frames;
+      timestamp.time_ns = packet_time_ns +
+                          NanosForFrames(format, output_frames) -
+                          NanosForFrames(device_format, input_frames);
+      if (captured.capture_time_ns > 0) {
+        drift.Update(captured.device_position, captured.capture_time_ns);
+        state->drift_ppm.store(drift.ppm(), std::memory_order_relaxed);
+        state->drift_ms.store(drift.drift_ns() / 1e6,
+                              std::memory_order_relaxed);
+      }
+      if (compensate_drift) {
+        // The trim stage reads nominal output frames; |nominal| is where
+        // this packet starts among them and |at| where it will land in
+        // the delivered stream.
+        const AdaptiveResampler* trim = converter.rate_adjuster();
+        const double nominal = static_cast<double>(input_frames) *
+                               format.sample_rate / device_format.sample_rate;
+        const double lead = trim->next_input_position() - nominal;
+        timestamp.time_ns =
+            packet_time_ns +
+            static_cast<int64_t>(std::llround(lead * 1e9 / format.sample_rate));
+        if (captured.capture_time_ns > 0 && drift.locked()) {
+          const double at = static_cast<double>(timestamp.position) -
+                            lead / trim->ratio();
+          if (!drift_anchored) {
+            drift_anchored = true;
+            drift_anchor_frames = at;
+            drift_anchor_ns = packet_time_ns;
+          }
+          const double target =
+              drift_anchor_frames + static_cast<double>(packet_time_ns -
+                                                        drift_anchor_ns) *
+                                        format.sample_rate / 1e9;
+          const double correction = std::min(
+              kMaxDriftCorrection,
+              std::max(-kMaxDriftCorrection,
+                       (at - target) / (format.sample_rate *
+                                        kDriftSettleSeconds)));
+          converter.SetRateAdjustment(drift.ratio() * (1.0 + correction));
+        }
+        state->drift_corrected_frames.store(
+            static_cast<int64_t>(
+                std::llround(output_frames - trim->next_input_position())),
+            std::memory_order_relaxed);
+      }
+
+      // Silent packets are forwarded as zeros so consumers see continuous
+      // data; the flag lets them skip the work if they want to. WASAPI
+      // leaves the buffer contents undefined for them.
+      const uint8_t* data = device_data;
+      size_t frames = captured.frames;
+      if (convert) {
+        const size_t bytes =
+            converter.MaxOutputFrames(captured.frames) * block_align;
+        if (staging.size() < bytes) {
+          staging.resize(bytes);
+        }
+        frames = converter.Convert(silent ? nullptr : device_data,
+                                   captured.frames, staging.data());
+        data = staging.data();
+      }
+
+      input_frames += captured.frames;
+      output_frames += frames;
+
+      pending_flags |= captured.flags;
+      bool deliver = frames > 0;
+      if (deliver && vad) {
+        const VoiceActivity activity = vad->Process(
+            data, static_cast<uint32_t>(frames), pending_flags);
+        if (activity != VoiceActivity::kSpeech) {
+          state->silent_packets.fetch_add(1, std::memory_order_relaxed);
+          pending_flags |= kPacketNoSpeech;
+          if (silence_policy != SilencePolicy::kForward) {
+            state->suppressed_frames.fetch_add(frames,
+                                               std::memory_order_relaxed);
+            deliver = false;
+          }
+          if (silence_policy == SilencePolicy::kMarkers) {
+            if (marker_frames == 0) {
+              marker_timestamp = timestamp;
+            }
+            marker_frames += static_cast<uint32_t>(frames);
+            marker_device_frames += captured.frames;
+            marker_flags |= pending_flags;
+            if (marker_frames >= max_marker_frames) {
+              flush_marker();
+            }
+          }
+          if (!deliver) {
+            pending_flags = 0;
+          }
+        } else {
+          // The marker must reach the queue ahead of the speech it
+          // precedes.
+          flush_marker();
+        }
+      }
+      if (deliver) {
+        if (ring.Write(data, static_cast<uint32_t>(frames), format,
+                       pending_flags, timestamp)) {
+          wake_consumer();
+        } else {
+          state->overruns.fetch_add(1, std::memory_order_relaxed);
+          state->dropped_frames.fetch_add(captured.frames,
+                                          std::memory_order_relaxed);
+        }
+        pending_flags = 0;
+      }
+
+      if (held) {
+        stream->ReleasePacket(captured.frames);
+        record_held(packet_start);
+      }
+      state->packets_captured.fetch_add(1, std::memory_order_relaxed);
+
+      ok = stream->GetNextPacketSize(&packet_frames);
+    }
+
+    if (!event_driven && state->capturing.load()) {
+      clock_->SleepFor(period_ns);
+    }
+  }
+
+  stream->Stop();
+  flush_marker();
+
+  // Hand over whatever is still queued, then stop the delivery thread.
+  {
+    std::lock_guard<std::mutex> lock(state->delivery_mutex);
+    delivering = false;
+  }
+  state->delivery_cv.notify_one();
+  delivery_thread.join();
+
+  state->capturing = false;
+}
+
+}  // namespace samurai
@@ -0,0 +1,61 @@
+#include "samurai_audio_core/capture_profile.h"
+
+namespace samurai {
+
+const char* CaptureProfileName(CaptureProfile profile) {
+  switch (profile) {
+    case CaptureProfile::kRealtime:
+      return "realtime";
+    case CaptureProfile::kBalanced:
+      return "balanced";
+    case CaptureProfile::kBulk:
+      return "bulk";
+  }
+  return "unknown";
+}
+
+bool ParseCaptureProfile(const std::string& name, CaptureProfile* profile) {
+  for (CaptureProfile candidate :
+       {CaptureProfile::kRealtime, CaptureProfile::kBalanced,
+        CaptureProfile::kBulk}) {
+    if (name == CaptureProfileName(candidate)) {
+      *profile = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+CaptureSettings CaptureSettingsForProfile(CaptureProfile profile,
+                                          const AudioFormat& format) {
+  CaptureSettings settings;
+  settings.stream.format = format;
+  switch (profile) {
+    case CaptureProfile::kRealtime:
+      settings.stream.scheduling = SchedulingMode::kEventDriven;
+      settings.stream.device_period_ms = 10;
+      settings.stream.buffer_duration_ms = 40;
+      settings.stream.high_priority = true;
+      settings.slot_duration_ms = 10;
+      settings.ring_slots = 16;
+      break;
+    case CaptureProfile::kBalanced:
+      settings.stream.scheduling = SchedulingMode::kEventDriven;
+      settings.stream.device_period_ms = 10;
+      settings.stream.buffer_duration_ms = 200;
+      settings.slot_duration_ms = 20;
+      settings.ring_slots = 64;
+      break;
+    case CaptureProfile::kBulk:
+      settings.stream.scheduling = SchedulingMode::kTimer;
+      settings.stream.device_period_ms = 100;
+      settings.stream.buffer_duration_ms = 1000;
+      settings.slot_duration_ms = 100;
+      settings.ring_slots = 256;
+      settings.resampler_quality = ResamplerQuality::kHigh;
+      break;
+  }
+  return settings;
+}
+
+}  // namespace samurai
@@ -0,0 +1,209 @@
+#include "samurai_audio_core/channel_mixer.h"
+
+#include <utility>
+
+#include "channel_mixer_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+namespace samurai {
+
+namespace {
+
+internal::StereoToMono StereoToMonoFor(ChannelMixImpl impl) {
+  switch (impl) {
+    case ChannelMixImpl::kSse2:
+      return internal::StereoToMonoSse2();
+    case ChannelMixImpl::kAvx2:
+      return internal::StereoToMonoAvx2();
+    case ChannelMixImpl::kNeon:
+      return internal::StereoToMonoNeon();
+    case ChannelMixImpl::kScalar:
+      break;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+const char* ChannelModeName(ChannelMode mode) {
+  switch (mode) {
+    case ChannelMode::kPassthrough:
+      return "passthrough";
+    case ChannelMode::kDownmix:
+      return "downmix";
+    case ChannelMode::kSelect:
+      return "select";
+    case ChannelMode::kMatrix:
+      return "matrix";
+  }
+  return "unknown";
+}
+
+bool ParseChannelMode(const std::string& name, ChannelMode* mode) {
+  for (ChannelMode candidate :
+       {ChannelMode::kPassthrough, ChannelMode::kDownmix, ChannelMode::kSelect,
+        ChannelMode::kMatrix}) {
+    if (name == ChannelModeName(candidate)) {
+      *mode = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+ChannelMap ChannelMap::Downmix() {
+  ChannelMap map;
+  map.mode = ChannelMode::kDownmix;
+  return map;
+}
+
+ChannelMap ChannelMap::Select(uint16_t channel) {
+  ChannelMap map;
+  map.mode = ChannelMode::kSelect;
+  map.channel = channel;
+  return map;
+}
+
+ChannelMap ChannelMap::Matrix(uint16_t output_channels,
+                              std::vector<float> gains) {
+  ChannelMap map;
+  map.mode = ChannelMode::kMatrix;
+  map.output_channels = output_channels;
+  map.matrix = std::move(gains);
+  return map;
+}
+
+const char* ChannelMixImplName(ChannelMixImpl impl) {
+  switch (impl) {
+    case ChannelMixImpl::kScalar:
+      return "scalar";
+    case ChannelMixImpl::kSse2:
+      return "sse2";
+    case ChannelMixImpl::kAvx2:
+      return "avx2";
+    case ChannelMixImpl::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool ChannelMixImplSupported(ChannelMixImpl impl) {
+  const CpuFeatures& cpu = GetCpuFeatures();
+  switch (impl) {
+    case ChannelMixImpl::kScalar:
+      return true;
+#if defined(SAMURAI_ARCH_X86)
+    case ChannelMixImpl::kSse2:
+      return cpu.sse2;
+    case ChannelMixImpl::kAvx2:
+      return cpu.avx2;
+#endif
+#if defined(SAMURAI_ARCH_ARM64)
+    case ChannelMixImpl::kNeon:
+      return cpu.neon;
+#endif
+    default:
+      break;
+  }
+  return false;
+}
+
+ChannelMixImpl ChannelMixBestImpl() {
+  static const ChannelMixImpl best = []() {
+    for (ChannelMixImpl impl :
+         {ChannelMixImpl::kAvx2, ChannelMixImpl::kNeon, ChannelMixImpl::kSse2}) {
+      if (ChannelMixImplSupported(impl)) {
+        return impl;
+      }
+    }
+    return ChannelMixImpl::kScalar;
+  }();
+  return best;
+}
+
+ChannelMixer::ChannelMixer(uint16_t input_channels, const ChannelMap& map)
+    : ChannelMixer(input_channels, map, ChannelMixBestImpl()) {}
+
+ChannelMixer::ChannelMixer(uint16_t input_channels, const ChannelMap& map,
+                           ChannelMixImpl impl)
+    : input_channels_(input_channels), impl_(impl) {
+  if (input_channels == 0 || !ChannelMixImplSupported(impl)) {
+    return;
+  }
+  switch (map.mode) {
+    case ChannelMode::kPassthrough:
+      output_channels_ = input_channels;
+      gains_.assign(static_cast<size_t>(input_channels) * input_channels,
+                    0.0f);
+      for (uint16_t c = 0; c < input_channels; ++c) {
+        gains_[static_cast<size_t>(c) * input_channels + c] = 1.0f;
+      }
+      break;
+    case ChannelMode::kDownmix:
+      output_channels_ = 1;
+      gains_.assign(input_channels, 1.0f / input_channels);
+      break;
+    case ChannelMode::kSelect:
+      if (map.channel >= input_channels) {
+        return;
+      }
+      output_channels_ = 1;
+      select_ = map.channel;
+      gains_.assign(input_channels, 0.0f);
+      gains_[map.channel] = 1.0f;
+      break;
+    case ChannelMode::kMatrix:
+      if (map.output_channels == 0 ||
+          map.matrix.size() !=
+              static_cast<size_t>(map.output_channels) * input_channels) {
+        return;
+      }
+      output_channels_ = map.output_channels;
+      gains_ = map.matrix;
+      break;
+  }
+  valid_ = true;
+}
+
+void ChannelMixer::Process(const float* in, size_t frames, float* out) const {
+  if (!valid_) {
+    return;
+  }
+  const size_t inputs = input_channels_;
+  if (select_ >= 0) {
+    for (size_t i = 0; i < frames; ++i) {
+      out[i] = in[i * inputs + select_];
+    }
+    return;
+  }
+
+  if (inputs == 2 && output_channels_ == 1) {
+    const float left = gains_[0];
+    const float right = gains_[1];
+    size_t done = 0;
+    if (internal::StereoToMono kernel = StereoToMonoFor(impl_)) {
+      done = kernel(in, frames, left, right, out);
+    }
+    for (size_t i = done; i < frames; ++i) {
+      const float l = in[i * 2] * left;
+      const float r = in[i * 2 + 1] * right;
+      out[i] = l + r;
+    }
+    return;
+  }
+
+  const size_t outputs = output_channels_;
+  for (size_t i = 0; i < frames; ++i) {
+    const float* frame = in + i * inputs;
+    for (size_t m = 0; m < outputs; ++m) {
+      const float* row = gains_.data() + m * inputs;
+      float sum = 0.0f;
+      for (size_t n = 0; n < inputs; ++n) {
+        sum += frame[n] * row[n];
+      }
+      out[i * outputs + m] = sum;
+    }
+  }
+}
+
+}  // namespace samurai
@@ -0,0 +1,23 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_CHANNEL_MIXER_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_CHANNEL_MIXER_INTERNAL_H_
+
+#include <cstddef>
+
+namespace samurai {
+namespace internal {
+
+// Computes out[i] = in[2i] * left + in[2i+1] * right (multiply, multiply,
+// add; never fused) over whole blocks of frames and returns the number of
+// frames done; the caller finishes the tail with the scalar code.
+using StereoToMono = size_t (*)(const float* in, size_t frames, float left,
+                                float right, float* out);
+
+// Null on architectures without the instruction set.
+StereoToMono StereoToMonoSse2();
+StereoToMono StereoToMonoAvx2();
+StereoToMono StereoToMonoNeon();
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_CHANNEL_MIXER_INTERNAL_H_
@@ -0,0 +1,41 @@
+#include "channel_mixer_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_ARM64)
+
+namespace {
+
+// vld2q deinterleaves directly; separate multiply and add keep the result
+// unfused like the x86 kernels.
+size_t StereoToMonoNeonImpl(const float* in, size_t frames, float left,
+                            float right, float* out) {
+  const float32x4_t wl = vdupq_n_f32(left);
+  const float32x4_t wr = vdupq_n_f32(right);
+  size_t i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    const float32x4x2_t lr = vld2q_f32(in + i * 2);
+    vst1q_f32(out + i,
+              vaddq_f32(vmulq_f32(lr.val[0], wl), vmulq_f32(lr.val[1], wr)));
+  }
+  return i;
+}
+
+}  // namespace
+
+StereoToMono StereoToMonoNeon() { return StereoToMonoNeonImpl; }
+
+#else  // !SAMURAI_ARCH_ARM64
+
+StereoToMono StereoToMonoNeon() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_ARM64
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,70 @@
+#include "channel_mixer_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_X86)
+
+// Each iteration loads two vectors of interleaved frames and splits them
+// into left and right with shuffles; the arithmetic matches the scalar
+// loop operation for operation.
+
+namespace {
+
+SAMURAI_TARGET("sse2")
+size_t StereoToMonoSse2Impl(const float* in, size_t frames, float left,
+                            float right, float* out) {
+  const __m128 wl = _mm_set1_ps(left);
+  const __m128 wr = _mm_set1_ps(right);
+  size_t i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    const __m128 a = _mm_loadu_ps(in + i * 2);
+    const __m128 b = _mm_loadu_ps(in + i * 2 + 4);
+    const __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(l, wl), _mm_mul_ps(r, wr)));
+  }
+  return i;
+}
+
+SAMURAI_TARGET("avx2")
+size_t StereoToMonoAvx2Impl(const float* in, size_t frames, float left,
+                            float right, float* out) {
+  const __m256 wl = _mm256_set1_ps(left);
+  const __m256 wr = _mm256_set1_ps(right);
+  size_t i = 0;
+  for (; i + 8 <= frames; i += 8) {
+    const __m256 a = _mm256_loadu_ps(in + i * 2);
+    const __m256 b = _mm256_loadu_ps(in + i * 2 + 8);
+    // Per 128-bit lane: frames 0,1,4,5 | 2,3,6,7; the permute restores
+    // frame order.
+    const __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m256 mono =
+        _mm256_add_ps(_mm256_mul_ps(l, wl), _mm256_mul_ps(r, wr));
+    _mm256_storeu_ps(out + i, _mm256_castpd_ps(_mm256_permute4x64_pd(
+                                  _mm256_castps_pd(mono),
+                                  _MM_SHUFFLE(3, 1, 2, 0))));
+  }
+  return i;
+}
+
+}  // namespace
+
+StereoToMono StereoToMonoSse2() { return StereoToMonoSse2Impl; }
+StereoToMono StereoToMonoAvx2() { return StereoToMonoAvx2Impl; }
+
+#else  // !SAMURAI_ARCH_X86
+
+StereoToMono StereoToMonoSse2() { return nullptr; }
+StereoToMono StereoToMonoAvx2() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_X86
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,459 @@
+#include "samurai_audio_core/channel_protocol.h"
+
+#include "samurai_audio_core/audio_codec.h"
+#include "samurai_audio_core/channel_mixer.h"
+#include "samurai_audio_core/resampler.h"
+#include "samurai_audio_core/voice_activity.h"
+#include "samurai_audio_core/websocket_client.h"
+
+namespace samurai {
+
+namespace {
+
+ChannelValue Count(uint64_t value) {
+  return ChannelValue::Int(static_cast<int64_t>(value));
+}
+
+// Reads the optional codec / bitrate / codecFrameMs / opusApplication
+// arguments into |config|. Returns false for unknown names or out-of-range
+// values; codecs that cannot run fall back to PCM on start.
+bool ParseEncoder(const ChannelValue& args, EncoderConfig* config) {
+  const std::string codec = args.GetString("codec");
+  if (!codec.empty() && !ParseCodecId(codec, &config->codec)) {
+    return false;
+  }
+  const std::string application = args.GetString("opusApplication");
+  if (!application.empty() &&
+      !ParseOpusApplication(application, &config->application)) {
+    return false;
+  }
+  const int64_t bitrate = args.GetInt("bitrate", config->bitrate);
+  const int64_t frame_ms = args.GetInt("codecFrameMs", config->frame_ms);
+  if (bitrate <= 0 || bitrate > 1000000 || frame_ms <= 0 || frame_ms > 1000) {
+    return false;
+  }
+  config->bitrate = static_cast<uint32_t>(bitrate);
+  config->frame_ms = static_cast<uint32_t>(frame_ms);
+  return true;
+}
+
+// Reads the optional recordPath / recordCodec / recordBitrate /
+// recordWavPath arguments into |config|. Returns false for an unknown
+// codec or a bad bitrate.
+bool ParseRecording(const ChannelValue& args, RecordingConfig* config) {
+  config->path = args.GetString("recordPath");
+  config->wav_path = args.GetString("recordWavPath");
+  if (!ParseCodecId(args.GetString("recordCodec", "pcm"),
+                    &config->encoder.codec)) {
+    return false;
+  }
+  // Archive quality by default: 128 kbit/s MP3, 32 kbit/s Opus.
+  const int64_t bitrate = args.GetInt(
+      "recordBitrate",
+      config->encoder.codec == CodecId::kMp3 ? 128000 : 32000);
+  if (bitrate <= 0 || bitrate > 1000000) {
+    return false;
+  }
+  config->encoder.bitrate = static_cast<uint32_t>(bitrate);
+  config->encoder.application = OpusApplication::kAudio;
+  return true;
+}
+
+// Reads the optional channelMode / channel / outputChannels /
+// channelMatrix arguments into |map|. Returns false for an unknown mode or
+// malformed values.
+bool ParseChannelMap(const ChannelValue& args, ChannelMap* map) {
+  const std::string mode = args.GetString("channelMode");
+  if (mode.empty()) {
+    return true;
+  }
+  if (!ParseChannelMode(mode, &map->mode)) {
+    return false;
+  }
+  const int64_t channel = args.GetInt("channel", 0);
+  const int64_t outputs = args.GetInt("outputChannels", 0);
+  if (channel < 0 || channel > 255 || outputs < 0 || outputs > 255) {
+    return false;
+  }
+  map->channel = static_cast<uint16_t>(channel);
+  map->output_channels = static_cast<uint16_t>(outputs);
+  if (map->mode != ChannelMode::kMatrix) {
+    return true;
+  }
+
+  const ChannelValue* matrix = args.Find("channelMatrix");
+  if (matrix == nullptr) {
+    return false;
+  }
+  if (matrix->type() == ChannelValue::Type::kDoubleList) {
+    for (double gain : matrix->double_list()) {
+      map->matrix.push_back(static_cast<float>(gain));
+    }
+    return true;
+  }
+  if (matrix->type() != ChannelValue::Type::kList) {
+    return false;
+  }
+  for (const ChannelValue& gain : matrix->list()) {
+    if (gain.type() != ChannelValue::Type::kDouble) {
+      return false;
+    }
+    map->matrix.push_back(static_cast<float>(gain.double_value()));
+  }
+  return true;
+}
+
+// Returns the string list argument |key|; false when it is missing or
+// holds anything but strings.
+bool ParseStringList(const ChannelValue& args, const char* key,
+                     std::vector<std::string>* values) {
+  const ChannelValue* list = args.Find(key);
+  if (list == nullptr || list->type() != ChannelValue::Type::kList) {
+    return false;
+  }
+  for (const ChannelValue& value : list->list()) {
+    if (value.type() != ChannelValue::Type::kString) {
+      return false;
+    }
+    values->push_back(value.string_value());
+  }
+  return true;
+}
+
+}  // namespace
+
+ChannelResult ChannelResult::Error(std::string code, std::string message) {
+  ChannelResult result;
+  result.code = std::move(code);
+  result.message = std::move(message);
+  return result;
+}
+
+ChannelResult ChannelResult::Invalid(std::string message) {
+  return Error("INVALID_ARGUMENT", std::move(message));
+}
+
+CaptureDelivery ParseCaptureDelivery(const ChannelValue& args) {
+  const std::string delivery = args.GetString("delivery", "base64");
+  CaptureDelivery parsed;
+  parsed.native = delivery == "native";
+  parsed.binary = delivery == "binary" ||
+                  (parsed.native && args.GetBool("mirror", false));
+  return parsed;
+}
+
+StreamKind ParseStreamType(const ChannelValue& args) {
+  return args.GetString("type", "system") == "microphone"
+             ? StreamKind::kMicrophone
+             : StreamKind::kSystem;
+}
+
+ChannelResult ParseCaptureRequest(const ChannelValue& args,
+                                  CaptureRequest* request) {
+  request->device_id = args.GetString("deviceId");
+  request->delivery = ParseCaptureDelivery(args);
+
+  const std::string profile_name =
+      args.GetString("profile", CaptureProfileName(request->profile));
+  if (!ParseCaptureProfile(profile_name, &request->profile)) {
+    return ChannelResult::Invalid("Unknown capture profile: " + profile_name);
+  }
+
+  // Resampled natively; e.g. 16000 for speech backends.
+  AudioFormat format = DefaultOutputFormat();
+  const int64_t sample_rate = args.GetInt("sampleRate", format.sample_rate);
+  if (sample_rate < 8000 || sample_rate > 192000) {
+    return ChannelResult::Invalid("Unsupported sample rate: " +
+                                  std::to_string(sample_rate));
+  }
+  format.sample_rate = static_cast<uint32_t>(sample_rate);
+  CaptureSettings& settings = request->settings;
+  settings = CaptureSettingsForProfile(request->profile, format);
+
+  const std::string quality_name = args.GetString("resamplerQuality");
+  if (!quality_name.empty() &&
+      !ParseResamplerQuality(quality_name, &settings.resampler_quality)) {
+    return ChannelResult::Invalid("Unknown resampler quality: " +
+                                  quality_name);
+  }
+  if (!ParseChannelMap(args, &settings.channel_map)) {
+    return ChannelResult::Invalid("Invalid channel mapping");
+  }
+  // Any silence policy turns on voice activity detection.
+  const std::string policy_name = args.GetString("silencePolicy");
+  if (!policy_name.empty()) {
+    if (!ParseSilencePolicy(policy_name, &settings.silence_policy)) {
+      return ChannelResult::Invalid("Unknown silence policy: " + policy_name);
+    }
+    settings.vad = true;
+  }
+  if (!ParseEncoder(args, &settings.encoder)) {
+    return ChannelResult::Invalid("Invalid codec settings");
+  }
+  if (!ParseRecording(args, &settings.recording)) {
+    return ChannelResult::Invalid("Invalid recording settings");
+  }
+  // Fixed-duration PCM frames, e.g. 20 ms; 0 keeps device-sized packets.
+  const int64_t frame_ms = args.GetInt("frameMs", 0);
+  const int64_t frame_flush_ms =
+      args.GetInt("frameFlushMs", settings.frame_flush_ms);
+  if (frame_ms < 0 || frame_ms > 1000 || frame_flush_ms < 0 ||
+      frame_flush_ms > 10000) {
+    return ChannelResult::Invalid("Invalid frame settings");
+  }
+  settings.frame_ms = static_cast<uint32_t>(frame_ms);
+  settings.frame_flush_ms = static_cast<uint32_t>(frame_flush_ms);
+  // Locks the stream to the host clock, so loopback and microphone from
+  // different devices stay aligned on long calls.
+  settings.compensate_drift = args.GetBool("compensateDrift", false);
+  return ChannelResult::Ok();
+}
+
+ChannelResult ParseNativeStreamingRequest(const ChannelValue& args,
+                                          NativeStreamingRequest* request) {
+  WebSocketSinkConfig& config = request->sink;
+  config.url = args.GetString("url");
+  config.auth_token = args.GetString("authToken");
+  const int64_t max_queued = args.GetInt(
+      "maxQueuedBytes", static_cast<int64_t>(config.max_queued_bytes));
+  if (max_queued <= 0) {
+    return ChannelResult::Invalid("maxQueuedBytes must be positive");
+  }
+  config.max_queued_bytes = static_cast<size_t>(max_queued);
+  // The same bounds apply to the sink's fan-out queue, which applies the
+  // policy once the sink's own queue is full.
+  const int64_t max_queued_ms = args.GetInt("maxQueuedMs",
+                                            config.max_queued_ms);
+  if (max_queued_ms < 0 || max_queued_ms > 3600000 ||
+      !ParseBackpressurePolicy(args.GetString("queuePolicy", "drop_oldest"),
+                               &request->policy)) {
+    return ChannelResult::Invalid("Unsupported queue duration or policy");
+  }
+  config.max_queued_ms = static_cast<uint32_t>(max_queued_ms);
+  config.block_when_full = true;
+  // Spills to disk instead while the link is down or the queue is full,
+  // and replays in order, faster than real time, once it is back.
+  config.spill.directory = args.GetString("spillDirectory");
+  const int64_t spill_max = args.GetInt(
+      "spillMaxBytes", static_cast<int64_t>(config.spill.max_bytes));
+  const int64_t spill_sync_ms =
+      args.GetInt("spillSyncMs", config.spill.sync_interval_ms);
+  const int64_t replay_speed = args.GetInt("replaySpeed", 4);
+  if (spill_max <= 0 || spill_sync_ms < 0 || spill_sync_ms > 60000 ||
+      replay_speed < 0 || replay_speed > 100) {
+    return ChannelResult::Invalid("Unsupported spill settings");
+  }
+  config.spill.max_bytes = static_cast<size_t>(spill_max);
+  config.spill.sync_interval_ms = static_cast<uint32_t>(spill_sync_ms);
+  config.replay_speed = static_cast<float>(replay_speed);
+  // PCM from both speakers goes out as one stereo stream.
+  config.align_streams = args.GetBool("alignStreams", false);
+  // Cancels the customer's echo from the agent channel of that stream.
+  config.cancel_echo =
+      config.align_streams && args.GetBool("cancelEcho", false);
+
+  WebSocketUrl url;
+  if (!ParseWebSocketUrl(config.url, &url)) {
+    return ChannelResult::Invalid("Unsupported WebSocket URL: " + config.url);
+  }
+  // ws:// has no TLS; see WebSocketSinkConfig::auth_token.
+  if (!config.auth_token.empty() && !IsLoopbackHost(url.host)) {
+    return ChannelResult::Invalid(
+        "authToken would be sent in cleartext; use a loopback host");
+  }
+  return ChannelResult::Ok();
+}
+
+ChannelResult ParseConvertRequest(const ChannelValue& args,
+                                  TranscodeRequest* request) {
+  request->input_path = args.GetString("wavPath");
+  request->output_path = args.GetString("mp3Path");
+  request->encoder.codec = CodecId::kMp3;
+  request->encoder.bitrate = 192000;
+  if (request->input_path.empty() || request->output_path.empty()) {
+    return ChannelResult::Error("INVALID_ARGS",
+                                "wavPath and mp3Path are required");
+  }
+  return ChannelResult::Ok();
+}
+
+ChannelResult ParseConvertBatchRequest(
+    const ChannelValue& args, std::vector<TranscodeRequest>* requests) {
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+  EncoderConfig encoder;
+  encoder.codec = CodecId::kMp3;
+  const int64_t bitrate = args.GetInt("bitrate", 192000);
+  if (!ParseStringList(args, "inputs", &inputs) ||
+      !ParseStringList(args, "outputs", &outputs) ||
+      inputs.size() != outputs.size() ||
+      !ParseCodecId(args.GetString("codec", "mp3"), &encoder.codec) ||
+      bitrate <= 0 || bitrate > 1000000) {
+    return ChannelResult::Error(
+        "INVALID_ARGS", "inputs and outputs must be equal-length path lists");
+  }
+  encoder.bitrate = static_cast<uint32_t>(bitrate);
+  encoder.application = OpusApplication::kAudio;
+  requests->assign(inputs.size(), TranscodeRequest());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    (*requests)[i].input_path = inputs[i];
+    (*requests)[i].output_path = outputs[i];
+    (*requests)[i].encoder = encoder;
+  }
+  return ChannelResult::Ok();
+}
+
+ChannelValue DeviceListValue(const std::vector<AudioDevice>& devices) {
+  ChannelValue list = ChannelValue::EmptyList();
+  for (const AudioDevice& device : devices) {
+    ChannelValue map;
+    map.Set("id", ChannelValue::String(device.id));
+    map.Set("name", ChannelValue::String(device.name));
+    map.Set("isInput", ChannelValue::Bool(device.isInput));
+    list.Append(std::move(map));
+  }
+  return list;
+}
+
+ChannelValue StreamInfoValue(CaptureProfile profile, const StreamInfo& info) {
+  ChannelValue map;
+  map.Set("profile", ChannelValue::String(CaptureProfileName(profile)));
+  map.Set("sampleRate", ChannelValue::Int(info.format.sample_rate));
+  map.Set("channels", ChannelValue::Int(info.format.channels));
+  map.Set("sampleType",
+          ChannelValue::String(SampleTypeName(info.format.sample_type)));
+  // The negotiated codec; the format fields describe the PCM it encodes.
+  map.Set("mimeType", ChannelValue::String(info.mime_type));
+  map.Set("codec", ChannelValue::String(CodecName(info.encoder.codec)));
+  map.Set("bitrate", ChannelValue::Int(info.encoder.bitrate));
+  map.Set("codecFrameMs", ChannelValue::Int(info.encoder.frame_ms));
+  map.Set("channelMode",
+          ChannelValue::String(ChannelModeName(info.channel_mode)));
+  map.Set("deviceSampleRate",
+          ChannelValue::Int(info.device_format.sample_rate));
+  map.Set("deviceChannels", ChannelValue::Int(info.device_format.channels));
+  map.Set("deviceSampleType",
+          ChannelValue::String(SampleTypeName(info.device_format.sample_type)));
+  map.Set("eventDriven",
+          ChannelValue::Bool(info.scheduling == SchedulingMode::kEventDriven));
+  map.Set("devicePeriodMs", ChannelValue::Int(info.device_period_ms));
+  map.Set("bufferDurationMs", ChannelValue::Int(info.buffer_duration_ms));
+  map.Set("deliveryFrames", ChannelValue::Int(info.delivery_frames));
+  map.Set("frameFrames", ChannelValue::Int(info.frame_frames));
+  map.Set("queueSlots", ChannelValue::Int(info.queue_slots));
+  map.Set("queueDurationMs", ChannelValue::Int(info.queue_duration_ms));
+  map.Set("expectedLatencyMs", ChannelValue::Int(info.expected_latency_ms));
+  if (!info.recording_mime_type.empty()) {
+    map.Set("recordingMimeType",
+            ChannelValue::String(info.recording_mime_type));
+  }
+  return map;
+}
+
+ChannelValue CaptureStatsValue(const CaptureStats& stats) {
+  ChannelValue map;
+  map.Set("packetsCaptured", Count(stats.packets_captured));
+  map.Set("packetsDelivered", Count(stats.packets_delivered));
+  map.Set("overruns", Count(stats.overruns));
+  map.Set("droppedFrames", Count(stats.dropped_frames));
+  map.Set("maxCaptureNs", Count(stats.max_capture_ns));
+  map.Set("totalCaptureNs", Count(stats.total_capture_ns));
+  map.Set("wakeups", Count(stats.wakeups));
+  map.Set("idleWakeups", Count(stats.idle_wakeups));
+  map.Set("maxLatencyNs", Count(stats.max_latency_ns));
+  map.Set("totalLatencyNs", Count(stats.total_latency_ns));
+  map.Set("latencySamples", Count(stats.latency_samples));
+  map.Set("silentPackets", Count(stats.silent_packets));
+  map.Set("suppressedFrames", Count(stats.suppressed_frames));
+  map.Set("frameTimeouts", Count(stats.frame_timeouts));
+  map.Set("driftPpm", ChannelValue::Double(stats.drift_ppm));
+  map.Set("driftMs", ChannelValue::Double(stats.drift_ms));
+  map.Set("driftCorrectedFrames",
+          ChannelValue::Int(stats.drift_corrected_frames));
+  map.Set("encodedPackets", Count(stats.encoded_packets));
+  map.Set("encoderFailures", Count(stats.encoder_failures));
+  map.Set("recordedFrames", Count(stats.recorded_frames));
+  map.Set("recordingBytes", Count(stats.recording_bytes));
+  map.Set("recordingFailed", ChannelValue::Bool(stats.recording_failed));
+  return map;
+}
+
+ChannelValue SinkQueueValue(BackpressurePolicy policy,
+                            const FanOutSinkStats& stats) {
+  ChannelValue map;
+  map.Set("policy", ChannelValue::String(BackpressurePolicyName(policy)));
+  map.Set("deliveredPackets", Count(stats.delivered_packets));
+  map.Set("droppedPackets", Count(stats.dropped_packets));
+  map.Set("coalescedPackets", Count(stats.coalesced_packets));
+  map.Set("blockedPackets", Count(stats.blocked_packets));
+  map.Set("copiedPackets", Count(stats.copied_packets));
+  map.Set("queuedPackets", Count(stats.queued_packets));
+  map.Set("queuedBytes", Count(stats.queued_bytes));
+  map.Set("queuedMs", Count(stats.queued_ms));
+  map.Set("highWaterPackets", Count(stats.high_water_packets));
+  map.Set("highWaterBytes", Count(stats.high_water_bytes));
+  map.Set("highWaterMs", Count(stats.high_water_ms));
+  return map;
+}
+
+ChannelValue BatchValue(uint64_t batch, const std::vector<uint64_t>& jobs) {
+  ChannelValue ids = ChannelValue::EmptyList();
+  for (uint64_t id : jobs) {
+    ids.Append(Count(id));
+  }
+  ChannelValue map;
+  map.Set("batch", Count(batch));
+  map.Set("jobs", std::move(ids));
+  return map;
+}
+
+ChannelValue JobEventValue(const JobEvent& event) {
+  ChannelValue map;
+  map.Set("id", Count(event.id));
+  map.Set("state", ChannelValue::String(JobStateName(event.state)));
+  map.Set("progress", ChannelValue::Double(event.progress));
+  if (!event.error.empty()) {
+    map.Set("error", ChannelValue::String(event.error));
+  }
+  if (event.batch != 0) {
+    map.Set("batch", Count(event.batch));
+    map.Set("batchProgress", ChannelValue::Double(event.batch_progress));
+    map.Set("batchPending", Count(event.batch_pending));
+  }
+  return map;
+}
+
+ChannelValue StreamEventValue(const WebSocketSinkEvent& event) {
+  ChannelValue map;
+  map.Set("state", ChannelValue::String(WebSocketSinkStateName(event.state)));
+  if (!event.error.empty()) {
+    map.Set("error", ChannelValue::String(event.error));
+  }
+  const WebSocketSinkStats& stats = event.stats;
+  map.Set("messagesSent", Count(stats.messages_sent));
+  map.Set("bytesSent", Count(stats.bytes_sent));
+  map.Set("messagesDropped", Count(stats.messages_dropped));
+  map.Set("messagesReceived", Count(stats.messages_received));
+  map.Set("reconnects", Count(stats.reconnects));
+  map.Set("messagesBlocked", Count(stats.messages_blocked));
+  map.Set("queuedBytes", Count(stats.queued_bytes));
+  map.Set("queuedMs", Count(stats.queued_ms));
+  map.Set("highWaterBytes", Count(stats.high_water_bytes));
+  map.Set("highWaterMs", Count(stats.high_water_ms));
+  map.Set("messagesSpilled", Count(stats.messages_spilled));
+  map.Set("messagesReplayed", Count(stats.messages_replayed));
+  map.Set("spillDropped", Count(stats.spill_dropped));
+  map.Set("spillQueuedBytes", Count(stats.spill_queued_bytes));
+  map.Set("spillQueuedMs", Count(stats.spill_queued_ms));
+  map.Set("spillDiskBytes", Count(stats.spill_disk_bytes));
+  map.Set("maxSendNs", Count(stats.max_send_ns));
+  map.Set("alignedFilledFrames", Count(stats.aligned_filled_frames));
+  map.Set("alignedLateFrames", Count(stats.aligned_late_frames));
+  map.Set("echoProcessedFrames", Count(stats.echo_processed_frames));
+  map.Set("echoBypassedFrames", Count(stats.echo_bypassed_frames));
+  map.Set("echoCpuNs", Count(stats.echo_cpu_ns));
+  map.Set("echoErleDb", ChannelValue::Double(stats.echo_erle_db));
+  return map;
+}
+
+}  // namespace samurai
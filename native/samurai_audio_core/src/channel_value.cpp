@@ -0,0 +1,100 @@
+#include "samurai_audio_core/channel_value.h"
+
+namespace samurai {
+
+ChannelValue ChannelValue::Bool(bool value) {
+  ChannelValue result;
+  result.type_ = Type::kBool;
+  result.bool_ = value;
+  return result;
+}
+
+ChannelValue ChannelValue::Int(int64_t value) {
+  ChannelValue result;
+  result.type_ = Type::kInt;
+  result.int_ = value;
+  return result;
+}
+
+ChannelValue ChannelValue::Double(double value) {
+  ChannelValue result;
+  result.type_ = Type::kDouble;
+  result.double_ = value;
+  return result;
+}
+
+ChannelValue ChannelValue::String(std::string value) {
+  ChannelValue result;
+  result.type_ = Type::kString;
+  result.string_ = std::move(value);
+  return result;
+}
+
+ChannelValue ChannelValue::DoubleList(std::vector<double> values) {
+  ChannelValue result;
+  result.type_ = Type::kDoubleList;
+  result.double_list_ = std::move(values);
+  return result;
+}
+
+ChannelValue ChannelValue::EmptyList() {
+  ChannelValue result;
+  result.type_ = Type::kList;
+  return result;
+}
+
+ChannelValue ChannelValue::EmptyMap() {
+  ChannelValue result;
+  result.type_ = Type::kMap;
+  return result;
+}
+
+void ChannelValue::Append(ChannelValue value) {
+  if (type_ == Type::kNull) {
+    type_ = Type::kList;
+  }
+  list_.push_back(std::move(value));
+}
+
+void ChannelValue::Set(const std::string& key, ChannelValue value) {
+  if (type_ == Type::kNull) {
+    type_ = Type::kMap;
+  }
+  for (auto& entry : map_) {
+    if (entry.first == key) {
+      entry.second = std::move(value);
+      return;
+    }
+  }
+  map_.emplace_back(key, std::move(value));
+}
+
+const ChannelValue* ChannelValue::Find(const char* key) const {
+  if (type_ != Type::kMap) {
+    return nullptr;
+  }
+  for (const auto& entry : map_) {
+    if (entry.first == key) {
+      return &entry.second;
+    }
+  }
+  return nullptr;
+}
+
+std::string ChannelValue::GetString(const char* key,
+                                    const std::string& fallback) const {
+  const ChannelValue* value = Find(key);
+  return value && value->type_ == Type::kString ? value->string_ : fallback;
+}
+
+int64_t ChannelValue::GetInt(const char* key, int64_t fallback) const {
+  const ChannelValue* value = Find(key);
+  return value && value->type_ == Type::kInt ? value->int_ : fallback;
+}
+
+bool ChannelValue::GetBool(const char* key, bool fallback) const {
+  const ChannelValue* value = Find(key);
+  return value && value->type_ == Type::kBool ? value->bool_ : fallback;
+}
+
+}  // namespace samurai
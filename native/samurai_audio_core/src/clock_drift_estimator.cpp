@@ -0,0 +1,100 @@
+#include "samurai_audio_core/clock_drift_estimator.h"
+
+#include <algorithm>
+
+namespace samurai {
+
+ClockDriftEstimator::ClockDriftEstimator(uint32_t nominal_rate,
+                                         const DriftEstimatorConfig& config)
+    : nominal_rate_(nominal_rate), config_(config) {
+  config_.interval_ms = std::max<uint32_t>(1, config_.interval_ms);
+  points_.resize(std::max<uint32_t>(
+      2, config_.window_ms / config_.interval_ms + 1));
+}
+
+void ClockDriftEstimator::Reset() {
+  head_ = 0;
+  count_ = 0;
+  started_ = false;
+  locked_ = false;
+  ratio_ = 1.0;
+}
+
+void ClockDriftEstimator::Update(uint64_t position, int64_t time_ns) {
+  if (started_ && (position < last_position_ || time_ns < last_time_ns_)) {
+    Reset();
+  }
+  if (!started_) {
+    started_ = true;
+    first_position_ = position;
+    first_time_ns_ = time_ns;
+  }
+  last_position_ = position;
+  last_time_ns_ = time_ns;
+
+  const Point point{static_cast<double>(time_ns - first_time_ns_) / 1e9,
+                    static_cast<double>(position - first_position_)};
+  const size_t capacity = points_.size();
+  if (count_ > 0) {
+    const Point& newest = points_[(head_ + count_ - 1) % capacity];
+    if (point.seconds - newest.seconds < config_.interval_ms / 1000.0) {
+      return;
+    }
+  }
+  if (count_ == capacity) {
+    head_ = (head_ + 1) % capacity;
+    --count_;
+  }
+  points_[(head_ + count_) % capacity] = point;
+  ++count_;
+  const double window = config_.window_ms / 1000.0;
+  while (count_ > 2 && point.seconds - points_[head_].seconds > window) {
+    head_ = (head_ + 1) % capacity;
+    --count_;
+  }
+  Fit();
+}
+
+void ClockDriftEstimator::Fit() {
+  const size_t capacity = points_.size();
+  const Point& oldest = points_[head_];
+  const Point& newest = points_[(head_ + count_ - 1) % capacity];
+  if (count_ < 2 ||
+      newest.seconds - oldest.seconds < config_.min_span_ms / 1000.0) {
+    return;
+  }
+  // Centred sums, so hours of frames lose no precision in the squares.
+  double mean_seconds = 0.0;
+  double mean_frames = 0.0;
+  for (size_t i = 0; i < count_; ++i) {
+    const Point& p = points_[(head_ + i) % capacity];
+    mean_seconds += p.seconds;
+    mean_frames += p.frames;
+  }
+  mean_seconds /= count_;
+  mean_frames /= count_;
+  double sxx = 0.0;
+  double sxy = 0.0;
+  for (size_t i = 0; i < count_; ++i) {
+    const Point& p = points_[(head_ + i) % capacity];
+    const double dx = p.seconds - mean_seconds;
+    sxx += dx * dx;
+    sxy += dx * (p.frames - mean_frames);
+  }
+  if (sxx <= 0.0 || nominal_rate_ <= 0.0) {
+    return;
+  }
+  ratio_ = sxy / sxx / nominal_rate_;
+  locked_ = true;
+}
+
+double ClockDriftEstimator::drift_ns() const {
+  if (!started_ || nominal_rate_ <= 0.0) {
+    return 0.0;
+  }
+  return static_cast<double>(last_position_ - first_position_) * 1e9 /
+             nominal_rate_ -
+         static_cast<double>(last_time_ns_ - first_time_ns_);
+}
+
+}  // namespace samurai
@@ -0,0 +1,76 @@
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace samurai {
+
+namespace {
+
+#if defined(SAMURAI_ARCH_X86)
+
+void Cpuid(int leaf, int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuidex(info, leaf, subleaf);
+  for (int i = 0; i < 4; ++i) {
+    regs[i] = static_cast<unsigned int>(info[i]);
+  }
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+unsigned long long Xgetbv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  unsigned int eax = 0;
+  unsigned int edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+#endif  // SAMURAI_ARCH_X86
+
+CpuFeatures Detect() {
+  CpuFeatures features;
+#if defined(SAMURAI_ARCH_X86)
+  unsigned int regs[4];
+  Cpuid(0, 0, regs);
+  const unsigned int max_leaf = regs[0];
+
+  Cpuid(1, 0, regs);
+  features.sse2 = (regs[3] & (1u << 26)) != 0;
+  features.ssse3 = (regs[2] & (1u << 9)) != 0;
+  features.sse41 = (regs[2] & (1u << 19)) != 0;
+  const bool fma = (regs[2] & (1u << 12)) != 0;
+  const bool osxsave = (regs[2] & (1u << 27)) != 0;
+  const bool ymm_enabled = osxsave && (Xgetbv() & 0x6) == 0x6;
+
+  if (max_leaf >= 7) {
+    Cpuid(7, 0, regs);
+    features.avx2 = ymm_enabled && (regs[1] & (1u << 5)) != 0;
+  }
+  features.fma = ymm_enabled && fma;
+#elif defined(SAMURAI_ARCH_ARM64)
+  // Advanced SIMD is mandatory on AArch64.
+  features.neon = true;
+#endif
+  return features;
+}
+
+}  // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+  static const CpuFeatures features = Detect();
+  return features;
+}
+
+}  // namespace samurai
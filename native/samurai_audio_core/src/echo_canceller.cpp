@@ -0,0 +1,248 @@
+#include "samurai_audio_core/echo_canceller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "fft_internal.h"
+
+namespace samurai {
+
+namespace {
+
+// Far-end blocks quieter than this mean square (about -70 dBFS) carry no
+// echo worth adapting to.
+constexpr double kFarActivity = 1e-7;
+// Per-block smoothing of the far-end power spectrum and of the energies
+// comparing the two filters.
+constexpr float kPowerSmoothing = 0.9f;
+constexpr double kEnergySmoothing = 0.9;
+// The background replaces the foreground once it leaves this much less
+// error, and is reset from it when it leaves this much more.
+constexpr double kCopyRatio = 0.8;
+constexpr double kDivergedRatio = 4.0;
+
+double Energy(const float* samples, size_t n) {
+  double sum = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    sum += static_cast<double>(samples[i]) * samples[i];
+  }
+  return sum;
+}
+
+}  // namespace
+
+EchoCanceller::EchoCanceller(uint32_t sample_rate, uint32_t block_frames,
+                             const EchoCancellerConfig& config)
+    : EchoCanceller(sample_rate, block_frames, config, FftBestImpl()) {}
+
+EchoCanceller::EchoCanceller(uint32_t sample_rate, uint32_t block_frames,
+                             const EchoCancellerConfig& config, FftImpl impl)
+    : sample_rate_(sample_rate),
+      block_(block_frames),
+      config_(config),
+      fft_(2 * static_cast<size_t>(block_frames), impl) {
+  if (sample_rate == 0 || block_frames < 16 || block_frames > 1024 ||
+      (block_frames & (block_frames - 1)) != 0 || !fft_.IsValid() ||
+      !(config.step > 0.0f && config.step <= 1.0f)) {
+    return;
+  }
+  const uint64_t tail_frames =
+      std::max<uint64_t>(1, static_cast<uint64_t>(config.tail_ms) *
+                                sample_rate / 1000);
+  partitions_ = static_cast<uint32_t>((tail_frames + block_ - 1) / block_);
+  bins_ = fft_.bins();
+  padded_bins_ = (bins_ + 7) & ~static_cast<size_t>(7);
+
+  const size_t spectra = static_cast<size_t>(partitions_) * padded_bins_;
+  for (Spectra* s : {&far_, &foreground_, &background_}) {
+    s->re.resize(spectra);
+    s->im.resize(spectra);
+  }
+  for (Spectra* s : {&sum_, &error_}) {
+    s->re.resize(padded_bins_);
+    s->im.resize(padded_bins_);
+  }
+  far_power_.resize(bins_);
+  far_window_.resize(2 * block_);
+  time_.resize(2 * block_);
+  echo_.resize(block_);
+  background_error_.resize(block_);
+  valid_ = true;
+  Reset();
+}
+
+void EchoCanceller::Reset() {
+  if (!valid_) {
+    return;
+  }
+  for (Spectra* s : {&foreground_, &background_}) {
+    std::fill(s->re.begin(), s->re.end(), 0.0f);
+    std::fill(s->im.begin(), s->im.end(), 0.0f);
+  }
+  std::fill(far_power_.begin(), far_power_.end(), 0.0f);
+  ClearHistory();
+  constrain_next_ = 0;
+  near_energy_ = 0.0;
+  foreground_energy_ = 0.0;
+  background_energy_ = 0.0;
+  erle_near_ = 0.0;
+  erle_out_ = 0.0;
+}
+
+void EchoCanceller::ClearHistory() {
+  std::fill(far_.re.begin(), far_.re.end(), 0.0f);
+  std::fill(far_.im.begin(), far_.im.end(), 0.0f);
+  std::fill(far_window_.begin(), far_window_.end(), 0.0f);
+  head_ = 0;
+}
+
+bool EchoCanceller::Process(const float* far, const float* near, size_t frames,
+                            float* out) {
+  if (!valid_ || frames % block_ != 0) {
+    return false;
+  }
+  const uint64_t allowance_ns =
+      static_cast<uint64_t>(config_.cpu_budget_percent) * 10000000;
+  for (size_t done = 0; done < frames; done += block_) {
+    if (over_budget_) {
+      if (out != near) {
+        std::memcpy(out + done, near + done, block_ * sizeof(float));
+      }
+      stats_.bypassed_frames += block_;
+    } else {
+      const auto start = std::chrono::steady_clock::now();
+      ProcessBlock(far + done, near + done, out + done);
+      const uint64_t ns = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+      stats_.processed_frames += block_;
+      stats_.cpu_ns += ns;
+      budget_ns_ += ns;
+      over_budget_ = allowance_ns > 0 && budget_ns_ > allowance_ns;
+    }
+    budget_frames_ += block_;
+    if (budget_frames_ >= sample_rate_) {
+      // The far history skipped while bypassing no longer lines up.
+      if (over_budget_) {
+        ClearHistory();
+      }
+      budget_frames_ = 0;
+      budget_ns_ = 0;
+      over_budget_ = false;
+    }
+  }
+  return true;
+}
+
+void EchoCanceller::Estimate(const Spectra& filter, float* y) {
+  const internal::FftKernels* kernels = internal::FftKernelsFor(fft_.impl());
+  std::fill(sum_.re.begin(), sum_.re.end(), 0.0f);
+  std::fill(sum_.im.begin(), sum_.im.end(), 0.0f);
+  for (uint32_t p = 0; p < partitions_; ++p) {
+    const size_t x = ((head_ + p) % partitions_) * padded_bins_;
+    const size_t w = static_cast<size_t>(p) * padded_bins_;
+    kernels->multiply_accumulate(far_.re.data() + x, far_.im.data() + x,
+                                 filter.re.data() + w, filter.im.data() + w,
+                                 sum_.re.data(), sum_.im.data(),
+                                 padded_bins_);
+  }
+  // Overlap-save: only the second half is linear convolution.
+  fft_.Inverse(sum_.re.data(), sum_.im.data(), time_.data());
+  std::memcpy(y, time_.data() + block_, block_ * sizeof(float));
+}
+
+void EchoCanceller::ProcessBlock(const float* far, const float* near,
+                                 float* out) {
+  const internal::FftKernels* kernels = internal::FftKernelsFor(fft_.impl());
+  const size_t n = block_;
+
+  // The newest far-end window becomes partition 0.
+  std::memmove(far_window_.data(), far_window_.data() + n, n * sizeof(float));
+  std::memcpy(far_window_.data() + n, far, n * sizeof(float));
+  head_ = (head_ + partitions_ - 1) % partitions_;
+  float* xr = far_.re.data() + head_ * padded_bins_;
+  float* xi = far_.im.data() + head_ * padded_bins_;
+  fft_.Forward(far_window_.data(), xr, xi);
+  for (size_t k = 0; k < bins_; ++k) {
+    far_power_[k] = kPowerSmoothing * far_power_[k] +
+                    (1.0f - kPowerSmoothing) * (xr[k] * xr[k] + xi[k] * xi[k]);
+  }
+  const bool far_active = Energy(far, n) > kFarActivity * n;
+
+  // Both filters' errors; |out| may alias |near|, so it is written last.
+  Estimate(background_, echo_.data());
+  for (size_t i = 0; i < n; ++i) {
+    background_error_[i] = near[i] - echo_[i];
+  }
+  Estimate(foreground_, echo_.data());
+  const double near_energy = Energy(near, n);
+  for (size_t i = 0; i < n; ++i) {
+    echo_[i] = near[i] - echo_[i];
+  }
+  const double foreground_energy = Energy(echo_.data(), n);
+  const double background_energy = Energy(background_error_.data(), n);
+  near_energy_ = kEnergySmoothing * near_energy_ + near_energy;
+  foreground_energy_ = kEnergySmoothing * foreground_energy_ +
+                       foreground_energy;
+  background_energy_ = kEnergySmoothing * background_energy_ +
+                       background_energy;
+
+  const float* result = echo_.data();
+  if (far_active) {
+    // NLMS on the background: each bin's step is normalised by the far
+    // end's power there, so quiet bands adapt as fast as loud ones.
+    std::fill(time_.begin(), time_.begin() + n, 0.0f);
+    std::memcpy(time_.data() + n, background_error_.data(),
+                n * sizeof(float));
+    fft_.Forward(time_.data(), error_.re.data(), error_.im.data());
+    const float regularization = 1e-6f * static_cast<float>(2 * n);
+    for (size_t k = 0; k < bins_; ++k) {
+      const float gain =
+          config_.step /
+          (static_cast<float>(partitions_) * far_power_[k] + regularization);
+      error_.re[k] *= gain;
+      error_.im[k] *= gain;
+    }
+    for (uint32_t p = 0; p < partitions_; ++p) {
+      const size_t x = ((head_ + p) % partitions_) * padded_bins_;
+      const size_t w = static_cast<size_t>(p) * padded_bins_;
+      kernels->conj_multiply_accumulate(
+          far_.re.data() + x, far_.im.data() + x, error_.re.data(),
+          error_.im.data(), background_.re.data() + w,
+          background_.im.data() + w, padded_bins_);
+    }
+
+    // Keep one partition per block to N taps, so circular wrap-around
+    // cannot build up; every partition is visited once per tail.
+    const size_t w = static_cast<size_t>(constrain_next_) * padded_bins_;
+    fft_.Inverse(background_.re.data() + w, background_.im.data() + w,
+                 time_.data());
+    std::fill(time_.begin() + n, time_.end(), 0.0f);
+    fft_.Forward(time_.data(), background_.re.data() + w,
+                 background_.im.data() + w);
+    constrain_next_ = (constrain_next_ + 1) % partitions_;
+
+    if (background_energy_ < kCopyRatio * foreground_energy_) {
+      foreground_.re = background_.re;
+      foreground_.im = background_.im;
+      foreground_energy_ = background_energy_;
+      result = background_error_.data();
+    } else if (background_energy_ > kDivergedRatio * foreground_energy_ &&
+               background_energy_ > near_energy_) {
+      background_.re = foreground_.re;
+      background_.im = foreground_.im;
+      background_energy_ = foreground_energy_;
+    }
+
+    erle_near_ = 0.98 * erle_near_ + near_energy;
+    erle_out_ = 0.98 * erle_out_ + Energy(result, n);
+    stats_.erle_db = 10.0 * std::log10((erle_near_ + 1e-20) /
+                                       (erle_out_ + 1e-20));
+  }
+  std::memcpy(out, result, n * sizeof(float));
+}
+
+}  // namespace samurai
@@ -0,0 +1,242 @@
+#include "samurai_audio_core/fft.h"
+
+#include <cmath>
+
+#include "fft_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+namespace samurai {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+void ButterfliesScalar(float* re, float* im, const float* wr, const float* wi,
+                       size_t h) {
+  for (size_t j = 0; j < h; ++j) {
+    const float br = re[j + h];
+    const float bi = im[j + h];
+    const float tr = br * wr[j] - bi * wi[j];
+    const float ti = br * wi[j] + bi * wr[j];
+    re[j + h] = re[j] - tr;
+    im[j + h] = im[j] - ti;
+    re[j] += tr;
+    im[j] += ti;
+  }
+}
+
+void MultiplyAccumulateScalar(const float* ar, const float* ai,
+                              const float* br, const float* bi, float* yr,
+                              float* yi, size_t n) {
+  for (size_t k = 0; k < n; ++k) {
+    yr[k] += ar[k] * br[k] - ai[k] * bi[k];
+    yi[k] += ar[k] * bi[k] + ai[k] * br[k];
+  }
+}
+
+void ConjMultiplyAccumulateScalar(const float* ar, const float* ai,
+                                  const float* br, const float* bi, float* yr,
+                                  float* yi, size_t n) {
+  for (size_t k = 0; k < n; ++k) {
+    yr[k] += ar[k] * br[k] + ai[k] * bi[k];
+    yi[k] += ar[k] * bi[k] - ai[k] * br[k];
+  }
+}
+
+const internal::FftKernels kScalarKernels = {
+    ButterfliesScalar, MultiplyAccumulateScalar, ConjMultiplyAccumulateScalar};
+
+}  // namespace
+
+namespace internal {
+
+const FftKernels* FftKernelsFor(FftImpl impl) {
+  const FftKernels* kernels = nullptr;
+  switch (impl) {
+    case FftImpl::kSse2:
+      kernels = FftKernelsSse2();
+      break;
+    case FftImpl::kAvx2:
+      kernels = FftKernelsAvx2();
+      break;
+    case FftImpl::kNeon:
+      kernels = FftKernelsNeon();
+      break;
+    case FftImpl::kScalar:
+      break;
+  }
+  return kernels ? kernels : &kScalarKernels;
+}
+
+}  // namespace internal
+
+const char* FftImplName(FftImpl impl) {
+  switch (impl) {
+    case FftImpl::kScalar:
+      return "scalar";
+    case FftImpl::kSse2:
+      return "sse2";
+    case FftImpl::kAvx2:
+      return "avx2";
+    case FftImpl::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool FftImplSupported(FftImpl impl) {
+  const CpuFeatures& cpu = GetCpuFeatures();
+  switch (impl) {
+    case FftImpl::kScalar:
+      return true;
+#if defined(SAMURAI_ARCH_X86)
+    case FftImpl::kSse2:
+      return cpu.sse2;
+    case FftImpl::kAvx2:
+      return cpu.avx2 && cpu.fma;
+#endif
+#if defined(SAMURAI_ARCH_ARM64)
+    case FftImpl::kNeon:
+      return cpu.neon;
+#endif
+    default:
+      break;
+  }
+  return false;
+}
+
+FftImpl FftBestImpl() {
+  static const FftImpl best = []() {
+    for (FftImpl impl : {FftImpl::kAvx2, FftImpl::kNeon, FftImpl::kSse2}) {
+      if (FftImplSupported(impl)) {
+        return impl;
+      }
+    }
+    return FftImpl::kScalar;
+  }();
+  return best;
+}
+
+RealFft::RealFft(size_t size) : RealFft(size, FftBestImpl()) {}
+
+RealFft::RealFft(size_t size, FftImpl impl)
+    : size_(size), half_(size / 2), impl_(impl) {
+  if (size < 4 || size > 65536 || (size & (size - 1)) != 0 ||
+      !FftImplSupported(impl)) {
+    return;
+  }
+  uint32_t bits = 0;
+  while ((size_t{1} << bits) < half_) {
+    ++bits;
+  }
+  bit_reverse_.resize(half_);
+  for (size_t i = 0; i < half_; ++i) {
+    uint32_t reversed = 0;
+    for (uint32_t b = 0; b < bits; ++b) {
+      reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+    }
+    bit_reverse_[i] = reversed;
+  }
+
+  // Twiddles in double, rounded once.
+  stage_re_.resize(half_);
+  stage_im_.resize(half_);
+  for (size_t h = 1; h < half_; h *= 2) {
+    for (size_t j = 0; j < h; ++j) {
+      const double angle = -kPi * static_cast<double>(j) / h;
+      stage_re_[h - 1 + j] = static_cast<float>(std::cos(angle));
+      stage_im_[h - 1 + j] = static_cast<float>(std::sin(angle));
+    }
+  }
+  split_re_.resize(half_ + 1);
+  split_im_.resize(half_ + 1);
+  for (size_t k = 0; k <= half_; ++k) {
+    const double angle = -2.0 * kPi * static_cast<double>(k) / size_;
+    split_re_[k] = static_cast<float>(std::cos(angle));
+    split_im_[k] = static_cast<float>(std::sin(angle));
+  }
+  work_re_.resize(half_);
+  work_im_.resize(half_);
+  valid_ = true;
+}
+
+void RealFft::Transform() {
+  float* re = work_re_.data();
+  float* im = work_im_.data();
+  // The first stages have too few butterflies per group for the vector
+  // kernels.
+  size_t h = 1;
+  for (; h < half_ && h < 8; h *= 2) {
+    for (size_t g = 0; g < half_; g += 2 * h) {
+      ButterfliesScalar(re + g, im + g, stage_re_.data() + h - 1,
+                        stage_im_.data() + h - 1, h);
+    }
+  }
+  const internal::FftKernels* kernels = internal::FftKernelsFor(impl_);
+  for (; h < half_; h *= 2) {
+    for (size_t g = 0; g < half_; g += 2 * h) {
+      kernels->butterflies(re + g, im + g, stage_re_.data() + h - 1,
+                           stage_im_.data() + h - 1, h);
+    }
+  }
+}
+
+void RealFft::Forward(const float* in, float* re, float* im) {
+  if (!valid_) {
+    return;
+  }
+  // Even samples as real parts, odd as imaginary.
+  for (size_t n = 0; n < half_; ++n) {
+    work_re_[bit_reverse_[n]] = in[2 * n];
+    work_im_[bit_reverse_[n]] = in[2 * n + 1];
+  }
+  Transform();
+
+  // Z[k] mixes the spectra of the even and odd samples; separate them and
+  // combine with one more twiddle.
+  for (size_t k = 0; k <= half_; ++k) {
+    const size_t a = k % half_;
+    const size_t b = (half_ - k) % half_;
+    const float ar = work_re_[a];
+    const float ai = work_im_[a];
+    const float br = work_re_[b];
+    const float bi = work_im_[b];
+    const float even_re = 0.5f * (ar + br);
+    const float even_im = 0.5f * (ai - bi);
+    const float odd_re = 0.5f * (ai + bi);
+    const float odd_im = -0.5f * (ar - br);
+    re[k] = even_re + split_re_[k] * odd_re - split_im_[k] * odd_im;
+    im[k] = even_im + split_re_[k] * odd_im + split_im_[k] * odd_re;
+  }
+}
+
+void RealFft::Inverse(const float* re, const float* im, float* out) {
+  if (!valid_) {
+    return;
+  }
+  // Undo the split step, conjugated so the forward transform inverts.
+  for (size_t k = 0; k < half_; ++k) {
+    const float ar = re[k];
+    const float ai = k == 0 ? 0.0f : im[k];
+    const float br = re[half_ - k];
+    const float bi = k == 0 ? 0.0f : -im[half_ - k];
+    const float even_re = 0.5f * (ar + br);
+    const float even_im = 0.5f * (ai + bi);
+    const float diff_re = 0.5f * (ar - br);
+    const float diff_im = 0.5f * (ai - bi);
+    // odd = diff * conj(split[k])
+    const float odd_re = diff_re * split_re_[k] + diff_im * split_im_[k];
+    const float odd_im = diff_im * split_re_[k] - diff_re * split_im_[k];
+    // Z = even + i * odd, stored conjugated.
+    work_re_[bit_reverse_[k]] = even_re - odd_im;
+    work_im_[bit_reverse_[k]] = -(even_im + odd_re);
+  }
+  Transform();
+  const float scale = 1.0f / static_cast<float>(half_);
+  for (size_t n = 0; n < half_; ++n) {
+    out[2 * n] = work_re_[n] * scale;
+    out[2 * n + 1] = -work_im_[n] * scale;
+  }
+}
+
+}  // namespace samurai
@@ -0,0 +1,40 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_FFT_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_FFT_INTERNAL_H_
+
+#include <cstddef>
+
+#include "samurai_audio_core/fft.h"
+
+namespace samurai {
+namespace internal {
+
+// Split-format kernels. |h| and |n| are multiples of 8 (the FFT runs
+// narrower stages itself and spectra are padded), so no kernel needs a
+// scalar tail.
+struct FftKernels {
+  // One radix-2 stage of one group: pairs element j with j + h, twiddled
+  // by (wr[j], wi[j]).
+  void (*butterflies)(float* re, float* im, const float* wr, const float* wi,
+                      size_t h);
+  // y += a * b, complex, over |n| bins.
+  void (*multiply_accumulate)(const float* ar, const float* ai,
+                              const float* br, const float* bi, float* yr,
+                              float* yi, size_t n);
+  // y += conj(a) * b, complex, over |n| bins.
+  void (*conj_multiply_accumulate)(const float* ar, const float* ai,
+                                   const float* br, const float* bi,
+                                   float* yr, float* yi, size_t n);
+};
+
+// Never null: falls back to the scalar kernels.
+const FftKernels* FftKernelsFor(FftImpl impl);
+
+// Null on architectures without the instruction set.
+const FftKernels* FftKernelsSse2();
+const FftKernels* FftKernelsAvx2();
+const FftKernels* FftKernelsNeon();
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_FFT_INTERNAL_H_
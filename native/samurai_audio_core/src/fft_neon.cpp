@@ -0,0 +1,74 @@
+#include "fft_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_ARM64)
+
+// Same split-format structure as the x86 kernels.
+
+namespace {
+
+void ButterfliesNeon(float* re, float* im, const float* wr, const float* wi,
+                     size_t h) {
+  for (size_t j = 0; j < h; j += 4) {
+    const float32x4_t br = vld1q_f32(re + j + h);
+    const float32x4_t bi = vld1q_f32(im + j + h);
+    const float32x4_t cr = vld1q_f32(wr + j);
+    const float32x4_t ci = vld1q_f32(wi + j);
+    const float32x4_t tr = vfmsq_f32(vmulq_f32(br, cr), bi, ci);
+    const float32x4_t ti = vfmaq_f32(vmulq_f32(br, ci), bi, cr);
+    const float32x4_t ar = vld1q_f32(re + j);
+    const float32x4_t ai = vld1q_f32(im + j);
+    vst1q_f32(re + j + h, vsubq_f32(ar, tr));
+    vst1q_f32(im + j + h, vsubq_f32(ai, ti));
+    vst1q_f32(re + j, vaddq_f32(ar, tr));
+    vst1q_f32(im + j, vaddq_f32(ai, ti));
+  }
+}
+
+void MultiplyAccumulateNeon(const float* ar, const float* ai, const float* br,
+                            const float* bi, float* yr, float* yi, size_t n) {
+  for (size_t k = 0; k < n; k += 4) {
+    const float32x4_t xr = vld1q_f32(ar + k);
+    const float32x4_t xi = vld1q_f32(ai + k);
+    const float32x4_t wr = vld1q_f32(br + k);
+    const float32x4_t wi = vld1q_f32(bi + k);
+    vst1q_f32(yr + k, vfmsq_f32(vfmaq_f32(vld1q_f32(yr + k), xr, wr), xi, wi));
+    vst1q_f32(yi + k, vfmaq_f32(vfmaq_f32(vld1q_f32(yi + k), xr, wi), xi, wr));
+  }
+}
+
+void ConjMultiplyAccumulateNeon(const float* ar, const float* ai,
+                                const float* br, const float* bi, float* yr,
+                                float* yi, size_t n) {
+  for (size_t k = 0; k < n; k += 4) {
+    const float32x4_t xr = vld1q_f32(ar + k);
+    const float32x4_t xi = vld1q_f32(ai + k);
+    const float32x4_t er = vld1q_f32(br + k);
+    const float32x4_t ei = vld1q_f32(bi + k);
+    vst1q_f32(yr + k, vfmaq_f32(vfmaq_f32(vld1q_f32(yr + k), xr, er), xi, ei));
+    vst1q_f32(yi + k, vfmsq_f32(vfmaq_f32(vld1q_f32(yi + k), xr, ei), xi, er));
+  }
+}
+
+const FftKernels kNeonKernels = {ButterfliesNeon, MultiplyAccumulateNeon,
+                                 ConjMultiplyAccumulateNeon};
+
+}  // namespace
+
+const FftKernels* FftKernelsNeon() { return &kNeonKernels; }
+
+#else  // !SAMURAI_ARCH_ARM64
+
+const FftKernels* FftKernelsNeon() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_ARM64
+
+}  // namespace internal
+}  // namespace samurai
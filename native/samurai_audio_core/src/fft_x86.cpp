@@ -0,0 +1,149 @@
+#include "fft_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_X86)
+
+// Split format keeps real and imaginary parts in separate lanes, so a
+// complex multiply is four plain multiplies with no shuffles.
+
+namespace {
+
+SAMURAI_TARGET("sse2")
+void ButterfliesSse2(float* re, float* im, const float* wr, const float* wi,
+                     size_t h) {
+  for (size_t j = 0; j < h; j += 4) {
+    const __m128 br = _mm_loadu_ps(re + j + h);
+    const __m128 bi = _mm_loadu_ps(im + j + h);
+    const __m128 cr = _mm_loadu_ps(wr + j);
+    const __m128 ci = _mm_loadu_ps(wi + j);
+    const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, cr), _mm_mul_ps(bi, ci));
+    const __m128 ti = _mm_add_ps(_mm_mul_ps(br, ci), _mm_mul_ps(bi, cr));
+    const __m128 ar = _mm_loadu_ps(re + j);
+    const __m128 ai = _mm_loadu_ps(im + j);
+    _mm_storeu_ps(re + j + h, _mm_sub_ps(ar, tr));
+    _mm_storeu_ps(im + j + h, _mm_sub_ps(ai, ti));
+    _mm_storeu_ps(re + j, _mm_add_ps(ar, tr));
+    _mm_storeu_ps(im + j, _mm_add_ps(ai, ti));
+  }
+}
+
+SAMURAI_TARGET("sse2")
+void MultiplyAccumulateSse2(const float* ar, const float* ai, const float* br,
+                            const float* bi, float* yr, float* yi, size_t n) {
+  for (size_t k = 0; k < n; k += 4) {
+    const __m128 xr = _mm_loadu_ps(ar + k);
+    const __m128 xi = _mm_loadu_ps(ai + k);
+    const __m128 wr = _mm_loadu_ps(br + k);
+    const __m128 wi = _mm_loadu_ps(bi + k);
+    _mm_storeu_ps(yr + k,
+                  _mm_add_ps(_mm_loadu_ps(yr + k),
+                             _mm_sub_ps(_mm_mul_ps(xr, wr),
+                                        _mm_mul_ps(xi, wi))));
+    _mm_storeu_ps(yi + k,
+                  _mm_add_ps(_mm_loadu_ps(yi + k),
+                             _mm_add_ps(_mm_mul_ps(xr, wi),
+                                        _mm_mul_ps(xi, wr))));
+  }
+}
+
+SAMURAI_TARGET("sse2")
+void ConjMultiplyAccumulateSse2(const float* ar, const float* ai,
+                                const float* br, const float* bi, float* yr,
+                                float* yi, size_t n) {
+  for (size_t k = 0; k < n; k += 4) {
+    const __m128 xr = _mm_loadu_ps(ar + k);
+    const __m128 xi = _mm_loadu_ps(ai + k);
+    const __m128 er = _mm_loadu_ps(br + k);
+    const __m128 ei = _mm_loadu_ps(bi + k);
+    _mm_storeu_ps(yr + k,
+                  _mm_add_ps(_mm_loadu_ps(yr + k),
+                             _mm_add_ps(_mm_mul_ps(xr, er),
+                                        _mm_mul_ps(xi, ei))));
+    _mm_storeu_ps(yi + k,
+                  _mm_add_ps(_mm_loadu_ps(yi + k),
+                             _mm_sub_ps(_mm_mul_ps(xr, ei),
+                                        _mm_mul_ps(xi, er))));
+  }
+}
+
+const FftKernels kSse2Kernels = {ButterfliesSse2, MultiplyAccumulateSse2,
+                                 ConjMultiplyAccumulateSse2};
+
+SAMURAI_TARGET("avx2,fma")
+void ButterfliesAvx2(float* re, float* im, const float* wr, const float* wi,
+                     size_t h) {
+  for (size_t j = 0; j < h; j += 8) {
+    const __m256 br = _mm256_loadu_ps(re + j + h);
+    const __m256 bi = _mm256_loadu_ps(im + j + h);
+    const __m256 cr = _mm256_loadu_ps(wr + j);
+    const __m256 ci = _mm256_loadu_ps(wi + j);
+    const __m256 tr = _mm256_fmsub_ps(br, cr, _mm256_mul_ps(bi, ci));
+    const __m256 ti = _mm256_fmadd_ps(br, ci, _mm256_mul_ps(bi, cr));
+    const __m256 ar = _mm256_loadu_ps(re + j);
+    const __m256 ai = _mm256_loadu_ps(im + j);
+    _mm256_storeu_ps(re + j + h, _mm256_sub_ps(ar, tr));
+    _mm256_storeu_ps(im + j + h, _mm256_sub_ps(ai, ti));
+    _mm256_storeu_ps(re + j, _mm256_add_ps(ar, tr));
+    _mm256_storeu_ps(im + j, _mm256_add_ps(ai, ti));
+  }
+}
+
+SAMURAI_TARGET("avx2,fma")
+void MultiplyAccumulateAvx2(const float* ar, const float* ai, const float* br,
+                            const float* bi, float* yr, float* yi, size_t n) {
+  for (size_t k = 0; k < n; k += 8) {
+    const __m256 xr = _mm256_loadu_ps(ar + k);
+    const __m256 xi = _mm256_loadu_ps(ai + k);
+    const __m256 wr = _mm256_loadu_ps(br + k);
+    const __m256 wi = _mm256_loadu_ps(bi + k);
+    _mm256_storeu_ps(
+        yr + k, _mm256_fmadd_ps(xr, wr, _mm256_fnmadd_ps(
+                                            xi, wi, _mm256_loadu_ps(yr + k))));
+    _mm256_storeu_ps(
+        yi + k, _mm256_fmadd_ps(xr, wi, _mm256_fmadd_ps(
+                                            xi, wr, _mm256_loadu_ps(yi + k))));
+  }
+}
+
+SAMURAI_TARGET("avx2,fma")
+void ConjMultiplyAccumulateAvx2(const float* ar, const float* ai,
+                                const float* br, const float* bi, float* yr,
+                                float* yi, size_t n) {
+  for (size_t k = 0; k < n; k += 8) {
+    const __m256 xr = _mm256_loadu_ps(ar + k);
+    const __m256 xi = _mm256_loadu_ps(ai + k);
+    const __m256 er = _mm256_loadu_ps(br + k);
+    const __m256 ei = _mm256_loadu_ps(bi + k);
+    _mm256_storeu_ps(
+        yr + k, _mm256_fmadd_ps(xr, er, _mm256_fmadd_ps(
+                                            xi, ei, _mm256_loadu_ps(yr + k))));
+    _mm256_storeu_ps(
+        yi + k, _mm256_fmadd_ps(xr, ei, _mm256_fnmadd_ps(
+                                            xi, er, _mm256_loadu_ps(yi + k))));
+  }
+}
+
+const FftKernels kAvx2Kernels = {ButterfliesAvx2, MultiplyAccumulateAvx2,
+                                 ConjMultiplyAccumulateAvx2};
+
+}  // namespace
+
+const FftKernels* FftKernelsSse2() { return &kSse2Kernels; }
+const FftKernels* FftKernelsAvx2() { return &kAvx2Kernels; }
+
+#else  // !SAMURAI_ARCH_X86
+
+const FftKernels* FftKernelsSse2() { return nullptr; }
+const FftKernels* FftKernelsAvx2() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_X86
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,175 @@
+#include "samurai_audio_core/format_converter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace samurai {
+
+namespace {
+
+// Grows |buffer| to at least |size| elements and returns its data.
+float* Reserve(std::vector<float>* buffer, size_t size) {
+  if (buffer->size() < size) {
+    buffer->resize(size);
+  }
+  return buffer->data();
+}
+
+}  // namespace
+
+FormatConverter::FormatConverter(const AudioFormat& input,
+                                 const AudioFormat& requested,
+                                 const ChannelMap& channels, bool dither,
+                                 ResamplerQuality quality)
+    : input_(input), output_(input), dither_(dither) {
+  if (requested.sample_type != input.sample_type &&
+      SampleConverter(input.sample_type, requested.sample_type, dither)
+          .IsValid()) {
+    output_.sample_type = requested.sample_type;
+  }
+
+  if (channels.mode != ChannelMode::kPassthrough) {
+    auto mixer = std::make_unique<ChannelMixer>(input.channels, channels);
+    if (mixer->IsValid()) {
+      output_.channels = mixer->output_channels();
+      channel_mode_ = channels.mode;
+      mixer_ = std::move(mixer);
+    }
+  }
+
+  if (requested.sample_rate != 0 &&
+      requested.sample_rate != input.sample_rate) {
+    auto resampler = std::make_unique<Resampler>(
+        input.sample_rate, requested.sample_rate, output_.channels, quality);
+    if (resampler->IsValid()) {
+      resampler_ = std::move(resampler);
+      output_.sample_rate = requested.sample_rate;
+    }
+  }
+
+  if (mixer_ || resampler_) {
+    if (input.sample_type != SampleType::kFloat32) {
+      to_float_ = std::make_unique<SampleConverter>(
+          input.sample_type, SampleType::kFloat32, false);
+    }
+    if (output_.sample_type != SampleType::kFloat32) {
+      from_float_ = std::make_unique<SampleConverter>(
+          SampleType::kFloat32, output_.sample_type, dither);
+    }
+  } else if (output_.sample_type != input.sample_type) {
+    direct_ = std::make_unique<SampleConverter>(input.sample_type,
+                                                output_.sample_type, dither);
+  }
+  passthrough_ = !mixer_ && !resampler_ && !direct_;
+}
+
+uint32_t FormatConverter::delay_frames() const {
+  uint32_t frames = resampler_ ? resampler_->taps() / 2 : 0;
+  if (adjuster_) {
+    // Held back at the output rate.
+    frames += static_cast<uint32_t>(static_cast<uint64_t>(adjuster_->taps()) /
+                                    2 * input_.sample_rate /
+                                    output_.sample_rate);
+  }
+  return frames;
+}
+
+bool FormatConverter::EnableRateAdjustment(ResamplerQuality quality) {
+  if (adjuster_) {
+    return true;
+  }
+  auto adjuster =
+      std::make_unique<AdaptiveResampler>(output_.channels, quality);
+  if (!adjuster->IsValid()) {
+    return false;
+  }
+  adjuster_ = std::move(adjuster);
+  direct_.reset();
+  if (input_.sample_type != SampleType::kFloat32 && !to_float_) {
+    to_float_ = std::make_unique<SampleConverter>(
+        input_.sample_type, SampleType::kFloat32, false);
+  }
+  if (output_.sample_type != SampleType::kFloat32 && !from_float_) {
+    from_float_ = std::make_unique<SampleConverter>(
+        SampleType::kFloat32, output_.sample_type, dither_);
+  }
+  passthrough_ = false;
+  return true;
+}
+
+void FormatConverter::SetRateAdjustment(double ratio) {
+  if (adjuster_) {
+    adjuster_->SetRatio(ratio);
+  }
+}
+
+size_t FormatConverter::MaxOutputFrames(size_t input_frames) const {
+  size_t frames = resampler_ ? resampler_->MaxOutputFrames(input_frames)
+                             : input_frames;
+  return adjuster_ ? adjuster_->MaxOutputFrames(frames) : frames;
+}
+
+size_t FormatConverter::Convert(const uint8_t* in, size_t frames,
+                                uint8_t* out) {
+  if (!mixer_ && !resampler_ && !adjuster_) {
+    const size_t samples = frames * input_.channels;
+    if (!in) {
+      std::memset(out, 0, frames * output_.BlockAlign());
+    } else if (direct_) {
+      direct_->Convert(in, samples, out);
+    } else {
+      std::memcpy(out, in, frames * output_.BlockAlign());
+    }
+    return frames;
+  }
+
+  // Float frames in the output layout. Silence still runs through the
+  // resampler so its history stays in step with the device clock.
+  const size_t channels = output_.channels;
+  float* mixed = Reserve(&mixed_, frames * channels);
+  if (!in) {
+    std::fill(mixed, mixed + frames * channels, 0.0f);
+  } else {
+    const size_t in_samples = frames * input_.channels;
+    float* floats = mixer_ ? Reserve(&float_in_, in_samples) : mixed;
+    if (to_float_) {
+      to_float_->Convert(in, in_samples, reinterpret_cast<uint8_t*>(floats));
+    } else {
+      std::memcpy(floats, in, in_samples * sizeof(float));
+    }
+    if (mixer_) {
+      mixer_->Process(floats, frames, mixed);
+    }
+  }
+
+  size_t produced = frames;
+  const float* result = mixed;
+  if (resampler_) {
+    float* resampled =
+        from_float_ || adjuster_
+            ? Reserve(&float_out_, resampler_->MaxOutputFrames(frames) *
+                                       channels)
+            : reinterpret_cast<float*>(out);
+    produced = resampler_->Process(mixed, frames, resampled);
+    result = resampled;
+  }
+  if (adjuster_) {
+    float* adjusted =
+        from_float_
+            ? Reserve(&adjusted_, adjuster_->MaxOutputFrames(produced) *
+                                      channels)
+            : reinterpret_cast<float*>(out);
+    produced = adjuster_->Process(result, produced, adjusted);
+    result = adjusted;
+  }
+
+  if (from_float_) {
+    from_float_->Convert(reinterpret_cast<const uint8_t*>(result),
+                         produced * channels, out);
+  } else if (result != reinterpret_cast<const float*>(out)) {
+    std::memcpy(out, result, produced * channels * sizeof(float));
+  }
+  return produced;
+}
+
+}  // namespace samurai
@@ -0,0 +1,172 @@
+#include "samurai_audio_core/frame_pool.h"
+
+#include <memory>
+
+namespace samurai {
+
+namespace internal {
+
+// What frames point back to. Lives while the pool or any of its frames
+// does: |users| counts the pool itself plus every frame handed out.
+struct FramePoolCore {
+  static constexpr uint32_t kEnd = 0xFFFFFFFFu;
+  // Cache-line aligned buffers: no false sharing between frames, and
+  // aligned loads for the SIMD kernels.
+  static constexpr size_t kAlignment = 64;
+
+  static size_t Stride(size_t bytes) {
+    return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  FramePoolCore(size_t count, size_t bytes)
+      : storage(new uint8_t[count * Stride(bytes) + kAlignment]),
+        buffers(new FrameRef::Buffer[count > 0 ? count : 1]) {
+    uint8_t* base = storage.get();
+    base += (kAlignment - reinterpret_cast<uintptr_t>(base) % kAlignment) %
+            kAlignment;
+    for (size_t i = 0; i < count; ++i) {
+      FrameRef::Buffer& buffer = buffers[i];
+      buffer.index = static_cast<uint32_t>(i);
+      buffer.data = base + i * Stride(bytes);
+      buffer.capacity = bytes;
+      buffer.pool = this;
+      buffer.next_free.store(i + 1 < count ? static_cast<uint32_t>(i + 1)
+                                           : kEnd,
+                             std::memory_order_relaxed);
+    }
+    free_head.store(count > 0 ? 0 : kEnd, std::memory_order_relaxed);
+    available.store(count, std::memory_order_relaxed);
+  }
+
+  // Treiber stack of free indices. The upper half of |free_head| counts
+  // pushes, so a pop racing a pop-push of the same index fails its CAS.
+  FrameRef::Buffer* Pop() {
+    uint64_t head = free_head.load(std::memory_order_acquire);
+    while (true) {
+      const uint32_t index = static_cast<uint32_t>(head);
+      if (index == kEnd) {
+        return nullptr;
+      }
+      const uint32_t next =
+          buffers[index].next_free.load(std::memory_order_relaxed);
+      const uint64_t desired = (head & ~uint64_t{0xFFFFFFFFu}) | next;
+      if (free_head.compare_exchange_weak(head, desired,
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire)) {
+        available.fetch_sub(1, std::memory_order_relaxed);
+        return &buffers[index];
+      }
+    }
+  }
+
+  void Push(FrameRef::Buffer* buffer) {
+    uint64_t head = free_head.load(std::memory_order_relaxed);
+    uint64_t desired;
+    do {
+      buffer->next_free.store(static_cast<uint32_t>(head),
+                              std::memory_order_relaxed);
+      desired = (((head >> 32) + 1) << 32) | buffer->index;
+    } while (!free_head.compare_exchange_weak(head, desired,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    available.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Unref() {
+    if (users.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  std::unique_ptr<uint8_t[]> storage;
+  std::unique_ptr<FrameRef::Buffer[]> buffers;
+  std::atomic<uint64_t> free_head{kEnd};
+  std::atomic<size_t> available{0};
+  std::atomic<uint64_t> exhausted{0};
+  std::atomic<size_t> users{1};
+};
+
+}  // namespace internal
+
+FrameRef::FrameRef(const FrameRef& other) : buffer_(other.buffer_) {
+  if (buffer_) {
+    buffer_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+FrameRef::FrameRef(FrameRef&& other) noexcept : buffer_(other.buffer_) {
+  other.buffer_ = nullptr;
+}
+
+FrameRef& FrameRef::operator=(const FrameRef& other) {
+  if (other.buffer_ != buffer_) {
+    FrameRef copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+FrameRef& FrameRef::operator=(FrameRef&& other) noexcept {
+  if (this != &other) {
+    Reset();
+    buffer_ = other.buffer_;
+    other.buffer_ = nullptr;
+  }
+  return *this;
+}
+
+FrameRef FrameRef::Allocate(size_t capacity) {
+  Buffer* buffer = new Buffer();
+  buffer->data = new uint8_t[capacity > 0 ? capacity : 1];
+  buffer->capacity = capacity;
+  buffer->refs.store(1, std::memory_order_relaxed);
+  return FrameRef(buffer);
+}
+
+void FrameRef::Reset() {
+  Buffer* buffer = buffer_;
+  if (!buffer) {
+    return;
+  }
+  buffer_ = nullptr;
+  if (buffer->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  internal::FramePoolCore* pool = buffer->pool;
+  if (!pool) {
+    delete[] buffer->data;
+    delete buffer;
+    return;
+  }
+  buffer->size = 0;
+  pool->Push(buffer);
+  pool->Unref();
+}
+
+FramePool::FramePool(size_t buffer_count, size_t buffer_bytes)
+    : capacity_(buffer_count),
+      buffer_bytes_(buffer_bytes),
+      core_(new internal::FramePoolCore(buffer_count, buffer_bytes)) {}
+
+FramePool::~FramePool() { core_->Unref(); }
+
+FrameRef FramePool::Acquire() {
+  FrameRef::Buffer* buffer = core_->Pop();
+  if (!buffer) {
+    core_->exhausted.fetch_add(1, std::memory_order_relaxed);
+    return FrameRef();
+  }
+  core_->users.fetch_add(1, std::memory_order_relaxed);
+  buffer->refs.store(1, std::memory_order_relaxed);
+  return FrameRef(buffer);
+}
+
+size_t FramePool::available() const {
+  return core_->available.load(std::memory_order_relaxed);
+}
+
+uint64_t FramePool::exhausted() const {
+  return core_->exhausted.load(std::memory_order_relaxed);
+}
+
+}  // namespace samurai
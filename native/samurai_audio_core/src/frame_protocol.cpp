@@ -0,0 +1,186 @@
+#include "samurai_audio_core/frame_protocol.h"
+
+#include <cstring>
+
+namespace samurai {
+
+namespace {
+
+// Wire values are spelled out rather than cast from the enums, so
+// reordering an enum cannot silently change the protocol.
+uint8_t CodecWireValue(CodecId codec) {
+  switch (codec) {
+    case CodecId::kPcm:
+      return 0;
+    case CodecId::kOpus:
+      return 1;
+    case CodecId::kMp3:
+      return 2;
+  }
+  return 0;
+}
+
+bool CodecFromWire(uint8_t value, CodecId* codec) {
+  switch (value) {
+    case 0:
+      *codec = CodecId::kPcm;
+      return true;
+    case 1:
+      *codec = CodecId::kOpus;
+      return true;
+    case 2:
+      *codec = CodecId::kMp3;
+      return true;
+  }
+  return false;
+}
+
+uint8_t SampleTypeWireValue(SampleType type) {
+  switch (type) {
+    case SampleType::kInt16:
+      return 0;
+    case SampleType::kInt24:
+      return 1;
+    case SampleType::kInt32:
+      return 2;
+    case SampleType::kFloat32:
+      return 3;
+  }
+  return 0;
+}
+
+bool SampleTypeFromWire(uint8_t value, SampleType* type) {
+  switch (value) {
+    case 0:
+      *type = SampleType::kInt16;
+      return true;
+    case 1:
+      *type = SampleType::kInt24;
+      return true;
+    case 2:
+      *type = SampleType::kInt32;
+      return true;
+    case 3:
+      *type = SampleType::kFloat32;
+      return true;
+  }
+  return false;
+}
+
+void Put16(uint8_t* out, uint16_t value) {
+  out[0] = static_cast<uint8_t>(value);
+  out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void Put32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (i * 8));
+  }
+}
+
+void Put64(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (i * 8));
+  }
+}
+
+uint16_t Get16(const uint8_t* in) {
+  return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t Get32(const uint8_t* in) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = (value << 8) | in[i];
+  }
+  return value;
+}
+
+uint64_t Get64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i) {
+    value = (value << 8) | in[i];
+  }
+  return value;
+}
+
+}  // namespace
+
+FrameHeader FrameHeaderForPacket(const AudioPacket& packet) {
+  FrameHeader header;
+  header.stream = packet.stream;
+  header.codec = packet.codec;
+  header.flags = static_cast<uint16_t>(packet.flags);
+  header.format = packet.format;
+  header.capture_time_ns = packet.capture_time_ns;
+  header.frames = packet.frames;
+  header.sequence = static_cast<uint32_t>(packet.sequence);
+  header.payload_bytes = static_cast<uint32_t>(packet.size);
+  header.position = packet.position;
+  return header;
+}
+
+void EncodeFrameHeader(const FrameHeader& header, uint8_t* out) {
+  out[0] = header.version;
+  out[1] = static_cast<uint8_t>(kFrameHeaderBytes);
+  out[2] = static_cast<uint8_t>(header.stream);
+  out[3] = CodecWireValue(header.codec);
+  Put16(out + 4, header.flags);
+  out[6] = static_cast<uint8_t>(header.format.channels);
+  out[7] = SampleTypeWireValue(header.format.sample_type);
+  Put64(out + 8, static_cast<uint64_t>(header.capture_time_ns));
+  Put32(out + 16, header.format.sample_rate);
+  Put32(out + 20, header.frames);
+  Put32(out + 24, header.sequence);
+  Put32(out + 28, header.payload_bytes);
+  Put64(out + 32, header.position);
+}
+
+void EncodeFrame(const AudioPacket& packet, std::string* frame) {
+  frame->resize(kFrameHeaderBytes + packet.size);
+  uint8_t* out = reinterpret_cast<uint8_t*>(&(*frame)[0]);
+  EncodeFrameHeader(FrameHeaderForPacket(packet), out);
+  if (packet.size > 0) {
+    std::memcpy(out + kFrameHeaderBytes, packet.data, packet.size);
+  }
+}
+
+size_t DecodeFrame(const uint8_t* data, size_t size, FrameHeader* header,
+                   const uint8_t** payload) {
+  if (size < kFrameHeaderMinBytes || data[0] != kFrameProtocolVersion) {
+    return 0;
+  }
+  const size_t header_bytes = data[1];
+  if (header_bytes < kFrameHeaderMinBytes || header_bytes > size) {
+    return 0;
+  }
+  FrameHeader parsed;
+  parsed.version = data[0];
+  if (data[2] > static_cast<uint8_t>(StreamKind::kAligned) ||
+      !CodecFromWire(data[3], &parsed.codec) ||
+      !SampleTypeFromWire(data[7], &parsed.format.sample_type) ||
+      data[6] == 0) {
+    return 0;
+  }
+  parsed.stream = static_cast<StreamKind>(data[2]);
+  parsed.flags = Get16(data + 4);
+  parsed.format.channels = data[6];
+  parsed.capture_time_ns = static_cast<int64_t>(Get64(data + 8));
+  parsed.format.sample_rate = Get32(data + 16);
+  parsed.frames = Get32(data + 20);
+  parsed.sequence = Get32(data + 24);
+  parsed.payload_bytes = Get32(data + 28);
+  parsed.has_position = header_bytes >= kFrameHeaderBytes;
+  if (parsed.has_position) {
+    parsed.position = Get64(data + 32);
+  }
+  if (parsed.format.sample_rate == 0 ||
+      parsed.payload_bytes > size - header_bytes) {
+    return 0;
+  }
+  *header = parsed;
+  *payload = data + header_bytes;
+  return header_bytes + parsed.payload_bytes;
+}
+
+}  // namespace samurai
@@ -0,0 +1,120 @@
+#include <lame/lame.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "audio_codec_internal.h"
+
+namespace samurai {
+namespace internal {
+
+namespace {
+
+// MPEG-1 Layer III frame; MPEG-2 rates use half, which LAME buffers for us.
+constexpr uint32_t kMp3FrameSamples = 1152;
+
+// LAME's documented worst case for one lame_encode_buffer() call:
+// 1.25 * samples + 7200.
+constexpr size_t kMaxMp3PacketBytes = kMp3FrameSamples * 5 / 4 + 7200;
+
+// The CBR bitrates valid for both MPEG-1 and MPEG-2; LAME rounds anything
+// else, so round here and report what is actually used.
+uint32_t NearestMp3Bitrate(uint32_t bitrate) {
+  static const uint32_t kKbps[] = {32, 40, 48, 56, 64, 80, 96, 112, 128,
+                                   144, 160, 192, 224, 256, 320};
+  const uint32_t target = bitrate / 1000;
+  uint32_t best = kKbps[0];
+  for (uint32_t kbps : kKbps) {
+    if (std::abs(static_cast<int>(kbps) - static_cast<int>(target)) <
+        std::abs(static_cast<int>(best) - static_cast<int>(target))) {
+      best = kbps;
+    }
+  }
+  return best * 1000;
+}
+
+class LameAudioEncoder : public AudioEncoder {
+ public:
+  LameAudioEncoder(lame_global_flags* lame, const EncoderConfig& config,
+                   const AudioFormat& format)
+      : lame_(lame), config_(config), format_(format) {}
+
+  ~LameAudioEncoder() override { lame_close(lame_); }
+
+  const EncoderConfig& config() const override { return config_; }
+  const AudioFormat& input_format() const override { return format_; }
+  std::string MimeType() const override {
+    return CodecMimeType(CodecId::kMp3, format_);
+  }
+  uint32_t frame_size() const override { return kMp3FrameSamples; }
+  size_t max_packet_bytes() const override { return kMaxMp3PacketBytes; }
+
+  size_t Encode(const uint8_t* pcm, uint8_t* out) override {
+    int bytes;
+    const int size = static_cast<int>(kMaxMp3PacketBytes);
+    if (format_.sample_type == SampleType::kFloat32) {
+      bytes = lame_encode_buffer_interleaved_ieee_float(
+          lame_, reinterpret_cast<const float*>(pcm), kMp3FrameSamples, out,
+          size);
+    } else if (format_.channels == 2) {
+      // LAME's interleaved entry point takes a non-const pointer but does
+      // not write through it.
+      bytes = lame_encode_buffer_interleaved(
+          lame_, reinterpret_cast<short*>(const_cast<uint8_t*>(pcm)),
+          kMp3FrameSamples, out, size);
+    } else {
+      const short* mono = reinterpret_cast<const short*>(pcm);
+      bytes = lame_encode_buffer(lame_, mono, mono, kMp3FrameSamples, out,
+                                 size);
+    }
+    // 0 while LAME fills its lookahead; the stage carries those frames.
+    return bytes >= 0 ? static_cast<size_t>(bytes) : kEncodeFailed;
+  }
+
+  size_t Finish(uint8_t* out) override {
+    const int bytes =
+        lame_encode_flush(lame_, out, static_cast<int>(kMaxMp3PacketBytes));
+    return bytes > 0 ? static_cast<size_t>(bytes) : 0;
+  }
+
+ private:
+  lame_global_flags* lame_;
+  EncoderConfig config_;
+  AudioFormat format_;
+};
+
+}  // namespace
+
+std::unique_ptr<AudioEncoder> CreateLameEncoder(const EncoderConfig& config,
+                                                const AudioFormat& format) {
+  if (format.channels < 1 || format.channels > 2) {
+    return nullptr;
+  }
+  EncoderConfig effective = config;
+  effective.bitrate = NearestMp3Bitrate(config.bitrate);
+  effective.frame_ms = static_cast<uint32_t>(
+      (uint64_t{kMp3FrameSamples} * 1000 + format.sample_rate - 1) /
+      format.sample_rate);
+
+  lame_global_flags* lame = lame_init();
+  if (!lame) {
+    return nullptr;
+  }
+  lame_set_in_samplerate(lame, static_cast<int>(format.sample_rate));
+  lame_set_out_samplerate(lame, static_cast<int>(format.sample_rate));
+  lame_set_num_channels(lame, format.channels);
+  lame_set_mode(lame, format.channels == 1 ? MONO : JOINT_STEREO);
+  lame_set_brate(lame, static_cast<int>(effective.bitrate / 1000));
+  lame_set_VBR(lame, vbr_off);
+  // Packets are streamed, so there is no header to go back and patch.
+  lame_set_bWriteVbrTag(lame, 0);
+  if (lame_init_params(lame) < 0) {
+    lame_close(lame);
+    return nullptr;
+  }
+  return std::unique_ptr<AudioEncoder>(
+      new LameAudioEncoder(lame, effective, format));
+}
+
+}  // namespace internal
+}  // namespace samurai
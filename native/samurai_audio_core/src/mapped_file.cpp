@@ -0,0 +1,277 @@
+#include "samurai_audio_core/mapped_file.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace samurai {
+
+MappedFile::~MappedFile() { Close(); }
+
+#if defined(_WIN32)
+
+namespace {
+
+// |path| (UTF-8) as a null-terminated wide string; empty on failure.
+std::vector<wchar_t> WidePath(const std::string& path) {
+  const int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1,
+                                         nullptr, 0);
+  if (length <= 0) {
+    return std::vector<wchar_t>();
+  }
+  std::vector<wchar_t> wide(length);
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wide.data(), length);
+  return wide;
+}
+
+}  // namespace
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+  const std::vector<wchar_t> wide = WidePath(path);
+  if (wide.empty()) {
+    return false;
+  }
+
+  HANDLE file = CreateFileW(wide.data(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+  file_ = file;
+  size_ = static_cast<size_t>(size.QuadPart);
+  open_ = true;
+  if (size_ == 0) {
+    return true;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    Close();
+    return false;
+  }
+  mapping_ = mapping;
+  data_ = static_cast<const uint8_t*>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!data_) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::OpenWritable(const std::string& path, size_t size) {
+  Close();
+  const std::vector<wchar_t> wide = WidePath(path);
+  if (wide.empty()) {
+    return false;
+  }
+
+  HANDLE file = CreateFileW(wide.data(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  file_ = file;
+  LARGE_INTEGER current;
+  if (!GetFileSizeEx(file, &current)) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(current.QuadPart);
+  if (size_ < size) {
+    // Not sparse: SetEndOfFile allocates the clusters.
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(file)) {
+      Close();
+      return false;
+    }
+    size_ = size;
+  }
+  open_ = true;
+  writable_ = true;
+  if (size_ == 0) {
+    return true;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+  if (!mapping) {
+    Close();
+    return false;
+  }
+  mapping_ = mapping;
+  data_ = static_cast<const uint8_t*>(
+      MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+  if (!data_) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(static_cast<HANDLE>(mapping_));
+  }
+  if (file_) {
+    CloseHandle(static_cast<HANDLE>(file_));
+  }
+  data_ = nullptr;
+  mapping_ = nullptr;
+  file_ = nullptr;
+  size_ = 0;
+  open_ = false;
+  writable_ = false;
+}
+
+void MappedFile::Release(size_t offset, size_t length) const {
+  // Clean read-only pages are trimmed from the working set on demand;
+  // there is no cheap per-range hint.
+}
+
+bool MappedFile::Sync(size_t offset, size_t length) const {
+  if (!writable_) {
+    return false;
+  }
+  if (!data_ || offset >= size_ || length == 0) {
+    return true;
+  }
+  // FlushViewOfFile only starts the writes; FlushFileBuffers waits.
+  return FlushViewOfFile(data_ + offset, std::min(length, size_ - offset)) &&
+         FlushFileBuffers(static_cast<HANDLE>(file_));
+}
+
+#else  // !_WIN32
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+  fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  open_ = true;
+  if (size_ == 0) {
+    return true;
+  }
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (data == MAP_FAILED) {
+    Close();
+    return false;
+  }
+  data_ = static_cast<const uint8_t*>(data);
+  madvise(data, size_, MADV_SEQUENTIAL);
+  return true;
+}
+
+bool MappedFile::OpenWritable(const std::string& path, size_t size) {
+  Close();
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ < size) {
+#if defined(__linux__)
+    // Allocates the blocks: writing to a hole on a full disk is SIGBUS.
+    if (posix_fallocate(fd_, 0, static_cast<off_t>(size)) != 0) {
+#else
+    if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+#endif
+      Close();
+      return false;
+    }
+    size_ = size;
+  }
+  open_ = true;
+  writable_ = true;
+  if (size_ == 0) {
+    return true;
+  }
+  void* data =
+      mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    Close();
+    return false;
+  }
+  data_ = static_cast<const uint8_t*>(data);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  data_ = nullptr;
+  fd_ = -1;
+  size_ = 0;
+  open_ = false;
+  writable_ = false;
+}
+
+void MappedFile::Release(size_t offset, size_t length) const {
+  if (!data_ || offset >= size_) {
+    return;
+  }
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  // Only whole pages inside the range.
+  const size_t begin = (offset + page - 1) / page * page;
+  const size_t end = std::min(size_, offset + length) / page * page;
+  if (end > begin) {
+    madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_DONTNEED);
+  }
+}
+
+bool MappedFile::Sync(size_t offset, size_t length) const {
+  if (!writable_) {
+    return false;
+  }
+  if (!data_ || offset >= size_ || length == 0) {
+    return true;
+  }
+  // msync() wants a page-aligned start.
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t begin = offset / page * page;
+  const size_t end = std::min(size_, offset + length);
+  return msync(const_cast<uint8_t*>(data_) + begin, end - begin, MS_SYNC) ==
+         0;
+}
+
+#endif  // _WIN32
+
+}  // namespace samurai
@@ -0,0 +1,131 @@
+#include "ogg_muxer_internal.h"
+
+#include <cstring>
+#include <utility>
+
+namespace samurai {
+namespace internal {
+
+namespace {
+
+constexpr uint8_t kContinued = 0x01;
+constexpr uint8_t kBeginOfStream = 0x02;
+constexpr uint8_t kEndOfStream = 0x04;
+
+// One byte of lacing covers up to 255 body bytes; a page holds 255.
+constexpr size_t kMaxSegments = 255;
+constexpr size_t kHeaderBytes = 27;
+
+struct CrcTable {
+  uint32_t entries[256];
+  CrcTable() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t r = i << 24;
+      for (int bit = 0; bit < 8; ++bit) {
+        r = (r & 0x80000000u) ? (r << 1) ^ 0x04C11DB7u : r << 1;
+      }
+      entries[i] = r;
+    }
+  }
+};
+
+void PutU32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<uint8_t>(v >> (8 * i));
+  }
+}
+
+}  // namespace
+
+uint32_t OggCrc(const uint8_t* data, size_t size) {
+  static const CrcTable table;
+  uint32_t crc = 0;
+  for (size_t i = 0; i < size; ++i) {
+    crc = (crc << 8) ^ table.entries[((crc >> 24) ^ data[i]) & 0xFF];
+  }
+  return crc;
+}
+
+OggMuxer::OggMuxer(uint32_t serial, PageWriter write)
+    : serial_(serial), write_(std::move(write)) {
+  lacing_.reserve(kMaxSegments);
+  body_.reserve(kPageBytes + 255 * kMaxSegments);
+}
+
+void OggMuxer::AddPacket(const uint8_t* packet, size_t size,
+                         int64_t granule) {
+  // Lacing: 255s then a terminating value below 255 (possibly 0).
+  size_t remaining = size;
+  while (true) {
+    const size_t segment = remaining < 255 ? remaining : 255;
+    lacing_.push_back(static_cast<uint8_t>(segment));
+    body_.insert(body_.end(), packet, packet + segment);
+    packet += segment;
+    remaining -= segment;
+    const bool last = segment < 255;
+    if (last) {
+      granule_ = granule;
+    }
+    if (lacing_.size() == kMaxSegments) {
+      // Page full; a packet still open spills into a continued page.
+      WritePage(0);
+      continued_ = !last;
+    }
+    if (last) {
+      break;
+    }
+  }
+  if (body_.size() >= kPageBytes) {
+    Flush();
+  }
+}
+
+void OggMuxer::Flush() {
+  if (!lacing_.empty()) {
+    WritePage(0);
+    continued_ = false;
+  }
+}
+
+void OggMuxer::Finish(int64_t granule) {
+  granule_ = granule;
+  WritePage(kEndOfStream);
+}
+
+void OggMuxer::WritePage(uint8_t header_type) {
+  if (sequence_ == 0) {
+    header_type |= kBeginOfStream;
+  }
+  if (continued_) {
+    header_type |= kContinued;
+  }
+  page_.resize(kHeaderBytes + lacing_.size() + body_.size());
+  uint8_t* p = page_.data();
+  std::memcpy(p, "OggS", 4);
+  p[4] = 0;  // Version.
+  p[5] = header_type;
+  // -1 when no packet ends on this page.
+  const uint64_t granule = static_cast<uint64_t>(granule_);
+  PutU32(p + 6, static_cast<uint32_t>(granule));
+  PutU32(p + 10, static_cast<uint32_t>(granule >> 32));
+  PutU32(p + 14, serial_);
+  PutU32(p + 18, sequence_++);
+  PutU32(p + 22, 0);
+  p[26] = static_cast<uint8_t>(lacing_.size());
+  if (!lacing_.empty()) {
+    std::memcpy(p + kHeaderBytes, lacing_.data(), lacing_.size());
+  }
+  if (!body_.empty()) {
+    std::memcpy(p + kHeaderBytes + lacing_.size(), body_.data(),
+                body_.size());
+  }
+  PutU32(p + 22, OggCrc(p, page_.size()));
+  write_(page_.data(), page_.size());
+
+  lacing_.clear();
+  body_.clear();
+  granule_ = -1;
+}
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,58 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_OGG_MUXER_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_OGG_MUXER_INTERNAL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace samurai {
+namespace internal {
+
+// Ogg CRC-32 (polynomial 0x04C11DB7, no reflection, zero init and xor).
+uint32_t OggCrc(const uint8_t* data, size_t size);
+
+// Packs packets of one logical stream into Ogg pages (RFC 3533). Pages are
+// handed to |write| whole, so a writer that stops mid-stream leaves a file
+// whose complete pages all still decode.
+class OggMuxer {
+ public:
+  using PageWriter = std::function<void(const uint8_t*, size_t)>;
+
+  OggMuxer(uint32_t serial, PageWriter write);
+
+  // Queues |packet|; |granule| is the stream position at its end. Pages
+  // are cut once the queued body reaches |page_bytes| or the lacing table
+  // is full.
+  void AddPacket(const uint8_t* packet, size_t size, int64_t granule);
+
+  // Writes the queued packets as a page, even if short. Used after
+  // headers, which must end their pages.
+  void Flush();
+
+  // Writes the final page with end-of-stream set and |granule| as its
+  // position (for trimming the last packet's padding). Writes an empty
+  // page when nothing is queued.
+  void Finish(int64_t granule);
+
+  uint32_t pages() const { return sequence_; }
+
+  static constexpr size_t kPageBytes = 4096;
+
+ private:
+  void WritePage(uint8_t header_type);
+
+  uint32_t serial_;
+  PageWriter write_;
+  uint32_t sequence_ = 0;
+  int64_t granule_ = -1;  // Of the last packet completed on this page.
+  bool continued_ = false;
+  std::vector<uint8_t> lacing_;
+  std::vector<uint8_t> body_;
+  std::vector<uint8_t> page_;
+};
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_OGG_MUXER_INTERNAL_H_
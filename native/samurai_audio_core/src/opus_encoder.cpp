@@ -0,0 +1,100 @@
+#include <opus.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "audio_codec_internal.h"
+
+namespace samurai {
+namespace internal {
+
+namespace {
+
+// RFC 6716 bounds a 120 ms packet at 6 frames of 1275 bytes; 4000 is the
+// size libopus itself recommends for any single call.
+constexpr size_t kMaxOpusPacketBytes = 4000;
+
+bool OpusRateSupported(uint32_t rate) {
+  return rate == 8000 || rate == 12000 || rate == 16000 || rate == 24000 ||
+         rate == 48000;
+}
+
+class OpusAudioEncoder : public AudioEncoder {
+ public:
+  OpusAudioEncoder(OpusEncoder* encoder, const EncoderConfig& config,
+                   const AudioFormat& format)
+      : encoder_(encoder),
+        config_(config),
+        format_(format),
+        frame_size_(FramesForDuration(format, config.frame_ms)) {}
+
+  ~OpusAudioEncoder() override { opus_encoder_destroy(encoder_); }
+
+  const EncoderConfig& config() const override { return config_; }
+  const AudioFormat& input_format() const override { return format_; }
+
+  std::string MimeType() const override {
+    return CodecMimeType(CodecId::kOpus, format_);
+  }
+
+  uint32_t frame_size() const override { return frame_size_; }
+  size_t max_packet_bytes() const override { return kMaxOpusPacketBytes; }
+
+  size_t Encode(const uint8_t* pcm, uint8_t* out) override {
+    opus_int32 bytes;
+    if (format_.sample_type == SampleType::kFloat32) {
+      bytes = opus_encode_float(encoder_, reinterpret_cast<const float*>(pcm),
+                                static_cast<int>(frame_size_), out,
+                                static_cast<opus_int32>(kMaxOpusPacketBytes));
+    } else {
+      bytes = opus_encode(encoder_, reinterpret_cast<const opus_int16*>(pcm),
+                          static_cast<int>(frame_size_), out,
+                          static_cast<opus_int32>(kMaxOpusPacketBytes));
+    }
+    return bytes > 0 ? static_cast<size_t>(bytes) : kEncodeFailed;
+  }
+
+ private:
+  OpusEncoder* encoder_;
+  EncoderConfig config_;
+  AudioFormat format_;
+  uint32_t frame_size_;
+};
+
+}  // namespace
+
+std::unique_ptr<AudioEncoder> CreateOpusEncoder(const EncoderConfig& config,
+                                                const AudioFormat& format) {
+  if (!OpusRateSupported(format.sample_rate) || format.channels < 1 ||
+      format.channels > 2) {
+    return nullptr;
+  }
+  EncoderConfig effective = config;
+  effective.bitrate = std::min<uint32_t>(
+      510000, std::max<uint32_t>(6000, config.bitrate));
+  if (config.frame_ms != 10 && config.frame_ms != 20 &&
+      config.frame_ms != 40 && config.frame_ms != 60) {
+    effective.frame_ms = 20;
+  }
+
+  const int application = config.application == OpusApplication::kVoip
+                              ? OPUS_APPLICATION_VOIP
+                              : OPUS_APPLICATION_AUDIO;
+  int error = OPUS_OK;
+  OpusEncoder* encoder =
+      opus_encoder_create(static_cast<opus_int32>(format.sample_rate),
+                          format.channels, application, &error);
+  if (error != OPUS_OK || !encoder) {
+    return nullptr;
+  }
+  opus_encoder_ctl(encoder,
+                   OPUS_SET_BITRATE(static_cast<opus_int32>(effective.bitrate)));
+  if (config.application == OpusApplication::kVoip) {
+    opus_encoder_ctl(encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+  }
+  return std::unique_ptr<AudioEncoder>(
+      new OpusAudioEncoder(encoder, effective, format));
+}
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,429 @@
+#include "samurai_audio_core/packet_fan_out.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace samurai {
+
+const char* BackpressurePolicyName(BackpressurePolicy policy) {
+  switch (policy) {
+    case BackpressurePolicy::kDropOldest:
+      return "drop_oldest";
+    case BackpressurePolicy::kDropNewest:
+      return "drop_newest";
+    case BackpressurePolicy::kBlock:
+      return "block";
+    case BackpressurePolicy::kCoalesceSilence:
+      return "coalesce_silence";
+  }
+  return "unknown";
+}
+
+bool ParseBackpressurePolicy(const std::string& name,
+                             BackpressurePolicy* policy) {
+  for (BackpressurePolicy candidate :
+       {BackpressurePolicy::kDropOldest, BackpressurePolicy::kDropNewest,
+        BackpressurePolicy::kBlock, BackpressurePolicy::kCoalesceSilence}) {
+    if (name == BackpressurePolicyName(candidate)) {
+      *policy = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+namespace {
+
+// Audio a queued packet holds; silence markers hold none.
+uint64_t HeldNs(const AudioPacket& packet) {
+  if (packet.size == 0 || packet.format.sample_rate == 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(packet.frames) * 1000000000ull /
+         packet.format.sample_rate;
+}
+
+// PCM whose samples kCoalesceSilence may give up.
+bool IsCoalescible(const AudioPacket& packet) {
+  return packet.codec == CodecId::kPcm && packet.size > 0 &&
+         (packet.flags & (kPacketNoSpeech | kPacketSilent)) != 0;
+}
+
+bool IsMarker(const AudioPacket& packet) {
+  return (packet.flags & kPacketSilenceMarker) != 0;
+}
+
+// Whether marker |next| picks up where marker |last| ends, so one marker
+// can stand for both.
+bool ContinuesMarker(const AudioPacket& last, const AudioPacket& next) {
+  return IsMarker(last) && IsMarker(next) && last.stream == next.stream &&
+         last.format == next.format &&
+         last.position + last.frames == next.position &&
+         static_cast<uint64_t>(last.frames) + next.frames <= UINT32_MAX;
+}
+
+}  // namespace
+
+struct PacketFanOut::Sink {
+  // A queued packet. |packet.data| and |packet.buffer| are filled in when
+  // it is handed out; until then the samples sit |offset| bytes into
+  // |buffer|.
+  struct Entry {
+    AudioPacket packet;
+    FrameRef buffer;
+    size_t offset = 0;
+    uint64_t ns = 0;  // HeldNs(packet).
+    bool held = false;  // |buffer| is an engine frame counted in |held|.
+  };
+
+  Sink(uint64_t id, const FanOutSinkConfig& config,
+       AudioPacketCallback callback)
+      : id(id),
+        config(config),
+        callback(std::move(callback)),
+        max_ns(static_cast<uint64_t>(config.max_duration_ms) * 1000000),
+        entries(config.max_packets > 0 ? config.max_packets : 1) {}
+
+  // |stream| is the index whose engine frames the packet would hold, or
+  // -1 for one that holds none.
+  bool Fits(size_t bytes, uint64_t ns, int stream) const {
+    if (count == 0) {
+      return true;
+    }
+    return count < entries.size() &&
+           (config.max_bytes == 0 ||
+            queued_bytes + bytes <= config.max_bytes) &&
+           (max_ns == 0 || queued_ns + ns <= max_ns) &&
+           (stream < 0 || config.max_held_frames == 0 ||
+            held[stream] < config.max_held_frames);
+  }
+
+  Entry& At(size_t index) { return entries[(head + index) % entries.size()]; }
+
+  // Drops |entry|'s buffer, and with it any engine frame it held.
+  void Release(Entry& entry) {
+    if (entry.held) {
+      --held[static_cast<int>(entry.packet.stream)];
+      entry.held = false;
+    }
+    entry.buffer.Reset();
+  }
+
+  void EvictOldest() {
+    Entry& entry = entries[head];
+    queued_bytes -= entry.packet.size;
+    queued_ns -= entry.ns;
+    Release(entry);
+    head = (head + 1) % entries.size();
+    --count;
+    ++stats.dropped_packets;
+  }
+
+  // Turns queued silence into markers and merges adjacent markers,
+  // compacting the queue in place.
+  void Coalesce() {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+      Entry& entry = At(i);
+      bool given_up = false;
+      if (IsCoalescible(entry.packet)) {
+        queued_bytes -= entry.packet.size;
+        queued_ns -= entry.ns;
+        Release(entry);
+        entry.packet.size = 0;
+        entry.packet.flags |= kPacketSilenceMarker;
+        entry.offset = 0;
+        entry.ns = 0;
+        given_up = true;
+        ++stats.coalesced_packets;
+      }
+      if (kept > 0 && ContinuesMarker(At(kept - 1).packet, entry.packet)) {
+        At(kept - 1).packet.frames += entry.packet.frames;
+        Release(entry);
+        if (!given_up) {
+          ++stats.coalesced_packets;
+        }
+        continue;
+      }
+      if (kept != i) {
+        At(kept) = std::move(entry);
+      }
+      ++kept;
+    }
+    count = kept;
+  }
+
+  void Push(const AudioPacket& packet, const FrameRef& buffer, size_t offset,
+            bool copied) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (closing) {
+      return;
+    }
+    size_t bytes = packet.size;
+    uint64_t ns = HeldNs(packet);
+    int stream = !copied && buffer && IsCapturedStream(packet.stream)
+                     ? static_cast<int>(packet.stream)
+                     : -1;
+    bool to_marker = false;
+    bool coalesced = false;
+    if (!Fits(bytes, ns, stream)) {
+      switch (config.policy) {
+        case BackpressurePolicy::kDropNewest:
+          ++stats.dropped_packets;
+          return;
+        case BackpressurePolicy::kDropOldest:
+          while (!Fits(bytes, ns, stream)) {
+            EvictOldest();
+          }
+          break;
+        case BackpressurePolicy::kBlock:
+          ++stats.blocked_packets;
+          room.wait(lock,
+                    [&]() { return Fits(bytes, ns, stream) || closing; });
+          if (closing) {
+            return;
+          }
+          break;
+        case BackpressurePolicy::kCoalesceSilence:
+          Coalesce();
+          coalesced = true;
+          if (IsCoalescible(packet)) {
+            to_marker = true;
+            bytes = 0;
+            ns = 0;
+            stream = -1;
+          }
+          while (!Fits(bytes, ns, stream)) {
+            EvictOldest();
+          }
+          break;
+      }
+    }
+
+    AudioPacket stored = packet;
+    if (to_marker) {
+      stored.size = 0;
+      stored.flags |= kPacketSilenceMarker;
+      ++stats.coalesced_packets;
+    }
+    if (coalesced && count > 0 &&
+        ContinuesMarker(At(count - 1).packet, stored)) {
+      At(count - 1).packet.frames += stored.frames;
+      if (!to_marker) {
+        ++stats.coalesced_packets;
+      }
+      return;
+    }
+    Entry& entry = At(count);
+    entry.packet = stored;
+    if (to_marker) {
+      entry.buffer.Reset();
+    } else {
+      entry.buffer = buffer;
+    }
+    entry.offset = offset;
+    entry.ns = ns;
+    entry.held = stream >= 0;
+    if (entry.held) {
+      ++held[stream];
+    }
+    ++count;
+    queued_bytes += bytes;
+    queued_ns += ns;
+    if (copied) {
+      ++stats.copied_packets;
+    }
+    stats.high_water_packets = std::max(stats.high_water_packets, count);
+    stats.high_water_bytes = std::max(stats.high_water_bytes, queued_bytes);
+    stats.high_water_ms = std::max(
+        stats.high_water_ms, static_cast<uint32_t>(queued_ns / 1000000));
+    lock.unlock();
+    ready.notify_one();
+  }
+
+  // The sink's thread: hands out packets until closing and drained.
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      ready.wait(lock, [this]() { return count > 0 || closing; });
+      if (count == 0) {
+        return;
+      }
+      Entry& entry = entries[head];
+      AudioPacket packet = entry.packet;
+      FrameRef buffer = std::move(entry.buffer);
+      const size_t offset = entry.offset;
+      // Still counted while the callback has it.
+      const bool was_held = entry.held;
+      entry.held = false;
+      queued_bytes -= entry.packet.size;
+      queued_ns -= entry.ns;
+      head = (head + 1) % entries.size();
+      --count;
+      lock.unlock();
+      // Producers blocked on different packet sizes may each fit now.
+      room.notify_all();
+
+      packet.data = buffer ? buffer.data() + offset : nullptr;
+      packet.buffer = &buffer;
+      callback(packet);
+      buffer.Reset();
+
+      lock.lock();
+      ++stats.delivered_packets;
+      if (was_held) {
+        --held[static_cast<int>(packet.stream)];
+        lock.unlock();
+        room.notify_all();
+        lock.lock();
+      }
+    }
+  }
+
+  const uint64_t id;
+  const FanOutSinkConfig config;
+  const AudioPacketCallback callback;
+  const uint64_t max_ns;  // 0: no duration bound.
+
+  std::mutex mutex;
+  std::condition_variable ready;  // Wakes Run().
+  std::condition_variable room;   // Wakes kBlock producers.
+  // Circular, allocated once.
+  std::vector<Entry> entries;
+  size_t head = 0;
+  size_t count = 0;
+  size_t queued_bytes = 0;
+  uint64_t queued_ns = 0;
+  // Engine frames held per stream, queued or in the callback.
+  size_t held[kStreamKindCount] = {};
+  bool closing = false;
+  FanOutSinkStats stats;
+  std::thread thread;
+};
+
+PacketFanOut::PacketFanOut() = default;
+
+PacketFanOut::~PacketFanOut() {
+  for (size_t i = 0; i < kMaxSinks; ++i) {
+    uint64_t id = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (sinks_[i]) {
+        id = sinks_[i]->id;
+      }
+    }
+    if (id != 0) {
+      Detach(id);
+    }
+  }
+}
+
+uint64_t PacketFanOut::Attach(const FanOutSinkConfig& config,
+                              AudioPacketCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::shared_ptr<Sink>& slot : sinks_) {
+    if (slot) {
+      continue;
+    }
+    auto sink = std::make_shared<Sink>(next_id_++, config, std::move(callback));
+    Sink* raw = sink.get();
+    sink->thread = std::thread([raw]() { raw->Run(); });
+    slot = std::move(sink);
+    return slot->id;
+  }
+  return 0;
+}
+
+bool PacketFanOut::Detach(uint64_t id) {
+  std::shared_ptr<Sink> sink;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::shared_ptr<Sink>& slot : sinks_) {
+      if (slot && slot->id == id) {
+        sink = std::move(slot);
+        break;
+      }
+    }
+  }
+  if (!sink) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(sink->mutex);
+    sink->closing = true;
+  }
+  sink->ready.notify_all();
+  sink->room.notify_all();
+  sink->thread.join();
+  return true;
+}
+
+void PacketFanOut::Deliver(const AudioPacket& packet) {
+  std::shared_ptr<Sink> sinks[kMaxSinks];
+  size_t count = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::shared_ptr<Sink>& slot : sinks_) {
+      if (slot) {
+        sinks[count++] = slot;
+      }
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+
+  // Shares the packet's own buffer when its samples are in it, and makes
+  // one copy for all sinks otherwise.
+  FrameRef copy;
+  const FrameRef* buffer = &copy;
+  size_t offset = 0;
+  bool copied = false;
+  const FrameRef* shared = packet.buffer;
+  if (shared && *shared && packet.data >= shared->data() &&
+      packet.data + packet.size <= shared->data() + shared->capacity()) {
+    buffer = shared;
+    offset = static_cast<size_t>(packet.data - shared->data());
+  } else if (packet.size > 0) {
+    copy = FrameRef::Allocate(packet.size);
+    std::memcpy(copy.data(), packet.data, packet.size);
+    copy.set_size(packet.size);
+    copied = true;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    sinks[i]->Push(packet, *buffer, offset, copied);
+  }
+}
+
+bool PacketFanOut::GetStats(uint64_t id, FanOutSinkStats* stats) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const std::shared_ptr<Sink>& slot : sinks_) {
+    if (slot && slot->id == id) {
+      std::lock_guard<std::mutex> sink_lock(slot->mutex);
+      *stats = slot->stats;
+      stats->queued_packets = slot->count;
+      stats->queued_bytes = slot->queued_bytes;
+      stats->queued_ms = static_cast<uint32_t>(slot->queued_ns / 1000000);
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t PacketFanOut::sink_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const std::shared_ptr<Sink>& slot : sinks_) {
+    if (slot) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+}  // namespace samurai
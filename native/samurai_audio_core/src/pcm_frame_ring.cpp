@@ -0,0 +1,122 @@
+#include "samurai_audio_core/pcm_frame_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace samurai {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+PcmFrameRing::PcmFrameRing(size_t slot_count, size_t slot_bytes)
+    : slot_bytes_(slot_bytes),
+      mask_(RoundUpToPowerOfTwo(std::max<size_t>(slot_count, 2)) - 1),
+      pool_(2 * (mask_ + 1), slot_bytes),
+      slots_(mask_ + 1) {}
+
+bool PcmFrameRing::Write(const uint8_t* data, uint32_t frames,
+                         const AudioFormat& format, uint32_t flags,
+                         const MediaTimestamp& timestamp) {
+  const uint32_t block_align = format.BlockAlign();
+  const uint32_t frames_per_slot =
+      block_align > 0 ? static_cast<uint32_t>(slot_bytes_ / block_align) : 0;
+  if (frames_per_slot == 0) {
+    return false;
+  }
+  const size_t needed = (frames + frames_per_slot - 1) / frames_per_slot;
+
+  const size_t tail = tail_.value.load(std::memory_order_relaxed);
+  const size_t head = head_.value.load(std::memory_order_acquire);
+  if (needed > capacity() - (tail - head)) {
+    overruns_.fetch_add(1, std::memory_order_relaxed);
+    dropped_frames_.fetch_add(frames, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Buffers still held by consumers count against the ring too.
+  for (size_t i = 0; i < needed; ++i) {
+    PcmFrame& slot = slots_[(tail + i) & mask_];
+    slot.buffer = pool_.Acquire();
+    if (!slot.buffer) {
+      for (size_t j = 0; j < i; ++j) {
+        slots_[(tail + j) & mask_].buffer.Reset();
+      }
+      overruns_.fetch_add(1, std::memory_order_relaxed);
+      dropped_frames_.fetch_add(frames, std::memory_order_relaxed);
+      return false;
+    }
+  }
+
+  size_t index = tail;
+  uint32_t written = 0;
+  while (frames > 0) {
+    uint32_t chunk = std::min(frames, frames_per_slot);
+    size_t bytes = static_cast<size_t>(chunk) * block_align;
+    PcmFrame& slot = slots_[index & mask_];
+    slot.data = slot.buffer.data();
+    std::memcpy(slot.data, data, bytes);
+    slot.buffer.set_size(bytes);
+    slot.size = bytes;
+    slot.frames = chunk;
+    slot.flags = flags;
+    slot.timestamp = AdvanceTimestamp(format, timestamp, written);
+    data += bytes;
+    frames -= chunk;
+    written += chunk;
+    ++index;
+  }
+
+  tail_.value.store(index, std::memory_order_release);
+  return true;
+}
+
+bool PcmFrameRing::WriteMarker(uint32_t frames, uint32_t flags,
+                               const MediaTimestamp& timestamp) {
+  const size_t tail = tail_.value.load(std::memory_order_relaxed);
+  const size_t head = head_.value.load(std::memory_order_acquire);
+  if (tail - head >= capacity()) {
+    return false;
+  }
+  PcmFrame& slot = slots_[tail & mask_];
+  slot.buffer.Reset();
+  slot.data = nullptr;
+  slot.size = 0;
+  slot.frames = frames;
+  slot.flags = flags;
+  slot.timestamp = timestamp;
+  tail_.value.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+const PcmFrame* PcmFrameRing::Peek() const {
+  const size_t head = head_.value.load(std::memory_order_relaxed);
+  if (head == tail_.value.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return &slots_[head & mask_];
+}
+
+void PcmFrameRing::Pop() {
+  const size_t head = head_.value.load(std::memory_order_relaxed);
+  // Hands the buffer back unless the consumer kept it.
+  slots_[head & mask_].buffer.Reset();
+  head_.value.store(head + 1, std::memory_order_release);
+}
+
+bool PcmFrameRing::Empty() const { return Size() == 0; }
+
+size_t PcmFrameRing::Size() const {
+  return tail_.value.load(std::memory_order_acquire) -
+         head_.value.load(std::memory_order_acquire);
+}
+
+}  // namespace samurai
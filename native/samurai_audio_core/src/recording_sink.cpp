@@ -0,0 +1,37 @@
+#include "samurai_audio_core/recording_sink.h"
+
+#include "samurai_audio_core/capture_backend.h"
+
+namespace samurai {
+
+bool RecordingSink::Open(const RecordingConfig& config,
+                         const AudioFormat& format) {
+  if (config.path.empty() || !file_.Open(config.path, config.encoder, format)) {
+    return false;
+  }
+  if (!config.wav_path.empty() &&
+      !wav_.Open(config.wav_path, EncoderConfig(), format)) {
+    file_.Close();
+    return false;
+  }
+  return true;
+}
+
+void RecordingSink::Write(const uint8_t* pcm, uint32_t frames,
+                          uint32_t flags) {
+  const uint8_t* data = (flags & kPacketSilenceMarker) ? nullptr : pcm;
+  file_.Write(data, frames);
+  if (wav_.is_open()) {
+    wav_.Write(data, frames);
+  }
+}
+
+bool RecordingSink::Close() {
+  bool ok = file_.Close();
+  if (wav_.is_open()) {
+    ok = wav_.Close() && ok;
+  }
+  return ok;
+}
+
+}  // namespace samurai
@@ -0,0 +1,97 @@
+#include "samurai_audio_core/reframer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "samurai_audio_core/capture_backend.h"
+
+namespace samurai {
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+
+}  // namespace
+
+Reframer::Reframer(const AudioFormat& format, uint32_t frame_ms,
+                   uint32_t flush_timeout_ms)
+    : block_align_(format.BlockAlign()),
+      frame_frames_(std::max<uint32_t>(1, FramesForDuration(format, frame_ms))),
+      timeout_ns_(flush_timeout_ms == 0
+                      ? kNoDeadline
+                      : static_cast<int64_t>(flush_timeout_ms) * 1000000) {
+  const size_t bytes = static_cast<size_t>(frame_frames_) * block_align_;
+  storage_.reset(new uint8_t[bytes + kAlignment]);
+  const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.get());
+  frame_ = storage_.get() + (kAlignment - address % kAlignment) % kAlignment;
+}
+
+void Reframer::Push(const uint8_t* pcm, uint32_t frames, uint32_t flags,
+                    int64_t now_ns, const Output& output) {
+  if (flags & kPacketSilenceMarker) {
+    // Silence is exact zeros, so padding with it keeps the grid without
+    // inventing audio.
+    if (buffered_ > 0) {
+      const uint32_t pad = std::min(frames, frame_frames_ - buffered_);
+      std::memset(frame_ + static_cast<size_t>(buffered_) * block_align_, 0,
+                  static_cast<size_t>(pad) * block_align_);
+      buffered_ += pad;
+      flags_ |= flags & ~static_cast<uint32_t>(kPacketSilenceMarker);
+      frames -= pad;
+      if (buffered_ == frame_frames_) {
+        Emit(output);
+      }
+    }
+    if (frames > 0) {
+      output(nullptr, 0, frames, flags);
+    }
+    return;
+  }
+
+  while (frames > 0) {
+    if (buffered_ == 0) {
+      first_ns_ = now_ns;
+    }
+    flags_ |= flags;
+    flags = 0;
+    const uint32_t take = std::min(frames, frame_frames_ - buffered_);
+    const size_t bytes = static_cast<size_t>(take) * block_align_;
+    std::memcpy(frame_ + static_cast<size_t>(buffered_) * block_align_, pcm,
+                bytes);
+    buffered_ += take;
+    pcm += bytes;
+    frames -= take;
+    if (buffered_ == frame_frames_) {
+      Emit(output);
+    }
+  }
+}
+
+void Reframer::Poll(int64_t now_ns, const Output& output) {
+  if (buffered_ > 0 && now_ns >= deadline_ns()) {
+    ++timeouts_;
+    Emit(output);
+  }
+}
+
+int64_t Reframer::deadline_ns() const {
+  if (buffered_ == 0 || timeout_ns_ == kNoDeadline) {
+    return kNoDeadline;
+  }
+  return first_ns_ + timeout_ns_;
+}
+
+void Reframer::Flush(const Output& output) {
+  if (buffered_ > 0) {
+    Emit(output);
+  }
+}
+
+void Reframer::Emit(const Output& output) {
+  output(frame_, static_cast<size_t>(buffered_) * block_align_, buffered_,
+         flags_);
+  buffered_ = 0;
+  flags_ = 0;
+}
+
+}  // namespace samurai
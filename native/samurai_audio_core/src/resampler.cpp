@@ -0,0 +1,409 @@
+#include "samurai_audio_core/resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "resampler_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+namespace samurai {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Keeps odd rate pairs (e.g. 44100 -> 44101) from building tables of
+// millions of coefficients.
+constexpr size_t kMaxCoefficients = 1u << 20;
+
+struct QualityParams {
+  uint32_t taps;  // At unity ratio.
+  double beta;    // Kaiser window shape.
+  double cutoff;  // Fraction of the lower Nyquist; the stopband starts
+                  // near the Nyquist frequency itself.
+};
+
+QualityParams ParamsFor(ResamplerQuality quality) {
+  switch (quality) {
+    case ResamplerQuality::kLow:
+      return {16, 6.0, 0.76};
+    case ResamplerQuality::kMedium:
+      return {32, 8.0, 0.84};
+    case ResamplerQuality::kHigh:
+      return {64, 10.0, 0.90};
+  }
+  return {32, 8.0, 0.84};
+}
+
+// Zeroth-order modified Bessel function of the first kind.
+double BesselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  const double q = x * x / 4.0;
+  for (int k = 1; k < 64 && term > sum * 1e-17; ++k) {
+    term *= q / (static_cast<double>(k) * k);
+    sum += term;
+  }
+  return sum;
+}
+
+float ScalarDot(const float* a, const float* b, size_t n) {
+  float sum = 0.0f;
+  for (size_t i = 0; i < n; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+internal::ResamplerDot DotFor(ResamplerImpl impl) {
+  internal::ResamplerDot dot = nullptr;
+  switch (impl) {
+    case ResamplerImpl::kSse2:
+      dot = internal::ResamplerDotSse2();
+      break;
+    case ResamplerImpl::kAvx2:
+      dot = internal::ResamplerDotAvx2();
+      break;
+    case ResamplerImpl::kNeon:
+      dot = internal::ResamplerDotNeon();
+      break;
+    case ResamplerImpl::kScalar:
+      break;
+  }
+  return dot ? dot : ScalarDot;
+}
+
+}  // namespace
+
+const char* ResamplerQualityName(ResamplerQuality quality) {
+  switch (quality) {
+    case ResamplerQuality::kLow:
+      return "low";
+    case ResamplerQuality::kMedium:
+      return "medium";
+    case ResamplerQuality::kHigh:
+      return "high";
+  }
+  return "unknown";
+}
+
+bool ParseResamplerQuality(const std::string& name, ResamplerQuality* quality) {
+  for (ResamplerQuality candidate :
+       {ResamplerQuality::kLow, ResamplerQuality::kMedium,
+        ResamplerQuality::kHigh}) {
+    if (name == ResamplerQualityName(candidate)) {
+      *quality = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* ResamplerImplName(ResamplerImpl impl) {
+  switch (impl) {
+    case ResamplerImpl::kScalar:
+      return "scalar";
+    case ResamplerImpl::kSse2:
+      return "sse2";
+    case ResamplerImpl::kAvx2:
+      return "avx2";
+    case ResamplerImpl::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool ResamplerImplSupported(ResamplerImpl impl) {
+  const CpuFeatures& cpu = GetCpuFeatures();
+  switch (impl) {
+    case ResamplerImpl::kScalar:
+      return true;
+#if defined(SAMURAI_ARCH_X86)
+    case ResamplerImpl::kSse2:
+      return cpu.sse2;
+    case ResamplerImpl::kAvx2:
+      return cpu.avx2 && cpu.fma;
+#endif
+#if defined(SAMURAI_ARCH_ARM64)
+    case ResamplerImpl::kNeon:
+      return cpu.neon;
+#endif
+    default:
+      break;
+  }
+  return false;
+}
+
+ResamplerImpl ResamplerBestImpl() {
+  static const ResamplerImpl best = []() {
+    for (ResamplerImpl impl :
+         {ResamplerImpl::kAvx2, ResamplerImpl::kNeon, ResamplerImpl::kSse2}) {
+      if (ResamplerImplSupported(impl)) {
+        return impl;
+      }
+    }
+    return ResamplerImpl::kScalar;
+  }();
+  return best;
+}
+
+Resampler::Resampler(uint32_t input_rate, uint32_t output_rate,
+                     uint16_t channels, ResamplerQuality quality)
+    : Resampler(input_rate, output_rate, channels, quality,
+                ResamplerBestImpl()) {}
+
+Resampler::Resampler(uint32_t input_rate, uint32_t output_rate,
+                     uint16_t channels, ResamplerQuality quality,
+                     ResamplerImpl impl)
+    : input_rate_(input_rate),
+      output_rate_(output_rate),
+      channels_(channels),
+      impl_(impl) {
+  if (input_rate == 0 || output_rate == 0 || channels == 0 ||
+      !ResamplerImplSupported(impl)) {
+    return;
+  }
+  const uint32_t g = std::gcd(input_rate, output_rate);
+  up_ = output_rate / g;
+  down_ = input_rate / g;
+
+  // Downsampling stretches the filter so the transition band scales with
+  // the output rate; round up for the 8-wide kernels.
+  const QualityParams params = ParamsFor(quality);
+  const double ratio =
+      std::min(1.0, static_cast<double>(up_) / static_cast<double>(down_));
+  const uint32_t taps =
+      static_cast<uint32_t>(std::ceil(params.taps / ratio));
+  taps_ = (taps + 7) & ~7u;
+  if (static_cast<size_t>(up_) * taps_ > kMaxCoefficients) {
+    return;
+  }
+
+  // Row p serves outputs that fall p/L of the way between two input
+  // frames. Tap j multiplies history frame pos + j, and the output is
+  // centred on frame pos + taps/2 - 1 + p/L.
+  const double cutoff = params.cutoff * ratio;
+  const double half = taps_ / 2.0;
+  const double window_norm = BesselI0(params.beta);
+  coefficients_.resize(static_cast<size_t>(up_) * taps_);
+  std::vector<double> taps_d(taps_);
+  for (uint32_t p = 0; p < up_; ++p) {
+    float* row = coefficients_.data() + static_cast<size_t>(p) * taps_;
+    const double frac = static_cast<double>(p) / up_;
+    double sum = 0.0;
+    for (uint32_t j = 0; j < taps_; ++j) {
+      const double x = j - (half - 1.0) - frac;
+      const double r = x / half;
+      const double window =
+          r * r < 1.0 ? BesselI0(params.beta * std::sqrt(1.0 - r * r)) /
+                            window_norm
+                      : 0.0;
+      const double arg = kPi * cutoff * x;
+      const double sinc = x == 0.0 ? 1.0 : std::sin(arg) / arg;
+      taps_d[j] = cutoff * sinc * window;
+      sum += taps_d[j];
+    }
+    // Unity DC gain for every phase, so a constant input stays constant.
+    for (uint32_t j = 0; j < taps_; ++j) {
+      row[j] = static_cast<float>(taps_d[j] / sum);
+    }
+  }
+
+  history_.resize(channels_);
+  valid_ = true;
+  Reset();
+}
+
+size_t Resampler::MaxOutputFrames(size_t input_frames) const {
+  // Fewer than taps() frames stay buffered between calls, so at most the
+  // new input's worth of output (rounded up) becomes available.
+  return input_frames * up_ / down_ + 1;
+}
+
+void Resampler::Reset() {
+  if (!valid_) {
+    return;
+  }
+  // Silence before the first frame puts output 0 on input frame 0.
+  buffered_ = taps_ / 2 - 1;
+  phase_ = 0;
+  for (std::vector<float>& channel : history_) {
+    if (channel.size() < buffered_) {
+      channel.resize(buffered_);
+    }
+    std::fill(channel.begin(), channel.begin() + buffered_, 0.0f);
+  }
+}
+
+size_t Resampler::Process(const float* in, size_t frames, float* out) {
+  if (!valid_) {
+    return 0;
+  }
+  // Deinterleave behind the history. The buffers only grow, so steady
+  // state packets do not allocate.
+  const size_t total = buffered_ + frames;
+  for (uint16_t c = 0; c < channels_; ++c) {
+    std::vector<float>& channel = history_[c];
+    if (channel.size() < total) {
+      channel.resize(total);
+    }
+    float* dst = channel.data() + buffered_;
+    for (size_t i = 0; i < frames; ++i) {
+      dst[i] = in[i * channels_ + c];
+    }
+  }
+
+  const internal::ResamplerDot dot = DotFor(impl_);
+  size_t pos = 0;
+  size_t produced = 0;
+  while (pos + taps_ <= total) {
+    const float* row =
+        coefficients_.data() + static_cast<size_t>(phase_) * taps_;
+    float* frame = out + produced * channels_;
+    for (uint16_t c = 0; c < channels_; ++c) {
+      frame[c] = dot(row, history_[c].data() + pos, taps_);
+    }
+    ++produced;
+    phase_ += down_;
+    pos += phase_ / up_;
+    phase_ %= up_;
+  }
+
+  // taps_ >= M / L, so |pos| never steps past the buffered input.
+  buffered_ = total - pos;
+  for (std::vector<float>& channel : history_) {
+    std::memmove(channel.data(), channel.data() + pos,
+                 buffered_ * sizeof(float));
+  }
+  return produced;
+}
+
+AdaptiveResampler::AdaptiveResampler(uint16_t channels,
+                                     ResamplerQuality quality)
+    : AdaptiveResampler(channels, quality, ResamplerBestImpl()) {}
+
+AdaptiveResampler::AdaptiveResampler(uint16_t channels,
+                                     ResamplerQuality quality,
+                                     ResamplerImpl impl)
+    : channels_(channels), impl_(impl) {
+  if (channels == 0 || !ResamplerImplSupported(impl)) {
+    return;
+  }
+  // The ratio stays within a percent of 1, so the unity-ratio prototype
+  // serves every step. Row kPhases is row 0 one frame later, which lets
+  // the interpolation reach a whole frame.
+  const QualityParams params = ParamsFor(quality);
+  taps_ = params.taps;
+  const double half = taps_ / 2.0;
+  const double window_norm = BesselI0(params.beta);
+  coefficients_.resize(static_cast<size_t>(kPhases + 1) * taps_);
+  std::vector<double> taps_d(taps_);
+  for (uint32_t p = 0; p <= kPhases; ++p) {
+    float* row = coefficients_.data() + static_cast<size_t>(p) * taps_;
+    const double frac = static_cast<double>(p) / kPhases;
+    double sum = 0.0;
+    for (uint32_t j = 0; j < taps_; ++j) {
+      const double x = j - (half - 1.0) - frac;
+      const double r = x / half;
+      const double window =
+          r * r < 1.0 ? BesselI0(params.beta * std::sqrt(1.0 - r * r)) /
+                            window_norm
+                      : 0.0;
+      const double arg = kPi * params.cutoff * x;
+      const double sinc = x == 0.0 ? 1.0 : std::sin(arg) / arg;
+      taps_d[j] = params.cutoff * sinc * window;
+      sum += taps_d[j];
+    }
+    for (uint32_t j = 0; j < taps_; ++j) {
+      row[j] = static_cast<float>(taps_d[j] / sum);
+    }
+  }
+  row_.resize(taps_);
+
+  history_.resize(channels_);
+  valid_ = true;
+  Reset();
+}
+
+void AdaptiveResampler::SetRatio(double ratio) {
+  ratio_ = std::min(1.0 + kMaxAdjustment,
+                    std::max(1.0 - kMaxAdjustment, ratio));
+}
+
+size_t AdaptiveResampler::MaxOutputFrames(size_t input_frames) const {
+  // Fewer than taps() frames stay buffered, as in Resampler; the slowest
+  // step stretches the input by at most 1 / 99.
+  return input_frames + input_frames / 99 + 2;
+}
+
+void AdaptiveResampler::Reset() {
+  if (!valid_) {
+    return;
+  }
+  buffered_ = taps_ / 2 - 1;
+  position_ = 0;
+  fraction_ = 0.0;
+  dropped_ = 0;
+  for (std::vector<float>& channel : history_) {
+    if (channel.size() < buffered_) {
+      channel.resize(buffered_);
+    }
+    std::fill(channel.begin(), channel.begin() + buffered_, 0.0f);
+  }
+}
+
+size_t AdaptiveResampler::Process(const float* in, size_t frames,
+                                  float* out) {
+  if (!valid_) {
+    return 0;
+  }
+  const size_t total = buffered_ + frames;
+  for (uint16_t c = 0; c < channels_; ++c) {
+    std::vector<float>& channel = history_[c];
+    if (channel.size() < total) {
+      channel.resize(total);
+    }
+    float* dst = channel.data() + buffered_;
+    for (size_t i = 0; i < frames; ++i) {
+      dst[i] = in[i * channels_ + c];
+    }
+  }
+
+  const internal::ResamplerDot dot = DotFor(impl_);
+  float* row = row_.data();
+  size_t produced = 0;
+  while (position_ + taps_ <= total) {
+    const double phase = fraction_ * kPhases;
+    const uint32_t p = std::min<uint32_t>(static_cast<uint32_t>(phase),
+                                          kPhases - 1);
+    const float weight = static_cast<float>(phase - p);
+    const float* a = coefficients_.data() + static_cast<size_t>(p) * taps_;
+    const float* b = a + taps_;
+    for (uint32_t j = 0; j < taps_; ++j) {
+      row[j] = a[j] + weight * (b[j] - a[j]);
+    }
+    float* frame = out + produced * channels_;
+    for (uint16_t c = 0; c < channels_; ++c) {
+      frame[c] = dot(row, history_[c].data() + position_, taps_);
+    }
+    ++produced;
+    fraction_ += ratio_;
+    const double whole = std::floor(fraction_);
+    position_ += static_cast<size_t>(whole);
+    fraction_ -= whole;
+  }
+
+  const size_t drop = std::min(position_, total);
+  position_ -= drop;
+  dropped_ += drop;
+  buffered_ = total - drop;
+  for (std::vector<float>& channel : history_) {
+    std::memmove(channel.data(), channel.data() + drop,
+                 buffered_ * sizeof(float));
+  }
+  return produced;
+}
+
+}  // namespace samurai
@@ -0,0 +1,21 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_RESAMPLER_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_RESAMPLER_INTERNAL_H_
+
+#include <cstddef>
+
+namespace samurai {
+namespace internal {
+
+// Dot product of two float vectors; |n| is a multiple of 8 (the resampler
+// pads its filter rows), so the kernels need no scalar tail.
+using ResamplerDot = float (*)(const float* a, const float* b, size_t n);
+
+// Null on architectures without the instruction set.
+ResamplerDot ResamplerDotSse2();
+ResamplerDot ResamplerDotAvx2();
+ResamplerDot ResamplerDotNeon();
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_RESAMPLER_INTERNAL_H_
@@ -0,0 +1,36 @@
+#include "resampler_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_ARM64)
+
+namespace {
+
+float DotNeon(const float* a, const float* b, size_t n) {
+  float32x4_t acc0 = vdupq_n_f32(0.0f);
+  float32x4_t acc1 = vdupq_n_f32(0.0f);
+  for (size_t i = 0; i < n; i += 8) {
+    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  return vaddvq_f32(vaddq_f32(acc0, acc1));
+}
+
+}  // namespace
+
+ResamplerDot ResamplerDotNeon() { return DotNeon; }
+
+#else  // !SAMURAI_ARCH_ARM64
+
+ResamplerDot ResamplerDotNeon() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_ARM64
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,70 @@
+#include "resampler_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_X86)
+
+// Two independent accumulators hide the add latency; the summation order
+// differs from the scalar loop, so results agree only to float rounding.
+
+namespace {
+
+SAMURAI_TARGET("sse2")
+float DotSse2(const float* a, const float* b, size_t n) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for (size_t i = 0; i < n; i += 8) {
+    acc0 = _mm_add_ps(acc0,
+                      _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc1 = _mm_add_ps(
+        acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  __m128 sum = _mm_add_ps(acc0, acc1);
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+SAMURAI_TARGET("avx2,fma")
+float DotAvx2(const float* a, const float* b, size_t n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 =
+        _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                           _mm256_loadu_ps(b + i + 8), acc1);
+  }
+  if (i < n) {
+    acc0 =
+        _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+  }
+  const __m256 sum8 = _mm256_add_ps(acc0, acc1);
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8),
+                          _mm256_extractf128_ps(sum8, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+}  // namespace
+
+ResamplerDot ResamplerDotSse2() { return DotSse2; }
+ResamplerDot ResamplerDotAvx2() { return DotAvx2; }
+
+#else  // !SAMURAI_ARCH_X86
+
+ResamplerDot ResamplerDotSse2() { return nullptr; }
+ResamplerDot ResamplerDotAvx2() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_X86
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,237 @@
+#include "samurai_audio_core/sample_convert.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "sample_convert_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+namespace samurai {
+
+namespace {
+
+// Scale to int16 full scale. Int32 and widened int24 share a scale.
+constexpr float kFloatToInt16 = 32768.0f;
+constexpr float kInt32ToInt16 = 1.0f / 65536.0f;
+constexpr float kInt32ToFloat = 1.0f / 2147483648.0f;
+constexpr float kInt16ToFloat = 1.0f / 32768.0f;
+
+uint32_t Xorshift32(uint32_t x) {
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+// Difference of two 16-bit uniforms: triangular on (-1, 1) LSB.
+float TriangularDither(uint32_t r) {
+  const float k = 1.0f / 65536.0f;
+  return static_cast<float>(r & 0xFFFF) * k - static_cast<float>(r >> 16) * k;
+}
+
+// Mirrors the vector sequence: zero NaN, min, max, round to nearest even.
+int16_t SaturateToInt16(float v) {
+  if (!(v == v)) {
+    v = 0.0f;
+  }
+  v = v < 32767.0f ? v : 32767.0f;
+  v = v > -32768.0f ? v : -32768.0f;
+  return static_cast<int16_t>(std::lrintf(v));
+}
+
+float LoadFloat(const uint8_t* in, size_t i) {
+  float v;
+  std::memcpy(&v, in + i * 4, sizeof(v));
+  return v;
+}
+
+int32_t LoadInt32(const uint8_t* in, size_t i) {
+  int32_t v;
+  std::memcpy(&v, in + i * 4, sizeof(v));
+  return v;
+}
+
+// Little-endian 24-bit sample widened to int32 (value << 8).
+int32_t LoadInt24(const uint8_t* in, size_t i) {
+  const uint8_t* p = in + i * 3;
+  uint32_t v = (static_cast<uint32_t>(p[0]) << 8) |
+               (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 24);
+  return static_cast<int32_t>(v);
+}
+
+int16_t LoadInt16(const uint8_t* in, size_t i) {
+  int16_t v;
+  std::memcpy(&v, in + i * 2, sizeof(v));
+  return v;
+}
+
+// Scalar conversion of samples [begin, samples). |begin| is a multiple of
+// the dither block, so sample i draws from lane i % kLanes like the
+// vector kernels do.
+template <typename Load>
+void ScalarToInt16(const uint8_t* in, size_t begin, size_t samples,
+                   float scale, DitherState* dither, int16_t* out, Load load) {
+  for (size_t i = begin; i < samples; ++i) {
+    float v = static_cast<float>(load(in, i)) * scale;
+    if (dither) {
+      uint32_t& lane = dither->lanes[i % DitherState::kLanes];
+      lane = Xorshift32(lane);
+      v += TriangularDither(lane);
+    }
+    out[i] = SaturateToInt16(v);
+  }
+}
+
+const internal::ConvertKernels* KernelsFor(ConvertImpl impl) {
+  switch (impl) {
+    case ConvertImpl::kSsse3:
+      return internal::ConvertKernelsSsse3();
+    case ConvertImpl::kAvx2:
+      return internal::ConvertKernelsAvx2();
+    case ConvertImpl::kNeon:
+      return internal::ConvertKernelsNeon();
+    case ConvertImpl::kScalar:
+      break;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+DitherState::DitherState(uint32_t seed) {
+  // Decorrelate the lanes; xorshift32 must never be seeded with 0.
+  uint32_t x = seed ? seed : 1u;
+  for (int i = 0; i < kLanes; ++i) {
+    x = Xorshift32(x + 0x9E3779B9u);
+    lanes[i] = x ? x : 1u;
+  }
+}
+
+const char* ConvertImplName(ConvertImpl impl) {
+  switch (impl) {
+    case ConvertImpl::kScalar:
+      return "scalar";
+    case ConvertImpl::kSsse3:
+      return "ssse3";
+    case ConvertImpl::kAvx2:
+      return "avx2";
+    case ConvertImpl::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool ConvertImplSupported(ConvertImpl impl) {
+  const CpuFeatures& cpu = GetCpuFeatures();
+  switch (impl) {
+    case ConvertImpl::kScalar:
+      return true;
+#if defined(SAMURAI_ARCH_X86)
+    case ConvertImpl::kSsse3:
+      return cpu.ssse3;
+    case ConvertImpl::kAvx2:
+      return cpu.avx2;
+#endif
+#if defined(SAMURAI_ARCH_ARM64)
+    case ConvertImpl::kNeon:
+      return cpu.neon;
+#endif
+    default:
+      break;
+  }
+  return false;
+}
+
+ConvertImpl ConvertBestImpl() {
+  static const ConvertImpl best = []() {
+    for (ConvertImpl impl :
+         {ConvertImpl::kAvx2, ConvertImpl::kNeon, ConvertImpl::kSsse3}) {
+      if (ConvertImplSupported(impl)) {
+        return impl;
+      }
+    }
+    return ConvertImpl::kScalar;
+  }();
+  return best;
+}
+
+SampleConverter::SampleConverter(SampleType input, SampleType output,
+                                 bool dither)
+    : SampleConverter(input, output, dither, ConvertBestImpl()) {}
+
+SampleConverter::SampleConverter(SampleType input, SampleType output,
+                                 bool dither, ConvertImpl impl)
+    : input_(input),
+      output_(output),
+      dither_(dither),
+      impl_(impl),
+      valid_((output == SampleType::kInt16 ||
+              output == SampleType::kFloat32) &&
+             ConvertImplSupported(impl)) {}
+
+size_t SampleConverter::OutputSize(size_t samples) const {
+  AudioFormat format;
+  format.sample_type = output_;
+  return samples * format.BytesPerSample();
+}
+
+void SampleConverter::Convert(const uint8_t* in, size_t samples,
+                              uint8_t* out) {
+  if (input_ == output_) {
+    std::memcpy(out, in, OutputSize(samples));
+    return;
+  }
+
+  if (output_ == SampleType::kFloat32) {
+    for (size_t i = 0; i < samples; ++i) {
+      float v = 0.0f;
+      switch (input_) {
+        case SampleType::kInt16:
+          v = LoadInt16(in, i) * kInt16ToFloat;
+          break;
+        case SampleType::kInt24:
+          v = static_cast<float>(LoadInt24(in, i)) * kInt32ToFloat;
+          break;
+        case SampleType::kInt32:
+          v = static_cast<float>(LoadInt32(in, i)) * kInt32ToFloat;
+          break;
+        case SampleType::kFloat32:
+          break;
+      }
+      std::memcpy(out + i * 4, &v, sizeof(v));
+    }
+    return;
+  }
+
+  // Narrowing to int16; |out| is only byte-aligned in general, but every
+  // caller hands us ring or vector storage, which is 2-byte aligned.
+  int16_t* dst = reinterpret_cast<int16_t*>(out);
+  DitherState* dither = dither_ ? &dither_state_ : nullptr;
+  const internal::ConvertKernels* kernels = KernelsFor(impl_);
+  size_t done = 0;
+  switch (input_) {
+    case SampleType::kFloat32:
+      if (kernels) {
+        done = kernels->float_to_int16(in, samples, kFloatToInt16, dither, dst);
+      }
+      ScalarToInt16(in, done, samples, kFloatToInt16, dither, dst, LoadFloat);
+      break;
+    case SampleType::kInt32:
+      if (kernels) {
+        done = kernels->int32_to_int16(in, samples, kInt32ToInt16, dither, dst);
+      }
+      ScalarToInt16(in, done, samples, kInt32ToInt16, dither, dst, LoadInt32);
+      break;
+    case SampleType::kInt24:
+      if (kernels) {
+        done = kernels->int24_to_int16(in, samples, kInt32ToInt16, dither, dst);
+      }
+      ScalarToInt16(in, done, samples, kInt32ToInt16, dither, dst, LoadInt24);
+      break;
+    case SampleType::kInt16:
+      break;
+  }
+}
+
+}  // namespace samurai
@@ -0,0 +1,34 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_SAMPLE_CONVERT_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_SAMPLE_CONVERT_INTERNAL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "samurai_audio_core/sample_convert.h"
+
+namespace samurai {
+namespace internal {
+
+// SIMD kernels convert whole blocks of DitherState::kLanes samples to int16
+// as round(clamp(value * scale + dither)) and return the number of samples
+// consumed; the caller finishes the tail with the scalar code. |dither| is
+// null when dithering is off. Int24 input is widened to int32 (value << 8)
+// before scaling.
+struct ConvertKernels {
+  size_t (*float_to_int16)(const uint8_t* in, size_t samples, float scale,
+                           DitherState* dither, int16_t* out);
+  size_t (*int32_to_int16)(const uint8_t* in, size_t samples, float scale,
+                           DitherState* dither, int16_t* out);
+  size_t (*int24_to_int16)(const uint8_t* in, size_t samples, float scale,
+                           DitherState* dither, int16_t* out);
+};
+
+// Null on architectures without the instruction set.
+const ConvertKernels* ConvertKernelsSsse3();
+const ConvertKernels* ConvertKernelsAvx2();
+const ConvertKernels* ConvertKernelsNeon();
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_SAMPLE_CONVERT_INTERNAL_H_
@@ -0,0 +1,115 @@
+#include "sample_convert_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_ARM64)
+
+// Same block structure as the x86 kernels. vcvtnq rounds to nearest even
+// and saturates, and vqmovn saturates again to int16, which gives the same
+// result as clamping first; NaN converts to 0 as in the scalar code.
+
+namespace {
+
+constexpr int kBlock = DitherState::kLanes;
+
+inline float32x4_t DitherNeon(uint32x4_t* state) {
+  uint32x4_t x = *state;
+  x = veorq_u32(x, vshlq_n_u32(x, 13));
+  x = veorq_u32(x, vshrq_n_u32(x, 17));
+  x = veorq_u32(x, vshlq_n_u32(x, 5));
+  *state = x;
+  const float32x4_t k = vdupq_n_f32(1.0f / 65536.0f);
+  const float32x4_t u1 =
+      vmulq_f32(vcvtq_f32_u32(vandq_u32(x, vdupq_n_u32(0xFFFF))), k);
+  const float32x4_t u2 = vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(x, 16)), k);
+  return vsubq_f32(u1, u2);
+}
+
+inline void StoreBlockNeon(float32x4_t lo, float32x4_t hi, float32x4_t scale,
+                           uint32x4_t* state, int16_t* out) {
+  lo = vmulq_f32(lo, scale);
+  hi = vmulq_f32(hi, scale);
+  if (state) {
+    lo = vaddq_f32(lo, DitherNeon(&state[0]));
+    hi = vaddq_f32(hi, DitherNeon(&state[1]));
+  }
+  vst1q_s16(out, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)),
+                              vqmovn_s32(vcvtnq_s32_f32(hi))));
+}
+
+// Widens eight 3-byte samples to int32 (value << 8).
+inline void LoadInt24Neon(const uint8_t* p, int32x4_t* lo, int32x4_t* hi) {
+  const uint8x8x3_t bytes = vld3_u8(p);
+  const uint16x8_t b0 = vmovl_u8(bytes.val[0]);
+  const uint16x8_t b1 = vmovl_u8(bytes.val[1]);
+  const uint16x8_t b2 = vmovl_u8(bytes.val[2]);
+  // (b2 << 24) | (b1 << 16) | (b0 << 8)
+  const uint16x8_t low16 = vshlq_n_u16(b0, 8);
+  const uint16x8_t high16 = vorrq_u16(vshlq_n_u16(b2, 8), b1);
+  *lo = vreinterpretq_s32_u32(
+      vorrq_u32(vshll_n_u16(vget_low_u16(high16), 16),
+                vmovl_u16(vget_low_u16(low16))));
+  *hi = vreinterpretq_s32_u32(
+      vorrq_u32(vshll_n_u16(vget_high_u16(high16), 16),
+                vmovl_u16(vget_high_u16(low16))));
+}
+
+enum class Source { kFloat, kInt32, kInt24 };
+
+template <Source kSource>
+size_t ToInt16Neon(const uint8_t* in, size_t samples, float scale,
+                   DitherState* dither, int16_t* out) {
+  uint32x4_t state[2] = {vdupq_n_u32(0), vdupq_n_u32(0)};
+  if (dither) {
+    state[0] = vld1q_u32(dither->lanes);
+    state[1] = vld1q_u32(dither->lanes + 4);
+  }
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  size_t i = 0;
+  for (; i + kBlock <= samples; i += kBlock) {
+    float32x4_t lo, hi;
+    if (kSource == Source::kFloat) {
+      const float* src = reinterpret_cast<const float*>(in) + i;
+      lo = vld1q_f32(src);
+      hi = vld1q_f32(src + 4);
+    } else if (kSource == Source::kInt32) {
+      const int32_t* src = reinterpret_cast<const int32_t*>(in) + i;
+      lo = vcvtq_f32_s32(vld1q_s32(src));
+      hi = vcvtq_f32_s32(vld1q_s32(src + 4));
+    } else {
+      int32x4_t a, b;
+      LoadInt24Neon(in + i * 3, &a, &b);
+      lo = vcvtq_f32_s32(a);
+      hi = vcvtq_f32_s32(b);
+    }
+    StoreBlockNeon(lo, hi, vscale, dither ? state : nullptr, out + i);
+  }
+  if (dither) {
+    vst1q_u32(dither->lanes, state[0]);
+    vst1q_u32(dither->lanes + 4, state[1]);
+  }
+  return i;
+}
+
+const ConvertKernels kNeonKernels = {ToInt16Neon<Source::kFloat>,
+                                     ToInt16Neon<Source::kInt32>,
+                                     ToInt16Neon<Source::kInt24>};
+
+}  // namespace
+
+const ConvertKernels* ConvertKernelsNeon() { return &kNeonKernels; }
+
+#else  // !SAMURAI_ARCH_ARM64
+
+const ConvertKernels* ConvertKernelsNeon() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_ARM64
+
+}  // namespace internal
+}  // namespace samurai
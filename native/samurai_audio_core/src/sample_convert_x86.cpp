@@ -0,0 +1,258 @@
+#include "sample_convert_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_X86)
+
+// Each kernel handles one dither block (8 samples) per iteration: scale,
+// add dither from the per-lane xorshift32 state, zero NaNs, clamp, convert
+// with round-to-nearest-even and pack to int16. The operation order matches
+// the scalar code exactly, so every implementation is bit-identical.
+
+namespace {
+
+constexpr int kBlock = DitherState::kLanes;
+
+// Spreads 3-byte samples into the top of 32-bit lanes (value << 8).
+#define SAMURAI_INT24_SHUFFLE                                              \
+  -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11
+
+SAMURAI_TARGET("ssse3")
+inline __m128 DitherSsse3(__m128i* state) {
+  __m128i x = *state;
+  x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+  x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+  x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+  *state = x;
+  const __m128 k = _mm_set1_ps(1.0f / 65536.0f);
+  const __m128 u1 = _mm_mul_ps(
+      _mm_cvtepi32_ps(_mm_and_si128(x, _mm_set1_epi32(0xFFFF))), k);
+  const __m128 u2 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 16)), k);
+  return _mm_sub_ps(u1, u2);
+}
+
+SAMURAI_TARGET("ssse3")
+inline __m128i SaturateSsse3(__m128 v) {
+  v = _mm_and_ps(v, _mm_cmpord_ps(v, v));
+  v = _mm_min_ps(v, _mm_set1_ps(32767.0f));
+  v = _mm_max_ps(v, _mm_set1_ps(-32768.0f));
+  return _mm_cvtps_epi32(v);
+}
+
+SAMURAI_TARGET("ssse3")
+inline void StoreBlockSsse3(__m128 lo, __m128 hi, __m128 scale,
+                            __m128i* state, int16_t* out) {
+  lo = _mm_mul_ps(lo, scale);
+  hi = _mm_mul_ps(hi, scale);
+  if (state) {
+    lo = _mm_add_ps(lo, DitherSsse3(&state[0]));
+    hi = _mm_add_ps(hi, DitherSsse3(&state[1]));
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm_packs_epi32(SaturateSsse3(lo), SaturateSsse3(hi)));
+}
+
+SAMURAI_TARGET("ssse3")
+size_t FloatToInt16Ssse3(const uint8_t* in, size_t samples, float scale,
+                         DitherState* dither, int16_t* out) {
+  const float* src = reinterpret_cast<const float*>(in);
+  __m128i state[2] = {_mm_setzero_si128(), _mm_setzero_si128()};
+  if (dither) {
+    state[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes));
+    state[1] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes + 4));
+  }
+  const __m128 vscale = _mm_set1_ps(scale);
+  size_t i = 0;
+  for (; i + kBlock <= samples; i += kBlock) {
+    StoreBlockSsse3(_mm_loadu_ps(src + i), _mm_loadu_ps(src + i + 4), vscale,
+                    dither ? state : nullptr, out + i);
+  }
+  if (dither) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes), state[0]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes + 4), state[1]);
+  }
+  return i;
+}
+
+SAMURAI_TARGET("ssse3")
+size_t Int32ToInt16Ssse3(const uint8_t* in, size_t samples, float scale,
+                         DitherState* dither, int16_t* out) {
+  const __m128i* src = reinterpret_cast<const __m128i*>(in);
+  __m128i state[2] = {_mm_setzero_si128(), _mm_setzero_si128()};
+  if (dither) {
+    state[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes));
+    state[1] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes + 4));
+  }
+  const __m128 vscale = _mm_set1_ps(scale);
+  size_t i = 0;
+  for (; i + kBlock <= samples; i += kBlock) {
+    __m128 lo = _mm_cvtepi32_ps(_mm_loadu_si128(src + i / 4));
+    __m128 hi = _mm_cvtepi32_ps(_mm_loadu_si128(src + i / 4 + 1));
+    StoreBlockSsse3(lo, hi, vscale, dither ? state : nullptr, out + i);
+  }
+  if (dither) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes), state[0]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes + 4), state[1]);
+  }
+  return i;
+}
+
+SAMURAI_TARGET("ssse3")
+size_t Int24ToInt16Ssse3(const uint8_t* in, size_t samples, float scale,
+                         DitherState* dither, int16_t* out) {
+  __m128i state[2] = {_mm_setzero_si128(), _mm_setzero_si128()};
+  if (dither) {
+    state[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes));
+    state[1] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes + 4));
+  }
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128i spread = _mm_setr_epi8(SAMURAI_INT24_SHUFFLE);
+  size_t i = 0;
+  // The second 16-byte load of a block reads 4 bytes past it, so stop while
+  // at least 28 input bytes remain.
+  for (; i + kBlock + 2 <= samples; i += kBlock) {
+    const uint8_t* p = in + i * 3;
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+    __m128 lo = _mm_cvtepi32_ps(_mm_shuffle_epi8(a, spread));
+    __m128 hi = _mm_cvtepi32_ps(_mm_shuffle_epi8(b, spread));
+    StoreBlockSsse3(lo, hi, vscale, dither ? state : nullptr, out + i);
+  }
+  if (dither) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes), state[0]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes + 4), state[1]);
+  }
+  return i;
+}
+
+SAMURAI_TARGET("avx2")
+inline __m256 DitherAvx2(__m256i* state) {
+  __m256i x = *state;
+  x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+  x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+  *state = x;
+  const __m256 k = _mm256_set1_ps(1.0f / 65536.0f);
+  const __m256 u1 = _mm256_mul_ps(
+      _mm256_cvtepi32_ps(_mm256_and_si256(x, _mm256_set1_epi32(0xFFFF))), k);
+  const __m256 u2 =
+      _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 16)), k);
+  return _mm256_sub_ps(u1, u2);
+}
+
+SAMURAI_TARGET("avx2")
+inline void StoreBlockAvx2(__m256 v, __m256 scale, __m256i* state,
+                           int16_t* out) {
+  v = _mm256_mul_ps(v, scale);
+  if (state) {
+    v = _mm256_add_ps(v, DitherAvx2(state));
+  }
+  v = _mm256_and_ps(v, _mm256_cmp_ps(v, v, _CMP_ORD_Q));
+  v = _mm256_min_ps(v, _mm256_set1_ps(32767.0f));
+  v = _mm256_max_ps(v, _mm256_set1_ps(-32768.0f));
+  const __m256i i32 = _mm256_cvtps_epi32(v);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm_packs_epi32(_mm256_castsi256_si128(i32),
+                                   _mm256_extracti128_si256(i32, 1)));
+}
+
+SAMURAI_TARGET("avx2")
+size_t FloatToInt16Avx2(const uint8_t* in, size_t samples, float scale,
+                        DitherState* dither, int16_t* out) {
+  const float* src = reinterpret_cast<const float*>(in);
+  __m256i state = _mm256_setzero_si256();
+  if (dither) {
+    state =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither->lanes));
+  }
+  const __m256 vscale = _mm256_set1_ps(scale);
+  size_t i = 0;
+  for (; i + kBlock <= samples; i += kBlock) {
+    StoreBlockAvx2(_mm256_loadu_ps(src + i), vscale,
+                   dither ? &state : nullptr, out + i);
+  }
+  if (dither) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither->lanes), state);
+  }
+  return i;
+}
+
+SAMURAI_TARGET("avx2")
+size_t Int32ToInt16Avx2(const uint8_t* in, size_t samples, float scale,
+                        DitherState* dither, int16_t* out) {
+  __m256i state = _mm256_setzero_si256();
+  if (dither) {
+    state =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither->lanes));
+  }
+  const __m256 vscale = _mm256_set1_ps(scale);
+  size_t i = 0;
+  for (; i + kBlock <= samples; i += kBlock) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 4));
+    StoreBlockAvx2(_mm256_cvtepi32_ps(v), vscale, dither ? &state : nullptr,
+                   out + i);
+  }
+  if (dither) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither->lanes), state);
+  }
+  return i;
+}
+
+SAMURAI_TARGET("avx2")
+size_t Int24ToInt16Avx2(const uint8_t* in, size_t samples, float scale,
+                        DitherState* dither, int16_t* out) {
+  __m256i state = _mm256_setzero_si256();
+  if (dither) {
+    state =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither->lanes));
+  }
+  const __m256 vscale = _mm256_set1_ps(scale);
+  const __m256i spread = _mm256_setr_epi8(SAMURAI_INT24_SHUFFLE,
+                                          SAMURAI_INT24_SHUFFLE);
+  size_t i = 0;
+  // Same 4-byte over-read as the SSSE3 kernel.
+  for (; i + kBlock + 2 <= samples; i += kBlock) {
+    const uint8_t* p = in + i * 3;
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+    StoreBlockAvx2(_mm256_cvtepi32_ps(_mm256_shuffle_epi8(v, spread)), vscale,
+                   dither ? &state : nullptr, out + i);
+  }
+  if (dither) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither->lanes), state);
+  }
+  return i;
+}
+
+#undef SAMURAI_INT24_SHUFFLE
+
+const ConvertKernels kSsse3Kernels = {FloatToInt16Ssse3, Int32ToInt16Ssse3,
+                                      Int24ToInt16Ssse3};
+const ConvertKernels kAvx2Kernels = {FloatToInt16Avx2, Int32ToInt16Avx2,
+                                     Int24ToInt16Avx2};
+
+}  // namespace
+
+const ConvertKernels* ConvertKernelsSsse3() { return &kSsse3Kernels; }
+const ConvertKernels* ConvertKernelsAvx2() { return &kAvx2Kernels; }
+
+#else  // !SAMURAI_ARCH_X86
+
+const ConvertKernels* ConvertKernelsSsse3() { return nullptr; }
+const ConvertKernels* ConvertKernelsAvx2() { return nullptr; }
+
+#endif
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,94 @@
+#include "sha1_internal.h"
+
+#include <cstring>
+
+namespace samurai {
+namespace internal {
+
+namespace {
+
+inline uint32_t Rotl(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+void Compress(uint32_t state[5], const uint8_t block[64]) {
+  uint32_t w[80];
+  for (int i = 0; i < 16; ++i) {
+    w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+           (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+           (static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+           static_cast<uint32_t>(block[i * 4 + 3]);
+  }
+  for (int i = 16; i < 80; ++i) {
+    w[i] = Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  }
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+           e = state[4];
+  for (int i = 0; i < 80; ++i) {
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDC;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6;
+    }
+    const uint32_t t = Rotl(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = Rotl(b, 30);
+    b = a;
+    a = t;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+}  // namespace
+
+void Sha1(const uint8_t* data, size_t size,
+          uint8_t digest[kSha1DigestBytes]) {
+  uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                       0xC3D2E1F0};
+  size_t done = 0;
+  for (; size - done >= 64; done += 64) {
+    Compress(state, data + done);
+  }
+
+  // Padding: 0x80, zeros, then the bit length big-endian in the last 8
+  // bytes of one or two final blocks.
+  uint8_t tail[128] = {};
+  const size_t rest = size - done;
+  if (rest > 0) {
+    std::memcpy(tail, data + done, rest);
+  }
+  tail[rest] = 0x80;
+  const size_t tail_size = rest < 56 ? 64 : 128;
+  const uint64_t bits = static_cast<uint64_t>(size) * 8;
+  for (int i = 0; i < 8; ++i) {
+    tail[tail_size - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+  }
+  Compress(state, tail);
+  if (tail_size == 128) {
+    Compress(state, tail + 64);
+  }
+
+  for (int i = 0; i < 5; ++i) {
+    digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+    digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+    digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+    digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+  }
+}
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,20 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_SHA1_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_SHA1_INTERNAL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace samurai {
+namespace internal {
+
+constexpr size_t kSha1DigestBytes = 20;
+
+// FIPS 180-4 SHA-1. Only for the WebSocket handshake, where RFC 6455
+// fixes the algorithm; never use it for anything security-relevant.
+void Sha1(const uint8_t* data, size_t size,
+          uint8_t digest[kSha1DigestBytes]);
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_SHA1_INTERNAL_H_
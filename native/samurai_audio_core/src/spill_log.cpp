@@ -0,0 +1,346 @@
+#include "samurai_audio_core/spill_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "samurai_audio_core/mapped_file.h"
+
+namespace samurai {
+
+namespace {
+
+// A record, in host byte order: payload size (never 0), checksum, audio
+// ns, then the payload padded to 8 bytes. Segments are zero-filled when
+// allocated, so a zero size ends a segment's records.
+constexpr size_t kRecordHeaderBytes = 16;
+
+constexpr char kSegmentPrefix[] = "spill-";
+constexpr char kSegmentSuffix[] = ".log";
+
+struct RecordHeader {
+  uint32_t size = 0;
+  uint32_t checksum = 0;
+  uint64_t ns = 0;
+};
+
+size_t RecordBytes(size_t size) {
+  return kRecordHeaderBytes + (size + 7) / 8 * 8;
+}
+
+RecordHeader ReadHeader(const uint8_t* in) {
+  RecordHeader header;
+  std::memcpy(&header.size, in, 4);
+  std::memcpy(&header.checksum, in + 4, 4);
+  std::memcpy(&header.ns, in + 8, 8);
+  return header;
+}
+
+void WriteHeader(const RecordHeader& header, uint8_t* out) {
+  std::memcpy(out, &header.size, 4);
+  std::memcpy(out + 4, &header.checksum, 4);
+  std::memcpy(out + 8, &header.ns, 8);
+}
+
+// FNV-1a over the audio duration and the payload.
+uint32_t Checksum(uint64_t ns, const uint8_t* data, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < 8; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(ns >> (8 * i))) * 16777619u;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Parses "spill-<number>.log".
+bool ParseSegmentName(const std::string& name, uint64_t* number) {
+  const size_t prefix = sizeof(kSegmentPrefix) - 1;
+  const size_t suffix = sizeof(kSegmentSuffix) - 1;
+  if (name.size() <= prefix + suffix || name.size() > prefix + suffix + 20 ||
+      name.compare(0, prefix, kSegmentPrefix) != 0 ||
+      name.compare(name.size() - suffix, suffix, kSegmentSuffix) != 0) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (size_t i = prefix; i < name.size() - suffix; ++i) {
+    if (name[i] < '0' || name[i] > '9' || value > UINT64_MAX / 10) {
+      return false;
+    }
+    value = value * 10 + static_cast<uint64_t>(name[i] - '0');
+  }
+  *number = value;
+  return true;
+}
+
+}  // namespace
+
+struct SpillLog::Segment {
+  uint64_t number = 0;
+  MappedFile file;
+  // Recovered segments are only read.
+  bool writable = false;
+  size_t write_offset = 0;  // End of the records.
+  size_t read_offset = 0;
+  size_t synced_offset = 0;
+  // Unread.
+  uint64_t records = 0;
+  uint64_t bytes = 0;
+  uint64_t ns = 0;
+};
+
+SpillLog::SpillLog(SpillLogConfig config)
+    : config_(std::move(config)),
+      max_segments_(std::max<size_t>(
+          2, config_.max_bytes / std::max<size_t>(1, config_.segment_bytes))) {
+}
+
+SpillLog::~SpillLog() { Close(); }
+
+bool SpillLog::Open() {
+  Close();
+  std::error_code ec;
+  const std::filesystem::path directory =
+      std::filesystem::u8path(config_.directory);
+  std::filesystem::create_directories(directory, ec);
+  if (ec) {
+    return false;
+  }
+  std::vector<uint64_t> numbers;
+  for (std::filesystem::directory_iterator it(directory, ec), end;
+       !ec && it != end; it.increment(ec)) {
+    uint64_t number;
+    if (ParseSegmentName(it->path().filename().u8string(), &number)) {
+      numbers.push_back(number);
+    }
+  }
+  if (ec) {
+    return false;
+  }
+  std::sort(numbers.begin(), numbers.end());
+
+  stats_ = SpillLogStats();
+  for (uint64_t number : numbers) {
+    next_number_ = number + 1;
+    std::unique_ptr<Segment> segment = Recover(number);
+    if (!segment) {
+      std::filesystem::remove(std::filesystem::u8path(SegmentPath(number)),
+                              ec);
+      continue;
+    }
+    stats_.recovered_records += segment->records;
+    stats_.pending_records += segment->records;
+    stats_.pending_bytes += segment->bytes;
+    stats_.pending_ns += segment->ns;
+    segments_.push_back(std::move(segment));
+  }
+  while (segments_.size() > max_segments_) {
+    EvictOldest();
+  }
+  open_ = true;
+  return true;
+}
+
+void SpillLog::Close() {
+  if (open_) {
+    Sync();
+  }
+  segments_.clear();
+  next_index_ = 0;
+  unsynced_bytes_ = 0;
+  open_ = false;
+}
+
+std::string SpillLog::SegmentPath(uint64_t number) const {
+  // Zero-padded, so the files list in order.
+  const std::string digits = std::to_string(number);
+  return config_.directory + "/" + kSegmentPrefix +
+         std::string(20 - digits.size(), '0') + digits + kSegmentSuffix;
+}
+
+std::unique_ptr<SpillLog::Segment> SpillLog::Recover(uint64_t number) {
+  auto segment = std::make_unique<Segment>();
+  segment->number = number;
+  if (!segment->file.Open(SegmentPath(number)) || !segment->file.data()) {
+    return nullptr;
+  }
+  const uint8_t* data = segment->file.data();
+  const size_t size = segment->file.size();
+  size_t offset = 0;
+  while (size - offset >= kRecordHeaderBytes) {
+    const RecordHeader header = ReadHeader(data + offset);
+    if (header.size == 0 ||
+        header.size > size - offset - kRecordHeaderBytes ||
+        header.checksum != Checksum(header.ns,
+                                    data + offset + kRecordHeaderBytes,
+                                    header.size)) {
+      break;
+    }
+    ++segment->records;
+    segment->bytes += header.size;
+    segment->ns += header.ns;
+    offset = std::min(size, offset + RecordBytes(header.size));
+  }
+  segment->write_offset = offset;
+  segment->synced_offset = offset;
+  if (segment->records == 0) {
+    return nullptr;
+  }
+  return segment;
+}
+
+bool SpillLog::Append(const uint8_t* data, size_t size, uint64_t ns) {
+  const size_t bytes = RecordBytes(size);
+  if (!open_ || size == 0 || size > UINT32_MAX ||
+      bytes > config_.segment_bytes) {
+    return false;
+  }
+  if (segments_.empty() || !segments_.back()->writable ||
+      segments_.back()->write_offset + bytes >
+          segments_.back()->file.size()) {
+    if (!AddSegment()) {
+      return false;
+    }
+  }
+  Segment& tail = *segments_.back();
+  uint8_t* out = tail.file.mutable_data() + tail.write_offset;
+  std::memcpy(out + kRecordHeaderBytes, data, size);
+  RecordHeader header;
+  header.size = static_cast<uint32_t>(size);
+  header.checksum = Checksum(ns, data, size);
+  header.ns = ns;
+  WriteHeader(header, out);
+  tail.write_offset += bytes;
+  ++tail.records;
+  tail.bytes += size;
+  tail.ns += ns;
+  ++stats_.appended_records;
+  ++stats_.pending_records;
+  stats_.pending_bytes += size;
+  stats_.pending_ns += ns;
+
+  if (unsynced_bytes_ == 0) {
+    unsynced_since_ = std::chrono::steady_clock::now();
+  }
+  unsynced_bytes_ += bytes;
+  MaybeSync();
+  RemoveRead();
+  return true;
+}
+
+bool SpillLog::AddSegment() {
+  // The tail is complete: later syncs only cover the new one.
+  Sync();
+  while (segments_.size() >= max_segments_) {
+    EvictOldest();
+  }
+  auto segment = std::make_unique<Segment>();
+  segment->number = next_number_++;
+  segment->writable = true;
+  const std::string path = SegmentPath(segment->number);
+  if (!segment->file.OpenWritable(path, config_.segment_bytes)) {
+    segment->file.Close();
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::u8path(path), ec);
+    return false;
+  }
+  segments_.push_back(std::move(segment));
+  return true;
+}
+
+bool SpillLog::Peek(SpillRecord* record) {
+  if (stats_.pending_records == 0) {
+    return false;
+  }
+  // RemoveRead() leaves the oldest segment with something unread.
+  const Segment& oldest = *segments_.front();
+  const uint8_t* at = oldest.file.data() + oldest.read_offset;
+  const RecordHeader header = ReadHeader(at);
+  record->data = at + kRecordHeaderBytes;
+  record->size = header.size;
+  record->ns = header.ns;
+  record->index = next_index_;
+  return true;
+}
+
+void SpillLog::Pop(uint64_t index) {
+  if (index != next_index_ || stats_.pending_records == 0) {
+    return;
+  }
+  Segment& oldest = *segments_.front();
+  const RecordHeader header =
+      ReadHeader(oldest.file.data() + oldest.read_offset);
+  const size_t bytes = RecordBytes(header.size);
+  oldest.file.Release(oldest.read_offset, bytes);
+  oldest.read_offset += bytes;
+  --oldest.records;
+  oldest.bytes -= header.size;
+  oldest.ns -= header.ns;
+  --stats_.pending_records;
+  stats_.pending_bytes -= header.size;
+  stats_.pending_ns -= header.ns;
+  ++stats_.consumed_records;
+  ++next_index_;
+  RemoveRead();
+}
+
+void SpillLog::EvictOldest() {
+  Segment& oldest = *segments_.front();
+  stats_.dropped_records += oldest.records;
+  stats_.pending_records -= oldest.records;
+  stats_.pending_bytes -= oldest.bytes;
+  stats_.pending_ns -= oldest.ns;
+  next_index_ += oldest.records;
+  RemoveOldest();
+}
+
+void SpillLog::RemoveOldest() {
+  const std::string path = SegmentPath(segments_.front()->number);
+  segments_.pop_front();
+  if (segments_.empty()) {
+    unsynced_bytes_ = 0;
+  }
+  std::error_code ec;
+  std::filesystem::remove(std::filesystem::u8path(path), ec);
+}
+
+void SpillLog::RemoveRead() {
+  while (!segments_.empty() && segments_.front()->records == 0 &&
+         (segments_.size() > 1 || stats_.pending_records == 0)) {
+    RemoveOldest();
+  }
+}
+
+void SpillLog::Sync() {
+  if (unsynced_bytes_ == 0 || segments_.empty()) {
+    return;
+  }
+  Segment& tail = *segments_.back();
+  tail.file.Sync(tail.synced_offset, tail.write_offset - tail.synced_offset);
+  tail.synced_offset = tail.write_offset;
+  unsynced_bytes_ = 0;
+  ++stats_.syncs;
+}
+
+void SpillLog::MaybeSync() {
+  if (unsynced_bytes_ >= config_.sync_bytes ||
+      (config_.sync_interval_ms > 0 &&
+       std::chrono::steady_clock::now() - unsynced_since_ >=
+           std::chrono::milliseconds(config_.sync_interval_ms))) {
+    Sync();
+  }
+}
+
+SpillLogStats SpillLog::stats() const {
+  SpillLogStats stats = stats_;
+  for (const std::unique_ptr<Segment>& segment : segments_) {
+    stats.disk_bytes += segment->file.size();
+  }
+  return stats;
+}
+
+}  // namespace samurai
@@ -0,0 +1,164 @@
+#include "samurai_audio_core/stream_aligner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace samurai {
+
+StreamAligner::StreamAligner(const StreamAlignerConfig& config)
+    : config_(config) {}
+
+bool StreamAligner::Push(const AudioPacket& packet, const Output& output) {
+  const int index = static_cast<int>(packet.stream);
+  if (index >= kStreamKindCount || packet.codec != CodecId::kPcm ||
+      packet.format.channels != 1 || !packet.format.IsValid() ||
+      (configured_ && packet.format != input_format_)) {
+    ++stats_.rejected_packets;
+    return false;
+  }
+  if (!configured_) {
+    configured_ = true;
+    input_format_ = packet.format;
+    output_format_ = packet.format;
+    output_format_.channels = 2;
+    frame_frames_ = std::max<uint32_t>(
+        1, FramesForDuration(input_format_, config_.frame_ms));
+    capacity_frames_ =
+        frame_frames_ +
+        std::max(frame_frames_,
+                 FramesForDuration(input_format_, config_.max_wait_ms));
+    buffer_.assign(
+        static_cast<size_t>(capacity_frames_) * output_format_.BlockAlign(), 0);
+    packet_flags_.assign(capacity_frames_ / frame_frames_ + 1, 0);
+    origin_ns_ = packet.capture_time_ns;
+  }
+
+  Input& input = inputs_[index];
+  int64_t start = static_cast<int64_t>(packet.position);
+  if (!input.started) {
+    // The output frame nearest the packet's capture time.
+    const double delta_ns =
+        static_cast<double>(packet.capture_time_ns - origin_ns_);
+    const int64_t frame = static_cast<int64_t>(
+        std::llround(delta_ns * input_format_.sample_rate / 1e9));
+    input.started = true;
+    input.offset = frame - start;
+    input.begin = frame;
+    input.end = frame;
+  }
+  start += input.offset;
+  if (start > input.end) {
+    MarkFrame(input.end, kPacketDiscontinuity);
+  }
+
+  const bool marker = (packet.flags & kPacketSilenceMarker) != 0;
+  const uint32_t sample_bytes = input_format_.BytesPerSample();
+  const uint32_t frame_bytes = output_format_.BlockAlign();
+  const uint8_t* data = packet.data;
+  int64_t frames = packet.frames;
+  if (start < base_) {
+    const int64_t late = std::min(frames, base_ - start);
+    stats_.late_frames[index] += static_cast<uint64_t>(late);
+    start += late;
+    frames -= late;
+    if (!marker) {
+      data += late * sample_bytes;
+    }
+  }
+  while (frames > 0) {
+    const int64_t limit = base_ + capacity_frames_;
+    if (start >= limit) {
+      // This stream is |max_wait_ms| ahead: the other one is late.
+      Emit(frame_frames_, output);
+      continue;
+    }
+    const int64_t chunk = std::min(frames, limit - start);
+    if (!marker) {
+      uint8_t* dst = buffer_.data() + (start - base_) * frame_bytes +
+                     index * sample_bytes;
+      for (int64_t i = 0; i < chunk; ++i) {
+        std::memcpy(dst, data, sample_bytes);
+        dst += frame_bytes;
+        data += sample_bytes;
+      }
+    }
+    start += chunk;
+    frames -= chunk;
+  }
+  input.end = std::max(input.end, start);
+
+  // Everything both streams have covered is final.
+  if (inputs_[0].started && inputs_[1].started) {
+    const int64_t ready = std::min(inputs_[0].end, inputs_[1].end);
+    while (ready - base_ >= frame_frames_) {
+      Emit(frame_frames_, output);
+    }
+  }
+  return true;
+}
+
+void StreamAligner::Flush(const Output& output) {
+  int64_t end = base_;
+  for (const Input& input : inputs_) {
+    if (input.started) {
+      end = std::max(end, input.end);
+    }
+  }
+  while (end > base_) {
+    Emit(static_cast<uint32_t>(
+             std::min<int64_t>(end - base_, frame_frames_)),
+         output);
+  }
+}
+
+void StreamAligner::MarkFrame(int64_t frame, uint32_t flags) {
+  if (frame >= base_) {
+    const size_t slot = static_cast<size_t>((frame - base_) / frame_frames_);
+    packet_flags_[std::min(slot, packet_flags_.size() - 1)] |= flags;
+  }
+}
+
+void StreamAligner::Emit(uint32_t frames, const Output& output) {
+  uint32_t flags = packet_flags_[0];
+  const int64_t end = base_ + frames;
+  for (int i = 0; i < kStreamKindCount; ++i) {
+    const Input& input = inputs_[i];
+    int64_t covered = 0;
+    if (input.started) {
+      covered = std::max<int64_t>(
+          0, std::min(input.end, end) - std::max(input.begin, base_));
+      // Falling behind after it started is a discontinuity; starting late
+      // is not.
+      if (input.end < end && input.end > input.begin) {
+        flags |= kPacketDiscontinuity;
+      }
+    }
+    stats_.filled_frames[i] += static_cast<uint64_t>(frames - covered);
+  }
+
+  const size_t bytes =
+      static_cast<size_t>(frames) * output_format_.BlockAlign();
+  AudioPacket packet;
+  packet.stream = StreamKind::kAligned;
+  packet.codec = CodecId::kPcm;
+  packet.format = output_format_;
+  packet.data = buffer_.data();
+  packet.size = bytes;
+  packet.frames = frames;
+  packet.flags = flags;
+  packet.sequence = sequence_++;
+  packet.position = static_cast<uint64_t>(base_);
+  packet.capture_time_ns =
+      origin_ns_ + NanosForFrames(output_format_, packet.position);
+  output(packet);
+  ++stats_.packets;
+
+  std::memmove(buffer_.data(), buffer_.data() + bytes, buffer_.size() - bytes);
+  std::memset(buffer_.data() + buffer_.size() - bytes, 0, bytes);
+  base_ += frames;
+  packet_flags_.erase(packet_flags_.begin());
+  packet_flags_.push_back(0);
+}
+
+}  // namespace samurai
@@ -0,0 +1,204 @@
+#include "samurai_audio_core/synthetic_capture_backend.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace samurai {
+
+namespace {
+
+constexpr double kTwoPi = 6.28318530717958647692;
+constexpr float kAmplitude = 0.25f;
+
+void WriteSample(float value, SampleType type, uint8_t* dst) {
+  switch (type) {
+    case SampleType::kInt16: {
+      int16_t s = static_cast<int16_t>(value * 32767.0f);
+      std::memcpy(dst, &s, sizeof(s));
+      break;
+    }
+    case SampleType::kInt24: {
+      int32_t s = static_cast<int32_t>(value * 8388607.0f);
+      dst[0] = static_cast<uint8_t>(s);
+      dst[1] = static_cast<uint8_t>(s >> 8);
+      dst[2] = static_cast<uint8_t>(s >> 16);
+      break;
+    }
+    case SampleType::kInt32: {
+      int32_t s = static_cast<int32_t>(value * 2147483647.0);
+      std::memcpy(dst, &s, sizeof(s));
+      break;
+    }
+    case SampleType::kFloat32:
+      std::memcpy(dst, &value, sizeof(value));
+      break;
+  }
+}
+
+class SyntheticCaptureStream : public CaptureStream {
+ public:
+  SyntheticCaptureStream(const SyntheticCaptureBackend::Options& options,
+                         const StreamConfig& config, double frequency,
+                         double clock_ppm)
+      : options_(options),
+        clock_(options.clock ? options.clock : SteadyCaptureClock::Get()),
+        event_driven_(options.realtime &&
+                      config.scheduling == SchedulingMode::kEventDriven),
+        device_period_ms_(config.device_period_ms
+                              ? config.device_period_ms
+                              : static_cast<uint32_t>(DurationForFrames(
+                                    options.format, options.packet_frames) /
+                                    1000)),
+        buffer_duration_ms_(config.buffer_duration_ms),
+        frequency_(frequency),
+        clock_ppm_(clock_ppm),
+        buffer_(static_cast<size_t>(options.packet_frames) *
+                options.format.BlockAlign()) {}
+
+  const AudioFormat& format() const override { return options_.format; }
+
+  bool Start() override {
+    start_ns_ = clock_->NowNanos();
+    frames_produced_ = 0;
+    return true;
+  }
+
+  void Stop() override {}
+
+  bool GetNextPacketSize(uint32_t* frames) override {
+    if (!options_.realtime) {
+      *frames = options_.packet_frames;
+      return true;
+    }
+    *frames = clock_->NowNanos() >= NextPacketReadyNs() ? options_.packet_frames
+                                                        : 0;
+    return true;
+  }
+
+  bool event_driven() const override { return event_driven_; }
+
+  bool WaitForData(int64_t timeout_ns) override {
+    int64_t now = clock_->NowNanos();
+    int64_t ready = NextPacketReadyNs();
+    if (ready - now > timeout_ns) {
+      clock_->SleepFor(timeout_ns);
+      return false;
+    }
+    clock_->SleepUntil(ready);
+    return true;
+  }
+
+  uint32_t device_period_ms() const override { return device_period_ms_; }
+  uint32_t buffer_duration_ms() const override { return buffer_duration_ms_; }
+
+  bool GetPacket(CapturedPacket* packet) override {
+    const AudioFormat& format = options_.format;
+    const uint32_t bytes_per_sample = format.BytesPerSample();
+    ++packet_index_;
+    bool silent = options_.silent_every > 0 &&
+                  packet_index_ % options_.silent_every == 0;
+
+    uint8_t* dst = buffer_.data();
+    for (uint32_t frame = 0; frame < options_.packet_frames; ++frame) {
+      float value = 0.0f;
+      if (!silent) {
+        value = kAmplitude * static_cast<float>(std::sin(phase_));
+      }
+      phase_ += kTwoPi * frequency_ / format.sample_rate;
+      if (phase_ >= kTwoPi) {
+        phase_ -= kTwoPi;
+      }
+      for (uint16_t channel = 0; channel < format.channels; ++channel) {
+        WriteSample(value, format.sample_type, dst);
+        dst += bytes_per_sample;
+      }
+    }
+
+    packet->data = buffer_.data();
+    packet->frames = options_.packet_frames;
+    packet->flags = silent ? kPacketSilent : 0;
+    packet->capture_time_ns =
+        options_.realtime ? FrameTimeNs(frames_produced_) : 0;
+    packet->device_position = frames_produced_;
+    return true;
+  }
+
+  // Like an endpoint buffer, the packet is gone once released: it is
+  // scribbled over so a late read shows up as garbage samples.
+  void ReleasePacket(uint32_t frames) override {
+    std::memset(buffer_.data(), 0xff, buffer_.size());
+    frames_produced_ += frames;
+  }
+
+ private:
+  // Clock time at which |frame| was captured.
+  int64_t FrameTimeNs(uint64_t frame) const {
+    if (clock_ppm_ == 0.0) {
+      return start_ns_ + static_cast<int64_t>(frame * 1000000000ull /
+                                              options_.format.sample_rate);
+    }
+    return start_ns_ +
+           static_cast<int64_t>(static_cast<double>(frame) * 1e9 /
+                                (options_.format.sample_rate *
+                                 (1.0 + clock_ppm_ * 1e-6)));
+  }
+
+  // A packet is ready once its last frame has been captured.
+  int64_t NextPacketReadyNs() const {
+    return FrameTimeNs(frames_produced_ + options_.packet_frames);
+  }
+
+  SyntheticCaptureBackend::Options options_;
+  CaptureClock* clock_;
+  bool event_driven_;
+  uint32_t device_period_ms_;
+  uint32_t buffer_duration_ms_;
+  double frequency_;
+  double clock_ppm_;
+  std::vector<uint8_t> buffer_;
+  int64_t start_ns_ = 0;
+  uint64_t frames_produced_ = 0;
+  uint64_t packet_index_ = 0;
+  double phase_ = 0.0;
+};
+
+}  // namespace
+
+SyntheticCaptureBackend::Options::Options() {
+  format.sample_rate = 48000;
+  format.channels = 2;
+  format.sample_type = SampleType::kFloat32;
+}
+
+SyntheticCaptureBackend::SyntheticCaptureBackend()
+    : SyntheticCaptureBackend(Options()) {}
+
+SyntheticCaptureBackend::SyntheticCaptureBackend(const Options& options)
+    : options_(options) {}
+
+SyntheticCaptureBackend::~SyntheticCaptureBackend() = default;
+
+bool SyntheticCaptureBackend::Initialize() { return true; }
+
+std::vector<AudioDevice> SyntheticCaptureBackend::GetInputDevices() {
+  return {{"synthetic-input", "Synthetic Microphone", true}};
+}
+
+std::vector<AudioDevice> SyntheticCaptureBackend::GetOutputDevices() {
+  return {{"synthetic-output", "Synthetic Speakers", false}};
+}
+
+std::unique_ptr<CaptureStream> SyntheticCaptureBackend::OpenStream(
+    StreamKind kind, const std::string& device_id,
+    const StreamConfig& config) {
+  if (!options_.format.IsValid() || options_.packet_frames == 0) {
+    return nullptr;
+  }
+  const bool system = kind == StreamKind::kSystem;
+  return std::make_unique<SyntheticCaptureStream>(
+      options_, config,
+      system ? options_.system_frequency : options_.microphone_frequency,
+      system ? options_.system_clock_ppm : options_.microphone_clock_ppm);
+}
+
+}  // namespace samurai
@@ -0,0 +1,462 @@
+#include "samurai_audio_core/transcode_jobs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#include "samurai_audio_core/audio_file_writer.h"
+#include "samurai_audio_core/format_converter.h"
+#include "samurai_audio_core/wav_reader.h"
+
+namespace samurai {
+
+namespace {
+
+// Input frames converted per step: ~85 ms at 48 kHz, small enough for
+// prompt cancellation, large enough to amortize the per-call overhead.
+constexpr size_t kBlockFrames = 4096;
+
+// Mapped input behind the read position is dropped in steps of this many
+// blocks, so a long file never stays resident.
+constexpr size_t kReleaseBlocks = 64;
+
+// The rate used when the encoder has no table for the file's own.
+constexpr uint32_t kFallbackRate = 48000;
+
+// Fixed part of a job's footprint: the encoder state (LAME's is the
+// largest, ~300 KB) and AudioFileWriter's file buffer, with slack.
+constexpr size_t kFixedJobBytes = 512 * 1024 + 64 * 1024;
+
+bool IsTerminal(JobState state) {
+  return state != JobState::kQueued && state != JobState::kRunning;
+}
+
+}  // namespace
+
+const char* JobStateName(JobState state) {
+  switch (state) {
+    case JobState::kQueued:
+      return "queued";
+    case JobState::kRunning:
+      return "running";
+    case JobState::kSucceeded:
+      return "succeeded";
+    case JobState::kFailed:
+      return "failed";
+    case JobState::kCancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+bool TranscodeWavFile(const TranscodeRequest& request,
+                      const TranscodeProgress& progress, std::string* error) {
+  const CodecId codec = request.encoder.codec;
+  if (!AudioCodecAvailable(codec)) {
+    *error = codec == CodecId::kMp3 ? "MP3 encoder not built in"
+                                    : "Opus encoder not built in";
+    return false;
+  }
+  WavReader reader;
+  if (!reader.Open(request.input_path)) {
+    *error = "Cannot read WAV file";
+    return false;
+  }
+
+  const AudioFormat& input = reader.format();
+  const ChannelMap channels =
+      input.channels > 2 ? ChannelMap::Downmix() : ChannelMap();
+  AudioFormat target;
+  target.sample_rate = input.sample_rate;
+  target.sample_type = SampleType::kInt16;
+  target.channels = input.channels > 2 ? 1 : input.channels;
+  std::unique_ptr<AudioEncoder> encoder =
+      CreateAudioEncoder(request.encoder, target);
+  if (!encoder) {
+    target.sample_rate = kFallbackRate;
+    encoder = CreateAudioEncoder(request.encoder, target);
+  }
+  if (!encoder) {
+    *error = "Unsupported WAV format";
+    return false;
+  }
+  FormatConverter converter(input, target, channels, /*dither=*/true,
+                            ResamplerQuality::kHigh);
+  if (converter.output_format() != target) {
+    *error = "Unsupported WAV format";
+    return false;
+  }
+
+  const std::string partial = request.output_path + ".part";
+  AudioFileWriter writer;
+  if (!writer.Open(partial, std::move(encoder))) {
+    *error = "Cannot create output file";
+    return false;
+  }
+
+  std::vector<uint8_t> converted(converter.MaxOutputFrames(kBlockFrames) *
+                                 target.BlockAlign());
+  const uint64_t total = reader.frames();
+  const uint32_t block_align = input.BlockAlign();
+  bool ok = true;
+  bool cancelled = false;
+  int reported = -1;
+  size_t blocks = 0;
+  for (uint64_t done = 0; ok && done < total;) {
+    const size_t frames =
+        static_cast<size_t>(std::min<uint64_t>(kBlockFrames, total - done));
+    const size_t out = converter.Convert(
+        reader.samples() + done * block_align, frames, converted.data());
+    ok = writer.Write(converted.data(), static_cast<uint32_t>(out));
+    done += frames;
+
+    if (++blocks % kReleaseBlocks == 0) {
+      reader.ReleaseBefore(done);
+    }
+    const int percent = static_cast<int>(done * 100 / total);
+    if (ok && percent != reported) {
+      reported = percent;
+      if (progress && !progress(static_cast<double>(done) / total)) {
+        cancelled = true;
+        ok = false;
+      }
+    }
+  }
+  if (ok) {
+    // Silence pushes the resampler's lookahead out.
+    if (const uint32_t tail = converter.delay_frames()) {
+      const size_t out = converter.Convert(nullptr, tail, converted.data());
+      writer.Write(converted.data(), static_cast<uint32_t>(out));
+    }
+  }
+  const bool write_failed = writer.failed();
+  if (!writer.Close()) {
+    ok = false;
+  }
+  if (cancelled) {
+    *error = "Cancelled";
+  } else if (!ok) {
+    *error = write_failed ? "Cannot write output file" : "Encoder failed";
+  }
+
+  const std::filesystem::path output =
+      std::filesystem::u8path(request.output_path);
+  const std::filesystem::path part = std::filesystem::u8path(partial);
+  std::error_code ec;
+  if (ok) {
+    std::filesystem::rename(part, output, ec);
+    if (ec) {
+      *error = "Cannot replace output file";
+      ok = false;
+    }
+  }
+  if (!ok) {
+    std::filesystem::remove(part, ec);
+  }
+  return ok;
+}
+
+size_t TranscodeMemoryEstimate(const TranscodeRequest& request) {
+  size_t bytes = kFixedJobBytes;
+  WavReader reader;
+  if (!reader.Open(request.input_path)) {
+    return bytes;
+  }
+  const AudioFormat& input = reader.format();
+  // Mapped input stays resident until the next release.
+  bytes += kReleaseBlocks * kBlockFrames * input.BlockAlign();
+  // Float scratch, resampler history and the int16 block, at the largest
+  // ratio the fallback rate can need.
+  const size_t frames = static_cast<size_t>(
+      kBlockFrames * std::max(1.0, static_cast<double>(kFallbackRate) /
+                                       input.sample_rate)) + 1;
+  bytes += frames * input.channels * (2 * sizeof(float) + sizeof(int16_t));
+  return bytes;
+}
+
+struct TranscodeJobQueue::Job {
+  uint64_t id = 0;
+  uint64_t batch = 0;
+  TranscodeRequest request;
+  size_t cost = 0;       // TranscodeMemoryEstimate().
+  double weight = 1.0;   // Share of its batch: the input size.
+  std::atomic<bool> cancelled{false};
+
+  // Guarded by mutex_.
+  bool admitted = false;  // Handed to the pool; |cost| is counted.
+  bool started = false;   // Claimed by a worker.
+  bool finished = false;  // Out of jobs_.
+
+  double progress = 0.0;  // Last reported. Guarded by emit_mutex_.
+};
+
+TranscodeJobQueue::TranscodeJobQueue(size_t workers, JobEventCallback callback,
+                                     Runner runner)
+    : callback_(std::move(callback)),
+      runner_(std::move(runner)),
+      pool_(std::make_unique<WorkStealingPool>(workers)) {}
+
+TranscodeJobQueue::~TranscodeJobQueue() {
+  std::vector<std::shared_ptr<Job>> abandoned;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    waiting_.clear();
+    for (auto& entry : jobs_) {
+      entry.second->cancelled.store(true);
+      if (!entry.second->started) {
+        abandoned.push_back(entry.second);
+      }
+    }
+    for (const auto& job : abandoned) {
+      RetireLocked(job.get());
+    }
+  }
+  // Running jobs stop at their next progress report; abandoned ones are
+  // skipped.
+  pool_.reset();
+  for (const auto& job : abandoned) {
+    JobEvent event;
+    event.id = job->id;
+    event.state = JobState::kCancelled;
+    Emit(job.get(), event);
+  }
+}
+
+std::shared_ptr<TranscodeJobQueue::Job> TranscodeJobQueue::NewJob(
+    const TranscodeRequest& request, uint64_t batch) {
+  auto job = std::make_shared<Job>();
+  job->batch = batch;
+  job->request = request;
+  job->cost = TranscodeMemoryEstimate(request);
+  std::error_code ec;
+  const uintmax_t size = std::filesystem::file_size(
+      std::filesystem::u8path(request.input_path), ec);
+  if (!ec && size > 0) {
+    job->weight = static_cast<double>(size);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  job->id = next_id_++;
+  jobs_[job->id] = job;
+  return job;
+}
+
+uint64_t TranscodeJobQueue::Submit(const TranscodeRequest& request) {
+  std::shared_ptr<Job> job = NewJob(request, 0);
+  JobEvent event;
+  event.id = job->id;
+  event.state = JobState::kQueued;
+  Emit(job.get(), event);
+  {
+    // Queued only after kQueued went out, so it always comes first.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!job->finished) {
+      waiting_.push_back(job);
+      AdmitLocked();
+    }
+  }
+  return job->id;
+}
+
+uint64_t TranscodeJobQueue::SubmitBatch(
+    const std::vector<TranscodeRequest>& requests, std::vector<uint64_t>* ids) {
+  if (requests.empty()) {
+    return 0;
+  }
+  uint64_t batch_id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_id = next_batch_++;
+  }
+  std::vector<std::shared_ptr<Job>> jobs;
+  Batch batch;
+  for (const TranscodeRequest& request : requests) {
+    jobs.push_back(NewJob(request, batch_id));
+    batch.total_weight += jobs.back()->weight;
+    ++batch.pending;
+  }
+  {
+    std::lock_guard<std::mutex> lock(emit_mutex_);
+    batches_[batch_id] = batch;
+  }
+  for (const auto& job : jobs) {
+    if (ids) {
+      ids->push_back(job->id);
+    }
+    JobEvent event;
+    event.id = job->id;
+    event.state = JobState::kQueued;
+    Emit(job.get(), event);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& job : jobs) {
+      if (!job->finished) {
+        waiting_.push_back(job);
+      }
+    }
+    AdmitLocked();
+  }
+  return batch_id;
+}
+
+bool TranscodeJobQueue::Cancel(uint64_t id) {
+  std::shared_ptr<Job> job;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = jobs_.find(id);
+    if (found == jobs_.end() || found->second->cancelled.load()) {
+      return false;
+    }
+    job = found->second;
+    job->cancelled.store(true);
+    if (job->started) {
+      return true;
+    }
+    // Never reached a worker: finish it here. A pool task already queued
+    // for it finds it finished and does nothing.
+    waiting_.erase(std::remove(waiting_.begin(), waiting_.end(), job),
+                   waiting_.end());
+    RetireLocked(job.get());
+    AdmitLocked();
+  }
+  JobEvent event;
+  event.id = id;
+  event.state = JobState::kCancelled;
+  Emit(job.get(), event);
+  return true;
+}
+
+bool TranscodeJobQueue::CancelBatch(uint64_t batch) {
+  std::vector<uint64_t> ids;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : jobs_) {
+      if (entry.second->batch == batch) {
+        ids.push_back(entry.first);
+      }
+    }
+  }
+  bool cancelled = false;
+  for (uint64_t id : ids) {
+    cancelled |= Cancel(id);
+  }
+  return cancelled;
+}
+
+void TranscodeJobQueue::SetMemoryBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  memory_budget_ = bytes;
+  AdmitLocked();
+}
+
+size_t TranscodeJobQueue::outstanding() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return jobs_.size();
+}
+
+void TranscodeJobQueue::AdmitLocked() {
+  while (!stopping_ && !waiting_.empty()) {
+    const size_t cost = waiting_.front()->cost;
+    if (memory_budget_ != 0 && memory_in_use_ != 0 &&
+        memory_in_use_ + cost > memory_budget_) {
+      return;
+    }
+    std::shared_ptr<Job> job = std::move(waiting_.front());
+    waiting_.pop_front();
+    job->admitted = true;
+    memory_in_use_ += cost;
+    pool_->Submit([this, job]() { Execute(job); });
+  }
+}
+
+void TranscodeJobQueue::RetireLocked(Job* job) {
+  jobs_.erase(job->id);
+  job->finished = true;
+  if (job->admitted) {
+    memory_in_use_ -= job->cost;
+  }
+}
+
+void TranscodeJobQueue::Execute(const std::shared_ptr<Job>& job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (job->finished) {
+      return;
+    }
+    job->started = true;
+  }
+  const JobEvent done = Run(job.get());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RetireLocked(job.get());
+    AdmitLocked();
+  }
+  Emit(job.get(), done);
+}
+
+JobEvent TranscodeJobQueue::Run(Job* job) {
+  JobEvent event;
+  event.id = job->id;
+  if (job->cancelled.load()) {
+    // Cancelled between being claimed and getting here.
+    event.state = JobState::kCancelled;
+    return event;
+  }
+  event.state = JobState::kRunning;
+  Emit(job, event);
+
+  const TranscodeProgress progress = [&](double fraction) {
+    if (job->cancelled.load()) {
+      return false;
+    }
+    // Runners may also call this just to poll for cancellation.
+    if (fraction != event.progress) {
+      event.progress = fraction;
+      Emit(job, event);
+    }
+    return true;
+  };
+  std::string error;
+  const bool ok = runner_(job->request, progress, &error);
+
+  if (ok) {
+    event.state = JobState::kSucceeded;
+    event.progress = 1.0;
+  } else if (job->cancelled.load()) {
+    event.state = JobState::kCancelled;
+  } else {
+    event.state = JobState::kFailed;
+    event.error = error.empty() ? "Transcode failed" : error;
+  }
+  return event;
+}
+
+void TranscodeJobQueue::Emit(Job* job, JobEvent event) {
+  // Serialized, so batch_pending reaches 0 on the last event delivered.
+  std::lock_guard<std::mutex> lock(emit_mutex_);
+  if (job->batch != 0) {
+    auto found = batches_.find(job->batch);
+    if (found != batches_.end()) {
+      Batch& batch = found->second;
+      const double progress = IsTerminal(event.state) ? 1.0 : event.progress;
+      batch.done_weight += job->weight * (progress - job->progress);
+      job->progress = progress;
+      if (IsTerminal(event.state)) {
+        --batch.pending;
+      }
+      event.batch = job->batch;
+      event.batch_progress =
+          std::min(1.0, batch.done_weight / batch.total_weight);
+      event.batch_pending = batch.pending;
+      if (batch.pending == 0) {
+        batches_.erase(found);
+      }
+    }
+  }
+  callback_(event);
+}
+
+}  // namespace samurai
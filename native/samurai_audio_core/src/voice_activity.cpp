@@ -0,0 +1,266 @@
+#include "samurai_audio_core/voice_activity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "samurai_audio_core/capture_backend.h"
+#include "samurai_audio_core/cpu_features.h"
+#include "voice_activity_internal.h"
+
+namespace samurai {
+
+namespace {
+
+constexpr float kMinDb = -120.0f;
+constexpr double kInt16FullScaleSquared = 32768.0 * 32768.0;
+
+const internal::VadKernels* KernelsFor(VadImpl impl) {
+  switch (impl) {
+    case VadImpl::kSse2:
+      return internal::VadKernelsSse2();
+    case VadImpl::kAvx2:
+      return internal::VadKernelsAvx2();
+    case VadImpl::kNeon:
+      return internal::VadKernelsNeon();
+    case VadImpl::kScalar:
+      break;
+  }
+  return nullptr;
+}
+
+bool SignBit(float v) { return std::signbit(v); }
+bool SignBit(int16_t v) { return v < 0; }
+
+// Scalar completion of the kernel sums from sample |begin|.
+template <typename T>
+void AnalyzeScalar(const T* in, size_t begin, size_t samples, size_t stride,
+                   double* energy, uint64_t* crossings) {
+  for (size_t i = begin; i < samples; ++i) {
+    const double v = static_cast<double>(in[i]);
+    *energy += v * v;
+  }
+  for (size_t i = begin; i + stride < samples; ++i) {
+    *crossings += SignBit(in[i]) != SignBit(in[i + stride]) ? 1 : 0;
+  }
+}
+
+}  // namespace
+
+const char* VoiceActivityName(VoiceActivity activity) {
+  switch (activity) {
+    case VoiceActivity::kSpeech:
+      return "speech";
+    case VoiceActivity::kSilence:
+      return "silence";
+    case VoiceActivity::kDeviceSilent:
+      return "device-silent";
+  }
+  return "unknown";
+}
+
+const char* SilencePolicyName(SilencePolicy policy) {
+  switch (policy) {
+    case SilencePolicy::kForward:
+      return "forward";
+    case SilencePolicy::kDrop:
+      return "drop";
+    case SilencePolicy::kMarkers:
+      return "markers";
+  }
+  return "unknown";
+}
+
+bool ParseSilencePolicy(const std::string& name, SilencePolicy* policy) {
+  for (SilencePolicy candidate :
+       {SilencePolicy::kForward, SilencePolicy::kDrop,
+        SilencePolicy::kMarkers}) {
+    if (name == SilencePolicyName(candidate)) {
+      *policy = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* VadImplName(VadImpl impl) {
+  switch (impl) {
+    case VadImpl::kScalar:
+      return "scalar";
+    case VadImpl::kSse2:
+      return "sse2";
+    case VadImpl::kAvx2:
+      return "avx2";
+    case VadImpl::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool VadImplSupported(VadImpl impl) {
+  const CpuFeatures& cpu = GetCpuFeatures();
+  switch (impl) {
+    case VadImpl::kScalar:
+      return true;
+#if defined(SAMURAI_ARCH_X86)
+    case VadImpl::kSse2:
+      return cpu.sse2;
+    case VadImpl::kAvx2:
+      return cpu.avx2;
+#endif
+#if defined(SAMURAI_ARCH_ARM64)
+    case VadImpl::kNeon:
+      return cpu.neon;
+#endif
+    default:
+      break;
+  }
+  return false;
+}
+
+VadImpl VadBestImpl() {
+  static const VadImpl best = []() {
+    for (VadImpl impl : {VadImpl::kAvx2, VadImpl::kNeon, VadImpl::kSse2}) {
+      if (VadImplSupported(impl)) {
+        return impl;
+      }
+    }
+    return VadImpl::kScalar;
+  }();
+  return best;
+}
+
+VoiceActivityDetector::VoiceActivityDetector(const AudioFormat& format,
+                                             const VadConfig& config)
+    : VoiceActivityDetector(format, config, VadBestImpl()) {}
+
+VoiceActivityDetector::VoiceActivityDetector(const AudioFormat& format,
+                                             const VadConfig& config,
+                                             VadImpl impl)
+    : format_(format), config_(config), impl_(impl) {
+  valid_ = format.IsValid() &&
+           (format.sample_type == SampleType::kInt16 ||
+            format.sample_type == SampleType::kFloat32) &&
+           VadImplSupported(impl);
+  window_frames_ =
+      std::max<uint32_t>(1, FramesForDuration(format, config.window_ms));
+  hangover_frames_ = FramesForDuration(format, config.hangover_ms);
+  floor_rise_per_window_ = config.floor_rise_db_per_second *
+                           static_cast<float>(window_frames_) /
+                           static_cast<float>(std::max(1u, format.sample_rate));
+  Reset();
+}
+
+void VoiceActivityDetector::Reset() {
+  energy_ = 0.0;
+  crossings_ = 0;
+  crossing_pairs_ = 0;
+  frames_in_window_ = 0;
+  hangover_left_ = 0;
+  // Start where the absolute threshold and the margin agree; the floor
+  // then settles onto the real background within a few seconds.
+  noise_floor_db_ = config_.threshold_db - config_.margin_db;
+  last_energy_db_ = kMinDb;
+  last_zcr_ = 0.0f;
+}
+
+VoiceActivity VoiceActivityDetector::Process(const uint8_t* data,
+                                             uint32_t frames,
+                                             uint32_t flags) {
+  if (!valid_) {
+    return VoiceActivity::kSpeech;
+  }
+  if (flags & kPacketSilent) {
+    // Digital silence: nothing to measure, but it still ends speech.
+    hangover_left_ -= std::min(hangover_left_, frames);
+    energy_ = 0.0;
+    crossings_ = 0;
+    crossing_pairs_ = 0;
+    frames_in_window_ = 0;
+    return VoiceActivity::kDeviceSilent;
+  }
+  const bool speech = AnalyzeWindows(data, frames);
+  return speech || hangover_left_ > 0 ? VoiceActivity::kSpeech
+                                      : VoiceActivity::kSilence;
+}
+
+bool VoiceActivityDetector::AnalyzeWindows(const uint8_t* data,
+                                           uint32_t frames) {
+  const size_t channels = format_.channels;
+  const internal::VadKernels* kernels = KernelsFor(impl_);
+  bool speech = false;
+  while (frames > 0) {
+    const uint32_t chunk = std::min(frames, window_frames_ - frames_in_window_);
+    const size_t samples = static_cast<size_t>(chunk) * channels;
+    size_t done = 0;
+    if (format_.sample_type == SampleType::kFloat32) {
+      const float* in = reinterpret_cast<const float*>(data);
+      if (kernels) {
+        done = kernels->analyze_float(in, samples, channels, &energy_,
+                                      &crossings_);
+      }
+      AnalyzeScalar(in, done, samples, channels, &energy_, &crossings_);
+    } else {
+      const int16_t* in = reinterpret_cast<const int16_t*>(data);
+      if (kernels) {
+        done = kernels->analyze_int16(in, samples, channels, &energy_,
+                                      &crossings_);
+      }
+      AnalyzeScalar(in, done, samples, channels, &energy_, &crossings_);
+    }
+    if (samples > channels) {
+      crossing_pairs_ += samples - channels;
+    }
+
+    frames_in_window_ += chunk;
+    frames -= chunk;
+    data += samples * format_.BytesPerSample();
+    if (frames_in_window_ == window_frames_) {
+      speech = CloseWindow() || speech;
+    }
+  }
+  return speech;
+}
+
+bool VoiceActivityDetector::CloseWindow() {
+  double mean_square =
+      energy_ / (static_cast<double>(frames_in_window_) * format_.channels);
+  if (format_.sample_type == SampleType::kInt16) {
+    mean_square /= kInt16FullScaleSquared;
+  }
+  const float energy_db = std::max(
+      kMinDb, static_cast<float>(10.0 * std::log10(mean_square + 1e-13)));
+  const float zcr = crossing_pairs_
+                        ? static_cast<float>(crossings_) /
+                              static_cast<float>(crossing_pairs_)
+                        : 0.0f;
+  last_energy_db_ = energy_db;
+  last_zcr_ = zcr;
+
+  const bool speech = energy_db >= config_.threshold_db &&
+                      energy_db >= noise_floor_db_ + config_.margin_db &&
+                      zcr <= config_.max_zero_crossing_rate;
+
+  // Minimum tracking with a slow leak upwards, so a steady hum or fan
+  // becomes the floor even if it first looked like speech.
+  if (energy_db < noise_floor_db_) {
+    noise_floor_db_ = energy_db;
+  } else {
+    noise_floor_db_ =
+        std::min(energy_db, noise_floor_db_ + floor_rise_per_window_);
+  }
+
+  if (speech) {
+    hangover_left_ = hangover_frames_;
+  } else {
+    hangover_left_ -= std::min(hangover_left_, window_frames_);
+  }
+
+  energy_ = 0.0;
+  crossings_ = 0;
+  crossing_pairs_ = 0;
+  frames_in_window_ = 0;
+  return speech;
+}
+
+}  // namespace samurai
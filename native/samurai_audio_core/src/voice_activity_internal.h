@@ -0,0 +1,30 @@
+#ifndef SAMURAI_AUDIO_CORE_SRC_VOICE_ACTIVITY_INTERNAL_H_
+#define SAMURAI_AUDIO_CORE_SRC_VOICE_ACTIVITY_INTERNAL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace samurai {
+namespace internal {
+
+// Kernels add the sum of squares of in[i] and the number of sign changes
+// between in[i] and in[i + stride] to |energy| and |crossings| for whole
+// blocks of eight i with i + 8 + stride <= samples, and return the first i
+// not covered; the caller finishes both sums with the scalar code. Int16
+// energy is in raw sample units.
+struct VadKernels {
+  size_t (*analyze_float)(const float* in, size_t samples, size_t stride,
+                          double* energy, uint64_t* crossings);
+  size_t (*analyze_int16)(const int16_t* in, size_t samples, size_t stride,
+                          double* energy, uint64_t* crossings);
+};
+
+// Null on architectures without the instruction set.
+const VadKernels* VadKernelsSse2();
+const VadKernels* VadKernelsAvx2();
+const VadKernels* VadKernelsNeon();
+
+}  // namespace internal
+}  // namespace samurai
+
+#endif  // SAMURAI_AUDIO_CORE_SRC_VOICE_ACTIVITY_INTERNAL_H_
@@ -0,0 +1,71 @@
+#include "voice_activity_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_ARM64)
+
+// Same block structure as the x86 kernels.
+
+namespace {
+
+size_t AnalyzeFloatNeon(const float* in, size_t samples, size_t stride,
+                        double* energy, uint64_t* crossings) {
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  uint32x4_t count = vdupq_n_u32(0);
+  size_t i = 0;
+  for (; i + 8 + stride <= samples; i += 8) {
+    for (size_t half = 0; half < 8; half += 4) {
+      const float32x4_t a = vld1q_f32(in + i + half);
+      const float32x4_t b = vld1q_f32(in + i + half + stride);
+      acc = vaddq_f32(acc, vmulq_f32(a, a));
+      count = vaddq_u32(
+          count, vshrq_n_u32(veorq_u32(vreinterpretq_u32_f32(a),
+                                       vreinterpretq_u32_f32(b)),
+                             31));
+    }
+  }
+  *energy += vaddvq_f32(acc);
+  *crossings += vaddvq_u32(count);
+  return i;
+}
+
+size_t AnalyzeInt16Neon(const int16_t* in, size_t samples, size_t stride,
+                        double* energy, uint64_t* crossings) {
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  uint32x4_t count = vdupq_n_u32(0);
+  size_t i = 0;
+  for (; i + 8 + stride <= samples; i += 8) {
+    const int16x8_t a = vld1q_s16(in + i);
+    const int16x8_t b = vld1q_s16(in + i + stride);
+    const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(a)));
+    const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(a)));
+    acc = vaddq_f32(acc, vaddq_f32(vmulq_f32(lo, lo), vmulq_f32(hi, hi)));
+    const uint16x8_t bits = vshrq_n_u16(
+        veorq_u16(vreinterpretq_u16_s16(a), vreinterpretq_u16_s16(b)), 15);
+    count = vaddq_u32(count, vpaddlq_u16(bits));
+  }
+  *energy += vaddvq_f32(acc);
+  *crossings += vaddvq_u32(count);
+  return i;
+}
+
+const VadKernels kNeonKernels = {AnalyzeFloatNeon, AnalyzeInt16Neon};
+
+}  // namespace
+
+const VadKernels* VadKernelsNeon() { return &kNeonKernels; }
+
+#else  // !SAMURAI_ARCH_ARM64
+
+const VadKernels* VadKernelsNeon() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_ARM64
+
+}  // namespace internal
+}  // namespace samurai
@@ -0,0 +1,153 @@
+#include "voice_activity_internal.h"
+#include "samurai_audio_core/cpu_features.h"
+
+#if defined(SAMURAI_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+namespace samurai {
+namespace internal {
+
+#if defined(SAMURAI_ARCH_X86)
+
+// Energy accumulates in float lanes and is widened once per call; a sign
+// change is the top bit of in[i] ^ in[i + stride], summed in int32 lanes.
+
+namespace {
+
+SAMURAI_TARGET("sse2")
+inline float SumSse2(__m128 v) {
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+  return _mm_cvtss_f32(v);
+}
+
+SAMURAI_TARGET("sse2")
+inline uint32_t SumSse2(__m128i v) {
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+SAMURAI_TARGET("sse2")
+size_t AnalyzeFloatSse2(const float* in, size_t samples, size_t stride,
+                        double* energy, uint64_t* crossings) {
+  __m128 acc = _mm_setzero_ps();
+  __m128i count = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 8 + stride <= samples; i += 8) {
+    for (size_t half = 0; half < 8; half += 4) {
+      const __m128 a = _mm_loadu_ps(in + i + half);
+      const __m128 b = _mm_loadu_ps(in + i + half + stride);
+      acc = _mm_add_ps(acc, _mm_mul_ps(a, a));
+      count = _mm_add_epi32(
+          count, _mm_srli_epi32(_mm_castps_si128(_mm_xor_ps(a, b)), 31));
+    }
+  }
+  *energy += SumSse2(acc);
+  *crossings += SumSse2(count);
+  return i;
+}
+
+SAMURAI_TARGET("sse2")
+size_t AnalyzeInt16Sse2(const int16_t* in, size_t samples, size_t stride,
+                        double* energy, uint64_t* crossings) {
+  __m128 acc = _mm_setzero_ps();
+  __m128i count = _mm_setzero_si128();
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 8 + stride <= samples; i += 8) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + stride));
+    // Sign-extends by duplicating each sample into the top half.
+    const __m128 lo =
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16));
+    const __m128 hi =
+        _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16));
+    acc = _mm_add_ps(acc, _mm_add_ps(_mm_mul_ps(lo, lo), _mm_mul_ps(hi, hi)));
+    const __m128i bits = _mm_srli_epi16(_mm_xor_si128(a, b), 15);
+    count = _mm_add_epi32(count, _mm_add_epi32(_mm_unpacklo_epi16(bits, zero),
+                                               _mm_unpackhi_epi16(bits, zero)));
+  }
+  *energy += SumSse2(acc);
+  *crossings += SumSse2(count);
+  return i;
+}
+
+SAMURAI_TARGET("avx2")
+inline float SumAvx2(__m256 v) {
+  __m128 sum =
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+SAMURAI_TARGET("avx2")
+inline uint32_t SumAvx2(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+}
+
+SAMURAI_TARGET("avx2")
+size_t AnalyzeFloatAvx2(const float* in, size_t samples, size_t stride,
+                        double* energy, uint64_t* crossings) {
+  __m256 acc = _mm256_setzero_ps();
+  __m256i count = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 + stride <= samples; i += 8) {
+    const __m256 a = _mm256_loadu_ps(in + i);
+    const __m256 b = _mm256_loadu_ps(in + i + stride);
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(a, a));
+    count = _mm256_add_epi32(
+        count,
+        _mm256_srli_epi32(_mm256_castps_si256(_mm256_xor_ps(a, b)), 31));
+  }
+  *energy += SumAvx2(acc);
+  *crossings += SumAvx2(count);
+  return i;
+}
+
+SAMURAI_TARGET("avx2")
+size_t AnalyzeInt16Avx2(const int16_t* in, size_t samples, size_t stride,
+                        double* energy, uint64_t* crossings) {
+  __m256 acc = _mm256_setzero_ps();
+  __m256i count = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 + stride <= samples; i += 8) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + stride));
+    const __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(v, v));
+    count = _mm256_add_epi32(
+        count, _mm256_cvtepu16_epi32(_mm_srli_epi16(_mm_xor_si128(a, b), 15)));
+  }
+  *energy += SumAvx2(acc);
+  *crossings += SumAvx2(count);
+  return i;
+}
+
+const VadKernels kSse2Kernels = {AnalyzeFloatSse2, AnalyzeInt16Sse2};
+const VadKernels kAvx2Kernels = {AnalyzeFloatAvx2, AnalyzeInt16Avx2};
+
+}  // namespace
+
+const VadKernels* VadKernelsSse2() { return &kSse2Kernels; }
+const VadKernels* VadKernelsAvx2() { return &kAvx2Kernels; }
+
+#else  // !SAMURAI_ARCH_X86
+
+const VadKernels* VadKernelsSse2() { return nullptr; }
+const VadKernels* VadKernelsAvx2() { return nullptr; }
+
+#endif  // SAMURAI_ARCH_X86
+
+}  // namespace internal
+}  // namespace samurai
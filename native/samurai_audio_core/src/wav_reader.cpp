@@ -0,0 +1,121 @@
+#include "samurai_audio_core/wav_reader.h"
+
+#include <cstring>
+
+namespace samurai {
+
+namespace {
+
+constexpr uint16_t kWaveFormatPcm = 0x0001;
+constexpr uint16_t kWaveFormatIeeeFloat = 0x0003;
+constexpr uint16_t kWaveFormatExtensible = 0xFFFE;
+
+uint16_t ReadU16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t ReadU32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Maps a WAVEFORMAT tag and container size onto the pipeline's sample
+// types. 24-bit samples must be packed (block align 3 per channel).
+bool SampleTypeFor(uint16_t tag, uint16_t bits, SampleType* type) {
+  if (tag == kWaveFormatPcm) {
+    switch (bits) {
+      case 16:
+        *type = SampleType::kInt16;
+        return true;
+      case 24:
+        *type = SampleType::kInt24;
+        return true;
+      case 32:
+        *type = SampleType::kInt32;
+        return true;
+    }
+  } else if (tag == kWaveFormatIeeeFloat && bits == 32) {
+    *type = SampleType::kFloat32;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool WavReader::Open(const std::string& path) {
+  samples_ = nullptr;
+  frames_ = 0;
+  if (!file_.Open(path) || file_.size() < 12) {
+    return false;
+  }
+  const uint8_t* data = file_.data();
+  const size_t size = file_.size();
+  if (std::memcmp(data, "RIFF", 4) != 0 ||
+      std::memcmp(data + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+
+  bool have_format = false;
+  size_t offset = 12;
+  while (offset + 8 <= size) {
+    const uint8_t* chunk = data + offset;
+    const uint32_t chunk_size = ReadU32(chunk + 4);
+    const uint8_t* body = chunk + 8;
+    const size_t available = size - offset - 8;
+
+    if (std::memcmp(chunk, "fmt ", 4) == 0) {
+      if (chunk_size < 16 || chunk_size > available) {
+        return false;
+      }
+      uint16_t tag = ReadU16(body);
+      const uint16_t channels = ReadU16(body + 2);
+      const uint32_t rate = ReadU32(body + 4);
+      const uint16_t block_align = ReadU16(body + 12);
+      const uint16_t bits = ReadU16(body + 14);
+      if (tag == kWaveFormatExtensible) {
+        // The sub-format GUID starts with the plain format tag.
+        if (chunk_size < 40) {
+          return false;
+        }
+        tag = ReadU16(body + 24);
+      }
+      if (!SampleTypeFor(tag, bits, &format_.sample_type)) {
+        return false;
+      }
+      format_.channels = channels;
+      format_.sample_rate = rate;
+      if (!format_.IsValid() || block_align != format_.BlockAlign()) {
+        return false;
+      }
+      have_format = true;
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      if (!have_format) {
+        return false;
+      }
+      // Writers that crash before finalizing leave 0 or 0xFFFFFFFF here.
+      size_t bytes = chunk_size;
+      if (bytes == 0 || bytes > available) {
+        bytes = available;
+      }
+      samples_ = body;
+      frames_ = bytes / format_.BlockAlign();
+      return true;
+    }
+    // Chunks are word aligned.
+    offset += 8 + static_cast<size_t>(chunk_size) + (chunk_size & 1);
+  }
+  return false;
+}
+
+void WavReader::ReleaseBefore(uint64_t frame) const {
+  if (!samples_) {
+    return;
+  }
+  const size_t end = static_cast<size_t>(samples_ - file_.data()) +
+                     static_cast<size_t>(frame) * format_.BlockAlign();
+  file_.Release(0, end);
+}
+
+}  // namespace samurai
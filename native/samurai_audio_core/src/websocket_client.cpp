@@ -0,0 +1,640 @@
+#include "samurai_audio_core/websocket_client.h"
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#include "samurai_audio_core/base64.h"
+#include "sha1_internal.h"
+
+namespace samurai {
+
+namespace {
+
+constexpr char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// Larger messages close the connection with 1009; nothing we receive is
+// more than a status line.
+constexpr size_t kMaxMessageBytes = 16 * 1024 * 1024;
+constexpr size_t kMaxHandshakeBytes = 16 * 1024;
+constexpr size_t kRecvChunkBytes = 64 * 1024;
+
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+constexpr NativeSocket kInvalidSocket = INVALID_SOCKET;
+
+void CloseNativeSocket(NativeSocket s) { closesocket(s); }
+
+bool SetNonBlocking(NativeSocket s, bool enabled) {
+  u_long mode = enabled ? 1 : 0;
+  return ioctlsocket(s, FIONBIO, &mode) == 0;
+}
+
+int PollNativeSocket(NativeSocket s, short events, int timeout_ms) {
+  WSAPOLLFD fd = {};
+  fd.fd = s;
+  fd.events = events;
+  return WSAPoll(&fd, 1, timeout_ms);
+}
+
+bool ConnectInProgress() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+
+bool StartNetworking() {
+  static const bool started = []() {
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  }();
+  return started;
+}
+
+int SendSome(NativeSocket s, const uint8_t* data, size_t size) {
+  return send(s, reinterpret_cast<const char*>(data),
+              static_cast<int>(std::min<size_t>(size, INT32_MAX)), 0);
+}
+
+int RecvSome(NativeSocket s, uint8_t* data, size_t size) {
+  return recv(s, reinterpret_cast<char*>(data), static_cast<int>(size), 0);
+}
+#else
+using NativeSocket = int;
+constexpr NativeSocket kInvalidSocket = -1;
+
+void CloseNativeSocket(NativeSocket s) { close(s); }
+
+bool SetNonBlocking(NativeSocket s, bool enabled) {
+  const int flags = fcntl(s, F_GETFL, 0);
+  return flags >= 0 &&
+         fcntl(s, F_SETFL, enabled ? flags | O_NONBLOCK
+                                   : flags & ~O_NONBLOCK) == 0;
+}
+
+int PollNativeSocket(NativeSocket s, short events, int timeout_ms) {
+  pollfd fd = {};
+  fd.fd = s;
+  fd.events = events;
+  int result;
+  do {
+    result = poll(&fd, 1, timeout_ms);
+  } while (result < 0 && errno == EINTR);
+  return result;
+}
+
+bool ConnectInProgress() { return errno == EINPROGRESS; }
+
+bool StartNetworking() { return true; }
+
+int SendSome(NativeSocket s, const uint8_t* data, size_t size) {
+#if defined(MSG_NOSIGNAL)
+  const int flags = MSG_NOSIGNAL;  // A dropped peer must not kill the app.
+#else
+  const int flags = 0;
+#endif
+  ssize_t sent;
+  do {
+    sent = send(s, data, size, flags);
+  } while (sent < 0 && errno == EINTR);
+  return static_cast<int>(sent);
+}
+
+int RecvSome(NativeSocket s, uint8_t* data, size_t size) {
+  ssize_t received;
+  do {
+    received = recv(s, data, size, 0);
+  } while (received < 0 && errno == EINTR);
+  return static_cast<int>(received);
+}
+#endif
+
+NativeSocket ToNative(intptr_t s) { return static_cast<NativeSocket>(s); }
+
+// Resolves |url| and connects within |timeout_ms|. Returns kInvalidSocket
+// with |error| set on failure.
+NativeSocket ConnectTcp(const WebSocketUrl& url, int timeout_ms,
+                        std::string* error) {
+  if (!StartNetworking()) {
+    *error = "Networking unavailable";
+    return kInvalidSocket;
+  }
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  if (getaddrinfo(url.host.c_str(), std::to_string(url.port).c_str(), &hints,
+                  &addresses) != 0) {
+    *error = "Cannot resolve " + url.host;
+    return kInvalidSocket;
+  }
+  NativeSocket s = kInvalidSocket;
+  *error = "Cannot connect to " + url.host;
+  for (addrinfo* a = addresses; a != nullptr; a = a->ai_next) {
+    s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (s == kInvalidSocket) {
+      continue;
+    }
+    // Non-blocking only for the connect, so it can time out.
+    bool connected = false;
+    if (SetNonBlocking(s, true)) {
+      if (connect(s, a->ai_addr, static_cast<int>(a->ai_addrlen)) == 0) {
+        connected = true;
+      } else if (ConnectInProgress() &&
+                 PollNativeSocket(s, POLLOUT, timeout_ms) > 0) {
+        int so_error = 0;
+        socklen_t length = sizeof(so_error);
+        getsockopt(s, SOL_SOCKET, SO_ERROR,
+                   reinterpret_cast<char*>(&so_error), &length);
+        connected = so_error == 0;
+      }
+    }
+    if (connected && SetNonBlocking(s, false)) {
+      // Audio frames are small and latency-bound.
+      int one = 1;
+      setsockopt(s, IPPROTO_TCP, TCP_NODELAY,
+                 reinterpret_cast<const char*>(&one), sizeof(one));
+      error->clear();
+      break;
+    }
+    CloseNativeSocket(s);
+    s = kInvalidSocket;
+  }
+  freeaddrinfo(addresses);
+  return s;
+}
+
+bool EqualsIgnoreCase(const std::string& a, const char* b) {
+  const size_t length = std::strlen(b);
+  if (a.size() != length) {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) !=
+        std::tolower(static_cast<unsigned char>(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Value of header |name| in a raw HTTP response head, trimmed; empty when
+// absent.
+std::string HeaderValue(const std::string& head, const char* name) {
+  size_t line = head.find("\r\n");
+  while (line != std::string::npos && line + 2 < head.size()) {
+    const size_t start = line + 2;
+    const size_t end = head.find("\r\n", start);
+    const size_t colon = head.find(':', start);
+    if (colon != std::string::npos && colon < end &&
+        EqualsIgnoreCase(head.substr(start, colon - start), name)) {
+      size_t from = colon + 1;
+      size_t to = end == std::string::npos ? head.size() : end;
+      while (from < to && (head[from] == ' ' || head[from] == '\t')) {
+        ++from;
+      }
+      while (to > from && (head[to - 1] == ' ' || head[to - 1] == '\t')) {
+        --to;
+      }
+      return head.substr(from, to - from);
+    }
+    line = end;
+  }
+  return std::string();
+}
+
+// XORs |size| bytes with the 4-byte |mask|, eight at a time.
+void ApplyMask(uint8_t* data, size_t size, const uint8_t mask[4]) {
+  uint8_t pattern[8];
+  for (int i = 0; i < 8; ++i) {
+    pattern[i] = mask[i & 3];
+  }
+  uint64_t wide;
+  std::memcpy(&wide, pattern, sizeof(wide));
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, data + i, sizeof(chunk));
+    chunk ^= wide;
+    std::memcpy(data + i, &chunk, sizeof(chunk));
+  }
+  for (; i < size; ++i) {
+    data[i] ^= mask[i & 3];
+  }
+}
+
+}  // namespace
+
+bool ParseWebSocketUrl(const std::string& url, WebSocketUrl* parsed) {
+  const std::string scheme = "ws://";
+  if (url.size() <= scheme.size() ||
+      !EqualsIgnoreCase(url.substr(0, scheme.size()), scheme.c_str())) {
+    return false;
+  }
+  const size_t host_start = scheme.size();
+  const size_t path_start = url.find_first_of("/?", host_start);
+  const std::string authority =
+      url.substr(host_start, path_start == std::string::npos
+                                 ? std::string::npos
+                                 : path_start - host_start);
+  WebSocketUrl result;
+  // [v6]:port, host:port or host.
+  size_t port_colon = std::string::npos;
+  if (!authority.empty() && authority[0] == '[') {
+    const size_t close = authority.find(']');
+    if (close == std::string::npos) {
+      return false;
+    }
+    result.host = authority.substr(1, close - 1);
+    if (close + 1 < authority.size()) {
+      if (authority[close + 1] != ':') {
+        return false;
+      }
+      port_colon = close + 1;
+    }
+  } else {
+    port_colon = authority.find(':');
+    result.host = authority.substr(0, port_colon);
+  }
+  if (result.host.empty()) {
+    return false;
+  }
+  if (port_colon != std::string::npos) {
+    const std::string port = authority.substr(port_colon + 1);
+    if (port.empty() || port.size() > 5 ||
+        port.find_first_not_of("0123456789") != std::string::npos) {
+      return false;
+    }
+    const unsigned long value = std::stoul(port);
+    if (value == 0 || value > 65535) {
+      return false;
+    }
+    result.port = static_cast<uint16_t>(value);
+  }
+  if (path_start != std::string::npos) {
+    result.path = url.substr(path_start);
+    if (result.path[0] == '?') {
+      result.path.insert(0, "/");
+    }
+  }
+  *parsed = result;
+  return true;
+}
+
+bool IsLoopbackHost(const std::string& host) {
+  if (EqualsIgnoreCase(host, "localhost") || host == "::1") {
+    return true;
+  }
+  // Dotted-quad 127.a.b.c.
+  int parts = 0;
+  size_t start = 0;
+  while (start <= host.size()) {
+    size_t end = host.find('.', start);
+    if (end == std::string::npos) {
+      end = host.size();
+    }
+    const std::string part = host.substr(start, end - start);
+    if (part.empty() || part.size() > 3 ||
+        part.find_first_not_of("0123456789") != std::string::npos ||
+        std::stoi(part) > 255 || (parts == 0 && part != "127")) {
+      return false;
+    }
+    ++parts;
+    start = end + 1;
+  }
+  return parts == 4;
+}
+
+std::string WebSocketAcceptKey(const std::string& key) {
+  const std::string input = key + kWebSocketGuid;
+  uint8_t digest[internal::kSha1DigestBytes];
+  internal::Sha1(reinterpret_cast<const uint8_t*>(input.data()), input.size(),
+                 digest);
+  return Base64Encode(digest, sizeof(digest));
+}
+
+WebSocketClient::WebSocketClient() {
+  std::random_device seed;
+  mask_state_ = seed() | 1;
+}
+
+WebSocketClient::~WebSocketClient() { Close(); }
+
+bool WebSocketClient::Connect(const std::string& url,
+                              const std::vector<std::string>& headers,
+                              int timeout_ms, std::string* error) {
+  Close();
+  WebSocketUrl parsed;
+  if (!ParseWebSocketUrl(url, &parsed)) {
+    *error = "Invalid WebSocket URL";
+    return false;
+  }
+  const NativeSocket s = ConnectTcp(parsed, timeout_ms, error);
+  if (s == kInvalidSocket) {
+    return false;
+  }
+  socket_ = static_cast<intptr_t>(s);
+  input_.clear();
+  input_offset_ = 0;
+  message_.clear();
+
+  std::random_device seed;
+  uint8_t nonce[16];
+  for (uint8_t& byte : nonce) {
+    byte = static_cast<uint8_t>(seed());
+  }
+  const std::string key = Base64Encode(nonce, sizeof(nonce));
+  std::string request = "GET " + parsed.path + " HTTP/1.1\r\nHost: " +
+                        parsed.host;
+  if (parsed.port != 80) {
+    request += ":" + std::to_string(parsed.port);
+  }
+  request +=
+      "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+      "Sec-WebSocket-Key: " + key + "\r\nSec-WebSocket-Version: 13\r\n";
+  for (const std::string& header : headers) {
+    request += header + "\r\n";
+  }
+  request += "\r\n";
+  if (!WriteAll(reinterpret_cast<const uint8_t*>(request.data()),
+                request.size())) {
+    *error = "Handshake failed";
+    Drop();
+    return false;
+  }
+
+  // Read the response head; frames may follow it in the same segment.
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms);
+  size_t head_end = std::string::npos;
+  while (head_end == std::string::npos) {
+    const int left = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now())
+            .count());
+    bool timed_out = false;
+    if (left <= 0 || input_.size() > kMaxHandshakeBytes ||
+        !Fill(input_.size() + 1, left, &timed_out)) {
+      *error = timed_out || left <= 0 ? "Handshake timed out"
+                                      : "Handshake failed";
+      Drop();
+      return false;
+    }
+    const std::string received(input_.begin(), input_.end());
+    head_end = received.find("\r\n\r\n");
+  }
+  const std::string head(input_.begin(), input_.begin() + head_end + 2);
+  Consume(head_end + 4);
+  if (head.compare(0, 12, "HTTP/1.1 101") != 0) {
+    const size_t line_end = head.find("\r\n");
+    *error = "Server refused upgrade: " + head.substr(0, line_end);
+    Drop();
+    return false;
+  }
+  if (HeaderValue(head, "Sec-WebSocket-Accept") != WebSocketAcceptKey(key)) {
+    *error = "Bad Sec-WebSocket-Accept";
+    Drop();
+    return false;
+  }
+  return true;
+}
+
+bool WebSocketClient::SendText(const std::string& text) {
+  return SendFrame(WebSocketOpcode::kText,
+                   reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+bool WebSocketClient::SendBinary(const uint8_t* data, size_t size) {
+  return SendFrame(WebSocketOpcode::kBinary, data, size);
+}
+
+bool WebSocketClient::SendPing() {
+  return SendFrame(WebSocketOpcode::kPing, nullptr, 0);
+}
+
+bool WebSocketClient::SendFrame(WebSocketOpcode opcode, const uint8_t* data,
+                                size_t size) {
+  if (!is_open()) {
+    return false;
+  }
+  frame_.resize(14 + size);
+  uint8_t* out = frame_.data();
+  size_t header = 2;
+  out[0] = static_cast<uint8_t>(0x80 | static_cast<uint8_t>(opcode));
+  if (size < 126) {
+    out[1] = static_cast<uint8_t>(0x80 | size);
+  } else if (size <= 0xFFFF) {
+    out[1] = 0x80 | 126;
+    out[2] = static_cast<uint8_t>(size >> 8);
+    out[3] = static_cast<uint8_t>(size);
+    header = 4;
+  } else {
+    out[1] = 0x80 | 127;
+    for (int i = 0; i < 8; ++i) {
+      out[2 + i] = static_cast<uint8_t>(static_cast<uint64_t>(size) >>
+                                        (56 - 8 * i));
+    }
+    header = 10;
+  }
+  // Clients must mask; the key only has to be unpredictable to the
+  // network path, not secret.
+  mask_state_ ^= mask_state_ << 13;
+  mask_state_ ^= mask_state_ >> 17;
+  mask_state_ ^= mask_state_ << 5;
+  uint8_t* mask = out + header;
+  std::memcpy(mask, &mask_state_, 4);
+  header += 4;
+  if (size > 0) {
+    std::memcpy(out + header, data, size);
+    ApplyMask(out + header, size, mask);
+  }
+  if (!WriteAll(out, header + size)) {
+    Drop();
+    return false;
+  }
+  return true;
+}
+
+bool WebSocketClient::WriteAll(const uint8_t* data, size_t size) {
+  while (size > 0) {
+    const int sent = SendSome(ToNative(socket_), data, size);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    size -= static_cast<size_t>(sent);
+    bytes_sent_ += static_cast<uint64_t>(sent);
+  }
+  return true;
+}
+
+bool WebSocketClient::Fill(size_t size, int timeout_ms, bool* timed_out) {
+  *timed_out = false;
+  while (input_.size() - input_offset_ < size) {
+    if (input_offset_ > 0) {
+      input_.erase(input_.begin(), input_.begin() + input_offset_);
+      input_offset_ = 0;
+    }
+    const int ready = PollNativeSocket(ToNative(socket_), POLLIN, timeout_ms);
+    if (ready == 0) {
+      *timed_out = true;
+      return false;
+    }
+    if (ready < 0) {
+      return false;
+    }
+    const size_t old_size = input_.size();
+    input_.resize(old_size + kRecvChunkBytes);
+    const int received =
+        RecvSome(ToNative(socket_), input_.data() + old_size, kRecvChunkBytes);
+    input_.resize(old_size + static_cast<size_t>(std::max(received, 0)));
+    if (received <= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void WebSocketClient::Consume(size_t size) {
+  input_offset_ += size;
+  if (input_offset_ == input_.size()) {
+    input_.clear();
+    input_offset_ = 0;
+  }
+}
+
+WebSocketClient::ReadResult WebSocketClient::Read(
+    int timeout_ms, WebSocketOpcode* opcode, std::vector<uint8_t>* payload) {
+  while (is_open()) {
+    // Nothing is consumed until a whole frame is buffered, so a timeout
+    // part-way through a frame loses nothing.
+    bool timed_out = false;
+    if (!Fill(2, timeout_ms, &timed_out)) {
+      if (timed_out) {
+        return ReadResult::kTimeout;
+      }
+      break;
+    }
+    const uint8_t* head = input_.data() + input_offset_;
+    const bool fin = (head[0] & 0x80) != 0;
+    const auto op = static_cast<WebSocketOpcode>(head[0] & 0x0F);
+    const bool masked = (head[1] & 0x80) != 0;
+    size_t header = 2 + (masked ? 4 : 0);
+    uint64_t length = head[1] & 0x7F;
+    if (length == 126) {
+      header += 2;
+    } else if (length == 127) {
+      header += 8;
+    }
+    if (!Fill(header, timeout_ms, &timed_out)) {
+      if (timed_out) {
+        return ReadResult::kTimeout;
+      }
+      break;
+    }
+    head = input_.data() + input_offset_;
+    if (length == 126) {
+      length = (static_cast<uint64_t>(head[2]) << 8) | head[3];
+    } else if (length == 127) {
+      length = 0;
+      for (int i = 0; i < 8; ++i) {
+        length = (length << 8) | head[2 + i];
+      }
+    }
+    if (length > kMaxMessageBytes ||
+        message_.size() + length > kMaxMessageBytes) {
+      Close(1009);
+      return ReadResult::kClosed;
+    }
+    if (!Fill(header + static_cast<size_t>(length), timeout_ms, &timed_out)) {
+      if (timed_out) {
+        return ReadResult::kTimeout;
+      }
+      break;
+    }
+    uint8_t* data = input_.data() + input_offset_ + header;
+    const size_t size = static_cast<size_t>(length);
+    if (masked) {
+      ApplyMask(data, size, data - 4);
+    }
+
+    switch (op) {
+      case WebSocketOpcode::kPing: {
+        std::vector<uint8_t> echo(data, data + size);
+        Consume(header + size);
+        SendFrame(WebSocketOpcode::kPong, echo.data(), echo.size());
+        continue;
+      }
+      case WebSocketOpcode::kPong:
+        Consume(header + size);
+        continue;
+      case WebSocketOpcode::kClose: {
+        uint16_t code = 1000;
+        if (size >= 2) {
+          code = static_cast<uint16_t>((data[0] << 8) | data[1]);
+        }
+        Consume(header + size);
+        Close(code);
+        return ReadResult::kClosed;
+      }
+      case WebSocketOpcode::kText:
+      case WebSocketOpcode::kBinary:
+        message_opcode_ = op;
+        message_.assign(data, data + size);
+        break;
+      case WebSocketOpcode::kContinuation:
+        message_.insert(message_.end(), data, data + size);
+        break;
+      default:
+        // Reserved opcode: a protocol error.
+        Close(1002);
+        return ReadResult::kClosed;
+    }
+    Consume(header + size);
+    if (fin) {
+      *opcode = message_opcode_;
+      payload->swap(message_);
+      message_.clear();
+      return ReadResult::kMessage;
+    }
+  }
+  Drop();
+  return ReadResult::kClosed;
+}
+
+void WebSocketClient::Close(uint16_t code) {
+  if (!is_open()) {
+    return;
+  }
+  const uint8_t reason[2] = {static_cast<uint8_t>(code >> 8),
+                             static_cast<uint8_t>(code)};
+  SendFrame(WebSocketOpcode::kClose, reason, sizeof(reason));
+  Drop();
+}
+
+void WebSocketClient::Drop() {
+  if (!is_open()) {
+    return;
+  }
+#if defined(_WIN32)
+  shutdown(ToNative(socket_), SD_BOTH);
+#else
+  shutdown(ToNative(socket_), SHUT_RDWR);
+#endif
+  CloseNativeSocket(ToNative(socket_));
+  socket_ = kNoSocket;
+}
+
+}  // namespace samurai
@@ -0,0 +1,623 @@
+#include "samurai_audio_core/websocket_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "samurai_audio_core/frame_protocol.h"
+
+namespace samurai {
+
+namespace {
+
+// How long the network thread sleeps when there is nothing to send; bounds
+// the latency of answering pings and noticing a closed socket.
+constexpr auto kIdleWait = std::chrono::milliseconds(50);
+
+// Spilled messages sent per turn of the network thread, between pings.
+constexpr int kReplayBatch = 64;
+
+// Largest echo canceller block used; bigger ones only add FFT work.
+constexpr uint32_t kMaxEchoBlock = 256;
+
+// Audio a packet's message holds; silence markers hold none.
+uint64_t HeldNs(const AudioPacket& packet) {
+  if (packet.size == 0 || packet.format.sample_rate == 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(packet.frames) * 1000000000ull /
+         packet.format.sample_rate;
+}
+
+uint64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+}  // namespace
+
+const char* WebSocketSinkStateName(WebSocketSinkState state) {
+  switch (state) {
+    case WebSocketSinkState::kConnecting:
+      return "connecting";
+    case WebSocketSinkState::kConnected:
+      return "connected";
+    case WebSocketSinkState::kReconnecting:
+      return "reconnecting";
+    case WebSocketSinkState::kStopped:
+      return "stopped";
+  }
+  return "unknown";
+}
+
+WebSocketSink::WebSocketSink(WebSocketSinkConfig config,
+                             WebSocketSinkCallback callback)
+    : config_(std::move(config)),
+      callback_(std::move(callback)),
+      aligner_(config_.aligner) {}
+
+WebSocketSink::~WebSocketSink() { Stop(); }
+
+bool WebSocketSink::Start() {
+  WebSocketUrl url;
+  if (!ParseWebSocketUrl(config_.url, &url)) {
+    return false;
+  }
+  // Only ws:// is supported: never send a token over the network in the
+  // clear.
+  if (!config_.auth_token.empty() && !IsLoopbackHost(url.host)) {
+    return false;
+  }
+  if (thread_.joinable()) {
+    return true;
+  }
+  {
+    std::lock_guard<std::mutex> spill_lock(spill_mutex_);
+    spill_error_.clear();
+    if (!config_.spill.directory.empty()) {
+      spill_ = std::make_unique<SpillLog>(config_.spill);
+      if (spill_->Open()) {
+        // Left by an earlier sink: replayed before anything new.
+        spilling_ = !spill_->empty();
+      } else {
+        spill_.reset();
+        spill_error_ = "Cannot open spill log in " + config_.spill.directory;
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    releasing_ = false;
+    stopping_ = false;
+    link_down_ = false;
+    if (spill_) {
+      UpdateSpillStats();
+    }
+  }
+  thread_ = std::thread([this]() { Run(); });
+  return true;
+}
+
+void WebSocketSink::Stop() {
+  // A Deliver() waiting for room holds the aligner.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    releasing_ = true;
+  }
+  room_cv_.notify_all();
+  if (config_.align_streams) {
+    std::lock_guard<std::mutex> lock(aligner_mutex_);
+    aligner_.Flush(
+        [this](const AudioPacket& aligned) { EnqueueAligned(aligned); });
+    UpdateAlignerStats();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  std::lock_guard<std::mutex> spill_lock(spill_mutex_);
+  if (spill_) {
+    SpillQueue();
+  }
+  spill_.reset();
+  spilling_ = false;
+}
+
+void WebSocketSink::SpillQueue() {
+  MessageQueue queued;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued.swap(queue_);
+    UpdateQueueStats();
+  }
+  if (queued.empty()) {
+    return;
+  }
+  // While spilling, the queue only holds messages a drop sent back, older
+  // than the log: they are appended, then the log's records are moved
+  // behind them one at a time.
+  const uint64_t older = spill_->stats().pending_records;
+  uint64_t spilled = 0;
+  uint64_t failed = 0;
+  auto append = [&](const uint8_t* data, size_t size, uint64_t ns) {
+    if (spill_->Append(data, size, ns)) {
+      ++spilled;
+    } else {
+      ++failed;
+    }
+  };
+  for (; !queued.empty(); queued.pop_front()) {
+    append(queued.front().data(), queued.front().size(), queued.front_ns());
+  }
+  SpillRecord record;
+  for (uint64_t i = 0; i < older && spill_->Peek(&record); ++i) {
+    // Copied out: the record is only valid until the Pop().
+    replay_message_.assign(record.data, record.data + record.size);
+    const uint64_t ns = record.ns;
+    spill_->Pop(record.index);
+    append(replay_message_.data(), replay_message_.size(), ns);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.messages_spilled += spilled;
+  spill_failures_ += failed;
+  UpdateSpillStats();
+}
+
+void WebSocketSink::Deliver(const AudioPacket& packet) {
+  if (config_.align_streams) {
+    std::lock_guard<std::mutex> lock(aligner_mutex_);
+    const bool aligned = aligner_.Push(packet, [this](const AudioPacket& out) {
+      EnqueueAligned(out);
+    });
+    UpdateAlignerStats();
+    if (aligned) {
+      return;
+    }
+  }
+  Enqueue(packet);
+}
+
+void WebSocketSink::UpdateAlignerStats() {
+  const StreamAlignerStats& aligner = aligner_.stats();
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.aligned_filled_frames = 0;
+  stats_.aligned_late_frames = 0;
+  for (int i = 0; i < kStreamKindCount; ++i) {
+    stats_.aligned_filled_frames += aligner.filled_frames[i];
+    stats_.aligned_late_frames += aligner.late_frames[i];
+  }
+  if (echo_canceller_) {
+    const EchoCancellerStats& echo = echo_canceller_->stats();
+    stats_.echo_processed_frames = echo.processed_frames;
+    stats_.echo_cpu_ns = echo.cpu_ns;
+    stats_.echo_erle_db = echo.erle_db;
+    stats_.echo_bypassed_frames = echo.bypassed_frames;
+  }
+  stats_.echo_bypassed_frames += echo_passed_frames_;
+}
+
+void WebSocketSink::EnqueueAligned(const AudioPacket& packet) {
+  const SampleType type = packet.format.sample_type;
+  const bool pcm = config_.cancel_echo && packet.codec == CodecId::kPcm &&
+                   packet.data && packet.format.channels == 2 &&
+                   (type == SampleType::kInt16 ||
+                    type == SampleType::kFloat32);
+  if (pcm && !echo_checked_) {
+    echo_checked_ = true;
+    uint32_t block = 1;
+    while (block < kMaxEchoBlock && packet.frames % (2 * block) == 0) {
+      block *= 2;
+    }
+    auto canceller = std::make_unique<EchoCanceller>(
+        packet.format.sample_rate, block, config_.echo);
+    if (canceller->IsValid()) {
+      echo_canceller_ = std::move(canceller);
+      echo_far_.resize(packet.frames);
+      echo_near_.resize(packet.frames);
+    }
+  }
+  // The aligner emits one packet size but for the last.
+  if (!pcm || !echo_canceller_ || packet.frames != echo_far_.size()) {
+    if (config_.cancel_echo) {
+      echo_passed_frames_ += packet.frames;
+    }
+    Enqueue(packet);
+    return;
+  }
+
+  // Customer (far end) on the left, agent (near end) on the right.
+  const size_t frames = packet.frames;
+  // Cancelled in the message itself.
+  FrameRef message = NewMessage(kFrameHeaderBytes + packet.size);
+  uint8_t* payload = message.data() + kFrameHeaderBytes;
+  std::memcpy(payload, packet.data, packet.size);
+  if (type == SampleType::kInt16) {
+    int16_t* samples = reinterpret_cast<int16_t*>(payload);
+    for (size_t i = 0; i < frames; ++i) {
+      echo_far_[i] = samples[2 * i] * (1.0f / 32768.0f);
+      echo_near_[i] = samples[2 * i + 1] * (1.0f / 32768.0f);
+    }
+    echo_canceller_->Process(echo_far_.data(), echo_near_.data(), frames,
+                             echo_near_.data());
+    for (size_t i = 0; i < frames; ++i) {
+      const float scaled = std::nearbyint(echo_near_[i] * 32768.0f);
+      samples[2 * i + 1] = static_cast<int16_t>(
+          std::min(32767.0f, std::max(-32768.0f, scaled)));
+    }
+  } else {
+    float* samples = reinterpret_cast<float*>(payload);
+    for (size_t i = 0; i < frames; ++i) {
+      echo_far_[i] = samples[2 * i];
+      echo_near_[i] = samples[2 * i + 1];
+    }
+    echo_canceller_->Process(echo_far_.data(), echo_near_.data(), frames,
+                             echo_near_.data());
+    for (size_t i = 0; i < frames; ++i) {
+      samples[2 * i + 1] = echo_near_[i];
+    }
+  }
+  EncodeFrameHeader(FrameHeaderForPacket(packet), message.data());
+  message.set_size(kFrameHeaderBytes + packet.size);
+  QueueMessage(std::move(message), HeldNs(packet));
+}
+
+void WebSocketSink::Enqueue(const AudioPacket& packet) {
+  FrameRef message = NewMessage(kFrameHeaderBytes + packet.size);
+  uint8_t* out = message.data();
+  EncodeFrameHeader(FrameHeaderForPacket(packet), out);
+  if (packet.size > 0) {
+    std::memcpy(out + kFrameHeaderBytes, packet.data, packet.size);
+  }
+  message.set_size(kFrameHeaderBytes + packet.size);
+  QueueMessage(std::move(message), HeldNs(packet));
+}
+
+void WebSocketSink::QueueMessage(FrameRef message, uint64_t ns) {
+  std::lock_guard<std::mutex> spill_lock(spill_mutex_);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (spill_ &&
+        (spilling_ || link_down_ || !QueueFits(message.size(), ns))) {
+      // Starting to spill, what is queued goes first, so the log is in
+      // order. Once spilling, the queue only holds messages a drop sent
+      // back, which are older than the log and sent before it.
+      MessageQueue queued;
+      if (!spilling_) {
+        queued.swap(queue_);
+        UpdateQueueStats();
+      }
+      spilling_ = true;
+      lock.unlock();
+      uint64_t spilled = 0;
+      uint64_t failed = 0;
+      auto append = [&](const FrameRef& frame, uint64_t held_ns) {
+        if (spill_->Append(frame.data(), frame.size(), held_ns)) {
+          ++spilled;
+        } else {
+          ++failed;
+        }
+      };
+      for (; !queued.empty(); queued.pop_front()) {
+        append(queued.front(), queued.front_ns());
+      }
+      append(message, ns);
+      lock.lock();
+      stats_.messages_spilled += spilled;
+      spill_failures_ += failed;
+      UpdateSpillStats();
+      return;
+    }
+    if (config_.block_when_full && !releasing_ &&
+        !QueueFits(message.size(), ns)) {
+      ++stats_.messages_blocked;
+      const size_t bytes = message.size();
+      room_cv_.wait(lock,
+                    [&]() { return releasing_ || QueueFits(bytes, ns); });
+    }
+    queue_.push_back(std::move(message), ns);
+    TrimQueue();
+    UpdateQueueStats();
+  }
+  cv_.notify_one();
+}
+
+bool WebSocketSink::QueueFits(size_t bytes, uint64_t ns) const {
+  return queue_.empty() ||
+         (queue_.bytes() + bytes <= config_.max_queued_bytes &&
+          (config_.max_queued_ms == 0 ||
+           queue_.ns() + ns <=
+               static_cast<uint64_t>(config_.max_queued_ms) * 1000000));
+}
+
+void WebSocketSink::TrimQueue() {
+  const uint64_t max_ns =
+      static_cast<uint64_t>(config_.max_queued_ms) * 1000000;
+  while (queue_.size() > 1 && (queue_.bytes() > config_.max_queued_bytes ||
+                               (max_ns > 0 && queue_.ns() > max_ns))) {
+    queue_.pop_front();
+    ++stats_.messages_dropped;
+  }
+}
+
+void WebSocketSink::UpdateSpillStats() {
+  const SpillLogStats log = spill_->stats();
+  stats_.spill_dropped = log.dropped_records + spill_failures_;
+  stats_.spill_queued_bytes = log.pending_bytes;
+  stats_.spill_queued_ms = static_cast<uint32_t>(log.pending_ns / 1000000);
+  stats_.spill_disk_bytes = log.disk_bytes;
+}
+
+void WebSocketSink::UpdateQueueStats() {
+  stats_.queued_bytes = queue_.bytes();
+  stats_.queued_ms = static_cast<uint32_t>(queue_.ns() / 1000000);
+  stats_.high_water_bytes =
+      std::max<uint64_t>(stats_.high_water_bytes, stats_.queued_bytes);
+  stats_.high_water_ms = std::max(stats_.high_water_ms, stats_.queued_ms);
+}
+
+FrameRef WebSocketSink::NewMessage(size_t size) {
+  FramePool* pool;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!message_pool_) {
+      // Enough messages the size of the first to fill the queue twice,
+      // once more for the batch being sent, and a few more.
+      message_pool_.reset(
+          new FramePool(2 * config_.max_queued_bytes / size + 8, size));
+    }
+    pool = message_pool_.get();
+  }
+  FrameRef message;
+  if (size <= pool->buffer_bytes()) {
+    message = pool->Acquire();
+  }
+  if (!message) {
+    message = FrameRef::Allocate(size);
+  }
+  return message;
+}
+
+void WebSocketSink::MessageQueue::push_back(FrameRef message, uint64_t ns) {
+  if (count_ == messages_.size()) {
+    Grow();
+  }
+  bytes_ += message.size();
+  ns_ += ns;
+  Message& slot = messages_[(head_ + count_) % messages_.size()];
+  slot.frame = std::move(message);
+  slot.ns = ns;
+  ++count_;
+}
+
+void WebSocketSink::MessageQueue::pop_front() {
+  Message& slot = messages_[head_];
+  bytes_ -= slot.frame.size();
+  ns_ -= slot.ns;
+  slot.frame.Reset();
+  head_ = (head_ + 1) % messages_.size();
+  --count_;
+}
+
+void WebSocketSink::MessageQueue::swap(MessageQueue& other) {
+  messages_.swap(other.messages_);
+  std::swap(head_, other.head_);
+  std::swap(count_, other.count_);
+  std::swap(bytes_, other.bytes_);
+  std::swap(ns_, other.ns_);
+}
+
+void WebSocketSink::MessageQueue::Grow() {
+  std::vector<Message> grown(std::max<size_t>(64, messages_.size() * 2));
+  for (size_t i = 0; i < count_; ++i) {
+    grown[i] = std::move(messages_[(head_ + i) % messages_.size()]);
+  }
+  messages_.swap(grown);
+  head_ = 0;
+}
+
+WebSocketSinkStats WebSocketSink::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void WebSocketSink::Run() {
+  std::vector<std::string> headers;
+  if (!config_.auth_token.empty()) {
+    headers.push_back("Authorization: Bearer " + config_.auth_token);
+  }
+  uint32_t backoff = std::max<uint32_t>(1, config_.reconnect_min_ms);
+  bool connected_before = false;
+  Emit(WebSocketSinkState::kConnecting, spill_error_);
+  while (true) {
+    std::string error;
+    if (client_.Connect(config_.url, headers, config_.connect_timeout_ms,
+                        &error)) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        link_down_ = false;
+        if (connected_before) {
+          ++stats_.reconnects;
+        }
+      }
+      connected_before = true;
+      backoff = std::max<uint32_t>(1, config_.reconnect_min_ms);
+      Emit(WebSocketSinkState::kConnected, std::string());
+      if (Pump(&error)) {
+        break;
+      }
+    }
+    {
+      // Spilling from now on, if configured.
+      std::lock_guard<std::mutex> lock(mutex_);
+      link_down_ = true;
+    }
+    Emit(WebSocketSinkState::kReconnecting, error);
+    if (WaitForStop(backoff)) {
+      break;
+    }
+    backoff = std::min(backoff * 2, config_.reconnect_max_ms);
+  }
+  client_.Close();
+  Emit(WebSocketSinkState::kStopped, std::string());
+}
+
+bool WebSocketSink::Pump(std::string* error) {
+  const auto interval = std::chrono::milliseconds(
+      std::max<uint32_t>(1, config_.stats_interval_ms));
+  auto next_stats = std::chrono::steady_clock::now() + interval;
+  MessageQueue batch;
+  std::vector<uint8_t> received;
+  // The replay pace, from the connection or the end of the last backlog.
+  auto replay_start = std::chrono::steady_clock::now();
+  uint64_t replayed_ns = 0;
+  std::chrono::nanoseconds wait = kIdleWait;
+  while (true) {
+    bool stopping;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait_for(lock, wait,
+                   [this]() { return stopping_ || !queue_.empty(); });
+      batch.swap(queue_);
+      UpdateQueueStats();
+      stopping = stopping_;
+    }
+    room_cv_.notify_all();
+    wait = kIdleWait;
+    const bool queue_empty = batch.empty();
+
+    while (!batch.empty()) {
+      const auto start = std::chrono::steady_clock::now();
+      const FrameRef& frame = batch.front();
+      if (!client_.SendBinary(frame.data(), frame.size())) {
+        // Unsent messages go back ahead of anything queued since, for the
+        // next connection.
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!queue_.empty()) {
+          batch.push_back(std::move(queue_.front()), queue_.front_ns());
+          queue_.pop_front();
+        }
+        queue_.swap(batch);
+        // With a log, Deliver() spills what is queued on the next call.
+        if (!spill_) {
+          TrimQueue();
+        }
+        UpdateQueueStats();
+        *error = "Send failed";
+        return false;
+      }
+      const uint64_t ns = ElapsedNs(start);
+      batch.pop_front();
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.messages_sent;
+      stats_.bytes_sent = client_.bytes_sent();
+      stats_.max_send_ns = std::max(stats_.max_send_ns, ns);
+    }
+    if (stopping) {
+      // Everything queued before Stop() has gone out.
+      return true;
+    }
+    // The log only holds messages newer than the queue.
+    if (spill_ && queue_empty &&
+        !Replay(&replay_start, &replayed_ns, &wait, error)) {
+      return false;
+    }
+
+    // Answers pings and notices a close; server messages are only counted.
+    WebSocketOpcode opcode;
+    WebSocketClient::ReadResult result;
+    while ((result = client_.Read(0, &opcode, &received)) ==
+           WebSocketClient::ReadResult::kMessage) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.messages_received;
+    }
+    if (result == WebSocketClient::ReadResult::kClosed) {
+      *error = "Connection closed by server";
+      return false;
+    }
+    if (std::chrono::steady_clock::now() >= next_stats) {
+      next_stats += interval;
+      Emit(WebSocketSinkState::kConnected, std::string());
+    }
+  }
+}
+
+bool WebSocketSink::Replay(std::chrono::steady_clock::time_point* start,
+                           uint64_t* replayed_ns,
+                           std::chrono::nanoseconds* wait,
+                           std::string* error) {
+  for (int i = 0; i < kReplayBatch; ++i) {
+    uint64_t ns;
+    uint64_t index;
+    {
+      std::lock_guard<std::mutex> spill_lock(spill_mutex_);
+      SpillRecord record;
+      if (!spill_->Peek(&record)) {
+        // Caught up: messages queue again, and the next backlog is paced
+        // from when it starts.
+        spilling_ = false;
+        *start = std::chrono::steady_clock::now();
+        *replayed_ns = 0;
+        return true;
+      }
+      if (config_.replay_speed > 0) {
+        const uint64_t due_ns =
+            static_cast<uint64_t>(*replayed_ns / config_.replay_speed);
+        const uint64_t elapsed_ns = ElapsedNs(*start);
+        if (due_ns > elapsed_ns) {
+          *wait = std::min<std::chrono::nanoseconds>(
+              *wait, std::chrono::nanoseconds(due_ns - elapsed_ns));
+          return true;
+        }
+      }
+      // Copied out: an Append() may evict the segment while it is sent.
+      replay_message_.assign(record.data, record.data + record.size);
+      ns = record.ns;
+      index = record.index;
+    }
+    const auto send_start = std::chrono::steady_clock::now();
+    if (!client_.SendBinary(replay_message_.data(), replay_message_.size())) {
+      // The message stays in the log for the next connection.
+      *error = "Send failed";
+      return false;
+    }
+    const uint64_t send_ns = ElapsedNs(send_start);
+    *replayed_ns += ns;
+    std::lock_guard<std::mutex> spill_lock(spill_mutex_);
+    spill_->Pop(index);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.messages_sent;
+    ++stats_.messages_replayed;
+    stats_.bytes_sent = client_.bytes_sent();
+    stats_.max_send_ns = std::max(stats_.max_send_ns, send_ns);
+    UpdateSpillStats();
+  }
+  // More may be due at once.
+  *wait = std::chrono::nanoseconds(0);
+  return true;
+}
+
+void WebSocketSink::Emit(WebSocketSinkState state, const std::string& error) {
+  if (!callback_) {
+    return;
+  }
+  WebSocketSinkEvent event;
+  event.state = state;
+  event.error = error;
+  event.stats = stats();
+  callback_(event);
+}
+
+bool WebSocketSink::WaitForStop(uint32_t ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return cv_.wait_for(lock, std::chrono::milliseconds(ms),
+                      [this]() { return stopping_; });
+}
+
+}  // namespace samurai
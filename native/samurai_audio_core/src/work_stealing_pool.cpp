@@ -0,0 +1,102 @@
+#include "samurai_audio_core/work_stealing_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace samurai {
+
+namespace {
+
+// The pool and deque the current thread works for, if any.
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    deques_.push_back(std::make_unique<TaskDeque>());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::Submit(Task task) {
+  const size_t index =
+      current_pool == this
+          ? current_index
+          : next_deque_.fetch_add(1, std::memory_order_relaxed) %
+                deques_.size();
+  {
+    std::lock_guard<std::mutex> lock(deques_[index]->mutex);
+    deques_[index]->tasks.push_back(std::move(task));
+  }
+  {
+    // Counted only once it is in a deque, so a claim always finds a task.
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++unclaimed_;
+  }
+  cv_.notify_one();
+}
+
+bool WorkStealingPool::Take(size_t index, Task* task) {
+  {
+    TaskDeque& own = *deques_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      *task = std::move(own.tasks.front());
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+  for (size_t i = 1; i < deques_.size(); ++i) {
+    TaskDeque& victim = *deques_[(index + i) % deques_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      *task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  current_index = index;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stopping_ || unclaimed_ > 0; });
+      if (unclaimed_ == 0) {
+        return;
+      }
+      --unclaimed_;
+    }
+    // Every claim is backed by a queued task, but another worker may be
+    // holding the deque it sits in for a moment.
+    Task task;
+    while (!Take(index, &task)) {
+      std::this_thread::yield();
+    }
+    task();
+  }
+}
+
+}  // namespace samurai
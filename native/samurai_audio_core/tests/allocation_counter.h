@@ -0,0 +1,57 @@
+#ifndef SAMURAI_AUDIO_CORE_TESTS_ALLOCATION_COUNTER_H_
+#define SAMURAI_AUDIO_CORE_TESTS_ALLOCATION_COUNTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions of the test executable that
+// includes it (one source per executable) with counting ones, so a test
+// can check that a stretch of code, on any thread, allocates nothing.
+namespace samurai {
+namespace testing {
+
+inline std::atomic<uint64_t>& AllocationCounter() {
+  static std::atomic<uint64_t> count{0};
+  return count;
+}
+
+// Heap allocations so far, by every thread.
+inline uint64_t AllocationCount() {
+  return AllocationCounter().load(std::memory_order_relaxed);
+}
+
+inline void* CountedAllocate(std::size_t size) {
+  AllocationCounter().fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size > 0 ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+}  // namespace testing
+}  // namespace samurai
+
+void* operator new(std::size_t size) {
+  return ::samurai::testing::CountedAllocate(size);
+}
+void* operator new[](std::size_t size) {
+  return ::samurai::testing::CountedAllocate(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  ::samurai::testing::AllocationCounter().fetch_add(
+      1, std::memory_order_relaxed);
+  return std::malloc(size > 0 ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  ::samurai::testing::AllocationCounter().fetch_add(
+      1, std::memory_order_relaxed);
+  return std::malloc(size > 0 ? size : 1);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#endif  // SAMURAI_AUDIO_CORE_TESTS_ALLOCATION_COUNTER_H_
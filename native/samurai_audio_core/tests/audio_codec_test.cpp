@@ -0,0 +1,209 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "samurai_audio_core/audio_codec.h"
+#include "samurai_audio_core/capture_backend.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+struct Emitted {
+  std::vector<uint8_t> data;
+  uint32_t frames;
+  uint32_t flags;
+};
+
+AudioFormat Mono16k() {
+  AudioFormat format;
+  format.sample_rate = 16000;
+  format.channels = 1;
+  format.sample_type = SampleType::kInt16;
+  return format;
+}
+
+EncoderConfig PcmFrames(uint32_t frame_ms) {
+  EncoderConfig config;
+  config.codec = CodecId::kPcm;
+  config.frame_ms = frame_ms;
+  return config;
+}
+
+EncoderStage::Output Collect(std::vector<Emitted>* out) {
+  return [out](const uint8_t* data, size_t size, uint32_t frames,
+               uint32_t flags) {
+    out->push_back({std::vector<uint8_t>(data, data + size), frames, flags});
+  };
+}
+
+// Like MP3: the first two frames produce no packet, and Finish() returns
+// what is left.
+class LaggingEncoder : public AudioEncoder {
+ public:
+  const EncoderConfig& config() const override { return config_; }
+  const AudioFormat& input_format() const override { return format_; }
+  std::string MimeType() const override { return "test/lagging"; }
+  uint32_t frame_size() const override { return 4; }
+  size_t max_packet_bytes() const override { return 8; }
+
+  size_t Encode(const uint8_t* pcm, uint8_t* out) override {
+    if (++calls_ <= 2) {
+      return 0;
+    }
+    out[0] = static_cast<uint8_t>(calls_);
+    return 1;
+  }
+
+  size_t Finish(uint8_t* out) override {
+    out[0] = 0xEE;
+    return 1;
+  }
+
+ private:
+  EncoderConfig config_;
+  AudioFormat format_ = Mono16k();
+  int calls_ = 0;
+};
+
+}  // namespace
+
+TEST(ParsesCodecNames) {
+  CodecId codec = CodecId::kPcm;
+  EXPECT_TRUE(ParseCodecId("opus", &codec));
+  EXPECT_TRUE(codec == CodecId::kOpus);
+  EXPECT_TRUE(ParseCodecId(CodecName(CodecId::kPcm), &codec));
+  EXPECT_TRUE(codec == CodecId::kPcm);
+  EXPECT_TRUE(ParseCodecId("mp3", &codec));
+  EXPECT_TRUE(codec == CodecId::kMp3);
+  EXPECT_TRUE(!ParseCodecId("flac", &codec));
+
+  OpusApplication application = OpusApplication::kVoip;
+  EXPECT_TRUE(ParseOpusApplication("audio", &application));
+  EXPECT_TRUE(application == OpusApplication::kAudio);
+  EXPECT_TRUE(!ParseOpusApplication("lowdelay", &application));
+}
+
+TEST(FactoryMatchesAvailability) {
+  EXPECT_TRUE(AudioCodecAvailable(CodecId::kPcm));
+  EncoderConfig opus;
+  opus.codec = CodecId::kOpus;
+  const bool created = CreateAudioEncoder(opus, Mono16k()) != nullptr;
+  EXPECT_TRUE(created == AudioCodecAvailable(CodecId::kOpus));
+  EncoderConfig mp3;
+  mp3.codec = CodecId::kMp3;
+  EXPECT_TRUE((CreateAudioEncoder(mp3, Mono16k()) != nullptr) ==
+              AudioCodecAvailable(CodecId::kMp3));
+
+  AudioFormat int24 = Mono16k();
+  int24.sample_type = SampleType::kInt24;
+  EXPECT_TRUE(CreateAudioEncoder(PcmFrames(20), int24) == nullptr);
+}
+
+TEST(OpusEncodesSpeechRateFrames) {
+  if (!AudioCodecAvailable(CodecId::kOpus)) {
+    return;  // Built without libopus.
+  }
+  EncoderConfig config;
+  config.codec = CodecId::kOpus;
+  config.bitrate = 1000;  // Clamped.
+  config.frame_ms = 25;   // Not an Opus frame size.
+  std::unique_ptr<AudioEncoder> encoder = CreateAudioEncoder(config, Mono16k());
+  ASSERT_TRUE(encoder != nullptr);
+  EXPECT_EQ(encoder->config().bitrate, 6000u);
+  EXPECT_EQ(encoder->config().frame_ms, 20u);
+  EXPECT_EQ(encoder->frame_size(), 320u);
+  EXPECT_TRUE(encoder->MimeType() == "audio/opus;rate=16000;channels=1");
+
+  // Opus only runs at its native rates.
+  AudioFormat cd = Mono16k();
+  cd.sample_rate = 44100;
+  EXPECT_TRUE(CreateAudioEncoder(config, cd) == nullptr);
+
+  std::vector<int16_t> tone(320);
+  for (size_t i = 0; i < tone.size(); ++i) {
+    tone[i] = static_cast<int16_t>(8000 * std::sin(0.1 * i));
+  }
+  std::vector<uint8_t> packet(encoder->max_packet_bytes());
+  const size_t size = encoder->Encode(
+      reinterpret_cast<const uint8_t*>(tone.data()), packet.data());
+  EXPECT_TRUE(size > 0);
+  EXPECT_TRUE(size < 640);  // Far smaller than the 640 PCM bytes.
+}
+
+TEST(StageReframesPackets) {
+  EncoderStage stage(CreateAudioEncoder(PcmFrames(20), Mono16k()));
+  std::vector<int16_t> input(441 * 3);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<int16_t>(i);
+  }
+  std::vector<Emitted> out;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(input.data());
+  for (int i = 0; i < 3; ++i) {
+    stage.Push(bytes + i * 441 * 2, 441, i == 1 ? kPacketDiscontinuity : 0,
+               Collect(&out));
+  }
+  // 1323 frames: four 320-frame packets, 43 frames buffered.
+  ASSERT_TRUE(out.size() == 4);
+  std::vector<uint8_t> joined;
+  for (const Emitted& e : out) {
+    EXPECT_EQ(e.frames, 320u);
+    joined.insert(joined.end(), e.data.begin(), e.data.end());
+  }
+  EXPECT_TRUE(std::memcmp(joined.data(), bytes, joined.size()) == 0);
+  // The flag lands on the packet holding the flagged input's first frame.
+  EXPECT_EQ(out[0].flags, 0u);
+  EXPECT_EQ(out[1].flags, static_cast<uint32_t>(kPacketDiscontinuity));
+  EXPECT_EQ(out[2].flags, 0u);
+  EXPECT_EQ(out[3].flags, 0u);
+
+  stage.Flush(Collect(&out));
+  ASSERT_TRUE(out.size() == 5);
+  EXPECT_EQ(out[4].frames, 320u);
+  EXPECT_EQ(reinterpret_cast<const int16_t*>(out[4].data.data())[42],
+            input[1322]);
+  EXPECT_EQ(reinterpret_cast<const int16_t*>(out[4].data.data())[43], 0);
+}
+
+TEST(StagePadsFrameBeforeSilenceMarker) {
+  EncoderStage stage(CreateAudioEncoder(PcmFrames(20), Mono16k()));
+  std::vector<int16_t> input(100, 7);
+  std::vector<Emitted> out;
+  stage.Push(reinterpret_cast<const uint8_t*>(input.data()), 100, 0,
+             Collect(&out));
+  const uint32_t marker = kPacketSilenceMarker | kPacketNoSpeech;
+  stage.Push(nullptr, 1000, marker, Collect(&out));
+  ASSERT_TRUE(out.size() == 2);
+  EXPECT_EQ(out[0].frames, 320u);
+  EXPECT_EQ(out[0].flags, 0u);
+  // The padding is taken out of the silence it stands for.
+  EXPECT_EQ(out[1].frames, 780u);
+  EXPECT_EQ(out[1].flags, marker);
+  EXPECT_TRUE(out[1].data.empty());
+
+  // A marker shorter than the padding disappears into it.
+  stage.Push(reinterpret_cast<const uint8_t*>(input.data()), 100, 0,
+             Collect(&out));
+  stage.Push(nullptr, 50, marker, Collect(&out));
+  EXPECT_TRUE(out.size() == 3);
+}
+
+TEST(StageCarriesFramesTheCodecHolds) {
+  EncoderStage stage(std::unique_ptr<AudioEncoder>(new LaggingEncoder()));
+  std::vector<int16_t> input(14);
+  std::vector<Emitted> out;
+  stage.Push(reinterpret_cast<const uint8_t*>(input.data()), 14,
+             kPacketDiscontinuity, Collect(&out));
+  // Frames from the silent encodes ride on the first real packet.
+  ASSERT_TRUE(out.size() == 1);
+  EXPECT_EQ(out[0].frames, 12u);
+  EXPECT_EQ(out[0].flags, static_cast<uint32_t>(kPacketDiscontinuity));
+  EXPECT_EQ(stage.failures(), 0u);
+
+  stage.Flush(Collect(&out));
+  ASSERT_TRUE(out.size() == 3);
+  EXPECT_EQ(out[1].frames, 4u);  // The padded partial frame.
+  EXPECT_EQ(out[2].frames, 0u);
+  EXPECT_EQ(out[2].data[0], 0xEE);
+}
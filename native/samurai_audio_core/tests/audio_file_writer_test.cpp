@@ -0,0 +1,251 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/audio_file_writer.h"
+#include "samurai_audio_core/wav_reader.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+std::string TempPath(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / ("samurai_" + name))
+      .string();
+}
+
+std::vector<uint8_t> ReadAll(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+}
+
+uint32_t U32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Bitwise reference for the Ogg page checksum, which is computed with its
+// own field (bytes 22..25) zeroed.
+uint32_t ReferenceOggCrc(const std::vector<uint8_t>& page) {
+  uint32_t crc = 0;
+  for (size_t i = 0; i < page.size(); ++i) {
+    const uint8_t byte = (i >= 22 && i < 26) ? 0 : page[i];
+    crc ^= static_cast<uint32_t>(byte) << 24;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+    }
+  }
+  return crc;
+}
+
+struct OggPage {
+  uint8_t type;
+  int64_t granule;
+  uint32_t sequence;
+  std::vector<std::vector<uint8_t>> packets;  // Completed on this page.
+  bool crc_ok;
+};
+
+std::vector<OggPage> ParseOgg(const std::vector<uint8_t>& file) {
+  std::vector<OggPage> pages;
+  size_t offset = 0;
+  std::vector<uint8_t> open_packet;
+  while (offset + 27 <= file.size() &&
+         std::memcmp(file.data() + offset, "OggS", 4) == 0) {
+    const uint8_t* p = file.data() + offset;
+    OggPage page;
+    page.type = p[5];
+    page.granule = static_cast<int64_t>(
+        U32(p + 6) | (static_cast<uint64_t>(U32(p + 10)) << 32));
+    page.sequence = U32(p + 18);
+    const size_t segments = p[26];
+    size_t body = 0;
+    for (size_t i = 0; i < segments; ++i) {
+      body += p[27 + i];
+    }
+    const size_t size = 27 + segments + body;
+    std::vector<uint8_t> bytes(p, p + size);
+    page.crc_ok = ReferenceOggCrc(bytes) == U32(p + 22);
+    const uint8_t* data = p + 27 + segments;
+    for (size_t i = 0; i < segments; ++i) {
+      open_packet.insert(open_packet.end(), data, data + p[27 + i]);
+      data += p[27 + i];
+      if (p[27 + i] < 255) {
+        page.packets.push_back(open_packet);
+        open_packet.clear();
+      }
+    }
+    pages.push_back(page);
+    offset += size;
+  }
+  return pages;
+}
+
+// Stands in for Opus: 20 ms frames, each encoded as a packet of |size_|
+// bytes holding its first sample's low byte.
+class FakeOpusEncoder : public AudioEncoder {
+ public:
+  FakeOpusEncoder(const AudioFormat& format, size_t size)
+      : format_(format), size_(size) {
+    config_.codec = CodecId::kOpus;
+  }
+
+  const EncoderConfig& config() const override { return config_; }
+  const AudioFormat& input_format() const override { return format_; }
+  std::string MimeType() const override { return "audio/opus"; }
+  uint32_t frame_size() const override { return format_.sample_rate / 50; }
+  size_t max_packet_bytes() const override { return size_; }
+
+  size_t Encode(const uint8_t* pcm, uint8_t* out) override {
+    std::memset(out, pcm[0], size_);
+    return size_;
+  }
+
+ private:
+  EncoderConfig config_;
+  AudioFormat format_;
+  size_t size_;
+};
+
+AudioFormat Mono16k() {
+  AudioFormat format;
+  format.sample_rate = 16000;
+  format.channels = 1;
+  format.sample_type = SampleType::kInt16;
+  return format;
+}
+
+}  // namespace
+
+TEST(WavIsReadableWhileRecordingAndFinalizedOnClose) {
+  const std::string path = TempPath("writer.wav");
+  AudioFileWriter writer;
+  AudioFormat format = Mono16k();
+  format.sample_type = SampleType::kFloat32;
+  ASSERT_TRUE(writer.Open(path, EncoderConfig(), format));
+  EXPECT_EQ(writer.MimeType(), "audio/wav");
+  std::vector<float> samples(1000, 0.25f);
+  EXPECT_TRUE(writer.Write(reinterpret_cast<const uint8_t*>(samples.data()),
+                           1000));
+  EXPECT_TRUE(writer.Write(nullptr, 600));  // Silence.
+  EXPECT_EQ(writer.frames(), 1600u);
+
+  EXPECT_TRUE(writer.Close());
+  EXPECT_EQ(writer.bytes(), 44u + 1600 * 4);
+
+  std::vector<uint8_t> bytes = ReadAll(path);
+  ASSERT_TRUE(bytes.size() == 44 + 1600 * 4);
+  EXPECT_EQ(U32(bytes.data() + 4), bytes.size() - 8);
+  EXPECT_EQ(U32(bytes.data() + 40), 1600u * 4);
+
+  WavReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_TRUE(reader.format() == format);
+  EXPECT_EQ(reader.frames(), 1600u);
+  const float* read = reinterpret_cast<const float*>(reader.samples());
+  EXPECT_TRUE(read[999] == 0.25f && read[1000] == 0.0f);
+  std::filesystem::remove(path);
+}
+
+TEST(UnfinishedWavStillOpens) {
+  const std::string path = TempPath("unfinished.wav");
+  {
+    AudioFileWriter writer;
+    ASSERT_TRUE(writer.Open(path, EncoderConfig(), Mono16k()));
+    std::vector<int16_t> samples(321, 5);
+    writer.Write(reinterpret_cast<const uint8_t*>(samples.data()), 321);
+    writer.Close();
+  }
+  // Undo the finalization, as if the recorder had crashed.
+  std::vector<uint8_t> bytes = ReadAll(path);
+  std::memset(bytes.data() + 4, 0, 4);
+  std::memset(bytes.data() + 40, 0, 4);
+  std::ofstream(path, std::ios::binary)
+      .write(reinterpret_cast<const char*>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+  WavReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_EQ(reader.frames(), 321u);
+  std::filesystem::remove(path);
+}
+
+TEST(OpusGoesIntoOggPages) {
+  const std::string path = TempPath("writer.opus");
+  AudioFileWriter writer;
+  // 600-byte packets span several lacing values and force page breaks.
+  ASSERT_TRUE(writer.Open(path, std::unique_ptr<AudioEncoder>(
+                                    new FakeOpusEncoder(Mono16k(), 600))));
+  EXPECT_EQ(writer.MimeType(), "audio/ogg;codecs=opus");
+  std::vector<int16_t> samples(16000);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i] = static_cast<int16_t>(i / 320);  // Packet index.
+  }
+  ASSERT_TRUE(writer.Write(reinterpret_cast<const uint8_t*>(samples.data()),
+                           16000));
+  ASSERT_TRUE(writer.Write(reinterpret_cast<const uint8_t*>(samples.data()),
+                           100));
+  ASSERT_TRUE(writer.Close());
+
+  std::vector<OggPage> pages = ParseOgg(ReadAll(path));
+  ASSERT_TRUE(pages.size() >= 4);
+  for (size_t i = 0; i < pages.size(); ++i) {
+    EXPECT_TRUE(pages[i].crc_ok);
+    EXPECT_EQ(pages[i].sequence, i);
+  }
+  // Headers first, each alone on its page.
+  EXPECT_EQ(pages[0].type, 0x02);
+  ASSERT_TRUE(pages[0].packets.size() == 1);
+  EXPECT_TRUE(std::memcmp(pages[0].packets[0].data(), "OpusHead", 8) == 0);
+  EXPECT_EQ(pages[0].packets[0][9], 1);  // Channels.
+  EXPECT_EQ(U32(pages[0].packets[0].data() + 12), 16000u);
+  ASSERT_TRUE(pages[1].packets.size() == 1);
+  EXPECT_TRUE(std::memcmp(pages[1].packets[0].data(), "OpusTags", 8) == 0);
+
+  // 50 full frames plus the padded one holding the last 100 frames.
+  std::vector<std::vector<uint8_t>> audio;
+  for (size_t i = 2; i < pages.size(); ++i) {
+    audio.insert(audio.end(), pages[i].packets.begin(),
+                 pages[i].packets.end());
+  }
+  ASSERT_TRUE(audio.size() == 51);
+  for (size_t i = 0; i < 50; ++i) {
+    EXPECT_TRUE(audio[i].size() == 600 && audio[i][0] == i);
+  }
+  // The end-of-stream granule trims the padding: 312 + 16100 * 3.
+  EXPECT_EQ(pages.back().type & 0x04, 0x04);
+  EXPECT_EQ(pages.back().granule, 312 + 16100 * 3);
+  // Earlier pages count whole frames at 48 kHz.
+  EXPECT_EQ(pages[2].granule % 960, 312);
+  std::filesystem::remove(path);
+}
+
+TEST(OpenFailsForUnusableTargets) {
+  AudioFileWriter writer;
+  EXPECT_TRUE(!writer.Open("/nonexistent/dir/out.wav", EncoderConfig(),
+                           Mono16k()));
+  EXPECT_TRUE(!writer.is_open());
+  EXPECT_TRUE(!writer.Close());
+  EXPECT_TRUE(!writer.Write(nullptr, 10));
+
+  EncoderConfig mp3;
+  mp3.codec = CodecId::kMp3;
+  const std::string path = TempPath("writer.mp3");
+  const bool opened = writer.Open(path, mp3, Mono16k());
+  EXPECT_TRUE(opened == AudioCodecAvailable(CodecId::kMp3));
+  if (opened) {
+    std::vector<int16_t> samples(16000, 0);
+    EXPECT_TRUE(writer.Write(reinterpret_cast<const uint8_t*>(samples.data()),
+                             16000));
+    EXPECT_TRUE(writer.Close());
+    EXPECT_TRUE(writer.bytes() > 0);
+  }
+  std::filesystem::remove(path);
+  EXPECT_EQ(std::string(AudioFileExtension(CodecId::kOpus)), "opus");
+}
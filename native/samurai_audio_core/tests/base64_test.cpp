@@ -0,0 +1,130 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/base64.h"
+#include "test_support.h"
+
+using samurai::Base64Decode;
+using samurai::Base64Encode;
+using samurai::Base64Impl;
+
+namespace {
+
+// The loop AudioCaptureHandler::OnAudioData used before the encoder moved
+// into the core; every implementation must match it byte for byte.
+std::string ReferenceEncode(const uint8_t* data, size_t size) {
+  const char base64_chars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::string base64;
+  base64.reserve(((size + 2) / 3) * 4);
+
+  for (size_t i = 0; i < size; i += 3) {
+    uint32_t octet_a = i < size ? data[i] : 0;
+    uint32_t octet_b = i + 1 < size ? data[i + 1] : 0;
+    uint32_t octet_c = i + 2 < size ? data[i + 2] : 0;
+
+    uint32_t triple = (octet_a << 16) | (octet_b << 8) | octet_c;
+
+    base64 += base64_chars[(triple >> 18) & 0x3F];
+    base64 += base64_chars[(triple >> 12) & 0x3F];
+    base64 += (i + 1 < size) ? base64_chars[(triple >> 6) & 0x3F] : '=';
+    base64 += (i + 2 < size) ? base64_chars[triple & 0x3F] : '=';
+  }
+  return base64;
+}
+
+const Base64Impl kAllImpls[] = {Base64Impl::kScalar, Base64Impl::kSsse3,
+                                Base64Impl::kAvx2, Base64Impl::kNeon};
+
+std::string Encode(const std::string& text) {
+  return Base64Encode(reinterpret_cast<const uint8_t*>(text.data()),
+                      text.size());
+}
+
+}  // namespace
+
+TEST(EncodesRfc4648Vectors) {
+  EXPECT_EQ(Encode(""), "");
+  EXPECT_EQ(Encode("f"), "Zg==");
+  EXPECT_EQ(Encode("fo"), "Zm8=");
+  EXPECT_EQ(Encode("foo"), "Zm9v");
+  EXPECT_EQ(Encode("foob"), "Zm9vYg==");
+  EXPECT_EQ(Encode("fooba"), "Zm9vYmE=");
+  EXPECT_EQ(Encode("foobar"), "Zm9vYmFy");
+}
+
+TEST(EncodesAllByteValues) {
+  std::vector<uint8_t> bytes(256);
+  for (int i = 0; i < 256; ++i) {
+    bytes[i] = static_cast<uint8_t>(i);
+  }
+  std::string encoded = Base64Encode(bytes.data(), bytes.size());
+  EXPECT_EQ(encoded.size(), samurai::Base64EncodedSize(bytes.size()));
+  EXPECT_EQ(encoded.substr(0, 8), "AAECAwQF");
+  EXPECT_EQ(encoded.substr(encoded.size() - 8), "/P3+/w==");
+}
+
+TEST(ReusesOutputString) {
+  const uint8_t data[] = {0xde, 0xad, 0xbe, 0xef};
+  std::string out = "stale contents that are longer than the result";
+  Base64Encode(data, sizeof(data), &out);
+  EXPECT_EQ(out, "3q2+7w==");
+}
+
+TEST(AllImplementationsMatchReference) {
+  std::mt19937 rng(1234);
+  std::vector<uint8_t> data(20000);
+  for (auto& byte : data) {
+    byte = static_cast<uint8_t>(rng());
+  }
+
+  // Every length up to a few SIMD blocks, plus packet-sized inputs.
+  std::vector<size_t> sizes;
+  for (size_t size = 0; size <= 200; ++size) {
+    sizes.push_back(size);
+  }
+  for (size_t size : {1764u, 3528u, 17640u, 19999u}) {
+    sizes.push_back(size);
+  }
+
+  for (Base64Impl impl : kAllImpls) {
+    if (!samurai::Base64ImplSupported(impl)) {
+      std::printf("  skipping unsupported %s\n", samurai::Base64ImplName(impl));
+      continue;
+    }
+    bool all_match = true;
+    for (size_t size : sizes) {
+      std::string expected = ReferenceEncode(data.data(), size);
+      std::string actual(samurai::Base64EncodedSize(size), '\0');
+      EXPECT_TRUE(samurai::Base64EncodeWith(impl, data.data(), size, &actual[0]));
+      all_match = all_match && actual == expected;
+    }
+    EXPECT_TRUE(all_match);
+  }
+  EXPECT_TRUE(samurai::Base64ImplSupported(samurai::Base64BestImpl()));
+}
+
+TEST(DecodeRoundTrips) {
+  std::mt19937 rng(99);
+  for (size_t size = 0; size < 100; ++size) {
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> decoded;
+    EXPECT_TRUE(Base64Decode(Base64Encode(data.data(), data.size()), &decoded));
+    EXPECT_TRUE(decoded == data);
+  }
+}
+
+TEST(DecodeRejectsMalformedInput) {
+  std::vector<uint8_t> decoded;
+  EXPECT_TRUE(!Base64Decode(std::string("Zm9"), &decoded));
+  EXPECT_TRUE(!Base64Decode(std::string("Zm9*"), &decoded));
+  EXPECT_TRUE(!Base64Decode(std::string("Zg==Zm9v"), &decoded));
+  EXPECT_TRUE(!Base64Decode(std::string("Z=9v"), &decoded));
+  EXPECT_TRUE(Base64Decode(std::string("Zm9vYg=="), &decoded));
+  EXPECT_TRUE(decoded == std::vector<uint8_t>({'f', 'o', 'o', 'b'}));
+}
@@ -0,0 +1,583 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/synthetic_capture_backend.h"
+#include "samurai_audio_core/wav_reader.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+std::unique_ptr<CaptureEngine> MakeEngine(
+    const SyntheticCaptureBackend::Options& options) {
+  auto engine = std::make_unique<CaptureEngine>(
+      std::make_unique<SyntheticCaptureBackend>(options));
+  engine->Initialize();
+  return engine;
+}
+
+bool WaitFor(const std::atomic<int>& counter, int target) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (counter.load() < target) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(DeliversPacketsSizedInBytes) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  // At the requested rate, so packets are not resampled.
+  options.format.sample_rate = 44100;
+  auto engine = MakeEngine(options);
+
+  std::atomic<int> packets{0};
+  std::atomic<bool> sizes_ok{true};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", [&](const AudioPacket& p) {
+    if (p.stream != StreamKind::kSystem ||
+        p.sequence != static_cast<uint64_t>(packets.load()) ||
+        p.size != static_cast<size_t>(p.frames) * p.format.BlockAlign() ||
+        p.frames != options.packet_frames) {
+      sizes_ok = false;
+    }
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 10));
+  engine->Stop(StreamKind::kSystem);
+  EXPECT_TRUE(sizes_ok.load());
+  EXPECT_TRUE(!engine->IsCapturing(StreamKind::kSystem));
+}
+
+TEST(RejectsSecondStartOfSameStream) {
+  auto engine = MakeEngine(SyntheticCaptureBackend::Options());
+  EXPECT_TRUE(engine->Start(StreamKind::kMicrophone, "", nullptr));
+  EXPECT_TRUE(!engine->Start(StreamKind::kMicrophone, "", nullptr));
+  engine->Stop(StreamKind::kMicrophone);
+  EXPECT_TRUE(engine->Start(StreamKind::kMicrophone, "", nullptr));
+}
+
+TEST(StoppingOneStreamLeavesTheOtherRunning) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+
+  std::atomic<int> mic_packets{0};
+  engine->Start(StreamKind::kSystem, "", nullptr);
+  engine->Start(StreamKind::kMicrophone, "",
+                [&](const AudioPacket&) { ++mic_packets; });
+  engine->Stop(StreamKind::kSystem);
+
+  int seen = mic_packets.load();
+  EXPECT_TRUE(engine->IsCapturing(StreamKind::kMicrophone));
+  EXPECT_TRUE(WaitFor(mic_packets, seen + 5));
+}
+
+TEST(ForwardsSilentFlag) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  options.silent_every = 2;
+  auto engine = MakeEngine(options);
+
+  std::atomic<int> packets{0};
+  std::atomic<int> silent{0};
+  engine->Start(StreamKind::kSystem, "", [&](const AudioPacket& p) {
+    if (p.flags & kPacketSilent) {
+      ++silent;
+    }
+    ++packets;
+  });
+  EXPECT_TRUE(WaitFor(packets, 20));
+  engine->Stop(StreamKind::kSystem);
+  EXPECT_TRUE(silent.load() > 0);
+  EXPECT_TRUE(silent.load() < packets.load());
+}
+
+TEST(SlowConsumerCausesOverrunsNotCaptureStalls) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  CaptureEngine::Options engine_options;
+  engine_options.settings.ring_slots = 4;
+  CaptureEngine engine(std::make_unique<SyntheticCaptureBackend>(options),
+                       engine_options);
+  engine.Initialize();
+
+  std::atomic<int> delivered{0};
+  engine.Start(StreamKind::kSystem, "", [&](const AudioPacket&) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ++delivered;
+  });
+  EXPECT_TRUE(WaitFor(delivered, 3));
+  engine.Stop(StreamKind::kSystem);
+
+  // Capture kept pulling packets while the consumer slept: the ones the
+  // full ring could not take were counted as overruns, not waited for.
+  CaptureStats stats = engine.GetStats(StreamKind::kSystem);
+  EXPECT_TRUE(stats.overruns > 0);
+  EXPECT_EQ(stats.dropped_frames, stats.overruns * options.packet_frames);
+  EXPECT_EQ(stats.packets_captured, stats.packets_delivered + stats.overruns);
+}
+
+TEST(CallbacksMayQueryTheEngineWhileItStops) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+  std::atomic<int> delivered{0};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", [&](const AudioPacket&) {
+    StreamInfo info;
+    engine->GetStreamInfo(StreamKind::kSystem, &info);
+    ++delivered;
+  }));
+  EXPECT_TRUE(WaitFor(delivered, 10));
+  // Joins the delivery thread while the callback keeps taking the lock.
+  engine->Stop(StreamKind::kSystem);
+  EXPECT_TRUE(!engine->IsCapturing(StreamKind::kSystem));
+}
+
+TEST(StartReportsDeviceOpenFailure) {
+  SyntheticCaptureBackend::Options options;
+  options.packet_frames = 0;  // Makes OpenStream fail.
+  auto engine = MakeEngine(options);
+  EXPECT_TRUE(!engine->Start(StreamKind::kSystem, "", nullptr));
+  EXPECT_TRUE(!engine->IsCapturing(StreamKind::kSystem));
+  StreamInfo info;
+  EXPECT_TRUE(!engine->GetStreamInfo(StreamKind::kSystem, &info));
+}
+
+TEST(RefusesStreamsThatAreNotCaptured) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+  bool called = false;
+  EXPECT_TRUE(!engine->Start(StreamKind::kAligned, "",
+                             [&](const AudioPacket&) { called = true; }));
+  EXPECT_TRUE(!engine->IsCapturing(StreamKind::kAligned));
+  EXPECT_EQ(engine->GetStats(StreamKind::kAligned).packets_captured, 0u);
+  StreamInfo info;
+  EXPECT_TRUE(!engine->GetStreamInfo(StreamKind::kAligned, &info));
+  engine->Stop(StreamKind::kAligned);
+  EXPECT_TRUE(!called);
+  // The captured streams are untouched.
+  EXPECT_TRUE(!engine->IsCapturing(StreamKind::kSystem));
+  EXPECT_TRUE(!engine->IsCapturing(StreamKind::kMicrophone));
+}
+
+TEST(ConvertsDeviceFloatToRequestedFormat) {
+  SyntheticCaptureBackend::Options options;  // 48 kHz float stereo.
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+
+  std::atomic<int> packets{0};
+  std::atomic<int> peak{0};
+  std::atomic<bool> format_ok{true};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", [&](const AudioPacket& p) {
+    if (p.format.sample_type != SampleType::kInt16 ||
+        p.size != static_cast<size_t>(p.frames) * 4) {
+      format_ok = false;
+    }
+    const int16_t* samples = reinterpret_cast<const int16_t*>(p.data);
+    for (size_t i = 0; i < p.size / 2; ++i) {
+      int v = samples[i] < 0 ? -samples[i] : samples[i];
+      if (v > peak.load()) {
+        peak = v;
+      }
+    }
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 10));
+  engine->Stop(StreamKind::kSystem);
+
+  StreamInfo info;
+  ASSERT_TRUE(engine->GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_TRUE(info.device_format.sample_type == SampleType::kFloat32);
+  EXPECT_TRUE(info.format.sample_type == SampleType::kInt16);
+  EXPECT_EQ(info.device_format.sample_rate, 48000u);
+  EXPECT_EQ(info.format.sample_rate, 44100u);
+  EXPECT_TRUE(format_ok.load());
+  // The synthetic tone peaks at 0.25 full scale, i.e. ~8192.
+  EXPECT_NEAR(peak.load(), 8192, 16);
+}
+
+TEST(ResamplesToRequestedRateAcrossPackets) {
+  SyntheticCaptureBackend::Options options;  // 48 kHz, 480-frame packets.
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 16000;
+  settings.resampler_quality = ResamplerQuality::kHigh;
+  std::atomic<int> packets{0};
+  std::atomic<uint64_t> frames{0};
+  std::atomic<int> peak{0};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    frames += p.frames;
+    const int16_t* samples = reinterpret_cast<const int16_t*>(p.data);
+    for (size_t i = 0; i < p.size / 2; ++i) {
+      int v = samples[i] < 0 ? -samples[i] : samples[i];
+      if (v > peak.load()) {
+        peak = v;
+      }
+    }
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 50));
+  engine->Stop(StreamKind::kSystem);
+
+  StreamInfo info;
+  ASSERT_TRUE(engine->GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_EQ(info.format.sample_rate, 16000u);
+  // 20 ms slots at the output rate.
+  EXPECT_EQ(info.delivery_frames, 320u);
+  // Every queued device packet yields a third of its frames, less the
+  // lookahead still held when the stream stopped.
+  CaptureStats stats = engine->GetStats(StreamKind::kSystem);
+  const uint64_t expected =
+      (stats.packets_captured * options.packet_frames - stats.dropped_frames) /
+      3;
+  EXPECT_TRUE(frames.load() <= expected);
+  EXPECT_TRUE(frames.load() + 64 >= expected);
+  // The tone is well inside the 8 kHz band, so its level survives.
+  EXPECT_NEAR(peak.load(), 8192, 16);
+}
+
+TEST(ReframesDeliveryToFixedDuration) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  // 10 ms device packets at the requested rate.
+  options.format.sample_rate = 44100;
+  options.packet_frames = 441;
+  auto engine = MakeEngine(options);
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();  // 44.1 kHz.
+  settings.frame_ms = 20;
+  std::atomic<int> packets{0};
+  std::atomic<bool> sizes_ok{true};
+  std::atomic<bool> aligned{true};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    if (p.frames != 882 ||
+        p.size != static_cast<size_t>(p.frames) * p.format.BlockAlign()) {
+      sizes_ok = false;
+    }
+    if (reinterpret_cast<uintptr_t>(p.data) % 64 != 0) {
+      aligned = false;
+    }
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 20));
+  // Stopping may flush one short frame; count only what came before.
+  const bool ok = sizes_ok.load() && aligned.load();
+  engine->Stop(StreamKind::kSystem);
+  EXPECT_TRUE(ok);
+
+  StreamInfo info;
+  ASSERT_TRUE(engine->GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_EQ(info.frame_frames, 882u);
+}
+
+TEST(DownmixesToMonoBeforeDelivery) {
+  SyntheticCaptureBackend::Options options;  // Same tone on both channels.
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.channel_map = ChannelMap::Downmix();
+  std::atomic<int> packets{0};
+  std::atomic<int> peak{0};
+  std::atomic<bool> format_ok{true};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    if (p.format.channels != 1 || p.size != static_cast<size_t>(p.frames) * 2) {
+      format_ok = false;
+    }
+    const int16_t* samples = reinterpret_cast<const int16_t*>(p.data);
+    for (size_t i = 0; i < p.size / 2; ++i) {
+      int v = samples[i] < 0 ? -samples[i] : samples[i];
+      if (v > peak.load()) {
+        peak = v;
+      }
+    }
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 10));
+  engine->Stop(StreamKind::kSystem);
+
+  StreamInfo info;
+  ASSERT_TRUE(engine->GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_EQ(info.device_format.channels, 2u);
+  EXPECT_EQ(info.format.channels, 1u);
+  EXPECT_TRUE(info.channel_mode == ChannelMode::kDownmix);
+  EXPECT_TRUE(format_ok.load());
+  EXPECT_NEAR(peak.load(), 8192, 16);
+}
+
+TEST(ChannelMapThatDoesNotFitFallsBackToDeviceLayout) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.channel_map = ChannelMap::Select(5);
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings, nullptr));
+  engine->Stop(StreamKind::kSystem);
+
+  StreamInfo info;
+  ASSERT_TRUE(engine->GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_EQ(info.format.channels, 2u);
+  EXPECT_TRUE(info.channel_mode == ChannelMode::kPassthrough);
+}
+
+TEST(DropPolicyDeliversSpeechOnly) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  options.silent_every = 2;
+  auto engine = MakeEngine(options);
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 48000;
+  settings.vad = true;
+  settings.silence_policy = SilencePolicy::kDrop;
+  std::atomic<int> packets{0};
+  std::atomic<int> not_speech{0};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    if (p.flags & (kPacketSilent | kPacketNoSpeech | kPacketSilenceMarker)) {
+      ++not_speech;
+    }
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 10));
+  engine->Stop(StreamKind::kSystem);
+
+  CaptureStats stats = engine->GetStats(StreamKind::kSystem);
+  EXPECT_EQ(not_speech.load(), 0);
+  EXPECT_TRUE(stats.silent_packets > 0);
+  EXPECT_EQ(stats.suppressed_frames,
+            stats.silent_packets * options.packet_frames);
+}
+
+TEST(MarkerPolicyReplacesSilenceRuns) {
+  // Paced, so the consumer keeps up and no packet is lost to overruns.
+  SyntheticCaptureBackend::Options options;
+  options.silent_every = 2;
+  auto engine = MakeEngine(options);
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 48000;
+  settings.vad = true;
+  settings.silence_policy = SilencePolicy::kMarkers;
+  std::atomic<int> packets{0};
+  std::atomic<int> markers{0};
+  std::atomic<bool> order_ok{true};
+  bool last_was_marker = false;
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    const bool marker = (p.flags & kPacketSilenceMarker) != 0;
+    if (marker) {
+      // One silent device packet between tones; never two markers in a
+      // row, and never samples.
+      if (p.size != 0 || p.frames != options.packet_frames ||
+          !(p.flags & kPacketNoSpeech) || last_was_marker) {
+        order_ok = false;
+      }
+      ++markers;
+    } else if (p.flags & kPacketSilent) {
+      order_ok = false;
+    }
+    last_was_marker = marker;
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(markers, 5));
+  engine->Stop(StreamKind::kSystem);
+  EXPECT_TRUE(order_ok.load());
+}
+
+TEST(LongSilenceIsSplitIntoBoundedMarkers) {
+  SyntheticCaptureBackend::Options options;
+  options.silent_every = 1;
+  auto engine = MakeEngine(options);
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 48000;
+  settings.vad = true;
+  settings.silence_policy = SilencePolicy::kMarkers;
+  settings.silence_marker_ms = 100;
+  std::atomic<int> markers{0};
+  std::atomic<bool> sizes_ok{true};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    if (!(p.flags & kPacketSilenceMarker) || p.frames > 4800) {
+      sizes_ok = false;
+    }
+    ++markers;
+  }));
+  EXPECT_TRUE(WaitFor(markers, 3));
+  engine->Stop(StreamKind::kSystem);
+  EXPECT_TRUE(sizes_ok.load());
+}
+
+namespace {
+
+// Writes each frame's length as the "encoded" packet.
+class FrameCountEncoder : public AudioEncoder {
+ public:
+  FrameCountEncoder(const EncoderConfig& config, const AudioFormat& format)
+      : config_(config), format_(format) {}
+  const EncoderConfig& config() const override { return config_; }
+  const AudioFormat& input_format() const override { return format_; }
+  std::string MimeType() const override { return "audio/x-count"; }
+  uint32_t frame_size() const override {
+    return FramesForDuration(format_, config_.frame_ms);
+  }
+  size_t max_packet_bytes() const override { return 4; }
+  size_t Encode(const uint8_t* pcm, uint8_t* out) override {
+    const uint32_t frames = frame_size();
+    std::memcpy(out, &frames, 4);
+    return 4;
+  }
+
+ private:
+  EncoderConfig config_;
+  AudioFormat format_;
+};
+
+}  // namespace
+
+TEST(EncodesOnDeliveryThread) {
+  SyntheticCaptureBackend::Options backend_options;
+  backend_options.realtime = false;
+  CaptureEngine::Options options;
+  options.encoder_factory = [](const EncoderConfig& config,
+                               const AudioFormat& format) {
+    return std::unique_ptr<AudioEncoder>(
+        new FrameCountEncoder(config, format));
+  };
+  CaptureEngine engine(
+      std::make_unique<SyntheticCaptureBackend>(backend_options), options);
+  ASSERT_TRUE(engine.Initialize());
+
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.encoder.codec = CodecId::kOpus;
+  settings.encoder.frame_ms = 40;
+  std::atomic<int> packets{0};
+  std::atomic<bool> packets_ok{true};
+  EXPECT_TRUE(engine.Start(StreamKind::kSystem, "", settings,
+                           [&](const AudioPacket& p) {
+    uint32_t encoded = 0;
+    if (p.size == 4) {
+      std::memcpy(&encoded, p.data, 4);
+    }
+    if (p.codec != CodecId::kOpus || p.frames != 1764 || encoded != 1764 ||
+        p.sequence != static_cast<uint64_t>(packets.load())) {
+      packets_ok = false;
+    }
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 10));
+  engine.Stop(StreamKind::kSystem);
+  EXPECT_TRUE(packets_ok.load());
+
+  StreamInfo info;
+  ASSERT_TRUE(engine.GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_TRUE(info.encoder.codec == CodecId::kOpus);
+  EXPECT_TRUE(info.mime_type == "audio/x-count");
+  EXPECT_TRUE(engine.GetStats(StreamKind::kSystem).encoded_packets >= 10);
+}
+
+TEST(UnavailableCodecFallsBackToPcm) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+
+  // Opus has no 44.1 kHz mode, whether or not it is built in.
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.encoder.codec = CodecId::kOpus;
+  std::atomic<bool> pcm{true};
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    if (p.codec != CodecId::kPcm) {
+      pcm = false;
+    }
+  }));
+  engine->Stop(StreamKind::kSystem);
+
+  StreamInfo info;
+  ASSERT_TRUE(engine->GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_TRUE(info.encoder.codec == CodecId::kPcm);
+  EXPECT_TRUE(info.mime_type == PcmMimeType(info.format));
+  EXPECT_TRUE(pcm.load());
+}
+
+TEST(RecordsDeliveredStreamUntilStop) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  auto engine = MakeEngine(options);
+
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.recording.path = (dir / "samurai_engine_rec.wav").string();
+  settings.recording.wav_path = (dir / "samurai_engine_copy.wav").string();
+  std::atomic<int> packets{0};
+  std::atomic<uint64_t> delivered_frames{0};
+  ASSERT_TRUE(engine->Start(StreamKind::kSystem, "", settings,
+                            [&](const AudioPacket& p) {
+    delivered_frames += p.frames;
+    ++packets;
+  }));
+  EXPECT_TRUE(WaitFor(packets, 20));
+  engine->Stop(StreamKind::kSystem);
+
+  StreamInfo info;
+  ASSERT_TRUE(engine->GetStreamInfo(StreamKind::kSystem, &info));
+  EXPECT_EQ(info.recording_mime_type, "audio/wav");
+  // Everything delivered is on disk, and the file is final on return.
+  const CaptureStats stats = engine->GetStats(StreamKind::kSystem);
+  EXPECT_EQ(stats.recorded_frames, delivered_frames.load());
+  EXPECT_TRUE(!stats.recording_failed);
+  for (const std::string& path :
+       {settings.recording.path, settings.recording.wav_path}) {
+    WavReader reader;
+    ASSERT_TRUE(reader.Open(path));
+    EXPECT_TRUE(reader.format() == info.format);
+    EXPECT_EQ(reader.frames(), delivered_frames.load());
+  }
+  std::filesystem::remove(settings.recording.path);
+  std::filesystem::remove(settings.recording.wav_path);
+}
+
+TEST(StartFailsWhenRecordingCannotBeCreated) {
+  auto engine = MakeEngine(SyntheticCaptureBackend::Options());
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.recording.path = "/nonexistent/dir/samurai.wav";
+  EXPECT_TRUE(!engine->Start(StreamKind::kSystem, "", settings, nullptr));
+  EXPECT_TRUE(!engine->IsCapturing(StreamKind::kSystem));
+
+  // Opus has no 44.1 kHz mode; a recording does not fall back to PCM.
+  settings.recording.path =
+      (std::filesystem::temp_directory_path() / "samurai_rec.opus").string();
+  settings.recording.encoder.codec = CodecId::kOpus;
+  EXPECT_TRUE(!engine->Start(StreamKind::kSystem, "", settings, nullptr));
+  EXPECT_TRUE(engine->Start(StreamKind::kSystem, "", nullptr));
+}
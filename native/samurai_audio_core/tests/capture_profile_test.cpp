@@ -0,0 +1,74 @@
+#include <memory>
+
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/capture_profile.h"
+#include "samurai_audio_core/synthetic_capture_backend.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+StreamInfo StartWithProfile(CaptureProfile profile) {
+  CaptureEngine engine(std::make_unique<SyntheticCaptureBackend>());
+  engine.Initialize();
+  StreamInfo info;
+  if (engine.Start(StreamKind::kMicrophone, "",
+                   CaptureSettingsForProfile(profile, DefaultOutputFormat()),
+                   nullptr)) {
+    engine.GetStreamInfo(StreamKind::kMicrophone, &info);
+  }
+  engine.Stop(StreamKind::kMicrophone);
+  return info;
+}
+
+}  // namespace
+
+TEST(ParsesProfileNames) {
+  CaptureProfile profile = CaptureProfile::kBalanced;
+  EXPECT_TRUE(ParseCaptureProfile("realtime", &profile));
+  EXPECT_TRUE(profile == CaptureProfile::kRealtime);
+  EXPECT_TRUE(ParseCaptureProfile("bulk", &profile));
+  EXPECT_TRUE(profile == CaptureProfile::kBulk);
+  EXPECT_TRUE(!ParseCaptureProfile("fast", &profile));
+  EXPECT_TRUE(profile == CaptureProfile::kBulk);
+  for (CaptureProfile p : {CaptureProfile::kRealtime, CaptureProfile::kBalanced,
+                           CaptureProfile::kBulk}) {
+    EXPECT_TRUE(ParseCaptureProfile(CaptureProfileName(p), &profile));
+    EXPECT_TRUE(profile == p);
+  }
+}
+
+TEST(BulkProfileResamplesAtHighQuality) {
+  EXPECT_TRUE(CaptureSettingsForProfile(CaptureProfile::kBulk,
+                                        DefaultOutputFormat())
+                  .resampler_quality == ResamplerQuality::kHigh);
+  EXPECT_TRUE(CaptureSettingsForProfile(CaptureProfile::kRealtime,
+                                        DefaultOutputFormat())
+                  .resampler_quality == ResamplerQuality::kMedium);
+}
+
+TEST(ProfilesTradeLatencyForQueueDepth) {
+  StreamInfo realtime = StartWithProfile(CaptureProfile::kRealtime);
+  StreamInfo balanced = StartWithProfile(CaptureProfile::kBalanced);
+  StreamInfo bulk = StartWithProfile(CaptureProfile::kBulk);
+
+  // The synthetic device honours the requested period exactly.
+  EXPECT_EQ(realtime.expected_latency_ms, 10u);
+  EXPECT_TRUE(realtime.scheduling == SchedulingMode::kEventDriven);
+  EXPECT_TRUE(bulk.scheduling == SchedulingMode::kTimer);
+  // Two polling periods plus 36 frames (0.75 ms) of resampler lookahead.
+  EXPECT_EQ(bulk.expected_latency_ms, 201u);
+
+  EXPECT_TRUE(realtime.expected_latency_ms <= balanced.expected_latency_ms);
+  EXPECT_TRUE(balanced.expected_latency_ms < bulk.expected_latency_ms);
+  EXPECT_TRUE(realtime.queue_duration_ms < balanced.queue_duration_ms);
+  EXPECT_TRUE(balanced.queue_duration_ms < bulk.queue_duration_ms);
+  EXPECT_TRUE(realtime.buffer_duration_ms < bulk.buffer_duration_ms);
+  EXPECT_TRUE(realtime.delivery_frames < bulk.delivery_frames);
+
+  // Delivery slots are sized in the delivered format (44.1 kHz here).
+  EXPECT_EQ(realtime.delivery_frames, 441u);
+  EXPECT_EQ(realtime.queue_slots, 16u);
+  EXPECT_EQ(realtime.queue_duration_ms, 160u);
+}
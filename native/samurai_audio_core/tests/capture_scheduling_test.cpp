@@ -0,0 +1,248 @@
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/capture_clock.h"
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/synthetic_capture_backend.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr int64_t kMillis = 1000000;
+
+// Runs one real-time synthetic stream on simulated time until |packets|
+// device packets were captured, and returns the engine's stats.
+CaptureStats RunSimulated(uint32_t packet_frames, const StreamConfig& config,
+                          uint64_t packets) {
+  SimulatedCaptureClock clock(1000 * kMillis);
+
+  SyntheticCaptureBackend::Options backend_options;
+  backend_options.packet_frames = packet_frames;
+  backend_options.clock = &clock;
+
+  CaptureEngine::Options engine_options;
+  engine_options.clock = &clock;
+
+  CaptureEngine engine(
+      std::make_unique<SyntheticCaptureBackend>(backend_options),
+      engine_options);
+  engine.Initialize();
+  CaptureSettings settings;
+  settings.stream = config;
+  engine.Start(StreamKind::kSystem, "", settings, nullptr);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (engine.GetStats(StreamKind::kSystem).packets_captured < packets &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  engine.Stop(StreamKind::kSystem);
+  return engine.GetStats(StreamKind::kSystem);
+}
+
+}  // namespace
+
+TEST(SimulatedClockOnlyMovesWhenSleeping) {
+  SimulatedCaptureClock clock(5);
+  EXPECT_EQ(clock.NowNanos(), 5);
+  clock.SleepFor(10);
+  clock.SleepUntil(100);
+  clock.SleepUntil(50);  // In the past: no-op.
+  EXPECT_EQ(clock.NowNanos(), 100);
+  EXPECT_EQ(clock.sleeps(), 2u);
+}
+
+TEST(EventDrivenWakesOncePerPacketWithNoLatency) {
+  StreamConfig config;
+  config.scheduling = SchedulingMode::kEventDriven;
+  // 240 frames at 48 kHz: a 5 ms device period.
+  CaptureStats stats = RunSimulated(240, config, 200);
+
+  ASSERT_TRUE(stats.packets_captured >= 200);
+  EXPECT_EQ(stats.latency_samples, stats.packets_captured);
+  EXPECT_EQ(stats.max_latency_ns, 0u);
+  EXPECT_EQ(stats.idle_wakeups, 0u);
+  // At most one extra wakeup, the one interrupted by Stop().
+  EXPECT_TRUE(stats.wakeups <= stats.packets_captured + 1);
+}
+
+TEST(TimerPollingAddsUpToOnePeriodOfLatency) {
+  StreamConfig config;
+  config.scheduling = SchedulingMode::kTimer;
+  config.device_period_ms = 10;
+  CaptureStats stats = RunSimulated(240, config, 200);
+
+  ASSERT_TRUE(stats.packets_captured >= 200);
+  // Each 10 ms poll finds two 5 ms packets; the older one waited 5 ms.
+  EXPECT_EQ(stats.max_latency_ns, static_cast<uint64_t>(5 * kMillis));
+  EXPECT_NEAR(static_cast<double>(stats.total_latency_ns) /
+                  stats.latency_samples,
+              2.5 * kMillis, 0.1 * kMillis);
+}
+
+TEST(FastTimerPollingWakesIdle) {
+  StreamConfig config;
+  config.scheduling = SchedulingMode::kTimer;
+  config.device_period_ms = 1;
+  CaptureStats stats = RunSimulated(240, config, 100);
+
+  ASSERT_TRUE(stats.packets_captured >= 100);
+  EXPECT_TRUE(stats.max_latency_ns < static_cast<uint64_t>(kMillis));
+  // Four of every five 1 ms polls find nothing.
+  EXPECT_TRUE(stats.idle_wakeups >= 3 * stats.packets_captured);
+}
+
+namespace {
+
+struct Stamp {
+  uint64_t position;
+  int64_t time_ns;
+  uint32_t frames;
+};
+
+// Runs a real-time synthetic stream (48 kHz, 5 ms packets, the device
+// clock |clock_ppm| fast) on simulated time, starting at 1 s, and collects
+// the delivered timestamps. Fills |stats| if not null.
+std::vector<Stamp> CollectTimestamps(const CaptureSettings& settings,
+                                     double clock_ppm, size_t count,
+                                     CaptureStats* stats) {
+  SimulatedCaptureClock clock(1000 * kMillis);
+  SyntheticCaptureBackend::Options backend_options;
+  backend_options.packet_frames = 240;
+  backend_options.clock = &clock;
+  backend_options.system_clock_ppm = clock_ppm;
+  CaptureEngine::Options engine_options;
+  engine_options.clock = &clock;
+  CaptureEngine engine(
+      std::make_unique<SyntheticCaptureBackend>(backend_options),
+      engine_options);
+  engine.Initialize();
+
+  std::mutex mutex;
+  std::vector<Stamp> stamps;
+  engine.Start(StreamKind::kSystem, "", settings, [&](const AudioPacket& p) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stamps.push_back(Stamp{p.position, p.capture_time_ns, p.frames});
+  });
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (std::chrono::steady_clock::now() < deadline) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stamps.size() >= count) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  engine.Stop(StreamKind::kSystem);
+  if (stats) {
+    *stats = engine.GetStats(StreamKind::kSystem);
+  }
+  return stamps;
+}
+
+}  // namespace
+
+TEST(TimestampsFollowTheDeviceClock) {
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 48000;
+  std::vector<Stamp> stamps = CollectTimestamps(settings, 0.0, 50, nullptr);
+  ASSERT_TRUE(stamps.size() >= 50);
+
+  const AudioFormat format = settings.stream.format;
+  uint64_t next = 0;
+  bool exact = true;
+  for (const Stamp& stamp : stamps) {
+    // Contiguous positions, each stamped at exactly its device time.
+    exact = exact && stamp.position == next &&
+            stamp.time_ns ==
+                1000 * kMillis + NanosForFrames(format, stamp.position);
+    next = stamp.position + stamp.frames;
+  }
+  EXPECT_TRUE(exact);
+}
+
+TEST(TimestampsSurviveResamplingAndReframing) {
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 16000;
+  settings.frame_ms = 20;  // 320 frames from 80-frame device packets.
+  std::vector<Stamp> stamps = CollectTimestamps(settings, 0.0, 30, nullptr);
+  ASSERT_TRUE(stamps.size() >= 30);
+
+  const AudioFormat format = settings.stream.format;
+  uint64_t next = stamps[0].position;
+  bool aligned = true;
+  for (size_t i = 0; i < 30; ++i) {
+    const Stamp& stamp = stamps[i];
+    // The resampler has no group delay, so output frame k still maps to
+    // device time k / 16000 s after the start, to within rounding.
+    const int64_t expected =
+        1000 * kMillis + NanosForFrames(format, stamp.position);
+    aligned = aligned && stamp.position == next && stamp.frames == 320 &&
+              stamp.time_ns >= expected - 2 && stamp.time_ns <= expected + 2;
+    next = stamp.position + stamp.frames;
+  }
+  EXPECT_TRUE(aligned);
+}
+
+namespace {
+
+// Delivered frames minus host time elapsed since the first stamp, in
+// frames, at the first stamp at or past |seconds|.
+double TimelineError(const std::vector<Stamp>& stamps, uint32_t rate,
+                     double seconds) {
+  for (const Stamp& stamp : stamps) {
+    const double elapsed = (stamp.time_ns - stamps[0].time_ns) / 1e9;
+    if (elapsed >= seconds) {
+      return static_cast<double>(stamp.position - stamps[0].position) -
+             elapsed * rate;
+    }
+  }
+  return 0.0;
+}
+
+}  // namespace
+
+TEST(MeasuresDeviceClockDrift) {
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 16000;
+  CaptureStats stats;
+  // 20 s of 5 ms device packets from a crystal 300 ppm fast.
+  std::vector<Stamp> stamps = CollectTimestamps(settings, 300.0, 4000,
+                                                &stats);
+  ASSERT_TRUE(stamps.size() >= 4000);
+  EXPECT_NEAR(stats.drift_ppm, 300.0, 1.0);
+  EXPECT_NEAR(stats.drift_ms, 0.3 * 20, 0.3);
+  EXPECT_EQ(stats.drift_corrected_frames, 0);
+  // Uncorrected, positions run 4.8 frames a second ahead of host time.
+  EXPECT_NEAR(TimelineError(stamps, 16000, 19.0) -
+                  TimelineError(stamps, 16000, 5.0),
+              14 * 4.8, 2.0);
+}
+
+TEST(CompensatesDeviceClockDrift) {
+  CaptureSettings settings;
+  settings.stream.format = DefaultOutputFormat();
+  settings.stream.format.sample_rate = 16000;
+  settings.compensate_drift = true;
+  CaptureStats stats;
+  std::vector<Stamp> stamps = CollectTimestamps(settings, 300.0, 4000,
+                                                &stats);
+  ASSERT_TRUE(stamps.size() >= 4000);
+  EXPECT_NEAR(stats.drift_ppm, 300.0, 1.0);
+  // Once the estimate locks, positions follow host time to within a
+  // frame; the frames that makes up for were taken out of the stream.
+  EXPECT_NEAR(TimelineError(stamps, 16000, 19.0) -
+                  TimelineError(stamps, 16000, 5.0),
+              0.0, 1.0);
+  EXPECT_TRUE(stats.drift_corrected_frames < -60);
+  EXPECT_TRUE(stats.drift_corrected_frames > -100);
+}
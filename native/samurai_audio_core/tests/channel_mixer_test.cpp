@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "samurai_audio_core/channel_mixer.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+const ChannelMixImpl kAllImpls[] = {ChannelMixImpl::kScalar,
+                                    ChannelMixImpl::kSse2,
+                                    ChannelMixImpl::kAvx2,
+                                    ChannelMixImpl::kNeon};
+
+std::vector<float> RandomFrames(size_t frames, uint16_t channels,
+                                std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> samples(frames * channels);
+  for (float& v : samples) {
+    v = dist(*rng);
+  }
+  return samples;
+}
+
+std::vector<float> Mix(const ChannelMixer& mixer, const std::vector<float>& in) {
+  const size_t frames = in.size() / mixer.input_channels();
+  std::vector<float> out(frames * mixer.output_channels());
+  mixer.Process(in.data(), frames, out.data());
+  return out;
+}
+
+}  // namespace
+
+TEST(ParsesModeNames) {
+  ChannelMode mode = ChannelMode::kPassthrough;
+  for (ChannelMode m : {ChannelMode::kPassthrough, ChannelMode::kDownmix,
+                        ChannelMode::kSelect, ChannelMode::kMatrix}) {
+    EXPECT_TRUE(ParseChannelMode(ChannelModeName(m), &mode));
+    EXPECT_TRUE(mode == m);
+  }
+  EXPECT_TRUE(!ParseChannelMode("mono", &mode));
+  EXPECT_TRUE(mode == ChannelMode::kMatrix);
+}
+
+TEST(DownmixAveragesChannels) {
+  ChannelMixer stereo(2, ChannelMap::Downmix());
+  ASSERT_TRUE(stereo.IsValid());
+  EXPECT_EQ(stereo.output_channels(), 1u);
+  std::vector<float> out = Mix(stereo, {1.0f, 0.0f, 0.5f, -0.5f, -1.0f, -0.5f});
+  EXPECT_NEAR(out[0], 0.5, 1e-7);
+  EXPECT_NEAR(out[1], 0.0, 1e-7);
+  EXPECT_NEAR(out[2], -0.75, 1e-7);
+
+  ChannelMixer quad(4, ChannelMap::Downmix());
+  out = Mix(quad, {1.0f, 1.0f, 0.0f, 0.0f});
+  ASSERT_TRUE(out.size() == 1);
+  EXPECT_NEAR(out[0], 0.5, 1e-7);
+}
+
+TEST(SelectKeepsOneChannel) {
+  ChannelMixer right(2, ChannelMap::Select(1));
+  ASSERT_TRUE(right.IsValid());
+  std::vector<float> out = Mix(right, {1.0f, 2.0f, 3.0f, 4.0f});
+  EXPECT_TRUE(out == std::vector<float>({2.0f, 4.0f}));
+
+  ChannelMixer third(6, ChannelMap::Select(2));
+  std::vector<float> in(12);
+  for (size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<float>(i);
+  }
+  EXPECT_TRUE(Mix(third, in) == std::vector<float>({2.0f, 8.0f}));
+
+  EXPECT_TRUE(!ChannelMixer(2, ChannelMap::Select(2)).IsValid());
+}
+
+TEST(MatrixMapsNToM) {
+  // 5.1 (L R C LFE Ls Rs) to stereo.
+  const float k = 0.7071f;
+  std::vector<float> gains = {1.0f, 0.0f, k, 0.0f, k, 0.0f,
+                              0.0f, 1.0f, k, 0.0f, 0.0f, k};
+  ChannelMixer mixer(6, ChannelMap::Matrix(2, gains));
+  ASSERT_TRUE(mixer.IsValid());
+  EXPECT_EQ(mixer.output_channels(), 2u);
+
+  std::mt19937 rng(5);
+  std::vector<float> in = RandomFrames(33, 6, &rng);
+  std::vector<float> out = Mix(mixer, in);
+  ASSERT_TRUE(out.size() == 66);
+  for (size_t i = 0; i < 33; ++i) {
+    const float* f = in.data() + i * 6;
+    EXPECT_NEAR(out[i * 2], f[0] + k * f[2] + k * f[4], 1e-6);
+    EXPECT_NEAR(out[i * 2 + 1], f[1] + k * f[2] + k * f[5], 1e-6);
+  }
+
+  // Wrong size for the input layout.
+  EXPECT_TRUE(!ChannelMixer(2, ChannelMap::Matrix(2, gains)).IsValid());
+  EXPECT_TRUE(!ChannelMixer(6, ChannelMap::Matrix(0, {})).IsValid());
+}
+
+TEST(StereoKernelsMatchScalar) {
+  std::mt19937 rng(9);
+  const ChannelMap maps[] = {ChannelMap::Downmix(),
+                             ChannelMap::Matrix(1, {0.8f, -0.3f})};
+  for (const ChannelMap& map : maps) {
+    ChannelMixer reference(2, map, ChannelMixImpl::kScalar);
+    for (ChannelMixImpl impl : kAllImpls) {
+      if (impl == ChannelMixImpl::kScalar || !ChannelMixImplSupported(impl)) {
+        continue;
+      }
+      ChannelMixer simd(2, map, impl);
+      // Odd sizes exercise the scalar tails.
+      for (size_t frames : {0, 1, 3, 4, 7, 8, 9, 17, 441, 480, 1001}) {
+        std::vector<float> in = RandomFrames(frames, 2, &rng);
+        std::vector<float> expected = Mix(reference, in);
+        std::vector<float> actual = Mix(simd, in);
+        float max_error = 0.0f;
+        for (size_t i = 0; i < frames; ++i) {
+          max_error = std::max(max_error, std::fabs(actual[i] - expected[i]));
+        }
+        EXPECT_TRUE(max_error <= 1e-7f);
+      }
+    }
+  }
+}
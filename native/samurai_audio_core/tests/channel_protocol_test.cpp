@@ -0,0 +1,172 @@
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/channel_protocol.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+ChannelValue StringList(const std::vector<std::string>& values) {
+  ChannelValue list = ChannelValue::EmptyList();
+  for (const std::string& value : values) {
+    list.Append(ChannelValue::String(value));
+  }
+  return list;
+}
+
+}  // namespace
+
+TEST(GettersFallBackOnMissingOrMistypedEntries) {
+  ChannelValue args;
+  args.Set("deviceId", ChannelValue());
+  args.Set("sampleRate", ChannelValue::String("16000"));
+  args.Set("mirror", ChannelValue::Bool(true));
+  args.Set("mirror", ChannelValue::Bool(false));
+  EXPECT_TRUE(args.type() == ChannelValue::Type::kMap);
+  EXPECT_EQ(args.map().size(), 3u);
+  EXPECT_EQ(args.GetString("deviceId", "default"), "default");
+  EXPECT_EQ(args.GetInt("sampleRate", 48000), 48000);
+  EXPECT_EQ(args.GetBool("mirror", true), false);
+  EXPECT_TRUE(args.Find("missing") == nullptr);
+  EXPECT_TRUE(ChannelValue().Find("deviceId") == nullptr);
+}
+
+TEST(CaptureRequestDefaultsToTheBalancedProfile) {
+  CaptureRequest request;
+  EXPECT_TRUE(ParseCaptureRequest(ChannelValue(), &request).ok());
+  const CaptureSettings expected = CaptureSettingsForProfile(
+      CaptureProfile::kBalanced, DefaultOutputFormat());
+  EXPECT_TRUE(request.profile == CaptureProfile::kBalanced);
+  EXPECT_EQ(request.settings.stream.format.sample_rate,
+            expected.stream.format.sample_rate);
+  EXPECT_EQ(request.settings.frame_flush_ms, expected.frame_flush_ms);
+  EXPECT_EQ(request.settings.frame_ms, 0u);
+  EXPECT_TRUE(request.settings.recording.encoder.codec == CodecId::kPcm);
+  EXPECT_TRUE(!request.delivery.binary && !request.delivery.native);
+}
+
+TEST(CaptureRequestAppliesOptionalArguments) {
+  ChannelValue args;
+  args.Set("deviceId", ChannelValue::String("mic-1"));
+  args.Set("profile", ChannelValue::String("realtime"));
+  args.Set("sampleRate", ChannelValue::Int(16000));
+  args.Set("silencePolicy", ChannelValue::String("drop"));
+  args.Set("frameMs", ChannelValue::Int(20));
+  args.Set("recordCodec", ChannelValue::String("mp3"));
+  args.Set("channelMode", ChannelValue::String("matrix"));
+  args.Set("outputChannels", ChannelValue::Int(1));
+  args.Set("channelMatrix", ChannelValue::DoubleList({0.5, 0.5}));
+  args.Set("compensateDrift", ChannelValue::Bool(true));
+  CaptureRequest request;
+  ChannelResult result = ParseCaptureRequest(args, &request);
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(request.device_id, "mic-1");
+  EXPECT_TRUE(request.profile == CaptureProfile::kRealtime);
+  EXPECT_EQ(request.settings.stream.format.sample_rate, 16000u);
+  EXPECT_TRUE(request.settings.vad);
+  EXPECT_EQ(request.settings.frame_ms, 20u);
+  EXPECT_EQ(request.settings.recording.encoder.bitrate, 128000u);
+  EXPECT_EQ(request.settings.channel_map.matrix.size(), 2u);
+  EXPECT_TRUE(request.settings.compensate_drift);
+}
+
+TEST(CaptureRequestReportsTheFirstBadArgument) {
+  ChannelValue args;
+  args.Set("profile", ChannelValue::String("turbo"));
+  args.Set("sampleRate", ChannelValue::Int(4000));
+  CaptureRequest request;
+  ChannelResult result = ParseCaptureRequest(args, &request);
+  EXPECT_EQ(result.code, "INVALID_ARGUMENT");
+  EXPECT_EQ(result.message, "Unknown capture profile: turbo");
+
+  args.Set("profile", ChannelValue::String("balanced"));
+  result = ParseCaptureRequest(args, &request);
+  EXPECT_EQ(result.message, "Unsupported sample rate: 4000");
+
+  args.Set("sampleRate", ChannelValue::Int(48000));
+  args.Set("channelMode", ChannelValue::String("matrix"));
+  EXPECT_EQ(ParseCaptureRequest(args, &request).message,
+            "Invalid channel mapping");
+
+  args.Set("channelMode", ChannelValue::String("downmix"));
+  args.Set("frameMs", ChannelValue::Int(5000));
+  EXPECT_EQ(ParseCaptureRequest(args, &request).message,
+            "Invalid frame settings");
+}
+
+TEST(DeliveryMirrorsOnlyNativeCaptures) {
+  ChannelValue args;
+  args.Set("mirror", ChannelValue::Bool(true));
+  CaptureDelivery delivery = ParseCaptureDelivery(args);
+  EXPECT_TRUE(!delivery.binary && !delivery.native);
+
+  args.Set("delivery", ChannelValue::String("native"));
+  delivery = ParseCaptureDelivery(args);
+  EXPECT_TRUE(delivery.binary && delivery.native);
+
+  args.Set("mirror", ChannelValue::Bool(false));
+  delivery = ParseCaptureDelivery(args);
+  EXPECT_TRUE(!delivery.binary && delivery.native);
+
+  args.Set("delivery", ChannelValue::String("binary"));
+  delivery = ParseCaptureDelivery(args);
+  EXPECT_TRUE(delivery.binary && !delivery.native);
+}
+
+TEST(NativeStreamingKeepsTokensOnLoopback) {
+  ChannelValue args;
+  args.Set("url", ChannelValue::String("ws://127.0.0.1:9000/audio"));
+  args.Set("authToken", ChannelValue::String("secret"));
+  args.Set("queuePolicy", ChannelValue::String("coalesce_silence"));
+  NativeStreamingRequest request;
+  ASSERT_TRUE(ParseNativeStreamingRequest(args, &request).ok());
+  EXPECT_EQ(request.sink.auth_token, "secret");
+  EXPECT_TRUE(request.sink.block_when_full);
+  EXPECT_TRUE(request.policy == BackpressurePolicy::kCoalesceSilence);
+
+  args.Set("url", ChannelValue::String("ws://example.com/audio"));
+  EXPECT_EQ(ParseNativeStreamingRequest(args, &request).message,
+            "authToken would be sent in cleartext; use a loopback host");
+
+  args.Set("url", ChannelValue::String("wss://example.com/audio"));
+  EXPECT_EQ(ParseNativeStreamingRequest(args, &request).message,
+            "Unsupported WebSocket URL: wss://example.com/audio");
+}
+
+TEST(ConvertBatchNeedsEqualLengthPathLists) {
+  ChannelValue args;
+  args.Set("inputs", StringList({"a.wav", "b.wav"}));
+  args.Set("outputs", StringList({"a.mp3", "b.mp3"}));
+  std::vector<TranscodeRequest> requests;
+  ASSERT_TRUE(ParseConvertBatchRequest(args, &requests).ok());
+  ASSERT_TRUE(requests.size() == 2);
+  EXPECT_EQ(requests[1].input_path, "b.wav");
+  EXPECT_EQ(requests[1].output_path, "b.mp3");
+  EXPECT_TRUE(requests[1].encoder.codec == CodecId::kMp3);
+  EXPECT_EQ(requests[1].encoder.bitrate, 192000u);
+
+  args.Set("outputs", StringList({"a.mp3"}));
+  requests.clear();
+  ChannelResult result = ParseConvertBatchRequest(args, &requests);
+  EXPECT_EQ(result.code, "INVALID_ARGS");
+  EXPECT_TRUE(requests.empty());
+}
+
+TEST(JobEventsCarryBatchFieldsOnlyInABatch) {
+  JobEvent event;
+  event.id = 7;
+  event.state = JobState::kRunning;
+  event.progress = 0.5;
+  ChannelValue value = JobEventValue(event);
+  EXPECT_EQ(value.GetInt("id", 0), 7);
+  EXPECT_TRUE(value.Find("batch") == nullptr);
+  EXPECT_TRUE(value.Find("error") == nullptr);
+
+  event.batch = 3;
+  event.batch_pending = 2;
+  value = JobEventValue(event);
+  EXPECT_EQ(value.GetInt("batch", 0), 3);
+  EXPECT_EQ(value.GetInt("batchPending", 0), 2);
+}
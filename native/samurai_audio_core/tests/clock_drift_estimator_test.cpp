@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <random>
+
+#include "samurai_audio_core/clock_drift_estimator.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr int64_t kMs = 1000000;
+
+// Feeds |seconds| of 10 ms packets from a 48 kHz device running |ppm| fast,
+// stamped with up to |jitter_ns| of host timestamp noise.
+void Feed(ClockDriftEstimator* estimator, double ppm, int seconds,
+          int64_t jitter_ns) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int64_t> noise(-jitter_ns, jitter_ns);
+  const double device_rate = 48000.0 * (1.0 + ppm * 1e-6);
+  for (uint64_t position = 0; position < 48000ull * seconds;
+       position += 480) {
+    const int64_t time_ns =
+        5000 * kMs + static_cast<int64_t>(position * 1e9 / device_rate);
+    estimator->Update(position, time_ns + (jitter_ns ? noise(rng) : 0));
+  }
+}
+
+}  // namespace
+
+TEST(MeasuresAFastDeviceClock) {
+  ClockDriftEstimator estimator(48000, DriftEstimatorConfig());
+  Feed(&estimator, 120.0, 20, 0);
+  ASSERT_TRUE(estimator.locked());
+  EXPECT_NEAR(estimator.ppm(), 120.0, 0.5);
+  // 20 s at 120 ppm fast: 2.4 ms ahead of the host.
+  EXPECT_NEAR(estimator.drift_ns(), 2.4e6, 0.05e6);
+}
+
+TEST(SeesThroughTimestampJitter) {
+  ClockDriftEstimator estimator(48000, DriftEstimatorConfig());
+  // 200 us of jitter per packet, far more than the drift per packet.
+  Feed(&estimator, -80.0, 30, 200000);
+  ASSERT_TRUE(estimator.locked());
+  EXPECT_NEAR(estimator.ppm(), -80.0, 10.0);
+}
+
+TEST(WaitsForEnoughSpanBeforeLocking) {
+  DriftEstimatorConfig config;
+  config.min_span_ms = 2000;
+  ClockDriftEstimator estimator(48000, config);
+  Feed(&estimator, 500.0, 1, 0);
+  EXPECT_TRUE(!estimator.locked());
+  EXPECT_EQ(estimator.ratio(), 1.0);
+  // The raw drift is known from the first two packets on.
+  EXPECT_NEAR(estimator.drift_ns(), 0.5e6, 0.05e6);
+}
+
+TEST(RestartsWhenTheDeviceResets) {
+  ClockDriftEstimator estimator(48000, DriftEstimatorConfig());
+  Feed(&estimator, 300.0, 5, 0);
+  ASSERT_TRUE(estimator.locked());
+  // A position going backwards starts over.
+  estimator.Update(0, 100000 * kMs);
+  EXPECT_TRUE(!estimator.locked());
+  EXPECT_EQ(estimator.drift_ns(), 0.0);
+  for (uint64_t position = 480; position < 48000 * 5; position += 480) {
+    estimator.Update(position,
+                     100000 * kMs + static_cast<int64_t>(position * 1e9 /
+                                                         48000.0));
+  }
+  ASSERT_TRUE(estimator.locked());
+  EXPECT_NEAR(estimator.ppm(), 0.0, 0.5);
+}
@@ -0,0 +1,163 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "samurai_audio_core/echo_canceller.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr uint32_t kRate = 16000;
+constexpr uint32_t kBlock = 128;
+
+// Far-end speech stand-in: noise coloured towards the low end, as speech
+// is, which is harder to converge on than white noise.
+std::vector<float> FarEnd(size_t frames, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> dist(0.0f, 0.1f);
+  std::vector<float> far(frames);
+  float state = 0.0f;
+  for (float& s : far) {
+    state = 0.8f * state + dist(rng);
+    s = state;
+  }
+  return far;
+}
+
+// Loudspeaker-to-microphone path: 20 ms of delay, then 40 ms of decaying
+// random reflections.
+std::vector<float> EchoPath() {
+  std::mt19937 rng(11);
+  std::normal_distribution<float> dist(0.0f, 1.0f);
+  const size_t delay = kRate / 50;
+  std::vector<float> path(delay + kRate / 25);
+  for (size_t i = delay; i < path.size(); ++i) {
+    path[i] = 0.3f * dist(rng) *
+              std::exp(-static_cast<float>(i - delay) / (kRate / 200));
+  }
+  return path;
+}
+
+std::vector<float> Echo(const std::vector<float>& far) {
+  const std::vector<float> path = EchoPath();
+  std::vector<float> echo(far.size());
+  for (size_t n = 0; n < far.size(); ++n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < path.size() && i <= n; ++i) {
+      sum += path[i] * far[n - i];
+    }
+    echo[n] = static_cast<float>(sum);
+  }
+  return echo;
+}
+
+double EnergyDb(const float* samples, size_t n) {
+  double sum = 1e-20;
+  for (size_t i = 0; i < n; ++i) {
+    sum += static_cast<double>(samples[i]) * samples[i];
+  }
+  return 10.0 * std::log10(sum);
+}
+
+EchoCancellerConfig UnlimitedConfig() {
+  EchoCancellerConfig config;
+  config.cpu_budget_percent = 0;
+  return config;
+}
+
+}  // namespace
+
+TEST(RejectsBadBlockSizes) {
+  EXPECT_TRUE(!EchoCanceller(kRate, 0, UnlimitedConfig()).IsValid());
+  EXPECT_TRUE(!EchoCanceller(kRate, 8, UnlimitedConfig()).IsValid());
+  EXPECT_TRUE(!EchoCanceller(kRate, 160, UnlimitedConfig()).IsValid());
+  EchoCanceller canceller(kRate, kBlock, UnlimitedConfig());
+  ASSERT_TRUE(canceller.IsValid());
+  // 128 ms of tail in 128-frame partitions.
+  EXPECT_EQ(canceller.partitions(), 16u);
+  std::vector<float> samples(kBlock + 1);
+  EXPECT_TRUE(!canceller.Process(samples.data(), samples.data(),
+                                 samples.size(), samples.data()));
+}
+
+TEST(CancelsTheEcho) {
+  const size_t frames = 8 * kRate;
+  const std::vector<float> far = FarEnd(frames, 1);
+  const std::vector<float> near = Echo(far);
+  for (FftImpl impl : {FftImpl::kScalar, FftBestImpl()}) {
+    EchoCanceller canceller(kRate, kBlock, UnlimitedConfig(), impl);
+    ASSERT_TRUE(canceller.IsValid());
+    std::vector<float> out(frames);
+    // 10 ms packets would not be whole blocks; 40 ms ones are.
+    for (size_t done = 0; done < frames; done += 5 * kBlock) {
+      ASSERT_TRUE(canceller.Process(far.data() + done, near.data() + done,
+                                    5 * kBlock, out.data() + done));
+    }
+    const size_t tail = frames - 2 * kRate;
+    const double erle = EnergyDb(near.data() + tail, frames - tail) -
+                        EnergyDb(out.data() + tail, frames - tail);
+    EXPECT_TRUE(erle > 25.0);
+    EXPECT_TRUE(canceller.stats().erle_db > 20.0);
+    EXPECT_EQ(canceller.stats().processed_frames, frames);
+    EXPECT_EQ(canceller.stats().bypassed_frames, 0u);
+  }
+}
+
+TEST(KeepsNearEndSpeechDuringDoubleTalk) {
+  const size_t frames = 10 * kRate;
+  const std::vector<float> far = FarEnd(frames, 2);
+  std::vector<float> near = Echo(far);
+  // The agent talks over the customer for the last three seconds.
+  const size_t talk = frames - 3 * kRate;
+  const std::vector<float> speech = FarEnd(frames, 3);
+  for (size_t n = talk; n < frames; ++n) {
+    near[n] += speech[n];
+  }
+  EchoCanceller canceller(kRate, kBlock, UnlimitedConfig());
+  std::vector<float> out(frames);
+  ASSERT_TRUE(canceller.Process(far.data(), near.data(), frames, out.data()));
+
+  std::vector<float> residual(frames - talk);
+  for (size_t n = talk; n < frames; ++n) {
+    residual[n - talk] = out[n] - speech[n];
+  }
+  // The speech survives and the echo stays well below it.
+  EXPECT_TRUE(EnergyDb(speech.data() + talk, frames - talk) -
+                  EnergyDb(residual.data(), residual.size()) >
+              15.0);
+}
+
+TEST(PassesNearEndThroughWithoutFarEnd) {
+  const size_t frames = kRate;
+  const std::vector<float> near = FarEnd(frames, 4);
+  const std::vector<float> far(frames);
+  EchoCanceller canceller(kRate, kBlock, UnlimitedConfig());
+  std::vector<float> out = near;
+  // In place.
+  ASSERT_TRUE(canceller.Process(far.data(), out.data(), frames, out.data()));
+  for (size_t n = 0; n < frames; ++n) {
+    EXPECT_NEAR(out[n], near[n], 1e-6);
+  }
+}
+
+TEST(BypassesOverTheCpuBudget) {
+  // Two seconds of tail in 16-frame blocks at 48 kHz is thousands of
+  // partitions per block: far more than 1% of any CPU.
+  EchoCancellerConfig config;
+  config.tail_ms = 2000;
+  config.cpu_budget_percent = 1;
+  EchoCanceller canceller(48000, 16, config);
+  ASSERT_TRUE(canceller.IsValid());
+  const size_t frames = 48000;
+  const std::vector<float> far = FarEnd(frames, 5);
+  const std::vector<float> near = FarEnd(frames, 6);
+  std::vector<float> out(frames);
+  ASSERT_TRUE(canceller.Process(far.data(), near.data(), frames, out.data()));
+  const EchoCancellerStats& stats = canceller.stats();
+  EXPECT_TRUE(stats.bypassed_frames > 0);
+  EXPECT_EQ(stats.processed_frames + stats.bypassed_frames, frames);
+  // Bypassed audio is the microphone as is.
+  EXPECT_EQ(out[frames - 1], near[frames - 1]);
+}
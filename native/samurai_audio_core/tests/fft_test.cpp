@@ -0,0 +1,97 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "samurai_audio_core/fft.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr FftImpl kImpls[] = {FftImpl::kScalar, FftImpl::kSse2,
+                              FftImpl::kAvx2, FftImpl::kNeon};
+
+std::vector<float> Noise(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> samples(n);
+  for (float& s : samples) {
+    s = dist(rng);
+  }
+  return samples;
+}
+
+}  // namespace
+
+TEST(RejectsSizesThatAreNotPowersOfTwo) {
+  EXPECT_TRUE(!RealFft(0).IsValid());
+  EXPECT_TRUE(!RealFft(2).IsValid());
+  EXPECT_TRUE(!RealFft(96).IsValid());
+  EXPECT_TRUE(RealFft(4).IsValid());
+  EXPECT_TRUE(RealFft(512).IsValid());
+}
+
+TEST(ForwardMatchesTheDefinition) {
+  for (size_t size : {4, 8, 16, 64, 256}) {
+    RealFft fft(size, FftImpl::kScalar);
+    const std::vector<float> in = Noise(size, 3);
+    std::vector<float> re(fft.bins());
+    std::vector<float> im(fft.bins());
+    fft.Forward(in.data(), re.data(), im.data());
+    for (size_t k = 0; k < fft.bins(); ++k) {
+      double dft_re = 0.0;
+      double dft_im = 0.0;
+      for (size_t n = 0; n < size; ++n) {
+        const double angle = -2.0 * 3.14159265358979323846 * k * n / size;
+        dft_re += in[n] * std::cos(angle);
+        dft_im += in[n] * std::sin(angle);
+      }
+      EXPECT_NEAR(re[k], dft_re, 1e-4 * size);
+      EXPECT_NEAR(im[k], dft_im, 1e-4 * size);
+    }
+  }
+}
+
+TEST(InverseUndoesForward) {
+  for (FftImpl impl : kImpls) {
+    if (!FftImplSupported(impl)) {
+      continue;
+    }
+    for (size_t size : {4, 32, 1024, 4096}) {
+      RealFft fft(size, impl);
+      ASSERT_TRUE(fft.IsValid());
+      const std::vector<float> in = Noise(size, 5);
+      std::vector<float> re(fft.bins());
+      std::vector<float> im(fft.bins());
+      std::vector<float> out(size);
+      fft.Forward(in.data(), re.data(), im.data());
+      fft.Inverse(re.data(), im.data(), out.data());
+      for (size_t n = 0; n < size; ++n) {
+        EXPECT_NEAR(out[n], in[n], 1e-5);
+      }
+    }
+  }
+}
+
+TEST(EveryImplMatchesScalar) {
+  const size_t kSize = 512;
+  const std::vector<float> in = Noise(kSize, 9);
+  RealFft scalar(kSize, FftImpl::kScalar);
+  std::vector<float> want_re(scalar.bins());
+  std::vector<float> want_im(scalar.bins());
+  scalar.Forward(in.data(), want_re.data(), want_im.data());
+  for (FftImpl impl : kImpls) {
+    if (!FftImplSupported(impl)) {
+      continue;
+    }
+    RealFft fft(kSize, impl);
+    std::vector<float> re(fft.bins());
+    std::vector<float> im(fft.bins());
+    fft.Forward(in.data(), re.data(), im.data());
+    for (size_t k = 0; k < fft.bins(); ++k) {
+      EXPECT_NEAR(re[k], want_re[k], 1e-3);
+      EXPECT_NEAR(im[k], want_im[k], 1e-3);
+    }
+  }
+}
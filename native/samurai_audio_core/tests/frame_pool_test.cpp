@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/frame_pool.h"
+#include "samurai_audio_core/packet_fan_out.h"
+#include "samurai_audio_core/synthetic_capture_backend.h"
+#include "samurai_audio_core/websocket_sink.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+bool WaitFor(const std::atomic<int>& counter, int target) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (counter.load() < target) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(HandsOutEveryBufferOnce) {
+  FramePool pool(3, 64);
+  EXPECT_EQ(pool.available(), 3u);
+  FrameRef a = pool.Acquire();
+  FrameRef b = pool.Acquire();
+  FrameRef c = pool.Acquire();
+  ASSERT_TRUE(a && b && c);
+  EXPECT_TRUE(a.data() != b.data() && b.data() != c.data());
+  EXPECT_EQ(a.capacity(), 64u);
+  EXPECT_TRUE(a.unique());
+  // Empty: fails instead of allocating.
+  EXPECT_TRUE(!pool.Acquire());
+  EXPECT_EQ(pool.exhausted(), 1u);
+  b.Reset();
+  EXPECT_EQ(pool.available(), 1u);
+  EXPECT_TRUE(pool.Acquire());
+}
+
+TEST(SharedFramesReturnWithTheLastHandle) {
+  FramePool pool(1, 16);
+  FrameRef frame = pool.Acquire();
+  std::memcpy(frame.data(), "samurai", 8);
+  frame.set_size(8);
+  FrameRef shared = frame;
+  EXPECT_TRUE(!frame.unique());
+  EXPECT_EQ(shared.size(), 8u);
+  frame.Reset();
+  EXPECT_EQ(pool.available(), 0u);
+  EXPECT_TRUE(shared.unique());
+  EXPECT_EQ(std::memcmp(shared.data(), "samurai", 8), 0);
+  shared = FrameRef();
+  EXPECT_EQ(pool.available(), 1u);
+  // Handed out again empty.
+  EXPECT_EQ(pool.Acquire().size(), 0u);
+}
+
+TEST(FramesOutliveTheirPool) {
+  FrameRef frame;
+  {
+    FramePool pool(2, 32);
+    frame = pool.Acquire();
+    std::memset(frame.data(), 7, 32);
+  }
+  EXPECT_EQ(frame.data()[31], 7);
+  frame.Reset();
+}
+
+TEST(HeapFramesWorkLikePooledOnes) {
+  FrameRef frame = FrameRef::Allocate(100);
+  EXPECT_EQ(frame.capacity(), 100u);
+  frame.set_size(200);
+  EXPECT_EQ(frame.size(), 100u);
+  FrameRef copy = frame;
+  frame.Reset();
+  EXPECT_TRUE(copy.unique());
+}
+
+TEST(AcquiresAndReleasesAcrossThreads) {
+  FramePool pool(8, 8);
+  std::atomic<bool> overlap{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, &overlap, t]() {
+      for (int i = 0; i < 20000; ++i) {
+        FrameRef frame = pool.Acquire();
+        if (!frame) {
+          continue;
+        }
+        // Nobody else may hold the buffer meanwhile.
+        frame.data()[0] = static_cast<uint8_t>(t);
+        FrameRef shared = frame;
+        frame.Reset();
+        if (shared.data()[0] != t) {
+          overlap = true;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(!overlap.load());
+  EXPECT_EQ(pool.available(), 8u);
+}
+
+// The whole native path, from device packets through conversion, the
+// ring, re-framing, alignment and echo cancellation to the sink's queue,
+// kept running long enough to fill every buffer and queue and evict from
+// them, allocates nothing once warmed up.
+TEST(PipelineAllocatesNothingAfterWarmUp) {
+  SyntheticCaptureBackend::Options options;
+  options.realtime = false;
+  CaptureEngine engine(std::make_unique<SyntheticCaptureBackend>(options));
+  ASSERT_TRUE(engine.Initialize());
+
+  WebSocketSinkConfig config;
+  config.url = "ws://127.0.0.1:9/";  // Never started: nothing leaves.
+  config.max_queued_bytes = 64 * 1024;
+  config.align_streams = true;
+  config.cancel_echo = true;
+  config.echo.cpu_budget_percent = 0;
+  WebSocketSink sink(config, nullptr);
+
+  CaptureSettings settings;
+  settings.stream.format = AudioFormat{16000, 1, SampleType::kInt16};
+  settings.channel_map = ChannelMap::Downmix();
+  settings.frame_ms = 20;
+  std::atomic<int> packets{0};
+  FrameRef kept[kStreamKindCount];
+  std::atomic<bool> pooled{true};
+  // Through a fan-out, as the runners deliver. Blocking keeps every
+  // packet, so nothing is copied around a drop.
+  PacketFanOut fan_out;
+  FanOutSinkConfig sink_config;
+  sink_config.policy = BackpressurePolicy::kBlock;
+  const uint64_t sink_id =
+      fan_out.Attach(sink_config, [&](const AudioPacket& packet) {
+        // Consumers may keep delivered samples without copying them.
+        kept[static_cast<int>(packet.stream)] = *packet.buffer;
+        sink.Deliver(packet);
+      });
+  auto callback = [&](const AudioPacket& packet) {
+    if (!packet.buffer) {
+      pooled = false;
+    }
+    fan_out.Deliver(packet);
+    ++packets;
+  };
+  ASSERT_TRUE(engine.Start(StreamKind::kSystem, "", settings, callback));
+  ASSERT_TRUE(engine.Start(StreamKind::kMicrophone, "", settings, callback));
+
+  ASSERT_TRUE(WaitFor(packets, 600));
+  const uint64_t warm = testing::AllocationCount();
+  ASSERT_TRUE(WaitFor(packets, 900));
+  const uint64_t allocations = testing::AllocationCount() - warm;
+  engine.StopAll();
+  FanOutSinkStats fan_out_stats;
+  fan_out.GetStats(sink_id, &fan_out_stats);
+  fan_out.Detach(sink_id);
+
+  EXPECT_EQ(allocations, 0u);
+  EXPECT_TRUE(pooled.load());
+  EXPECT_EQ(fan_out_stats.copied_packets, 0u);
+  EXPECT_TRUE(sink.stats().messages_dropped > 0);
+  EXPECT_TRUE(sink.stats().echo_processed_frames > 0);
+}
@@ -0,0 +1,183 @@
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/frame_protocol.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+AudioPacket OpusPacket(const std::vector<uint8_t>& bytes) {
+  AudioPacket packet;
+  packet.stream = StreamKind::kMicrophone;
+  packet.codec = CodecId::kOpus;
+  packet.format = AudioFormat{16000, 1, SampleType::kInt16};
+  packet.data = bytes.data();
+  packet.size = bytes.size();
+  packet.frames = 320;
+  packet.flags = kPacketNoSpeech;
+  packet.sequence = (1ull << 32) + 5;  // Wraps to 5 on the wire.
+  packet.capture_time_ns = -1234567890123;
+  packet.position = 0x123456789;
+  return packet;
+}
+
+const uint8_t* Bytes(const std::string& frame) {
+  return reinterpret_cast<const uint8_t*>(frame.data());
+}
+
+}  // namespace
+
+TEST(RoundTripsEveryField) {
+  const std::vector<uint8_t> bytes = {9, 8, 7, 6, 5};
+  std::string frame;
+  EncodeFrame(OpusPacket(bytes), &frame);
+  ASSERT_TRUE(frame.size() == kFrameHeaderBytes + bytes.size());
+
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+  EXPECT_EQ(DecodeFrame(Bytes(frame), frame.size(), &header, &payload),
+            frame.size());
+  EXPECT_EQ(header.version, kFrameProtocolVersion);
+  EXPECT_TRUE(header.stream == StreamKind::kMicrophone);
+  EXPECT_TRUE(header.codec == CodecId::kOpus);
+  EXPECT_EQ(header.flags, kPacketNoSpeech);
+  EXPECT_EQ(header.format.sample_rate, 16000u);
+  EXPECT_EQ(header.format.channels, 1);
+  EXPECT_TRUE(header.format.sample_type == SampleType::kInt16);
+  EXPECT_EQ(header.capture_time_ns, -1234567890123);
+  EXPECT_EQ(header.frames, 320u);
+  EXPECT_EQ(header.sequence, 5u);
+  EXPECT_EQ(header.payload_bytes, bytes.size());
+  EXPECT_EQ(header.position, 0x123456789u);
+  EXPECT_TRUE(header.has_position);
+  EXPECT_EQ(std::vector<uint8_t>(payload, payload + header.payload_bytes),
+            bytes);
+}
+
+TEST(HeaderLayoutIsLittleEndian) {
+  FrameHeader header;
+  header.stream = StreamKind::kMicrophone;
+  header.codec = CodecId::kMp3;
+  header.flags = 0x0102;
+  header.format = AudioFormat{48000, 2, SampleType::kFloat32};
+  header.capture_time_ns = 0x0102030405060708;
+  header.frames = 1152;
+  header.sequence = 0xA0B0C0D0;
+  header.payload_bytes = 417;
+  header.position = 0x1122334455667788;
+  uint8_t out[kFrameHeaderBytes];
+  EncodeFrameHeader(header, out);
+
+  const uint8_t expected[kFrameHeaderBytes] = {
+      1,    40,   1,    2,    0x02, 0x01, 2,    3,     // version .. type
+      0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,  // capture time
+      0x80, 0xBB, 0x00, 0x00,                          // 48000
+      0x80, 0x04, 0x00, 0x00,                          // 1152
+      0xD0, 0xC0, 0xB0, 0xA0,                          // sequence
+      0xA1, 0x01, 0x00, 0x00,                          // 417
+      0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11,  // position
+  };
+  for (size_t i = 0; i < kFrameHeaderBytes; ++i) {
+    EXPECT_EQ(out[i], expected[i]);
+  }
+}
+
+TEST(SilenceMarkersHaveNoPayload) {
+  AudioPacket packet;
+  packet.format = AudioFormat{16000, 1, SampleType::kInt16};
+  packet.frames = 8000;
+  packet.flags = kPacketSilenceMarker | kPacketNoSpeech;
+  std::string frame;
+  EncodeFrame(packet, &frame);
+  EXPECT_EQ(frame.size(), kFrameHeaderBytes);
+
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+  EXPECT_EQ(DecodeFrame(Bytes(frame), frame.size(), &header, &payload),
+            kFrameHeaderBytes);
+  EXPECT_EQ(header.frames, 8000u);
+  EXPECT_EQ(header.payload_bytes, 0u);
+}
+
+TEST(WalksConcatenatedFrames) {
+  const std::vector<uint8_t> first = {1, 2, 3};
+  const std::vector<uint8_t> second = {4, 5};
+  std::string frame;
+  std::string stream;
+  EncodeFrame(OpusPacket(first), &frame);
+  stream += frame;
+  EncodeFrame(OpusPacket(second), &frame);
+  stream += frame;
+
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+  const size_t used = DecodeFrame(Bytes(stream), stream.size(), &header,
+                                  &payload);
+  EXPECT_EQ(used, kFrameHeaderBytes + first.size());
+  EXPECT_EQ(DecodeFrame(Bytes(stream) + used, stream.size() - used, &header,
+                        &payload),
+            kFrameHeaderBytes + second.size());
+  EXPECT_EQ(payload[0], 4);
+}
+
+TEST(SkipsHeaderExtensions) {
+  // A same-version sender with four more header bytes.
+  const std::vector<uint8_t> bytes = {42};
+  std::string frame;
+  EncodeFrame(OpusPacket(bytes), &frame);
+  frame.insert(kFrameHeaderBytes, 4, '\x7F');
+  frame[1] = static_cast<char>(kFrameHeaderBytes + 4);
+
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+  EXPECT_EQ(DecodeFrame(Bytes(frame), frame.size(), &header, &payload),
+            frame.size());
+  EXPECT_EQ(payload[0], 42);
+}
+
+TEST(AcceptsHeadersWithoutPosition) {
+  // As sent before the position was appended: 32 bytes, then payload.
+  const std::vector<uint8_t> bytes = {42};
+  std::string frame;
+  EncodeFrame(OpusPacket(bytes), &frame);
+  frame.erase(kFrameHeaderMinBytes, kFrameHeaderBytes - kFrameHeaderMinBytes);
+  frame[1] = static_cast<char>(kFrameHeaderMinBytes);
+
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+  EXPECT_EQ(DecodeFrame(Bytes(frame), frame.size(), &header, &payload),
+            frame.size());
+  EXPECT_TRUE(!header.has_position);
+  EXPECT_EQ(header.position, 0u);
+  EXPECT_EQ(header.capture_time_ns, -1234567890123);
+  EXPECT_EQ(payload[0], 42);
+}
+
+TEST(RejectsMalformedFrames) {
+  const std::vector<uint8_t> bytes = {1, 2, 3, 4};
+  std::string frame;
+  EncodeFrame(OpusPacket(bytes), &frame);
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+
+  // Truncated header and truncated payload.
+  EXPECT_EQ(DecodeFrame(Bytes(frame), kFrameHeaderMinBytes - 1, &header,
+                        &payload),
+            0u);
+  EXPECT_EQ(DecodeFrame(Bytes(frame), frame.size() - 1, &header, &payload),
+            0u);
+
+  auto corrupt = [&](size_t offset, char value) {
+    std::string bad = frame;
+    bad[offset] = value;
+    return DecodeFrame(Bytes(bad), bad.size(), &header, &payload);
+  };
+  EXPECT_EQ(corrupt(0, 2), 0u);    // Unknown version.
+  EXPECT_EQ(corrupt(1, 16), 0u);   // Header too short.
+  EXPECT_EQ(corrupt(2, 3), 0u);    // Unknown stream.
+  EXPECT_EQ(corrupt(3, 9), 0u);    // Unknown codec.
+  EXPECT_EQ(corrupt(6, 0), 0u);    // No channels.
+  EXPECT_EQ(corrupt(7, 4), 0u);    // Unknown sample type.
+}
@@ -0,0 +1,437 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/capture_profile.h"
+#include "samurai_audio_core/frame_pool.h"
+#include "samurai_audio_core/packet_fan_out.h"
+#include "samurai_audio_core/synthetic_capture_backend.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+bool WaitFor(const std::atomic<int>& counter, int target) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (counter.load() < target) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// One millisecond of 16-bit stereo per frame.
+const AudioFormat kStereo16{1000, 2, SampleType::kInt16};
+
+// A one-frame packet whose first sample byte is its sequence number, also
+// its position, in a frame from |pool|.
+AudioPacket PooledPacket(FramePool* pool, uint64_t sequence, FrameRef* ref,
+                         uint32_t flags = 0) {
+  *ref = pool->Acquire();
+  ref->data()[0] = static_cast<uint8_t>(sequence);
+  ref->set_size(4);
+  AudioPacket packet;
+  packet.data = ref->data();
+  packet.size = 4;
+  packet.buffer = ref;
+  packet.frames = 1;
+  packet.flags = flags;
+  packet.sequence = sequence;
+  packet.position = sequence;
+  packet.format = kStereo16;
+  return packet;
+}
+
+// Holds a sink's callback until Open().
+class Gate {
+ public:
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++waiting_;
+    cv_.wait(lock, [this]() { return open_; });
+  }
+  void Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = true;
+    cv_.notify_all();
+  }
+  bool HasWaiter() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiting_ > 0;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool open_ = false;
+  int waiting_ = 0;
+};
+
+// Sequences a sink got with kDropOldest or kDropNewest and two queue
+// slots, when packets 1-4 arrive while it is still busy with packet 0.
+std::vector<uint64_t> ReceivedUnderPolicy(BackpressurePolicy policy,
+                                          uint64_t* dropped) {
+  PacketFanOut fan_out;
+  FramePool pool(8, 4);
+  Gate gate;
+  std::mutex mutex;
+  std::vector<uint64_t> received;
+  std::atomic<int> count{0};
+  FanOutSinkConfig config;
+  config.max_packets = 2;
+  config.policy = policy;
+  const uint64_t id = fan_out.Attach(config, [&](const AudioPacket& packet) {
+    gate.Wait();
+    std::lock_guard<std::mutex> lock(mutex);
+    received.push_back(packet.data[0]);
+    ++count;
+  });
+
+  FrameRef ref;
+  fan_out.Deliver(PooledPacket(&pool, 0, &ref));
+  while (!gate.HasWaiter()) {
+    std::this_thread::yield();
+  }
+  for (uint64_t sequence = 1; sequence <= 4; ++sequence) {
+    fan_out.Deliver(PooledPacket(&pool, sequence, &ref));
+  }
+  ref.Reset();
+  gate.Open();
+  WaitFor(count, 3);
+  FanOutSinkStats stats;
+  fan_out.GetStats(id, &stats);
+  *dropped = stats.dropped_packets;
+  fan_out.Detach(id);
+  return received;
+}
+
+}  // namespace
+
+TEST(SharesOneBufferWithEverySink) {
+  PacketFanOut fan_out;
+  FramePool pool(4, 4);
+  std::atomic<int> count{0};
+  std::atomic<bool> shared{true};
+  FrameRef ref;
+  AudioPacket packet = PooledPacket(&pool, 7, &ref);
+  const uint8_t* samples = ref.data();
+  FrameRef kept[3];
+  uint64_t ids[3];
+  for (int i = 0; i < 3; ++i) {
+    ids[i] = fan_out.Attach(FanOutSinkConfig(), [&, i](const AudioPacket& p) {
+      shared = shared && p.data == samples && p.buffer && p.size == 4 &&
+               p.sequence == 7;
+      kept[i] = *p.buffer;
+      ++count;
+    });
+    EXPECT_TRUE(ids[i] != 0);
+  }
+  EXPECT_EQ(fan_out.sink_count(), 3u);
+
+  fan_out.Deliver(packet);
+  ref.Reset();
+  ASSERT_TRUE(WaitFor(count, 3));
+  EXPECT_TRUE(shared.load());
+  // One frame, held by every sink that kept it and by no one else.
+  EXPECT_EQ(pool.available(), 3u);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(fan_out.Detach(ids[i]));
+    kept[i].Reset();
+  }
+  EXPECT_EQ(pool.available(), 4u);
+  EXPECT_EQ(fan_out.sink_count(), 0u);
+  EXPECT_TRUE(!fan_out.Detach(ids[0]));
+}
+
+TEST(CopiesPacketsWithoutABufferOnce) {
+  PacketFanOut fan_out;
+  std::atomic<int> count{0};
+  std::atomic<bool> intact{true};
+  const uint8_t samples[4] = {1, 2, 3, 4};
+  const uint64_t id =
+      fan_out.Attach(FanOutSinkConfig(), [&](const AudioPacket& packet) {
+        intact = intact && packet.data != samples && packet.buffer &&
+                 *packet.buffer && std::memcmp(packet.data, samples, 4) == 0;
+        ++count;
+      });
+  AudioPacket packet;
+  packet.data = samples;
+  packet.size = sizeof(samples);
+  fan_out.Deliver(packet);
+  ASSERT_TRUE(WaitFor(count, 1));
+  EXPECT_TRUE(intact.load());
+  FanOutSinkStats stats;
+  ASSERT_TRUE(fan_out.GetStats(id, &stats));
+  EXPECT_EQ(stats.copied_packets, 1u);
+  EXPECT_EQ(stats.delivered_packets, 1u);
+}
+
+TEST(DropOldestKeepsTheNewestPackets) {
+  uint64_t dropped = 0;
+  std::vector<uint64_t> received =
+      ReceivedUnderPolicy(BackpressurePolicy::kDropOldest, &dropped);
+  EXPECT_TRUE(received == std::vector<uint64_t>({0, 3, 4}));
+  EXPECT_EQ(dropped, 2u);
+}
+
+TEST(DropNewestKeepsWhatIsQueued) {
+  uint64_t dropped = 0;
+  std::vector<uint64_t> received =
+      ReceivedUnderPolicy(BackpressurePolicy::kDropNewest, &dropped);
+  EXPECT_TRUE(received == std::vector<uint64_t>({0, 1, 2}));
+  EXPECT_EQ(dropped, 2u);
+}
+
+TEST(BlockWaitsForRoomInsteadOfDropping) {
+  PacketFanOut fan_out;
+  FramePool pool(8, 4);
+  std::atomic<int> count{0};
+  std::atomic<bool> in_order{true};
+  FanOutSinkConfig config;
+  config.max_packets = 1;
+  config.policy = BackpressurePolicy::kBlock;
+  const uint64_t id = fan_out.Attach(config, [&](const AudioPacket& packet) {
+    in_order = in_order && packet.data[0] == count.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ++count;
+  });
+  for (uint64_t sequence = 0; sequence < 20; ++sequence) {
+    FrameRef ref;
+    fan_out.Deliver(PooledPacket(&pool, sequence, &ref));
+  }
+  ASSERT_TRUE(WaitFor(count, 20));
+  FanOutSinkStats stats;
+  ASSERT_TRUE(fan_out.GetStats(id, &stats));
+  EXPECT_TRUE(in_order.load());
+  EXPECT_EQ(stats.dropped_packets, 0u);
+  EXPECT_EQ(stats.high_water_packets, 1u);
+}
+
+TEST(BoundsQueuesByBytesAndDuration) {
+  PacketFanOut fan_out;
+  FramePool pool(16, 4);
+  Gate gate;
+  std::atomic<int> count{0};
+  auto callback = [&](const AudioPacket&) {
+    gate.Wait();
+    ++count;
+  };
+  FanOutSinkConfig by_bytes;
+  by_bytes.max_bytes = 16;
+  by_bytes.max_duration_ms = 0;
+  FanOutSinkConfig by_duration;
+  by_duration.max_bytes = 0;
+  by_duration.max_duration_ms = 3;
+  const uint64_t bytes_id = fan_out.Attach(by_bytes, callback);
+  const uint64_t duration_id = fan_out.Attach(by_duration, callback);
+
+  FrameRef ref;
+  fan_out.Deliver(PooledPacket(&pool, 0, &ref));
+  FanOutSinkStats stats;
+  // Both sinks busy with the first packet.
+  while (fan_out.GetStats(bytes_id, &stats) && stats.queued_packets > 0) {
+    std::this_thread::yield();
+  }
+  while (fan_out.GetStats(duration_id, &stats) && stats.queued_packets > 0) {
+    std::this_thread::yield();
+  }
+  for (uint64_t sequence = 1; sequence <= 10; ++sequence) {
+    fan_out.Deliver(PooledPacket(&pool, sequence, &ref));
+  }
+  ref.Reset();
+
+  ASSERT_TRUE(fan_out.GetStats(bytes_id, &stats));
+  EXPECT_EQ(stats.queued_packets, 4u);
+  EXPECT_EQ(stats.queued_bytes, 16u);
+  EXPECT_EQ(stats.high_water_bytes, 16u);
+  EXPECT_EQ(stats.dropped_packets, 6u);
+  ASSERT_TRUE(fan_out.GetStats(duration_id, &stats));
+  EXPECT_EQ(stats.queued_packets, 3u);
+  EXPECT_EQ(stats.queued_ms, 3u);
+  EXPECT_EQ(stats.high_water_ms, 3u);
+  EXPECT_EQ(stats.dropped_packets, 7u);
+  // Frames held: one in flight per sink, the four and three queued.
+  EXPECT_EQ(pool.available(), 16u - 5u);
+  gate.Open();
+}
+
+TEST(CoalescesSilenceBeforeDroppingSpeech) {
+  PacketFanOut fan_out;
+  FramePool pool(16, 4);
+  Gate gate;
+  std::mutex mutex;
+  std::vector<AudioPacket> received;
+  std::atomic<int> count{0};
+  FanOutSinkConfig config;
+  config.max_packets = 4;
+  config.policy = BackpressurePolicy::kCoalesceSilence;
+  const uint64_t id = fan_out.Attach(config, [&](const AudioPacket& packet) {
+    gate.Wait();
+    std::lock_guard<std::mutex> lock(mutex);
+    received.push_back(packet);
+    ++count;
+  });
+
+  FrameRef ref;
+  fan_out.Deliver(PooledPacket(&pool, 0, &ref));
+  while (!gate.HasWaiter()) {
+    std::this_thread::yield();
+  }
+  // Queue: speech, three silent packets; then speech that needs room.
+  fan_out.Deliver(PooledPacket(&pool, 1, &ref));
+  for (uint64_t sequence = 2; sequence <= 4; ++sequence) {
+    fan_out.Deliver(PooledPacket(&pool, sequence, &ref, kPacketNoSpeech));
+  }
+  fan_out.Deliver(PooledPacket(&pool, 5, &ref));
+  ref.Reset();
+  gate.Open();
+  ASSERT_TRUE(WaitFor(count, 4));
+
+  FanOutSinkStats stats;
+  ASSERT_TRUE(fan_out.GetStats(id, &stats));
+  fan_out.Detach(id);
+  EXPECT_EQ(stats.dropped_packets, 0u);
+  EXPECT_EQ(stats.coalesced_packets, 3u);
+  ASSERT_TRUE(received.size() == 4u);
+  EXPECT_EQ(received[1].sequence, 1u);
+  // One marker for the silence, on its timeline.
+  EXPECT_TRUE((received[2].flags & kPacketSilenceMarker) != 0);
+  EXPECT_EQ(received[2].size, 0u);
+  EXPECT_EQ(received[2].position, 2u);
+  EXPECT_EQ(received[2].frames, 3u);
+  EXPECT_EQ(received[3].sequence, 5u);
+  EXPECT_EQ(received[3].size, 4u);
+}
+
+// A sink that never returns keeps only its share of the engine's frames,
+// so capture goes on for everyone else.
+TEST(StalledSinkLeavesCaptureToTheOthers) {
+  CaptureEngine engine(std::make_unique<SyntheticCaptureBackend>());
+  ASSERT_TRUE(engine.Initialize());
+  PacketFanOut fan_out;
+  Gate gate;
+  FanOutSinkConfig stalled_config;
+  stalled_config.policy = BackpressurePolicy::kCoalesceSilence;
+  const uint64_t stalled = fan_out.Attach(
+      stalled_config, [&](const AudioPacket&) { gate.Wait(); });
+  std::atomic<int> fast{0};
+  const uint64_t fast_id = fan_out.Attach(
+      FanOutSinkConfig(), [&](const AudioPacket&) { ++fast; });
+
+  CaptureSettings settings = CaptureSettingsForProfile(
+      CaptureProfile::kRealtime, AudioFormat{16000, 1, SampleType::kInt16});
+  ASSERT_TRUE(engine.Start(
+      StreamKind::kSystem, "", settings,
+      [&](const AudioPacket& packet) { fan_out.Deliver(packet); }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  engine.Stop(StreamKind::kSystem);
+  const CaptureStats stats = engine.GetStats(StreamKind::kSystem);
+  EXPECT_TRUE(WaitFor(fast, static_cast<int>(stats.packets_delivered)));
+  FanOutSinkStats fast_stats;
+  fan_out.GetStats(fast_id, &fast_stats);
+  gate.Open();
+  fan_out.Detach(stalled);
+
+  EXPECT_TRUE(stats.packets_captured > 50);
+  EXPECT_EQ(stats.overruns, 0u);
+  EXPECT_EQ(fast.load(), static_cast<int>(stats.packets_captured));
+  EXPECT_EQ(fast_stats.dropped_packets, 0u);
+}
+
+TEST(DetachHandsOverWhatIsQueued) {
+  PacketFanOut fan_out;
+  FramePool pool(8, 4);
+  Gate gate;
+  std::atomic<int> count{0};
+  const uint64_t id =
+      fan_out.Attach(FanOutSinkConfig(), [&](const AudioPacket&) {
+        gate.Wait();
+        ++count;
+      });
+  for (uint64_t sequence = 0; sequence < 5; ++sequence) {
+    FrameRef ref;
+    fan_out.Deliver(PooledPacket(&pool, sequence, &ref));
+  }
+  std::thread opener([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    gate.Open();
+  });
+  EXPECT_TRUE(fan_out.Detach(id));
+  opener.join();
+  EXPECT_EQ(count.load(), 5);
+  EXPECT_EQ(pool.available(), 8u);
+}
+
+TEST(AttachesAndDetachesWhileDelivering) {
+  PacketFanOut fan_out;
+  FramePool pool(64, 4);
+  std::atomic<bool> running{true};
+  std::atomic<bool> in_order{true};
+  std::thread producer([&]() {
+    uint64_t sequence = 0;
+    while (running) {
+      FrameRef ref;
+      if (pool.available() > 0) {
+        fan_out.Deliver(PooledPacket(&pool, sequence++, &ref));
+      }
+      std::this_thread::yield();
+    }
+  });
+  // A sink that stays attached throughout, and one that comes and goes.
+  uint64_t last_steady = 0;
+  std::atomic<int> steady_count{0};
+  const uint64_t steady =
+      fan_out.Attach(FanOutSinkConfig(), [&](const AudioPacket& packet) {
+        in_order = in_order &&
+                   (steady_count.load() == 0 || packet.sequence > last_steady);
+        last_steady = packet.sequence;
+        ++steady_count;
+      });
+  for (int round = 0; round < 50; ++round) {
+    std::atomic<int> count{0};
+    const uint64_t id =
+        fan_out.Attach(FanOutSinkConfig(), [&](const AudioPacket&) {
+          ++count;
+        });
+    EXPECT_TRUE(id != 0);
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    EXPECT_TRUE(fan_out.Detach(id));
+  }
+  running = false;
+  producer.join();
+  EXPECT_TRUE(fan_out.Detach(steady));
+  EXPECT_TRUE(steady_count.load() > 0);
+  EXPECT_TRUE(in_order.load());
+  EXPECT_EQ(pool.available(), 64u);
+}
+
+TEST(RefusesSinksBeyondTheLimit) {
+  PacketFanOut fan_out;
+  for (size_t i = 0; i < PacketFanOut::kMaxSinks; ++i) {
+    EXPECT_TRUE(fan_out.Attach(FanOutSinkConfig(), [](const AudioPacket&) {}) !=
+                0);
+  }
+  EXPECT_EQ(fan_out.Attach(FanOutSinkConfig(), [](const AudioPacket&) {}),
+            0u);
+}
+
+TEST(ParsesPolicyNames) {
+  BackpressurePolicy policy = BackpressurePolicy::kBlock;
+  EXPECT_TRUE(ParseBackpressurePolicy("drop_newest", &policy));
+  EXPECT_TRUE(policy == BackpressurePolicy::kDropNewest);
+  EXPECT_TRUE(ParseBackpressurePolicy("coalesce_silence", &policy));
+  EXPECT_TRUE(policy == BackpressurePolicy::kCoalesceSilence);
+  EXPECT_TRUE(!ParseBackpressurePolicy("lossy", &policy));
+  EXPECT_TRUE(policy == BackpressurePolicy::kCoalesceSilence);
+  EXPECT_EQ(std::string(BackpressurePolicyName(BackpressurePolicy::kBlock)),
+            std::string("block"));
+}
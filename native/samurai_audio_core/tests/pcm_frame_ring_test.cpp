@@ -0,0 +1,139 @@
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/pcm_frame_ring.h"
+#include "test_support.h"
+
+using samurai::AudioFormat;
+using samurai::MediaTimestamp;
+using samurai::PcmFrame;
+using samurai::PcmFrameRing;
+using samurai::SampleType;
+
+namespace {
+
+// 4-byte frames; 1 kHz makes a frame one millisecond.
+const AudioFormat kStereo16{1000, 2, SampleType::kInt16};
+const AudioFormat kMono32{1000, 1, SampleType::kInt32};
+
+}  // namespace
+
+TEST(RoundsCapacityUpToPowerOfTwo) {
+  PcmFrameRing ring(5, 16);
+  EXPECT_EQ(ring.capacity(), 8u);
+  EXPECT_TRUE(ring.Empty());
+}
+
+TEST(SplitsPacketsAcrossSlots) {
+  // 4-byte frames, 4 frames per slot.
+  PcmFrameRing ring(8, 16);
+  std::vector<uint8_t> packet(10 * 4);
+  for (size_t i = 0; i < packet.size(); ++i) {
+    packet[i] = static_cast<uint8_t>(i);
+  }
+  MediaTimestamp timestamp;
+  timestamp.position = 100;
+  timestamp.time_ns = 5000000000;
+  EXPECT_TRUE(ring.Write(packet.data(), 10, kStereo16, 7, timestamp));
+  EXPECT_EQ(ring.Size(), 3u);
+
+  std::vector<uint8_t> read;
+  uint32_t frames[3];
+  for (int i = 0; i < 3; ++i) {
+    const PcmFrame* frame = ring.Peek();
+    ASSERT_TRUE(frame != nullptr);
+    EXPECT_EQ(frame->flags, 7u);
+    // Each slot is stamped with its own first frame.
+    EXPECT_EQ(frame->timestamp.position, 100u + 4 * i);
+    EXPECT_EQ(frame->timestamp.time_ns, 5000000000 + 4000000 * i);
+    frames[i] = frame->frames;
+    read.insert(read.end(), frame->data, frame->data + frame->size);
+    ring.Pop();
+  }
+  EXPECT_EQ(frames[0], 4u);
+  EXPECT_EQ(frames[2], 2u);
+  EXPECT_TRUE(read == packet);
+  EXPECT_TRUE(ring.Peek() == nullptr);
+}
+
+TEST(CountsOverrunsWithoutPartialWrites) {
+  PcmFrameRing ring(2, 8);
+  uint8_t packet[24] = {};
+  EXPECT_TRUE(ring.Write(packet, 2, kStereo16, 0, MediaTimestamp()));
+  // Needs two slots but only one is free.
+  EXPECT_TRUE(!ring.Write(packet, 3, kStereo16, 0, MediaTimestamp()));
+  EXPECT_EQ(ring.Size(), 1u);
+  EXPECT_EQ(ring.overruns(), 1u);
+  EXPECT_EQ(ring.dropped_frames(), 3u);
+}
+
+TEST(MarkersTakeOneSlotWithoutSamples) {
+  PcmFrameRing ring(2, 8);
+  uint8_t packet[8] = {};
+  MediaTimestamp timestamp;
+  timestamp.position = 7;
+  EXPECT_TRUE(ring.WriteMarker(48000, 9, timestamp));
+  EXPECT_TRUE(ring.Write(packet, 2, kStereo16, 0, MediaTimestamp()));
+  EXPECT_TRUE(!ring.WriteMarker(10, 9, MediaTimestamp()));
+  EXPECT_EQ(ring.overruns(), 0u);
+
+  const PcmFrame* frame = ring.Peek();
+  ASSERT_TRUE(frame != nullptr);
+  EXPECT_EQ(frame->size, 0u);
+  EXPECT_EQ(frame->frames, 48000u);
+  EXPECT_EQ(frame->flags, 9u);
+  EXPECT_EQ(frame->timestamp.position, 7u);
+}
+
+TEST(KeptSlotsOutliveThePopAndBoundTheRing) {
+  PcmFrameRing ring(2, 4);
+  uint8_t packet[4] = {1, 2, 3, 4};
+  std::vector<samurai::FrameRef> kept;
+  // Two slots and four buffers: the fifth write finds none left.
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(ring.Write(packet, 1, kStereo16, 0, MediaTimestamp()));
+    kept.push_back(ring.Peek()->buffer);
+    ring.Pop();
+  }
+  EXPECT_TRUE(!ring.Write(packet, 1, kStereo16, 0, MediaTimestamp()));
+  EXPECT_EQ(ring.overruns(), 1u);
+  EXPECT_EQ(kept[3].size(), 4u);
+  EXPECT_EQ(kept[3].data()[3], 4);
+
+  kept.pop_back();
+  EXPECT_TRUE(ring.Write(packet, 1, kStereo16, 0, MediaTimestamp()));
+}
+
+TEST(PreservesOrderAcrossThreads) {
+  PcmFrameRing ring(16, sizeof(uint32_t));
+  const uint32_t kCount = 100000;
+
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < kCount;) {
+      if (ring.Write(reinterpret_cast<const uint8_t*>(&i), 1, kMono32, 0,
+                     MediaTimestamp())) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  bool in_order = true;
+  while (expected < kCount) {
+    const PcmFrame* frame = ring.Peek();
+    if (!frame) {
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t value;
+    std::memcpy(&value, frame->data, sizeof(value));
+    in_order = in_order && value == expected;
+    ring.Pop();
+    ++expected;
+  }
+  producer.join();
+  EXPECT_TRUE(in_order);
+}
@@ -0,0 +1,147 @@
+#include <cstdint>
+#include <vector>
+
+#include "samurai_audio_core/capture_backend.h"
+#include "samurai_audio_core/reframer.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr int64_t kMs = 1000000;
+
+struct Emitted {
+  std::vector<int16_t> samples;
+  uint32_t frames;
+  uint32_t flags;
+  bool has_data;
+  uintptr_t address;
+};
+
+struct Collector {
+  std::vector<Emitted> out;
+
+  Reframer::Output Output() {
+    return [this](const uint8_t* data, size_t size, uint32_t frames,
+                  uint32_t flags) {
+      const int16_t* samples = reinterpret_cast<const int16_t*>(data);
+      out.push_back(Emitted{
+          data ? std::vector<int16_t>(samples, samples + size / 2)
+               : std::vector<int16_t>(),
+          frames, flags, data != nullptr,
+          reinterpret_cast<uintptr_t>(data)});
+    };
+  }
+};
+
+// Mono 16 kHz: 20 ms is 320 frames.
+const AudioFormat kFormat{16000, 1, SampleType::kInt16};
+
+std::vector<int16_t> Ramp(int16_t start, size_t count) {
+  std::vector<int16_t> samples(count);
+  for (size_t i = 0; i < count; ++i) {
+    samples[i] = static_cast<int16_t>(start + i);
+  }
+  return samples;
+}
+
+const uint8_t* Bytes(const std::vector<int16_t>& samples) {
+  return reinterpret_cast<const uint8_t*>(samples.data());
+}
+
+}  // namespace
+
+TEST(EmitsExactFramesFromOddPackets) {
+  Reframer reframer(kFormat, 20, 100);
+  EXPECT_EQ(reframer.frame_frames(), 320u);
+  Collector collector;
+  const std::vector<int16_t> samples = Ramp(0, 1000);
+  // 441-frame device packets, as a 44.1 kHz device at 10 ms would give.
+  reframer.Push(Bytes(samples), 441, 0, 0, collector.Output());
+  reframer.Push(Bytes(samples) + 441 * 2, 441, 0, 0, collector.Output());
+  reframer.Push(Bytes(samples) + 882 * 2, 118, 0, 0, collector.Output());
+  ASSERT_TRUE(collector.out.size() == 3u);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(collector.out[i].frames, 320u);
+    EXPECT_EQ(collector.out[i].samples.size(), 320u);
+    EXPECT_EQ(collector.out[i].samples[0], static_cast<int16_t>(i * 320));
+    EXPECT_EQ(collector.out[i].samples[319],
+              static_cast<int16_t>(i * 320 + 319));
+  }
+  reframer.Flush(collector.Output());
+  ASSERT_TRUE(collector.out.size() == 4u);
+  EXPECT_EQ(collector.out[3].frames, 40u);
+  EXPECT_EQ(collector.out[3].samples[0], 960);
+}
+
+TEST(SupportsCommonFrameDurations) {
+  const uint32_t durations[] = {10, 20, 40, 60};
+  const uint32_t expected[] = {480, 960, 1920, 2880};
+  for (size_t i = 0; i < 4; ++i) {
+    Reframer reframer(AudioFormat{48000, 2, SampleType::kInt16},
+                      durations[i], 100);
+    EXPECT_EQ(reframer.frame_frames(), expected[i]);
+  }
+}
+
+TEST(FlagsMarkTheFrameHoldingTheirFirstFrame) {
+  Reframer reframer(kFormat, 10, 0);
+  Collector collector;
+  const std::vector<int16_t> samples = Ramp(0, 320);
+  reframer.Push(Bytes(samples), 150, 0, 0, collector.Output());
+  reframer.Push(Bytes(samples), 170, kPacketDiscontinuity, 0,
+                collector.Output());
+  ASSERT_TRUE(collector.out.size() == 2u);
+  EXPECT_EQ(collector.out[0].flags, kPacketDiscontinuity);
+  EXPECT_EQ(collector.out[1].flags, 0u);
+}
+
+TEST(TimeoutEmitsShortFrame) {
+  Reframer reframer(kFormat, 20, 30);
+  Collector collector;
+  EXPECT_EQ(reframer.deadline_ns(), Reframer::kNoDeadline);
+  const std::vector<int16_t> samples = Ramp(1, 100);
+  reframer.Push(Bytes(samples), 100, 0, 5 * kMs, collector.Output());
+  EXPECT_EQ(reframer.deadline_ns(), 35 * kMs);
+
+  reframer.Poll(34 * kMs, collector.Output());
+  EXPECT_TRUE(collector.out.empty());
+  reframer.Poll(35 * kMs, collector.Output());
+  ASSERT_TRUE(collector.out.size() == 1u);
+  EXPECT_EQ(collector.out[0].frames, 100u);
+  EXPECT_EQ(collector.out[0].samples, samples);
+  EXPECT_EQ(reframer.timeouts(), 1u);
+  EXPECT_EQ(reframer.deadline_ns(), Reframer::kNoDeadline);
+}
+
+TEST(SilenceMarkersPadTheOpenFrame) {
+  Reframer reframer(kFormat, 10, 100);
+  Collector collector;
+  const std::vector<int16_t> samples = Ramp(1, 100);
+  reframer.Push(Bytes(samples), 100, 0, 0, collector.Output());
+  reframer.Push(nullptr, 1000, kPacketSilenceMarker | kPacketNoSpeech, 0,
+                collector.Output());
+  ASSERT_TRUE(collector.out.size() == 2u);
+  // 100 captured frames and 60 of zeros...
+  EXPECT_EQ(collector.out[0].frames, 160u);
+  EXPECT_EQ(collector.out[0].samples[99], 100);
+  EXPECT_EQ(collector.out[0].samples[100], 0);
+  EXPECT_EQ(collector.out[0].samples[159], 0);
+  EXPECT_EQ(collector.out[0].flags, kPacketNoSpeech);
+  // ...then the rest of the marker passes through.
+  EXPECT_TRUE(!collector.out[1].has_data);
+  EXPECT_EQ(collector.out[1].frames, 940u);
+  EXPECT_EQ(collector.out[1].flags, kPacketSilenceMarker | kPacketNoSpeech);
+}
+
+TEST(FramesAreAligned) {
+  Reframer reframer(AudioFormat{44100, 2, SampleType::kInt24}, 10, 0);
+  Collector collector;
+  const std::vector<int16_t> samples(441 * 3, 7);
+  reframer.Push(Bytes(samples), 441, 0, 0, collector.Output());
+  reframer.Push(Bytes(samples), 441, 0, 0, collector.Output());
+  ASSERT_TRUE(collector.out.size() == 2u);
+  EXPECT_EQ(collector.out[0].address % 64, 0u);
+  EXPECT_EQ(collector.out[1].address, collector.out[0].address);
+}
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "samurai_audio_core/resampler.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+const ResamplerImpl kAllImpls[] = {ResamplerImpl::kScalar, ResamplerImpl::kSse2,
+                                   ResamplerImpl::kAvx2, ResamplerImpl::kNeon};
+const ResamplerQuality kAllQualities[] = {
+    ResamplerQuality::kLow, ResamplerQuality::kMedium, ResamplerQuality::kHigh};
+
+// Stereo tone; the right channel is inverted so channel mix-ups show.
+std::vector<float> Tone(double frequency, uint32_t rate, size_t frames,
+                        double amplitude) {
+  std::vector<float> samples(frames * 2);
+  for (size_t i = 0; i < frames; ++i) {
+    const float v = static_cast<float>(
+        amplitude * std::sin(2.0 * kPi * frequency * i / rate));
+    samples[i * 2] = v;
+    samples[i * 2 + 1] = -v;
+  }
+  return samples;
+}
+
+// Feeds |input| in random chunks (one call without |rng|) and returns the
+// concatenated output, checking MaxOutputFrames() on every call. Works for
+// Resampler and AdaptiveResampler.
+template <typename R>
+std::vector<float> Run(R* resampler, const std::vector<float>& input,
+                       std::mt19937* rng = nullptr) {
+  const size_t channels = resampler->channels();
+  const size_t frames = input.size() / channels;
+  std::vector<float> output;
+  size_t done = 0;
+  while (done < frames) {
+    size_t chunk = frames - done;
+    if (rng) {
+      chunk = std::min(chunk, static_cast<size_t>((*rng)() % 700));
+    }
+    std::vector<float> out(resampler->MaxOutputFrames(chunk) * channels);
+    const size_t produced =
+        resampler->Process(input.data() + done * channels, chunk, out.data());
+    EXPECT_TRUE(produced <= resampler->MaxOutputFrames(chunk));
+    output.insert(output.end(), out.begin(), out.begin() + produced * channels);
+    done += chunk;
+  }
+  return output;
+}
+
+// Error of the left channel against the ideal tone at the output rate,
+// skipping the start-up transient, in dB relative to the tone.
+double ToneErrorDb(const std::vector<float>& output, double frequency,
+                   uint32_t rate, double amplitude, size_t skip) {
+  double error = 0.0;
+  double signal = 0.0;
+  for (size_t i = skip; i < output.size() / 2; ++i) {
+    const double ideal = amplitude * std::sin(2.0 * kPi * frequency * i / rate);
+    error += (output[i * 2] - ideal) * (output[i * 2] - ideal);
+    signal += ideal * ideal;
+  }
+  return 10.0 * std::log10(error / signal);
+}
+
+double RmsDb(const std::vector<float>& output, size_t skip) {
+  double energy = 0.0;
+  size_t n = 0;
+  for (size_t i = skip * 2; i < output.size(); ++i, ++n) {
+    energy += output[i] * output[i];
+  }
+  return 10.0 * std::log10(energy / n + 1e-30);
+}
+
+}  // namespace
+
+TEST(ReducesTheRateRatio) {
+  Resampler down(48000, 16000, 2, ResamplerQuality::kMedium);
+  ASSERT_TRUE(down.IsValid());
+  EXPECT_EQ(down.phases(), 1u);
+  // 32 taps stretched by the 3:1 decimation.
+  EXPECT_EQ(down.taps(), 96u);
+
+  Resampler up(44100, 48000, 2, ResamplerQuality::kLow);
+  ASSERT_TRUE(up.IsValid());
+  EXPECT_EQ(up.phases(), 160u);
+  EXPECT_EQ(up.taps(), 16u);
+
+  EXPECT_TRUE(!Resampler(0, 16000, 2, ResamplerQuality::kLow).IsValid());
+  EXPECT_TRUE(!Resampler(48000, 16000, 0, ResamplerQuality::kLow).IsValid());
+  // Coprime rates would need a 44101-phase table.
+  EXPECT_TRUE(!Resampler(44100, 44101, 1, ResamplerQuality::kHigh).IsValid());
+}
+
+TEST(ParsesQualityNames) {
+  ResamplerQuality quality = ResamplerQuality::kMedium;
+  for (ResamplerQuality q : kAllQualities) {
+    EXPECT_TRUE(ParseResamplerQuality(ResamplerQualityName(q), &quality));
+    EXPECT_TRUE(quality == q);
+  }
+  EXPECT_TRUE(!ParseResamplerQuality("best", &quality));
+  EXPECT_TRUE(quality == ResamplerQuality::kHigh);
+}
+
+TEST(PreservesInBandTonesWithoutDelay) {
+  // Output frame k lands on input time k * M / L, so the ideal output is
+  // the same tone sampled at the output rate with no offset.
+  const uint32_t kRates[][2] = {
+      {48000, 16000}, {44100, 16000}, {48000, 44100}, {44100, 48000},
+      {16000, 48000}, {96000, 44100}};
+  const double kMaxErrorDb[] = {-55.0, -80.0, -105.0};
+  for (ResamplerQuality quality : kAllQualities) {
+    for (const auto& rates : kRates) {
+      Resampler resampler(rates[0], rates[1], 2, quality);
+      ASSERT_TRUE(resampler.IsValid());
+      std::vector<float> out =
+          Run(&resampler, Tone(1000.0, rates[0], rates[0] / 4, 0.5));
+      // Only the last taps/2 input frames of lookahead are still pending.
+      const size_t pending = resampler.taps() / 2 * rates[1] / rates[0] + 1;
+      EXPECT_TRUE(out.size() / 2 + pending >= rates[1] / 4);
+      EXPECT_TRUE(ToneErrorDb(out, 1000.0, rates[1], 0.5, 64) <
+                  kMaxErrorDb[static_cast<int>(quality)]);
+      // The right channel stays the inverse of the left.
+      EXPECT_NEAR(out[201], -out[200], 1e-6);
+    }
+  }
+}
+
+TEST(RejectsAliases) {
+  const double kMaxAliasDb[] = {-60.0, -75.0, -95.0};
+  const std::vector<float> input = Tone(11000.0, 48000, 12000, 0.5);
+  for (ResamplerQuality quality : kAllQualities) {
+    Resampler resampler(48000, 16000, 2, quality);
+    // 11 kHz is above the 8 kHz output Nyquist and would fold to 5 kHz.
+    std::vector<float> out = Run(&resampler, input);
+    EXPECT_TRUE(RmsDb(out, 64) - RmsDb(input, 0) <
+                kMaxAliasDb[static_cast<int>(quality)]);
+  }
+}
+
+TEST(PacketBoundariesDoNotChangeTheOutput) {
+  std::mt19937 rng(3);
+  const std::vector<float> input = Tone(440.0, 44100, 20000, 0.8);
+  for (ResamplerQuality quality : kAllQualities) {
+    Resampler whole(44100, 16000, 2, quality);
+    Resampler chunked(44100, 16000, 2, quality);
+    std::vector<float> expected = Run(&whole, input);
+    std::vector<float> actual = Run(&chunked, input, &rng);
+    EXPECT_TRUE(expected == actual);
+  }
+}
+
+TEST(AllImplementationsMatchScalar) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> input(4801 * 2);
+  for (float& v : input) {
+    v = dist(rng);
+  }
+  for (ResamplerQuality quality : kAllQualities) {
+    Resampler reference(48000, 44100, 2, quality, ResamplerImpl::kScalar);
+    const std::vector<float> expected = Run(&reference, input);
+    for (ResamplerImpl impl : kAllImpls) {
+      if (impl == ResamplerImpl::kScalar || !ResamplerImplSupported(impl)) {
+        continue;
+      }
+      Resampler simd(48000, 44100, 2, quality, impl);
+      const std::vector<float> actual = Run(&simd, input);
+      ASSERT_TRUE(actual.size() == expected.size());
+      float max_error = 0.0f;
+      for (size_t i = 0; i < actual.size(); ++i) {
+        max_error = std::max(max_error, std::fabs(actual[i] - expected[i]));
+      }
+      // Only the summation order differs.
+      EXPECT_TRUE(max_error < 1e-5f);
+    }
+  }
+}
+
+TEST(ResetRestartsTheStream) {
+  const std::vector<float> input = Tone(1000.0, 48000, 960, 0.5);
+  Resampler resampler(48000, 16000, 2, ResamplerQuality::kMedium);
+  const std::vector<float> first = Run(&resampler, input);
+  resampler.Reset();
+  EXPECT_TRUE(Run(&resampler, input) == first);
+}
+
+TEST(AdaptiveUnityRatioKeepsTheTone) {
+  const std::vector<float> input = Tone(1000.0, 16000, 16000, 0.5);
+  for (ResamplerQuality quality : kAllQualities) {
+    AdaptiveResampler resampler(2, quality);
+    ASSERT_TRUE(resampler.IsValid());
+    const std::vector<float> output = Run(&resampler, input);
+    EXPECT_TRUE(ToneErrorDb(output, 1000.0, 16000, 0.5, resampler.taps()) <
+                -60.0);
+  }
+}
+
+TEST(AdaptiveRatioTrimsTheStream) {
+  const std::vector<float> input = Tone(1000.0, 16000, 32000, 0.5);
+  std::mt19937 rng(3);
+  AdaptiveResampler chunked(2, ResamplerQuality::kMedium);
+  AdaptiveResampler whole(2, ResamplerQuality::kMedium);
+  chunked.SetRatio(1.002);
+  whole.SetRatio(1.002);
+  const std::vector<float> output = Run(&chunked, input, &rng);
+  EXPECT_TRUE(Run(&whole, input) == output);
+
+  // 0.2 % fewer frames, each read 1.002 input frames after the last: the
+  // same tone, 0.2 % higher.
+  const size_t produced = output.size() / 2;
+  EXPECT_NEAR(static_cast<double>(produced), 32000 / 1.002, 20.0);
+  EXPECT_NEAR(chunked.next_input_position(), produced * 1.002, 1e-6);
+  EXPECT_TRUE(ToneErrorDb(output, 1002.0, 16000, 0.5, chunked.taps()) <
+              -50.0);
+}
+
+TEST(AdaptiveRatioIsClamped) {
+  AdaptiveResampler resampler(1, ResamplerQuality::kLow);
+  resampler.SetRatio(2.0);
+  EXPECT_EQ(resampler.ratio(), 1.0 + AdaptiveResampler::kMaxAdjustment);
+  resampler.SetRatio(0.5);
+  EXPECT_EQ(resampler.ratio(), 1.0 - AdaptiveResampler::kMaxAdjustment);
+  // The slowest step still fits MaxOutputFrames().
+  std::vector<float> input(5000, 0.25f);
+  std::vector<float> output(resampler.MaxOutputFrames(input.size()));
+  const size_t produced =
+      resampler.Process(input.data(), input.size(), output.data());
+  EXPECT_TRUE(produced <= resampler.MaxOutputFrames(input.size()));
+  EXPECT_NEAR(output[produced - 1], 0.25f, 1e-4);
+}
@@ -0,0 +1,194 @@
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/mapped_file.h"
+#include "samurai_audio_core/spill_log.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+// 40-byte records take 56 bytes with their header: four to a segment.
+constexpr size_t kRecordBytes = 40;
+constexpr size_t kSegmentBytes = 4 * 56;
+
+// An empty directory for one test.
+std::string TempDir(const std::string& name) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / ("samurai_" + name);
+  std::filesystem::remove_all(path);
+  return path.string();
+}
+
+size_t FileCount(const std::string& directory) {
+  size_t count = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+    (void)entry;
+    ++count;
+  }
+  return count;
+}
+
+SpillLogConfig Config(const std::string& directory) {
+  SpillLogConfig config;
+  config.directory = directory;
+  config.segment_bytes = kSegmentBytes;
+  config.max_bytes = 16 * kSegmentBytes;
+  config.sync_bytes = 1 << 20;
+  config.sync_interval_ms = 0;
+  return config;
+}
+
+bool AppendRecord(SpillLog* log, uint8_t value) {
+  const std::vector<uint8_t> record(kRecordBytes, value);
+  return log->Append(record.data(), record.size(), 1000u * value);
+}
+
+// Pops the oldest record and returns its fill value, or -1.
+int PopRecord(SpillLog* log) {
+  SpillRecord record;
+  if (!log->Peek(&record) || record.size != kRecordBytes ||
+      record.ns != 1000u * record.data[0]) {
+    return -1;
+  }
+  const int value = record.data[0];
+  log->Pop(record.index);
+  return value;
+}
+
+}  // namespace
+
+TEST(ReadsBackInOrderAcrossSegments) {
+  const std::string dir = TempDir("spill_order");
+  SpillLog log(Config(dir));
+  ASSERT_TRUE(log.Open());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(AppendRecord(&log, static_cast<uint8_t>(i)));
+  }
+  EXPECT_EQ(FileCount(dir), 3u);
+  SpillLogStats stats = log.stats();
+  EXPECT_EQ(stats.pending_records, 10u);
+  EXPECT_EQ(stats.pending_bytes, 10 * kRecordBytes);
+  EXPECT_EQ(stats.pending_ns, 45000u);
+  EXPECT_EQ(stats.disk_bytes, 3 * kSegmentBytes);
+
+  bool in_order = true;
+  for (int i = 0; i < 10; ++i) {
+    in_order = in_order && PopRecord(&log) == i;
+  }
+  EXPECT_TRUE(in_order);
+  EXPECT_TRUE(log.empty());
+  // Read segments go, the last one too once nothing is unread.
+  EXPECT_EQ(FileCount(dir), 0u);
+  EXPECT_EQ(log.stats().consumed_records, 10u);
+
+  // Neither empty records nor ones bigger than a segment fit.
+  const std::vector<uint8_t> big(kSegmentBytes);
+  EXPECT_TRUE(!log.Append(big.data(), big.size(), 0));
+  EXPECT_TRUE(!log.Append(big.data(), 0, 0));
+}
+
+TEST(RecoversUnreadRecordsOnReopen) {
+  const std::string dir = TempDir("spill_recover");
+  {
+    SpillLog log(Config(dir));
+    ASSERT_TRUE(log.Open());
+    for (int i = 0; i < 10; ++i) {
+      AppendRecord(&log, static_cast<uint8_t>(i));
+    }
+    // The first segment is read and deleted, the second read into.
+    for (int i = 0; i < 5; ++i) {
+      PopRecord(&log);
+    }
+  }
+  SpillLog log(Config(dir));
+  ASSERT_TRUE(log.Open());
+  // Progress within a segment is not kept: record 4 comes again.
+  EXPECT_EQ(log.stats().recovered_records, 6u);
+  EXPECT_EQ(PopRecord(&log), 4);
+  // New records go after the recovered ones, in a segment of their own.
+  EXPECT_TRUE(AppendRecord(&log, 10));
+  bool in_order = true;
+  for (int i = 5; i <= 10; ++i) {
+    in_order = in_order && PopRecord(&log) == i;
+  }
+  EXPECT_TRUE(in_order);
+  EXPECT_TRUE(log.empty());
+}
+
+TEST(RecoveryStopsAtACorruptRecord) {
+  const std::string dir = TempDir("spill_corrupt");
+  {
+    SpillLog log(Config(dir));
+    ASSERT_TRUE(log.Open());
+    for (int i = 0; i < 3; ++i) {
+      AppendRecord(&log, static_cast<uint8_t>(i));
+    }
+  }
+  std::string segment;
+  for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+    segment = entry.path().string();
+  }
+  {
+    // A torn write: the second record's payload never made it.
+    MappedFile file;
+    ASSERT_TRUE(file.OpenWritable(segment, 0));
+    file.mutable_data()[56 + 16 + 5] ^= 0xFF;
+  }
+  SpillLog log(Config(dir));
+  ASSERT_TRUE(log.Open());
+  EXPECT_EQ(log.stats().recovered_records, 1u);
+  EXPECT_EQ(PopRecord(&log), 0);
+  EXPECT_TRUE(log.empty());
+}
+
+TEST(EvictsTheOldestSegmentPastTheDiskBound) {
+  const std::string dir = TempDir("spill_bound");
+  SpillLogConfig config = Config(dir);
+  config.max_bytes = 3 * kSegmentBytes;
+  SpillLog log(config);
+  ASSERT_TRUE(log.Open());
+  AppendRecord(&log, 0);
+  SpillRecord stale;
+  ASSERT_TRUE(log.Peek(&stale));
+  for (int i = 1; i < 20; ++i) {
+    EXPECT_TRUE(AppendRecord(&log, static_cast<uint8_t>(i)));
+  }
+  SpillLogStats stats = log.stats();
+  EXPECT_EQ(stats.disk_bytes, 3 * kSegmentBytes);
+  EXPECT_EQ(stats.dropped_records, 8u);
+  EXPECT_EQ(stats.pending_records, 12u);
+  EXPECT_EQ(FileCount(dir), 3u);
+  // Dropped since it was peeked: popping it takes nothing.
+  log.Pop(stale.index);
+  EXPECT_EQ(log.stats().pending_records, 12u);
+  EXPECT_EQ(PopRecord(&log), 8);
+}
+
+TEST(SyncsInBatches) {
+  const std::string dir = TempDir("spill_sync");
+  SpillLogConfig config = Config(dir);
+  config.sync_bytes = 3 * 56;
+  SpillLog log(config);
+  ASSERT_TRUE(log.Open());
+  for (int i = 0; i < 3; ++i) {
+    AppendRecord(&log, static_cast<uint8_t>(i));
+  }
+  EXPECT_EQ(log.stats().syncs, 1u);
+  // Starting a segment syncs the one before, however little is unsynced.
+  for (int i = 3; i < 5; ++i) {
+    AppendRecord(&log, static_cast<uint8_t>(i));
+  }
+  EXPECT_EQ(log.stats().syncs, 2u);
+  log.Close();
+  EXPECT_EQ(log.stats().syncs, 3u);
+
+  config.sync_bytes = 0;
+  SpillLog every(config);
+  ASSERT_TRUE(every.Open());
+  AppendRecord(&every, 9);
+  AppendRecord(&every, 9);
+  EXPECT_EQ(every.stats().syncs, 2u);
+}
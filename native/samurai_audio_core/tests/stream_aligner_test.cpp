@@ -0,0 +1,187 @@
+#include <cstdint>
+#include <vector>
+
+#include "samurai_audio_core/stream_aligner.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr int64_t kStartNs = 5000000000;
+const AudioFormat kMono{16000, 1, SampleType::kInt16};
+
+struct Collected {
+  std::vector<int16_t> left;
+  std::vector<int16_t> right;
+  std::vector<AudioPacket> packets;  // data is not valid after Output.
+
+  StreamAligner::Output Output() {
+    return [this](const AudioPacket& packet) {
+      const int16_t* samples = reinterpret_cast<const int16_t*>(packet.data);
+      for (uint32_t i = 0; i < packet.frames; ++i) {
+        left.push_back(samples[2 * i]);
+        right.push_back(samples[2 * i + 1]);
+      }
+      packets.push_back(packet);
+    };
+  }
+};
+
+// |frames| frames of |stream| starting at |position|, whose first frame
+// was captured at |time_ns|; sample i holds |base| + i.
+struct Feed {
+  std::vector<int16_t> samples;
+  AudioPacket packet;
+
+  Feed(StreamKind stream, uint64_t position, int64_t time_ns,
+       uint32_t frames, int16_t base) {
+    for (uint32_t i = 0; i < frames; ++i) {
+      samples.push_back(static_cast<int16_t>(base + i));
+    }
+    packet.stream = stream;
+    packet.format = kMono;
+    packet.data = reinterpret_cast<const uint8_t*>(samples.data());
+    packet.size = samples.size() * 2;
+    packet.frames = frames;
+    packet.position = position;
+    packet.capture_time_ns = time_ns;
+  }
+};
+
+int64_t TimeOf(uint64_t position) {
+  return kStartNs + static_cast<int64_t>(position) * 1000000000 / 16000;
+}
+
+}  // namespace
+
+TEST(InterleavesCustomerLeftAgentRight) {
+  StreamAligner aligner(StreamAlignerConfig{});
+  Collected out;
+  for (uint64_t position = 0; position < 640; position += 160) {
+    Feed system(StreamKind::kSystem, position, TimeOf(position), 160,
+                static_cast<int16_t>(1000 + position));
+    Feed mic(StreamKind::kMicrophone, position, TimeOf(position), 160,
+             static_cast<int16_t>(-1000 - static_cast<int>(position)));
+    EXPECT_TRUE(aligner.Push(system.packet, out.Output()));
+    EXPECT_TRUE(aligner.Push(mic.packet, out.Output()));
+  }
+  // 20 ms packets once both streams covered them.
+  ASSERT_TRUE(out.packets.size() == 2u);
+  for (size_t i = 0; i < 2; ++i) {
+    const AudioPacket& packet = out.packets[i];
+    EXPECT_TRUE(packet.stream == StreamKind::kAligned);
+    EXPECT_EQ(packet.format.channels, 2);
+    EXPECT_EQ(packet.frames, 320u);
+    EXPECT_EQ(packet.sequence, i);
+    EXPECT_EQ(packet.position, 320u * i);
+    EXPECT_EQ(packet.capture_time_ns, TimeOf(320 * i));
+  }
+  EXPECT_EQ(out.left[0], 1000);
+  EXPECT_EQ(out.right[0], -1000);
+  EXPECT_EQ(out.left[639], 1000 + 639);
+  EXPECT_EQ(out.right[639], -1480 + 159);
+  EXPECT_EQ(aligner.stats().filled_frames[0], 0u);
+  EXPECT_EQ(aligner.stats().filled_frames[1], 0u);
+}
+
+TEST(CompensatesDifferentStartTimes) {
+  StreamAligner aligner(StreamAlignerConfig{});
+  Collected out;
+  // The microphone started 5 ms (80 frames) after the loopback; both
+  // count positions from their own start.
+  Feed system(StreamKind::kSystem, 0, TimeOf(0), 400, 1);
+  Feed mic(StreamKind::kMicrophone, 0, TimeOf(80), 320, 5000);
+  EXPECT_TRUE(aligner.Push(system.packet, out.Output()));
+  EXPECT_TRUE(aligner.Push(mic.packet, out.Output()));
+  ASSERT_TRUE(out.packets.size() == 1u);
+  EXPECT_EQ(out.right[79], 0);
+  EXPECT_EQ(out.right[80], 5000);
+  EXPECT_EQ(out.left[80], 81);
+  EXPECT_EQ(out.right[319], 5000 + 239);
+  EXPECT_EQ(aligner.stats().filled_frames[1], 80u);
+}
+
+TEST(FillsAStreamThatFallsBehind) {
+  StreamAlignerConfig config;
+  config.max_wait_ms = 100;  // 1600 frames.
+  StreamAligner aligner(config);
+  Collected out;
+  Feed mic(StreamKind::kMicrophone, 0, TimeOf(0), 160, 7);
+  EXPECT_TRUE(aligner.Push(mic.packet, out.Output()));
+  // The loopback keeps going while the microphone stalls.
+  for (uint64_t position = 0; position < 3200; position += 320) {
+    Feed system(StreamKind::kSystem, position, TimeOf(position), 320, 1);
+    EXPECT_TRUE(aligner.Push(system.packet, out.Output()));
+  }
+  // Everything more than 100 ms behind the loopback went out.
+  ASSERT_TRUE(out.packets.size() >= 4u);
+  EXPECT_TRUE(out.packets.size() <= 5u);
+  EXPECT_EQ(out.right[0], 7);
+  EXPECT_EQ(out.right[160], 0);
+  EXPECT_TRUE(out.packets[0].flags & kPacketDiscontinuity);
+  EXPECT_EQ(aligner.stats().filled_frames[1],
+            out.packets.size() * 320 - 160);
+
+  // The stalled microphone finally delivers: the part that already went
+  // out is dropped as late.
+  Feed late(StreamKind::kMicrophone, 160, TimeOf(160), 320, 9);
+  EXPECT_TRUE(aligner.Push(late.packet, out.Output()));
+  EXPECT_EQ(aligner.stats().late_frames[1], 320u);
+}
+
+TEST(MarkersAndGapsBecomeSilence) {
+  StreamAligner aligner(StreamAlignerConfig{});
+  Collected out;
+  Feed system(StreamKind::kSystem, 0, TimeOf(0), 640, 1);
+  Feed speech(StreamKind::kMicrophone, 0, TimeOf(0), 100, 1);
+  Feed marker(StreamKind::kMicrophone, 100, TimeOf(100), 0, 0);
+  marker.packet.frames = 200;
+  marker.packet.flags = kPacketSilenceMarker | kPacketNoSpeech;
+  // The device lost 40 frames after the marker.
+  Feed resumed(StreamKind::kMicrophone, 340, TimeOf(340), 300, 500);
+  EXPECT_TRUE(aligner.Push(system.packet, out.Output()));
+  EXPECT_TRUE(aligner.Push(speech.packet, out.Output()));
+  EXPECT_TRUE(aligner.Push(marker.packet, out.Output()));
+  EXPECT_TRUE(aligner.Push(resumed.packet, out.Output()));
+  ASSERT_TRUE(out.packets.size() == 2u);
+  EXPECT_EQ(out.right[99], 100);
+  EXPECT_EQ(out.right[100], 0);
+  EXPECT_EQ(out.right[339], 0);
+  EXPECT_EQ(out.right[340], 500);
+  // Flagged on the packet where the gap starts.
+  EXPECT_TRUE(out.packets[0].flags & kPacketDiscontinuity);
+  EXPECT_EQ(out.packets[1].flags, 0u);
+}
+
+TEST(FlushEmitsTheRemainder) {
+  StreamAligner aligner(StreamAlignerConfig{});
+  Collected out;
+  Feed system(StreamKind::kSystem, 0, TimeOf(0), 400, 1);
+  Feed mic(StreamKind::kMicrophone, 0, TimeOf(0), 350, 1);
+  aligner.Push(system.packet, out.Output());
+  aligner.Push(mic.packet, out.Output());
+  ASSERT_TRUE(out.packets.size() == 1u);
+  aligner.Flush(out.Output());
+  ASSERT_TRUE(out.packets.size() == 2u);
+  EXPECT_EQ(out.packets[1].frames, 80u);
+  EXPECT_EQ(out.packets[1].position, 320u);
+  EXPECT_EQ(aligner.stats().filled_frames[1], 50u);
+}
+
+TEST(RejectsWhatItCannotAlign) {
+  StreamAligner aligner(StreamAlignerConfig{});
+  Collected out;
+  Feed encoded(StreamKind::kSystem, 0, TimeOf(0), 320, 0);
+  encoded.packet.codec = CodecId::kOpus;
+  EXPECT_TRUE(!aligner.Push(encoded.packet, out.Output()));
+  Feed stereo(StreamKind::kSystem, 0, TimeOf(0), 160, 0);
+  stereo.packet.format.channels = 2;
+  EXPECT_TRUE(!aligner.Push(stereo.packet, out.Output()));
+  Feed first(StreamKind::kSystem, 0, TimeOf(0), 160, 0);
+  EXPECT_TRUE(aligner.Push(first.packet, out.Output()));
+  Feed other_rate(StreamKind::kMicrophone, 0, TimeOf(0), 160, 0);
+  other_rate.packet.format.sample_rate = 48000;
+  EXPECT_TRUE(!aligner.Push(other_rate.packet, out.Output()));
+  EXPECT_EQ(aligner.stats().rejected_packets, 3u);
+}
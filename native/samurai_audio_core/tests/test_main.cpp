@@ -0,0 +1,3 @@
+#include "test_support.h"
+
+int main() { return samurai::testing::RunAllTests(); }
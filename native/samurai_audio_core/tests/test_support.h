@@ -0,0 +1,74 @@
+#ifndef SAMURAI_AUDIO_CORE_TESTS_TEST_SUPPORT_H_
+#define SAMURAI_AUDIO_CORE_TESTS_TEST_SUPPORT_H_
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Minimal self-registering test harness so the core has no third-party test
+// dependency. Each test source builds into its own ctest executable.
+namespace samurai {
+namespace testing {
+
+struct TestCase {
+  const char* name;
+  void (*fn)();
+};
+
+inline std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+inline int& FailureCount() {
+  static int failures = 0;
+  return failures;
+}
+
+struct Registrar {
+  Registrar(const char* name, void (*fn)()) { Registry().push_back({name, fn}); }
+};
+
+inline int RunAllTests() {
+  for (const TestCase& test : Registry()) {
+    int before = FailureCount();
+    test.fn();
+    std::printf("[%s] %s\n", FailureCount() == before ? " OK " : "FAIL",
+                test.name);
+  }
+  std::printf("%zu tests, %d failures\n", Registry().size(), FailureCount());
+  return FailureCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace testing
+}  // namespace samurai
+
+#define TEST(name)                                                  \
+  static void name();                                               \
+  static ::samurai::testing::Registrar name##_registrar(#name, name); \
+  static void name()
+
+#define EXPECT_TRUE(cond)                                                  \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,     \
+                   #cond);                                                 \
+      ++::samurai::testing::FailureCount();                                \
+    }                                                                      \
+  } while (0)
+
+#define EXPECT_EQ(a, b) EXPECT_TRUE((a) == (b))
+#define EXPECT_NEAR(a, b, tolerance) \
+  EXPECT_TRUE(((a) > (b) ? (a) - (b) : (b) - (a)) <= (tolerance))
+
+#define ASSERT_TRUE(cond)                                                  \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,     \
+                   #cond);                                                 \
+      ++::samurai::testing::FailureCount();                                \
+      return;                                                              \
+    }                                                                      \
+  } while (0)
+
+#endif  // SAMURAI_AUDIO_CORE_TESTS_TEST_SUPPORT_H_
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/transcode_jobs.h"
+#include "samurai_audio_core/wav_reader.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+// Collects events and lets the test wait for terminal ones.
+class EventLog {
+ public:
+  JobEventCallback Callback() {
+    return [this](const JobEvent& event) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      events_.push_back(event);
+      cv_.notify_all();
+    };
+  }
+
+  // Waits until |id| reaches a terminal state and returns it.
+  JobEvent WaitDone(uint64_t id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    JobEvent done;
+    cv_.wait_for(lock, std::chrono::seconds(10), [&]() {
+      for (const JobEvent& event : events_) {
+        if (event.id == id && event.state != JobState::kQueued &&
+            event.state != JobState::kRunning) {
+          done = event;
+          return true;
+        }
+      }
+      return false;
+    });
+    return done;
+  }
+
+  std::vector<JobEvent> All() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_;
+  }
+
+  std::vector<JobEvent> For(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<JobEvent> matching;
+    for (const JobEvent& event : events_) {
+      if (event.id == id) {
+        matching.push_back(event);
+      }
+    }
+    return matching;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<JobEvent> events_;
+};
+
+// Reports ten steps of progress, failing on request.
+bool StepRunner(const TranscodeRequest& request,
+                const TranscodeProgress& progress, std::string* error) {
+  for (int i = 1; i <= 10; ++i) {
+    if (!progress(i / 10.0)) {
+      return false;
+    }
+  }
+  if (request.input_path == "fail") {
+    *error = "boom";
+    return false;
+  }
+  return true;
+}
+
+// A one-second 440 Hz int16 mono WAV at |rate|.
+std::string WriteToneWav(const std::string& name, uint32_t rate) {
+  std::vector<int16_t> samples(rate);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i] = static_cast<int16_t>(
+        8000 * std::sin(2.0 * 3.14159265358979 * 440.0 * i / rate));
+  }
+  const uint32_t data_bytes = static_cast<uint32_t>(samples.size() * 2);
+  auto u32 = [](uint32_t v) {
+    return std::string(reinterpret_cast<char*>(&v), 4);
+  };
+  auto u16 = [](uint16_t v) {
+    return std::string(reinterpret_cast<char*>(&v), 2);
+  };
+  std::string header = "RIFF" + u32(36 + data_bytes) + "WAVEfmt " + u32(16) +
+                       u16(1) + u16(1) + u32(rate) + u32(rate * 2) + u16(2) +
+                       u16(16) + "data" + u32(data_bytes);
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / ("samurai_" + name);
+  std::ofstream file(path, std::ios::binary);
+  file.write(header.data(), static_cast<std::streamsize>(header.size()));
+  file.write(reinterpret_cast<const char*>(samples.data()), data_bytes);
+  return path.string();
+}
+
+}  // namespace
+
+TEST(ParsesJobStateNames) {
+  EXPECT_EQ(std::string(JobStateName(JobState::kQueued)), "queued");
+  EXPECT_EQ(std::string(JobStateName(JobState::kCancelled)), "cancelled");
+}
+
+TEST(JobsReportProgressAndResult) {
+  EventLog log;
+  TranscodeJobQueue queue(2, log.Callback(), StepRunner);
+  TranscodeRequest ok;
+  ok.input_path = "ok";
+  TranscodeRequest bad;
+  bad.input_path = "fail";
+  const uint64_t first = queue.Submit(ok);
+  const uint64_t second = queue.Submit(bad);
+  EXPECT_TRUE(first != 0 && second != 0 && first != second);
+
+  JobEvent done = log.WaitDone(first);
+  EXPECT_TRUE(done.state == JobState::kSucceeded);
+  EXPECT_NEAR(done.progress, 1.0, 1e-9);
+  std::vector<JobEvent> events = log.For(first);
+  ASSERT_TRUE(events.size() == 13);  // queued, running, 10 steps, result.
+  EXPECT_TRUE(events[0].state == JobState::kQueued);
+  EXPECT_TRUE(events[1].state == JobState::kRunning);
+  EXPECT_NEAR(events[6].progress, 0.5, 1e-9);
+
+  done = log.WaitDone(second);
+  EXPECT_TRUE(done.state == JobState::kFailed);
+  EXPECT_EQ(done.error, "boom");
+  EXPECT_TRUE(!queue.Cancel(second));
+}
+
+TEST(CancelStopsQueuedAndRunningJobs) {
+  EventLog log;
+  std::mutex gate;
+  std::unique_lock<std::mutex> hold(gate);
+  // Blocks in its first progress report until the test releases |gate|.
+  auto runner = [&](const TranscodeRequest&, const TranscodeProgress& progress,
+                    std::string*) {
+    std::lock_guard<std::mutex> wait(gate);
+    return progress(0.5);
+  };
+  TranscodeJobQueue queue(1, log.Callback(), runner);
+  const uint64_t running = queue.Submit(TranscodeRequest());
+  const uint64_t queued = queue.Submit(TranscodeRequest());
+  EXPECT_EQ(queue.outstanding(), 2u);
+
+  EXPECT_TRUE(queue.Cancel(queued));
+  EXPECT_TRUE(log.WaitDone(queued).state == JobState::kCancelled);
+  EXPECT_TRUE(queue.Cancel(running));
+  EXPECT_TRUE(!queue.Cancel(running));
+  hold.unlock();
+  EXPECT_TRUE(log.WaitDone(running).state == JobState::kCancelled);
+  EXPECT_EQ(queue.outstanding(), 0u);
+  EXPECT_TRUE(!queue.Cancel(12345));
+}
+
+TEST(DestructorCancelsOutstandingJobs) {
+  EventLog log;
+  uint64_t id = 0;
+  {
+    TranscodeJobQueue queue(1, log.Callback(), StepRunner);
+    for (int i = 0; i < 20; ++i) {
+      id = queue.Submit(TranscodeRequest());
+    }
+  }
+  const JobEvent last = log.WaitDone(id);
+  EXPECT_TRUE(last.state == JobState::kSucceeded ||
+              last.state == JobState::kCancelled);
+}
+
+TEST(BatchReportsAggregateProgress) {
+  EventLog log;
+  TranscodeJobQueue queue(2, log.Callback(), StepRunner);
+  std::vector<TranscodeRequest> requests(3);
+  requests[1].input_path = "fail";
+  std::vector<uint64_t> ids;
+  const uint64_t batch = queue.SubmitBatch(requests, &ids);
+  EXPECT_TRUE(batch != 0);
+  ASSERT_TRUE(ids.size() == 3);
+  EXPECT_EQ(queue.SubmitBatch({}, nullptr), 0u);
+
+  for (uint64_t id : ids) {
+    log.WaitDone(id);
+  }
+  EXPECT_TRUE(log.WaitDone(ids[1]).state == JobState::kFailed);
+  std::vector<JobEvent> events = log.All();
+  ASSERT_TRUE(events.size() == 3 * 13);
+  double last = 0.0;
+  for (const JobEvent& event : events) {
+    EXPECT_EQ(event.batch, batch);
+    EXPECT_TRUE(event.batch_progress >= last);
+    last = event.batch_progress;
+  }
+  // Only the last event delivered closes the batch; failures count as done.
+  EXPECT_EQ(events.back().batch_pending, 0u);
+  EXPECT_NEAR(events.back().batch_progress, 1.0, 1e-9);
+  EXPECT_EQ(events[events.size() - 2].batch_pending, 1u);
+  EXPECT_TRUE(!queue.CancelBatch(batch));
+}
+
+TEST(CancelBatchStopsEveryJob) {
+  EventLog log;
+  std::mutex gate;
+  std::unique_lock<std::mutex> hold(gate);
+  auto runner = [&](const TranscodeRequest&, const TranscodeProgress& progress,
+                    std::string*) {
+    std::lock_guard<std::mutex> wait(gate);
+    return progress(0.5);
+  };
+  TranscodeJobQueue queue(1, log.Callback(), runner);
+  std::vector<uint64_t> ids;
+  const uint64_t batch =
+      queue.SubmitBatch(std::vector<TranscodeRequest>(4), &ids);
+  EXPECT_TRUE(queue.CancelBatch(batch));
+  hold.unlock();
+  for (uint64_t id : ids) {
+    EXPECT_TRUE(log.WaitDone(id).state == JobState::kCancelled);
+  }
+  EXPECT_EQ(queue.outstanding(), 0u);
+}
+
+TEST(MemoryBudgetLimitsRunningJobs) {
+  EventLog log;
+  std::atomic<int> running{0};
+  std::atomic<int> peak{0};
+  auto runner = [&](const TranscodeRequest&, const TranscodeProgress&,
+                    std::string*) {
+    const int now = running.fetch_add(1) + 1;
+    int seen = peak.load();
+    while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    running.fetch_sub(1);
+    return true;
+  };
+  TranscodeJobQueue queue(4, log.Callback(), runner);
+  EXPECT_EQ(queue.workers(), 4u);
+  const size_t cost = TranscodeMemoryEstimate(TranscodeRequest());
+  EXPECT_TRUE(cost > 0);
+  queue.SetMemoryBudget(2 * cost);
+
+  std::vector<uint64_t> ids;
+  queue.SubmitBatch(std::vector<TranscodeRequest>(12), &ids);
+  for (uint64_t id : ids) {
+    EXPECT_TRUE(log.WaitDone(id).state == JobState::kSucceeded);
+  }
+  EXPECT_TRUE(peak.load() >= 1 && peak.load() <= 2);
+
+  // A job larger than the whole budget still runs, on its own.
+  queue.SetMemoryBudget(1);
+  peak.store(0);
+  ids.clear();
+  queue.SubmitBatch(std::vector<TranscodeRequest>(4), &ids);
+  for (uint64_t id : ids) {
+    EXPECT_TRUE(log.WaitDone(id).state == JobState::kSucceeded);
+  }
+  EXPECT_EQ(peak.load(), 1);
+}
+
+TEST(MemoryEstimateGrowsWithInput) {
+  TranscodeRequest request;
+  const size_t fixed = TranscodeMemoryEstimate(request);
+  request.input_path = WriteToneWav("estimate.wav", 16000);
+  EXPECT_TRUE(TranscodeMemoryEstimate(request) > fixed);
+  std::filesystem::remove(request.input_path);
+}
+
+TEST(TranscodesWavToWav) {
+  TranscodeRequest request;
+  request.input_path = WriteToneWav("tone_pcm.wav", 44100);
+  request.output_path = request.input_path + ".out.wav";
+  request.encoder.codec = CodecId::kPcm;
+  std::string error;
+  ASSERT_TRUE(TranscodeWavFile(request, nullptr, &error));
+  WavReader output;
+  ASSERT_TRUE(output.Open(request.output_path));
+  EXPECT_EQ(output.format().sample_rate, 44100u);
+  EXPECT_TRUE(output.format().sample_type == SampleType::kInt16);
+  EXPECT_EQ(output.frames(), 44100u);
+  std::filesystem::remove(request.output_path);
+  std::filesystem::remove(request.input_path);
+}
+
+TEST(TranscodesWavToMp3) {
+  TranscodeRequest request;
+  request.input_path = WriteToneWav("tone.wav", 44100);
+  request.output_path = request.input_path + ".mp3";
+  request.encoder.codec = CodecId::kMp3;
+  request.encoder.bitrate = 128000;
+
+  std::string error;
+  double last = 0.0;
+  const bool ok = TranscodeWavFile(
+      request, [&](double p) { last = p; return true; }, &error);
+  if (!AudioCodecAvailable(CodecId::kMp3)) {
+    EXPECT_TRUE(!ok);
+    EXPECT_EQ(error, "MP3 encoder not built in");
+  } else {
+    ASSERT_TRUE(ok);
+    EXPECT_NEAR(last, 1.0, 1e-9);
+    // ~16 KB at 128 kbps, starting with an MPEG audio frame sync.
+    std::ifstream mp3(request.output_path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(mp3)),
+                            std::istreambuf_iterator<char>());
+    EXPECT_TRUE(bytes.size() > 12000 && bytes.size() < 24000);
+    ASSERT_TRUE(bytes.size() > 2);
+    EXPECT_TRUE(static_cast<uint8_t>(bytes[0]) == 0xFF &&
+                (static_cast<uint8_t>(bytes[1]) & 0xE0) == 0xE0);
+  }
+  EXPECT_TRUE(!std::filesystem::exists(request.output_path + ".part"));
+  std::filesystem::remove(request.output_path);
+  std::filesystem::remove(request.input_path);
+}
+
+TEST(TranscodeRejectsBadInput) {
+  TranscodeRequest request;
+  request.input_path = "/nonexistent/samurai.wav";
+  request.output_path =
+      (std::filesystem::temp_directory_path() / "samurai_none.mp3").string();
+  std::string error;
+  request.encoder.codec = CodecId::kPcm;
+  EXPECT_TRUE(!TranscodeWavFile(request, nullptr, &error));
+  EXPECT_EQ(error, "Cannot read WAV file");
+  request.encoder.codec = CodecId::kMp3;
+  EXPECT_TRUE(!TranscodeWavFile(request, nullptr, &error));
+  EXPECT_TRUE(!std::filesystem::exists(request.output_path));
+}
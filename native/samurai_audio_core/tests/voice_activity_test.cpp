@@ -0,0 +1,211 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "samurai_audio_core/capture_backend.h"
+#include "samurai_audio_core/voice_activity.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+const VadImpl kAllImpls[] = {VadImpl::kScalar, VadImpl::kSse2,
+                             VadImpl::kAvx2, VadImpl::kNeon};
+
+AudioFormat FloatMono() {
+  AudioFormat format;
+  format.sample_rate = 16000;
+  format.channels = 1;
+  format.sample_type = SampleType::kFloat32;
+  return format;
+}
+
+std::vector<float> Tone(size_t frames, double frequency, float amplitude,
+                        uint32_t rate) {
+  std::vector<float> samples(frames);
+  for (size_t i = 0; i < frames; ++i) {
+    samples[i] =
+        amplitude * static_cast<float>(std::sin(2.0 * kPi * frequency * i /
+                                                rate));
+  }
+  return samples;
+}
+
+std::vector<float> Noise(size_t frames, float amplitude, std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-amplitude, amplitude);
+  std::vector<float> samples(frames);
+  for (float& v : samples) {
+    v = dist(*rng);
+  }
+  return samples;
+}
+
+VoiceActivity Feed(VoiceActivityDetector* vad, const std::vector<float>& in,
+                   uint16_t channels = 1, uint32_t flags = 0) {
+  return vad->Process(reinterpret_cast<const uint8_t*>(in.data()),
+                      static_cast<uint32_t>(in.size() / channels), flags);
+}
+
+}  // namespace
+
+TEST(ParsesPolicyNames) {
+  SilencePolicy policy = SilencePolicy::kForward;
+  for (SilencePolicy p :
+       {SilencePolicy::kForward, SilencePolicy::kDrop,
+        SilencePolicy::kMarkers}) {
+    EXPECT_TRUE(ParseSilencePolicy(SilencePolicyName(p), &policy));
+    EXPECT_TRUE(policy == p);
+  }
+  EXPECT_TRUE(!ParseSilencePolicy("mute", &policy));
+  EXPECT_TRUE(policy == SilencePolicy::kMarkers);
+}
+
+TEST(SeparatesToneFromSilenceAndNoise) {
+  VadConfig config;
+  config.hangover_ms = 0;
+  VoiceActivityDetector vad(FloatMono(), config);
+  ASSERT_TRUE(vad.IsValid());
+
+  EXPECT_TRUE(Feed(&vad, std::vector<float>(160)) == VoiceActivity::kSilence);
+  EXPECT_TRUE(Feed(&vad, Tone(160, 200.0, 0.1f, 16000)) ==
+              VoiceActivity::kSpeech);
+  EXPECT_NEAR(vad.last_energy_db(), -23.0, 0.2);
+  EXPECT_NEAR(vad.last_zero_crossing_rate(), 2.0 * 200 / 16000, 0.01);
+
+  // Loud white noise crosses zero about every other sample.
+  std::mt19937 rng(3);
+  EXPECT_TRUE(Feed(&vad, Noise(160, 0.3f, &rng)) == VoiceActivity::kSilence);
+  EXPECT_TRUE(vad.last_zero_crossing_rate() > 0.4f);
+
+  // Below the absolute threshold.
+  EXPECT_TRUE(Feed(&vad, Tone(160, 200.0, 0.001f, 16000)) ==
+              VoiceActivity::kSilence);
+}
+
+TEST(NoiseFloorTracksBackground) {
+  VadConfig config;
+  config.hangover_ms = 0;
+  config.floor_rise_db_per_second = 1000.0f;  // Settles within a packet.
+  VoiceActivityDetector vad(FloatMono(), config);
+  // A steady hum above the threshold becomes the floor; a tone 20 dB above
+  // it is speech, one only 6 dB above is not.
+  const std::vector<float> hum = Tone(160, 100.0, 0.01f, 16000);
+  for (int i = 0; i < 5; ++i) {
+    Feed(&vad, hum);
+  }
+  EXPECT_TRUE(Feed(&vad, hum) == VoiceActivity::kSilence);
+  EXPECT_NEAR(vad.noise_floor_db(), -43.0, 0.5);
+  EXPECT_TRUE(Feed(&vad, Tone(160, 100.0, 0.02f, 16000)) ==
+              VoiceActivity::kSilence);
+  Feed(&vad, hum);
+  EXPECT_TRUE(Feed(&vad, Tone(160, 100.0, 0.1f, 16000)) ==
+              VoiceActivity::kSpeech);
+}
+
+TEST(HangoverBridgesShortGaps) {
+  VadConfig config;
+  config.hangover_ms = 50;
+  VoiceActivityDetector vad(FloatMono(), config);
+  EXPECT_TRUE(Feed(&vad, Tone(160, 200.0, 0.1f, 16000)) ==
+              VoiceActivity::kSpeech);
+  // 40 ms of silence stays speech, the 60th ms does not.
+  const std::vector<float> gap(160);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(Feed(&vad, gap) == VoiceActivity::kSpeech);
+  }
+  EXPECT_TRUE(Feed(&vad, gap) == VoiceActivity::kSilence);
+}
+
+TEST(DeviceSilentPacketsAreNotAnalysed) {
+  VoiceActivityDetector vad(FloatMono(), VadConfig());
+  // Contents are undefined for silent packets.
+  EXPECT_TRUE(Feed(&vad, Tone(160, 200.0, 0.5f, 16000), 1, kPacketSilent) ==
+              VoiceActivity::kDeviceSilent);
+  EXPECT_NEAR(vad.last_energy_db(), -120.0, 1e-6);
+}
+
+TEST(WindowsSpanPackets) {
+  VadConfig config;
+  config.hangover_ms = 0;
+  VoiceActivityDetector vad(FloatMono(), config);
+  // 100 frames does not complete a 160-frame window.
+  std::vector<float> tone = Tone(300, 200.0, 0.1f, 16000);
+  std::vector<float> head(tone.begin(), tone.begin() + 100);
+  std::vector<float> tail(tone.begin() + 100, tone.end());
+  EXPECT_TRUE(Feed(&vad, head) == VoiceActivity::kSilence);
+  EXPECT_TRUE(Feed(&vad, tail) == VoiceActivity::kSpeech);
+}
+
+TEST(Int16MatchesFloat) {
+  AudioFormat format = FloatMono();
+  format.channels = 2;
+  std::vector<float> tone = Tone(640, 300.0, 0.2f, 16000);
+  std::vector<float> stereo(tone.size() * 2);
+  std::vector<int16_t> pcm(stereo.size());
+  for (size_t i = 0; i < stereo.size(); ++i) {
+    stereo[i] = tone[i / 2] * (i % 2 ? -1.0f : 1.0f);
+    pcm[i] = static_cast<int16_t>(std::lround(stereo[i] * 32767.0f));
+  }
+  VoiceActivityDetector as_float(format, VadConfig());
+  Feed(&as_float, stereo, 2);
+  format.sample_type = SampleType::kInt16;
+  VoiceActivityDetector as_int16(format, VadConfig());
+  as_int16.Process(reinterpret_cast<const uint8_t*>(pcm.data()), 640, 0);
+  EXPECT_NEAR(as_int16.last_energy_db(), as_float.last_energy_db(), 0.01);
+  EXPECT_NEAR(as_int16.last_zero_crossing_rate(),
+              as_float.last_zero_crossing_rate(), 0.01);
+
+  format.sample_type = SampleType::kInt24;
+  EXPECT_TRUE(!VoiceActivityDetector(format, VadConfig()).IsValid());
+}
+
+TEST(KernelsMatchScalar) {
+  std::mt19937 rng(11);
+  for (uint16_t channels : {1, 2, 3}) {
+    AudioFormat format = FloatMono();
+    format.channels = channels;
+    // Odd window sizes exercise the scalar tails.
+    for (uint32_t window_ms : {1u, 3u, 10u}) {
+      VadConfig config;
+      config.window_ms = window_ms;
+      const size_t samples =
+          static_cast<size_t>(16 * window_ms) * channels * 4 + 5 * channels;
+      std::vector<float> in = Noise(samples, 0.5f, &rng);
+      std::vector<int16_t> pcm(samples);
+      for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = static_cast<int16_t>(std::lround(in[i] * 32767.0f));
+      }
+
+      VoiceActivityDetector reference(format, config, VadImpl::kScalar);
+      Feed(&reference, in, channels);
+      AudioFormat int16_format = format;
+      int16_format.sample_type = SampleType::kInt16;
+      VoiceActivityDetector reference16(int16_format, config,
+                                        VadImpl::kScalar);
+      reference16.Process(reinterpret_cast<const uint8_t*>(pcm.data()),
+                          static_cast<uint32_t>(samples / channels), 0);
+
+      for (VadImpl impl : kAllImpls) {
+        if (impl == VadImpl::kScalar || !VadImplSupported(impl)) {
+          continue;
+        }
+        VoiceActivityDetector simd(format, config, impl);
+        Feed(&simd, in, channels);
+        EXPECT_NEAR(simd.last_energy_db(), reference.last_energy_db(), 1e-4);
+        EXPECT_NEAR(simd.last_zero_crossing_rate(),
+                    reference.last_zero_crossing_rate(), 1e-7);
+
+        VoiceActivityDetector simd16(int16_format, config, impl);
+        simd16.Process(reinterpret_cast<const uint8_t*>(pcm.data()),
+                       static_cast<uint32_t>(samples / channels), 0);
+        EXPECT_NEAR(simd16.last_energy_db(), reference16.last_energy_db(),
+                    1e-4);
+        EXPECT_NEAR(simd16.last_zero_crossing_rate(),
+                    reference16.last_zero_crossing_rate(), 1e-7);
+      }
+    }
+  }
+}
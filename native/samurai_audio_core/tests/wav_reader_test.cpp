@@ -0,0 +1,145 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "samurai_audio_core/wav_reader.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+namespace {
+
+void PutU16(std::vector<uint8_t>* out, uint16_t v) {
+  out->push_back(static_cast<uint8_t>(v));
+  out->push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void PutU32(std::vector<uint8_t>* out, uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    out->push_back(static_cast<uint8_t>(v >> (8 * i)));
+  }
+}
+
+void PutTag(std::vector<uint8_t>* out, const char* tag) {
+  for (int i = 0; i < 4; ++i) {
+    out->push_back(static_cast<uint8_t>(tag[i]));
+  }
+}
+
+// A RIFF file with an odd-sized chunk before "fmt " to check chunk
+// alignment. |extensible| writes WAVE_FORMAT_EXTENSIBLE around |tag|.
+std::vector<uint8_t> MakeWav(uint16_t tag, uint16_t channels, uint32_t rate,
+                             uint16_t bits, const std::vector<uint8_t>& data,
+                             bool extensible) {
+  std::vector<uint8_t> wav;
+  PutTag(&wav, "RIFF");
+  PutU32(&wav, 0);  // Patched below.
+  PutTag(&wav, "WAVE");
+  PutTag(&wav, "LIST");
+  PutU32(&wav, 3);
+  wav.insert(wav.end(), {'a', 'b', 'c', 0});
+
+  const uint16_t block_align = channels * bits / 8;
+  PutTag(&wav, "fmt ");
+  PutU32(&wav, extensible ? 40 : 16);
+  PutU16(&wav, extensible ? 0xFFFE : tag);
+  PutU16(&wav, channels);
+  PutU32(&wav, rate);
+  PutU32(&wav, rate * block_align);
+  PutU16(&wav, block_align);
+  PutU16(&wav, bits);
+  if (extensible) {
+    PutU16(&wav, 22);
+    PutU16(&wav, bits);
+    PutU32(&wav, 0);
+    PutU16(&wav, tag);  // First two bytes of the sub-format GUID.
+    for (int i = 0; i < 14; ++i) {
+      wav.push_back(0);
+    }
+  }
+  PutTag(&wav, "data");
+  PutU32(&wav, static_cast<uint32_t>(data.size()));
+  wav.insert(wav.end(), data.begin(), data.end());
+  const uint32_t riff = static_cast<uint32_t>(wav.size() - 8);
+  std::memcpy(wav.data() + 4, &riff, 4);
+  return wav;
+}
+
+std::string WriteTemp(const std::string& name,
+                      const std::vector<uint8_t>& bytes) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / ("samurai_" + name);
+  std::ofstream(path, std::ios::binary)
+      .write(reinterpret_cast<const char*>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+  return path.string();
+}
+
+}  // namespace
+
+TEST(ReadsInt16Pcm) {
+  std::vector<uint8_t> data = {1, 0, 2, 0, 3, 0, 4, 0, 5, 0, 6, 0};
+  const std::string path =
+      WriteTemp("int16.wav", MakeWav(1, 2, 16000, 16, data, false));
+  WavReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_EQ(reader.format().sample_rate, 16000u);
+  EXPECT_EQ(reader.format().channels, 2u);
+  EXPECT_TRUE(reader.format().sample_type == SampleType::kInt16);
+  EXPECT_EQ(reader.frames(), 3u);
+  EXPECT_TRUE(std::memcmp(reader.samples(), data.data(), data.size()) == 0);
+  reader.ReleaseBefore(2);
+  EXPECT_EQ(reader.samples()[8], 5);
+  std::filesystem::remove(path);
+}
+
+TEST(ReadsFloatAndExtensible) {
+  std::vector<uint8_t> data(4 * 5, 0);
+  std::string path =
+      WriteTemp("float.wav", MakeWav(3, 1, 48000, 32, data, false));
+  WavReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_TRUE(reader.format().sample_type == SampleType::kFloat32);
+  EXPECT_EQ(reader.frames(), 5u);
+  std::filesystem::remove(path);
+
+  data.resize(3 * 2 * 4);
+  path = WriteTemp("ext.wav", MakeWav(1, 2, 44100, 24, data, true));
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_TRUE(reader.format().sample_type == SampleType::kInt24);
+  EXPECT_EQ(reader.frames(), 4u);
+  std::filesystem::remove(path);
+}
+
+TEST(TruncatesUnfinalizedData) {
+  std::vector<uint8_t> wav = MakeWav(1, 1, 8000, 16, {1, 0, 2, 0, 3}, false);
+  // A writer that died before patching sizes.
+  const size_t data_size = wav.size() - 5 - 4;
+  const uint32_t unknown = 0xFFFFFFFF;
+  std::memcpy(wav.data() + data_size, &unknown, 4);
+  const std::string path = WriteTemp("partial.wav", wav);
+  WavReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_EQ(reader.frames(), 2u);
+  std::filesystem::remove(path);
+}
+
+TEST(RejectsOtherFiles) {
+  WavReader reader;
+  EXPECT_TRUE(!reader.Open("/nonexistent/samurai.wav"));
+
+  std::string path = WriteTemp("junk.wav", {'n', 'o', 't', ' ', 'a', ' ',
+                                            'w', 'a', 'v', 'e', '!', '!'});
+  EXPECT_TRUE(!reader.Open(path));
+  std::filesystem::remove(path);
+
+  // A-law and 8-bit PCM are not pipeline sample types.
+  path = WriteTemp("alaw.wav", MakeWav(6, 1, 8000, 8, {1, 2}, false));
+  EXPECT_TRUE(!reader.Open(path));
+  std::filesystem::remove(path);
+  path = WriteTemp("u8.wav", MakeWav(1, 1, 8000, 8, {1, 2}, false));
+  EXPECT_TRUE(!reader.Open(path));
+  std::filesystem::remove(path);
+}
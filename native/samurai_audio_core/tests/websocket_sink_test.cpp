@@ -0,0 +1,785 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/frame_protocol.h"
+#include "samurai_audio_core/websocket_client.h"
+#include "samurai_audio_core/websocket_sink.h"
+#include "test_support.h"
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace samurai;
+
+TEST(ParsesUrls) {
+  WebSocketUrl url;
+  ASSERT_TRUE(ParseWebSocketUrl("ws://example.com/stream?id=7", &url));
+  EXPECT_EQ(url.host, "example.com");
+  EXPECT_EQ(url.port, 80);
+  EXPECT_EQ(url.path, "/stream?id=7");
+
+  ASSERT_TRUE(ParseWebSocketUrl("ws://127.0.0.1:8080", &url));
+  EXPECT_EQ(url.host, "127.0.0.1");
+  EXPECT_EQ(url.port, 8080);
+  EXPECT_EQ(url.path, "/");
+
+  ASSERT_TRUE(ParseWebSocketUrl("ws://[::1]:9000/a", &url));
+  EXPECT_EQ(url.host, "::1");
+  EXPECT_EQ(url.port, 9000);
+
+  EXPECT_TRUE(!ParseWebSocketUrl("wss://example.com/", &url));
+  EXPECT_TRUE(!ParseWebSocketUrl("http://example.com/", &url));
+  EXPECT_TRUE(!ParseWebSocketUrl("ws:///path", &url));
+  EXPECT_TRUE(!ParseWebSocketUrl("ws://host:99999/", &url));
+}
+
+TEST(RecognisesLoopbackHosts) {
+  EXPECT_TRUE(IsLoopbackHost("localhost"));
+  EXPECT_TRUE(IsLoopbackHost("LocalHost"));
+  EXPECT_TRUE(IsLoopbackHost("127.0.0.1"));
+  EXPECT_TRUE(IsLoopbackHost("127.1.2.3"));
+  EXPECT_TRUE(IsLoopbackHost("::1"));
+  EXPECT_TRUE(!IsLoopbackHost("172.21.0.16"));
+  EXPECT_TRUE(!IsLoopbackHost("127.0.0.1.example.com"));
+  EXPECT_TRUE(!IsLoopbackHost("127.0.0"));
+  EXPECT_TRUE(!IsLoopbackHost("127.0.0.256"));
+  EXPECT_TRUE(!IsLoopbackHost("localhost.example.com"));
+  EXPECT_TRUE(!IsLoopbackHost(""));
+}
+
+TEST(AcceptKeyMatchesRfcExample) {
+  EXPECT_EQ(WebSocketAcceptKey("dGhlIHNhbXBsZSBub25jZQ=="),
+            "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+#if !defined(_WIN32)
+
+namespace {
+
+// A one-connection-at-a-time WebSocket server on 127.0.0.1 that records
+// the data messages it receives.
+class LoopbackServer {
+ public:
+  struct Options {
+    bool echo = false;
+    bool bad_accept = false;
+    // Drop the first connection without a close frame after this many
+    // messages, 0 right after the handshake; -1 never drops.
+    int drop_after = -1;
+    // Drop with a reset rather than a FIN, so the next send fails.
+    bool reset = false;
+  };
+
+  explicit LoopbackServer(Options options) : options_(options) {
+    listener_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener_, 4);
+    socklen_t length = sizeof(address);
+    getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    thread_ = std::thread([this]() { Serve(); });
+  }
+
+  ~LoopbackServer() {
+    stopping_ = true;
+    thread_.join();
+    close(listener_);
+  }
+
+  std::string url() const {
+    return "ws://127.0.0.1:" + std::to_string(port_) + "/stream";
+  }
+
+  bool WaitForMessages(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(10),
+                        [&]() { return messages_.size() >= count; });
+  }
+
+  std::vector<std::string> messages() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return messages_;
+  }
+
+  std::string request() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return request_;
+  }
+
+  int connections() const { return connections_; }
+  int drops() const { return drops_; }
+  int binary_messages() const { return binary_messages_; }
+
+ private:
+  void Serve() {
+    while (!stopping_) {
+      pollfd entry = {listener_, POLLIN, 0};
+      if (poll(&entry, 1, 20) <= 0) {
+        continue;
+      }
+      const int fd = accept(listener_, nullptr, nullptr);
+      if (fd < 0) {
+        continue;
+      }
+      ++connections_;
+      const bool dropped = Handle(fd);
+      if (dropped && options_.reset) {
+        linger reset = {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+      }
+      close(fd);
+      if (dropped) {
+        ++drops_;
+      }
+    }
+  }
+
+  // Reads exactly |size| bytes, giving up when the server stops.
+  bool Receive(int fd, uint8_t* out, size_t size) {
+    while (size > 0) {
+      if (stopping_) {
+        return false;
+      }
+      pollfd entry = {fd, POLLIN, 0};
+      if (poll(&entry, 1, 20) <= 0) {
+        continue;
+      }
+      const ssize_t got = recv(fd, out, size, 0);
+      if (got <= 0) {
+        return false;
+      }
+      out += got;
+      size -= static_cast<size_t>(got);
+    }
+    return true;
+  }
+
+  void SendFrame(int fd, uint8_t opcode, const std::string& payload) {
+    std::string frame;
+    frame.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+      frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+      frame.push_back(126);
+      frame.push_back(static_cast<char>(payload.size() >> 8));
+      frame.push_back(static_cast<char>(payload.size()));
+    } else {
+      frame.push_back(127);
+      for (int i = 7; i >= 0; --i) {
+        frame.push_back(static_cast<char>(
+            static_cast<uint64_t>(payload.size()) >> (i * 8)));
+      }
+    }
+    frame += payload;
+    send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+  }
+
+  // Returns true when it drops the connection on purpose.
+  bool Handle(int fd) {
+    std::string request;
+    uint8_t byte;
+    while (request.find("\r\n\r\n") == std::string::npos) {
+      if (!Receive(fd, &byte, 1)) {
+        return false;
+      }
+      request.push_back(static_cast<char>(byte));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      request_ = request;
+    }
+    const std::string marker = "Sec-WebSocket-Key: ";
+    const size_t start = request.find(marker) + marker.size();
+    const std::string key =
+        request.substr(start, request.find("\r\n", start) - start);
+    const std::string accept =
+        options_.bad_accept ? "AAAAAAAAAAAAAAAAAAAAAAAAAAA="
+                            : WebSocketAcceptKey(key);
+    const std::string response =
+        "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+        "Connection: Upgrade\r\nSec-WebSocket-Accept: " +
+        accept + "\r\n\r\n";
+    send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+    if (options_.drop_after == 0 && connections_ == 1) {
+      return true;
+    }
+
+    int received = 0;
+    while (true) {
+      uint8_t header[2];
+      if (!Receive(fd, header, 2)) {
+        return false;
+      }
+      const uint8_t opcode = header[0] & 0x0F;
+      uint64_t size = header[1] & 0x7F;
+      if (size >= 126) {
+        uint8_t extended[8];
+        const size_t bytes = size == 126 ? 2 : 8;
+        if (!Receive(fd, extended, bytes)) {
+          return false;
+        }
+        size = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+          size = (size << 8) | extended[i];
+        }
+      }
+      uint8_t mask[4];
+      if (!Receive(fd, mask, 4)) {
+        return false;
+      }
+      std::string payload(size, '\0');
+      if (size > 0 &&
+          !Receive(fd, reinterpret_cast<uint8_t*>(&payload[0]), size)) {
+        return false;
+      }
+      for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+      }
+      if (opcode == 0x8) {
+        SendFrame(fd, 0x8, payload);
+        return false;
+      }
+      if (opcode != 0x1 && opcode != 0x2) {
+        continue;
+      }
+      if (options_.echo) {
+        SendFrame(fd, opcode, payload);
+      }
+      if (opcode == 0x2) {
+        ++binary_messages_;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        messages_.push_back(payload);
+      }
+      cv_.notify_all();
+      if (++received == options_.drop_after && connections_ == 1) {
+        return true;
+      }
+    }
+  }
+
+  Options options_;
+  int listener_ = -1;
+  uint16_t port_ = 0;
+  std::atomic<bool> stopping_{false};
+  std::atomic<int> connections_{0};
+  std::atomic<int> drops_{0};
+  std::atomic<int> binary_messages_{0};
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::string> messages_;
+  std::string request_;
+};
+
+// Records sink events for later inspection.
+class SinkEvents {
+ public:
+  WebSocketSinkCallback Callback() {
+    return [this](const WebSocketSinkEvent& event) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      events_.push_back(event);
+    };
+  }
+
+  std::vector<WebSocketSinkEvent> All() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<WebSocketSinkEvent> events_;
+};
+
+AudioPacket PcmPacket(StreamKind stream, const std::vector<uint8_t>& bytes) {
+  AudioPacket packet;
+  packet.stream = stream;
+  packet.format = AudioFormat{16000, 1, SampleType::kInt16};
+  packet.data = bytes.data();
+  packet.size = bytes.size();
+  packet.frames = static_cast<uint32_t>(bytes.size() / 2);
+  return packet;
+}
+
+}  // namespace
+
+TEST(ClientEchoesTextAndBinary) {
+  LoopbackServer::Options options;
+  options.echo = true;
+  LoopbackServer server(options);
+  WebSocketClient client;
+  std::string error;
+  ASSERT_TRUE(client.Connect(server.url(), {"X-Test: 1"}, 2000, &error));
+  EXPECT_TRUE(client.is_open());
+
+  ASSERT_TRUE(client.SendText("hello"));
+  WebSocketOpcode opcode;
+  std::vector<uint8_t> payload;
+  ASSERT_TRUE(client.Read(2000, &opcode, &payload) ==
+              WebSocketClient::ReadResult::kMessage);
+  EXPECT_TRUE(opcode == WebSocketOpcode::kText);
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "hello");
+
+  // Past the 16-bit length form.
+  std::vector<uint8_t> big(70000);
+  for (size_t i = 0; i < big.size(); ++i) {
+    big[i] = static_cast<uint8_t>(i * 7);
+  }
+  ASSERT_TRUE(client.SendBinary(big.data(), big.size()));
+  ASSERT_TRUE(client.Read(2000, &opcode, &payload) ==
+              WebSocketClient::ReadResult::kMessage);
+  EXPECT_TRUE(opcode == WebSocketOpcode::kBinary);
+  EXPECT_TRUE(payload == big);
+
+  EXPECT_TRUE(server.request().find("GET /stream HTTP/1.1") == 0);
+  EXPECT_TRUE(server.request().find("X-Test: 1\r\n") != std::string::npos);
+  EXPECT_TRUE(client.Read(0, &opcode, &payload) ==
+              WebSocketClient::ReadResult::kTimeout);
+  client.Close();
+  EXPECT_TRUE(!client.is_open());
+}
+
+TEST(ClientRejectsBadAcceptKey) {
+  LoopbackServer::Options options;
+  options.bad_accept = true;
+  LoopbackServer server(options);
+  WebSocketClient client;
+  std::string error;
+  EXPECT_TRUE(!client.Connect(server.url(), {}, 2000, &error));
+  EXPECT_TRUE(error.find("Sec-WebSocket-Accept") != std::string::npos);
+  EXPECT_TRUE(!client.is_open());
+}
+
+TEST(SinkStreamsBinaryFrames) {
+  LoopbackServer server(LoopbackServer::Options{});
+  SinkEvents events;
+  WebSocketSinkConfig config;
+  config.url = server.url();
+  config.auth_token = "secret";
+  WebSocketSink sink(config, events.Callback());
+  ASSERT_TRUE(sink.Start());
+
+  const std::vector<uint8_t> bytes = {1, 2, 3, 4};
+  AudioPacket audio = PcmPacket(StreamKind::kSystem, bytes);
+  audio.sequence = 7;
+  sink.Deliver(audio);
+  AudioPacket silence = PcmPacket(StreamKind::kMicrophone, {});
+  silence.frames = 3200;
+  silence.flags = kPacketSilenceMarker;
+  sink.Deliver(silence);
+  ASSERT_TRUE(server.WaitForMessages(2));
+  sink.Stop();
+
+  const std::vector<std::string> messages = server.messages();
+  EXPECT_EQ(server.binary_messages(), 2);
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+  ASSERT_TRUE(DecodeFrame(reinterpret_cast<const uint8_t*>(messages[0].data()),
+                          messages[0].size(), &header,
+                          &payload) == messages[0].size());
+  EXPECT_TRUE(header.stream == StreamKind::kSystem);
+  EXPECT_EQ(header.sequence, 7u);
+  EXPECT_EQ(header.frames, 2u);
+  EXPECT_EQ(header.format.sample_rate, 16000u);
+  EXPECT_EQ(std::vector<uint8_t>(payload, payload + header.payload_bytes),
+            bytes);
+  ASSERT_TRUE(DecodeFrame(reinterpret_cast<const uint8_t*>(messages[1].data()),
+                          messages[1].size(), &header,
+                          &payload) == kFrameHeaderBytes);
+  EXPECT_TRUE(header.stream == StreamKind::kMicrophone);
+  EXPECT_EQ(header.frames, 3200u);
+  EXPECT_TRUE((header.flags & kPacketSilenceMarker) != 0);
+  EXPECT_TRUE(server.request().find("Authorization: Bearer secret\r\n") !=
+              std::string::npos);
+
+  const WebSocketSinkStats stats = sink.stats();
+  EXPECT_EQ(stats.messages_sent, 2u);
+  EXPECT_EQ(stats.messages_dropped, 0u);
+  EXPECT_EQ(stats.reconnects, 0u);
+  EXPECT_TRUE(stats.bytes_sent > messages[0].size() + messages[1].size());
+
+  const std::vector<WebSocketSinkEvent> all = events.All();
+  ASSERT_TRUE(all.size() >= 3);
+  EXPECT_TRUE(all.front().state == WebSocketSinkState::kConnecting);
+  EXPECT_TRUE(all[1].state == WebSocketSinkState::kConnected);
+  EXPECT_TRUE(all.back().state == WebSocketSinkState::kStopped);
+}
+
+TEST(SinkSendsAlignedStreamsAsOne) {
+  LoopbackServer server(LoopbackServer::Options{});
+  WebSocketSinkConfig config;
+  config.url = server.url();
+  config.align_streams = true;
+  WebSocketSink sink(config, nullptr);
+  ASSERT_TRUE(sink.Start());
+
+  // 20 ms from each speaker, then an encoded packet it cannot align.
+  const std::vector<uint8_t> customer(640, 1);
+  const std::vector<uint8_t> agent(640, 2);
+  sink.Deliver(PcmPacket(StreamKind::kSystem, customer));
+  sink.Deliver(PcmPacket(StreamKind::kMicrophone, agent));
+  AudioPacket encoded = PcmPacket(StreamKind::kMicrophone, {9, 9});
+  encoded.codec = CodecId::kOpus;
+  sink.Deliver(encoded);
+  ASSERT_TRUE(server.WaitForMessages(2));
+  sink.Stop();
+
+  const std::vector<std::string> messages = server.messages();
+  ASSERT_TRUE(messages.size() == 2u);
+  FrameHeader header;
+  const uint8_t* payload = nullptr;
+  ASSERT_TRUE(DecodeFrame(reinterpret_cast<const uint8_t*>(messages[0].data()),
+                          messages[0].size(), &header,
+                          &payload) == messages[0].size());
+  EXPECT_TRUE(header.stream == StreamKind::kAligned);
+  EXPECT_EQ(header.format.channels, 2);
+  EXPECT_EQ(header.frames, 320u);
+  // Left sample from the customer, right from the agent.
+  EXPECT_EQ(payload[0], 1);
+  EXPECT_EQ(payload[2], 2);
+  ASSERT_TRUE(DecodeFrame(reinterpret_cast<const uint8_t*>(messages[1].data()),
+                          messages[1].size(), &header, &payload) > 0);
+  EXPECT_TRUE(header.stream == StreamKind::kMicrophone);
+  EXPECT_TRUE(header.codec == CodecId::kOpus);
+  EXPECT_EQ(sink.stats().aligned_filled_frames, 0u);
+}
+
+TEST(SinkCancelsEchoOnTheAgentChannel) {
+  LoopbackServer server(LoopbackServer::Options{});
+  WebSocketSinkConfig config;
+  config.url = server.url();
+  config.align_streams = true;
+  config.cancel_echo = true;
+  config.echo.cpu_budget_percent = 0;
+  WebSocketSink sink(config, nullptr);
+  ASSERT_TRUE(sink.Start());
+
+  // Three seconds of the customer, heard 5 ms later and at half level by
+  // the agent's microphone.
+  const int kPackets = 150;
+  const size_t kFrames = 320;
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> noise(-8000, 8000);
+  std::vector<int16_t> customer(kPackets * kFrames);
+  for (int16_t& s : customer) {
+    s = static_cast<int16_t>(noise(rng));
+  }
+  std::vector<int16_t> agent(customer.size());
+  for (size_t n = 80; n < agent.size(); ++n) {
+    agent[n] = static_cast<int16_t>(customer[n - 80] / 2);
+  }
+  for (int i = 0; i < kPackets; ++i) {
+    for (auto* source : {&customer, &agent}) {
+      const uint8_t* bytes =
+          reinterpret_cast<const uint8_t*>(source->data() + i * kFrames);
+      AudioPacket packet = PcmPacket(
+          source == &customer ? StreamKind::kSystem : StreamKind::kMicrophone,
+          std::vector<uint8_t>());
+      packet.data = bytes;
+      packet.size = kFrames * 2;
+      packet.frames = kFrames;
+      packet.sequence = i;
+      packet.position = i * kFrames;
+      packet.capture_time_ns = i * 20000000ll;
+      sink.Deliver(packet);
+    }
+  }
+  ASSERT_TRUE(server.WaitForMessages(kPackets));
+  sink.Stop();
+
+  const std::vector<std::string> messages = server.messages();
+  ASSERT_TRUE(messages.size() == static_cast<size_t>(kPackets));
+  // The agent channel of the last second against what the microphone
+  // heard.
+  double heard = 0.0;
+  double sent = 0.0;
+  for (int i = kPackets - 50; i < kPackets; ++i) {
+    FrameHeader header;
+    const uint8_t* payload = nullptr;
+    ASSERT_TRUE(DecodeFrame(
+                    reinterpret_cast<const uint8_t*>(messages[i].data()),
+                    messages[i].size(), &header, &payload) > 0);
+    ASSERT_TRUE(header.frames == kFrames);
+    for (size_t n = 0; n < kFrames; ++n) {
+      int16_t right;
+      std::memcpy(&right, payload + 4 * n + 2, 2);
+      const double mic = agent[i * kFrames + n];
+      heard += mic * mic;
+      sent += static_cast<double>(right) * right;
+    }
+  }
+  EXPECT_TRUE(sent * 100.0 < heard);
+  const WebSocketSinkStats stats = sink.stats();
+  EXPECT_EQ(stats.echo_processed_frames, kPackets * kFrames);
+  EXPECT_EQ(stats.echo_bypassed_frames, 0u);
+  EXPECT_TRUE(stats.echo_erle_db > 20.0);
+}
+
+TEST(SinkReconnectsAfterDrop) {
+  LoopbackServer::Options options;
+  options.drop_after = 1;
+  LoopbackServer server(options);
+  SinkEvents events;
+  WebSocketSinkConfig config;
+  config.url = server.url();
+  config.reconnect_min_ms = 10;
+  WebSocketSink sink(config, events.Callback());
+  ASSERT_TRUE(sink.Start());
+
+  const std::vector<uint8_t> bytes = {0, 0};
+  sink.Deliver(PcmPacket(StreamKind::kSystem, bytes));
+  ASSERT_TRUE(server.WaitForMessages(1));
+  // Keep delivering until the sink notices the drop and comes back.
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (server.connections() < 2 &&
+         std::chrono::steady_clock::now() < deadline) {
+    sink.Deliver(PcmPacket(StreamKind::kSystem, bytes));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  sink.Deliver(PcmPacket(StreamKind::kSystem, bytes));
+  ASSERT_TRUE(server.WaitForMessages(2));
+  sink.Stop();
+
+  EXPECT_EQ(server.connections(), 2);
+  EXPECT_EQ(sink.stats().reconnects, 1u);
+  bool reconnecting = false;
+  for (const WebSocketSinkEvent& event : events.All()) {
+    if (event.state == WebSocketSinkState::kReconnecting) {
+      reconnecting = true;
+      EXPECT_TRUE(!event.error.empty());
+    }
+  }
+  EXPECT_TRUE(reconnecting);
+}
+
+TEST(SinkBoundsItsQueueByDuration) {
+  WebSocketSinkConfig config;
+  config.url = "ws://127.0.0.1:9/";  // Never started: nothing leaves.
+  config.max_queued_ms = 100;
+  WebSocketSink sink(config, nullptr);
+  // 20 ms each; markers hold no audio.
+  const std::vector<uint8_t> bytes(640);
+  for (int i = 0; i < 20; ++i) {
+    sink.Deliver(PcmPacket(StreamKind::kSystem, bytes));
+  }
+  AudioPacket silence;
+  silence.frames = 16000;
+  silence.flags = kPacketSilenceMarker;
+  sink.Deliver(silence);
+
+  const WebSocketSinkStats stats = sink.stats();
+  EXPECT_EQ(stats.messages_dropped, 15u);
+  EXPECT_EQ(stats.queued_ms, 100u);
+  EXPECT_EQ(stats.high_water_ms, 100u);
+  EXPECT_EQ(stats.queued_bytes, 6 * kFrameHeaderBytes + 5 * bytes.size());
+}
+
+TEST(SinkBlocksWhenFullUntilStopped) {
+  WebSocketSinkConfig config;
+  config.url = "ws://127.0.0.1:9/";
+  config.max_queued_ms = 40;
+  config.block_when_full = true;
+  WebSocketSink sink(config, nullptr);
+  const std::vector<uint8_t> bytes(640);
+  sink.Deliver(PcmPacket(StreamKind::kSystem, bytes));
+  sink.Deliver(PcmPacket(StreamKind::kSystem, bytes));
+  std::atomic<bool> delivered{false};
+  std::thread producer([&]() {
+    sink.Deliver(PcmPacket(StreamKind::kSystem, bytes));
+    delivered = true;
+  });
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (sink.stats().messages_blocked == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(!delivered.load());
+  sink.Stop();
+  producer.join();
+
+  const WebSocketSinkStats stats = sink.stats();
+  EXPECT_EQ(stats.messages_blocked, 1u);
+  // Released by Stop(): queued over the oldest rather than lost.
+  EXPECT_EQ(stats.messages_dropped, 1u);
+  EXPECT_EQ(stats.high_water_ms, 40u);
+}
+
+TEST(SinkSpillsWhileDownAndReplaysInOrder) {
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "samurai_sink_spill";
+  std::filesystem::remove_all(dir);
+  const std::vector<uint8_t> bytes(640);  // 20 ms.
+  WebSocketSinkConfig config;
+  config.spill.directory = dir.string();
+  config.reconnect_min_ms = 10;
+  {
+    // Nothing listens: the first attempt fails and everything spills.
+    config.url = "ws://127.0.0.1:9/";
+    SinkEvents events;
+    WebSocketSink sink(config, events.Callback());
+    ASSERT_TRUE(sink.Start());
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (events.All().size() < 2 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (uint32_t i = 0; i < 50; ++i) {
+      AudioPacket packet = PcmPacket(StreamKind::kSystem, bytes);
+      packet.sequence = i;
+      sink.Deliver(packet);
+    }
+    const WebSocketSinkStats stats = sink.stats();
+    EXPECT_EQ(stats.messages_spilled, 50u);
+    EXPECT_EQ(stats.spill_queued_ms, 1000u);
+    EXPECT_EQ(stats.queued_bytes, 0u);
+    sink.Stop();
+  }
+
+  // The next sink on the directory replays the log at 10x real time, and
+  // new audio waits behind it.
+  LoopbackServer server(LoopbackServer::Options{});
+  config.url = server.url();
+  config.replay_speed = 10.0f;
+  WebSocketSink sink(config, nullptr);
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(sink.Start());
+  AudioPacket live = PcmPacket(StreamKind::kSystem, bytes);
+  live.sequence = 50;
+  sink.Deliver(live);
+  ASSERT_TRUE(server.WaitForMessages(51));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  sink.Stop();
+
+  // The 50th spilled message is due after 49 x 20 ms / 10.
+  EXPECT_TRUE(elapsed >= std::chrono::milliseconds(98));
+  const std::vector<std::string> messages = server.messages();
+  bool in_order = true;
+  for (uint32_t i = 0; i < messages.size(); ++i) {
+    FrameHeader header;
+    const uint8_t* payload = nullptr;
+    in_order = in_order &&
+               DecodeFrame(reinterpret_cast<const uint8_t*>(messages[i].data()),
+                           messages[i].size(), &header, &payload) > 0 &&
+               header.sequence == i;
+  }
+  EXPECT_TRUE(in_order);
+  const WebSocketSinkStats stats = sink.stats();
+  EXPECT_EQ(stats.messages_replayed, 51u);
+  EXPECT_EQ(stats.spill_queued_bytes, 0u);
+  EXPECT_EQ(stats.spill_disk_bytes, 0u);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(SinkSpillsWhatADropSentBackWhenStopped) {
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "samurai_sink_spill_stop";
+  std::filesystem::remove_all(dir);
+  const std::vector<uint8_t> bytes(640);
+  WebSocketSinkConfig config;
+  config.spill.directory = dir.string();
+  {
+    // The server resets the connection once it is up, and the messages
+    // queued meanwhile fail to send and go back to the queue.
+    LoopbackServer::Options options;
+    options.drop_after = 0;
+    options.reset = true;
+    LoopbackServer server(options);
+    config.url = server.url();
+    config.reconnect_min_ms = 10000;  // Down until stopped.
+    WebSocketSink* sink_ptr = nullptr;
+    std::atomic<bool> down{false};
+    WebSocketSink sink(config, [&](const WebSocketSinkEvent& event) {
+      if (event.state == WebSocketSinkState::kReconnecting) {
+        down = true;
+      }
+      if (event.state != WebSocketSinkState::kConnected ||
+          event.stats.messages_sent > 0 || down) {
+        return;
+      }
+      while (server.drops() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      for (uint32_t i = 0; i < 10; ++i) {
+        AudioPacket packet = PcmPacket(StreamKind::kSystem, bytes);
+        packet.sequence = i;
+        sink_ptr->Deliver(packet);
+      }
+    });
+    sink_ptr = &sink;
+    ASSERT_TRUE(sink.Start());
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!down && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(down.load());
+    EXPECT_EQ(sink.stats().messages_spilled, 0u);
+    EXPECT_EQ(sink.stats().queued_ms, 200u);
+    sink.Stop();
+    EXPECT_EQ(sink.stats().messages_spilled, 10u);
+    EXPECT_EQ(sink.stats().queued_bytes, 0u);
+  }
+
+  LoopbackServer server(LoopbackServer::Options{});
+  config.url = server.url();
+  config.reconnect_min_ms = 10;
+  config.replay_speed = 0.0f;
+  WebSocketSink sink(config, nullptr);
+  ASSERT_TRUE(sink.Start());
+  ASSERT_TRUE(server.WaitForMessages(10));
+  sink.Stop();
+
+  const std::vector<std::string> messages = server.messages();
+  EXPECT_EQ(messages.size(), 10u);
+  bool in_order = true;
+  for (uint32_t i = 0; i < messages.size(); ++i) {
+    FrameHeader header;
+    const uint8_t* payload = nullptr;
+    in_order = in_order &&
+               DecodeFrame(reinterpret_cast<const uint8_t*>(messages[i].data()),
+                           messages[i].size(), &header, &payload) > 0 &&
+               header.sequence == i;
+  }
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(sink.stats().messages_replayed, 10u);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(SinkRejectsBadUrl) {
+  WebSocketSinkConfig config;
+  config.url = "https://example.com/";
+  WebSocketSink sink(config, nullptr);
+  EXPECT_TRUE(!sink.Start());
+}
+
+TEST(SinkKeepsTokensOffTheNetwork) {
+  WebSocketSinkConfig config;
+  config.url = "ws://172.21.0.16:8000/audio";
+  config.auth_token = "secret";
+  WebSocketSink sink(config, nullptr);
+  EXPECT_TRUE(!sink.Start());
+}
+
+#endif  // !defined(_WIN32)
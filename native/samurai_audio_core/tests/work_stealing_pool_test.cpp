@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "samurai_audio_core/work_stealing_pool.h"
+#include "test_support.h"
+
+using namespace samurai;
+
+TEST(SizesToCoreCount) {
+  WorkStealingPool pool(0);
+  EXPECT_EQ(pool.threads(),
+            static_cast<size_t>(
+                std::max(1u, std::thread::hardware_concurrency())));
+  EXPECT_EQ(WorkStealingPool(3).threads(), 3u);
+}
+
+TEST(RunsEveryTaskBeforeDestruction) {
+  std::atomic<int> runs{0};
+  {
+    WorkStealingPool pool(4);
+    for (int i = 0; i < 1000; ++i) {
+      pool.Submit([&runs]() { runs.fetch_add(1); });
+    }
+  }
+  EXPECT_EQ(runs.load(), 1000);
+}
+
+TEST(SingleWorkerRunsInOrder) {
+  std::vector<int> order;
+  {
+    WorkStealingPool pool(1);
+    for (int i = 0; i < 50; ++i) {
+      pool.Submit([&order, i]() { order.push_back(i); });
+    }
+  }
+  ASSERT_TRUE(order.size() == 50);
+  EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+}
+
+TEST(IdleWorkersStealFromBusyOnes) {
+  std::atomic<int> runs{0};
+  WorkStealingPool pool(2);
+  // Tasks submitted from a worker land on its own deque; it then stays
+  // busy until they are done, so only stealing can finish them.
+  pool.Submit([&]() {
+    for (int i = 0; i < 20; ++i) {
+      pool.Submit([&runs]() { runs.fetch_add(1); });
+    }
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (runs.load() < 20 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (runs.load() < 20 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(runs.load(), 20);
+  EXPECT_TRUE(pool.steals() >= 20u);
+}
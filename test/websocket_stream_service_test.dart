@@ -0,0 +1,51 @@
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+import 'package:samurai/services/audio_service.dart';
+import 'package:samurai/services/websocket_stream_service.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+  final messenger =
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+  final methods = <String>[];
+
+  setUp(() {
+    methods.clear();
+    // The runner refuses everything; only the calls made are of interest.
+    messenger.setMockMethodCallHandler(
+        const MethodChannel('com.samurai.audio_capture'), (call) async {
+      methods.add(call.method);
+      return false;
+    });
+    for (final name in [
+      'com.samurai.audio_capture/pcm',
+      'com.samurai.audio_capture/jobs',
+      'com.samurai.audio_capture/stream',
+    ]) {
+      messenger.setMockMethodCallHandler(
+          MethodChannel(name), (call) async => null);
+    }
+  });
+
+  test('wss:// uses the Dart client even where the runner streams', () async {
+    final service = WebSocketStreamService(audioService: AudioService());
+    expect(service.canConnectNatively('wss://127.0.0.1:9/audio'), isFalse);
+
+    // Nothing listens; what matters is which client tried.
+    expect(await service.connect('wss://127.0.0.1:9/audio'), isFalse);
+    expect(methods, isNot(contains('startNativeStreaming')));
+    expect(service.isNative, isFalse);
+  });
+
+  test('ws:// goes to the native sink where the runner streams', () async {
+    final audioService = AudioService();
+    final service = WebSocketStreamService(audioService: audioService);
+    expect(service.canConnectNatively('ws://127.0.0.1:9/audio'),
+        audioService.nativeStreaming);
+
+    expect(await service.connect('ws://127.0.0.1:9/audio'), isFalse);
+    expect(methods.contains('startNativeStreaming'),
+        audioService.nativeStreaming);
+  });
+}
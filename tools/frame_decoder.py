@@ -0,0 +1,154 @@
+"""Reference decoder for the binary audio frames the app streams.
+
+Each WebSocket binary message is one frame: a fixed little-endian header
+followed by the payload. The layout is defined in
+native/samurai_audio_core/include/samurai_audio_core/frame_protocol.h:
+
+    version u8, header size u8, stream u8, codec u8, flags u16,
+    channels u8, sample type u8, capture time ns i64, sample rate u32,
+    frames u32, sequence u32, payload size u32, position u64
+
+The position (frames since the stream started, lost frames included) is
+absent from 32-byte headers; capture times of both streams share one
+monotonic host clock, so either lines the customer and agent up.
+
+Stream 0 is the system loopback (customer), stream 1 the microphone
+(agent), stream 2 both aligned into stereo (customer left, agent right). Silence markers carry no payload; their frame count is the
+duration. Usage from a server:
+
+    frame = decode_frame(message)
+    if frame.is_silence_marker:
+        handle_silence(frame.source, frame.duration_ms)
+    else:
+        handle_audio(frame.source, frame.mime_type, frame.payload)
+
+Run as a script to decode frames stored back to back in a file.
+"""
+
+import struct
+import sys
+from dataclasses import dataclass
+
+PROTOCOL_VERSION = 1
+HEADER = struct.Struct("<BBBBHBBqIIII")
+HEADER_MIN_BYTES = HEADER.size  # 32
+POSITION = struct.Struct("<Q")
+HEADER_BYTES = HEADER_MIN_BYTES + POSITION.size  # 40
+
+SOURCES = ("customer", "agent", "aligned")
+CODECS = ("pcm", "opus", "mp3")
+SAMPLE_TYPES = ("int16", "int24", "int32", "float32")
+SAMPLE_BITS = (16, 24, 32, 32)
+
+FLAG_DEVICE_SILENT = 1 << 0
+FLAG_DISCONTINUITY = 1 << 1
+FLAG_NO_SPEECH = 1 << 2
+FLAG_SILENCE_MARKER = 1 << 3
+
+
+class FrameError(ValueError):
+    """The bytes are not a complete frame of a known version."""
+
+
+@dataclass
+class Frame:
+    stream: int
+    codec: str
+    flags: int
+    channels: int
+    sample_type: str
+    capture_time_ns: int
+    sample_rate: int
+    frames: int
+    sequence: int
+    payload: bytes
+    size: int  # Bytes the frame occupied, header included.
+    position: int = None  # None when the sender's header has no position.
+
+    @property
+    def source(self):
+        return SOURCES[self.stream]
+
+    @property
+    def is_silence_marker(self):
+        return bool(self.flags & FLAG_SILENCE_MARKER)
+
+    @property
+    def duration_ms(self):
+        return self.frames * 1000 // self.sample_rate
+
+    @property
+    def mime_type(self):
+        """The mime strings the JSON protocol used to carry."""
+        if self.codec == "opus":
+            return "audio/opus;rate=%d;channels=%d" % (self.sample_rate,
+                                                       self.channels)
+        if self.codec == "mp3":
+            return "audio/mpeg"
+        type_index = SAMPLE_TYPES.index(self.sample_type)
+        mime = "audio/pcm;rate=%d;channels=%d;bitdepth=%d" % (
+            self.sample_rate, self.channels, SAMPLE_BITS[type_index])
+        if self.sample_type == "float32":
+            mime += ";encoding=float"
+        return mime
+
+
+def decode_frame(data, offset=0):
+    """Decodes the frame starting at data[offset]. Raises FrameError."""
+    if len(data) - offset < HEADER_MIN_BYTES:
+        raise FrameError("truncated header")
+    (version, header_bytes, stream, codec, flags, channels, sample_type,
+     capture_time_ns, sample_rate, frames, sequence,
+     payload_bytes) = HEADER.unpack_from(data, offset)
+    if version != PROTOCOL_VERSION:
+        raise FrameError("unsupported version %d" % version)
+    # Newer senders of the same version may append header fields.
+    if header_bytes < HEADER_MIN_BYTES:
+        raise FrameError("header too short")
+    if offset + header_bytes > len(data):
+        raise FrameError("truncated header")
+    position = None
+    if header_bytes >= HEADER_BYTES:
+        (position,) = POSITION.unpack_from(data, offset + HEADER_MIN_BYTES)
+    if stream >= len(SOURCES) or codec >= len(CODECS):
+        raise FrameError("unknown stream or codec")
+    if sample_type >= len(SAMPLE_TYPES) or channels == 0 or sample_rate == 0:
+        raise FrameError("bad format")
+    start = offset + header_bytes
+    end = start + payload_bytes
+    if end > len(data):
+        raise FrameError("truncated payload")
+    return Frame(stream, CODECS[codec], flags, channels,
+                 SAMPLE_TYPES[sample_type], capture_time_ns, sample_rate,
+                 frames, sequence, bytes(data[start:end]), end - offset,
+                 position)
+
+
+def decode_frames(data):
+    """Yields the frames stored back to back in data."""
+    offset = 0
+    while offset < len(data):
+        frame = decode_frame(data, offset)
+        offset += frame.size
+        yield frame
+
+
+def main(argv):
+    if len(argv) != 2:
+        print("usage: %s FRAMES_FILE" % argv[0], file=sys.stderr)
+        return 2
+    with open(argv[1], "rb") as f:
+        data = f.read()
+    for frame in decode_frames(data):
+        kind = ("silence %d ms" % frame.duration_ms
+                if frame.is_silence_marker else
+                "%d bytes %s" % (len(frame.payload), frame.mime_type))
+        where = "" if frame.position is None else "@%d " % frame.position
+        print("%-8s #%-6d t=%.6fs %s%5d frames  %s" %
+              (frame.source, frame.sequence, frame.capture_time_ns / 1e9,
+               where, frame.frames, kind))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -1,4 +1,7 @@
 #include "audio_capture.h"
+#include <avrt.h>
+#include <mmreg.h>
+#include <ksmedia.h>
 #include <iostream>
 #include <algorithm>
 
@@ -6,23 +9,205 @@ const CLSID CLSID_MMDeviceEnumerator = __uuidof(MMDeviceEnumerator);
 const IID IID_IMMDeviceEnumerator = __uuidof(IMMDeviceEnumerator);
 
 constexpr REFERENCE_TIME REFTIMES_PER_SEC = 10000000;
-constexpr REFERENCE_TIME REFTIMES_PER_MILLISEC = 10000;
-constexpr UINT32 SAMPLE_RATE = 44100;
-constexpr UINT32 CHANNELS = 2;
-constexpr UINT32 BITS_PER_SAMPLE = 16;
-constexpr UINT32 BLOCK_ALIGN = CHANNELS * BITS_PER_SAMPLE / 8;
-constexpr UINT32 BYTES_PER_SECOND = SAMPLE_RATE * BLOCK_ALIGN;
-
-AudioCapture::AudioCapture()
-    : device_enumerator_(nullptr),
-      system_audio_capturing_(false),
-      microphone_capturing_(false),
-      should_stop_(false) {
+
+namespace {
+
+// Maps a negotiated WASAPI format onto the core's format description. The
+// sample type follows the container size, so 24-in-32 formats read as int32;
+// valid bits are left-aligned, so narrowing them to int16 is still correct.
+bool ToAudioFormat(const WAVEFORMATEX* wfx, samurai::AudioFormat* format) {
+  bool is_float = wfx->wFormatTag == WAVE_FORMAT_IEEE_FLOAT;
+  if (wfx->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+    if (wfx->cbSize < sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX)) {
+      return false;
+    }
+    const auto* ext = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(wfx);
+    is_float = IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
+    if (!is_float && !IsEqualGUID(ext->SubFormat, KSDATAFORMAT_SUBTYPE_PCM)) {
+      return false;  // Compressed or otherwise opaque samples.
+    }
+  } else if (wfx->wFormatTag != WAVE_FORMAT_PCM && !is_float) {
+    return false;
+  }
+
+  format->sample_rate = wfx->nSamplesPerSec;
+  format->channels = wfx->nChannels;
+  switch (wfx->wBitsPerSample) {
+    case 16:
+      format->sample_type = samurai::SampleType::kInt16;
+      break;
+    case 24:
+      format->sample_type = samurai::SampleType::kInt24;
+      break;
+    case 32:
+      format->sample_type = is_float ? samurai::SampleType::kFloat32
+                                     : samurai::SampleType::kInt32;
+      break;
+    default:
+      return false;
+  }
+  return format->BlockAlign() == wfx->nBlockAlign;
 }
 
+// Tries to run a capture endpoint at |period_ms| through IAudioClient3.
+// Only worth it below the engine's default period, which plain Initialize
+// already gives us. Returns false if the caller should fall back to
+// IAudioClient::Initialize.
+bool InitializeLowLatency(IAudioClient* audioClient, DWORD flags,
+                          const WAVEFORMATEX* format, uint32_t period_ms,
+                          uint32_t* achieved_period_ms) {
+  IAudioClient3* audioClient3 = nullptr;
+  if (FAILED(audioClient->QueryInterface(
+          __uuidof(IAudioClient3), reinterpret_cast<void**>(&audioClient3)))) {
+    return false;
+  }
+
+  UINT32 defaultFrames = 0, fundamentalFrames = 0, minFrames = 0,
+         maxFrames = 0;
+  HRESULT hr = audioClient3->GetSharedModeEnginePeriod(
+      format, &defaultFrames, &fundamentalFrames, &minFrames, &maxFrames);
+  UINT32 wantedFrames = static_cast<UINT32>(
+      static_cast<uint64_t>(format->nSamplesPerSec) * period_ms / 1000);
+  if (FAILED(hr) || fundamentalFrames == 0 || wantedFrames >= defaultFrames) {
+    audioClient3->Release();
+    return false;
+  }
+
+  // Periods must be a multiple of the fundamental period within [min, max].
+  UINT32 periodFrames = std::max(
+      minFrames, wantedFrames / fundamentalFrames * fundamentalFrames);
+  periodFrames = std::min(periodFrames, maxFrames);
+  hr = audioClient3->InitializeSharedAudioStream(flags, periodFrames, format,
+                                                 nullptr);
+  audioClient3->Release();
+  if (FAILED(hr)) {
+    return false;
+  }
+  *achieved_period_ms = std::max<uint32_t>(
+      1, periodFrames * 1000 / format->nSamplesPerSec);
+  return true;
+}
+
+class WasapiCaptureStream : public samurai::CaptureStream {
+ public:
+  // Takes ownership of the COM pointers and |event| (null for timer
+  // scheduling).
+  WasapiCaptureStream(IMMDevice* device, IAudioClient* audioClient,
+                      IAudioCaptureClient* captureClient, HANDLE event,
+                      uint32_t periodMs, bool highPriority,
+                      const samurai::AudioFormat& format)
+      : device_(device),
+        audio_client_(audioClient),
+        capture_client_(captureClient),
+        event_(event),
+        period_ms_(periodMs),
+        high_priority_(highPriority),
+        format_(format) {
+    UINT32 bufferFrames = 0;
+    if (SUCCEEDED(audio_client_->GetBufferSize(&bufferFrames))) {
+      buffer_ms_ = static_cast<uint32_t>(
+          static_cast<uint64_t>(bufferFrames) * 1000 / format_.sample_rate);
+    }
+  }
+
+  ~WasapiCaptureStream() override {
+    capture_client_->Release();
+    audio_client_->Release();
+    device_->Release();
+    if (event_) {
+      CloseHandle(event_);
+    }
+  }
+
+  const samurai::AudioFormat& format() const override { return format_; }
+
+  // Start and Stop run on the capture thread, so the MMCSS registration
+  // applies to the thread that services the device.
+  bool Start() override {
+    if (high_priority_) {
+      DWORD taskIndex = 0;
+      mmcss_task_ = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+    }
+    return SUCCEEDED(audio_client_->Start());
+  }
+
+  void Stop() override {
+    audio_client_->Stop();
+    if (mmcss_task_) {
+      AvRevertMmThreadCharacteristics(mmcss_task_);
+      mmcss_task_ = nullptr;
+    }
+  }
+
+  bool GetNextPacketSize(uint32_t* frames) override {
+    UINT32 packetLength = 0;
+    HRESULT hr = capture_client_->GetNextPacketSize(&packetLength);
+    *frames = packetLength;
+    return SUCCEEDED(hr);
+  }
+
+  bool GetPacket(samurai::CapturedPacket* packet) override {
+    BYTE* data = nullptr;
+    UINT32 packetLength = 0;
+    DWORD flags = 0;
+    UINT64 devicePosition = 0;
+    UINT64 qpcPosition = 0;
+    HRESULT hr = capture_client_->GetBuffer(&data, &packetLength, &flags,
+                                            &devicePosition, &qpcPosition);
+    if (FAILED(hr)) {
+      return false;
+    }
+    packet->data = data;
+    packet->frames = packetLength;
+    packet->flags = 0;
+    packet->device_position = devicePosition;
+    // The QPC position is in 100 ns units; steady_clock shares the QPC
+    // epoch on MSVC, so this lines up with SteadyCaptureClock. The engine
+    // falls back to its own clock when the device flags it as unreliable.
+    packet->capture_time_ns =
+        (flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR)
+            ? 0
+            : static_cast<int64_t>(qpcPosition) * 100;
+    if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+      packet->flags |= samurai::kPacketSilent;
+    }
+    if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) {
+      packet->flags |= samurai::kPacketDiscontinuity;
+    }
+    return true;
+  }
+
+  void ReleasePacket(uint32_t frames) override {
+    capture_client_->ReleaseBuffer(frames);
+  }
+
+  bool event_driven() const override { return event_ != nullptr; }
+
+  bool WaitForData(int64_t timeout_ns) override {
+    DWORD timeoutMs = static_cast<DWORD>((timeout_ns + 999999) / 1000000);
+    return WaitForSingleObject(event_, timeoutMs) == WAIT_OBJECT_0;
+  }
+
+  uint32_t device_period_ms() const override { return period_ms_; }
+  uint32_t buffer_duration_ms() const override { return buffer_ms_; }
+
+ private:
+  IMMDevice* device_;
+  IAudioClient* audio_client_;
+  IAudioCaptureClient* capture_client_;
+  HANDLE event_;
+  uint32_t period_ms_;
+  uint32_t buffer_ms_ = 0;
+  bool high_priority_;
+  HANDLE mmcss_task_ = nullptr;
+  samurai::AudioFormat format_;
+};
+
+}  // namespace
+
+AudioCapture::AudioCapture() : device_enumerator_(nullptr) {}
+
 AudioCapture::~AudioCapture() {
-  StopSystemAudioCapture();
-  StopMicrophoneCapture();
   if (device_enumerator_) {
     device_enumerator_->Release();
     device_enumerator_ = nullptr;
@@ -120,42 +305,14 @@ bool AudioCapture::EnumerateDevices(bool input, std::vector<AudioDevice>& device
   return true;
 }
 
-bool AudioCapture::StartSystemAudioCapture(const std::string& deviceId,
-                                           std::function<void(const uint8_t*, size_t)> callback) {
-  return StartCapture(true, deviceId, callback, system_audio_capturing_);
-}
-
-bool AudioCapture::StartMicrophoneCapture(const std::string& deviceId,
-                                          std::function<void(const uint8_t*, size_t)> callback) {
-  return StartCapture(false, deviceId, callback, microphone_capturing_);
-}
-
-bool AudioCapture::StartCapture(bool loopback, const std::string& deviceId,
-                                std::function<void(const uint8_t*, size_t)> callback,
-                                std::atomic<bool>& capturing_flag) {
-  std::lock_guard<std::mutex> lock(capture_mutex_);
-
-  if (capturing_flag.load()) {
-    return false;  // Already capturing
-  }
-
-  capturing_flag = true;
-  should_stop_ = false;
-
-  std::thread capture_thread(&AudioCapture::CaptureThread, this, loopback, deviceId, callback, std::ref(capturing_flag));
-  
-  if (loopback) {
-    system_audio_thread_ = std::move(capture_thread);
-  } else {
-    microphone_thread_ = std::move(capture_thread);
+std::unique_ptr<samurai::CaptureStream> AudioCapture::OpenStream(
+    samurai::StreamKind kind, const std::string& deviceId,
+    const samurai::StreamConfig& config) {
+  if (!device_enumerator_) {
+    return nullptr;
   }
 
-  return true;
-}
-
-void AudioCapture::CaptureThread(bool loopback, const std::string& deviceId,
-                                 std::function<void(const uint8_t*, size_t)> callback,
-                                 std::atomic<bool>& capturing_flag) {
+  const bool loopback = kind == samurai::StreamKind::kSystem;
   IMMDevice* device = nullptr;
   IAudioClient* audioClient = nullptr;
   IAudioCaptureClient* captureClient = nullptr;
@@ -178,8 +335,7 @@ void AudioCapture::CaptureThread(bool loopback, const std::string& deviceId,
   }
 
   if (FAILED(hr) || !device) {
-    capturing_flag = false;
-    return;
+    return nullptr;
   }
 
   // Activate audio client
@@ -187,8 +343,7 @@ void AudioCapture::CaptureThread(bool loopback, const std::string& deviceId,
                         reinterpret_cast<void**>(&audioClient));
   if (FAILED(hr)) {
     device->Release();
-    capturing_flag = false;
-    return;
+    return nullptr;
   }
 
   // Get mix format
@@ -196,141 +351,110 @@ void AudioCapture::CaptureThread(bool loopback, const std::string& deviceId,
   if (FAILED(hr)) {
     audioClient->Release();
     device->Release();
-    capturing_flag = false;
-    return;
+    return nullptr;
   }
 
   // For loopback, we need to use the render endpoint's format
   // For capture, we can set our desired format
+  const samurai::AudioFormat& requested = config.format;
   WAVEFORMATEX desiredFormat = {};
   desiredFormat.wFormatTag = WAVE_FORMAT_PCM;
-  desiredFormat.nChannels = CHANNELS;
-  desiredFormat.nSamplesPerSec = SAMPLE_RATE;
-  desiredFormat.wBitsPerSample = BITS_PER_SAMPLE;
-  desiredFormat.nBlockAlign = BLOCK_ALIGN;
-  desiredFormat.nAvgBytesPerSec = BYTES_PER_SECOND;
+  desiredFormat.nChannels = requested.channels;
+  desiredFormat.nSamplesPerSec = requested.sample_rate;
+  desiredFormat.wBitsPerSample = requested.BitsPerSample();
+  desiredFormat.nBlockAlign = static_cast<WORD>(requested.BlockAlign());
+  desiredFormat.nAvgBytesPerSec = requested.BytesPerSecond();
   desiredFormat.cbSize = 0;
 
+  const WAVEFORMATEX* streamFormat = pwfx;
   WAVEFORMATEX* closestMatch = nullptr;
-  if (loopback) {
-    // For loopback, use the device's format
-    closestMatch = pwfx;
-  } else {
+  if (!loopback && requested.sample_type == samurai::SampleType::kInt16) {
     // For capture, try to set our format
     hr = audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, &desiredFormat, &closestMatch);
-    if (hr == S_FALSE) {
+    if (hr == S_FALSE && closestMatch) {
       // Use closest match
-      if (closestMatch) {
-        CoTaskMemFree(pwfx);
-        pwfx = closestMatch;
-      }
-    } else if (SUCCEEDED(hr)) {
-      CoTaskMemFree(pwfx);
-      pwfx = &desiredFormat;
+      streamFormat = closestMatch;
+    } else if (hr == S_OK) {
+      streamFormat = &desiredFormat;
     }
   }
 
-  // Initialize audio client
-  REFERENCE_TIME hnsRequestedDuration = REFTIMES_PER_SEC;
-  hr = audioClient->Initialize(
-      AUDCLNT_SHAREMODE_SHARED,
-      loopback ? AUDCLNT_STREAMFLAGS_LOOPBACK : 0,
-      hnsRequestedDuration, 0, pwfx, nullptr);
+  samurai::AudioFormat format;
+  bool formatOk = ToAudioFormat(streamFormat, &format);
 
-  if (FAILED(hr)) {
-    CoTaskMemFree(pwfx);
-    audioClient->Release();
-    device->Release();
-    capturing_flag = false;
-    return;
+  const bool eventDriven =
+      config.scheduling == samurai::SchedulingMode::kEventDriven;
+  DWORD streamFlags = loopback ? AUDCLNT_STREAMFLAGS_LOOPBACK : 0;
+  if (eventDriven) {
+    streamFlags |= AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
   }
 
-  // Get capture client
-  hr = audioClient->GetService(__uuidof(IAudioCaptureClient),
-                               reinterpret_cast<void**>(&captureClient));
-  if (FAILED(hr)) {
-    CoTaskMemFree(pwfx);
-    audioClient->Release();
-    device->Release();
-    capturing_flag = false;
-    return;
+  // Initialize audio client. Latency is set by how often we are woken; the
+  // buffer only decides how late a wakeup may be before data is lost.
+  REFERENCE_TIME hnsRequestedDuration =
+      config.buffer_duration_ms > 0
+          ? static_cast<REFERENCE_TIME>(config.buffer_duration_ms) * 10000
+          : REFTIMES_PER_SEC;
+  uint32_t periodMs = config.device_period_ms;
+  bool initialized = false;
+  if (formatOk && eventDriven && !loopback && config.device_period_ms > 0) {
+    initialized = InitializeLowLatency(audioClient, streamFlags, streamFormat,
+                                       config.device_period_ms, &periodMs);
+  }
+  if (formatOk && !initialized) {
+    hr = audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, streamFlags,
+                                 hnsRequestedDuration, 0, streamFormat,
+                                 nullptr);
+    initialized = SUCCEEDED(hr);
+    if (initialized && eventDriven) {
+      // Event-driven shared streams always run at the engine period.
+      REFERENCE_TIME hnsDefaultPeriod = 0;
+      if (SUCCEEDED(audioClient->GetDevicePeriod(&hnsDefaultPeriod,
+                                                 nullptr))) {
+        periodMs = std::max<uint32_t>(
+            1, static_cast<uint32_t>(hnsDefaultPeriod / 10000));
+      }
+    }
+  }
+  if (periodMs == 0) {
+    periodMs = 10;
   }
 
-  // Start capturing
-  hr = audioClient->Start();
-  if (FAILED(hr)) {
-    CoTaskMemFree(pwfx);
-    captureClient->Release();
+  CoTaskMemFree(closestMatch);
+  CoTaskMemFree(pwfx);
+
+  if (!initialized) {
     audioClient->Release();
     device->Release();
-    capturing_flag = false;
-    return;
+    return nullptr;
   }
 
-  // Capture loop
-  UINT32 packetLength = 0;
-  BYTE* data = nullptr;
-  DWORD flags = 0;
-
-  while (capturing_flag.load() && !should_stop_.load()) {
-    hr = captureClient->GetNextPacketSize(&packetLength);
-
-    while (SUCCEEDED(hr) && packetLength > 0) {
-      hr = captureClient->GetBuffer(&data, &packetLength, &flags, nullptr, nullptr);
-
-      if (SUCCEEDED(hr)) {
-        // Always send data, even if silent (for debugging and to ensure data flow)
-        size_t dataSize = packetLength;
-        
-        // If silent, we still send zeros (this is normal for silence)
-        // But we should still process the data
-        if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
-          // Buffer is silent (all zeros), but we still send it
-          // This is normal when no audio is playing
-        }
-        
-        // Call callback with audio data
-        if (callback && dataSize > 0) {
-          callback(data, dataSize);
-        }
-
-        captureClient->ReleaseBuffer(packetLength);
+  HANDLE event = nullptr;
+  if (eventDriven) {
+    event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!event || FAILED(audioClient->SetEventHandle(event))) {
+      if (event) {
+        CloseHandle(event);
       }
-
-      hr = captureClient->GetNextPacketSize(&packetLength);
+      audioClient->Release();
+      device->Release();
+      return nullptr;
     }
-
-    Sleep(10);  // Small sleep to prevent CPU spinning
   }
 
-  // Cleanup
-  audioClient->Stop();
-  CoTaskMemFree(pwfx);
-  captureClient->Release();
-  audioClient->Release();
-  device->Release();
-  capturing_flag = false;
-}
-
-void AudioCapture::StopSystemAudioCapture() {
-  std::lock_guard<std::mutex> lock(capture_mutex_);
-  if (system_audio_capturing_.load()) {
-    should_stop_ = true;
-    system_audio_capturing_ = false;
-    if (system_audio_thread_.joinable()) {
-      system_audio_thread_.join();
+  // Get capture client
+  hr = audioClient->GetService(__uuidof(IAudioCaptureClient),
+                               reinterpret_cast<void**>(&captureClient));
+  if (FAILED(hr)) {
+    if (event) {
+      CloseHandle(event);
     }
+    audioClient->Release();
+    device->Release();
+    return nullptr;
   }
-}
 
-void AudioCapture::StopMicrophoneCapture() {
-  std::lock_guard<std::mutex> lock(capture_mutex_);
-  if (microphone_capturing_.load()) {
-    should_stop_ = true;
-    microphone_capturing_ = false;
-    if (microphone_thread_.joinable()) {
-      microphone_thread_.join();
-    }
-  }
+  return std::make_unique<WasapiCaptureStream>(
+      device, audioClient, captureClient, event, periodMs,
+      config.high_priority, format);
 }
-
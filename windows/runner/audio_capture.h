@@ -7,66 +7,43 @@
 #include <functiondiscoverykeys_devpkey.h>
 #include <string>
 #include <vector>
-#include <functional>
 #include <memory>
-#include <mutex>
-#include <thread>
-#include <atomic>
+
+#include "samurai_audio_core/capture_backend.h"
 
 #pragma comment(lib, "ole32.lib")
 #pragma comment(lib, "oleaut32.lib")
+#pragma comment(lib, "avrt.lib")
 
-struct AudioDevice {
-  std::string id;
-  std::string name;
-  bool isInput;
-};
+using samurai::AudioDevice;
 
-class AudioCapture {
+// WASAPI implementation of the core capture backend. Capture threads,
+// buffering and encoding live in samurai_audio_core; this class only talks
+// to the MMDevice/IAudioClient APIs.
+class AudioCapture : public samurai::CaptureBackend {
  public:
   AudioCapture();
-  ~AudioCapture();
+  ~AudioCapture() override;
 
   // Initialize COM and audio system
-  bool Initialize();
+  bool Initialize() override;
 
   // Get list of audio devices
-  std::vector<AudioDevice> GetInputDevices();
-  std::vector<AudioDevice> GetOutputDevices();
-
-  // Start capturing system audio (loopback)
-  bool StartSystemAudioCapture(const std::string& deviceId,
-                                std::function<void(const uint8_t*, size_t)> callback);
+  std::vector<AudioDevice> GetInputDevices() override;
+  std::vector<AudioDevice> GetOutputDevices() override;
 
-  // Start capturing microphone
-  bool StartMicrophoneCapture(const std::string& deviceId,
-                               std::function<void(const uint8_t*, size_t)> callback);
-
-  // Stop capturing
-  void StopSystemAudioCapture();
-  void StopMicrophoneCapture();
-
-  // Check if capturing
-  bool IsSystemAudioCapturing() const { return system_audio_capturing_; }
-  bool IsMicrophoneCapturing() const { return microphone_capturing_; }
+  // Opens a shared-mode stream; system streams use loopback on the render
+  // endpoint. Event-driven streams are woken by the audio engine once per
+  // device period; capture endpoints use IAudioClient3 to get periods below
+  // the engine default when the driver allows it.
+  std::unique_ptr<samurai::CaptureStream> OpenStream(
+      samurai::StreamKind kind, const std::string& deviceId,
+      const samurai::StreamConfig& config) override;
 
  private:
   bool EnumerateDevices(bool input, std::vector<AudioDevice>& devices);
-  bool StartCapture(bool loopback, const std::string& deviceId,
-                    std::function<void(const uint8_t*, size_t)> callback,
-                    std::atomic<bool>& capturing_flag);
-  void CaptureThread(bool loopback, const std::string& deviceId,
-                     std::function<void(const uint8_t*, size_t)> callback,
-                     std::atomic<bool>& capturing_flag);
 
   IMMDeviceEnumerator* device_enumerator_;
-  std::mutex capture_mutex_;
-  std::thread system_audio_thread_;
-  std::thread microphone_thread_;
-  std::atomic<bool> system_audio_capturing_;
-  std::atomic<bool> microphone_capturing_;
-  std::atomic<bool> should_stop_;
 };
 
 #endif  // RUNNER_AUDIO_CAPTURE_H_
-
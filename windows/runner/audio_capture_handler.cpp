@@ -4,11 +4,191 @@
 #include <iomanip>
 #include <windows.h>
 #include <processthreadsapi.h>
+#include <string>
+#include <flutter/event_stream_handler_functions.h>
+#include "samurai_audio_core/base64.h"
+#include "samurai_audio_core/channel_protocol.h"
 
-AudioCaptureHandler::AudioCaptureHandler(flutter::FlutterEngine* engine)
-    : engine_(engine) {
-  audio_capture_ = std::make_unique<AudioCapture>();
-  audio_capture_->Initialize();
+namespace {
+
+// Summed TranscodeMemoryEstimate() of the export jobs running at once.
+constexpr size_t kTranscodeMemoryBudget = 256u << 20;
+
+// How many packets may wait for the platform thread. Beyond that the Dart
+// sink's thread waits, and the backlog builds up in its fan-out queue,
+// which is bounded, instead of in the platform event queue.
+constexpr int kMaxDartPacketsInFlight = 32;
+
+// The Dart sink's fan-out queue gives up silence before speech.
+constexpr samurai::BackpressurePolicy kDartQueuePolicy =
+    samurai::BackpressurePolicy::kCoalesceSilence;
+
+// Dart's arguments without the embedder's types; see channel_protocol.h.
+samurai::ChannelValue ToChannelValue(const flutter::EncodableValue& value) {
+  if (std::holds_alternative<bool>(value)) {
+    return samurai::ChannelValue::Bool(std::get<bool>(value));
+  }
+  if (std::holds_alternative<int32_t>(value)) {
+    return samurai::ChannelValue::Int(std::get<int32_t>(value));
+  }
+  if (std::holds_alternative<int64_t>(value)) {
+    return samurai::ChannelValue::Int(std::get<int64_t>(value));
+  }
+  if (std::holds_alternative<double>(value)) {
+    return samurai::ChannelValue::Double(std::get<double>(value));
+  }
+  if (std::holds_alternative<std::string>(value)) {
+    return samurai::ChannelValue::String(std::get<std::string>(value));
+  }
+  if (std::holds_alternative<std::vector<double>>(value)) {
+    return samurai::ChannelValue::DoubleList(
+        std::get<std::vector<double>>(value));
+  }
+  if (std::holds_alternative<std::vector<float>>(value)) {
+    const auto& floats = std::get<std::vector<float>>(value);
+    return samurai::ChannelValue::DoubleList(
+        std::vector<double>(floats.begin(), floats.end()));
+  }
+  if (std::holds_alternative<flutter::EncodableList>(value)) {
+    samurai::ChannelValue list = samurai::ChannelValue::EmptyList();
+    for (const auto& item : std::get<flutter::EncodableList>(value)) {
+      list.Append(ToChannelValue(item));
+    }
+    return list;
+  }
+  if (std::holds_alternative<flutter::EncodableMap>(value)) {
+    samurai::ChannelValue map = samurai::ChannelValue::EmptyMap();
+    for (const auto& entry : std::get<flutter::EncodableMap>(value)) {
+      if (std::holds_alternative<std::string>(entry.first)) {
+        map.Set(std::get<std::string>(entry.first),
+                ToChannelValue(entry.second));
+      }
+    }
+    return map;
+  }
+  return samurai::ChannelValue();
+}
+
+samurai::ChannelValue ToChannelValue(const flutter::EncodableValue* arguments) {
+  return arguments ? ToChannelValue(*arguments) : samurai::ChannelValue();
+}
+
+flutter::EncodableValue ToEncodableValue(const samurai::ChannelValue& value) {
+  switch (value.type()) {
+    case samurai::ChannelValue::Type::kNull:
+      break;
+    case samurai::ChannelValue::Type::kBool:
+      return flutter::EncodableValue(value.bool_value());
+    case samurai::ChannelValue::Type::kInt:
+      if (value.int_value() >= INT32_MIN && value.int_value() <= INT32_MAX) {
+        return flutter::EncodableValue(
+            static_cast<int32_t>(value.int_value()));
+      }
+      return flutter::EncodableValue(value.int_value());
+    case samurai::ChannelValue::Type::kDouble:
+      return flutter::EncodableValue(value.double_value());
+    case samurai::ChannelValue::Type::kString:
+      return flutter::EncodableValue(value.string_value());
+    case samurai::ChannelValue::Type::kDoubleList:
+      return flutter::EncodableValue(value.double_list());
+    case samurai::ChannelValue::Type::kList: {
+      flutter::EncodableList list;
+      for (const samurai::ChannelValue& item : value.list()) {
+        list.push_back(ToEncodableValue(item));
+      }
+      return flutter::EncodableValue(std::move(list));
+    }
+    case samurai::ChannelValue::Type::kMap: {
+      flutter::EncodableMap map;
+      for (const auto& entry : value.map()) {
+        map[flutter::EncodableValue(entry.first)] =
+            ToEncodableValue(entry.second);
+      }
+      return flutter::EncodableValue(std::move(map));
+    }
+  }
+  return flutter::EncodableValue();
+}
+
+std::wstring Utf8ToWide(const std::string& text) {
+  if (text.empty()) {
+    return std::wstring();
+  }
+  int length = MultiByteToWideChar(CP_UTF8, 0, text.data(),
+                                   static_cast<int>(text.size()), nullptr, 0);
+  std::wstring wide(length, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                      wide.data(), length);
+  return wide;
+}
+
+// Fallback for builds without LAME: an ffmpeg subprocess, run on a job
+// worker and polled so a cancel can terminate it.
+bool TranscodeWithFfmpeg(const samurai::TranscodeRequest& request,
+                         const samurai::TranscodeProgress& progress,
+                         std::string* error) {
+  std::wstring cmd = L"ffmpeg -i \"" + Utf8ToWide(request.input_path) +
+                     L"\" -codec:a libmp3lame -b:a " +
+                     std::to_wstring(request.encoder.bitrate / 1000) +
+                     L"k -y \"" + Utf8ToWide(request.output_path) + L"\"";
+  STARTUPINFOW si = {sizeof(si)};
+  PROCESS_INFORMATION pi = {};
+  if (!CreateProcessW(nullptr, cmd.data(), nullptr, nullptr, FALSE,
+                      CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
+    *error = "Cannot start ffmpeg";
+    return false;
+  }
+  bool cancelled = false;
+  while (WaitForSingleObject(pi.hProcess, 100) == WAIT_TIMEOUT) {
+    // Progress is unknown; 0 only polls for cancellation.
+    if (!progress(0.0)) {
+      TerminateProcess(pi.hProcess, 1);
+      WaitForSingleObject(pi.hProcess, INFINITE);
+      cancelled = true;
+      break;
+    }
+  }
+  DWORD exitCode = 1;
+  GetExitCodeProcess(pi.hProcess, &exitCode);
+  CloseHandle(pi.hProcess);
+  CloseHandle(pi.hThread);
+  if (cancelled) {
+    DeleteFileW(Utf8ToWide(request.output_path).c_str());
+    return false;
+  }
+  if (exitCode != 0) {
+    *error = "ffmpeg exited with code " + std::to_string(exitCode);
+    return false;
+  }
+  return true;
+}
+
+// Encodes in-process where the codec is built in; MP3 falls back to
+// ffmpeg otherwise.
+bool RunTranscode(const samurai::TranscodeRequest& request,
+                  const samurai::TranscodeProgress& progress,
+                  std::string* error) {
+  if (request.encoder.codec == samurai::CodecId::kMp3 &&
+      !samurai::AudioCodecAvailable(samurai::CodecId::kMp3)) {
+    return TranscodeWithFfmpeg(request, progress, error);
+  }
+  return samurai::TranscodeWavFile(request, progress, error);
+}
+
+}  // namespace
+
+AudioCaptureHandler::AudioCaptureHandler(flutter::FlutterEngine* engine,
+                                         HWND window)
+    : window_(window), engine_(engine) {
+  capture_engine_ = std::make_unique<samurai::CaptureEngine>(
+      std::make_unique<AudioCapture>());
+  capture_engine_->Initialize();
+  fan_out_ = std::make_unique<samurai::PacketFanOut>();
+  samurai::FanOutSinkConfig dart_queue;
+  dart_queue.policy = kDartQueuePolicy;
+  dart_sink_id_ = fan_out_->Attach(
+      dart_queue,
+      [this](const samurai::AudioPacket& packet) { OnAudioData(packet); });
 
   method_channel_ = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
       engine_->messenger(), "com.samurai.audio_capture",
@@ -18,192 +198,411 @@ AudioCaptureHandler::AudioCaptureHandler(flutter::FlutterEngine* engine)
       [this](const auto& call, auto result) {
         this->HandleMethodCall(call, std::move(result));
       });
+
+  pcm_channel_ = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+      engine_->messenger(), "com.samurai.audio_capture/pcm",
+      &flutter::StandardMethodCodec::GetInstance());
+
+  pcm_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            pcm_sink_ = std::move(events);
+            pcm_listening_ = true;
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            pcm_listening_ = false;
+            pcm_sink_.reset();
+            return nullptr;
+          }));
+
+  jobs_channel_ = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+      engine_->messenger(), "com.samurai.audio_capture/jobs",
+      &flutter::StandardMethodCodec::GetInstance());
+
+  jobs_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            jobs_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            jobs_sink_.reset();
+            return nullptr;
+          }));
+
+  stream_channel_ = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+      engine_->messenger(), "com.samurai.audio_capture/stream",
+      &flutter::StandardMethodCodec::GetInstance());
+
+  stream_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            stream_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            stream_sink_.reset();
+            return nullptr;
+          }));
+
+  // One worker per core for batch exports, capped in memory so a backlog
+  // of multichannel float recordings cannot crowd out the capture path.
+  transcode_jobs_ = std::make_unique<samurai::TranscodeJobQueue>(
+      0, [this](const samurai::JobEvent& event) { OnJobEvent(event); },
+      RunTranscode);
+  transcode_jobs_->SetMemoryBudget(kTranscodeMemoryBudget);
 }
 
 AudioCaptureHandler::~AudioCaptureHandler() {
-  if (audio_capture_) {
-    audio_capture_->StopSystemAudioCapture();
-    audio_capture_->StopMicrophoneCapture();
+  // Releases a Dart sink thread waiting for room; what is still queued is
+  // never sent.
+  CloseDartBacklog();
+  transcode_jobs_.reset();
+  if (capture_engine_) {
+    capture_engine_->StopAll();
   }
+  StopNativeStreaming();
+  fan_out_.reset();
 }
 
 void AudioCaptureHandler::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue>& method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
   const std::string& method_name = method_call.method_name();
+  const samurai::ChannelValue args = ToChannelValue(method_call.arguments());
 
   if (method_name == "getInputDevices") {
-    auto devices = audio_capture_->GetInputDevices();
-    flutter::EncodableList device_list;
-    for (const auto& device : devices) {
-      flutter::EncodableMap device_map;
-      device_map[flutter::EncodableValue("id")] = flutter::EncodableValue(device.id);
-      device_map[flutter::EncodableValue("name")] = flutter::EncodableValue(device.name);
-      device_map[flutter::EncodableValue("isInput")] = flutter::EncodableValue(device.isInput);
-      device_list.push_back(flutter::EncodableValue(device_map));
-    }
-    result->Success(flutter::EncodableValue(device_list));
+    result->Success(ToEncodableValue(
+        samurai::DeviceListValue(capture_engine_->GetInputDevices())));
   } else if (method_name == "getOutputDevices") {
-    auto devices = audio_capture_->GetOutputDevices();
-    flutter::EncodableList device_list;
-    for (const auto& device : devices) {
-      flutter::EncodableMap device_map;
-      device_map[flutter::EncodableValue("id")] = flutter::EncodableValue(device.id);
-      device_map[flutter::EncodableValue("name")] = flutter::EncodableValue(device.name);
-      device_map[flutter::EncodableValue("isInput")] = flutter::EncodableValue(device.isInput);
-      device_list.push_back(flutter::EncodableValue(device_map));
-    }
-    result->Success(flutter::EncodableValue(device_list));
+    result->Success(ToEncodableValue(
+        samurai::DeviceListValue(capture_engine_->GetOutputDevices())));
   } else if (method_name == "startSystemAudioCapture") {
-    std::string deviceId = "";
-    if (method_call.arguments() && method_call.arguments()->IsMap()) {
-      const auto& args = std::get<flutter::EncodableMap>(*method_call.arguments());
-      auto it = args.find(flutter::EncodableValue("deviceId"));
-      if (it != args.end()) {
-        deviceId = std::get<std::string>(it->second);
-      }
-    }
-
-    bool success = audio_capture_->StartSystemAudioCapture(
-        deviceId,
-        [this](const uint8_t* data, size_t size) {
-          this->OnAudioData(data, size, true);
-        });
-
-    if (success) {
-      result->Success(flutter::EncodableValue(true));
-    } else {
-      result->Error("FAILED", "Failed to start system audio capture");
-    }
+    StartCapture(samurai::StreamKind::kSystem, args, std::move(result));
   } else if (method_name == "stopSystemAudioCapture") {
-    audio_capture_->StopSystemAudioCapture();
+    capture_engine_->Stop(samurai::StreamKind::kSystem);
     result->Success(flutter::EncodableValue(true));
   } else if (method_name == "startMicrophoneCapture") {
-    std::string deviceId = "";
-    if (method_call.arguments() && method_call.arguments()->IsMap()) {
-      const auto& args = std::get<flutter::EncodableMap>(*method_call.arguments());
-      auto it = args.find(flutter::EncodableValue("deviceId"));
-      if (it != args.end()) {
-        deviceId = std::get<std::string>(it->second);
-      }
-    }
-
-    bool success = audio_capture_->StartMicrophoneCapture(
-        deviceId,
-        [this](const uint8_t* data, size_t size) {
-          this->OnAudioData(data, size, false);
-        });
-
-    if (success) {
-      result->Success(flutter::EncodableValue(true));
-    } else {
-      result->Error("FAILED", "Failed to start microphone capture");
-    }
+    StartCapture(samurai::StreamKind::kMicrophone, args, std::move(result));
   } else if (method_name == "stopMicrophoneCapture") {
-    audio_capture_->StopMicrophoneCapture();
+    capture_engine_->Stop(samurai::StreamKind::kMicrophone);
     result->Success(flutter::EncodableValue(true));
+  } else if (method_name == "setDelivery") {
+    // Moves a running capture between Dart and native streaming.
+    const samurai::StreamKind kind = samurai::ParseStreamType(args);
+    if (!capture_engine_->IsCapturing(kind)) {
+      result->Error("NOT_CAPTURING",
+                    std::string(samurai::StreamKindName(kind)) +
+                        " capture is not running");
+      return;
+    }
+    SetDelivery(kind, samurai::ParseCaptureDelivery(args));
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_name == "getCaptureStats") {
+    result->Success(ToEncodableValue(samurai::CaptureStatsValue(
+        capture_engine_->GetStats(samurai::ParseStreamType(args)))));
   } else if (method_name == "convertToMp3") {
-    std::string wavPath = "";
-    std::string mp3Path = "";
-    
-    if (method_call.arguments() && method_call.arguments()->IsMap()) {
-      const auto& args = std::get<flutter::EncodableMap>(*method_call.arguments());
-      auto wavIt = args.find(flutter::EncodableValue("wavPath"));
-      auto mp3It = args.find(flutter::EncodableValue("mp3Path"));
-      
-      if (wavIt != args.end()) {
-        wavPath = std::get<std::string>(wavIt->second);
-      }
-      if (mp3It != args.end()) {
-        mp3Path = std::get<std::string>(mp3It->second);
-      }
+    samurai::TranscodeRequest request;
+    samurai::ChannelResult parsed =
+        samurai::ParseConvertRequest(args, &request);
+    if (!parsed.ok()) {
+      result->Error(parsed.code, parsed.message);
+      return;
     }
-    
-    if (wavPath.empty() || mp3Path.empty()) {
-      result->Error("INVALID_ARGS", "wavPath and mp3Path are required");
+    // Returns at once; the job reports through the jobs EventChannel.
+    uint64_t id = transcode_jobs_->Submit(request);
+    result->Success(flutter::EncodableValue(static_cast<int64_t>(id)));
+  } else if (method_name == "convertBatch") {
+    std::vector<samurai::TranscodeRequest> requests;
+    samurai::ChannelResult parsed =
+        samurai::ParseConvertBatchRequest(args, &requests);
+    if (!parsed.ok()) {
+      result->Error(parsed.code, parsed.message);
       return;
     }
-    
-    bool success = ConvertWavToMp3(wavPath, mp3Path);
-    result->Success(flutter::EncodableValue(success));
+    std::vector<uint64_t> ids;
+    uint64_t batch = transcode_jobs_->SubmitBatch(requests, &ids);
+    result->Success(ToEncodableValue(samurai::BatchValue(batch, ids)));
+  } else if (method_name == "cancelJob") {
+    int64_t id = args.GetInt("id", 0);
+    result->Success(flutter::EncodableValue(
+        id > 0 && transcode_jobs_->Cancel(static_cast<uint64_t>(id))));
+  } else if (method_name == "cancelBatch") {
+    int64_t batch = args.GetInt("batch", 0);
+    result->Success(flutter::EncodableValue(
+        batch > 0 &&
+        transcode_jobs_->CancelBatch(static_cast<uint64_t>(batch))));
+  } else if (method_name == "startNativeStreaming") {
+    StartNativeStreaming(args, std::move(result));
+  } else if (method_name == "stopNativeStreaming") {
+    StopNativeStreaming();
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_name == "getSinkStats") {
+    samurai::ChannelValue sinks = samurai::ChannelValue::EmptyMap();
+    samurai::FanOutSinkStats stats;
+    if (fan_out_->GetStats(dart_sink_id_, &stats)) {
+      sinks.Set("dart", samurai::SinkQueueValue(kDartQueuePolicy, stats));
+    }
+    if (websocket_sink_id_ != 0 &&
+        fan_out_->GetStats(websocket_sink_id_, &stats)) {
+      sinks.Set("websocket",
+                samurai::SinkQueueValue(websocket_policy_, stats));
+    }
+    result->Success(ToEncodableValue(sinks));
   } else {
     result->NotImplemented();
   }
 }
 
-void AudioCaptureHandler::OnAudioData(const uint8_t* data, size_t size, bool isSystemAudio) {
-  // Convert to base64
-  const char base64_chars[] =
-      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-  
-  std::string base64;
-  base64.reserve(((size + 2) / 3) * 4);
-  
-  for (size_t i = 0; i < size; i += 3) {
-    uint32_t octet_a = i < size ? data[i] : 0;
-    uint32_t octet_b = i + 1 < size ? data[i + 1] : 0;
-    uint32_t octet_c = i + 2 < size ? data[i + 2] : 0;
-    
-    uint32_t triple = (octet_a << 16) | (octet_b << 8) | octet_c;
-    
-    base64 += base64_chars[(triple >> 18) & 0x3F];
-    base64 += base64_chars[(triple >> 12) & 0x3F];
-    base64 += (i + 1 < size) ? base64_chars[(triple >> 6) & 0x3F] : '=';
-    base64 += (i + 2 < size) ? base64_chars[triple & 0x3F] : '=';
-  }
-
-  // Print to console
-  //std::cout << (isSystemAudio ? "[SYSTEM] " : "[MIC] ") << base64 << std::endl;
-
-  // Also send to Flutter via event channel
-  if (method_channel_ && engine_) {
-    flutter::EncodableMap event_data;
-    event_data[flutter::EncodableValue("type")] = 
-        flutter::EncodableValue(isSystemAudio ? "system" : "microphone");
-    event_data[flutter::EncodableValue("data")] = flutter::EncodableValue(base64);
-    event_data[flutter::EncodableValue("size")] = flutter::EncodableValue(static_cast<int64_t>(size));
-    
-    method_channel_->InvokeMethod("onAudioData", 
-        std::make_unique<flutter::EncodableValue>(event_data));
-  }
-}
-
-bool AudioCaptureHandler::ConvertWavToMp3(const std::string& wavPath, const std::string& mp3Path) {
-  STARTUPINFOA si = { sizeof(si) };
-  PROCESS_INFORMATION pi;
-  ZeroMemory(&si, sizeof(si));
-  ZeroMemory(&pi, sizeof(pi));
-  
-  // Build command: ffmpeg -i input.wav -codec:a libmp3lame -b:a 192k -y output.mp3
-  std::string cmd = "ffmpeg -i \"" + wavPath + "\" -codec:a libmp3lame -b:a 192k -y \"" + mp3Path + "\"";
-  
-  // Create process
-  BOOL success = CreateProcessA(
-    NULL,                    // Application name
-    const_cast<char*>(cmd.c_str()),  // Command line
-    NULL,                    // Process security attributes
-    NULL,                    // Thread security attributes
-    FALSE,                   // Inherit handles
-    CREATE_NO_WINDOW,        // Creation flags
-    NULL,                    // Environment
-    NULL,                    // Current directory
-    &si,                     // Startup info
-    &pi                      // Process information
-  );
-  
-  if (!success) {
+void AudioCaptureHandler::StartCapture(
+    samurai::StreamKind kind, const samurai::ChannelValue& args,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  samurai::CaptureRequest request;
+  samurai::ChannelResult parsed = samurai::ParseCaptureRequest(args, &request);
+  if (!parsed.ok()) {
+    result->Error(parsed.code, parsed.message);
+    return;
+  }
+
+  // A running stream keeps its settings and delivery; see setDelivery.
+  if (capture_engine_->IsCapturing(kind)) {
+    result->Error("ALREADY_CAPTURING",
+                  std::string(samurai::StreamKindName(kind)) +
+                      " capture is already running");
+    return;
+  }
+  // Set before the first packet can reach OnAudioData().
+  SetDelivery(kind, request.delivery);
+  bool success = capture_engine_->Start(
+      kind, request.device_id, request.settings,
+      [this](const samurai::AudioPacket& packet) {
+        fan_out_->Deliver(packet);
+      });
+
+  samurai::StreamInfo info;
+  if (success && capture_engine_->GetStreamInfo(kind, &info)) {
+    // The negotiated settings, including the latency the profile achieved.
+    result->Success(
+        ToEncodableValue(samurai::StreamInfoValue(request.profile, info)));
+  } else {
+    result->Error("FAILED", kind == samurai::StreamKind::kSystem
+                                ? "Failed to start system audio capture"
+                                : "Failed to start microphone capture");
+  }
+}
+
+void AudioCaptureHandler::SetDelivery(
+    samurai::StreamKind kind, const samurai::CaptureDelivery& delivery) {
+  binary_delivery_[static_cast<int>(kind)] = delivery.binary;
+  native_delivery_[static_cast<int>(kind)] = delivery.native;
+}
+
+// Called on the Dart sink's fan-out thread; hops to the platform thread
+// before touching the channels.
+void AudioCaptureHandler::OnAudioData(const samurai::AudioPacket& packet) {
+  if (native_delivery_[static_cast<int>(packet.stream)] &&
+      !binary_delivery_[static_cast<int>(packet.stream)]) {
+    return;
+  }
+  if (binary_delivery_[static_cast<int>(packet.stream)] && !pcm_listening_) {
+    return;
+  }
+  // Waiting here leaves the backlog to the sink's fan-out queue and policy.
+  if (!EnterDartBacklog()) {
+    return;
+  }
+  if (binary_delivery_[static_cast<int>(packet.stream)]) {
+    SendBinaryAudioData(packet);
+    return;
+  }
+
+  flutter::EncodableMap event_data;
+  event_data[flutter::EncodableValue("type")] =
+      flutter::EncodableValue(samurai::StreamKindName(packet.stream));
+  event_data[flutter::EncodableValue("data")] = flutter::EncodableValue(
+      samurai::Base64Encode(packet.data, packet.size));
+  event_data[flutter::EncodableValue("size")] =
+      flutter::EncodableValue(static_cast<int64_t>(packet.size));
+  event_data[flutter::EncodableValue("frames")] =
+      flutter::EncodableValue(static_cast<int64_t>(packet.frames));
+  event_data[flutter::EncodableValue("flags")] =
+      flutter::EncodableValue(static_cast<int32_t>(packet.flags));
+  event_data[flutter::EncodableValue("position")] =
+      flutter::EncodableValue(static_cast<int64_t>(packet.position));
+  event_data[flutter::EncodableValue("captureTimeNs")] =
+      flutter::EncodableValue(packet.capture_time_ns);
+  PostPlatformEvent({PlatformEvent::Target::kAudioData,
+                     flutter::EncodableValue(std::move(event_data))});
+}
+
+void AudioCaptureHandler::SendBinaryAudioData(const samurai::AudioPacket& packet) {
+  flutter::EncodableMap event_data;
+  event_data[flutter::EncodableValue("type")] =
+      flutter::EncodableValue(samurai::StreamKindName(packet.stream));
+  event_data[flutter::EncodableValue("seq")] =
+      flutter::EncodableValue(static_cast<int64_t>(packet.sequence));
+  event_data[flutter::EncodableValue("flags")] =
+      flutter::EncodableValue(static_cast<int32_t>(packet.flags));
+  // Silence markers carry a frame count and no samples.
+  event_data[flutter::EncodableValue("frames")] =
+      flutter::EncodableValue(static_cast<int64_t>(packet.frames));
+  // Sample-accurate stream position and capture time of the first frame.
+  event_data[flutter::EncodableValue("position")] =
+      flutter::EncodableValue(static_cast<int64_t>(packet.position));
+  event_data[flutter::EncodableValue("captureTimeNs")] =
+      flutter::EncodableValue(packet.capture_time_ns);
+  // Arrives in Dart as a Uint8List, with no base64 step on either side.
+  event_data[flutter::EncodableValue("data")] = flutter::EncodableValue(
+      std::vector<uint8_t>(packet.data, packet.data + packet.size));
+  PostPlatformEvent({PlatformEvent::Target::kPcm,
+                     flutter::EncodableValue(std::move(event_data))});
+}
+
+void AudioCaptureHandler::PostPlatformEvent(PlatformEvent event) {
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(platform_events_mutex_);
+    wake = platform_events_.empty();
+    platform_events_.push_back(std::move(event));
+  }
+  // One message per batch: the drain takes everything queued by then.
+  if (wake) {
+    PostMessage(window_, kPlatformEventMessage, 0, 0);
+  }
+}
+
+void AudioCaptureHandler::DrainPlatformEvents() {
+  std::vector<PlatformEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(platform_events_mutex_);
+    events.swap(platform_events_);
+  }
+  int packets = 0;
+  for (PlatformEvent& event : events) {
+    switch (event.target) {
+      case PlatformEvent::Target::kAudioData:
+        ++packets;
+        method_channel_->InvokeMethod(
+            "onAudioData",
+            std::make_unique<flutter::EncodableValue>(std::move(event.value)));
+        break;
+      case PlatformEvent::Target::kPcm:
+        ++packets;
+        if (pcm_sink_) {
+          pcm_sink_->Success(event.value);
+        }
+        break;
+      case PlatformEvent::Target::kJobs:
+        if (jobs_sink_) {
+          jobs_sink_->Success(event.value);
+        }
+        break;
+      case PlatformEvent::Target::kStream:
+        if (stream_sink_) {
+          stream_sink_->Success(event.value);
+        }
+        break;
+    }
+  }
+  if (packets > 0) {
+    {
+      std::lock_guard<std::mutex> lock(platform_events_mutex_);
+      dart_packets_in_flight_ -= packets;
+    }
+    dart_backlog_cv_.notify_one();
+  }
+}
+
+bool AudioCaptureHandler::EnterDartBacklog() {
+  std::unique_lock<std::mutex> lock(platform_events_mutex_);
+  dart_backlog_cv_.wait(lock, [this]() {
+    return dart_backlog_closed_ ||
+           dart_packets_in_flight_ < kMaxDartPacketsInFlight;
+  });
+  if (dart_backlog_closed_) {
     return false;
   }
-  
-  // Wait for process to complete
-  WaitForSingleObject(pi.hProcess, INFINITE);
-  
-  DWORD exitCode;
-  GetExitCodeProcess(pi.hProcess, &exitCode);
-  
-  CloseHandle(pi.hProcess);
-  CloseHandle(pi.hThread);
-  
-  return exitCode == 0;
+  ++dart_packets_in_flight_;
+  return true;
+}
+
+void AudioCaptureHandler::CloseDartBacklog() {
+  {
+    std::lock_guard<std::mutex> lock(platform_events_mutex_);
+    dart_backlog_closed_ = true;
+  }
+  dart_backlog_cv_.notify_all();
+}
+
+// Called on job workers; same hop as OnAudioData.
+void AudioCaptureHandler::OnJobEvent(const samurai::JobEvent& event) {
+  PostPlatformEvent({PlatformEvent::Target::kJobs,
+                     ToEncodableValue(samurai::JobEventValue(event))});
+}
+
+void AudioCaptureHandler::StartNativeStreaming(
+    const samurai::ChannelValue& args,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  samurai::NativeStreamingRequest request;
+  samurai::ChannelResult parsed =
+      samurai::ParseNativeStreamingRequest(args, &request);
+  if (!parsed.ok()) {
+    result->Error(parsed.code, parsed.message);
+    return;
+  }
+  const samurai::WebSocketSinkConfig& config = request.sink;
+  const samurai::BackpressurePolicy policy = request.policy;
+
+  // One connection at a time; a new call replaces the old sink.
+  StopNativeStreaming();
+  auto sink = std::make_unique<samurai::WebSocketSink>(
+      config, [this](const samurai::WebSocketSinkEvent& event) {
+        OnStreamEvent(event);
+      });
+  sink->Start();
+  samurai::WebSocketSink* raw = sink.get();
+  websocket_ = std::move(sink);
+  websocket_policy_ = policy;
+  samurai::FanOutSinkConfig queue;
+  queue.max_bytes = config.max_queued_bytes;
+  queue.max_duration_ms = config.max_queued_ms;
+  queue.policy = policy;
+  websocket_sink_id_ = fan_out_->Attach(
+      queue, [this, raw](const samurai::AudioPacket& packet) {
+        if (native_delivery_[static_cast<int>(packet.stream)]) {
+          raw->Deliver(packet);
+        }
+      });
+  result->Success(flutter::EncodableValue(true));
+}
+
+void AudioCaptureHandler::StopNativeStreaming() {
+  // Capture keeps running for the other sinks. Stopping the sink first
+  // releases a fan-out thread waiting on its full queue; what the detach
+  // then hands over is dropped.
+  if (websocket_) {
+    websocket_->Stop();
+  }
+  if (websocket_sink_id_ != 0) {
+    fan_out_->Detach(websocket_sink_id_);
+    websocket_sink_id_ = 0;
+  }
+  websocket_.reset();
 }
 
+// Called on the sink's network thread; same hop as OnAudioData.
+void AudioCaptureHandler::OnStreamEvent(
+    const samurai::WebSocketSinkEvent& event) {
+  PostPlatformEvent({PlatformEvent::Target::kStream,
+                     ToEncodableValue(samurai::StreamEventValue(event))});
+}
@@ -1,27 +1,117 @@
 #ifndef RUNNER_AUDIO_CAPTURE_HANDLER_H_
 #define RUNNER_AUDIO_CAPTURE_HANDLER_H_
 
+#include <flutter/event_channel.h>
+#include <flutter/event_sink.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
+#include <windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "audio_capture.h"
+#include "samurai_audio_core/capture_engine.h"
+#include "samurai_audio_core/channel_protocol.h"
+#include "samurai_audio_core/packet_fan_out.h"
+#include "samurai_audio_core/transcode_jobs.h"
+#include "samurai_audio_core/websocket_sink.h"
 
+// Channel messages may only be sent on the platform thread. Events raised
+// on capture, job and network threads are queued and |window| is posted
+// kPlatformEventMessage, which its owner forwards to DrainPlatformEvents().
 class AudioCaptureHandler {
  public:
-  AudioCaptureHandler(flutter::FlutterEngine* engine);
+  static constexpr UINT kPlatformEventMessage = WM_APP + 1;
+
+  AudioCaptureHandler(flutter::FlutterEngine* engine, HWND window);
   ~AudioCaptureHandler();
 
+  // Sends the queued events. Runs on the platform thread.
+  void DrainPlatformEvents();
+
  private:
+  // A channel message waiting for the platform thread.
+  struct PlatformEvent {
+    enum class Target { kAudioData, kPcm, kJobs, kStream };
+    Target target;
+    flutter::EncodableValue value;
+  };
+
+  // Queues |event| and wakes the platform thread if the queue was empty.
+  void PostPlatformEvent(PlatformEvent event);
+  // Waits for room among the packets queued for Dart. Returns false once
+  // the handler is shutting down.
+  bool EnterDartBacklog();
+  void CloseDartBacklog();
+
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue>& method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 
-  void OnAudioData(const uint8_t* data, size_t size, bool isSystemAudio);
-  bool ConvertWavToMp3(const std::string& wavPath, const std::string& mp3Path);
+  void StartCapture(
+      samurai::StreamKind kind, const samurai::ChannelValue& args,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  // Sets how packets of |kind| reach Dart.
+  void SetDelivery(samurai::StreamKind kind,
+                   const samurai::CaptureDelivery& delivery);
+
+  void OnAudioData(const samurai::AudioPacket& packet);
+  void SendBinaryAudioData(const samurai::AudioPacket& packet);
+  void OnJobEvent(const samurai::JobEvent& event);
+  void StartNativeStreaming(
+      const samurai::ChannelValue& args,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void StopNativeStreaming();
+  void OnStreamEvent(const samurai::WebSocketSinkEvent& event);
 
   std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> method_channel_;
-  std::unique_ptr<AudioCapture> audio_capture_;
+
+  // Binary PCM delivery ("delivery": "binary"): raw bytes on an EventChannel
+  // instead of base64 strings through onAudioData. The sink is only
+  // touched on the platform thread.
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> pcm_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> pcm_sink_;
+  std::atomic<bool> pcm_listening_{false};
+  std::atomic<bool> binary_delivery_[samurai::kStreamKindCount] = {};
+
+  // WAV -> MP3 export jobs; progress and results go out on the jobs
+  // EventChannel. Declared after the sink so workers stop first.
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> jobs_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> jobs_sink_;
+  std::unique_ptr<samurai::TranscodeJobQueue> transcode_jobs_;
+
+  // Native WebSocket streaming ("delivery": "native"): packets go from the
+  // fan-out straight to the sink, never through Dart unless mirrored;
+  // connection state and counters go out on the stream EventChannel.
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> stream_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> stream_sink_;
+  std::atomic<bool> native_delivery_[samurai::kStreamKindCount] = {};
+  std::unique_ptr<samurai::WebSocketSink> websocket_;
+  uint64_t websocket_sink_id_ = 0;
+  samurai::BackpressurePolicy websocket_policy_ =
+      samurai::BackpressurePolicy::kDropOldest;
+
+  // Every captured packet goes to the Dart sink (OnAudioData) and, while
+  // streaming, the WebSocket sink, each through its own queue and thread.
+  std::unique_ptr<samurai::PacketFanOut> fan_out_;
+  uint64_t dart_sink_id_ = 0;
+
+  // Events waiting for the platform thread. PCM packets among them are
+  // counted in |dart_packets_in_flight_| and bounded, so a slow isolate
+  // backs up into the Dart sink's fan-out queue instead of this one.
+  HWND window_;
+  std::mutex platform_events_mutex_;
+  std::condition_variable dart_backlog_cv_;
+  std::vector<PlatformEvent> platform_events_;
+  int dart_packets_in_flight_ = 0;
+  bool dart_backlog_closed_ = false;
+
+  std::unique_ptr<samurai::CaptureEngine> capture_engine_;
   flutter::FlutterEngine* engine_;
 };
 
@@ -28,7 +28,8 @@ bool FlutterWindow::OnCreate() {
   RegisterPlugins(flutter_controller_->engine());
   
   // Initialize audio capture handler
-  audio_capture_handler_ = std::make_unique<AudioCaptureHandler>(flutter_controller_->engine());
+  audio_capture_handler_ = std::make_unique<AudioCaptureHandler>(
+      flutter_controller_->engine(), GetHandle());
   
   SetChildContent(flutter_controller_->view()->GetNativeWindow());
 
@@ -45,6 +46,8 @@ bool FlutterWindow::OnCreate() {
 }
 
 void FlutterWindow::OnDestroy() {
+  // Stops capture before the engine its channels send through goes away.
+  audio_capture_handler_ = nullptr;
   if (flutter_controller_) {
     flutter_controller_ = nullptr;
   }
@@ -70,6 +73,11 @@ FlutterWindow::MessageHandler(HWND hwnd, UINT const message,
     case WM_FONTCHANGE:
       flutter_controller_->engine()->ReloadSystemFonts();
       break;
+    case AudioCaptureHandler::kPlatformEventMessage:
+      if (audio_capture_handler_) {
+        audio_capture_handler_->DrainPlatformEvents();
+      }
+      return 0;
   }
 
   return Win32Window::MessageHandler(hwnd, message, wparam, lparam);
@@ -8,6 +8,8 @@
 
 #include "win32_window.h"
 
+class AudioCaptureHandler;
+
 // A window that does nothing but host a Flutter view.
 class FlutterWindow : public Win32Window {
  public:
@@ -30,7 +32,6 @@ class FlutterWindow : public Win32Window {
   std::unique_ptr<flutter::FlutterViewController> flutter_controller_;
 
   // Audio capture handler
-  class AudioCaptureHandler;
   std::unique_ptr<AudioCaptureHandler> audio_capture_handler_;
 };
 